@@ -0,0 +1,335 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2017 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Two-process memif throughput benchmark.
+ *
+ * memif_bench is a polling libmemif master which pushes fixed-size
+ * ethernet frames to its peer and counts what comes back. Run VPP as the
+ * zero-copy slave and loop the interface back to itself:
+ *
+ *   create interface memif id 0 slave
+ *   set interface state memif0/0 up
+ *   set interface l2 xconnect memif0/0 memif0/0
+ *
+ * then
+ *
+ *   memif_bench [socket <file>] [time <sec>] [size <bytes>]...
+ *
+ * Frames larger than the buffer size are chained across descriptors, so
+ * jumbo sizes exercise the multi-segment path on both sides.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <signal.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+#include <libmemif.h>
+
+#define APP_NAME "memif_bench"
+#define IF_NAME  "memif_bench"
+
+#define INFO(...) do {                                              \
+                    printf ("INFO: "__VA_ARGS__);                   \
+                    printf ("\n");                                  \
+                } while (0)
+
+/* maximum tx/rx memif buffers per burst */
+#define MAX_MEMIF_BUFS 256
+#define MAX_SIZES 8
+#define MAX_PKT_SIZE 9216
+#define BUFFER_SIZE 2048
+
+typedef struct
+{
+  memif_conn_handle_t conn;
+  volatile int connected;
+  memif_buffer_t *tx_bufs;
+  memif_buffer_t *rx_bufs;
+  /* packet template, copied into shared memory for every frame */
+  uint8_t *pkt;
+  uint64_t tx_pkts;
+  uint64_t rx_pkts;
+  uint64_t rx_bytes;
+} memif_bench_main_t;
+
+memif_bench_main_t memif_bench_main;
+static volatile int stop;
+
+static void
+bench_exit (int sig)
+{
+  stop = 1;
+}
+
+static int
+on_connect (memif_conn_handle_t conn, void *private_ctx)
+{
+  memif_bench_main_t *bm = &memif_bench_main;
+  int err;
+
+  /* no rx interrupts, we poll */
+  err = memif_set_rx_mode (conn, MEMIF_RX_MODE_POLLING, 0);
+  if (err != MEMIF_ERR_SUCCESS)
+    INFO ("memif_set_rx_mode: %s", memif_strerror (err));
+  bm->connected = 1;
+  INFO ("memif connected");
+  return 0;
+}
+
+static int
+on_disconnect (memif_conn_handle_t conn, void *private_ctx)
+{
+  memif_bench_main_t *bm = &memif_bench_main;
+
+  bm->connected = 0;
+  INFO ("memif disconnected");
+  return 0;
+}
+
+static int
+on_interrupt (memif_conn_handle_t conn, void *private_ctx, uint16_t qid)
+{
+  return 0;
+}
+
+static void
+build_packet (uint8_t * pkt)
+{
+  struct ether_header *eh = (struct ether_header *) pkt;
+  struct iphdr *ip = (struct iphdr *) (eh + 1);
+  struct udphdr *udp = (struct udphdr *) (ip + 1);
+  int i;
+
+  memset (eh->ether_dhost, 0xff, ETH_ALEN);
+  memcpy (eh->ether_shost, "\x02\xfe\x00\x00\x00\x01", ETH_ALEN);
+  eh->ether_type = htons (ETHERTYPE_IP);
+
+  ip->version = 4;
+  ip->ihl = 5;
+  ip->ttl = 64;
+  ip->protocol = IPPROTO_UDP;
+  ip->saddr = htonl (0xc0a80101);
+  ip->daddr = htonl (0xc0a80102);
+
+  udp->source = htons (1234);
+  udp->dest = htons (4321);
+
+  for (i = sizeof (*eh) + sizeof (*ip) + sizeof (*udp); i < MAX_PKT_SIZE;
+       i++)
+    pkt[i] = i;
+}
+
+static void
+set_packet_length (uint8_t * pkt, uint16_t size)
+{
+  struct iphdr *ip = (struct iphdr *) (pkt + sizeof (struct ether_header));
+  struct udphdr *udp = (struct udphdr *) (ip + 1);
+  uint16_t ip_len = size - sizeof (struct ether_header);
+
+  ip->tot_len = htons (ip_len);
+  udp->len = htons (ip_len - sizeof (*ip));
+}
+
+static inline double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+bench_tx (memif_bench_main_t * bm, uint16_t size)
+{
+  uint16_t n_alloc = 0, n_tx = 0, i, off = 0;
+  int err;
+
+  err = memif_buffer_alloc (bm->conn, 0, bm->tx_bufs, MAX_MEMIF_BUFS,
+			    &n_alloc, size);
+  if (err != MEMIF_ERR_SUCCESS && err != MEMIF_ERR_NOBUF_RING)
+    return;
+
+  /* alloc never splits a frame, so the last buffer always ends one */
+  for (i = 0; i < n_alloc; i++)
+    {
+      memif_buffer_t *b = bm->tx_bufs + i;
+      memcpy (b->data, bm->pkt + off, b->len);
+      off += b->len;
+      if ((b->flags & MEMIF_BUFFER_FLAG_NEXT) == 0)
+	{
+	  bm->tx_pkts++;
+	  off = 0;
+	}
+    }
+
+  if (n_alloc)
+    memif_tx_burst (bm->conn, 0, bm->tx_bufs, n_alloc, &n_tx);
+}
+
+static void
+bench_rx (memif_bench_main_t * bm)
+{
+  uint16_t n_rx = 0, i;
+  int err;
+
+  do
+    {
+      err = memif_rx_burst (bm->conn, 0, bm->rx_bufs, MAX_MEMIF_BUFS, &n_rx);
+      if (err != MEMIF_ERR_SUCCESS && err != MEMIF_ERR_NOBUF)
+	return;
+
+      for (i = 0; i < n_rx; i++)
+	{
+	  memif_buffer_t *b = bm->rx_bufs + i;
+	  bm->rx_bytes += b->len;
+	  if ((b->flags & MEMIF_BUFFER_FLAG_NEXT) == 0)
+	    bm->rx_pkts++;
+	}
+
+      if (n_rx)
+	memif_refill_queue (bm->conn, 0, n_rx, 0);
+    }
+  while (err == MEMIF_ERR_NOBUF);
+}
+
+static void
+bench_run (memif_bench_main_t * bm, uint16_t size, double duration)
+{
+  double t0, t1;
+  uint32_t iter = 0;
+
+  set_packet_length (bm->pkt, size);
+  bm->tx_pkts = bm->rx_pkts = bm->rx_bytes = 0;
+
+  t0 = t1 = now ();
+  while (!stop && bm->connected && t1 - t0 < duration)
+    {
+      bench_tx (bm, size);
+      bench_rx (bm);
+      /* control channel is only checked now and then */
+      if ((++iter & 0xfff) == 0)
+	{
+	  memif_poll_event (0);
+	  t1 = now ();
+	}
+    }
+  t1 = now ();
+
+  /* drain frames still in flight */
+  bench_rx (bm);
+
+  printf ("%6u bytes: tx %.3f Mpps, rx %.3f Mpps %.3f Gbps"
+	  " (%" PRIu64 " not returned)\n", size,
+	  bm->tx_pkts / (t1 - t0) * 1e-6, bm->rx_pkts / (t1 - t0) * 1e-6,
+	  bm->rx_bytes * 8 / (t1 - t0) * 1e-9,
+	  bm->tx_pkts > bm->rx_pkts ? bm->tx_pkts - bm->rx_pkts : 0);
+}
+
+int
+main (int argc, char *argv[])
+{
+  memif_bench_main_t *bm = &memif_bench_main;
+  memif_conn_args_t args;
+  uint16_t sizes[MAX_SIZES] = { 64, 1500, 9000 };
+  int n_sizes = 0, i, err;
+  double duration = 5;
+  char *sock = NULL;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "socket") && i + 1 < argc)
+	sock = argv[++i];
+      else if (!strcmp (argv[i], "time") && i + 1 < argc)
+	duration = atof (argv[++i]);
+      else if (!strcmp (argv[i], "size") && i + 1 < argc
+	       && n_sizes < MAX_SIZES)
+	{
+	  int size = atoi (argv[++i]);
+	  if (size < 64 || size > MAX_PKT_SIZE)
+	    {
+	      INFO ("size must be between 64 and %u", MAX_PKT_SIZE);
+	      return 1;
+	    }
+	  sizes[n_sizes++] = size;
+	}
+      else
+	{
+	  INFO ("usage: %s [socket <file>] [time <sec>] [size <bytes>]...",
+		argv[0]);
+	  return 1;
+	}
+    }
+  if (n_sizes == 0)
+    n_sizes = 3;
+
+  signal (SIGINT, bench_exit);
+
+  bm->tx_bufs = malloc (sizeof (memif_buffer_t) * MAX_MEMIF_BUFS);
+  bm->rx_bufs = malloc (sizeof (memif_buffer_t) * MAX_MEMIF_BUFS);
+  bm->pkt = malloc (MAX_PKT_SIZE);
+  build_packet (bm->pkt);
+
+  err = memif_init (NULL, APP_NAME, NULL, NULL);
+  if (err != MEMIF_ERR_SUCCESS)
+    {
+      INFO ("memif_init: %s", memif_strerror (err));
+      return 1;
+    }
+
+  memset (&args, 0, sizeof (args));
+  args.is_master = 1;
+  args.log2_ring_size = 11;
+  args.buffer_size = BUFFER_SIZE;
+  args.num_s2m_rings = 1;
+  args.num_m2s_rings = 1;
+  args.mode = MEMIF_INTERFACE_MODE_ETHERNET;
+  args.interface_id = 0;
+  args.socket_filename = (uint8_t *) sock;
+  strncpy ((char *) args.interface_name, IF_NAME,
+	   sizeof (args.interface_name) - 1);
+
+  err = memif_create (&bm->conn, &args, on_connect, on_disconnect,
+		      on_interrupt, NULL);
+  if (err != MEMIF_ERR_SUCCESS)
+    {
+      INFO ("memif_create: %s", memif_strerror (err));
+      return 1;
+    }
+
+  INFO ("waiting for slave...");
+  while (!stop && !bm->connected)
+    memif_poll_event (100);
+
+  for (i = 0; i < n_sizes && !stop && bm->connected; i++)
+    bench_run (bm, sizes[i], duration);
+
+  memif_delete (&bm->conn);
+  memif_cleanup ();
+  free (bm->tx_bufs);
+  free (bm->rx_bufs);
+  free (bm->pkt);
+  return 0;
+}
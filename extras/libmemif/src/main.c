@@ -1151,13 +1151,19 @@ memif_disconnect_internal (memif_connection_t * c)
 
   if (c->regions != NULL)
     {
-      if (munmap (c->regions[0].shm, c->regions[0].region_size) < 0)
-	return memif_syscall_error_handler (errno);
-      if (c->regions[0].fd > 0)
-	close (c->regions[0].fd);
-      c->regions[0].fd = -1;
+      for (i = 0; i < c->regions_num; i++)
+	{
+	  memif_region_t *mr = &c->regions[i];
+	  if (mr->shm != NULL && munmap (mr->shm, mr->region_size) < 0)
+	    return memif_syscall_error_handler (errno);
+	  mr->shm = NULL;
+	  if (mr->fd > 0)
+	    close (mr->fd);
+	  mr->fd = -1;
+	}
       lm->free (c->regions);
       c->regions = NULL;
+      c->regions_num = 0;
     }
 
   memset (&c->run_args, 0, sizeof (memif_conn_run_args_t));
@@ -1259,13 +1265,15 @@ int
 memif_connect1 (memif_connection_t * c)
 {
   libmemif_main_t *lm = &libmemif_main;
-  memif_region_t *mr = c->regions;
+  memif_region_t *mr;
   memif_queue_t *mq;
   int i;
   uint16_t num;
 
-  if (mr != NULL)
+  /* map all regions, descriptors may point to any of them */
+  for (i = 0; i < c->regions_num; i++)
     {
+      mr = &c->regions[i];
       if (!mr->shm)
 	{
 	  if (mr->fd < 0)
@@ -1274,6 +1282,7 @@ memif_connect1 (memif_connection_t * c)
 	  if ((mr->shm = mmap (NULL, mr->region_size, PROT_READ | PROT_WRITE,
 			       MAP_SHARED, mr->fd, 0)) == MAP_FAILED)
 	    {
+	      mr->shm = NULL;
 	      return memif_syscall_error_handler (errno);
 	    }
 	}
@@ -1333,6 +1342,7 @@ memif_init_regions_and_queues (memif_connection_t * conn)
   conn->regions = (memif_region_t *) lm->alloc (sizeof (memif_region_t));
   if (conn->regions == NULL)
     return MEMIF_ERR_NOMEM;
+  conn->regions_num = 1;
   r = conn->regions;
 
   r->buffer_offset =
@@ -1632,7 +1642,7 @@ memif_buffer_alloc (memif_conn_handle_t conn, uint16_t qid,
 		c->regions->buffer_offset + (x * c->run_args.buffer_size);
 	    }
 
-	  b0->data = c->regions->shm + ring->desc[slot & mask].offset;
+	  b0->data = memif_get_buffer (c, ring, slot & mask);
 
 	  src_left -= b0->len;
 	  dst_left -= b0->len;
@@ -68,7 +68,7 @@ _Static_assert (strlen (MEMIF_DEFAULT_APP_NAME) <= MEMIF_NAME_LEN,
 typedef struct
 {
   void *shm;
-  uint32_t region_size;
+  memif_region_size_t region_size;
   uint32_t buffer_offset;
   int fd;
 } memif_region_t;
@@ -133,7 +133,10 @@ typedef struct memif_connection
   uint8_t remote_name[MEMIF_NAME_LEN];
   uint8_t remote_disconnect_string[96];
 
+  /* region 0 holds rings, a zero-copy slave adds one region per
+     buffer pool */
   memif_region_t *regions;
+  uint16_t regions_num;
 
   memif_queue_t *rx_queues;
   memif_queue_t *tx_queues;
@@ -492,12 +492,19 @@ memif_msg_receive_add_region (memif_connection_t * c, memif_msg_t * msg,
   if (ar->index > MEMIF_MAX_REGION)
     return MEMIF_ERR_MAXREG;
 
-  mr =
-    (memif_region_t *) realloc (c->regions,
-				sizeof (memif_region_t) * (ar->index + 1));
-  if (mr == NULL)
-    return memif_syscall_error_handler (errno);
-  c->regions = mr;
+  if (ar->index >= c->regions_num)
+    {
+      mr =
+	(memif_region_t *) realloc (c->regions,
+				    sizeof (memif_region_t) * (ar->index + 1));
+      if (mr == NULL)
+	return memif_syscall_error_handler (errno);
+      memset (mr + c->regions_num, 0,
+	      sizeof (memif_region_t) * (ar->index + 1 - c->regions_num));
+      for (; c->regions_num <= ar->index; c->regions_num++)
+	mr[c->regions_num].fd = -1;
+      c->regions = mr;
+    }
   c->regions[ar->index].fd = fd;
   c->regions[ar->index].region_size = ar->size;
   c->regions[ar->index].shm = NULL;
@@ -439,6 +439,7 @@ START_TEST (test_recv_add_region)
   int err;
   memif_connection_t conn;
   conn.regions = NULL;
+  conn.regions_num = 0;
   memif_msg_t msg;
   msg.type = MEMIF_MSG_TYPE_ADD_REGION;
   msg.add_region.size = 2048;
@@ -452,9 +453,30 @@ START_TEST (test_recv_add_region)
 
   memif_region_t *mr = conn.regions;
 
+  ck_assert_uint_eq (conn.regions_num, 1);
   ck_assert_uint_eq (mr->fd, fd);
   ck_assert_uint_eq (mr->region_size, 2048);
   ck_assert_ptr_eq (mr->shm, NULL);
+
+  /* zero-copy slave sends buffer pool regions after the ring region */
+  msg.add_region.size = 1ULL << 32;
+  msg.add_region.index = 2;
+
+  if ((err =
+       memif_msg_receive_add_region (&conn, &msg, fd + 2)) !=
+      MEMIF_ERR_SUCCESS)
+    ck_abort_msg ("err code: %u, err msg: %s", err, memif_strerror (err));
+
+  mr = conn.regions;
+
+  ck_assert_uint_eq (conn.regions_num, 3);
+  ck_assert_uint_eq (mr[0].fd, fd);
+  ck_assert_int_eq (mr[1].fd, -1);
+  ck_assert_ptr_eq (mr[1].shm, NULL);
+  ck_assert_uint_eq (mr[2].fd, fd + 2);
+  ck_assert_uint_eq (mr[2].region_size, 1ULL << 32);
+
+  free (conn.regions);
 }
 
 END_TEST
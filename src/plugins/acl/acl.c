@@ -3257,6 +3257,53 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "lookup-engine"))
+    {
+      u32 engine;
+      u32 lc_index = ~0;
+      acl_lookup_context_t *acontext;
+      int rv = 0;
+
+      if (unformat (input, "hash"))
+	engine = ACL_LOOKUP_ENGINE_HASH;
+      else if (unformat (input, "tuple-merge"))
+	engine = ACL_LOOKUP_ENGINE_TUPLE_MERGE;
+      else
+	{
+	  error = clib_error_return (0,
+				     "expecting hash or tuple-merge, got `%U`",
+				     format_unformat_error, input);
+	  goto done;
+	}
+      if (unformat (input, "lc_index %u", &lc_index))
+	rv = acl_plugin_set_lookup_context_engine (lc_index, engine);
+      else
+	{
+	  /* the default for the new lookup contexts, and all the existing ones */
+	  am->default_lookup_engine = engine;
+	  /* *INDENT-OFF* */
+	  pool_foreach (acontext, am->acl_lookup_contexts,
+	  ({
+	    if (!rv)
+	      rv = acl_plugin_set_lookup_context_engine
+		(acontext - am->acl_lookup_contexts, engine);
+	  }));
+	  /* *INDENT-ON* */
+	}
+      if (rv)
+	error = clib_error_return (0, "setting lookup engine failed: %d",
+				   rv);
+      goto done;
+    }
+  if (unformat (input, "tuple-merge-split-threshold %u", &val))
+    {
+      /* takes effect on the next apply of the ACLs */
+      if (val == 0)
+	error = clib_error_return (0, "split threshold must be at least 1");
+      else
+	am->tuple_merge_split_threshold = val;
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -3369,6 +3416,20 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
 	    }
 	  goto done;
 	}
+      if (unformat (input, "timer-wheel"))
+	{
+	  if (!unformat (input, "%u", &val))
+	    {
+	      error = clib_error_return (0,
+					 "expecting 0 or 1, got `%U`",
+					 format_unformat_error, input);
+	      goto done;
+	    }
+	  if (acl_fa_set_session_timer_wheel (val))
+	    error = clib_error_return (0,
+				       "can not change the session aging while there are sessions");
+	  goto done;
+	}
       if (unformat (input, "timeout"))
 	{
 	  if (unformat (input, "udp"))
@@ -3824,6 +3885,7 @@ acl_plugin_show_sessions (acl_main_t * am,
 	  vlib_cli_output (vm, "    link prev index: %u",
 			   sess->link_prev_idx);
 	  vlib_cli_output (vm, "    link list id: %u", sess->link_list_id);
+	  vlib_cli_output (vm, "    timer handle: %u", sess->timer_handle);
 	}
       vlib_cli_output (vm, "  connection add/del stats:", wk);
       pool_foreach (swif, im->sw_interfaces, (
@@ -3862,6 +3924,24 @@ acl_plugin_show_sessions (acl_main_t * am,
 					       }
 		    ));
 
+      if (pw->session_timers_initialized)
+	{
+	  f64 us_per_clock = 1e6 / (f64) clocks_per_second;
+	  vlib_cli_output (vm, "  session timer wheel:");
+	  vlib_cli_output (vm, "    fired, yet to be checked: %u",
+			   vec_len (pw->timer_expired));
+	  vlib_cli_output (vm, "    sessions expired: %lu",
+			   pw->cnt_timer_expired_sessions);
+	  vlib_cli_output (vm, "    expirations per second: %.2f",
+			   pw->timer_expirations_per_second);
+	  vlib_cli_output (vm,
+			   "    sweeps: %lu, average %.3f us, worst-case %.3f us",
+			   pw->cnt_timer_sweeps,
+			   pw->cnt_timer_sweeps ?
+			   us_per_clock * pw->timer_sweep_total_clocks /
+			   pw->cnt_timer_sweeps : 0.0,
+			   us_per_clock * pw->timer_sweep_max_clocks);
+	}
       vlib_cli_output (vm, "  connection timeout type lists:", wk);
       u8 tt = 0;
       for (tt = 0; tt < ACL_N_TIMEOUTS; tt++)
@@ -3921,6 +4001,9 @@ acl_plugin_show_sessions (acl_main_t * am,
 		   ((f64) am->fa_current_cleaner_timer_wait_interval) *
 		   1000.0 / (f64) vm->clib_time.clocks_per_second);
   vlib_cli_output (vm, "Reclassify sessions: %d", am->reclassify_sessions);
+  vlib_cli_output (vm, "Session aging: %s",
+		   am->fa_use_timer_wheel ? "per-worker timer wheels" :
+		   "conn lists");
 }
 
 static clib_error_t *
@@ -4003,6 +4086,306 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   return error;
 }
 
+/*
+ * A ClassBench-like IPv4 rule: addresses from a few /8 blocks with
+ * a spread of prefix lengths, mostly TCP/UDP with exact, range or
+ * wildcard ports.
+ */
+static void
+acl_bench_make_rule (vl_api_acl_rule_t * r, u32 * seed)
+{
+  static u16 well_known_ports[] =
+    { 22, 25, 53, 80, 123, 443, 1521, 3306, 5060, 8080 };
+  u16 port_first[2], port_last[2];
+  u32 addr, rnd;
+  int i;
+
+  memset (r, 0, sizeof (*r));
+  r->is_permit = random_u32 (seed) & 1;
+  for (i = 0; i < 2; i++)
+    {
+      u8 *prefix_len = i ? &r->dst_ip_prefix_len : &r->src_ip_prefix_len;
+      rnd = random_u32 (seed) % 100;
+      if (rnd < 15)
+	*prefix_len = 0;
+      else if (rnd < 35)
+	*prefix_len = 32;
+      else if (rnd < 50)
+	*prefix_len = 24;
+      else
+	*prefix_len = 8 + random_u32 (seed) % 25;
+      addr = ((10 + random_u32 (seed) % 4) << 24) |
+	(random_u32 (seed) & 0xffffff);
+      addr &= *prefix_len ? ~0 << (32 - *prefix_len) : 0;
+      addr = clib_host_to_net_u32 (addr);
+      clib_memcpy (i ? r->dst_ip_addr : r->src_ip_addr, &addr,
+		   sizeof (addr));
+    }
+
+  rnd = random_u32 (seed) % 100;
+  r->proto = rnd < 50 ? IP_PROTOCOL_TCP : rnd < 80 ? IP_PROTOCOL_UDP :
+    rnd < 90 ? IP_PROTOCOL_ICMP : 0;
+
+  for (i = 0; i < 2; i++)
+    {
+      port_first[i] = 0;
+      port_last[i] = (r->proto == IP_PROTOCOL_ICMP) ? 255 : 65535;
+      rnd = random_u32 (seed) % 100;
+      if (r->proto == IP_PROTOCOL_ICMP)
+	{
+	  if (rnd < 30)
+	    port_first[i] = port_last[i] = i ? 0 : 8;
+	}
+      else if (i == 0)
+	{
+	  /* source ports are mostly wildcard */
+	  if (rnd < 10)
+	    port_first[i] = 1024;
+	  else if (rnd < 20)
+	    port_first[i] = port_last[i] = 1024 + random_u32 (seed) % 64512;
+	}
+      else
+	{
+	  if (rnd < 40)
+	    port_first[i] = port_last[i] =
+	      well_known_ports[random_u32 (seed) %
+			       ARRAY_LEN (well_known_ports)];
+	  else if (rnd < 60)
+	    {
+	      port_first[i] = random_u32 (seed) % 60000;
+	      port_last[i] = port_first[i] + random_u32 (seed) % 1000;
+	    }
+	  else if (rnd < 75)
+	    port_first[i] = 1024;
+	}
+    }
+  r->srcport_or_icmptype_first = clib_host_to_net_u16 (port_first[0]);
+  r->srcport_or_icmptype_last = clib_host_to_net_u16 (port_last[0]);
+  r->dstport_or_icmpcode_first = clib_host_to_net_u16 (port_first[1]);
+  r->dstport_or_icmpcode_last = clib_host_to_net_u16 (port_last[1]);
+}
+
+/*
+ * A packet inside a random rule of the set, or with random addresses
+ * and ports in one of every four packets.
+ */
+static void
+acl_bench_make_packet (fa_5tuple_t * pkt, vl_api_acl_rule_t * rules,
+		       u32 * seed)
+{
+  vl_api_acl_rule_t *r = vec_elt_at_index (rules,
+					   random_u32 (seed) %
+					   vec_len (rules));
+  int is_random = (random_u32 (seed) % 4) == 0;
+  u32 addr, mask;
+  u16 first, last;
+  int i;
+
+  memset (pkt, 0, sizeof (*pkt));
+  for (i = 0; i < 2; i++)
+    {
+      u8 prefix_len = i ? r->dst_ip_prefix_len : r->src_ip_prefix_len;
+      clib_memcpy (&addr, i ? r->dst_ip_addr : r->src_ip_addr,
+		   sizeof (addr));
+      addr = clib_net_to_host_u32 (addr);
+      mask = prefix_len ? ~0 << (32 - prefix_len) : 0;
+      if (is_random)
+	addr = (10 + random_u32 (seed) % 4) << 24;
+      addr = (addr & mask) | (random_u32 (seed) & ~mask);
+      pkt->addr[i].ip4.as_u32 = clib_host_to_net_u32 (addr);
+    }
+
+  pkt->l4.proto = r->proto ? r->proto : IP_PROTOCOL_UDP;
+  for (i = 0; i < 2; i++)
+    {
+      first = clib_net_to_host_u16 (i ? r->dstport_or_icmpcode_first :
+				    r->srcport_or_icmptype_first);
+      last = clib_net_to_host_u16 (i ? r->dstport_or_icmpcode_last :
+				   r->srcport_or_icmptype_last);
+      if (is_random || !r->proto)
+	{
+	  first = 0;
+	  last = (pkt->l4.proto == IP_PROTOCOL_ICMP) ? 255 : 65535;
+	}
+      pkt->l4.port[i] = first + random_u32 (seed) % (last - first + 1);
+    }
+  pkt->pkt.l4_valid = 1;
+  if (pkt->l4.proto == IP_PROTOCOL_TCP)
+    {
+      pkt->pkt.tcp_flags = random_u32 (seed);
+      pkt->pkt.tcp_flags_valid = 1;
+    }
+}
+
+/*
+ * Compare the hash-based lookup engines with each other and with the
+ * linear lookup on a synthetic ruleset: the time to apply the rules,
+ * the memory of the applied entries, tuples and hash keys, the number
+ * of hash keys and of the tables probed per lookup, and the time per
+ * lookup. All lookups must give the result
+ * of the linear lookup.
+ */
+static clib_error_t *
+acl_test_lookup_bench_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  clib_error_t *error = 0;
+  u32 n_rules = 1000;
+  u32 n_packets = 100000;
+  u32 seed = 0xacb0acb0;
+  u32 initial_seed;
+  vl_api_acl_rule_t *rules = 0;
+  fa_5tuple_t *pkts = 0;
+  u64 *linear_results = 0;
+  u32 lc_index[ACL_N_LOOKUP_ENGINES];
+  u32 acl_index = ~0;
+  u32 *acls = 0;
+  u32 mismatches = 0;
+  u32 user_id, engine, i;
+  u8 tag[64];
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %u", &n_rules))
+	;
+      else if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (n_rules == 0 || n_packets == 0)
+    return clib_error_return (0, "need at least one rule and one packet");
+
+  initial_seed = seed;
+  vec_validate (rules, n_rules - 1);
+  vec_foreach_index (i, rules) acl_bench_make_rule (&rules[i], &seed);
+  vec_validate (pkts, n_packets - 1);
+  vec_foreach_index (i, pkts)
+    acl_bench_make_packet (&pkts[i], rules, &seed);
+
+  memset (tag, 0, sizeof (tag));
+  snprintf ((char *) tag, sizeof (tag), "lookup-bench");
+  rv = acl_add_list (n_rules, rules, &acl_index, tag);
+  if (rv)
+    {
+      error = clib_error_return (0, "adding the ACL failed: %d", rv);
+      goto done;
+    }
+  vec_add1 (acls, acl_index);
+
+  vlib_cli_output (vm, "%u rules, %u packets, seed %u", n_rules, n_packets,
+		   initial_seed);
+  vlib_cli_output (vm, "%-12s %10s %10s %8s %8s %10s", "engine",
+		   "apply us", "memory KB", "keys", "tables", "lookup ns");
+
+  user_id = acl_plugin_register_user_module ("ACL lookup bench", "engine",
+					     "unused");
+  for (engine = 0; engine < ACL_N_LOOKUP_ENGINES; engine++)
+    lc_index[engine] =
+      acl_plugin_get_lookup_context_index (user_id, engine, 0);
+
+  /* the reference */
+  {
+    u64 t0, t1;
+    u8 action;
+    u32 acl_pos, acl_match, rule_match, trace_bitmap = 0;
+
+    vec_validate (linear_results, n_packets - 1);
+    rv = acl_plugin_set_acl_vec_for_context (lc_index[0], acls);
+    t0 = clib_cpu_time_now ();
+    for (i = 0; i < n_packets; i++)
+      {
+	pkts[i].pkt.lc_index = lc_index[0];
+	if (linear_multi_acl_match_5tuple (lc_index[0], &pkts[i], 0,
+					   &action, &acl_pos, &acl_match,
+					   &rule_match, &trace_bitmap))
+	  linear_results[i] = ((u64) acl_match << 32) | (rule_match << 1) |
+	    action;
+	else
+	  linear_results[i] = ~0ULL;
+      }
+    t1 = clib_cpu_time_now ();
+    vlib_cli_output (vm, "%-12s %10s %10s %8s %8s %10.1f", "linear", "-",
+		     "-", "-", "-",
+		     (t1 - t0) * vm->clib_time.seconds_per_clock * 1e9 /
+		     n_packets);
+  }
+
+  for (engine = 0; engine < ACL_N_LOOKUP_ENGINES; engine++)
+    {
+      applied_hash_acl_info_t *pal;
+      applied_hash_ace_entry_t *pae;
+      uword memory;
+      f64 apply_time;
+      u64 t0, t1, result;
+      u8 action;
+      u32 acl_pos, acl_match, rule_match, trace_bitmap = 0;
+      u32 n_keys = 0, n_tables;
+
+      acl_plugin_set_lookup_context_engine (lc_index[engine], engine);
+      /* from scratch, the reference run applied the ACL on the first one */
+      acl_plugin_set_acl_vec_for_context (lc_index[engine], 0);
+      apply_time = vlib_time_now (vm);
+      rv = acl_plugin_set_acl_vec_for_context (lc_index[engine], acls);
+      apply_time = vlib_time_now (vm) - apply_time;
+      if (rv)
+	{
+	  error = clib_error_return (0, "applying the ACL failed: %d", rv);
+	  break;
+	}
+
+      pal = vec_elt_at_index (am->applied_hash_acl_info_by_lc_index,
+			      lc_index[engine]);
+      vec_foreach (pae, am->hash_entry_vec_by_lc_index[lc_index[engine]])
+	n_keys += (pae->prev_applied_entry_index == ~0);
+      n_tables = pal->use_tuple_merge ? vec_len (pal->tuples) :
+	clib_bitmap_count_set_bits (pal->mask_type_index_bitmap);
+      memory = vec_bytes (am->hash_entry_vec_by_lc_index[lc_index[engine]]) +
+	vec_bytes (pal->tuples) + n_keys * sizeof (clib_bihash_kv_48_8_t);
+
+      for (i = 0; i < n_packets; i++)
+	pkts[i].pkt.lc_index = lc_index[engine];
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < n_packets; i++)
+	{
+	  if (hash_multi_acl_match_5tuple (lc_index[engine], &pkts[i], 0,
+					   &action, &acl_pos, &acl_match,
+					   &rule_match, &trace_bitmap))
+	    result = ((u64) acl_match << 32) | (rule_match << 1) | action;
+	  else
+	    result = ~0ULL;
+	  mismatches += (result != linear_results[i]);
+	}
+      t1 = clib_cpu_time_now ();
+
+      vlib_cli_output (vm, "%-12U %10.1f %10lu %8u %8u %10.1f",
+		       format_acl_lookup_engine, engine, apply_time * 1e6,
+		       memory >> 10, n_keys, n_tables,
+		       (t1 - t0) * vm->clib_time.seconds_per_clock * 1e9 /
+		       n_packets);
+    }
+
+  for (engine = 0; engine < ACL_N_LOOKUP_ENGINES; engine++)
+    acl_plugin_put_lookup_context_index (lc_index[engine]);
+  acl_del_list (acl_index);
+
+  if (!error && mismatches)
+    error = clib_error_return (0, "%u lookups differ from the linear lookup",
+			       mismatches);
+
+done:
+  vec_free (rules);
+  vec_free (pkts);
+  vec_free (linear_results);
+  vec_free (acls);
+  return error;
+}
+
 static clib_error_t *
 acl_clear_aclplugin_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -4017,7 +4400,7 @@ acl_clear_aclplugin_fn (vlib_main_t * vm,
  /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (aclplugin_set_command, static) = {
     .path = "set acl-plugin",
-    .short_help = "set acl-plugin session timeout {{udp idle}|tcp {idle|transient}} <seconds>",
+    .short_help = "set acl-plugin session timeout {{udp idle}|tcp {idle|transient}} <seconds> | session timer-wheel {0|1} | lookup-engine {hash|tuple-merge} [lc_index <n>]",
     .function = acl_set_aclplugin_fn,
 };
 
@@ -4081,6 +4464,12 @@ VLIB_CLI_COMMAND (aclplugin_show_macip_interface_command, static) = {
     .function = acl_show_aclplugin_macip_interface_fn,
 };
 
+VLIB_CLI_COMMAND (aclplugin_test_lookup_bench_command, static) = {
+    .path = "test acl-plugin lookup-bench",
+    .short_help = "test acl-plugin lookup-bench [rules <n>] [packets <n>] [seed <n>]",
+    .function = acl_test_lookup_bench_fn,
+};
+
 VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .path = "clear acl-plugin sessions",
     .short_help = "clear acl-plugin sessions",
@@ -4100,6 +4489,7 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
   u32 hash_lookup_hash_buckets;
   u32 hash_lookup_hash_memory;
   u32 reclassify_sessions;
+  u32 tuple_merge_split_threshold;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -4131,6 +4521,16 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "reclassify sessions %d",
 			 &reclassify_sessions))
 	am->reclassify_sessions = reclassify_sessions;
+      else if (unformat (input, "session timer wheel"))
+	am->fa_use_timer_wheel = 1;
+      else if (unformat (input, "lookup engine hash"))
+	am->default_lookup_engine = ACL_LOOKUP_ENGINE_HASH;
+      else if (unformat (input, "lookup engine tuple-merge"))
+	am->default_lookup_engine = ACL_LOOKUP_ENGINE_TUPLE_MERGE;
+      else if (unformat (input, "tuple merge split threshold %d",
+			 &tuple_merge_split_threshold))
+	am->tuple_merge_split_threshold =
+	  clib_max (tuple_merge_split_threshold, 1);
 
       else
 	return clib_error_return (0, "unknown input '%U'",
@@ -4171,6 +4571,8 @@ acl_init (vlib_main_t * vm)
 
   am->hash_lookup_hash_buckets = ACL_PLUGIN_HASH_LOOKUP_HASH_BUCKETS;
   am->hash_lookup_hash_memory = ACL_PLUGIN_HASH_LOOKUP_HASH_MEMORY;
+  am->default_lookup_engine = ACL_LOOKUP_ENGINE_HASH;
+  am->tuple_merge_split_threshold = ACL_PLUGIN_TUPLE_MERGE_SPLIT_THRESHOLD;
 
   am->session_timeout_sec[ACL_TIMEOUT_TCP_TRANSIENT] =
     TCP_SESSION_TRANSIENT_TIMEOUT_SEC;
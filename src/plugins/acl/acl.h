@@ -43,6 +43,8 @@
 #define ACL_PLUGIN_HASH_LOOKUP_HEAP_SIZE (2 << 25)
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_BUCKETS 65536
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_MEMORY (2 << 25)
+/* max entries with the same key in a tuple merge tuple */
+#define ACL_PLUGIN_TUPLE_MERGE_SPLIT_THRESHOLD 16
 
 extern vlib_node_registration_t acl_in_node;
 extern vlib_node_registration_t acl_out_node;
@@ -212,6 +214,11 @@ typedef struct {
   /* Do we use hash-based ACL matching or linear */
   int use_hash_acl_matching;
 
+  /* hash-based lookup engine of the newly created lookup contexts */
+  u8 default_lookup_engine;
+  /* tuple merge: entries with the same key a tuple takes before a new one is made */
+  u32 tuple_merge_split_threshold;
+
   /* a pool of all mask types present in all ACEs */
   ace_mask_type_entry_t *ace_mask_type_pool;
 
@@ -280,6 +287,8 @@ typedef struct {
   u32 fa_conn_table_hash_num_buckets;
   uword fa_conn_table_hash_memory_size;
   u64 fa_conn_table_max_entries;
+  /* age the sessions on per-worker timer wheels rather than conn lists */
+  int fa_use_timer_wheel;
 
   int trace_sessions;
   int trace_acl;
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <vppinfra/bihash_40_8.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 // #define FA_NODE_VERBOSE_DEBUG 3
 
@@ -21,6 +22,13 @@
 #define ACL_FA_CONN_TABLE_DEFAULT_HASH_MEMORY_SIZE (1ULL<<30)
 #define ACL_FA_CONN_TABLE_DEFAULT_MAX_ENTRIES 500000
 
+/* Session timer wheel tick, seconds */
+#define ACL_FA_SESSION_TIMER_TICK 0.1
+/* Max number of sessions checked per run of the session timers node */
+#define ACL_FA_SESSION_TIMER_EXPIRE_BATCH 256
+/* Max number of pool slots looked at per run when clearing sessions */
+#define ACL_FA_SESSION_TIMER_CLEAR_BATCH 1024
+
 typedef union {
   u64 as_u64;
   struct {
@@ -82,7 +90,9 @@ typedef struct {
   u8 link_list_id;        /* +1 bytes = 17 */
   u8 deleted;             /* +1 bytes = 18 */
   u8 reserved1[6];        /* +6 bytes = 24 */
-  u64 reserved2[5];       /* +5*8 bytes = 64 */
+  u32 timer_handle;       /* +4 bytes = 28 */
+  u32 reserved3;          /* +4 bytes = 32 */
+  u64 reserved2[4];       /* +4*8 bytes = 64 */
 } fa_session_t;
 
 #define FA_POLICY_EPOCH_MASK 0x7fff
@@ -175,6 +185,23 @@ typedef struct {
    * Set to copy of a "generation" counter in main thread so we can sync the interrupts.
    */
   int interrupt_generation;
+  /* Session idle timers, used instead of the conn lists in timer wheel mode */
+  tw_timer_wheel_1t_3w_1024sl_ov_t session_timers;
+  int session_timers_initialized;
+  /* Sessions whose timer fired, yet to be checked */
+  u32 *timer_expired;
+  /* next session pool index to look at while clearing the interfaces */
+  u32 timer_clear_next_index;
+  /* Sessions deleted by the timers */
+  u64 cnt_timer_expired_sessions;
+  /* expirations per second, measured over about a second */
+  f64 timer_expirations_per_second;
+  f64 timer_rate_interval_start;
+  u64 timer_rate_interval_base;
+  /* runs of the session timers node which had work, and their cost */
+  u64 cnt_timer_sweeps;
+  u64 timer_sweep_total_clocks;
+  u64 timer_sweep_max_clocks;
 } acl_fa_per_worker_data_t;
 
 
@@ -192,6 +219,8 @@ enum
 
 void acl_fa_enable_disable(u32 sw_if_index, int is_input, int enable_disable);
 
+int acl_fa_set_session_timer_wheel(int enable);
+
 void show_fa_sessions_hash(vlib_main_t * vm, u32 verbose);
 
 u8 *format_acl_plugin_5tuple (u8 * s, va_list * args);
@@ -63,8 +63,19 @@ fill_applied_hash_ace_kv(acl_main_t *am,
   hash_acl_lookup_value_t *kv_val = (hash_acl_lookup_value_t *)&kv->value;
   applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), new_index);
   hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+  ace_mask_type_entry_t *mte = pool_elt_at_index(am->ace_mask_type_pool, pae->mask_type_index);
+  u64 *pmatch = (u64 *)&(vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->match);
+  u64 *pmask = (u64 *)&mte->mask;
+  int i;
 
-  memcpy(kv_key, &(vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->match), sizeof(*kv_key));
+  /*
+   * The rule match under the mask of the table the entry is in. With the
+   * hash engine this is the own mask of the rule, so the match itself.
+   */
+  for(i=0; i<6; i++) {
+    kv->key[i] = pmatch[i] & pmask[i];
+  }
+  kv_key->pkt.mask_type_index_lsb = pae->mask_type_index;
   /* initialize the sw_if_index and direction */
   kv_key->pkt.lc_index = lc_index;
   kv_val->as_u64 = 0;
@@ -193,6 +204,180 @@ acl_plugin_hash_acl_set_trace_heap(int on)
   }
 }
 
+/*
+ * Tuple merge: rather than one hash table per mask type of the applied
+ * rules, put the rules into fewer tuples with less specific masks. A rule
+ * fits a tuple whose mask is a subset of its own, its key is its match
+ * under the tuple mask. The lookup probes each tuple once and checks the
+ * entries under the key against their own mask. The number of entries
+ * with the same key in a tuple is kept under tuple_merge_split_threshold,
+ * a rule that does not fit gets a new tuple.
+ */
+
+static u32 find_mask_type_index(acl_main_t *am, fa_5tuple_t *mask);
+static u32 assign_mask_type_index(acl_main_t *am, fa_5tuple_t *mask);
+static void release_mask_type_index(acl_main_t *am, u32 mask_type_index);
+static void make_address_mask(ip46_address_t *addr, u8 is_ipv6, u8 prefix_len);
+
+static applied_hash_tuple_info_t *
+tm_find_tuple(applied_hash_acl_info_t *pal, u32 mask_type_index)
+{
+  applied_hash_tuple_info_t *tuple;
+  vec_foreach(tuple, pal->tuples) {
+    if (tuple->mask_type_index == mask_type_index)
+      return tuple;
+  }
+  return 0;
+}
+
+static int
+tm_mask_is_subset(fa_5tuple_t *tuple_mask, fa_5tuple_t *mask)
+{
+  u64 *pt = (u64 *)tuple_mask;
+  u64 *pm = (u64 *)mask;
+  int i;
+  for(i=0; i<6; i++) {
+    if ((pt[i] & pm[i]) != pt[i])
+      return 0;
+  }
+  return 1;
+}
+
+/*
+ * The mask of a new tuple: the address prefixes shortened to a byte
+ * (IPv4) or a 16 bit (IPv6) boundary, so that the rules with the nearby
+ * prefix lengths can share it.
+ */
+static void
+tm_relax_mask(fa_5tuple_t *mask, int is_ip6)
+{
+  int i;
+  for(i=0; i<2; i++) {
+    ip46_address_t *addr = &mask->addr[i];
+    u8 prefix_len = is_ip6 ?
+      count_set_bits(addr->as_u64[0]) + count_set_bits(addr->as_u64[1]) :
+      count_set_bits(addr->ip4.as_u32);
+    make_address_mask(addr, is_ip6, prefix_len & ~(is_ip6 ? 15 : 7));
+  }
+}
+
+/* number of entries with the key of the entry under its current tuple, up to max */
+static u32
+tm_count_colliding_entries(acl_main_t *am, u32 lc_index,
+                            applied_hash_ace_entry_t **applied_hash_aces,
+                            u32 index, u32 max)
+{
+  clib_bihash_kv_48_8_t kv;
+  clib_bihash_kv_48_8_t result;
+  hash_acl_lookup_value_t *result_val = (hash_acl_lookup_value_t *)&result.value;
+  u32 curr_index;
+  u32 n = 0;
+
+  fill_applied_hash_ace_kv(am, applied_hash_aces, lc_index, index, &kv);
+  if (BV (clib_bihash_search) (&am->acl_lookup_hash, &kv, &result))
+    return 0;
+  curr_index = result_val->applied_entry_index;
+  while ((curr_index != ~0) && (n < max)) {
+    n++;
+    curr_index = vec_elt_at_index((*applied_hash_aces), curr_index)->next_applied_entry_index;
+  }
+  return n;
+}
+
+/* pick the tuple for a new applied entry, return its mask type index */
+static u32
+tm_assign_tuple(acl_main_t *am, u32 lc_index, applied_hash_acl_info_t *pal,
+                applied_hash_ace_entry_t **applied_hash_aces, u32 new_index)
+{
+  applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), new_index);
+  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+  hash_ace_info_t *hi = vec_elt_at_index(ha->rules, pae->hash_ace_info_index);
+  applied_hash_tuple_info_t *tuple;
+  ace_mask_type_entry_t *mte;
+  fa_5tuple_t mask;
+  u32 mask_type_index;
+
+  mte = pool_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index);
+  clib_memcpy(&mask, &mte->mask, sizeof(mask));
+
+  /* first fit among the existing tuples */
+  vec_foreach(tuple, pal->tuples) {
+    mte = pool_elt_at_index(am->ace_mask_type_pool, tuple->mask_type_index);
+    if (!tm_mask_is_subset(&mte->mask, &mask))
+      continue;
+    pae->mask_type_index = tuple->mask_type_index;
+    if (tm_count_colliding_entries(am, lc_index, applied_hash_aces, new_index,
+                                   am->tuple_merge_split_threshold) < am->tuple_merge_split_threshold)
+      return tuple->mask_type_index;
+  }
+
+  tm_relax_mask(&mask, hi->match.pkt.is_ip6);
+  mask_type_index = find_mask_type_index(am, &mask);
+  if ((mask_type_index != ~0) && tm_find_tuple(pal, mask_type_index)) {
+    /* the relaxed tuple is full for this key, fall back to the own mask of the rule */
+    if (tm_find_tuple(pal, hi->mask_type_index))
+      return hi->mask_type_index;
+    mte = pool_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index);
+    clib_memcpy(&mask, &mte->mask, sizeof(mask));
+  }
+  DBG("TM: new tuple for lc_index %d applied index %d", lc_index, new_index);
+  vec_add2(pal->tuples, tuple, 1);
+  tuple->mask_type_index = assign_mask_type_index(am, &mask);
+  tuple->n_entries = 0;
+  tuple->first_entry_index = ~0;
+  return tuple->mask_type_index;
+}
+
+static int
+tm_tuple_cmp(void *a1, void *a2)
+{
+  applied_hash_tuple_info_t *t1 = a1;
+  applied_hash_tuple_info_t *t2 = a2;
+  return (t1->first_entry_index > t2->first_entry_index) -
+         (t1->first_entry_index < t2->first_entry_index);
+}
+
+/*
+ * Recount the entries of the tuples of a lookup context after the apply
+ * or unapply, drop the empty ones and sort the rest on the first entry,
+ * so the lookup can stop once it has a match in front of the next tuple.
+ */
+static void
+tm_update_tuples(acl_main_t *am, u32 lc_index)
+{
+  applied_hash_acl_info_t *pal = vec_elt_at_index(am->applied_hash_acl_info_by_lc_index, lc_index);
+  applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, lc_index);
+  applied_hash_tuple_info_t *tuple;
+  applied_hash_ace_entry_t *pae;
+  uword *new_lookup_bitmap = 0;
+  int i;
+
+  vec_foreach(tuple, pal->tuples) {
+    tuple->n_entries = 0;
+    tuple->first_entry_index = ~0;
+  }
+  vec_foreach(pae, (*applied_hash_aces)) {
+    tuple = tm_find_tuple(pal, pae->mask_type_index);
+    ASSERT(tuple);
+    if (0 == tuple->n_entries++)
+      tuple->first_entry_index = pae - (*applied_hash_aces);
+  }
+  for(i = vec_len(pal->tuples); i > 0; i--) {
+    if (0 == pal->tuples[i-1].n_entries) {
+      release_mask_type_index(am, pal->tuples[i-1].mask_type_index);
+      vec_del1(pal->tuples, i-1);
+    }
+  }
+  vec_sort_with_function(pal->tuples, tm_tuple_cmp);
+
+  /* the bitmap is informational only with tuple merge */
+  vec_foreach(tuple, pal->tuples) {
+    new_lookup_bitmap = clib_bitmap_set(new_lookup_bitmap, tuple->mask_type_index, 1);
+  }
+  clib_bitmap_free(pal->mask_type_index_bitmap);
+  pal->mask_type_index_bitmap = new_lookup_bitmap;
+}
+
 void
 hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
 {
@@ -228,6 +413,11 @@ hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
                  acl_index, lc_index);
     goto done;
   }
+  if (0 == vec_len(pal->applied_acls)) {
+    /* the engine can change only while nothing is applied */
+    acl_lookup_context_t *acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+    pal->use_tuple_merge = (acontext->lookup_engine == ACL_LOOKUP_ENGINE_TUPLE_MERGE);
+  }
   vec_add1(pal->applied_acls, acl_index);
   u32 index2 = vec_search((*hash_acl_applied_lc_index), lc_index);
   if (index2 != ~0) {
@@ -237,8 +427,9 @@ hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
   }
   vec_add1((*hash_acl_applied_lc_index), lc_index);
 
-  pal->mask_type_index_bitmap = clib_bitmap_or(pal->mask_type_index_bitmap,
-                                     ha->mask_type_index_bitmap);
+  if (!pal->use_tuple_merge)
+    pal->mask_type_index_bitmap = clib_bitmap_or(pal->mask_type_index_bitmap,
+                                       ha->mask_type_index_bitmap);
   /*
    * if the applied ACL is empty, the current code will cause a
    * different behavior compared to current linear search: an empty ACL will
@@ -266,8 +457,13 @@ hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
     pae->next_applied_entry_index = ~0;
     pae->prev_applied_entry_index = ~0;
     pae->tail_applied_entry_index = ~0;
+    pae->mask_type_index = ha->rules[i].mask_type_index;
+    if (pal->use_tuple_merge)
+      pae->mask_type_index = tm_assign_tuple(am, lc_index, pal, applied_hash_aces, new_index);
     activate_applied_ace_hash_entry(am, lc_index, applied_hash_aces, new_index);
   }
+  if (pal->use_tuple_merge)
+    tm_update_tuples(am, lc_index);
   applied_hash_entries_analyze(am, applied_hash_aces);
 done:
   clib_mem_set_heap (oldheap);
@@ -476,7 +672,10 @@ hash_acl_unapply(acl_main_t *am, u32 lc_index, int acl_index)
   applied_hash_entries_analyze(am, applied_hash_aces);
 
   /* After deletion we might not need some of the mask-types anymore... */
-  hash_acl_build_applied_lookup_bitmap(am, lc_index);
+  if (pal->use_tuple_merge)
+    tm_update_tuples(am, lc_index);
+  else
+    hash_acl_build_applied_lookup_bitmap(am, lc_index);
   clib_mem_set_heap (oldheap);
 }
 
@@ -823,9 +1022,10 @@ void
 acl_plugin_print_pae (vlib_main_t * vm, int j, applied_hash_ace_entry_t * pae)
 {
   vlib_cli_output (vm,
-		   "    %4d: acl %d rule %d action %d bitmask-ready rule %d next %d prev %d tail %d hitcount %lld",
+		   "    %4d: acl %d rule %d action %d bitmask-ready rule %d mask type %d next %d prev %d tail %d hitcount %lld",
 		   j, pae->acl_index, pae->ace_index, pae->action,
-		   pae->hash_ace_info_index, pae->next_applied_entry_index,
+		   pae->hash_ace_info_index, pae->mask_type_index,
+		   pae->next_applied_entry_index,
 		   pae->prev_applied_entry_index,
 		   pae->tail_applied_entry_index, pae->hitcount);
 }
@@ -850,8 +1050,19 @@ acl_plugin_show_tables_applied_info (u32 lc_index)
 	{
 	  applied_hash_acl_info_t *pal =
 	    &am->applied_hash_acl_info_by_lc_index[lci];
+	  applied_hash_tuple_info_t *tuple;
+	  vlib_cli_output (vm, "  lookup engine: %U",
+			   format_acl_lookup_engine,
+			   pal->use_tuple_merge ?
+			   ACL_LOOKUP_ENGINE_TUPLE_MERGE :
+			   ACL_LOOKUP_ENGINE_HASH);
 	  vlib_cli_output (vm, "  lookup mask_type_index_bitmap: %U",
 			   format_bitmap_hex, pal->mask_type_index_bitmap);
+	  vec_foreach (tuple, pal->tuples)
+	    vlib_cli_output (vm,
+			     "  tuple mask type %d entries %d first entry %d",
+			     tuple->mask_type_index, tuple->n_entries,
+			     tuple->first_entry_index);
 	  vlib_cli_output (vm, "  applied acls: %U", format_vec32,
 			   pal->applied_acls, "%d");
 	}
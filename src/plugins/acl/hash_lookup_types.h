@@ -73,12 +73,29 @@ typedef struct {
    * acl position in vector of ACLs within lookup context
    */
   u32 acl_position;
+  /*
+   * mask type of the hash table this entry is in: the own mask type
+   * of the rule with the hash engine, the tuple's one with tuple merge.
+   */
+  u32 mask_type_index;
   /*
    * Action of this applied ACE
    */
   u8 action;
 } applied_hash_ace_entry_t;
 
+/*
+ * A tuple (a mask type) of the tuple merge lookup engine.
+ * Holds the entries whose own mask is the same or more specific.
+ */
+typedef struct {
+  u32 mask_type_index;
+  /* number of applied entries in this tuple */
+  u32 n_entries;
+  /* smallest applied entry index, the tuples are sorted on it */
+  u32 first_entry_index;
+} applied_hash_tuple_info_t;
+
 typedef struct {
    /*
     * A logical OR of all the applied_ace_hash_entry_t=>
@@ -87,6 +104,10 @@ typedef struct {
    uword *mask_type_index_bitmap;
    /* applied ACLs so we can track them independently from main ACL module */
    u32 *applied_acls;
+   /* look up using the tuples below rather than the mask type bitmap */
+   u8 use_tuple_merge;
+   /* tuple merge tuples, in the order of their first entry */
+   applied_hash_tuple_info_t *tuples;
 } applied_hash_acl_info_t;
 
 
@@ -97,6 +97,7 @@ int acl_plugin_get_lookup_context_index (u32 acl_user_id, u32 val1, u32 val2)
   acontext->context_user_id = acl_user_id;
   acontext->user_val1 = val1;
   acontext->user_val2 = val2;
+  acontext->lookup_engine = am->default_lookup_engine;
 
   u32 new_context_id = acontext - am->acl_lookup_contexts;
   vec_add1(am->acl_users[acl_user_id].lookup_contexts, new_context_id);
@@ -255,6 +256,47 @@ done:
   return rv;
 }
 
+/*
+ * Select the hash-based lookup engine of a lookup context.
+ * The applied ACLs are taken off and applied again with the new engine.
+ */
+int acl_plugin_set_lookup_context_engine (u32 lc_index, u32 engine)
+{
+  acl_main_t *am = &acl_main;
+  acl_lookup_context_t *acontext;
+
+  if (!acl_lc_index_valid(am, lc_index))
+    return VNET_API_ERROR_INVALID_VALUE;
+  if (engine >= ACL_N_LOOKUP_ENGINES)
+    return VNET_API_ERROR_INVALID_VALUE_2;
+
+  elog_acl_cond_trace_X2(am, (am->trace_acl), "LOOKUP-CONTEXT: set-engine lc_index %d engine %d", "i4i4", lc_index, engine);
+  void *oldheap = acl_plugin_set_heap ();
+  acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+  if (acontext->lookup_engine != engine) {
+    unapply_acl_vec(lc_index, acontext->acl_indices);
+    acontext->lookup_engine = engine;
+    apply_acl_vec(lc_index, acontext->acl_indices);
+  }
+  clib_mem_set_heap (oldheap);
+  return 0;
+}
+
+u8 *
+format_acl_lookup_engine (u8 * s, va_list * args)
+{
+  u32 engine = va_arg (*args, u32);
+
+  switch (engine) {
+  case ACL_LOOKUP_ENGINE_HASH:
+    return format (s, "hash");
+  case ACL_LOOKUP_ENGINE_TUPLE_MERGE:
+    return format (s, "tuple-merge");
+  default:
+    return format (s, "unknown %d", engine);
+  }
+}
+
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num)
 {
@@ -328,14 +370,16 @@ acl_plugin_show_lookup_context (u32 lc_index)
     if ((lc_index == ~0) || (curr_lc_index == lc_index)) {
       if (acl_user_id_valid(am, acontext->context_user_id)) {
         acl_lookup_context_user_t *auser = pool_elt_at_index(am->acl_users, acontext->context_user_id);
-        vlib_cli_output (vm, "index %d:%s %s: %d %s: %d, acl_indices: %U",
+        vlib_cli_output (vm, "index %d:%s %s: %d %s: %d, engine: %U, acl_indices: %U",
                        curr_lc_index, auser->user_module_name, auser->val1_label,
                        acontext->user_val1, auser->val2_label, acontext->user_val2,
+                       format_acl_lookup_engine, (u32) acontext->lookup_engine,
                        format_vec32, acontext->acl_indices, "%d");
       } else {
-        vlib_cli_output (vm, "index %d: user_id: %d user_val1: %d user_val2: %d, acl_indices: %U",
+        vlib_cli_output (vm, "index %d: user_id: %d user_val1: %d user_val2: %d, engine: %U, acl_indices: %U",
                        curr_lc_index, acontext->context_user_id,
                        acontext->user_val1, acontext->user_val2,
+                       format_acl_lookup_engine, (u32) acontext->lookup_engine,
                        format_vec32, acontext->acl_indices, "%d");
       }
     }
@@ -27,6 +27,14 @@ typedef struct {
   u32 *lookup_contexts;
 } acl_lookup_context_user_t;
 
+typedef enum {
+  /* one hash lookup per mask type of the applied rules */
+  ACL_LOOKUP_ENGINE_HASH = 0,
+  /* rules merged into fewer, less specific tuples */
+  ACL_LOOKUP_ENGINE_TUPLE_MERGE,
+  ACL_N_LOOKUP_ENGINES,
+} acl_lookup_engine_t;
+
 typedef struct {
   /* vector of acl #s within this context */
   u32 *acl_indices;
@@ -36,10 +44,14 @@ typedef struct {
   u32 user_val1;
   /* per-instance user value 2 */
   u32 user_val2;
+  /* acl_lookup_engine_t used by the hash-based lookup */
+  u8 lookup_engine;
 } acl_lookup_context_t;
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
 
+format_function_t format_acl_lookup_engine;
+
 void acl_plugin_show_lookup_context (u32 lc_index);
 void acl_plugin_show_lookup_user (u32 user_index);
 
@@ -126,6 +126,16 @@ int acl_plugin_match_5tuple (u32 lc_index,
                                            u32 * trace_bitmap);
 #endif
 
+/*
+ * Select the hash-based lookup engine (acl_lookup_engine_t) of a lookup
+ * context. The ACLs of the context are applied again with the new engine.
+ */
+#ifdef ACL_PLUGIN_EXTERNAL_EXPORTS
+int (*acl_plugin_set_lookup_context_engine) (u32 lc_index, u32 engine);
+#else
+int acl_plugin_set_lookup_context_engine (u32 lc_index, u32 engine);
+#endif
+
 #ifdef ACL_PLUGIN_DEFINED_BELOW_IN_FILE
 static inline int
 acl_plugin_match_5tuple_inline (u32 lc_index,
@@ -161,6 +171,7 @@ static inline clib_error_t * acl_plugin_exports_init (void)
     LOAD_SYMBOL(acl_plugin_set_acl_vec_for_context);
     LOAD_SYMBOL(acl_plugin_fill_5tuple);
     LOAD_SYMBOL(acl_plugin_match_5tuple);
+    LOAD_SYMBOL(acl_plugin_set_lookup_context_engine);
     return 0;
 }
 
@@ -693,6 +704,95 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   return curr_match_index;
 }
 
+/*
+ * Check the packet against the own mask and match of the rule behind
+ * an applied entry, found in a tuple merge tuple with a less specific mask.
+ */
+always_inline int
+tm_match_applied_ace(acl_main_t *am, fa_5tuple_t *match,
+                     applied_hash_ace_entry_t *pae, u32 index)
+{
+  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+  hash_ace_info_t *hi = vec_elt_at_index(ha->rules, pae->hash_ace_info_index);
+  ace_mask_type_entry_t *mte = vec_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index);
+  u64 *pmatch = (u64 *)match;
+  u64 *pmask = (u64 *)&mte->mask;
+  u64 *prule = (u64 *)&hi->match;
+  fa_packet_info_t pkt;
+
+  if (((pmatch[0] & pmask[0]) != prule[0]) |
+      ((pmatch[1] & pmask[1]) != prule[1]) |
+      ((pmatch[2] & pmask[2]) != prule[2]) |
+      ((pmatch[3] & pmask[3]) != prule[3]) |
+      ((pmatch[4] & pmask[4]) != prule[4]))
+    return 0;
+
+  /* the rule match has no lc_index, and its own mask type */
+  pkt.as_u64 = match->pkt.as_u64 & mte->mask.pkt.as_u64;
+  pkt.lc_index = 0;
+  pkt.mask_type_index_lsb = hi->mask_type_index;
+  if (pkt.as_u64 != hi->match.pkt.as_u64)
+    return 0;
+
+  if (PREDICT_FALSE(hi->src_portrange_not_powerof2 || hi->dst_portrange_not_powerof2))
+    return match_portranges(am, match, index);
+  return 1;
+}
+
+always_inline u32
+tm_multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
+{
+  clib_bihash_kv_48_8_t kv;
+  clib_bihash_kv_48_8_t result;
+  fa_5tuple_t *kv_key = (fa_5tuple_t *)kv.key;
+  hash_acl_lookup_value_t *result_val = (hash_acl_lookup_value_t *)&result.value;
+  u64 *pmatch = (u64 *)match;
+  u64 *pmask;
+  u32 curr_match_index = ~0;
+  u32 curr_index;
+  applied_hash_tuple_info_t *tuple;
+
+  u32 lc_index = match->pkt.lc_index;
+  applied_hash_ace_entry_t **applied_hash_aces = vec_elt_at_index(am->hash_entry_vec_by_lc_index, lc_index);
+  applied_hash_acl_info_t *pal = vec_elt_at_index(am->applied_hash_acl_info_by_lc_index, lc_index);
+
+  DBG("TM TRYING TO MATCH: %016llx %016llx %016llx %016llx %016llx %016llx",
+	       pmatch[0], pmatch[1], pmatch[2], pmatch[3], pmatch[4], pmatch[5]);
+
+  vec_foreach(tuple, pal->tuples) {
+    /* the tuples are sorted on the first entry, none of the rest can win */
+    if (tuple->first_entry_index >= curr_match_index)
+      break;
+    ace_mask_type_entry_t *mte = vec_elt_at_index(am->ace_mask_type_pool, tuple->mask_type_index);
+    pmask = (u64 *)&mte->mask;
+
+    kv.key[0] = pmatch[0] & pmask[0];
+    kv.key[1] = pmatch[1] & pmask[1];
+    kv.key[2] = pmatch[2] & pmask[2];
+    kv.key[3] = pmatch[3] & pmask[3];
+    kv.key[4] = pmatch[4] & pmask[4];
+    kv.key[5] = pmatch[5] & pmask[5];
+    kv_key->pkt.mask_type_index_lsb = tuple->mask_type_index;
+
+    if (clib_bihash_search_48_8 (&am->acl_lookup_hash, &kv, &result))
+      continue;
+
+    /* the entries under the key are in the order of the applied index */
+    curr_index = result_val->applied_entry_index;
+    while (curr_index < curr_match_index) {
+      applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), curr_index);
+      if (tm_match_applied_ace(am, match, pae, curr_index)) {
+        DBG("TM: index %d is the new candidate", curr_index);
+        curr_match_index = curr_index;
+        break;
+      }
+      curr_index = pae->next_applied_entry_index;
+    }
+  }
+  DBG("TM MATCH-RESULT: %d", curr_match_index);
+  return curr_match_index;
+}
+
 always_inline int
 hash_multi_acl_match_5tuple (u32 lc_index, fa_5tuple_t * pkt_5tuple,
                        int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
@@ -700,7 +800,12 @@ hash_multi_acl_match_5tuple (u32 lc_index, fa_5tuple_t * pkt_5tuple,
 {
   acl_main_t *am = p_acl_main;
   applied_hash_ace_entry_t **applied_hash_aces = vec_elt_at_index(am->hash_entry_vec_by_lc_index, lc_index);
-  u32 match_index = multi_acl_match_get_applied_ace_index(am, pkt_5tuple);
+  applied_hash_acl_info_t *pal = vec_elt_at_index(am->applied_hash_acl_info_by_lc_index, lc_index);
+  u32 match_index;
+  if (pal->use_tuple_merge)
+    match_index = tm_multi_acl_match_get_applied_ace_index(am, pkt_5tuple);
+  else
+    match_index = multi_acl_match_get_applied_ace_index(am, pkt_5tuple);
   if (match_index < vec_len((*applied_hash_aces))) {
     applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), match_index);
     pae->hitcount++;
@@ -68,6 +68,55 @@ format_session_bihash_5tuple (u8 * s, va_list * args)
 }
 
 
+static vlib_node_registration_t acl_fa_worker_session_timers_node;
+
+/*
+ * Allocate or free the per-worker session timer wheels, and run the
+ * node driving them on every thread while they are in use.
+ */
+static void
+acl_fa_session_timers_enable_disable (acl_main_t * am, int enable)
+{
+  vlib_node_state_t state =
+    enable ? VLIB_NODE_STATE_POLLING : VLIB_NODE_STATE_DISABLED;
+  void *oldheap = clib_mem_set_heap (am->acl_mheap);
+  u16 wk;
+  int i;
+
+  for (wk = 0; wk < vec_len (am->per_worker_data); wk++)
+    {
+      acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
+      if (enable && !pw->session_timers_initialized)
+	{
+	  /* each worker sets the time base on its first run */
+	  tw_timer_wheel_init_1t_3w_1024sl_ov (&pw->session_timers, 0,
+					       ACL_FA_SESSION_TIMER_TICK,
+					       ACL_FA_SESSION_TIMER_EXPIRE_BATCH);
+	  pw->session_timers.last_run_time = 0;
+	  vec_validate (pw->timer_expired,
+			ACL_FA_SESSION_TIMER_EXPIRE_BATCH - 1);
+	  _vec_len (pw->timer_expired) = 0;
+	  pw->timer_clear_next_index = 0;
+	  pw->session_timers_initialized = 1;
+	}
+      else if (!enable && pw->session_timers_initialized)
+	{
+	  tw_timer_wheel_free_1t_3w_1024sl_ov (&pw->session_timers);
+	  vec_free (pw->timer_expired);
+	  pw->session_timers_initialized = 0;
+	}
+    }
+  clib_mem_set_heap (oldheap);
+
+  if (vec_len (vlib_mains) == 0)
+    vlib_node_set_state (am->vlib_main,
+			 acl_fa_worker_session_timers_node.index, state);
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    if (vlib_mains[i])
+      vlib_node_set_state (vlib_mains[i],
+			   acl_fa_worker_session_timers_node.index, state);
+}
+
 static void
 acl_fa_verify_init_sessions (acl_main_t * am)
 {
@@ -96,6 +145,8 @@ acl_fa_verify_init_sessions (acl_main_t * am)
       clib_bihash_set_kvp_format_fn_40_8 (&am->fa_sessions_hash,
 					  format_session_bihash_5tuple);
       am->fa_sessions_hash_is_initialized = 1;
+      if (am->fa_use_timer_wheel)
+	acl_fa_session_timers_enable_disable (am, 1);
     }
 }
 
@@ -479,6 +530,196 @@ acl_fa_worker_conn_cleaner_process (vlib_main_t * vm,
   return 0;
 }
 
+/*
+ * Timer wheel mode: check the sessions whose timers fired, deactivate
+ * the idle ones and restart the timers of the others. The sessions
+ * belong to the calling worker, so this never needs another thread.
+ */
+static int
+acl_fa_expire_session_timers (acl_main_t * am, u16 thread_index,
+			      f64 now_sec, u64 now, u32 max_n)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  tw_timer_wheel_1t_3w_1024sl_ov_t *tw = &pw->session_timers;
+  fa_full_session_id_t fsid;
+  int n_expired = 0;
+
+  fsid.as_u64 = 0;
+  fsid.thread_index = thread_index;
+  if (PREDICT_FALSE (tw->last_run_time == 0))
+    tw->last_run_time = now_sec;
+
+  if (vec_len (pw->timer_expired) < max_n)
+    {
+      void *oldheap = clib_mem_set_heap (am->acl_mheap);
+      pw->timer_expired =
+	tw_timer_expire_timers_vec_1t_3w_1024sl_ov (tw, now_sec,
+						    pw->timer_expired);
+      clib_mem_set_heap (oldheap);
+    }
+
+  for (; max_n && vec_len (pw->timer_expired); max_n--)
+    {
+      fsid.session_index = vec_pop (pw->timer_expired);
+      if (pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
+	{
+	  pw->cnt_already_deleted_sessions++;
+	  continue;
+	}
+      fa_session_t *sess =
+	get_session_ptr (am, thread_index, fsid.session_index);
+      /* deactivated, or given a new timer, since the timer fired */
+      if (sess->deleted
+	  || acl_fa_session_timer_is_running (pw, sess, fsid.session_index))
+	continue;
+      sess->timer_handle = ~0;
+      if (now >= sess->last_active_time + fa_session_get_timeout (am, sess))
+	{
+	  if (am->trace_sessions > 3)
+	    {
+	      elog_acl_maybe_trace_X2 (am,
+				       "acl_fa_expire_session_timers: expire session %d sw_if_index %d",
+				       "i4i4", (u32) fsid.session_index,
+				       (u32) sess->sw_if_index);
+	    }
+	  /* goes to the purgatory */
+	  acl_fa_two_stage_delete_session (am, sess->sw_if_index, fsid, now);
+	  n_expired++;
+	}
+      else
+	{
+	  /* There was activity on the session, wait for the rest of the timeout */
+	  acl_fa_session_timer_start (am, pw, sess, fsid.session_index, now);
+	  pw->cnt_session_timer_restarted++;
+	}
+    }
+  return n_expired;
+}
+
+/*
+ * Timer wheel mode: put the sessions which have spent their time
+ * in the purgatory, so no packet in flight can still refer to them.
+ */
+static int
+acl_fa_reclaim_purgatory (acl_main_t * am, u16 thread_index, u64 now,
+			  u32 max_n)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  fa_full_session_id_t fsid;
+  int n_deleted = 0;
+
+  fsid.as_u64 = 0;
+  fsid.thread_index = thread_index;
+  while (n_deleted < max_n)
+    {
+      fsid.session_index = pw->fa_conn_list_head[ACL_TIMEOUT_PURGATORY];
+      if (FA_SESSION_BOGUS_INDEX == fsid.session_index)
+	break;
+      fa_session_t *sess =
+	get_session_ptr (am, thread_index, fsid.session_index);
+      if (sess->link_enqueue_time + fa_session_get_timeout (am, sess) >= now)
+	break;
+      acl_fa_conn_list_delete_session (am, fsid, now);
+      acl_fa_put_session (am, sess->sw_if_index, fsid);
+      pw->cnt_deleted_sessions++;
+      n_deleted++;
+    }
+  return n_deleted;
+}
+
+/*
+ * Timer wheel mode: deactivate the sessions on the interfaces being
+ * cleared, a batch of the session pool at a time.
+ */
+static void
+acl_fa_clear_sessions_by_timer_walk (acl_main_t * am, u16 thread_index,
+				     u64 now)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  u32 n_slots = pool_len (pw->fa_sessions_pool);
+  u32 end = clib_min (n_slots, pw->timer_clear_next_index +
+		      ACL_FA_SESSION_TIMER_CLEAR_BATCH);
+  fa_full_session_id_t fsid;
+
+  fsid.as_u64 = 0;
+  fsid.thread_index = thread_index;
+  for (fsid.session_index = pw->timer_clear_next_index;
+       fsid.session_index < end; fsid.session_index++)
+    {
+      if (pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
+	continue;
+      fa_session_t *sess =
+	get_session_ptr (am, thread_index, fsid.session_index);
+      if (sess->deleted
+	  || !clib_bitmap_get (pw->pending_clear_sw_if_index_bitmap,
+			       sess->sw_if_index))
+	continue;
+      acl_fa_conn_list_delete_session (am, fsid, now);
+      acl_fa_two_stage_delete_session (am, sess->sw_if_index, fsid, now);
+    }
+  pw->timer_clear_next_index = end;
+  if (end >= n_slots)
+    {
+      elog_acl_maybe_trace_X1 (am,
+			       "acl_fa_clear_sessions_by_timer_walk: now %lu, clearing done",
+			       "i8", now);
+      clib_bitmap_zero (pw->pending_clear_sw_if_index_bitmap);
+      pw->timer_clear_next_index = 0;
+      CLIB_MEMORY_BARRIER ();
+      pw->clear_in_process = 0;
+    }
+}
+
+/*
+ * Per-worker polling node driving the session timers in the timer
+ * wheel mode. Most of the runs only compare the time.
+ */
+static uword
+acl_fa_worker_session_timers_fn (vlib_main_t * vm,
+				 vlib_node_runtime_t * rt, vlib_frame_t * f)
+{
+  acl_main_t *am = &acl_main;
+  u16 thread_index = os_get_thread_index ();
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  f64 now_sec;
+  u64 now, clocks;
+  int n_expired;
+
+  if (PREDICT_FALSE (!pw->session_timers_initialized))
+    return 0;
+  now_sec = vlib_time_now (vm);
+  if (now_sec < pw->session_timers.next_run_time
+      && 0 == vec_len (pw->timer_expired) && !pw->clear_in_process
+      && !purgatory_has_connections (vm, am, thread_index))
+    return 0;
+
+  now = clib_cpu_time_now ();
+  if (pw->clear_in_process)
+    acl_fa_clear_sessions_by_timer_walk (am, thread_index, now);
+  n_expired = acl_fa_expire_session_timers (am, thread_index, now_sec, now,
+					    ACL_FA_SESSION_TIMER_EXPIRE_BATCH);
+  acl_fa_reclaim_purgatory (am, thread_index, now,
+			    ACL_FA_SESSION_TIMER_EXPIRE_BATCH);
+
+  clocks = clib_cpu_time_now () - now;
+  pw->cnt_timer_sweeps++;
+  pw->timer_sweep_total_clocks += clocks;
+  if (clocks > pw->timer_sweep_max_clocks)
+    pw->timer_sweep_max_clocks = clocks;
+
+  pw->cnt_timer_expired_sessions += n_expired;
+  if (now_sec >= pw->timer_rate_interval_start + 1.0)
+    {
+      if (pw->timer_rate_interval_start != 0)
+	pw->timer_expirations_per_second =
+	  (pw->cnt_timer_expired_sessions - pw->timer_rate_interval_base) /
+	  (now_sec - pw->timer_rate_interval_start);
+      pw->timer_rate_interval_start = now_sec;
+      pw->timer_rate_interval_base = pw->cnt_timer_expired_sessions;
+    }
+  return n_expired;
+}
+
 static void
 send_interrupts_to_workers (vlib_main_t * vm, acl_main_t * am)
 {
@@ -552,8 +793,12 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	    }
 	}
 
-      /* If no pending connections and no ACL applied then no point in timing out */
-      if (!has_pending_conns && (0 == am->fa_total_enabled_count))
+      /*
+       * If no pending connections and no ACL applied then no point in timing out.
+       * With the timer wheels the workers age their sessions themselves.
+       */
+      if (am->fa_use_timer_wheel
+	  || (!has_pending_conns && (0 == am->fa_total_enabled_count)))
 	{
 	  am->fa_cleaner_cnt_wait_without_timeout++;
 	  elog_acl_maybe_trace_X1 (am,
@@ -645,6 +890,11 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 		  acl_log_err
 		    ("ERROR-BUG! Could not initiate cleaning on worker because another cleanup in progress");
 		}
+	      else if (am->fa_use_timer_wheel
+		       && !pw0->session_timers_initialized)
+		{
+		  /* no sessions, and nobody to clear them */
+		}
 	      else
 		{
 		  if (clear_all)
@@ -666,7 +916,8 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 		}
 	    }
 	    /* send some interrupts so they can start working */
-	    send_interrupts_to_workers (vm, am);
+	    if (!am->fa_use_timer_wheel)
+	      send_interrupts_to_workers (vm, am);
 
 	    /* now wait till they all complete */
 	    acl_log_err ("CLEANER mains len: %u per-worker len: %d",
@@ -707,11 +958,18 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	  break;
 	}
 
-      send_interrupts_to_workers (vm, am);
-
       if (event_data)
 	_vec_len (event_data) = 0;
 
+      if (am->fa_use_timer_wheel)
+	{
+	  /* no interrupts to send, the workers poll their timers */
+	  am->fa_cleaner_cnt_event_cycles++;
+	  continue;
+	}
+
+      send_interrupts_to_workers (vm, am);
+
       /*
        * If the interrupts were not processed yet, ensure we wait a bit,
        * but up to a point.
@@ -835,6 +1093,34 @@ acl_fa_enable_disable (u32 sw_if_index, int is_input, int enable_disable)
     }
 }
 
+/*
+ * Switch between the conn list and the timer wheel session aging.
+ * Sessions are not moved from one to the other, so only possible
+ * while there are none.
+ */
+int
+acl_fa_set_session_timer_wheel (int enable)
+{
+  acl_main_t *am = &acl_main;
+
+  enable = (enable != 0);
+  if (enable == am->fa_use_timer_wheel)
+    return 0;
+  if (am->fa_session_total_adds != am->fa_session_total_dels)
+    return VNET_API_ERROR_INSTANCE_IN_USE;
+
+  am->fa_use_timer_wheel = enable;
+  if (am->fa_sessions_hash_is_initialized)
+    acl_fa_session_timers_enable_disable (am, enable);
+
+  /* let the cleaner process notice */
+  void *oldheap = clib_mem_set_heap (am->vlib_main->heap_base);
+  vlib_process_signal_event (am->vlib_main, am->fa_cleaner_node_index,
+			     ACL_FA_CLEANER_RESCHEDULE, 0);
+  clib_mem_set_heap (oldheap);
+  return 0;
+}
+
 void
 show_fa_sessions_hash (vlib_main_t * vm, u32 verbose)
 {
@@ -861,6 +1147,13 @@ VLIB_REGISTER_NODE (acl_fa_worker_session_cleaner_process_node, static) = {
   .state = VLIB_NODE_STATE_INTERRUPT,
 };
 
+VLIB_REGISTER_NODE (acl_fa_worker_session_timers_node, static) = {
+  .function = acl_fa_worker_session_timers_fn,
+  .name = "acl-plugin-fa-worker-session-timers",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+};
+
 VLIB_REGISTER_NODE (acl_fa_session_cleaner_process_node, static) = {
   .function = acl_fa_session_cleaner_process,
   .type = VLIB_NODE_TYPE_PROCESS,
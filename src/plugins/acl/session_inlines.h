@@ -140,6 +140,74 @@ is_valid_session_ptr (acl_main_t * am, u16 thread_index, fa_session_t * sess)
 	      pool_len (pw->fa_sessions_pool)));
 }
 
+/*
+ * In the timer wheel mode the conn lists only hold the purgatory, other
+ * sessions have a timer on the wheel of the worker owning them.
+ */
+
+always_inline int
+acl_fa_session_timer_is_running (acl_fa_per_worker_data_t * pw,
+				 fa_session_t * sess, u32 session_index)
+{
+  tw_timer_1t_3w_1024sl_ov_t *t;
+
+  /* handles of the fired timers are reused by the new timers */
+  if (sess->timer_handle == ~0
+      || pool_is_free_index (pw->session_timers.timers, sess->timer_handle))
+    return 0;
+  t = pool_elt_at_index (pw->session_timers.timers, sess->timer_handle);
+  return t->user_handle == session_index;
+}
+
+/*
+ * Ticks until the session may have been idle for its timeout.
+ * Established TCP sessions are looked at every transient timeout at least:
+ * a FIN seen by another worker shortens their timeout, and that worker
+ * can not restart the timer.
+ */
+
+always_inline u32
+acl_fa_session_timer_ticks (acl_main_t * am, fa_session_t * sess, u64 now)
+{
+  f64 cps = am->vlib_main->clib_time.clocks_per_second;
+  u64 expiry_time = sess->last_active_time + fa_session_get_timeout (am,
+								      sess);
+  f64 left = expiry_time > now ? (f64) (expiry_time - now) : 0;
+
+  if (ACL_TIMEOUT_TCP_IDLE == fa_session_get_timeout_type (am, sess))
+    left =
+      clib_min (left,
+		cps * am->session_timeout_sec[ACL_TIMEOUT_TCP_TRANSIENT]);
+  return 1 + (u32) (left / (cps * ACL_FA_SESSION_TIMER_TICK));
+}
+
+always_inline void
+acl_fa_session_timer_start (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			    fa_session_t * sess, u32 session_index, u64 now)
+{
+  void *oldheap = clib_mem_set_heap (am->acl_mheap);
+  if (acl_fa_session_timer_is_running (pw, sess, session_index))
+    tw_timer_stop_1t_3w_1024sl_ov (&pw->session_timers, sess->timer_handle);
+  sess->timer_handle =
+    tw_timer_start_1t_3w_1024sl_ov (&pw->session_timers, session_index, 0,
+				    acl_fa_session_timer_ticks (am, sess,
+								now));
+  clib_mem_set_heap (oldheap);
+}
+
+always_inline void
+acl_fa_session_timer_stop (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			   fa_session_t * sess, u32 session_index)
+{
+  if (acl_fa_session_timer_is_running (pw, sess, session_index))
+    {
+      void *oldheap = clib_mem_set_heap (am->acl_mheap);
+      tw_timer_stop_1t_3w_1024sl_ov (&pw->session_timers, sess->timer_handle);
+      clib_mem_set_heap (oldheap);
+    }
+  sess->timer_handle = ~0;
+}
+
 always_inline void
 acl_fa_conn_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id,
 			      u64 now)
@@ -155,6 +223,18 @@ acl_fa_conn_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id,
   ASSERT (sess->thread_index == sess_id.thread_index);
   /* the retrieved session thread index must be the same as current thread */
   ASSERT (sess->thread_index == thread_index);
+  if (am->fa_use_timer_wheel && !sess->deleted)
+    {
+      sess->link_enqueue_time = now;
+      sess->link_list_id = ACL_TIMEOUT_UNUSED;
+      sess->link_next_idx = FA_SESSION_BOGUS_INDEX;
+      sess->link_prev_idx = FA_SESSION_BOGUS_INDEX;
+      pw->serviced_sw_if_index_bitmap =
+	clib_bitmap_set (pw->serviced_sw_if_index_bitmap, sess->sw_if_index,
+			 1);
+      acl_fa_session_timer_start (am, pw, sess, sess_id.session_index, now);
+      return;
+    }
   sess->link_enqueue_time = now;
   sess->link_list_id = list_id;
   sess->link_next_idx = FA_SESSION_BOGUS_INDEX;
@@ -210,6 +290,8 @@ acl_fa_conn_list_delete_session (acl_main_t * am,
 	("Attempting to delete session belonging to thread %d by thread %d",
 	 sess->thread_index, thread_index);
     }
+  if (am->fa_use_timer_wheel)
+    acl_fa_session_timer_stop (am, pw, sess, sess_id.session_index);
   if (FA_SESSION_BOGUS_INDEX != sess->link_prev_idx)
     {
       fa_session_t *prev_sess =
@@ -513,6 +595,7 @@ acl_fa_add_session (acl_main_t * am, int is_input, int is_ip6,
   sess->link_prev_idx = FA_SESSION_BOGUS_INDEX;
   sess->link_next_idx = FA_SESSION_BOGUS_INDEX;
   sess->deleted = 0;
+  sess->timer_handle = ~0;
 
   acl_fa_conn_list_add_session (am, f_sess_id, now);
 
@@ -303,7 +303,10 @@ recycle_or_free (vlib_main_t * vm, vlib_buffer_main_t * bm, u32 bi,
       ;
     }
   else if (PREDICT_TRUE ((b->flags & VLIB_BUFFER_RECYCLE) == 0))
-    dpdk_rte_pktmbuf_free (vm, thread_index, b, 1);
+    {
+      fl->n_free_ops++;
+      dpdk_rte_pktmbuf_free (vm, thread_index, b, 1);
+    }
 }
 
 static_always_inline void
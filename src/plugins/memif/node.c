@@ -32,6 +32,7 @@
 
 #define foreach_memif_input_error \
   _(BUFFER_ALLOC_FAIL, "buffer allocation failed")		\
+  _(BAD_DESC_LENGTH, "descriptor length exceeds buffer size")	\
   _(NOT_IP, "not ip packet")
 
 typedef enum
@@ -170,6 +171,26 @@ memif_desc_is_invalid (memif_if_t * mif, memif_desc_t * d, u32 buffer_length)
   return 0;
 }
 
+/*
+ * In zero-copy mode descriptors point to our own buffers and the master
+ * only writes length and flags back. Length is read once, so it cannot
+ * change between the check and its use, and clamped to the buffer size.
+ */
+static_always_inline u32
+memif_zc_desc_length (memif_if_t * mif, memif_desc_t * d, u32 buffer_length,
+		      u32 * n_bad_desc)
+{
+  u32 length = d->length;
+
+  if (PREDICT_FALSE (length > buffer_length))
+    {
+      mif->flags |= MEMIF_IF_FLAG_ERROR;
+      *n_bad_desc += 1;
+      length = buffer_length;
+    }
+  return length;
+}
+
 static_always_inline uword
 memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   vlib_frame_t * frame, memif_if_t * mif,
@@ -547,7 +568,7 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 						   thread_index);
   u16 cur_slot, last_slot, ring_size, n_slots, mask, head;
   i16 start_offset;
-  u32 buffer_length;
+  u32 buffer_length, length0, n_bad_desc = 0;
   u16 n_alloc, n_from;
 
   mq = vec_elt_at_index (mif->rx_queues, qid);
@@ -584,17 +605,17 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     CLIB_CACHE_LINE_BYTES, LOAD);
       d0 = &ring->desc[s0];
       hb = b0 = vlib_get_buffer (vm, bi0);
+      length0 = memif_zc_desc_length (mif, d0, buffer_length, &n_bad_desc);
       b0->current_data = start_offset;
-      b0->current_length = start_offset + d0->length;
-      n_rx_bytes += d0->length;
-
-      if (0 && memif_desc_is_invalid (mif, d0, buffer_length))
-	return 0;
+      b0->current_length = length0;
+      n_rx_bytes += length0;
 
       cur_slot++;
       n_slots--;
       if (PREDICT_FALSE ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots))
 	{
+	  /* not part of the free list template, may be stale */
+	  hb->total_length_not_including_first_buffer = 0;
 	  hb->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
 	next_slot:
 	  s0 = cur_slot & mask;
@@ -607,10 +628,12 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  /* current buffer */
 	  b0 = vlib_get_buffer (vm, bi0);
+	  length0 = memif_zc_desc_length (mif, d0, buffer_length,
+					  &n_bad_desc);
 	  b0->current_data = start_offset;
-	  b0->current_length = start_offset + d0->length;
-	  hb->total_length_not_including_first_buffer += d0->length;
-	  n_rx_bytes += d0->length;
+	  b0->current_length = length0;
+	  hb->total_length_not_including_first_buffer += length0;
+	  n_rx_bytes += length0;
 
 	  cur_slot++;
 	  n_slots--;
@@ -622,6 +645,10 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   /* release slots from the ring */
   mq->last_tail = cur_slot;
 
+  if (PREDICT_FALSE (n_bad_desc))
+    vlib_error_count (vm, node->node_index, MEMIF_INPUT_ERROR_BAD_DESC_LENGTH,
+		      n_bad_desc);
+
   n_from = n_rx_packets;
   buffers = ptd->buffers;
 
@@ -23,6 +23,7 @@
 #include <vnet/fib/ip4_fib.h>
 #include <nat/nat.h>
 #include <nat/nat_ipfix_logging.h>
+#include <nat/nat_session_log.h>
 #include <nat/nat_det.h>
 #include <nat/nat_reass.h>
 #include <nat/nat_inlines.h>
@@ -129,7 +130,9 @@ _(MAX_SESSIONS_EXCEEDED, "Maximum sessions exceeded")   \
 _(DROP_FRAGMENT, "Drop fragment")                       \
 _(MAX_REASS, "Maximum reassemblies exceeded")           \
 _(MAX_FRAG, "Maximum fragments per reassembly exceeded")\
-_(FQ_CONGESTED, "Handoff frame queue congested")
+_(FQ_CONGESTED, "Handoff frame queue congested")        \
+_(SAME_WORKER, "Same worker")                           \
+_(DO_HANDOFF, "Do handoff")
 
 typedef enum {
 #define _(sym,str) SNAT_IN2OUT_ERROR_##sym,
@@ -391,6 +394,7 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
       nat_log_notice ("out2in key add failed");
 
   /* log NAT event */
+  nat_session_log_nat44_ses (thread_index, NAT44_SESSION_CREATE, s);
   snat_ipfix_logging_nat44_ses_create(s->in2out.addr.as_u32,
                                       s->out2in.addr.as_u32,
                                       s->in2out.protocol,
@@ -3550,6 +3554,7 @@ snat_in2out_worker_handoff_fn_inline (vlib_main_t * vm,
   u32 next_worker_index = 0;
   u32 current_worker_index = ~0;
   u32 thread_index = vlib_get_thread_index ();
+  u32 n_same_worker = 0, n_do_handoff = 0;
   u32 fq_index;
   u32 to_node_index;
   vlib_frame_t *d = 0;
@@ -3640,6 +3645,7 @@ snat_in2out_worker_handoff_fn_inline (vlib_main_t * vm,
             }
 
           /* enqueue to correct worker thread */
+          n_do_handoff++;
           to_next_worker[0] = bi0;
           to_next_worker++;
           n_left_to_next_worker--;
@@ -3656,6 +3662,7 @@ snat_in2out_worker_handoff_fn_inline (vlib_main_t * vm,
       else
         {
           do_handoff = 0;
+          n_same_worker++;
           /* if this is 1st frame */
           if (!f)
             {
@@ -3711,6 +3718,11 @@ trace0:
     }
   hf = 0;
   current_worker_index = ~0;
+
+  vlib_node_increment_counter (vm, node->node_index,
+                               SNAT_IN2OUT_ERROR_SAME_WORKER, n_same_worker);
+  vlib_node_increment_counter (vm, node->node_index,
+                               SNAT_IN2OUT_ERROR_DO_HANDOFF, n_do_handoff);
   return frame->n_vectors;
 }
 
@@ -3757,6 +3769,9 @@ VLIB_REGISTER_NODE (snat_in2out_output_worker_handoff_node) = {
   .format_trace = format_snat_in2out_worker_handoff_trace,
   .type = VLIB_NODE_TYPE_INTERNAL,
 
+  .n_errors = ARRAY_LEN(snat_in2out_error_strings),
+  .error_strings = snat_in2out_error_strings,
+
   .n_next_nodes = 1,
 
   .next_nodes = {
@@ -22,6 +22,7 @@
 #include <nat/nat.h>
 #include <nat/nat_dpo.h>
 #include <nat/nat_ipfix_logging.h>
+#include <nat/nat_session_log.h>
 #include <nat/nat_det.h>
 #include <nat/nat64.h>
 #include <nat/nat66.h>
@@ -30,6 +31,7 @@
 #include <nat/nat_inlines.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/flow/flow.h>
 
 #include <vpp/app/version.h>
 
@@ -211,6 +213,7 @@ nat_free_session_data (snat_main_t * sm, snat_session_t * s, u32 thread_index)
     return;
 
   /* log NAT event */
+  nat_session_log_nat44_ses (thread_index, NAT44_SESSION_DELETE, s);
   snat_ipfix_logging_nat44_ses_delete(s->in2out.addr.as_u32,
                                       s->out2in.addr.as_u32,
                                       s->in2out.protocol,
@@ -363,11 +366,204 @@ nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u, u32 thread_index)
       clib_dlist_addtail (tsm->list_pool,
                           s->per_user_list_head_index,
                           per_user_translation_list_elt - tsm->list_pool);
+      s->expire_timer_handle = ~0;
     }
 
+  /* Protocol not known yet, timer is restarted with the right timeout
+     when it fires */
+  nat44_session_timer_start (tsm, s,
+                             clib_min (clib_min (sm->udp_timeout,
+                                                 sm->icmp_timeout),
+                                       clib_min (sm->tcp_established_timeout,
+                                                 sm->tcp_transitory_timeout)));
+
   return s;
 }
 
+void
+nat44_session_timers_init (snat_main_per_thread_data_t * tsm)
+{
+  /* Threads have their own time base, set by the first expire walk */
+  tw_timer_wheel_init_1t_3w_1024sl_ov (&tsm->session_timers, 0, 1.0,
+                                       NAT44_SES_EXPIRE_BATCH);
+  tsm->session_timers.last_run_time = 0;
+
+  /* Keep fired timers out of the wheel's own vector */
+  vec_validate (tsm->expired_sessions, NAT44_SES_EXPIRE_BATCH - 1);
+  _vec_len (tsm->expired_sessions) = 0;
+}
+
+void
+nat44_session_timers_free (snat_main_per_thread_data_t * tsm)
+{
+  tw_timer_wheel_free_1t_3w_1024sl_ov (&tsm->session_timers);
+  vec_free (tsm->expired_sessions);
+}
+
+/**
+ * @brief Delete idle NAT44 sessions of a thread.
+ *
+ * Packets only refresh the last heard time of a session, so a session is
+ * checked when its timer fires and gets a new timer for the rest of its
+ * timeout if it was heard from in the meantime. At most max_n fired
+ * sessions are checked per call, the others wait in expired_sessions.
+ *
+ * @param sm NAT main
+ * @param thread_index thread owning the sessions
+ * @param now current time of that thread
+ * @param max_n max number of sessions to check
+ * @return number of deleted sessions
+ */
+u32
+nat44_session_expire (snat_main_t * sm, u32 thread_index, f64 now, u32 max_n)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  tw_timer_wheel_1t_3w_1024sl_ov_t *tw = &tsm->session_timers;
+  u32 session_index, timeout, n_expired = 0;
+  snat_session_t *s;
+  f64 idle;
+
+  if (PREDICT_FALSE (tw->last_run_time == 0))
+    tw->last_run_time = now;
+
+  if (vec_len (tsm->expired_sessions) < max_n)
+    tsm->expired_sessions =
+      tw_timer_expire_timers_vec_1t_3w_1024sl_ov (tw, now,
+                                                  tsm->expired_sessions);
+
+  for (; max_n && vec_len (tsm->expired_sessions); max_n--)
+    {
+      session_index = vec_pop (tsm->expired_sessions);
+
+      /* Deleted, or recycled with a new timer, since the timer fired */
+      if (pool_is_free_index (tsm->sessions, session_index))
+        continue;
+      s = pool_elt_at_index (tsm->sessions, session_index);
+      if (nat44_session_timer_is_running (tsm, s))
+        continue;
+
+      s->expire_timer_handle = ~0;
+      timeout = nat44_session_get_timeout (sm, s);
+      idle = now - s->last_heard;
+      if (idle < timeout)
+        {
+          nat44_session_timer_start (tsm, s, (u32) (timeout - idle) + 1);
+          continue;
+        }
+
+      nat_free_session_data (sm, s, thread_index);
+      nat44_delete_session (sm, s, thread_index);
+      n_expired++;
+    }
+
+  return n_expired;
+}
+
+#define foreach_nat44_ses_expire_error \
+_(EXPIRED, "NAT44 sessions expired")
+
+typedef enum {
+#define _(sym,str) NAT44_SES_EXPIRE_ERROR_##sym,
+  foreach_nat44_ses_expire_error
+#undef _
+  NAT44_SES_EXPIRE_N_ERROR,
+} nat44_ses_expire_error_t;
+
+static char * nat44_ses_expire_error_strings[] = {
+#define _(sym,string) string,
+  foreach_nat44_ses_expire_error
+#undef _
+};
+
+/**
+ * @brief Per worker process deleting idle NAT44 sessions.
+ */
+static uword
+nat44_ses_expire_worker_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                            vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vm->thread_index;
+  u32 n_expired;
+
+  n_expired = nat44_session_expire (sm, thread_index, vlib_time_now (vm),
+                                    NAT44_SES_EXPIRE_BATCH);
+
+  /* Not done yet, continue on the next main loop iteration */
+  if (vec_len (sm->per_thread_data[thread_index].expired_sessions))
+    vlib_node_set_interrupt_pending (vm, rt->node_index);
+
+  vlib_node_increment_counter (vm, rt->node_index,
+                               NAT44_SES_EXPIRE_ERROR_EXPIRED, n_expired);
+  return n_expired;
+}
+
+static vlib_node_registration_t nat44_ses_expire_worker_node;
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (nat44_ses_expire_worker_node, static) = {
+  .function = nat44_ses_expire_worker_fn,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .name = "nat44-ses-expire-worker",
+  .n_errors = ARRAY_LEN (nat44_ses_expire_error_strings),
+  .error_strings = nat44_ses_expire_error_strings,
+};
+/* *INDENT-ON* */
+
+/**
+ * @brief Centralized process to drive per worker NAT44 session expiry.
+ */
+static uword
+nat44_ses_expire_walk_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                          vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  vlib_main_t **worker_vms = 0, *worker_vm;
+  int i;
+
+  /* Only dynamic sessions have idle timers */
+  if (sm->deterministic ||
+      (sm->static_mapping_only && !sm->static_mapping_connection_tracking))
+    return 0;
+
+  if (vec_len (vlib_mains) == 0)
+    vec_add1 (worker_vms, vm);
+  else
+    {
+      for (i = 0; i < vec_len (vlib_mains); i++)
+        {
+          worker_vm = vlib_mains[i];
+          if (worker_vm)
+            vec_add1 (worker_vms, worker_vm);
+        }
+    }
+
+  while (1)
+    {
+      /* Timer wheels tick once a second */
+      vlib_process_suspend (vm, 1.0);
+
+      for (i = 0; i < vec_len (worker_vms); i++)
+        {
+          worker_vm = worker_vms[i];
+          vlib_node_set_interrupt_pending (worker_vm,
+                                           nat44_ses_expire_worker_node.index);
+        }
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (nat44_ses_expire_walk_node, static) = {
+  .function = nat44_ses_expire_walk_fn,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-ses-expire-walk",
+};
+/* *INDENT-ON* */
+
 typedef struct {
   u8 next_in2out;
 } nat44_classify_trace_t;
@@ -1726,6 +1922,9 @@ set_flags:
 
   /* Add/delete external addresses to FIB */
 fib:
+  if (!is_inside && sm->rss_worker_placement && sm->num_workers > 1)
+    nat44_rss_flows_add_del (sw_if_index, !is_del);
+
   vec_foreach (ap, sm->addresses)
     snat_add_del_addr_to_fib(&ap->addr, 32, sw_if_index, !is_del);
 
@@ -1826,6 +2025,9 @@ fib:
   if (is_inside)
     return 0;
 
+  if (sm->rss_worker_placement && sm->num_workers > 1)
+    nat44_rss_flows_add_del (sw_if_index, !is_del);
+
   vec_foreach (ap, sm->addresses)
     snat_add_del_addr_to_fib(&ap->addr, 32, sw_if_index, !is_del);
 
@@ -1852,16 +2054,36 @@ int snat_set_workers (uword * bitmap)
     return VNET_API_ERROR_INVALID_WORKER;
 
   vec_free (sm->workers);
+  clib_bitmap_zero (sm->worker_threads);
   clib_bitmap_foreach (i, bitmap,
     ({
       vec_add1(sm->workers, i);
       sm->per_thread_data[sm->first_worker_index + i].snat_thread_index = j;
+      sm->worker_threads = clib_bitmap_set (sm->worker_threads,
+                                            sm->first_worker_index + i, 1);
       j++;
     }));
 
   sm->port_per_thread = (0xffff - 1024) / _vec_len (sm->workers);
   sm->num_snat_thread = _vec_len (sm->workers);
 
+  /* Port ranges moved, steer them again */
+  if (sm->rss_worker_placement)
+    {
+      snat_interface_t *intf;
+
+      pool_foreach (intf, sm->interfaces,
+      ({
+        if (nat_interface_is_outside (intf))
+          nat44_rss_flows_add_del (intf->sw_if_index, 1);
+      }));
+      pool_foreach (intf, sm->output_feature_interfaces,
+      ({
+        if (nat_interface_is_outside (intf))
+          nat44_rss_flows_add_del (intf->sw_if_index, 1);
+      }));
+    }
+
   return 0;
 }
 
@@ -2403,6 +2625,98 @@ format_ed_session_kvp (u8 * s, va_list * args)
   return s;
 }
 
+/**
+ * @brief Steer outside ports of each NAT worker to a rx queue it polls.
+ *
+ * With RSS worker placement sessions are created on the worker the inside
+ * packets came in on, and the outside port range of that worker decides
+ * where out2in packets go. Flows on the outside interface redirect each
+ * range to a queue of its worker, so that out2in packets rarely need a
+ * handoff. Ranges are split into blocks a port mask can match. Workers
+ * without queue on the interface, or devices without flow support, keep
+ * working through the handoff node.
+ *
+ * @param sw_if_index outside interface
+ * @param is_add 1 to (re)install the flows, 0 to remove them
+ */
+void
+nat44_rss_flows_add_del (u32 sw_if_index, int is_add)
+{
+  snat_main_t *sm = &snat_main;
+  vnet_main_t *vnm = sm->vnet_main;
+  u8 protos[] = { IP_PROTOCOL_TCP, IP_PROTOCOL_UDP };
+  vnet_hw_interface_t *hw;
+  vnet_flow_t flow;
+  u32 *flows, *flow_index, fi, i, j, q, thread_index, lo, hi, size;
+  int rv;
+
+  vec_validate (sm->rss_flows_by_sw_if_index, sw_if_index);
+  flows = sm->rss_flows_by_sw_if_index[sw_if_index];
+  hw = vnet_get_sup_hw_interface (vnm, sw_if_index);
+
+  vec_foreach (flow_index, flows)
+    vnet_flow_del (vnm, flow_index[0]);
+  vec_reset_length (flows);
+
+  if (!is_add)
+    goto done;
+
+  /* MAP-E port sets do not follow worker port ranges */
+  if (sm->alloc_addr_and_port != nat_alloc_addr_and_port_default)
+    goto done;
+
+  for (i = 0; i < vec_len (sm->workers); i++)
+    {
+      thread_index = sm->first_worker_index + sm->workers[i];
+      for (q = 0; q < vec_len (hw->input_node_thread_index_by_queue); q++)
+        if (hw->input_node_thread_index_by_queue[q] == thread_index)
+          break;
+      if (q == vec_len (hw->input_node_thread_index_by_queue))
+        {
+          nat_log_notice ("%U: no rx queue on worker %u",
+                          format_vnet_sw_if_index_name, vnm, sw_if_index,
+                          i);
+          continue;
+        }
+
+      /* see nat_alloc_addr_and_port_default */
+      lo = 1025 + i * sm->port_per_thread;
+      hi = 1024 + (i + 1) * sm->port_per_thread;
+      while (lo <= hi)
+        {
+          size = lo & -lo;
+          while (lo + size - 1 > hi)
+            size >>= 1;
+
+          for (j = 0; j < ARRAY_LEN (protos); j++)
+            {
+              memset (&flow, 0, sizeof (flow));
+              flow.type = VNET_FLOW_TYPE_IP4_N_TUPLE;
+              flow.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+              flow.redirect_queue = q;
+              flow.ip4_n_tuple.dst_port.port = lo;
+              flow.ip4_n_tuple.dst_port.mask = ~(size - 1);
+              flow.ip4_n_tuple.protocol = protos[j];
+              vnet_flow_add (vnm, &flow, &fi);
+              if ((rv = vnet_flow_enable (vnm, fi, hw->hw_if_index)))
+                {
+                  nat_log_warn ("%U: flow enable failed (%d), out2in "
+                                "packets will be handed off",
+                                format_vnet_sw_if_index_name, vnm,
+                                sw_if_index, rv);
+                  vnet_flow_del (vnm, fi);
+                  goto done;
+                }
+              vec_add1 (flows, fi);
+            }
+          lo += size;
+        }
+    }
+
+done:
+  sm->rss_flows_by_sw_if_index[sw_if_index] = flows;
+}
+
 static u32
 snat_get_worker_in2out_cb (ip4_header_t * ip0, u32 rx_fib_index0)
 {
@@ -2422,6 +2736,19 @@ snat_get_worker_in2out_cb (ip4_header_t * ip0, u32 rx_fib_index0)
   return next_worker_index;
 }
 
+static u32
+snat_get_worker_in2out_rss_cb (ip4_header_t * ip0, u32 rx_fib_index0)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vlib_get_thread_index ();
+
+  /* Stay on the worker RSS picked, unless it does no NAT */
+  if (PREDICT_TRUE (clib_bitmap_get (sm->worker_threads, thread_index)))
+    return thread_index;
+
+  return snat_get_worker_in2out_cb (ip0, rx_fib_index0);
+}
+
 static u32
 snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
 {
@@ -2552,10 +2879,13 @@ snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
         }
     }
 
-  /* worker by outside port */
-  next_worker_index = sm->first_worker_index;
-  next_worker_index +=
-    sm->workers[(clib_net_to_host_u16 (port) - 1024) / sm->port_per_thread];
+  /* worker by outside port, see nat_alloc_addr_and_port_default */
+  port = clib_net_to_host_u16 (port);
+  if (PREDICT_FALSE (port <= 1024))
+    return vlib_get_thread_index ();
+  i = clib_min ((port - 1025) / sm->port_per_thread,
+                _vec_len (sm->workers) - 1);
+  next_worker_index = sm->first_worker_index + sm->workers[i];
   return next_worker_index;
 }
 
@@ -2628,6 +2958,8 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "nat64 st hash memory %d",
                          &nat64_st_memory_size))
         ;
+      else if (unformat (input, "rss worker placement"))
+        sm->rss_worker_placement = 1;
       else if (unformat (input, "out2in dpo"))
         sm->out2in_dpo = 1;
       else if (unformat (input, "dslite ce"))
@@ -2673,7 +3005,10 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
     }
   else
     {
-      sm->worker_in2out_cb = snat_get_worker_in2out_cb;
+      if (sm->rss_worker_placement)
+        sm->worker_in2out_cb = snat_get_worker_in2out_rss_cb;
+      else
+        sm->worker_in2out_cb = snat_get_worker_in2out_cb;
       sm->worker_out2in_cb = snat_get_worker_out2in_cb;
       sm->in2out_node_index = snat_in2out_node.index;
       sm->in2out_output_node_index = snat_in2out_output_node.index;
@@ -2700,6 +3035,8 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
                                     user_memory_size);
               clib_bihash_set_kvp_format_fn_8_8 (&tsm->user_hash,
                                                  format_user_kvp);
+
+              nat44_session_timers_init (tsm);
             }
 
           clib_bihash_init_16_8 (&sm->in2out_ed, "in2out-ed",
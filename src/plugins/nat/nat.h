@@ -27,6 +27,7 @@
 #include <vppinfra/bihash_16_8.h>
 #include <vppinfra/dlist.h>
 #include <vppinfra/error.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 #include <vlibapi/api.h>
 #include <vlib/log.h>
 
@@ -38,6 +39,9 @@
 #define SNAT_TCP_INCOMING_SYN 6
 #define SNAT_ICMP_TIMEOUT 60
 
+/* Max number of sessions checked per dispatch of the expire node */
+#define NAT44_SES_EXPIRE_BATCH 256
+
 #define NAT_FQ_NELTS 64
 
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
@@ -180,6 +184,9 @@ typedef CLIB_PACKED(struct {
   u8 state;
   u32 i2o_fin_seq;
   u32 o2i_fin_seq;
+
+  /* Idle timer handle */
+  u32 expire_timer_handle;
 }) snat_session_t;
 
 
@@ -285,6 +292,12 @@ typedef struct {
   /* Pool of doubly-linked list elements */
   dlist_elt_t * list_pool;
 
+  /* Session idle timers, 1 second ticks */
+  tw_timer_wheel_1t_3w_1024sl_ov_t session_timers;
+
+  /* Sessions whose timer fired, yet to be checked */
+  u32 * expired_sessions;
+
   u32 snat_thread_index;
 } snat_main_per_thread_data_t;
 
@@ -323,6 +336,8 @@ typedef struct snat_main_s {
   u32 first_worker_index;
   u32 next_worker;
   u32 * workers;
+  /* Bitmap of worker thread indices */
+  uword * worker_threads;
   snat_get_worker_function_t * worker_in2out_cb;
   snat_get_worker_function_t * worker_out2in_cb;
   u16 port_per_thread;
@@ -342,6 +357,9 @@ typedef struct snat_main_s {
 
   /* Interface pool */
   snat_interface_t * interfaces;
+
+  /* Flows steering outside ports to their workers, by sw_if_index */
+  u32 ** rss_flows_by_sw_if_index;
   snat_interface_t * output_feature_interfaces;
 
   /* Vector of outside addresses */
@@ -386,6 +404,7 @@ typedef struct snat_main_s {
   u8 static_mapping_connection_tracking;
   u8 deterministic;
   u8 out2in_dpo;
+  u8 rss_worker_placement;
   u32 translation_buckets;
   u32 translation_memory_size;
   u32 max_translations;
@@ -576,6 +595,7 @@ int snat_add_static_mapping(ip4_address_t l_addr, ip4_address_t e_addr,
                             u8 *tag);
 clib_error_t * snat_api_init(vlib_main_t * vm, snat_main_t * sm);
 int snat_set_workers (uword * bitmap);
+void nat44_rss_flows_add_del (u32 sw_if_index, int is_add);
 int snat_interface_add_del(u32 sw_if_index, u8 is_inside, int is_del);
 int snat_interface_add_del_output_feature(u32 sw_if_index, u8 is_inside,
                                           int is_del);
@@ -599,6 +619,10 @@ snat_user_t * nat_user_get_or_create (snat_main_t *sm, ip4_address_t *addr,
                                       u32 fib_index, u32 thread_index);
 snat_session_t * nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u,
                                                u32 thread_index);
+void nat44_session_timers_init (snat_main_per_thread_data_t * tsm);
+void nat44_session_timers_free (snat_main_per_thread_data_t * tsm);
+u32 nat44_session_expire (snat_main_t * sm, u32 thread_index, f64 now,
+                          u32 max_n);
 void nat_set_alloc_addr_and_port_mape (u16 psid, u16 psid_offset,
                                        u16 psid_length);
 void nat_set_alloc_addr_and_port_default (void);
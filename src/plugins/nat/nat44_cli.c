@@ -19,6 +19,7 @@
 
 #include <nat/nat.h>
 #include <nat/nat_ipfix_logging.h>
+#include <nat/nat_session_log.h>
 #include <nat/nat_det.h>
 #include <nat/nat_inlines.h>
 #include <vnet/fib/fib_table.h>
@@ -98,13 +99,21 @@ nat_show_workers_commnad_fn (vlib_main_t * vm, unformat_input_t * input,
 
   if (sm->num_workers > 1)
     {
-      vlib_cli_output (vm, "%d workers", vec_len (sm->workers));
+      vlib_cli_output (vm, "%d workers%s", vec_len (sm->workers),
+		       sm->rss_worker_placement ?
+		       ", rss worker placement" : "");
       /* *INDENT-OFF* */
       vec_foreach (worker, sm->workers)
         {
           vlib_worker_thread_t *w =
             vlib_worker_threads + *worker + sm->first_worker_index;
-          vlib_cli_output (vm, "  %s", w->name);
+          u32 i = worker - sm->workers;
+          if (sm->rss_worker_placement)
+            vlib_cli_output (vm, "  %s outside ports %u-%u", w->name,
+                             1025 + i * sm->port_per_thread,
+                             1024 + (i + 1) * sm->port_per_thread);
+          else
+            vlib_cli_output (vm, "  %s", w->name);
         }
       /* *INDENT-ON* */
     }
@@ -158,6 +167,126 @@ done:
   return error;
 }
 
+static clib_error_t *
+nat_session_log_enable_disable_command_fn (vlib_main_t * vm,
+					   unformat_input_t * input,
+					   vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u8 *file_basename = 0;
+  u32 file_size_mb = 0;
+  u8 is_circular = 0;
+  u8 enable = 1;
+  int rv = 0;
+  clib_error_t *error = 0;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (unformat (line_input, "size %u", &file_size_mb))
+	;
+      else if (unformat (line_input, "circular"))
+	is_circular = 1;
+      else if (!file_basename && unformat (line_input, "%s", &file_basename))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (enable && !file_basename)
+    {
+      error = clib_error_return (0, "log file basename required");
+      goto done;
+    }
+  vec_add1 (file_basename, 0);
+
+  rv = nat_session_log_enable_disable (enable, (char *) file_basename,
+				       (u64) file_size_mb << 20, is_circular);
+
+  if (rv)
+    {
+      error = clib_error_return (0, "session log enable failed");
+      goto done;
+    }
+
+done:
+  vec_free (file_basename);
+  unformat_free (line_input);
+
+  return error;
+}
+
+static clib_error_t *
+nat_show_session_log_command_fn (vlib_main_t * vm, unformat_input_t * input,
+				 vlib_cli_command_t * cmd)
+{
+  nat_session_log_main_t *lm = &nat_session_log_main;
+  nat_session_log_per_thread_t *ptd;
+  nat_session_log_record_t *r;
+  clib_maplog_main_t *mm;
+  u32 n_records = 0, i;
+  u64 n_entries, first, entry;
+
+  if (unformat (input, "records %u", &n_records))
+    ;
+
+  if (!lm->enabled)
+    {
+      vlib_cli_output (vm, "session log disabled");
+      return 0;
+    }
+
+  nat_session_log_sync ();
+
+  vlib_cli_output (vm, "session log %s, %s, %llu MB files", lm->file_basename,
+		   lm->is_circular ? "circular" : "linear",
+		   lm->file_size >> 20);
+
+  vec_foreach (ptd, lm->per_thread_data)
+  {
+    mm = &ptd->log;
+    n_entries = mm->next_record_index;
+    vlib_cli_output (vm, "  thread %u: %llu entries, %u files",
+		     ptd - lm->per_thread_data, n_entries,
+		     mm->current_file_index);
+
+    if (!n_records || !n_entries)
+      continue;
+
+    /* last entries still mapped, current file only */
+    first = (n_entries - 1) & ~(mm->file_size_in_records - 1);
+    if (mm->flags & CLIB_MAPLOG_FLAG_CIRCULAR)
+      first = n_entries > mm->file_size_in_records ?
+	n_entries - mm->file_size_in_records : 0;
+    n_entries = clib_min (n_entries - first,
+			  (n_records + NAT_SESSION_LOG_RECORDS_PER_ENTRY - 1)
+			  / NAT_SESSION_LOG_RECORDS_PER_ENTRY);
+
+    for (entry = mm->next_record_index - n_entries;
+	 entry < mm->next_record_index; entry++)
+      {
+	r = (nat_session_log_record_t *)
+	  (mm->file_baseva[(entry >> mm->log2_file_size_in_records) & 1] +
+	   (entry & (mm->file_size_in_records - 1)) *
+	   mm->record_size_in_cachelines * CLIB_CACHE_LINE_BYTES);
+	for (i = 0; i < NAT_SESSION_LOG_RECORDS_PER_ENTRY; i++, r++)
+	  if (r->timestamp)
+	    vlib_cli_output (vm, "    %U", format_nat_session_log_record, r);
+      }
+  }
+
+  return 0;
+}
+
 static clib_error_t *
 nat44_show_hash_commnad_fn (vlib_main_t * vm, unformat_input_t * input,
 			    vlib_cli_command_t * cmd)
@@ -1273,8 +1402,9 @@ set_timeout_command_fn (vlib_main_t * vm,
   snat_main_t *sm = &snat_main;
   unformat_input_t _line_input, *line_input = &_line_input;
   clib_error_t *error = 0;
+  int is_det = cmd->function_arg != 0;
 
-  if (!sm->deterministic)
+  if (is_det && !sm->deterministic)
     return clib_error_return (0, SUPPORTED_ONLY_IN_DET_MODE_STR);
 
   /* Get a line of input. */
@@ -1315,13 +1445,14 @@ done:
 }
 
 static clib_error_t *
-nat44_det_show_timeouts_command_fn (vlib_main_t * vm,
-				    unformat_input_t * input,
-				    vlib_cli_command_t * cmd)
+nat44_show_timeouts_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
 {
   snat_main_t *sm = &snat_main;
+  int is_det = cmd->function_arg != 0;
 
-  if (!sm->deterministic)
+  if (is_det && !sm->deterministic)
     return clib_error_return (0, SUPPORTED_ONLY_IN_DET_MODE_STR);
 
   vlib_cli_output (vm, "udp timeout: %dsec", sm->udp_timeout);
@@ -1478,6 +1609,192 @@ done:
 
   return error;
 }
+
+#define NAT44_SES_EXPIRE_TEST_N_PROTO (SNAT_PROTOCOL_ICMP + 1)
+
+static u32
+nat44_ses_expire_test_n_alive (u32 n_sessions[NAT44_SES_EXPIRE_TEST_N_PROTO][2],
+			       f64 deadline[NAT44_SES_EXPIRE_TEST_N_PROTO][2], f64 now)
+{
+  u32 i, j, n = 0;
+
+  for (i = 0; i < NAT44_SES_EXPIRE_TEST_N_PROTO; i++)
+    for (j = 0; j < 2; j++)
+      if (deadline[i][j] > now)
+	n += n_sessions[i][j];
+  return n;
+}
+
+static clib_error_t *
+test_nat44_ses_expire_command_fn (vlib_main_t * vm,
+				  unformat_input_t * input,
+				  vlib_cli_command_t * cmd)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  snat_user_t *u = 0;
+  snat_session_t *s, tmp = { };
+  clib_bihash_kv_8_8_t kv;
+  ip4_address_t addr;
+  u32 n_sessions = 1 << 20, per_user = 64, batch = NAT44_SES_EXPIRE_BATCH;
+  u32 n_by_type[NAT44_SES_EXPIRE_TEST_N_PROTO][2] = { };
+  f64 deadline[NAT44_SES_EXPIRE_TEST_N_PROTO][2], now, t_touch, t0;
+  u32 thread_index, timeout, i, proto, touched, n_alive, n_expired = 0;
+  u32 n_calls = 0, min_timeout;
+  u64 c0, cycles, max_cycles = 0, total_cycles = 0;
+  uword mem, timer_mem;
+  u8 log_enabled = nat_session_log_main.enabled;
+  clib_error_t *error = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "sessions %u", &n_sessions))
+	;
+      else if (unformat (input, "per-user %u", &per_user))
+	;
+      else if (unformat (input, "batch %u", &batch))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sm->deterministic)
+    return clib_error_return (0, UNSUPPORTED_IN_DET_MODE_STR);
+  if (!n_sessions || !per_user || !batch)
+    return clib_error_return (0, "sessions, per-user and batch must be > 0");
+  per_user = clib_min (per_user, sm->max_translations_per_user);
+
+  /* Test sessions live on a scratch thread, away from real traffic */
+  vec_add2 (sm->per_thread_data, tsm, 1);
+  /* and out of the session log */
+  nat_session_log_main.enabled = 0;
+  thread_index = tsm - sm->per_thread_data;
+  clib_bihash_init_8_8 (&tsm->in2out, "test-in2out",
+			max_pow2 (n_sessions / 4 + 1),
+			((uword) n_sessions << 7) + (1 << 20));
+  clib_bihash_init_8_8 (&tsm->out2in, "test-out2in",
+			max_pow2 (n_sessions / 4 + 1),
+			((uword) n_sessions << 7) + (1 << 20));
+  clib_bihash_init_8_8 (&tsm->user_hash, "test-users",
+			max_pow2 (n_sessions / per_user / 4 + 1),
+			((uword) n_sessions / per_user << 7) + (1 << 20));
+  nat44_session_timers_init (tsm);
+
+  min_timeout = clib_min (clib_min (sm->udp_timeout, sm->icmp_timeout),
+			  clib_min (sm->tcp_established_timeout,
+				    sm->tcp_transitory_timeout));
+  now = 1.0;
+  t_touch = now + min_timeout / 2;
+
+  /* 50% udp, 40% tcp, 10% icmp; every 4th session is heard again later */
+  t0 = vlib_time_now (vm);
+  for (i = 0; i < n_sessions; i++)
+    {
+      if (i % per_user == 0)
+	{
+	  addr.as_u32 = clib_host_to_net_u32 (0x0a000000 + i / per_user);
+	  u = nat_user_get_or_create (sm, &addr, 0, thread_index);
+	}
+      s = nat_session_alloc_or_recycle (sm, u, thread_index);
+      user_session_increment (sm, u, 0 /* is_static */ );
+
+      proto = (i % 10) < 5 ? SNAT_PROTOCOL_UDP :
+	(i % 10) < 9 ? SNAT_PROTOCOL_TCP : SNAT_PROTOCOL_ICMP;
+      s->in2out.addr = addr;
+      s->in2out.port = clib_host_to_net_u16 (1024 + i % per_user);
+      s->in2out.protocol = proto;
+      s->out2in.addr.as_u32 = clib_host_to_net_u32 (0xc6120000 + (i >> 16));
+      s->out2in.port = clib_host_to_net_u16 (i & 0xffff);
+      s->out2in.protocol = proto;
+      s->last_heard = now;
+
+      kv.value = s - tsm->sessions;
+      kv.key = s->in2out.as_u64;
+      clib_bihash_add_del_8_8 (&tsm->in2out, &kv, 1);
+      kv.key = s->out2in.as_u64;
+      clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 1);
+
+      touched = (i % 4) == 0;
+      n_by_type[proto][touched]++;
+    }
+
+  for (proto = 0; proto < NAT44_SES_EXPIRE_TEST_N_PROTO; proto++)
+    {
+      tmp.in2out.protocol = proto;
+      timeout = nat44_session_get_timeout (sm, &tmp);
+      deadline[proto][0] = now + timeout;
+      deadline[proto][1] = t_touch + timeout;
+    }
+
+  vlib_cli_output (vm, "created %u sessions in %.2f sec", n_sessions,
+		   vlib_time_now (vm) - t0);
+
+  mem = vec_len (tsm->sessions) * sizeof (snat_session_t) +
+    vec_len (tsm->list_pool) * sizeof (dlist_elt_t) +
+    vec_len (tsm->users) * sizeof (snat_user_t) +
+    tsm->in2out.alloc_arena_next - tsm->in2out.alloc_arena +
+    tsm->out2in.alloc_arena_next - tsm->out2in.alloc_arena +
+    tsm->user_hash.alloc_arena_next - tsm->user_hash.alloc_arena;
+  timer_mem = vec_len (tsm->session_timers.timers) *
+    sizeof (tw_timer_1t_3w_1024sl_ov_t);
+  vlib_cli_output (vm, "memory: %U, %.1f bytes per session, "
+		   "%.1f of them timers", format_memory_size, mem + timer_mem,
+		   (f64) (mem + timer_mem) / n_sessions,
+		   (f64) timer_mem / n_sessions);
+
+  /* Fake one second clock ticks, up to the last deadline */
+  while (pool_elts (tsm->sessions))
+    {
+      now += 1.0;
+      if (now == t_touch)
+	{
+	  for (i = 0; i < n_sessions; i += 4)
+	    pool_elt_at_index (tsm->sessions, i)->last_heard = now;
+	}
+
+      do
+	{
+	  c0 = clib_cpu_time_now ();
+	  n_expired += nat44_session_expire (sm, thread_index, now, batch);
+	  cycles = clib_cpu_time_now () - c0;
+	  total_cycles += cycles;
+	  max_cycles = clib_max (max_cycles, cycles);
+	  n_calls++;
+	}
+      while (vec_len (tsm->expired_sessions));
+
+      /* Timers may fire up to a tick late */
+      n_alive = pool_elts (tsm->sessions);
+      if (n_alive < nat44_ses_expire_test_n_alive (n_by_type, deadline, now)
+	  || n_alive > nat44_ses_expire_test_n_alive (n_by_type, deadline,
+						      now - 2.0))
+	{
+	  error = clib_error_return (0, "failed, %u sessions alive at "
+				     "%.0f sec", n_alive, now);
+	  goto done;
+	}
+    }
+
+  vlib_cli_output (vm, "expired %u sessions in %u calls, %.2f Mses/sec, "
+		   "max %.1f usec per call", n_expired, n_calls,
+		   n_expired * vm->clib_time.clocks_per_second /
+		   total_cycles / 1e6,
+		   max_cycles * 1e6 / vm->clib_time.clocks_per_second);
+
+done:
+  nat44_session_timers_free (tsm);
+  clib_bihash_free_8_8 (&tsm->in2out);
+  clib_bihash_free_8_8 (&tsm->out2in);
+  clib_bihash_free_8_8 (&tsm->user_hash);
+  pool_free (tsm->sessions);
+  pool_free (tsm->list_pool);
+  pool_free (tsm->users);
+  _vec_len (sm->per_thread_data) -= 1;
+  nat_session_log_main.enabled = log_enabled;
+  return error;
+}
+
 /* *INDENT-OFF* */
 
 /*?
@@ -1524,6 +1841,41 @@ VLIB_CLI_COMMAND (snat_ipfix_logging_enable_disable_command, static) = {
   .short_help = "nat ipfix logging [domain <domain-id>] [src-port <port>] [disable]",
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{nat session log}
+ * To log NAT44 session create and delete events to per thread memory
+ * mapped files /var/log/vpp/nat-<thread>_<n>, 256 MB each, use:
+ *  vpp# nat session log /var/log/vpp/nat size 256
+ * To keep a single file per thread, overwritten when full, use:
+ *  vpp# nat session log /var/log/vpp/nat circular
+ * To disable session log use:
+ *  vpp# nat session log disable
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat_session_log_enable_disable_command, static) = {
+  .path = "nat session log",
+  .function = nat_session_log_enable_disable_command_fn,
+  .short_help = "nat session log <basename> [size <MB>] [circular] | disable",
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{show nat session log}
+ * Show NAT44 session log state, and last records of each thread:
+ *  vpp# show nat session log records 2
+ *  session log /tmp/nat, linear, 64 MB files
+ *    thread 0: 1 entries, 2 files
+ *      1528301216.532186420 create UDP 10.0.0.3:1234 -> 1.2.3.4:1025 vrf 0
+ *      1528301216.532190011 create TCP 10.0.0.3:1235 -> 1.2.3.4:1026 vrf 0
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat_show_session_log_command, static) = {
+  .path = "show nat session log",
+  .function = nat_show_session_log_command_fn,
+  .short_help = "show nat session log [records <n>]",
+};
+
 /*?
  * @cliexpar
  * @cliexstart{nat addr-port-assignment-alg}
@@ -1871,11 +2223,30 @@ VLIB_CLI_COMMAND (snat_det_reverse_command, static) = {
 VLIB_CLI_COMMAND (set_timeout_command, static) = {
   .path = "set nat44 deterministic timeout",
   .function = set_timeout_command_fn,
+  .function_arg = 1,
   .short_help =
     "set nat44 deterministic timeout [udp <sec> | tcp-established <sec> "
     "tcp-transitory <sec> | icmp <sec> | reset]",
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 timeout}
+ * Set idle timeouts of dynamic NAT44 sessions (in seconds), use:
+ *  vpp# set nat44 timeout udp 120 tcp-established 7500
+ *  tcp-transitory 250 icmp 90
+ * To reset default values use:
+ *  vpp# set nat44 timeout reset
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_set_timeout_command, static) = {
+  .path = "set nat44 timeout",
+  .function = set_timeout_command_fn,
+  .short_help =
+    "set nat44 timeout [udp <sec> | tcp-established <sec> "
+    "tcp-transitory <sec> | icmp <sec> | reset]",
+};
+
 /*?
  * @cliexpar
  * @cliexstart{show nat44 deterministic timeouts}
@@ -1890,7 +2261,25 @@ VLIB_CLI_COMMAND (set_timeout_command, static) = {
 VLIB_CLI_COMMAND (nat44_det_show_timeouts_command, static) = {
   .path = "show nat44 deterministic timeouts",
   .short_help = "show nat44 deterministic timeouts",
-  .function = nat44_det_show_timeouts_command_fn,
+  .function = nat44_show_timeouts_command_fn,
+  .function_arg = 1,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{show nat44 timeouts}
+ * Show idle timeouts of dynamic NAT44 sessions.
+ * vpp# show nat44 timeouts
+ * udp timeout: 300sec
+ * tcp-established timeout: 7440sec
+ * tcp-transitory timeout: 240sec
+ * icmp timeout: 60sec
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_show_timeouts_command, static) = {
+  .path = "show nat44 timeouts",
+  .short_help = "show nat44 timeouts",
+  .function = nat44_show_timeouts_command_fn,
 };
 
 /*?
@@ -1940,6 +2329,22 @@ VLIB_CLI_COMMAND (snat_det_close_session_in_command, static) = {
   .function = snat_det_close_session_in_fn,
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{test nat44 session-expire}
+ * Create NAT44 sessions on a scratch thread and let them expire on a fake
+ * clock, checking that each session is deleted at its idle timeout. Shows
+ * memory per session and expire rate. Workers stay blocked meanwhile.
+ *  vpp# test nat44 session-expire sessions 10000000
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (test_nat44_ses_expire_command, static) = {
+  .path = "test nat44 session-expire",
+  .short_help =
+    "test nat44 session-expire [sessions <n>] [per-user <n>] [batch <n>]",
+  .function = test_nat44_ses_expire_command_fn,
+};
+
 /* *INDENT-ON* */
 
 /*
@@ -140,6 +140,62 @@ user_session_increment (snat_main_t * sm, snat_user_t * u, u8 is_static)
     }
 }
 
+/** \brief Get idle timeout of NAT44 session.
+    @return timeout in seconds
+*/
+always_inline u32
+nat44_session_get_timeout (snat_main_t * sm, snat_session_t * s)
+{
+  if (snat_is_unk_proto_session (s))
+    return sm->udp_timeout;
+
+  switch (s->in2out.protocol)
+    {
+    case SNAT_PROTOCOL_ICMP:
+      return sm->icmp_timeout;
+    case SNAT_PROTOCOL_TCP:
+      if (s->state)
+	return sm->tcp_transitory_timeout;
+      return sm->tcp_established_timeout;
+    default:
+      return sm->udp_timeout;
+    }
+}
+
+/** \brief Check if idle timer of NAT44 session is running.
+
+    Handles of fired timers are reused by new timers, so also check that
+    the timer still belongs to the session.
+*/
+always_inline int
+nat44_session_timer_is_running (snat_main_per_thread_data_t * tsm,
+				snat_session_t * s)
+{
+  tw_timer_1t_3w_1024sl_ov_t *t;
+
+  if (s->expire_timer_handle == ~0 ||
+      pool_is_free_index (tsm->session_timers.timers, s->expire_timer_handle))
+    return 0;
+
+  t = pool_elt_at_index (tsm->session_timers.timers, s->expire_timer_handle);
+  return t->user_handle == s - tsm->sessions;
+}
+
+/** \brief (Re)start idle timer of NAT44 session.
+    @param interval seconds until the session is checked
+*/
+always_inline void
+nat44_session_timer_start (snat_main_per_thread_data_t * tsm,
+			   snat_session_t * s, u32 interval)
+{
+  if (nat44_session_timer_is_running (tsm, s))
+    tw_timer_stop_1t_3w_1024sl_ov (&tsm->session_timers,
+				   s->expire_timer_handle);
+  s->expire_timer_handle =
+    tw_timer_start_1t_3w_1024sl_ov (&tsm->session_timers, s - tsm->sessions,
+				    0, clib_max (interval, 1));
+}
+
 always_inline void
 nat44_delete_session (snat_main_t * sm, snat_session_t * ses,
 		      u32 thread_index)
@@ -162,6 +218,9 @@ nat44_delete_session (snat_main_t * sm, snat_session_t * ses,
       else
 	u->nsessions--;
     }
+  if (nat44_session_timer_is_running (tsm, ses))
+    tw_timer_stop_1t_3w_1024sl_ov (&tsm->session_timers,
+				   ses->expire_timer_handle);
   clib_dlist_remove (tsm->list_pool, ses->per_user_index);
   pool_put_index (tsm->list_pool, ses->per_user_index);
   pool_put (tsm->sessions, ses);
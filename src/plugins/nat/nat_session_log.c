@@ -0,0 +1,162 @@
+/*
+ * nat_session_log.c - NAT44 binary session log
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/threads.h>
+#include <nat/nat_session_log.h>
+
+nat_session_log_main_t nat_session_log_main;
+
+static void
+nat_session_log_close (void)
+{
+  nat_session_log_main_t *lm = &nat_session_log_main;
+  nat_session_log_per_thread_t *ptd;
+
+  vec_foreach (ptd, lm->per_thread_data)
+  {
+    clib_maplog_close (&ptd->log);
+    ptd->next = 0;
+    ptd->n_left = 0;
+  }
+}
+
+/**
+ * @brief Enable/disable NAT44 binary session log
+ *
+ * Must be called with worker threads stopped, i.e. from the main thread
+ * holding the barrier.
+ *
+ * @param enable        1 if enable, 0 if disable
+ * @param file_basename log file basename
+ * @param file_size     size of each log file in bytes, 0 for default
+ * @param is_circular   keep a single file per thread, overwritten when full
+ *
+ * @returns 0 if success
+ */
+int
+nat_session_log_enable_disable (int enable, char *file_basename,
+				u64 file_size, u8 is_circular)
+{
+  nat_session_log_main_t *lm = &nat_session_log_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  clib_maplog_init_args_t _a, *a = &_a;
+  nat_session_log_per_thread_t *ptd;
+  u8 *basename = 0;
+  int rv = 0;
+
+  if (lm->enabled)
+    {
+      lm->enabled = 0;
+      nat_session_log_close ();
+      vec_free (lm->file_basename);
+    }
+
+  if (!enable)
+    return 0;
+
+  if (!file_size)
+    file_size = NAT_SESSION_LOG_DEFAULT_FILE_SIZE;
+
+  vec_validate_aligned (lm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  vec_foreach (ptd, lm->per_thread_data)
+  {
+    vec_reset_length (basename);
+    basename = format (basename, "%s-%u%c", file_basename,
+		       ptd - lm->per_thread_data, 0);
+
+    memset (a, 0, sizeof (*a));
+    a->mm = &ptd->log;
+    a->file_basename = (char *) basename;
+    a->file_size_in_bytes = file_size;
+    a->record_size_in_bytes = CLIB_CACHE_LINE_BYTES;
+    a->application_id = NAT_SESSION_LOG_APP_ID;
+    a->application_major_version = NAT_SESSION_LOG_MAJOR_VERSION;
+    a->application_minor_version = NAT_SESSION_LOG_MINOR_VERSION;
+    a->application_patch_version = NAT_SESSION_LOG_PATCH_VERSION;
+    a->maplog_is_circular = is_circular;
+
+    if ((rv = clib_maplog_init (a)))
+      {
+	clib_warning ("%s: clib_maplog_init returned %d", basename, rv);
+	nat_session_log_close ();
+	rv = VNET_API_ERROR_SYSCALL_ERROR_1;
+	goto done;
+      }
+    ptd->next = 0;
+    ptd->n_left = 0;
+  }
+
+  lm->file_basename = format (0, "%s%c", file_basename, 0);
+  lm->file_size = file_size;
+  lm->is_circular = is_circular;
+
+  /* Time reference pair */
+  lm->cpu_time_0 = clib_cpu_time_now ();
+  lm->nanosecond_time_0 = unix_time_now_nsec ();
+  lm->nanoseconds_per_clock =
+    1e9 * vlib_get_main ()->clib_time.seconds_per_clock;
+
+  lm->enabled = 1;
+
+done:
+  vec_free (basename);
+  return rv;
+}
+
+/**
+ * @brief Update log headers with the number of records and files
+ *
+ * Lets readers see the records logged so far, without closing the logs.
+ */
+void
+nat_session_log_sync (void)
+{
+  nat_session_log_main_t *lm = &nat_session_log_main;
+  nat_session_log_per_thread_t *ptd;
+
+  if (!lm->enabled)
+    return;
+
+  vec_foreach (ptd, lm->per_thread_data) clib_maplog_update_header (&ptd->log);
+}
+
+u8 *
+format_nat_session_log_record (u8 * s, va_list * args)
+{
+  nat_session_log_record_t *r = va_arg (*args, nat_session_log_record_t *);
+
+  s = format (s, "%llu.%09llu %s %U %U:%u -> %U:%u vrf %u",
+	      r->timestamp / 1000000000ULL, r->timestamp % 1000000000ULL,
+	      r->event == NAT44_SESSION_CREATE ? "create" : "delete",
+	      format_ip_protocol, r->protocol,
+	      format_ip4_address, &r->src_ip,
+	      clib_net_to_host_u16 (r->src_port),
+	      format_ip4_address, &r->nat_src_ip,
+	      clib_net_to_host_u16 (r->nat_src_port), r->vrf_id);
+  return s;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
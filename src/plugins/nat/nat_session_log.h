@@ -0,0 +1,153 @@
+/*
+ * nat_session_log.h - NAT44 binary session log
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief NAT44 binary session log
+ *
+ * Fixed size session create and delete records, appended by each thread
+ * to its own memory mapped log (vppinfra/maplog.h). Logging a session is
+ * a few stores, without locks, RPCs or buffers, so it keeps up with the
+ * session rate of the workers. The kernel writes the pages back.
+ *
+ * Thread N logs to <basename>-N_0, <basename>-N_1, ... described by
+ * <basename>-N_header. Each cache line sized log entry holds
+ * NAT_SESSION_LOG_RECORDS_PER_ENTRY records, records with zero timestamp
+ * are unused. Logs can be read with clib_maplog_process.
+ */
+#ifndef __included_nat_session_log_h__
+#define __included_nat_session_log_h__
+
+#include <vppinfra/maplog.h>
+#include <vnet/fib/fib_table.h>
+#include <nat/nat.h>
+#include <nat/nat_ipfix_logging.h>
+#include <nat/nat_inlines.h>
+
+/** clib_maplog application id, "NAT4" */
+#define NAT_SESSION_LOG_APP_ID 0x4e415434
+#define NAT_SESSION_LOG_MAJOR_VERSION 1
+#define NAT_SESSION_LOG_MINOR_VERSION 0
+#define NAT_SESSION_LOG_PATCH_VERSION 0
+
+/** Default size of each log file */
+#define NAT_SESSION_LOG_DEFAULT_FILE_SIZE (64 << 20)
+
+/* *INDENT-OFF* */
+typedef CLIB_PACKED (struct
+{
+  u64 timestamp;	/**< unix time in nanoseconds */
+  u32 src_ip;		/**< inside address, network order */
+  u32 nat_src_ip;	/**< outside address, network order */
+  u32 vrf_id;		/**< inside VRF */
+  u16 src_port;		/**< inside port or ICMP id, network order */
+  u16 nat_src_port;	/**< outside port or ICMP id, network order */
+  u8 event;		/**< NAT44_SESSION_CREATE or NAT44_SESSION_DELETE */
+  u8 protocol;		/**< IP protocol */
+  u8 pad[6];
+}) nat_session_log_record_t;
+/* *INDENT-ON* */
+
+#define NAT_SESSION_LOG_RECORDS_PER_ENTRY \
+  (CLIB_CACHE_LINE_BYTES / sizeof (nat_session_log_record_t))
+
+typedef struct
+{
+  clib_maplog_main_t log;
+  /** next record of the current log entry */
+  nat_session_log_record_t *next;
+  /** records left in the current log entry */
+  u32 n_left;
+} nat_session_log_per_thread_t;
+
+typedef struct
+{
+  /** session log enabled */
+  u8 enabled;
+  /** log file basename, c-string */
+  u8 *file_basename;
+  /** log file size in bytes */
+  u64 file_size;
+  /** single file per thread, overwritten when full */
+  u8 is_circular;
+
+  /** time reference pair */
+  u64 nanosecond_time_0;
+  u64 cpu_time_0;
+  f64 nanoseconds_per_clock;
+
+  /** per thread logs */
+  nat_session_log_per_thread_t *per_thread_data;
+} nat_session_log_main_t;
+
+extern nat_session_log_main_t nat_session_log_main;
+
+int nat_session_log_enable_disable (int enable, char *file_basename,
+				    u64 file_size, u8 is_circular);
+void nat_session_log_sync (void);
+format_function_t format_nat_session_log_record;
+
+/**
+ * @brief Log NAT44 session create or delete event
+ *
+ * @param thread_index thread owning the session
+ * @param event        NAT44_SESSION_CREATE or NAT44_SESSION_DELETE
+ * @param s            NAT44 session
+ */
+static_always_inline void
+nat_session_log_nat44_ses (u32 thread_index, u8 event, snat_session_t * s)
+{
+  nat_session_log_main_t *lm = &nat_session_log_main;
+  nat_session_log_per_thread_t *ptd;
+  nat_session_log_record_t *r;
+
+  if (PREDICT_TRUE (!lm->enabled))
+    return;
+
+  ptd = vec_elt_at_index (lm->per_thread_data, thread_index);
+  if (PREDICT_FALSE (ptd->n_left == 0))
+    {
+      ptd->next = clib_maplog_get_entry (&ptd->log);
+      /* circular logs reuse entries */
+      memset (ptd->next, 0, CLIB_CACHE_LINE_BYTES);
+      ptd->n_left = NAT_SESSION_LOG_RECORDS_PER_ENTRY;
+    }
+  r = ptd->next++;
+  ptd->n_left--;
+
+  /* time the node started, saves reading the clock per record */
+  r->timestamp = lm->nanosecond_time_0 +
+    (i64) ((i64) (vlib_get_main ()->cpu_time_last_node_dispatch -
+		  lm->cpu_time_0) * lm->nanoseconds_per_clock);
+  r->src_ip = s->in2out.addr.as_u32;
+  r->nat_src_ip = s->out2in.addr.as_u32;
+  r->vrf_id = fib_table_get_table_id (s->in2out.fib_index,
+				      FIB_PROTOCOL_IP4);
+  r->src_port = s->in2out.port;
+  r->nat_src_port = s->out2in.port;
+  r->event = event;
+  r->protocol = snat_proto_to_ip_proto (s->in2out.protocol);
+}
+
+#endif /* __included_nat_session_log_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -24,6 +24,7 @@
 #include <vnet/fib/ip4_fib.h>
 #include <nat/nat.h>
 #include <nat/nat_ipfix_logging.h>
+#include <nat/nat_session_log.h>
 #include <nat/nat_det.h>
 #include <nat/nat_reass.h>
 #include <nat/nat_inlines.h>
@@ -115,7 +116,9 @@ _(MAX_SESSIONS_EXCEEDED, "Maximum sessions exceeded")   \
 _(DROP_FRAGMENT, "Drop fragment")                       \
 _(MAX_REASS, "Maximum reassemblies exceeded")           \
 _(MAX_FRAG, "Maximum fragments per reassembly exceeded")\
-_(FQ_CONGESTED, "Handoff frame queue congested")
+_(FQ_CONGESTED, "Handoff frame queue congested")        \
+_(SAME_WORKER, "Same worker")                           \
+_(DO_HANDOFF, "Do handoff")
 
 typedef enum {
 #define _(sym,str) SNAT_OUT2IN_ERROR_##sym,
@@ -214,6 +217,7 @@ create_session_for_static_mapping (snat_main_t *sm,
       nat_log_notice ("out2in key add failed");
 
   /* log NAT event */
+  nat_session_log_nat44_ses (thread_index, NAT44_SESSION_CREATE, s);
   snat_ipfix_logging_nat44_ses_create(s->in2out.addr.as_u32,
                                       s->out2in.addr.as_u32,
                                       s->in2out.protocol,
@@ -2701,6 +2705,7 @@ snat_out2in_worker_handoff_fn (vlib_main_t * vm,
   u32 next_worker_index = 0;
   u32 current_worker_index = ~0;
   u32 thread_index = vlib_get_thread_index ();
+  u32 n_same_worker = 0, n_do_handoff = 0;
   vlib_frame_t *d = 0;
 
   ASSERT (vec_len (sm->workers));
@@ -2778,6 +2783,7 @@ snat_out2in_worker_handoff_fn (vlib_main_t * vm,
             }
 
           /* enqueue to correct worker thread */
+          n_do_handoff++;
           to_next_worker[0] = bi0;
           to_next_worker++;
           n_left_to_next_worker--;
@@ -2794,6 +2800,7 @@ snat_out2in_worker_handoff_fn (vlib_main_t * vm,
       else
         {
           do_handoff = 0;
+          n_same_worker++;
           /* if this is 1st frame */
           if (!f)
             {
@@ -2849,6 +2856,11 @@ trace0:
     }
   hf = 0;
   current_worker_index = ~0;
+
+  vlib_node_increment_counter (vm, node->node_index,
+                               SNAT_OUT2IN_ERROR_SAME_WORKER, n_same_worker);
+  vlib_node_increment_counter (vm, node->node_index,
+                               SNAT_OUT2IN_ERROR_DO_HANDOFF, n_do_handoff);
   return frame->n_vectors;
 }
 
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <vppinfra/mem.h>
+#include <vppinfra/hash.h>
+#include <vppinfra/lock.h>
+#include <vppinfra/format.h>
+#include <vppinfra/time.h>
+#include <vppinfra/smp.h>
+#include <svm/ring.h>
+
+/**
+ * Process-local ring state
+ *
+ * Eventfds are only valid in the process that opened or received them,
+ * so they are kept here and never in the ring, which is shared. Rings
+ * are mapped at the same address in all processes and the ring address
+ * is the key.
+ */
+typedef struct svm_ring_main_
+{
+  uword *evtfd_by_ring;		/**< Ring address to local eventfd */
+  clib_spinlock_t lock;		/**< Producer threads look fds up */
+} svm_ring_main_t;
+
+static svm_ring_main_t svm_ring_main;
+
+/**
+ * Allocate ring on the current heap
+ *
+ * As with svm_queue_init, switch to the shared memory heap the ring
+ * should live in before calling this.
+ *
+ * @param n_elts minimum number of elements, rounded up to a power of 2
+ * @param elt_size element size
+ * @param flags svm_ring_flags_t
+ */
+svm_ring_t *
+svm_ring_alloc (u32 n_elts, u32 elt_size, u32 flags)
+{
+  pthread_mutexattr_t attr;
+  pthread_condattr_t cattr;
+  svm_ring_slot_t *slot;
+  svm_ring_t *r;
+  u32 slot_size, i;
+
+  n_elts = max_pow2 (clib_max (n_elts, 2));
+  slot_size = svm_ring_slot_size (elt_size);
+
+  r = clib_mem_alloc_aligned (sizeof (*r) + n_elts * slot_size,
+			      CLIB_CACHE_LINE_BYTES);
+  memset (r, 0, sizeof (*r));
+  r->n_elts = n_elts;
+  r->mask = n_elts - 1;
+  r->elt_size = elt_size;
+  r->slot_size = slot_size;
+  r->flags = flags;
+
+  for (i = 0; i < n_elts; i++)
+    {
+      slot = svm_ring_slot (r, i);
+      slot->seq = i;
+    }
+
+  memset (&attr, 0, sizeof (attr));
+  memset (&cattr, 0, sizeof (cattr));
+
+  if (pthread_mutexattr_init (&attr))
+    clib_unix_warning ("mutexattr_init");
+  if (pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED))
+    clib_unix_warning ("pthread_mutexattr_setpshared");
+  if (pthread_mutex_init (&r->mutex, &attr))
+    clib_unix_warning ("mutex_init");
+  if (pthread_mutexattr_destroy (&attr))
+    clib_unix_warning ("mutexattr_destroy");
+  if (pthread_condattr_init (&cattr))
+    clib_unix_warning ("condattr_init");
+  if (pthread_condattr_setpshared (&cattr, PTHREAD_PROCESS_SHARED))
+    clib_unix_warning ("condattr_setpshared");
+  if (pthread_cond_init (&r->condvar, &cattr))
+    clib_unix_warning ("cond_init1");
+  if (pthread_condattr_destroy (&cattr))
+    clib_unix_warning ("cond_init2");
+
+  return r;
+}
+
+void
+svm_ring_free (svm_ring_t * r)
+{
+  (void) pthread_mutex_destroy (&r->mutex);
+  (void) pthread_cond_destroy (&r->condvar);
+  clib_mem_free (r);
+}
+
+/**
+ * Eventfd this process uses to wake up, or sleep on, the ring's consumer
+ *
+ * @return fd or -1 if none was set
+ */
+int
+svm_ring_eventfd (svm_ring_t * r)
+{
+  svm_ring_main_t *rm = &svm_ring_main;
+  uword *p;
+  int fd;
+
+  clib_spinlock_lock_if_init (&rm->lock);
+  p = hash_get (rm->evtfd_by_ring, pointer_to_uword (r));
+  fd = p ? p[0] : -1;
+  clib_spinlock_unlock_if_init (&rm->lock);
+  return fd;
+}
+
+/**
+ * Set the eventfd this process uses for the ring's consumer
+ *
+ * Producers that receive the fd from the consumer's process, for
+ * instance with SCM_RIGHTS over the api socket, and consumers that
+ * receive it from the process that allocated the ring, call this before
+ * they enqueue or wait. The ring takes ownership of the fd. An fd of -1
+ * closes the one previously set.
+ *
+ * Must be called on the process heap, not on a shared memory heap.
+ */
+void
+svm_ring_set_eventfd (svm_ring_t * r, int fd)
+{
+  svm_ring_main_t *rm = &svm_ring_main;
+  uword *p;
+
+  if (!rm->lock)
+    clib_spinlock_init (&rm->lock);
+
+  clib_spinlock_lock (&rm->lock);
+  p = hash_get (rm->evtfd_by_ring, pointer_to_uword (r));
+  if (p)
+    {
+      close (p[0]);
+      hash_unset (rm->evtfd_by_ring, pointer_to_uword (r));
+    }
+  if (fd >= 0)
+    hash_set (rm->evtfd_by_ring, pointer_to_uword (r), fd);
+  clib_spinlock_unlock (&rm->lock);
+}
+
+/**
+ * Have the ring's consumer sleep on an eventfd
+ *
+ * Meant for the process that allocates the ring, before it hands the
+ * ring out. The fd must then be passed to the consumer's process, and to
+ * any other producer process, which register it with
+ * svm_ring_set_eventfd. The consumer can add it to its own epoll set.
+ *
+ * @return eventfd or -1 on error
+ */
+int
+svm_ring_alloc_consumer_eventfd (svm_ring_t * r)
+{
+  int fd;
+
+  if ((fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+      clib_unix_warning ("eventfd");
+      return -1;
+    }
+  svm_ring_set_eventfd (r, fd);
+  r->flags |= SVM_RING_F_CONSUMER_EVTFD;
+  return fd;
+}
+
+/**
+ * Wake up consumers sleeping in svm_ring_wait
+ *
+ * Called by producers after they publish an element, if they find
+ * waiters. Off the fast path.
+ */
+void
+svm_ring_wake_consumers (svm_ring_t * r)
+{
+  u64 n = 1;
+  int fd;
+
+  if (r->flags & SVM_RING_F_CONSUMER_EVTFD)
+    {
+      if ((fd = svm_ring_eventfd (r)) < 0)
+	{
+	  clib_warning ("ring %p consumer eventfd not set", r);
+	  return;
+	}
+      if (write (fd, &n, sizeof (n)) != sizeof (n) && errno != EAGAIN)
+	clib_unix_warning ("eventfd write");
+      return;
+    }
+
+  pthread_mutex_lock (&r->mutex);
+  (void) pthread_cond_broadcast (&r->condvar);
+  pthread_mutex_unlock (&r->mutex);
+}
+
+static inline u8
+svm_ring_head_is_published (svm_ring_t * r)
+{
+  u32 pos = r->head;
+  return svm_ring_slot (r, pos)->seq == pos + 1;
+}
+
+static int
+svm_ring_wait_evtfd (svm_ring_t * r, int fd, svm_q_conditional_wait_t cond,
+		     u32 time)
+{
+  struct pollfd pfd;
+  int timeout_ms = -1, rv;
+  u64 n;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  if (cond == SVM_Q_TIMEDWAIT)
+    timeout_ms = time * 1000;
+
+  while (!svm_ring_head_is_published (r))
+    {
+      rv = poll (&pfd, 1, timeout_ms);
+      if (rv == 0)
+	return ETIMEDOUT;
+      if (rv < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  clib_unix_warning ("poll");
+	  return -1;
+	}
+      if (read (fd, &n, sizeof (n)) < 0 && errno != EAGAIN)
+	clib_unix_warning ("eventfd read");
+    }
+  return 0;
+}
+
+static int
+svm_ring_wait_condvar (svm_ring_t * r, svm_q_conditional_wait_t cond,
+		       u32 time)
+{
+  struct timespec ts;
+  int rv = 0;
+
+  ts.tv_sec = unix_time_now () + time;
+  ts.tv_nsec = 0;
+
+  pthread_mutex_lock (&r->mutex);
+  while (!svm_ring_head_is_published (r) && rv == 0)
+    {
+      if (cond == SVM_Q_TIMEDWAIT)
+	rv = pthread_cond_timedwait (&r->condvar, &r->mutex, &ts);
+      else
+	(void) pthread_cond_wait (&r->condvar, &r->mutex);
+    }
+  pthread_mutex_unlock (&r->mutex);
+  return rv == ETIMEDOUT ? ETIMEDOUT : 0;
+}
+
+/**
+ * Sleep until the ring is not empty
+ *
+ * The consumer first registers as a waiter and only then checks the ring
+ * again. Producers publish elements before they check for waiters, so
+ * either the consumer sees the element or the producer sees the waiter.
+ *
+ * @param r ring
+ * @param cond SVM_Q_WAIT or SVM_Q_TIMEDWAIT
+ * @param time seconds to wait for, if cond is SVM_Q_TIMEDWAIT
+ * @return 0 if the ring may have elements, ETIMEDOUT on timeout, -1 on
+ *         error
+ */
+int
+svm_ring_wait (svm_ring_t * r, svm_q_conditional_wait_t cond, u32 time)
+{
+  int rv, fd = -1;
+
+  if ((r->flags & SVM_RING_F_CONSUMER_EVTFD)
+      && (fd = svm_ring_eventfd (r)) < 0)
+    {
+      clib_warning ("ring %p consumer eventfd not set", r);
+      return -1;
+    }
+
+  clib_smp_atomic_add (&r->n_waiters, 1);
+  if (fd >= 0)
+    rv = svm_ring_wait_evtfd (r, fd, cond, time);
+  else
+    rv = svm_ring_wait_condvar (r, cond, time);
+  clib_smp_atomic_add (&r->n_waiters, -1);
+  return rv;
+}
+
+/**
+ * Dequeue up to n_max elements
+ *
+ * Single consumer rings release all slots with one barrier and one head
+ * update. Meant for consumers that poll, like vpp's workers.
+ *
+ * @param r ring
+ * @param elts where to copy elements, n_max * r->elt_size bytes
+ * @param n_max max number of elements to dequeue
+ * @return number of elements dequeued
+ */
+u32
+svm_ring_dequeue_batch (svm_ring_t * r, void *elts, u32 n_max)
+{
+  svm_ring_slot_t *slot;
+  u8 *dst = elts;
+  u32 pos, n = 0, i;
+
+  if (!(r->flags & SVM_RING_F_SINGLE_CONSUMER))
+    {
+      while (n < n_max && !svm_ring_try_dequeue (r, dst))
+	{
+	  dst += r->elt_size;
+	  n++;
+	}
+      return n;
+    }
+
+  pos = r->head;
+  while (n < n_max)
+    {
+      slot = svm_ring_slot (r, pos + n);
+      if (slot->seq != pos + n + 1)
+	break;
+      clib_memcpy (dst, slot->data, r->elt_size);
+      dst += r->elt_size;
+      n++;
+    }
+
+  if (!n)
+    return 0;
+
+  CLIB_MEMORY_BARRIER ();
+  for (i = 0; i < n; i++)
+    svm_ring_slot (r, pos + i)->seq = pos + i + r->n_elts;
+  r->head = pos + n;
+  return n;
+}
+
+u8 *
+format_svm_ring (u8 * s, va_list * args)
+{
+  svm_ring_t *r = va_arg (*args, svm_ring_t *);
+
+  s = format (s, "elts %u/%u elt-size %u head %u tail %u waiters %u%s",
+	      svm_ring_n_elts (r), r->n_elts, r->elt_size, r->head, r->tail,
+	      r->n_waiters,
+	      r->flags & SVM_RING_F_CONSUMER_EVTFD ? " eventfd" : "");
+  return s;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
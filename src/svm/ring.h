@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief Lock-free shared-memory message rings.
+ *
+ * Bounded rings of fixed size elements, meant to replace svm_queue_t
+ * where producers and consumers exchange small messages at high rates.
+ * Every slot carries a sequence number that tells whether it is free
+ * for the producer that reserved it or full for the consumer. Producers
+ * reserve slots by moving the tail with a compare-and-swap, unless the
+ * ring is single producer, in which case a plain store is enough. The
+ * same goes for consumers and the head. Producer, consumer and read-only
+ * state live in separate cache lines.
+ *
+ * Nobody takes a lock unless a consumer goes to sleep. Such a consumer
+ * registers as a waiter, and producers that see waiters wake it up,
+ * either through a process-shared condvar or, if the ring was set up for
+ * it, through an eventfd. Fds are process-local, so every process keeps
+ * its own fd for the ring, see svm_ring_set_eventfd.
+ */
+
+#ifndef included_svm_ring_h
+#define included_svm_ring_h
+
+#include <pthread.h>
+#include <sched.h>
+#include <vppinfra/clib.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/lock.h>
+#include <svm/queue.h>
+
+/** Full ring spins before blocking producers yield the cpu */
+#define SVM_RING_SPINS_BEFORE_YIELD 64
+
+typedef enum svm_ring_flags_
+{
+  /** Only one thread ever enqueues */
+  SVM_RING_F_SINGLE_PRODUCER = 1 << 0,
+  /** Only one thread ever dequeues */
+  SVM_RING_F_SINGLE_CONSUMER = 1 << 1,
+  /** Sleeping consumers wait on an eventfd instead of the condvar */
+  SVM_RING_F_CONSUMER_EVTFD = 1 << 2,
+} svm_ring_flags_t;
+
+typedef struct svm_ring_slot_
+{
+  volatile u32 seq;		/**< Position this slot is ready for */
+  u32 pad;
+  u8 data[0];
+} svm_ring_slot_t;
+
+typedef struct svm_ring_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 n_elts;			/**< Number of slots, power of 2 */
+  u32 mask;			/**< n_elts - 1 */
+  u32 elt_size;			/**< Element size */
+  u32 slot_size;		/**< Element size plus slot header */
+  u32 flags;			/**< svm_ring_flags_t */
+
+  /* Producers */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 tail;		/**< Next position to be reserved */
+
+  /* Consumers */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  volatile u32 head;		/**< Next position to be read */
+
+  /* Sleeping consumers, only touched off the fast path */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline3);
+  volatile u32 n_waiters;	/**< Consumers sleeping or about to */
+  pthread_mutex_t mutex;	/**< Guards condvar waits */
+  pthread_cond_t condvar;	/**< Wakes up sleeping consumers */
+
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline4);
+  u8 data[0];
+} svm_ring_t;
+
+svm_ring_t *svm_ring_alloc (u32 n_elts, u32 elt_size, u32 flags);
+void svm_ring_free (svm_ring_t * r);
+int svm_ring_alloc_consumer_eventfd (svm_ring_t * r);
+void svm_ring_set_eventfd (svm_ring_t * r, int fd);
+int svm_ring_eventfd (svm_ring_t * r);
+void svm_ring_wake_consumers (svm_ring_t * r);
+int svm_ring_wait (svm_ring_t * r, svm_q_conditional_wait_t cond, u32 time);
+u32 svm_ring_dequeue_batch (svm_ring_t * r, void *elts, u32 n_max);
+u8 *format_svm_ring (u8 * s, va_list * args);
+
+always_inline u32
+svm_ring_slot_size (u32 elt_size)
+{
+  return round_pow2 (sizeof (svm_ring_slot_t) + elt_size, 8);
+}
+
+/**
+ * Memory needed by a ring, to size the heap it is allocated on
+ */
+always_inline uword
+svm_ring_size (u32 n_elts, u32 elt_size)
+{
+  n_elts = max_pow2 (clib_max (n_elts, 2));
+  return sizeof (svm_ring_t) + (uword) n_elts * svm_ring_slot_size (elt_size);
+}
+
+always_inline svm_ring_slot_t *
+svm_ring_slot (svm_ring_t * r, u32 pos)
+{
+  return (svm_ring_slot_t *) (r->data + (pos & r->mask) * r->slot_size);
+}
+
+/**
+ * Number of elements in the ring
+ *
+ * Only a hint when other threads are enqueueing or dequeueing. Includes
+ * elements producers reserved but have not finished writing.
+ */
+always_inline u32
+svm_ring_n_elts (svm_ring_t * r)
+{
+  return r->tail - r->head;
+}
+
+always_inline u8
+svm_ring_is_empty (svm_ring_t * r)
+{
+  return r->tail == r->head;
+}
+
+always_inline u8
+svm_ring_is_full (svm_ring_t * r)
+{
+  return svm_ring_n_elts (r) >= r->n_elts;
+}
+
+/**
+ * Try to enqueue one element
+ *
+ * @param r ring
+ * @param elt element, r->elt_size bytes
+ * @return 0 on success, -2 if the ring is full, as svm_queue_add
+ */
+always_inline int
+svm_ring_try_enqueue (svm_ring_t * r, void *elt)
+{
+  svm_ring_slot_t *slot;
+  u32 pos;
+  i32 diff;
+
+  pos = r->tail;
+  while (1)
+    {
+      slot = svm_ring_slot (r, pos);
+      diff = (i32) (slot->seq - pos);
+      if (diff == 0)
+	{
+	  if (r->flags & SVM_RING_F_SINGLE_PRODUCER)
+	    {
+	      r->tail = pos + 1;
+	      break;
+	    }
+	  if (__sync_bool_compare_and_swap (&r->tail, pos, pos + 1))
+	    break;
+	}
+      else if (diff < 0)
+	return -2;
+      pos = r->tail;
+    }
+
+  clib_memcpy (slot->data, elt, r->elt_size);
+  CLIB_MEMORY_BARRIER ();
+  slot->seq = pos + 1;
+
+  /* Pairs with the barrier in svm_ring_wait */
+  CLIB_MEMORY_BARRIER ();
+  if (PREDICT_FALSE (r->n_waiters))
+    svm_ring_wake_consumers (r);
+  return 0;
+}
+
+/**
+ * Enqueue one element
+ *
+ * @param r ring
+ * @param elt element, r->elt_size bytes
+ * @param nowait if set, return -2 instead of waiting when the ring is full
+ * @return 0 on success
+ */
+always_inline int
+svm_ring_enqueue (svm_ring_t * r, void *elt, int nowait)
+{
+  u32 n_tries = 0;
+  int rv;
+
+  while ((rv = svm_ring_try_enqueue (r, elt)))
+    {
+      if (nowait)
+	return rv;
+      /* Consumer may need our cpu to make room */
+      if (++n_tries % SVM_RING_SPINS_BEFORE_YIELD)
+	CLIB_PAUSE ();
+      else
+	sched_yield ();
+    }
+  return 0;
+}
+
+/**
+ * Try to dequeue one element
+ *
+ * @param r ring
+ * @param elt where to copy the element, r->elt_size bytes
+ * @return 0 on success, -2 if the ring is empty, as svm_queue_sub
+ */
+always_inline int
+svm_ring_try_dequeue (svm_ring_t * r, void *elt)
+{
+  svm_ring_slot_t *slot;
+  u32 pos;
+  i32 diff;
+
+  pos = r->head;
+  while (1)
+    {
+      slot = svm_ring_slot (r, pos);
+      diff = (i32) (slot->seq - (pos + 1));
+      if (diff == 0)
+	{
+	  if (r->flags & SVM_RING_F_SINGLE_CONSUMER)
+	    {
+	      r->head = pos + 1;
+	      break;
+	    }
+	  if (__sync_bool_compare_and_swap (&r->head, pos, pos + 1))
+	    break;
+	}
+      else if (diff < 0)
+	return -2;
+      pos = r->head;
+    }
+
+  clib_memcpy (elt, slot->data, r->elt_size);
+  CLIB_MEMORY_BARRIER ();
+  slot->seq = pos + r->n_elts;
+  return 0;
+}
+
+/**
+ * Dequeue one element
+ *
+ * @param r ring
+ * @param elt where to copy the element, r->elt_size bytes
+ * @param cond wait mode, as for svm_queue_sub
+ * @param time seconds to wait for, if cond is SVM_Q_TIMEDWAIT
+ * @return 0 on success, -2 if empty and not waiting, ETIMEDOUT on timeout
+ */
+always_inline int
+svm_ring_dequeue (svm_ring_t * r, void *elt, svm_q_conditional_wait_t cond,
+		  u32 time)
+{
+  int rv;
+
+  while (svm_ring_try_dequeue (r, elt))
+    {
+      if (cond == SVM_Q_NOWAIT)
+	return -2;
+      if ((rv = svm_ring_wait (r, cond, time)))
+	return rv;
+    }
+  return 0;
+}
+
+/**
+ * Copy the element at offset from the head, without dequeueing it
+ *
+ * Only safe for the consumer, or when the caller can tolerate reading an
+ * element that is being dequeued concurrently.
+ *
+ * @return 0 on success, -1 if no element was published at that offset
+ */
+always_inline int
+svm_ring_peek (svm_ring_t * r, u32 offset, void *elt)
+{
+  svm_ring_slot_t *slot;
+  u32 pos = r->head + offset;
+
+  slot = svm_ring_slot (r, pos);
+  if (slot->seq != pos + 1)
+    return -1;
+  clib_memcpy (elt, slot->data, r->elt_size);
+  return 0;
+}
+
+#endif /* included_svm_ring_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -828,6 +828,72 @@ svm_fifo_dequeue_drop (svm_fifo_t * f, u32 max_bytes)
   return total_drop_bytes;
 }
 
+/**
+ * Point chunks at the data that can be read, without copying it
+ *
+ * Wrapped data is returned as two chunks, the second one starting at the
+ * beginning of the fifo. Data stays in the fifo, and counts towards its
+ * size, until the consumer releases it with svm_fifo_dequeue_drop.
+ *
+ * @param f fifo
+ * @param chunks array of two chunks, the second is zeroed if not used
+ * @param max_bytes max number of bytes to return
+ * @return number of bytes in the chunks, -2 if the fifo is empty
+ */
+int
+svm_fifo_read_chunks (svm_fifo_t * f, svm_fifo_chunk_t * chunks,
+		      u32 max_bytes)
+{
+  u32 cursize, n_bytes, first;
+
+  /* read cursize, which can only increase while we're working */
+  cursize = svm_fifo_max_dequeue (f);
+  if (PREDICT_FALSE (cursize == 0))
+    return -2;
+
+  n_bytes = clib_min (cursize, max_bytes);
+  first = clib_min (n_bytes, f->nitems - f->head);
+
+  chunks[0].data = f->data + f->head;
+  chunks[0].len = first;
+  chunks[1].data = f->data;
+  chunks[1].len = n_bytes - first;
+  return n_bytes;
+}
+
+/**
+ * Point chunks at the free space after the tail, without copying to it
+ *
+ * The producer fills the chunks and publishes the data with
+ * svm_fifo_enqueue_nocopy. Only for fifos that do not collect
+ * out-of-order segments, i.e., those written by apps.
+ *
+ * @param f fifo
+ * @param chunks array of two chunks, the second is zeroed if not used
+ * @param max_bytes max number of bytes to return
+ * @return number of bytes in the chunks, SVM_FIFO_FULL if no space
+ */
+int
+svm_fifo_write_chunks (svm_fifo_t * f, svm_fifo_chunk_t * chunks,
+		       u32 max_bytes)
+{
+  u32 free_count, n_bytes, first;
+
+  /* free space can only grow while we're working */
+  free_count = svm_fifo_max_enqueue (f);
+  if (PREDICT_FALSE (free_count == 0))
+    return SVM_FIFO_FULL;
+
+  n_bytes = clib_min (free_count, max_bytes);
+  first = clib_min (n_bytes, f->nitems - f->tail);
+
+  chunks[0].data = f->data + f->tail;
+  chunks[0].len = first;
+  chunks[1].data = f->data;
+  chunks[1].len = n_bytes - first;
+  return n_bytes;
+}
+
 u32
 svm_fifo_number_ooo_segments (svm_fifo_t * f)
 {
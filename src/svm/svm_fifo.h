@@ -85,6 +85,13 @@ typedef enum
   SVM_FIFO_FULL = -2,
 } svm_fifo_err_t;
 
+/** Contiguous region of fifo memory, handed out by reference */
+typedef struct
+{
+  u8 *data;
+  u32 len;
+} svm_fifo_chunk_t;
+
 #if SVM_FIFO_TRACE
 #define svm_fifo_trace_add(_f, _s, _l, _t)		\
 {							\
@@ -152,6 +159,10 @@ int svm_fifo_dequeue_nowait (svm_fifo_t * f, u32 max_bytes, u8 * copy_here);
 
 int svm_fifo_peek (svm_fifo_t * f, u32 offset, u32 max_bytes, u8 * copy_here);
 int svm_fifo_dequeue_drop (svm_fifo_t * f, u32 max_bytes);
+int svm_fifo_read_chunks (svm_fifo_t * f, svm_fifo_chunk_t * chunks,
+			  u32 max_bytes);
+int svm_fifo_write_chunks (svm_fifo_t * f, svm_fifo_chunk_t * chunks,
+			   u32 max_bytes);
 u32 svm_fifo_number_ooo_segments (svm_fifo_t * f);
 ooo_segment_t *svm_fifo_first_ooo_segment (svm_fifo_t * f);
 void svm_fifo_init_pointers (svm_fifo_t * f, u32 pointer);
@@ -201,7 +212,8 @@ svm_fifo_enqueue_nocopy (svm_fifo_t * f, u32 bytes)
 {
   ASSERT (bytes <= svm_fifo_max_enqueue (f));
   f->tail = (f->tail + bytes) % f->nitems;
-  f->cursize += bytes;
+  /* consumer may be dropping bytes concurrently */
+  __sync_fetch_and_add (&f->cursize, bytes);
 }
 
 always_inline u8 *
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Event rate and latency of svm_queue_t vs svm_ring_t, with several
+ * producer threads and one consumer. The consumer either polls and
+ * dequeues in batches, as the session queue node does, or sleeps when
+ * the queue is empty, as apps do. Also checks that no event is lost or
+ * reordered per producer.
+ *
+ * test_svm_ring [producers <n>] [events <n>] [size <n>] [wait [eventfd]]
+ *               [queue-only | ring-only]
+ */
+
+#include <sched.h>
+#include <vppinfra/time.h>
+#include <vppinfra/error.h>
+#include <vppinfra/format.h>
+#include <svm/queue.h>
+#include <svm/ring.h>
+
+typedef struct
+{
+  u64 timestamp;
+  u32 producer;
+  u32 seq;
+} test_ring_evt_t;
+
+typedef struct
+{
+  u32 n_producers;
+  u32 n_events;
+  u32 size;
+  u8 consumer_wait;
+  u8 consumer_evtfd;
+  u8 is_ring;
+  svm_queue_t *q;
+  svm_ring_t *r;
+  volatile u32 go;
+  clib_time_t clib_time;
+} test_ring_main_t;
+
+test_ring_main_t test_ring_main;
+
+static void *
+test_ring_producer (void *arg)
+{
+  test_ring_main_t *tm = &test_ring_main;
+  test_ring_evt_t evt;
+  u32 i;
+
+  evt.producer = pointer_to_uword (arg);
+  while (!tm->go)
+    ;
+
+  for (i = 0; i < tm->n_events; i++)
+    {
+      evt.seq = i;
+      evt.timestamp = clib_cpu_time_now ();
+      if (tm->is_ring)
+	svm_ring_enqueue (tm->r, &evt, 0);
+      else
+	svm_queue_add (tm->q, (u8 *) & evt, 0);
+    }
+  return 0;
+}
+
+static u32
+test_ring_consume (test_ring_main_t * tm, test_ring_evt_t * evts, u32 n_max)
+{
+  svm_queue_t *q = tm->q;
+  u32 n, i;
+
+  if (tm->is_ring)
+    {
+      if (tm->consumer_wait)
+	return svm_ring_dequeue (tm->r, evts, SVM_Q_WAIT, 0) ? 0 : 1;
+      return svm_ring_dequeue_batch (tm->r, evts, n_max);
+    }
+
+  if (tm->consumer_wait)
+    return svm_queue_sub (q, (u8 *) evts, SVM_Q_WAIT, 0) ? 0 : 1;
+
+  /* What the session queue node used to do */
+  if (!q->cursize || pthread_mutex_trylock (&q->mutex))
+    return 0;
+  n = clib_min (q->cursize, n_max);
+  for (i = 0; i < n; i++)
+    svm_queue_sub_raw (q, (u8 *) & evts[i]);
+  if (q->cursize < (q->maxsize / 8))
+    (void) pthread_cond_broadcast (&q->condvar);
+  pthread_mutex_unlock (&q->mutex);
+  return n;
+}
+
+static int
+test_ring_latency_cmp (void *a1, void *a2)
+{
+  u64 *l1 = a1, *l2 = a2;
+  return (*l1 > *l2) - (*l1 < *l2);
+}
+
+static clib_error_t *
+test_ring_run (test_ring_main_t * tm)
+{
+  test_ring_evt_t evts[256], *e;
+  u64 *latencies = 0, now, total;
+  u32 *next_seq = 0, n, i;
+  pthread_t *threads = 0;
+  f64 start, elapsed, cps;
+  clib_error_t *error = 0;
+
+  if (tm->is_ring)
+    {
+      tm->r = svm_ring_alloc (tm->size, sizeof (test_ring_evt_t),
+			    SVM_RING_F_SINGLE_CONSUMER);
+      if (tm->consumer_evtfd
+	  && svm_ring_alloc_consumer_eventfd (tm->r) < 0)
+	return clib_error_return (0, "eventfd");
+    }
+  else
+    tm->q = svm_queue_init (tm->size, sizeof (test_ring_evt_t), 0, 0);
+
+  total = (u64) tm->n_producers * tm->n_events;
+  vec_validate (latencies, total - 1);
+  vec_validate (next_seq, tm->n_producers - 1);
+  vec_validate (threads, tm->n_producers - 1);
+  tm->go = 0;
+
+  for (i = 0; i < tm->n_producers; i++)
+    if (pthread_create (&threads[i], 0, test_ring_producer,
+			uword_to_pointer (i, void *)))
+      return clib_error_return_unix (0, "pthread_create");
+
+  start = clib_time_now (&tm->clib_time);
+  tm->go = 1;
+
+  total = 0;
+  while (total < vec_len (latencies))
+    {
+      n = test_ring_consume (tm, evts, ARRAY_LEN (evts));
+      /* Let producers run if they share our cpu */
+      if (!n)
+	{
+	  sched_yield ();
+	  continue;
+	}
+      now = clib_cpu_time_now ();
+      for (i = 0; i < n; i++)
+	{
+	  e = &evts[i];
+	  if (e->producer >= tm->n_producers || e->seq != next_seq[e->producer])
+	    {
+	      error = clib_error_return (0, "producer %u event %u expected %u",
+					 e->producer, e->seq,
+					 next_seq[e->producer]);
+	      goto done;
+	    }
+	  next_seq[e->producer] += 1;
+	  latencies[total++] = now - e->timestamp;
+	}
+    }
+  elapsed = clib_time_now (&tm->clib_time) - start;
+
+  vec_sort_with_function (latencies, test_ring_latency_cmp);
+  cps = tm->clib_time.clocks_per_second;
+  fformat (stdout, "%-6s %u producers %s consumer: %.2f Mevents/s, latency "
+	   "p50 %.2f us p99 %.2f us max %.2f us\n",
+	   tm->is_ring ? "ring" : "queue", tm->n_producers,
+	   !tm->consumer_wait ? "polling" : tm->is_ring && tm->consumer_evtfd ?
+	   "eventfd" : "sleeping",
+	   total / elapsed / 1e6, latencies[total / 2] / cps * 1e6,
+	   latencies[total * 99 / 100] / cps * 1e6,
+	   latencies[total - 1] / cps * 1e6);
+
+done:
+  for (i = 0; i < tm->n_producers; i++)
+    pthread_join (threads[i], 0);
+  if (tm->is_ring)
+    {
+      svm_ring_set_eventfd (tm->r, -1);
+      svm_ring_free (tm->r);
+    }
+  else
+    svm_queue_free (tm->q);
+  vec_free (latencies);
+  vec_free (next_seq);
+  vec_free (threads);
+  return error;
+}
+
+static int
+test_svm_ring (unformat_input_t * input)
+{
+  test_ring_main_t *tm = &test_ring_main;
+  clib_error_t *error = 0;
+  u8 run_queue = 1, run_ring = 1;
+
+  tm->n_producers = 2;
+  tm->n_events = 1 << 20;
+  tm->size = 2048;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "producers %u", &tm->n_producers))
+	;
+      else if (unformat (input, "events %u", &tm->n_events))
+	;
+      else if (unformat (input, "size %u", &tm->size))
+	;
+      else if (unformat (input, "wait"))
+	tm->consumer_wait = 1;
+      else if (unformat (input, "eventfd"))
+	tm->consumer_evtfd = 1;
+      else if (unformat (input, "queue-only"))
+	run_ring = 0;
+      else if (unformat (input, "ring-only"))
+	run_queue = 0;
+      else
+	{
+	  error = clib_error_create ("unknown input `%U'\n",
+				     format_unformat_error, input);
+	  goto out;
+	}
+    }
+
+  if (!tm->n_producers || !tm->n_events)
+    {
+      error = clib_error_return (0, "need at least one producer and event");
+      goto out;
+    }
+
+  clib_time_init (&tm->clib_time);
+
+  if (run_queue)
+    {
+      tm->is_ring = 0;
+      if ((error = test_ring_run (tm)))
+	goto out;
+    }
+  if (run_ring)
+    {
+      tm->is_ring = 1;
+      error = test_ring_run (tm);
+    }
+
+out:
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  int r;
+
+  clib_mem_init (0, 256 << 20);
+  unformat_init_command_line (&i, argv);
+  r = test_svm_ring (&i);
+  unformat_free (&i);
+  return r;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,522 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * vhost_user_bench - minimal vhost-user master measuring the packet rate
+ * of the vpp vhost-user device, without a VM in the way.
+ *
+ * It plays the part of qemu and of the guest virtio-net driver: memory
+ * is shared with vpp through a memfd, one vring pair is set up and
+ * polled from this process. Packets posted on the guest TX ring are
+ * received by vhost-user-input; packets transmitted by vpp are reaped
+ * from the guest RX ring.
+ *
+ * vpp configuration, looping the interface back to itself:
+ *
+ *   create vhost-user socket /tmp/vhost.sock server
+ *   set interface state VirtualEthernet0/0/0 up
+ *   set interface l2 xconnect VirtualEthernet0/0/0 VirtualEthernet0/0/0
+ *
+ * then run:
+ *
+ *   vhost_user_bench socket /tmp/vhost.sock [size <n>] [ring-size <n>]
+ *                    [burst <n>] [time <seconds>]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vppinfra/clib.h>
+#include <vppinfra/format.h>
+#include <vppinfra/error.h>
+#include <vppinfra/time.h>
+#include <vnet/vnet.h>
+#include <vnet/devices/virtio/vhost-user.h>
+
+#define VRING_DESC_F_WRITE 2
+#define BENCH_BUFFER_SIZE 2048
+
+typedef struct
+{
+  u16 size;
+  u16 last_used_idx;
+  u16 avail_idx;
+  vring_desc_t *desc;
+  vring_avail_t *avail;
+  vring_used_t *used;
+} bench_vring_t;
+
+typedef struct
+{
+  int fd;
+  u8 *mem;
+  uword mem_size;
+  int mem_fd;
+
+  /* vring 0 is guest RX (vpp tx), vring 1 guest TX (vpp input) */
+  bench_vring_t vrings[2];
+
+  u32 pkt_size;
+  u32 burst;
+  f64 run_time;
+
+  u64 n_tx, n_rx;
+} bench_main_t;
+
+bench_main_t bench_main;
+
+static int
+bench_send_msg (bench_main_t * bm, vhost_user_msg_t * msg, int *fds,
+		int n_fds)
+{
+  struct msghdr mh = { 0 };
+  struct iovec iov;
+  char control[CMSG_SPACE (VHOST_MEMORY_MAX_NREGIONS * sizeof (int))];
+
+  msg->flags = 1;		/* version 1 */
+  iov.iov_base = msg;
+  iov.iov_len = VHOST_USER_MSG_HDR_SZ + msg->size;
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+
+  if (n_fds)
+    {
+      struct cmsghdr *cmsg;
+      memset (control, 0, sizeof (control));
+      mh.msg_control = control;
+      mh.msg_controllen = CMSG_SPACE (n_fds * sizeof (int));
+      cmsg = CMSG_FIRSTHDR (&mh);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN (n_fds * sizeof (int));
+      clib_memcpy (CMSG_DATA (cmsg), fds, n_fds * sizeof (int));
+    }
+
+  if (sendmsg (bm->fd, &mh, 0) != iov.iov_len)
+    {
+      clib_unix_warning ("sendmsg");
+      return -1;
+    }
+  return 0;
+}
+
+static int
+bench_recv_msg (bench_main_t * bm, vhost_user_msg_t * msg)
+{
+  if (read (bm->fd, msg, VHOST_USER_MSG_HDR_SZ) != VHOST_USER_MSG_HDR_SZ)
+    return -1;
+  if (msg->size > sizeof (*msg) - VHOST_USER_MSG_HDR_SZ)
+    return -1;
+  if (read (bm->fd, (u8 *) msg + VHOST_USER_MSG_HDR_SZ, msg->size) !=
+      msg->size)
+    return -1;
+  if (!(msg->flags & VHOST_USER_REPLY_MASK))
+    return -1;
+  return 0;
+}
+
+static int
+bench_send_u64 (bench_main_t * bm, vhost_user_req_t req, u64 v)
+{
+  vhost_user_msg_t msg = { 0 };
+  msg.request = req;
+  msg.size = sizeof (msg.u64);
+  msg.u64 = v;
+  return bench_send_msg (bm, &msg, 0, 0);
+}
+
+static int
+bench_send_state (bench_main_t * bm, vhost_user_req_t req, u32 index,
+		  u32 num)
+{
+  vhost_user_msg_t msg = { 0 };
+  msg.request = req;
+  msg.size = sizeof (msg.state);
+  msg.state.index = index;
+  msg.state.num = num;
+  return bench_send_msg (bm, &msg, 0, 0);
+}
+
+/* guest physical addresses are offsets in the shared memory */
+always_inline u64
+bench_guest_addr (bench_main_t * bm, void *p)
+{
+  return (u8 *) p - bm->mem;
+}
+
+static u16
+bench_ip4_checksum (u8 * ip)
+{
+  u32 sum = 0;
+  int i;
+
+  for (i = 0; i < 20; i += 2)
+    sum += (ip[i] << 8) | ip[i + 1];
+  while (sum >> 16)
+    sum = (sum & 0xffff) + (sum >> 16);
+  return ~sum;
+}
+
+static void
+bench_build_packet (bench_main_t * bm, u8 * p)
+{
+  static u8 eth[14] = {
+    0x02, 0xfe, 0x00, 0x00, 0x00, 0x02,
+    0x02, 0xfe, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00,
+  };
+  u8 *ip = p + sizeof (eth);
+  u8 *udp = ip + 20;
+  u16 ip_len = bm->pkt_size - sizeof (eth);
+  u16 udp_len = ip_len - 20;
+  u16 csum;
+
+  memset (p, 0, bm->pkt_size);
+  clib_memcpy (p, eth, sizeof (eth));
+  ip[0] = 0x45;
+  ip[2] = ip_len >> 8;
+  ip[3] = ip_len;
+  ip[8] = 64;
+  ip[9] = 17;
+  ip[12] = 10;
+  ip[15] = 1;
+  ip[16] = 10;
+  ip[19] = 2;
+  csum = bench_ip4_checksum (ip);
+  ip[10] = csum >> 8;
+  ip[11] = csum;
+  udp[0] = 0x04;
+  udp[2] = 0x04;
+  udp[4] = udp_len >> 8;
+  udp[5] = udp_len;
+}
+
+/*
+ * Lay out both vrings and their buffers in the shared memory. Each
+ * descriptor owns a fixed buffer, and vpp consumes descriptors in order,
+ * so avail slot n always refers to descriptor n.
+ */
+static clib_error_t *
+bench_alloc_memory (bench_main_t * bm, u16 ring_size)
+{
+  uword ring_bytes, off = 0;
+  int i, q;
+
+  ring_bytes = round_pow2 (ring_size * sizeof (vring_desc_t) +
+			   (3 + ring_size) * sizeof (u16), 4096) +
+    round_pow2 (3 * sizeof (u16) + ring_size * 2 * sizeof (u32), 4096);
+  bm->mem_size = round_pow2 (2 * (ring_bytes + ring_size * BENCH_BUFFER_SIZE),
+			     4096);
+
+  bm->mem_fd = memfd_create ("vhost_user_bench", 0);
+  if (bm->mem_fd < 0)
+    return clib_error_return_unix (0, "memfd_create");
+  if (ftruncate (bm->mem_fd, bm->mem_size) < 0)
+    return clib_error_return_unix (0, "ftruncate");
+  bm->mem = mmap (0, bm->mem_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		  bm->mem_fd, 0);
+  if (bm->mem == MAP_FAILED)
+    return clib_error_return_unix (0, "mmap");
+  memset (bm->mem, 0, bm->mem_size);
+
+  for (q = 0; q < 2; q++)
+    {
+      bench_vring_t *vr = &bm->vrings[q];
+      vr->size = ring_size;
+      vr->desc = (vring_desc_t *) (bm->mem + off);
+      vr->avail = (vring_avail_t *) (vr->desc + ring_size);
+      off += round_pow2 (ring_size * sizeof (vring_desc_t) +
+			 (3 + ring_size) * sizeof (u16), 4096);
+      vr->used = (vring_used_t *) (bm->mem + off);
+      off += round_pow2 (3 * sizeof (u16) + ring_size * 2 * sizeof (u32),
+			 4096);
+
+      /* we poll, vpp must not signal */
+      vr->avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+
+      for (i = 0; i < ring_size; i++)
+	{
+	  u8 *buf = bm->mem + off + i * BENCH_BUFFER_SIZE;
+	  vr->desc[i].addr = bench_guest_addr (bm, buf);
+	  if (q == 0)
+	    {
+	      vr->desc[i].len = BENCH_BUFFER_SIZE;
+	      vr->desc[i].flags = VRING_DESC_F_WRITE;
+	    }
+	  else
+	    {
+	      /* zero virtio-net header followed by the packet */
+	      vr->desc[i].len = sizeof (virtio_net_hdr_mrg_rxbuf_t) +
+		bm->pkt_size;
+	      bench_build_packet (bm, buf + sizeof (virtio_net_hdr_mrg_rxbuf_t));
+	    }
+	}
+      off += ring_size * BENCH_BUFFER_SIZE;
+    }
+
+  return 0;
+}
+
+static clib_error_t *
+bench_connect (bench_main_t * bm, u8 * socket_name)
+{
+  struct sockaddr_un sun = { 0 };
+  vhost_user_msg_t msg;
+  u64 features;
+  int q;
+
+  bm->fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (bm->fd < 0)
+    return clib_error_return_unix (0, "socket");
+  sun.sun_family = AF_UNIX;
+  strncpy (sun.sun_path, (char *) socket_name, sizeof (sun.sun_path) - 1);
+  if (connect (bm->fd, (struct sockaddr *) &sun, sizeof (sun)) < 0)
+    return clib_error_return_unix (0, "connect '%s'", socket_name);
+
+  if (bench_send_u64 (bm, VHOST_USER_SET_OWNER, 0))
+    return clib_error_return (0, "SET_OWNER failed");
+
+  memset (&msg, 0, sizeof (msg));
+  msg.request = VHOST_USER_GET_FEATURES;
+  if (bench_send_msg (bm, &msg, 0, 0) || bench_recv_msg (bm, &msg))
+    return clib_error_return (0, "GET_FEATURES failed");
+
+  /*
+   * Mergeable buffers only: without protocol features, vrings are
+   * enabled as soon as their addresses are set.
+   */
+  features = msg.u64 & (1ULL << FEAT_VIRTIO_NET_F_MRG_RXBUF);
+  if (bench_send_u64 (bm, VHOST_USER_SET_FEATURES, features))
+    return clib_error_return (0, "SET_FEATURES failed");
+
+  memset (&msg, 0, sizeof (msg));
+  msg.request = VHOST_USER_SET_MEM_TABLE;
+  msg.size = sizeof (msg.memory);
+  msg.memory.nregions = 1;
+  msg.memory.regions[0].guest_phys_addr = 0;
+  msg.memory.regions[0].memory_size = bm->mem_size;
+  msg.memory.regions[0].userspace_addr = pointer_to_uword (bm->mem);
+  msg.memory.regions[0].mmap_offset = 0;
+  if (bench_send_msg (bm, &msg, &bm->mem_fd, 1))
+    return clib_error_return (0, "SET_MEM_TABLE failed");
+
+  for (q = 0; q < 2; q++)
+    {
+      bench_vring_t *vr = &bm->vrings[q];
+
+      if (bench_send_state (bm, VHOST_USER_SET_VRING_NUM, q, vr->size) ||
+	  bench_send_state (bm, VHOST_USER_SET_VRING_BASE, q, 0))
+	return clib_error_return (0, "vring %d setup failed", q);
+
+      memset (&msg, 0, sizeof (msg));
+      msg.request = VHOST_USER_SET_VRING_ADDR;
+      msg.size = sizeof (msg.addr);
+      msg.addr.index = q;
+      msg.addr.desc_user_addr = pointer_to_uword (vr->desc);
+      msg.addr.avail_user_addr = pointer_to_uword (vr->avail);
+      msg.addr.used_user_addr = pointer_to_uword (vr->used);
+      if (bench_send_msg (bm, &msg, 0, 0))
+	return clib_error_return (0, "vring %d address failed", q);
+
+      /* no eventfds, both sides poll */
+      if (bench_send_u64 (bm, VHOST_USER_SET_VRING_CALL,
+			  q | VHOST_USER_VRING_NOFD_MASK) ||
+	  bench_send_u64 (bm, VHOST_USER_SET_VRING_KICK,
+			  q | VHOST_USER_VRING_NOFD_MASK))
+	return clib_error_return (0, "vring %d start failed", q);
+    }
+
+  return 0;
+}
+
+/* Post up to a burst of packets on the guest TX vring, reap completions */
+static_always_inline void
+bench_guest_tx (bench_main_t * bm)
+{
+  bench_vring_t *vr = &bm->vrings[1];
+  u16 used_idx = vr->used->idx;
+  u16 n_free, n;
+
+  bm->n_tx += (u16) (used_idx - vr->last_used_idx);
+  vr->last_used_idx = used_idx;
+
+  n_free = vr->size - (u16) (vr->avail_idx - vr->last_used_idx);
+  n = clib_min (n_free, bm->burst);
+  if (!n)
+    return;
+
+  while (n--)
+    {
+      u16 slot = vr->avail_idx & (vr->size - 1);
+      vr->avail->ring[slot] = slot;
+      vr->avail_idx++;
+    }
+  CLIB_MEMORY_BARRIER ();
+  vr->avail->idx = vr->avail_idx;
+}
+
+/* Count packets vpp wrote to the guest RX vring, give buffers back */
+static_always_inline void
+bench_guest_rx (bench_main_t * bm)
+{
+  bench_vring_t *vr = &bm->vrings[0];
+  u16 used_idx = vr->used->idx;
+  u16 n = used_idx - vr->last_used_idx;
+
+  if (!n)
+    return;
+
+  bm->n_rx += n;
+  vr->last_used_idx = used_idx;
+  while (n--)
+    {
+      u16 slot = vr->avail_idx & (vr->size - 1);
+      vr->avail->ring[slot] = slot;
+      vr->avail_idx++;
+    }
+  CLIB_MEMORY_BARRIER ();
+  vr->avail->idx = vr->avail_idx;
+}
+
+static void
+bench_run (bench_main_t * bm)
+{
+  bench_vring_t *rx = &bm->vrings[0];
+  clib_time_t ct;
+  f64 start, now, last;
+  u64 last_tx = 0, last_rx = 0;
+  int i;
+
+  /* all guest RX buffers are available to vpp from the start */
+  for (i = 0; i < rx->size; i++)
+    rx->avail->ring[i] = i;
+  rx->avail_idx = rx->size;
+  CLIB_MEMORY_BARRIER ();
+  rx->avail->idx = rx->avail_idx;
+
+  clib_time_init (&ct);
+  start = last = clib_time_now (&ct);
+
+  do
+    {
+      bench_guest_tx (bm);
+      bench_guest_rx (bm);
+
+      now = clib_time_now (&ct);
+      if (now - last >= 1.0)
+	{
+	  fformat (stdout, "%8.2f s: tx %8.3f Mpps rx %8.3f Mpps\n",
+		   now - start, (bm->n_tx - last_tx) / (now - last) / 1e6,
+		   (bm->n_rx - last_rx) / (now - last) / 1e6);
+	  last_tx = bm->n_tx;
+	  last_rx = bm->n_rx;
+	  last = now;
+	}
+    }
+  while (now - start < bm->run_time);
+
+  fformat (stdout, "%u byte packets, %.2f s: tx %llu (%.3f Mpps) "
+	   "rx %llu (%.3f Mpps)\n", bm->pkt_size, now - start,
+	   bm->n_tx, bm->n_tx / (now - start) / 1e6,
+	   bm->n_rx, bm->n_rx / (now - start) / 1e6);
+}
+
+int
+main (int argc, char **argv)
+{
+  bench_main_t *bm = &bench_main;
+  unformat_input_t _argv, *a = &_argv;
+  clib_error_t *error = 0;
+  u8 *socket_name = 0;
+  u32 ring_size = 256;
+
+  clib_mem_init (0, 64 << 20);
+
+  bm->pkt_size = 64;
+  bm->burst = 32;
+  bm->run_time = 10;
+
+  unformat_init_command_line (a, argv);
+  while (unformat_check_input (a) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (a, "socket %s", &socket_name))
+	;
+      else if (unformat (a, "size %u", &bm->pkt_size))
+	;
+      else if (unformat (a, "ring-size %u", &ring_size))
+	;
+      else if (unformat (a, "burst %u", &bm->burst))
+	;
+      else if (unformat (a, "time %f", &bm->run_time))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, a);
+	  goto done;
+	}
+    }
+
+  if (!socket_name)
+    {
+      error = clib_error_return (0, "socket <path> required");
+      goto done;
+    }
+  vec_add1 (socket_name, 0);
+  if (bm->pkt_size < 42 || bm->pkt_size > BENCH_BUFFER_SIZE -
+      sizeof (virtio_net_hdr_mrg_rxbuf_t))
+    {
+      error = clib_error_return (0, "size must be between 42 and %u",
+				 BENCH_BUFFER_SIZE -
+				 sizeof (virtio_net_hdr_mrg_rxbuf_t));
+      goto done;
+    }
+  if (ring_size == 0 || ring_size > VHOST_VRING_MAX_SIZE ||
+      !is_pow2 (ring_size))
+    {
+      error = clib_error_return (0, "ring-size must be a power of 2");
+      goto done;
+    }
+  if (bm->burst == 0)
+    bm->burst = 1;
+
+  if ((error = bench_alloc_memory (bm, ring_size)))
+    goto done;
+  if ((error = bench_connect (bm, socket_name)))
+    goto done;
+
+  bench_run (bm);
+
+done:
+  unformat_free (a);
+  vec_free (socket_name);
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -48,7 +48,7 @@ typedef struct
   svm_fifo_t *server_rx_fifo;
   svm_fifo_t *server_tx_fifo;
 
-  svm_queue_t *vpp_evt_q;
+  svm_ring_t *vpp_evt_q;
 
   u64 vpp_session_handle;
   u64 bytes_sent;
@@ -99,10 +99,10 @@ typedef struct
   int no_return;
 
   /* Our event queue */
-  svm_queue_t *our_event_queue;
+  svm_ring_t *our_event_queue;
 
   /* $$$ single thread only for the moment */
-  svm_queue_t *vpp_event_queue;
+  svm_ring_t *vpp_event_queue;
 
   u8 *socket_name;
 
@@ -284,6 +284,9 @@ application_send_attach (echo_main_t * em)
   bmp->options[APP_OPTIONS_TX_FIFO_SIZE] = em->fifo_size;
   bmp->options[APP_OPTIONS_ADD_SEGMENT_SIZE] = 128 << 20;
   bmp->options[APP_OPTIONS_SEGMENT_SIZE] = 256 << 20;
+  /* Sleep on an eventfd, it comes over the api socket */
+  if (em->use_sock_api)
+    bmp->options[APP_OPTIONS_FLAGS] |= APP_OPTIONS_FLAGS_EVT_Q_USE_EVENTFD;
   bmp->options[APP_OPTIONS_EVT_QUEUE_SIZE] = 256;
   vl_msg_api_send_shmem (em->vl_input_queue, (u8 *) & bmp);
 
@@ -388,6 +391,8 @@ vl_api_application_attach_reply_t_handler (vl_api_application_attach_reply_t *
 {
   echo_main_t *em = &echo_main;
   ssvm_segment_type_t seg_type;
+  clib_error_t *error;
+  int evt_q_fd;
 
   if (mp->retval)
     {
@@ -426,7 +431,19 @@ vl_api_application_attach_reply_t_handler (vl_api_application_attach_reply_t *
 
   ASSERT (mp->app_event_queue_address);
   em->our_event_queue = uword_to_pointer (mp->app_event_queue_address,
-					  svm_queue_t *);
+					  svm_ring_t *);
+
+  /* Read the eventfd vpp wakes us up through */
+  if (em->our_event_queue->flags & SVM_RING_F_CONSUMER_EVTFD)
+    {
+      if ((error = vl_socket_client_recv_fd_msg (&evt_q_fd, 5)))
+	{
+	  clib_error_report (error);
+	  em->state = STATE_FAILED;
+	  return;
+	}
+      svm_ring_set_eventfd (em->our_event_queue, evt_q_fd);
+    }
   em->state = STATE_ATTACHED;
 }
 
@@ -702,7 +719,7 @@ send_test_chunk (echo_main_t * em, session_t * s)
 	  /* Fabricate TX event, send to vpp */
 	  evt.fifo = tx_fifo;
 	  evt.event_type = FIFO_EVENT_APP_TX;
-	  svm_queue_add (s->vpp_evt_q, (u8 *) & evt, 0 /* wait for mutex */ );
+	  svm_ring_enqueue (s->vpp_evt_q, &evt, 0 /* wait for space */ );
 	}
     }
 }
@@ -759,7 +776,7 @@ client_rx_thread_fn (void *arg)
 
   while (!em->time_to_stop)
     {
-      svm_queue_sub (em->our_event_queue, (u8 *) e, SVM_Q_WAIT, 0);
+      svm_ring_dequeue (em->our_event_queue, e, SVM_Q_WAIT, 0);
       switch (e->event_type)
 	{
 	case FIFO_EVENT_APP_RX:
@@ -808,7 +825,7 @@ vl_api_connect_session_reply_t_handler (vl_api_connect_session_reply_t * mp)
   session->vpp_session_handle = mp->handle;
   session->start = clib_time_now (&em->clib_time);
   session->vpp_evt_q = uword_to_pointer (mp->vpp_event_queue_address,
-					 svm_queue_t *);
+					 svm_ring_t *);
 
   hash_set (em->session_index_by_vpp_handles, mp->handle, session_index);
 
@@ -918,7 +935,7 @@ clients_run (echo_main_t * em)
   start_time = clib_time_now (&em->clib_time);
   em->state = STATE_READY;
   while (em->n_active_clients)
-    svm_queue_sub (em->our_event_queue, (u8 *) e, SVM_Q_NOWAIT, 0);
+    svm_ring_dequeue (em->our_event_queue, e, SVM_Q_NOWAIT, 0);
 
 
   for (i = 0; i < em->n_clients; i++)
@@ -1067,7 +1084,7 @@ vl_api_accept_session_t_handler (vl_api_accept_session_t * mp)
   clib_warning ("Accepted session from: %s:%d", ip_str,
 		clib_net_to_host_u16 (mp->port));
   em->vpp_event_queue =
-    uword_to_pointer (mp->vpp_event_queue_address, svm_queue_t *);
+    uword_to_pointer (mp->vpp_event_queue_address, svm_ring_t *);
 
   /* Allocate local session and set it up */
   pool_get (em->sessions, session);
@@ -1115,7 +1132,7 @@ server_handle_fifo_event_rx (echo_main_t * em, session_fifo_event_t * e)
   svm_fifo_t *rx_fifo, *tx_fifo;
   int n_read;
   session_fifo_event_t evt;
-  svm_queue_t *q;
+  svm_ring_t *q;
   session_t *session;
   int rv;
   u32 max_dequeue, offset, max_transfer, rx_buf_len;
@@ -1168,7 +1185,7 @@ server_handle_fifo_event_rx (echo_main_t * em, session_fifo_event_t * e)
 	      evt.event_type = FIFO_EVENT_APP_TX;
 
 	      q = em->vpp_event_queue;
-	      svm_queue_add (q, (u8 *) & evt, 1 /* do wait for mutex */ );
+	      svm_ring_enqueue (q, &evt, 1 /* don't wait for space */ );
 	    }
 	}
     }
@@ -1182,7 +1199,7 @@ server_handle_event_queue (echo_main_t * em)
 
   while (1)
     {
-      svm_queue_sub (em->our_event_queue, (u8 *) e, SVM_Q_WAIT, 0);
+      svm_ring_dequeue (em->our_event_queue, e, SVM_Q_WAIT, 0);
       switch (e->event_type)
 	{
 	case FIFO_EVENT_APP_RX:
@@ -31,6 +31,7 @@
 #define SOCK_TEST_TOKEN_SHOW_CFG       "#C"
 #define SOCK_TEST_TOKEN_RUN_UNI        "#U"
 #define SOCK_TEST_TOKEN_RUN_BI         "#B"
+#define SOCK_TEST_TOKEN_ZERO_COPY      "#Z"
 
 #define SOCK_TEST_BANNER_STRING \
   "============================================\n"
@@ -72,6 +73,7 @@ typedef struct  __attribute__ ((packed))
   uint32_t verbose;
   uint32_t address_ip6;
   uint32_t transport_udp;
+  uint32_t zero_copy;
   uint64_t rxbuf_size;
   uint64_t txbuf_size;
   uint64_t num_writes;
@@ -88,6 +90,8 @@ typedef struct
   uint64_t tx_bytes;
   uint32_t tx_eagain;
   uint32_t tx_incomp;
+  uint64_t rx_zc_bytes;
+  uint64_t tx_zc_bytes;
   struct timespec start;
   struct timespec stop;
 } sock_test_stats_t;
@@ -115,6 +119,8 @@ sock_test_stats_accumulate (sock_test_stats_t * accum,
   accum->tx_bytes += incr->tx_bytes;
   accum->tx_eagain += incr->tx_eagain;
   accum->tx_incomp += incr->tx_incomp;
+  accum->rx_zc_bytes += incr->rx_zc_bytes;
+  accum->tx_zc_bytes += incr->tx_zc_bytes;
 }
 
 static inline void
@@ -125,6 +131,7 @@ sock_test_cfg_init (sock_test_cfg_t *cfg)
   cfg->ctrl_handle = ~0;
   cfg->num_test_sockets = 1;
   cfg->verbose = 0;
+  cfg->zero_copy = 0;
   cfg->rxbuf_size = SOCK_TEST_CFG_RXBUF_SIZE_DEF;
   cfg->num_writes = SOCK_TEST_CFG_NUM_WRITES_DEF;
   cfg->txbuf_size = SOCK_TEST_CFG_TXBUF_SIZE_DEF;
@@ -221,6 +228,7 @@ sock_test_cfg_dump (sock_test_cfg_t * cfg, uint8_t is_client)
 	  "           ctrl handle:  %d (0x%x)\n"
 	  "%-5s num test sockets:  %u (0x%08x)\n"
 	  "%-5s          verbose:  %s (%d)\n"
+	  "%-5s        zero copy:  %s (%d)\n"
 	  "%-5s       rxbuf size:  %lu (0x%08lx)\n"
 	  "%-5s       txbuf size:  %lu (0x%08lx)\n"
 	  "%-5s       num writes:  %lu (0x%08lx)\n"
@@ -237,6 +245,8 @@ sock_test_cfg_dump (sock_test_cfg_t * cfg, uint8_t is_client)
           cfg->num_test_sockets, cfg->num_test_sockets,
           is_client ? "'"SOCK_TEST_TOKEN_VERBOSE"'" : spc,
           cfg->verbose ? "on" : "off", cfg->verbose,
+          is_client ? "'"SOCK_TEST_TOKEN_ZERO_COPY"'" : spc,
+          cfg->zero_copy ? "on" : "off", cfg->zero_copy,
           is_client ? "'"SOCK_TEST_TOKEN_RXBUF_SIZE"'" : spc,
           cfg->rxbuf_size, cfg->rxbuf_size,
           is_client ? "'"SOCK_TEST_TOKEN_TXBUF_SIZE"'" : spc,
@@ -273,6 +283,10 @@ sock_test_stats_dump (char * header, sock_test_stats_t * stats,
           "  in %lf seconds (%lf Gbps %s-duplex)!\n",
               header, total_bytes, duration, rate,
           (show_rx && show_tx) ? "full" : "half");
+  if (stats->rx_zc_bytes || stats->tx_zc_bytes)
+    printf ("  copies avoided: %lu of %lu bytes (%.1lf%%)\n",
+            stats->rx_zc_bytes + stats->tx_zc_bytes, total_bytes,
+            100.0 * (stats->rx_zc_bytes + stats->tx_zc_bytes) / total_bytes);
 
   if (show_tx)
     {
@@ -429,4 +443,91 @@ sock_test_write (int fd, uint8_t *buf, uint32_t nbytes,
   return (tx_bytes);
 }
 
+#ifdef VCL_TEST
+/*
+ * Zero-copy versions of the above. Data is consumed or produced in the
+ * session fifos, by reference, and never copied to or from test buffers.
+ */
+static inline int
+sock_test_read_zc (int fd, uint64_t max_bytes, sock_test_stats_t *stats)
+{
+  vppcom_data_segments_t ds;
+  int rx_bytes, rv;
+
+  do
+    {
+      stats->rx_xacts++;
+      rx_bytes = vppcom_session_read_segments (fd, ds);
+      if (rx_bytes == VPPCOM_EAGAIN || rx_bytes == 0)
+        stats->rx_eagain++;
+    }
+  while (rx_bytes == VPPCOM_EAGAIN || rx_bytes == 0);
+
+  if (rx_bytes < 0)
+    {
+      errno = -rx_bytes;
+      fprintf (stderr, "SOCK_TEST: ERROR: zero-copy read "
+               "failed (errno = %d)!\n", errno);
+      return -1;
+    }
+
+  /* Leave whatever follows the test data, e.g., a cfg, in the fifo */
+  if (rx_bytes > max_bytes)
+    rx_bytes = max_bytes;
+
+  rv = vppcom_session_free_segments (fd, rx_bytes);
+  if (rv < 0)
+    {
+      errno = -rv;
+      return -1;
+    }
+
+  stats->rx_bytes += rx_bytes;
+  stats->rx_zc_bytes += rx_bytes;
+  return (rx_bytes);
+}
+
+static inline int
+sock_test_write_zc (int fd, uint64_t nbytes, sock_test_stats_t *stats)
+{
+  vppcom_data_segments_t ds;
+  int tx_bytes, rv;
+
+  do
+    {
+      stats->tx_xacts++;
+      tx_bytes = vppcom_session_alloc_segments (fd, ds);
+      if (tx_bytes == VPPCOM_EAGAIN || tx_bytes == 0)
+        stats->tx_eagain++;
+    }
+  while (tx_bytes == VPPCOM_EAGAIN || tx_bytes == 0);
+
+  if (tx_bytes < 0)
+    {
+      errno = -tx_bytes;
+      fprintf (stderr, "SOCK_TEST: ERROR: zero-copy alloc "
+               "failed (errno = %d)!\n", errno);
+      return -1;
+    }
+
+  /* Payload is produced in place, like iperf -Z sends file pages as
+   * they are, so segments are committed untouched */
+  if (tx_bytes > nbytes)
+    tx_bytes = nbytes;
+  else if (tx_bytes < nbytes)
+    stats->tx_incomp++;
+
+  rv = vppcom_session_commit_segments (fd, tx_bytes);
+  if (rv < 0)
+    {
+      errno = -rv;
+      return -1;
+    }
+
+  stats->tx_bytes += tx_bytes;
+  stats->tx_zc_bytes += tx_bytes;
+  return (tx_bytes);
+}
+#endif
+
 #endif /* __sock_test_h__ */
@@ -447,18 +447,33 @@ stream_test_client (sock_test_t test)
 	      FD_ISSET (tsock->fd, rfdset) &&
 	      (tsock->stats.rx_bytes < ctrl->cfg.total_bytes))
 	    {
-	      (void) sock_test_read (tsock->fd,
-				     (uint8_t *) tsock->rxbuf,
-				     tsock->rxbuf_size, &tsock->stats);
+#ifdef VCL_TEST
+	      if (ctrl->cfg.zero_copy)
+		(void) sock_test_read_zc (tsock->fd, ctrl->cfg.total_bytes -
+					  tsock->stats.rx_bytes,
+					  &tsock->stats);
+	      else
+#endif
+		(void) sock_test_read (tsock->fd,
+				       (uint8_t *) tsock->rxbuf,
+				       tsock->rxbuf_size, &tsock->stats);
 	    }
 
 	  if (FD_ISSET (tsock->fd, wfdset) &&
 	      (tsock->stats.tx_bytes < ctrl->cfg.total_bytes))
 	    {
-	      tx_bytes =
-		sock_test_write (tsock->fd, (uint8_t *) tsock->txbuf,
-				 ctrl->cfg.txbuf_size, &tsock->stats,
-				 ctrl->cfg.verbose);
+#ifdef VCL_TEST
+	      if (ctrl->cfg.zero_copy)
+		tx_bytes = sock_test_write_zc (tsock->fd,
+					       ctrl->cfg.total_bytes -
+					       tsock->stats.tx_bytes,
+					       &tsock->stats);
+	      else
+#endif
+		tx_bytes =
+		  sock_test_write (tsock->fd, (uint8_t *) tsock->txbuf,
+				   ctrl->cfg.txbuf_size, &tsock->stats,
+				   ctrl->cfg.verbose);
 	      if (tx_bytes < 0)
 		{
 		  fprintf (stderr, "\nCLIENT: ERROR: sock_test_write(%d) "
@@ -701,6 +716,8 @@ dump_help (void)
 	  "\t\t\tRun the Bi-directional test."
 	  INDENT SOCK_TEST_TOKEN_VERBOSE
 	  "\t\t\tToggle verbose setting."
+	  INDENT SOCK_TEST_TOKEN_ZERO_COPY
+	  "\t\t\tToggle zero-copy stream tests (vcl only)."
 	  INDENT SOCK_TEST_TOKEN_RXBUF_SIZE
 	  "<rxbuf size>\tRx buffer size (bytes)."
 	  INDENT SOCK_TEST_TOKEN_TXBUF_SIZE
@@ -807,6 +824,20 @@ cfg_verbose_toggle (void)
 
 }
 
+static void
+cfg_zero_copy_toggle (void)
+{
+  sock_client_main_t *scm = &sock_client_main;
+  sock_test_socket_t *ctrl = &scm->ctrl_socket;
+
+#ifdef VCL_TEST
+  ctrl->cfg.zero_copy = ctrl->cfg.zero_copy ? 0 : 1;
+  sock_test_cfg_dump (&ctrl->cfg, 1 /* is_client */ );
+#else
+  fprintf (stderr, "CLIENT: ERROR: zero copy needs the vcl test client!\n");
+#endif
+}
+
 static sock_test_t
 parse_input ()
 {
@@ -830,6 +861,10 @@ parse_input ()
 		     strlen (SOCK_TEST_TOKEN_VERBOSE)))
     cfg_verbose_toggle ();
 
+  else if (!strncmp (SOCK_TEST_TOKEN_ZERO_COPY, ctrl->txbuf,
+		     strlen (SOCK_TEST_TOKEN_ZERO_COPY)))
+    cfg_zero_copy_toggle ();
+
   else if (!strncmp (SOCK_TEST_TOKEN_TXBUF_SIZE, ctrl->txbuf,
 		     strlen (SOCK_TEST_TOKEN_TXBUF_SIZE)))
     cfg_txbuf_size_set ();
@@ -878,7 +913,8 @@ print_usage_and_exit (void)
 	   "  -T <txbuf-size>  Test Cfg: tx buffer size.\n"
 	   "  -U               Run Uni-directional test.\n"
 	   "  -B               Run Bi-directional test.\n"
-	   "  -V               Verbose mode.\n");
+	   "  -V               Verbose mode.\n"
+	   "  -Z               Zero-copy stream tests (vcl only).\n");
   exit (1);
 }
 
@@ -894,7 +930,7 @@ main (int argc, char **argv)
   sock_test_socket_buf_alloc (ctrl);
 
   opterr = 0;
-  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBV6D")) != -1)
+  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBV6DZ")) != -1)
     switch (c)
       {
       case 'c':
@@ -1031,6 +1067,16 @@ main (int argc, char **argv)
 	ctrl->cfg.verbose = 1;
 	break;
 
+      case 'Z':
+#ifdef VCL_TEST
+	ctrl->cfg.zero_copy = 1;
+#else
+	fprintf (stderr, "CLIENT: ERROR: Option -%c needs the vcl "
+		 "test client!\n", c);
+	print_usage_and_exit ();
+#endif
+	break;
+
       case '6':
 	ctrl->cfg.address_ip6 = 1;
 	break;
@@ -828,8 +828,25 @@ main (int argc, char **argv)
 	  if (EPOLLIN & ssm->wait_events[i].events)
 #endif
 	    {
-	      rx_bytes = sock_test_read (client_fd, conn->buf,
-					 conn->buf_size, &conn->stats);
+#ifdef VCL_TEST
+	      /* Sink uni-directional test data in place. Stop at the end of
+	       * the data so the stop cfg is read into conn->buf */
+	      if (conn->cfg.zero_copy && (conn->cfg.test == SOCK_TEST_TYPE_UNI)
+		  && (conn->stats.rx_bytes < conn->cfg.total_bytes))
+		{
+		  rx_bytes = sock_test_read_zc (client_fd, conn->cfg.total_bytes
+						- conn->stats.rx_bytes,
+						&conn->stats);
+		  if (rx_bytes > 0)
+		    {
+		      stream_test_server (conn, rx_bytes);
+		      continue;
+		    }
+		}
+	      else
+#endif
+		rx_bytes = sock_test_read (client_fd, conn->buf,
+					   conn->buf_size, &conn->stats);
 	      if (rx_bytes > 0)
 		{
 		  rx_cfg = (sock_test_cfg_t *) conn->buf;
@@ -144,7 +144,7 @@ typedef struct
   u32 sm_seg_index;
   u32 client_context;
   u64 vpp_handle;
-  svm_queue_t *vpp_event_queue;
+  svm_ring_t *vpp_event_queue;
 
   /* Socket configuration state */
   u8 is_vep;
@@ -257,7 +257,7 @@ typedef struct vppcom_main_t_
   clib_bitmap_t *ex_bitmap;
 
   /* Our event queue */
-  svm_queue_t *app_event_queue;
+  svm_ring_t *app_event_queue;
 
   /* unique segment name counter */
   u32 unique_segment_index;
@@ -1035,7 +1035,7 @@ vl_api_application_attach_reply_t_handler (vl_api_application_attach_reply_t *
     }
 
   vcm->app_event_queue =
-    uword_to_pointer (mp->app_event_queue_address, svm_queue_t *);
+    uword_to_pointer (mp->app_event_queue_address, svm_ring_t *);
 
   vcm->app_state = STATE_APP_ATTACHED;
 }
@@ -1232,7 +1232,7 @@ done:
       clib_spinlock_unlock (&vcm->session_io_thread.io_sessions_lockp);
     }
   session->vpp_event_queue = uword_to_pointer (mp->vpp_event_queue_address,
-					       svm_queue_t *);
+					       svm_ring_t *);
 
   rx_fifo = uword_to_pointer (mp->server_rx_fifo, svm_fifo_t *);
   rx_fifo->client_session_index = session_index;
@@ -1518,7 +1518,7 @@ vl_api_accept_session_t_handler (vl_api_accept_session_t * mp)
   session->rx_fifo = rx_fifo;
   session->tx_fifo = tx_fifo;
   session->vpp_event_queue = uword_to_pointer (mp->vpp_event_queue_address,
-					       svm_queue_t *);
+					       svm_ring_t *);
   session->state = STATE_ACCEPT;
   session->peer_port = mp->port;
   session->peer_addr.is_ip4 = mp->is_ip4;
@@ -3241,9 +3241,18 @@ done:
   return rv;
 }
 
+/* Segments are handed out as fifo chunks */
+STATIC_ASSERT (sizeof (vppcom_data_segment_t) == sizeof (svm_fifo_chunk_t)
+	       && STRUCT_OFFSET_OF (vppcom_data_segment_t, len)
+	       == STRUCT_OFFSET_OF (svm_fifo_chunk_t, len),
+	       "vppcom_data_segment_t must match svm_fifo_chunk_t");
+
+/**
+ * Copy, peek at, or if ds is set, point ds at data in the rx fifo
+ */
 static inline int
 vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
-			      u8 peek)
+			      vppcom_data_segment_t * ds, u8 peek)
 {
   session_t *session = 0;
   svm_fifo_t *rx_fifo;
@@ -3255,7 +3264,7 @@ vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
   u32 poll_et;
   session_state_t state;
 
-  ASSERT (buf);
+  ASSERT (buf || ds);
 
   VCL_LOCK_AND_GET_SESSION (session_index, &session);
 
@@ -3291,7 +3300,9 @@ vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
 
   do
     {
-      if (peek)
+      if (ds)
+	n_read = svm_fifo_read_chunks (rx_fifo, (svm_fifo_chunk_t *) ds, n);
+      else if (peek)
 	n_read = svm_fifo_peek (rx_fifo, 0, n, buf);
       else
 	n_read = svm_fifo_dequeue_nowait (rx_fifo, n, buf);
@@ -3351,13 +3362,54 @@ done:
 int
 vppcom_session_read (uint32_t session_index, void *buf, size_t n)
 {
-  return (vppcom_session_read_internal (session_index, buf, n, 0));
+  return (vppcom_session_read_internal (session_index, buf, n, 0, 0));
 }
 
 static int
 vppcom_session_peek (uint32_t session_index, void *buf, int n)
 {
-  return (vppcom_session_read_internal (session_index, buf, n, 1));
+  return (vppcom_session_read_internal (session_index, buf, n, 0, 1));
+}
+
+/**
+ * Point segments at data in the session's rx fifo, without copying it
+ *
+ * Data stays in the fifo, and keeps counting against the receive window,
+ * until it is released with vppcom_session_free_segments.
+ *
+ * @return number of bytes in the segments, or a VPPCOM error
+ */
+int
+vppcom_session_read_segments (uint32_t session_index,
+			      vppcom_data_segments_t ds)
+{
+  return (vppcom_session_read_internal (session_index, 0, ~0U >> 1, ds, 0));
+}
+
+/**
+ * Release the first n_bytes of data returned by read_segments
+ */
+int
+vppcom_session_free_segments (uint32_t session_index, uint32_t n_bytes)
+{
+  session_t *session = 0;
+  svm_fifo_t *rx_fifo;
+  int rv;
+
+  VCL_LOCK_AND_GET_SESSION (session_index, &session);
+  rx_fifo = session->rx_fifo;
+  clib_spinlock_unlock (&vcm->sessions_lockp);
+
+  if (PREDICT_FALSE (!rx_fifo || n_bytes > svm_fifo_max_dequeue (rx_fifo)))
+    {
+      rv = VPPCOM_EINVAL;
+      goto done;
+    }
+
+  (void) svm_fifo_dequeue_drop (rx_fifo, n_bytes);
+  rv = VPPCOM_OK;
+done:
+  return rv;
 }
 
 static inline int
@@ -3432,16 +3484,15 @@ vppcom_session_read_ready (session_t * session, u32 session_index)
     }
   rv = ready;
 
-  if (vcm->app_event_queue->cursize &&
-      !pthread_mutex_trylock (&vcm->app_event_queue->mutex))
+  if (!svm_ring_is_empty (vcm->app_event_queue))
     {
-      u32 i, n_to_dequeue = vcm->app_event_queue->cursize;
+      u32 i, n_to_dequeue = svm_ring_n_elts (vcm->app_event_queue);
       session_fifo_event_t e;
 
+      /* Other app threads may be draining the ring as well */
       for (i = 0; i < n_to_dequeue; i++)
-	svm_queue_sub_raw (vcm->app_event_queue, (u8 *) & e);
-
-      pthread_mutex_unlock (&vcm->app_event_queue->mutex);
+	if (svm_ring_try_dequeue (vcm->app_event_queue, &e))
+	  break;
     }
 done:
   return rv;
@@ -3482,20 +3533,23 @@ vppcom_session_register_ioevent_cb (uint32_t session_index,
   return rv;
 }
 
-int
-vppcom_session_write (uint32_t session_index, void *buf, size_t n)
+/**
+ * Copy buf to the tx fifo, or if ds is set, point ds at free space in the
+ * tx fifo. If commit is set, hand vpp n bytes the app wrote to that space.
+ */
+static int
+vppcom_session_write_internal (uint32_t session_index, void *buf, size_t n,
+			       vppcom_data_segment_t * ds, u8 commit)
 {
   session_t *session = 0;
   svm_fifo_t *tx_fifo = 0;
-  svm_queue_t *q;
+  svm_ring_t *q;
   session_fifo_event_t evt;
   session_state_t state;
   int rv, n_write, is_nonblocking;
   u32 poll_et;
   u64 vpp_handle;
 
-  ASSERT (buf);
-
   VCL_LOCK_AND_GET_SESSION (session_index, &session);
 
   tx_fifo = session->tx_fifo;
@@ -3531,11 +3585,29 @@ vppcom_session_write (uint32_t session_index, void *buf, size_t n)
 
   clib_spinlock_unlock (&vcm->sessions_lockp);
 
-  do
+  if (commit)
+    {
+      if (PREDICT_FALSE (n > svm_fifo_max_enqueue (tx_fifo)))
+	{
+	  rv = VPPCOM_EINVAL;
+	  goto done;
+	}
+      svm_fifo_enqueue_nocopy (tx_fifo, n);
+      n_write = n;
+    }
+  else
     {
-      n_write = svm_fifo_enqueue_nowait (tx_fifo, n, (void *) buf);
+      ASSERT (buf || ds);
+      do
+	{
+	  if (ds)
+	    n_write = svm_fifo_write_chunks (tx_fifo,
+					     (svm_fifo_chunk_t *) ds, n);
+	  else
+	    n_write = svm_fifo_enqueue_nowait (tx_fifo, n, (void *) buf);
+	}
+      while (!is_nonblocking && (n_write <= 0));
     }
-  while (!is_nonblocking && (n_write <= 0));
 
   /* If event wasn't set, add one
    *
@@ -3543,7 +3615,7 @@ vppcom_session_write (uint32_t session_index, void *buf, size_t n)
    * event is already there for this event_key, but for now
    * this will suffice. */
 
-  if ((n_write > 0) && svm_fifo_set_event (tx_fifo))
+  if ((n_write > 0) && !ds && svm_fifo_set_event (tx_fifo))
     {
       /* Fabricate TX event, send to vpp */
       evt.fifo = tx_fifo;
@@ -3552,7 +3624,7 @@ vppcom_session_write (uint32_t session_index, void *buf, size_t n)
       VCL_LOCK_AND_GET_SESSION (session_index, &session);
       q = session->vpp_event_queue;
       ASSERT (q);
-      svm_queue_add (q, (u8 *) & evt, 0 /* do wait for mutex */ );
+      svm_ring_enqueue (q, &evt, 0 /* wait for space */ );
       clib_spinlock_unlock (&vcm->sessions_lockp);
       if (VPPCOM_DEBUG > 1)
 	clib_warning ("VCL<%d>: vpp handle 0x%llx, sid %u: "
@@ -3612,6 +3684,42 @@ done:
   return rv;
 }
 
+int
+vppcom_session_write (uint32_t session_index, void *buf, size_t n)
+{
+  if (!buf)
+    return VPPCOM_EINVAL;
+  return vppcom_session_write_internal (session_index, buf, n, 0, 0);
+}
+
+/**
+ * Point segments at free space in the session's tx fifo
+ *
+ * The app fills the segments in place and hands the data to vpp with
+ * vppcom_session_commit_segments. Only one thread should write to a
+ * session while it has segments allocated.
+ *
+ * @return number of bytes in the segments, or a VPPCOM error
+ */
+int
+vppcom_session_alloc_segments (uint32_t session_index,
+			       vppcom_data_segments_t ds)
+{
+  return vppcom_session_write_internal (session_index, 0, ~0U, ds, 0);
+}
+
+/**
+ * Hand the first n_bytes of allocated segments to vpp
+ */
+int
+vppcom_session_commit_segments (uint32_t session_index, uint32_t n_bytes)
+{
+  if (!n_bytes)
+    return VPPCOM_OK;
+  return vppcom_session_write_internal (session_index, 0, n_bytes, 0,
+					1 /* commit */ );
+}
+
 static inline int
 vppcom_session_write_ready (session_t * session, u32 session_index)
 {
@@ -144,6 +144,16 @@ typedef struct _vcl_poll
   short *revents;
 } vcl_poll_t;
 
+/** Fifo memory lent to the app, see vppcom_session_read_segments */
+typedef struct vppcom_data_segment_
+{
+  unsigned char *data;
+  uint32_t len;
+} vppcom_data_segment_t;
+
+/** Fifos wrap, so data is handed out as at most two segments */
+typedef vppcom_data_segment_t vppcom_data_segments_t[2];
+
 typedef struct vppcom_ioevent_
 {
   uint32_t session_index;
@@ -303,6 +313,22 @@ extern int vppcom_session_connect (uint32_t session_index,
 extern int vppcom_session_read (uint32_t session_index, void *buf, size_t n);
 extern int vppcom_session_write (uint32_t session_index, void *buf, size_t n);
 
+/*
+ * Zero-copy I/O. Read segments point into the session's rx fifo, and
+ * stay valid until they are freed. Alloc segments point at free space in
+ * the tx fifo, and are handed to vpp once filled, by committing them.
+ * Bytes are freed and committed in order, and may be fewer than were
+ * read or allocated.
+ */
+extern int vppcom_session_read_segments (uint32_t session_index,
+					 vppcom_data_segments_t ds);
+extern int vppcom_session_free_segments (uint32_t session_index,
+					 uint32_t n_bytes);
+extern int vppcom_session_alloc_segments (uint32_t session_index,
+					  vppcom_data_segments_t ds);
+extern int vppcom_session_commit_segments (uint32_t session_index,
+					   uint32_t n_bytes);
+
 extern int vppcom_select (unsigned long n_bits,
 			  unsigned long *read_map,
 			  unsigned long *write_map,
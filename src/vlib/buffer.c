@@ -382,6 +382,8 @@ vlib_buffer_create_free_list_helper (vlib_main_t * vm,
   f->n_data_bytes = vlib_buffer_round_size (n_data_bytes);
   f->min_n_buffers_each_alloc = VLIB_FRAME_SIZE;
   f->buffer_pool_index = 0;
+  if (!bm->callbacks_registered)
+    f->buffer_pool_index = vlib_buffer_pool_index_for_numa (vm->numa_node);
   f->name = clib_mem_is_vec (name) ? name : format (0, "%s", name);
 
   /* Setup free buffer template. */
@@ -406,6 +408,9 @@ vlib_buffer_create_free_list_helper (vlib_main_t * vm,
       wf[0] = f[0];
       wf->buffers = 0;
       wf->n_alloc = 0;
+      if (!bm->callbacks_registered)
+	wf->buffer_pool_index =
+	  vlib_buffer_pool_index_for_numa (wvm->numa_node);
     }
 
   return f->index;
@@ -432,9 +437,15 @@ static void
 del_free_list (vlib_main_t * vm, vlib_buffer_free_list_t * f)
 {
   vlib_buffer_pool_t *bp = vlib_buffer_pool_get (f->buffer_pool_index);
+  u32 i;
 
-  vec_add_aligned (bp->buffers, f->buffers, vec_len (f->buffers),
-		   CLIB_CACHE_LINE_BYTES);
+  vlib_buffer_free_list_flush_remote (f);
+  for (i = 0; i < vec_len (f->remote_buffers); i++)
+    vec_free (f->remote_buffers[i]);
+  vec_free (f->remote_buffers);
+
+  if (vec_len (f->buffers))
+    vlib_buffer_pool_give (bp, f->buffers, vec_len (f->buffers));
   vec_free (f->name);
   vec_free (f->buffers);
 
@@ -475,10 +486,7 @@ vlib_buffer_pool_get_buffer (vlib_buffer_pool_t * bp)
   uword slot, page, addr;
 
   if (PREDICT_FALSE (bp->n_elts == bp->n_used))
-    {
-      clib_spinlock_unlock (&bp->lock);
-      return 0;
-    }
+    return 0;
   slot = bp->next_clear;
   bp->bitmap = clib_bitmap_set (bp->bitmap, slot, 1);
   bp->next_clear = clib_bitmap_next_clear (bp->bitmap, slot + 1);
@@ -502,34 +510,40 @@ vlib_buffer_fill_free_list_internal (vlib_main_t * vm,
   vlib_buffer_pool_t *bp = vlib_buffer_pool_get (fl->buffer_pool_index);
   int n;
   u32 *bi;
-  u32 n_alloc = 0;
+  u32 n_alloc = 0, len, n_take;
 
   /* Already have enough free buffers on free list? */
   n = min_free_buffers - vec_len (fl->buffers);
   if (n <= 0)
     return min_free_buffers;
 
-  if (vec_len (bp->buffers) > 0)
-    {
-      int n_copy, n_left;
-      clib_spinlock_lock (&bp->lock);
-      n_copy = clib_min (vec_len (bp->buffers), n);
-      n_left = vec_len (bp->buffers) - n_copy;
-      vec_add_aligned (fl->buffers, bp->buffers + n_left, n_copy,
-		       CLIB_CACHE_LINE_BYTES);
-      _vec_len (bp->buffers) = n_left;
-      clib_spinlock_unlock (&bp->lock);
-      n = min_free_buffers - vec_len (fl->buffers);
-      if (n <= 0)
-	return min_free_buffers;
-    }
-
   /* Always allocate round number of buffers. */
   n = round_pow2 (n, CLIB_CACHE_LINE_BYTES / sizeof (u32));
 
   /* Always allocate new buffers in reasonably large sized chunks. */
   n = clib_max (n, fl->min_n_buffers_each_alloc);
 
+  /* Refill in bulk from buffers other threads gave back */
+  len = vec_len (fl->buffers);
+  vec_validate_aligned (fl->buffers, len + n - 1, CLIB_CACHE_LINE_BYTES);
+  if (PREDICT_TRUE (bp->ring != 0))
+    n_take = vlib_buffer_pool_take (bp, fl->buffers + len, n);
+  else
+    {
+      clib_spinlock_lock_if_init (&bp->lock);
+      n_take = clib_min (vec_len (bp->buffers), n);
+      clib_memcpy (fl->buffers + len,
+		   bp->buffers + vec_len (bp->buffers) - n_take,
+		   n_take * sizeof (u32));
+      _vec_len (bp->buffers) -= n_take;
+      clib_spinlock_unlock_if_init (&bp->lock);
+    }
+  _vec_len (fl->buffers) = len + n_take;
+  fl->n_alloc += n_take;
+  if (n_take == n)
+    return n;
+  n -= n_take;
+
   clib_spinlock_lock (&bp->lock);
   while (n_alloc < n)
     {
@@ -546,6 +560,7 @@ vlib_buffer_fill_free_list_internal (vlib_main_t * vm,
 
       memset (b, 0, sizeof (vlib_buffer_t));
       vlib_buffer_init_for_free_list (b, fl);
+      b->buffer_pool_index = bp - buffer_main.buffer_pools;
 
       if (fl->buffer_init_function)
 	fl->buffer_init_function (vm, fl, bi, 1);
@@ -554,7 +569,23 @@ vlib_buffer_fill_free_list_internal (vlib_main_t * vm,
 done:
   clib_spinlock_unlock (&bp->lock);
   fl->n_alloc += n_alloc;
-  return n_alloc;
+  return n_take + n_alloc;
+}
+
+/* Send buffers freed on this thread but owned by another numa node's pool
+   home, called once per main loop when there are any */
+void
+vlib_buffer_flush_remote (vlib_main_t * vm)
+{
+  vlib_buffer_free_list_t *fl;
+
+  vm->buffer_remote_pending = 0;
+  /* *INDENT-OFF* */
+  pool_foreach (fl, vm->buffer_free_list_pool,
+  ({
+    vlib_buffer_free_list_flush_remote (fl);
+  }));
+  /* *INDENT-ON* */
 }
 
 void *
@@ -948,7 +979,13 @@ vlib_buffer_pool_create (vlib_main_t * vm, vlib_physmem_region_index_t pri,
   p->buffers_per_page = (1 << pr->log2_page_size) / p->buffer_size;
   p->n_elts = p->buffers_per_page * pr->n_pages;
   p->n_used = 0;
+  p->numa_node = pr->numa_node;
   clib_spinlock_init (&p->lock);
+
+  /* big enough to take back every buffer of the pool */
+  vec_validate_aligned (p->ring, max_pow2 (p->n_elts) - 1,
+			CLIB_CACHE_LINE_BYTES);
+  p->ring_mask = vec_len (p->ring) - 1;
 done:
   ASSERT (p - bm->buffer_pools < 256);
   return p - bm->buffer_pools;
@@ -959,23 +996,53 @@ format_vlib_buffer_free_list (u8 * s, va_list * va)
 {
   vlib_buffer_free_list_t *f = va_arg (*va, vlib_buffer_free_list_t *);
   u32 threadnum = va_arg (*va, u32);
+  f64 now = va_arg (*va, f64);
   uword bytes_alloc, bytes_free, n_free, size;
+  f64 dt, alloc_mops = 0, free_mops = 0;
 
   if (!f)
-    return format (s, "%=7s%=30s%=12s%=12s%=12s%=12s%=12s%=12s",
+    return format (s, "%=7s%=30s%=12s%=12s%=12s%=12s%=12s%=12s%=12s%=12s",
 		   "Thread", "Name", "Index", "Size", "Alloc", "Free",
-		   "#Alloc", "#Free");
+		   "#Alloc", "#Free", "Alloc Mops", "Free Mops");
 
   size = sizeof (vlib_buffer_t) + f->n_data_bytes;
   n_free = vec_len (f->buffers);
   bytes_alloc = size * f->n_alloc;
   bytes_free = size * n_free;
 
-  s = format (s, "%7d%30v%12d%12d%=12U%=12U%=12d%=12d", threadnum,
-	      f->name, f->index, f->n_data_bytes,
+  /* rates since the previous show */
+  dt = now - f->last_ops_time;
+  if (f->last_ops_time > 0 && dt > 0)
+    {
+      alloc_mops = (f->n_alloc_ops - f->last_alloc_ops) / dt * 1e-6;
+      free_mops = (f->n_free_ops - f->last_free_ops) / dt * 1e-6;
+    }
+  f->last_alloc_ops = f->n_alloc_ops;
+  f->last_free_ops = f->n_free_ops;
+  f->last_ops_time = now;
+
+  s = format (s, "%7d%30v%12d%12d%=12U%=12U%=12d%=12d%=12.3f%=12.3f",
+	      threadnum, f->name, f->index, f->n_data_bytes,
 	      format_memory_size, bytes_alloc,
-	      format_memory_size, bytes_free, f->n_alloc, n_free);
+	      format_memory_size, bytes_free, f->n_alloc, n_free,
+	      alloc_mops, free_mops);
+
+  return s;
+}
+
+static u8 *
+format_vlib_buffer_pool (u8 * s, va_list * va)
+{
+  vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
+  u32 index = va_arg (*va, u32);
+
+  if (!bp)
+    return format (s, "%=7s%=7s%=12s%=12s%=12s%=12s",
+		   "Pool", "Numa", "Size", "Buffers", "Carved", "Returned");
 
+  s = format (s, "%7d%7d%12d%12d%12d%12d", index, bp->numa_node,
+	      bp->buffer_size, bp->n_elts, bp->n_used,
+	      bp->ring_prod_tail - bp->ring_cons_tail);
   return s;
 }
 
@@ -983,11 +1050,14 @@ static clib_error_t *
 show_buffers (vlib_main_t * vm,
 	      unformat_input_t * input, vlib_cli_command_t * cmd)
 {
+  vlib_buffer_main_t *bm = &buffer_main;
   vlib_buffer_free_list_t *f;
+  vlib_buffer_pool_t *bp;
   vlib_main_t *curr_vm;
   u32 vm_index = 0;
+  f64 now = vlib_time_now (vm);
 
-  vlib_cli_output (vm, "%U", format_vlib_buffer_free_list, 0, 0);
+  vlib_cli_output (vm, "%U", format_vlib_buffer_free_list, 0, 0, now);
 
   do
     {
@@ -995,7 +1065,8 @@ show_buffers (vlib_main_t * vm,
 
     /* *INDENT-OFF* */
     pool_foreach (f, curr_vm->buffer_free_list_pool, ({
-      vlib_cli_output (vm, "%U", format_vlib_buffer_free_list, f, vm_index);
+      vlib_cli_output (vm, "%U", format_vlib_buffer_free_list, f, vm_index,
+		       now);
     }));
     /* *INDENT-ON* */
 
@@ -1003,6 +1074,14 @@ show_buffers (vlib_main_t * vm,
     }
   while (vm_index < vec_len (vlib_mains));
 
+  if (bm->callbacks_registered)
+    return 0;
+
+  vlib_cli_output (vm, "\n%U", format_vlib_buffer_pool, 0, 0);
+  vec_foreach (bp, bm->buffer_pools)
+    vlib_cli_output (vm, "%U", format_vlib_buffer_pool, bp,
+		     bp - bm->buffer_pools);
+
   return 0;
 }
 
@@ -1014,12 +1093,72 @@ VLIB_CLI_COMMAND (show_buffers_command, static) = {
 };
 /* *INDENT-ON* */
 
-clib_error_t *
-vlib_buffer_main_init (struct vlib_main_t * vm)
+/* Point the free lists of a new worker at the pool of its numa node */
+static clib_error_t *
+vlib_buffer_worker_init (vlib_main_t * vm)
+{
+  vlib_buffer_main_t *bm = &buffer_main;
+  vlib_buffer_free_list_t *f;
+
+  if (bm->callbacks_registered)
+    return 0;
+
+  /* *INDENT-OFF* */
+  pool_foreach (f, vm->buffer_free_list_pool, ({
+    ASSERT (vec_len (f->buffers) == 0);
+    f->buffer_pool_index = vlib_buffer_pool_index_for_numa (vm->numa_node);
+  }));
+  /* *INDENT-ON* */
+
+  return 0;
+}
+
+VLIB_WORKER_INIT_FUNCTION (vlib_buffer_worker_init);
+
+static clib_error_t *
+vlib_buffer_numa_pool_create (vlib_main_t * vm, u32 numa_node)
 {
   vlib_buffer_main_t *bm = &buffer_main;
   vlib_physmem_region_index_t pri;
   clib_error_t *error;
+  u8 *name;
+
+  /* keep the historical name for the first region */
+  if (numa_node == 0)
+    name = format (0, "buffers%c", 0);
+  else
+    name = format (0, "buffers-numa-%u%c", numa_node, 0);
+
+  error = vlib_physmem_region_alloc (vm, (char *) name,
+				     vlib_buffer_physmem_sz, numa_node,
+				     VLIB_PHYSMEM_F_SHARED |
+				     VLIB_PHYSMEM_F_HUGETLB, &pri);
+
+  if (error)
+    {
+      clib_error_free (error);
+      error = vlib_physmem_region_alloc (vm, (char *) name,
+					 vlib_buffer_physmem_sz, numa_node,
+					 VLIB_PHYSMEM_F_SHARED, &pri);
+    }
+  vec_free (name);
+
+  if (error)
+    return error;
+
+  vec_validate (bm->buffer_pool_index_by_numa, numa_node);
+  bm->buffer_pool_index_by_numa[numa_node] =
+    vlib_buffer_pool_create (vm, pri, sizeof (vlib_buffer_t) +
+			     VLIB_BUFFER_DEFAULT_FREE_LIST_BYTES);
+  return 0;
+}
+
+clib_error_t *
+vlib_buffer_main_init (struct vlib_main_t * vm)
+{
+  vlib_buffer_main_t *bm = &buffer_main;
+  clib_error_t *error = 0;
+  uword *numa_bitmap, numa_node;
 
   if (vlib_buffer_callbacks)
     {
@@ -1038,24 +1177,29 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     &vlib_buffer_delete_free_list_internal;
   clib_spinlock_init (&bm->buffer_known_hash_lockp);
 
-  /* allocate default region */
-  error = vlib_physmem_region_alloc (vm, "buffers",
-				     vlib_buffer_physmem_sz, 0,
-				     VLIB_PHYSMEM_F_SHARED |
-				     VLIB_PHYSMEM_F_HUGETLB, &pri);
+  /* one pool per numa node, threads allocate from their local one */
+  numa_bitmap = clib_sysfs_list_to_bitmap ("/sys/devices/system/node/online");
+  if (!numa_bitmap)
+    numa_bitmap = clib_bitmap_set (0, 0, 1);
+
+  /* *INDENT-OFF* */
+  clib_bitmap_foreach (numa_node, numa_bitmap, ({
+    error = vlib_buffer_numa_pool_create (vm, numa_node);
+    if (error && vec_len (bm->buffer_pools))
+      {
+        /* no memory on this node, it uses the first pool */
+        clib_warning ("numa %u: %U, using pool 0", numa_node,
+                      format_clib_error, error);
+        clib_error_free (error);
+        vec_validate (bm->buffer_pool_index_by_numa, numa_node);
+      }
+    else if (error)
+      goto done;
+  }));
+  /* *INDENT-ON* */
 
-  if (error == 0)
-    goto done;
-
-  clib_error_free (error);
-
-  error = vlib_physmem_region_alloc (vm, "buffers",
-				     vlib_buffer_physmem_sz, 0,
-				     VLIB_PHYSMEM_F_SHARED, &pri);
 done:
-  if (error == 0)
-    vlib_buffer_pool_create (vm, pri, sizeof (vlib_buffer_t) +
-			     VLIB_BUFFER_DEFAULT_FREE_LIST_BYTES);
+  clib_bitmap_free (numa_bitmap);
   return error;
 }
 
@@ -361,6 +361,10 @@ typedef struct vlib_buffer_free_list_t
   /* index of buffer pool used to get / put buffers */
   u8 buffer_pool_index;
 
+  /* Buffers freed here which belong to another pool, e.g. allocated
+     on a remote numa node. Indexed by pool, returned in bulk. */
+  u32 **remote_buffers;
+
   /* Free list name. */
   u8 *name;
 
@@ -376,6 +380,13 @@ typedef struct vlib_buffer_free_list_t
     (struct vlib_main_t * vm, struct vlib_buffer_free_list_t * fl);
 
   uword buffer_init_function_opaque;
+
+  /* Number of buffers handed out / taken back, for ops rate */
+  u64 n_alloc_ops;
+  u64 n_free_ops;
+  u64 last_alloc_ops;
+  u64 last_free_ops;
+  f64 last_ops_time;
 } __attribute__ ((aligned (16))) vlib_buffer_free_list_t;
 
 typedef uword (vlib_buffer_fill_free_list_cb_t) (struct vlib_main_t * vm,
@@ -412,15 +423,32 @@ typedef struct
   uword log2_page_size;
   vlib_physmem_region_index_t physmem_region;
 
-  u32 *buffers;
-
   u16 buffer_size;
+  u8 numa_node;
   uword buffers_per_page;
   uword n_elts;
   uword n_used;
   uword next_clear;
   uword *bitmap;
+  /* protects carving never used buffers out of the bitmap */
   clib_spinlock_t lock;
+
+  /* Free buffers given back by the threads. Multi-producer,
+     multi-consumer ring, moved in bulk without taking the lock. */
+  u32 *ring;
+  u32 ring_mask;
+
+  /* Pools created without a buffer size have no ring, buffers given
+     back to them go here under the lock */
+  u32 *buffers;
+
+    CLIB_CACHE_LINE_ALIGN_MARK (ring_prod);
+  volatile u32 ring_prod_head;
+  volatile u32 ring_prod_tail;
+
+    CLIB_CACHE_LINE_ALIGN_MARK (ring_cons);
+  volatile u32 ring_cons_head;
+  volatile u32 ring_cons_tail;
 } vlib_buffer_pool_t;
 
 typedef struct
@@ -432,6 +460,9 @@ typedef struct
   uword buffer_mem_size;
   vlib_buffer_pool_t *buffer_pools;
 
+  /* Native buffer pool serving each numa node */
+  u8 *buffer_pool_index_by_numa;
+
   /* Buffer free callback, for subversive activities */
     u32 (*buffer_free_callback) (struct vlib_main_t * vm,
 				 u32 * buffers,
@@ -464,6 +495,15 @@ vlib_buffer_pool_get (u8 buffer_pool_index)
   return vec_elt_at_index (bm->buffer_pools, buffer_pool_index);
 }
 
+static_always_inline u8
+vlib_buffer_pool_index_for_numa (u32 numa_node)
+{
+  vlib_buffer_main_t *bm = &buffer_main;
+  if (numa_node < vec_len (bm->buffer_pool_index_by_numa))
+    return bm->buffer_pool_index_by_numa[numa_node];
+  return 0;
+}
+
 u8 vlib_buffer_pool_create (struct vlib_main_t * vm,
 			    vlib_physmem_region_index_t region,
 			    u16 buffer_size);
@@ -514,6 +554,7 @@ void unserialize_open_vlib_buffer (serialize_main_t * m,
 u32 serialize_close_vlib_buffer (serialize_main_t * m);
 void unserialize_close_vlib_buffer (serialize_main_t * m);
 void *vlib_set_buffer_free_callback (struct vlib_main_t *vm, void *fp);
+void vlib_buffer_flush_remote (struct vlib_main_t *vm);
 
 always_inline u32
 serialize_vlib_buffer_n_bytes (serialize_main_t * m)
@@ -459,6 +459,7 @@ vlib_buffer_alloc_from_free_list (vlib_main_t * vm,
       src = fl->buffers + len - n_buffers;
       clib_memcpy (buffers, src, n_buffers * sizeof (u32));
       _vec_len (fl->buffers) -= n_buffers;
+      fl->n_alloc_ops += n_buffers;
 
       /* Verify that buffers are known free. */
       vlib_buffer_validate_alloc_free (vm, buffers, n_buffers,
@@ -470,6 +471,7 @@ vlib_buffer_alloc_from_free_list (vlib_main_t * vm,
   src = fl->buffers + len - n_buffers;
   clib_memcpy (buffers, src, n_buffers * sizeof (u32));
   _vec_len (fl->buffers) -= n_buffers;
+  fl->n_alloc_ops += n_buffers;
 
   /* Verify that buffers are known free. */
   vlib_buffer_validate_alloc_free (vm, buffers, n_buffers,
@@ -1099,6 +1101,111 @@ vlib_buffer_init_for_free_list (vlib_buffer_t * dst,
   ASSERT (dst->n_add_refs == 0);
 }
 
+/** \brief Put buffers on a buffer pool free ring
+
+    Lock-free, safe to call from any thread. The ring can hold every
+    buffer of the pool so it never overflows.
+*/
+static_always_inline void
+vlib_buffer_pool_put (vlib_buffer_pool_t * bp, u32 * buffers, u32 n_buffers)
+{
+  u32 head, next, slot, n_first;
+
+  /* claim n_buffers slots */
+  head = __atomic_load_n (&bp->ring_prod_head, __ATOMIC_RELAXED);
+  do
+    {
+      next = head + n_buffers;
+      ASSERT (next - bp->ring_cons_tail <= bp->ring_mask + 1);
+    }
+  while (!__atomic_compare_exchange_n (&bp->ring_prod_head, &head, next,
+				       /* weak */ 1, __ATOMIC_ACQUIRE,
+				       __ATOMIC_RELAXED));
+
+  slot = head & bp->ring_mask;
+  n_first = clib_min (n_buffers, bp->ring_mask + 1 - slot);
+  clib_memcpy (bp->ring + slot, buffers, n_first * sizeof (u32));
+  if (n_first < n_buffers)
+    clib_memcpy (bp->ring, buffers + n_first,
+		 (n_buffers - n_first) * sizeof (u32));
+
+  /* publish in claim order */
+  while (__atomic_load_n (&bp->ring_prod_tail, __ATOMIC_RELAXED) != head)
+    CLIB_PAUSE ();
+  __atomic_store_n (&bp->ring_prod_tail, next, __ATOMIC_RELEASE);
+}
+
+/** \brief Take up to n_buffers from a buffer pool free ring
+
+    Lock-free, safe to call from any thread.
+    @return - (u32) number of buffers taken, may be zero
+*/
+static_always_inline u32
+vlib_buffer_pool_take (vlib_buffer_pool_t * bp, u32 * buffers, u32 n_buffers)
+{
+  u32 head, next, slot, n_first, n_avail;
+
+  head = __atomic_load_n (&bp->ring_cons_head, __ATOMIC_RELAXED);
+  do
+    {
+      n_avail = __atomic_load_n (&bp->ring_prod_tail, __ATOMIC_ACQUIRE) - head;
+      n_buffers = clib_min (n_buffers, n_avail);
+      if (n_buffers == 0)
+	return 0;
+      next = head + n_buffers;
+    }
+  while (!__atomic_compare_exchange_n (&bp->ring_cons_head, &head, next,
+				       /* weak */ 1, __ATOMIC_ACQUIRE,
+				       __ATOMIC_RELAXED));
+
+  slot = head & bp->ring_mask;
+  n_first = clib_min (n_buffers, bp->ring_mask + 1 - slot);
+  clib_memcpy (buffers, bp->ring + slot, n_first * sizeof (u32));
+  if (n_first < n_buffers)
+    clib_memcpy (buffers + n_first, bp->ring,
+		 (n_buffers - n_first) * sizeof (u32));
+
+  while (__atomic_load_n (&bp->ring_cons_tail, __ATOMIC_RELAXED) != head)
+    CLIB_PAUSE ();
+  __atomic_store_n (&bp->ring_cons_tail, next, __ATOMIC_RELEASE);
+
+  return n_buffers;
+}
+
+/** \brief Give buffers back to a buffer pool
+
+    Through the ring when the pool has one. Pools registered without a
+    buffer size, e.g. by the dpdk plugin, keep a locked vector instead.
+*/
+static_always_inline void
+vlib_buffer_pool_give (vlib_buffer_pool_t * bp, u32 * buffers, u32 n_buffers)
+{
+  if (PREDICT_TRUE (bp->ring != 0))
+    {
+      vlib_buffer_pool_put (bp, buffers, n_buffers);
+      return;
+    }
+
+  clib_spinlock_lock_if_init (&bp->lock);
+  vec_add_aligned (bp->buffers, buffers, n_buffers, CLIB_CACHE_LINE_BYTES);
+  clib_spinlock_unlock_if_init (&bp->lock);
+}
+
+/** \brief Give remote buffers cached on a free list back to their pools */
+always_inline void
+vlib_buffer_free_list_flush_remote (vlib_buffer_free_list_t * f)
+{
+  u32 i;
+
+  for (i = 0; i < vec_len (f->remote_buffers); i++)
+    if (vec_len (f->remote_buffers[i]))
+      {
+	vlib_buffer_pool_give (vlib_buffer_pool_get (i), f->remote_buffers[i],
+			       vec_len (f->remote_buffers[i]));
+	_vec_len (f->remote_buffers[i]) = 0;
+      }
+}
+
 always_inline void
 vlib_buffer_add_to_free_list (vlib_main_t * vm,
 			      vlib_buffer_free_list_t * f,
@@ -1109,17 +1216,33 @@ vlib_buffer_add_to_free_list (vlib_main_t * vm,
   b = vlib_get_buffer (vm, buffer_index);
   if (PREDICT_TRUE (do_init))
     vlib_buffer_init_for_free_list (b, f);
+  f->n_free_ops++;
+
+  /* not ours, e.g. allocated on another numa node: send it home */
+  if (PREDICT_FALSE (b->buffer_pool_index != f->buffer_pool_index
+		     && vlib_buffer_pool_get (b->buffer_pool_index)->ring))
+    {
+      u32 **rb;
+
+      vec_validate (f->remote_buffers, b->buffer_pool_index);
+      rb = f->remote_buffers + b->buffer_pool_index;
+      vec_add1_aligned (rb[0], buffer_index, CLIB_CACHE_LINE_BYTES);
+      if (vec_len (rb[0]) >= VLIB_FRAME_SIZE)
+	vlib_buffer_free_list_flush_remote (f);
+      else
+	/* the rest goes home at the end of the main loop */
+	vm->buffer_remote_pending = 1;
+      return;
+    }
+
   vec_add1_aligned (f->buffers, buffer_index, CLIB_CACHE_LINE_BYTES);
 
   if (vec_len (f->buffers) > 4 * VLIB_FRAME_SIZE)
     {
-      clib_spinlock_lock (&bp->lock);
       /* keep last stored buffers, as they are more likely hot in the cache */
-      vec_add_aligned (bp->buffers, f->buffers, VLIB_FRAME_SIZE,
-		       CLIB_CACHE_LINE_BYTES);
+      vlib_buffer_pool_give (bp, f->buffers, VLIB_FRAME_SIZE);
       vec_delete (f->buffers, VLIB_FRAME_SIZE, 0);
       f->n_alloc -= VLIB_FRAME_SIZE;
-      clib_spinlock_unlock (&bp->lock);
     }
 }
 
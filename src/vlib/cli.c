@@ -582,8 +582,9 @@ vlib_cli_dispatch_sub_commands (vlib_main_t * vm,
 	    }
 	  else
 	    {
+	      /* barrier stats are kept per command */
 	      if (!c->is_mp_safe)
-		vlib_worker_thread_barrier_sync (vm);
+		vlib_worker_thread_barrier_sync_int (vm, c->path);
 
 	      c_error = c->function (vm, si, c);
 
@@ -74,26 +74,55 @@ vlib_clear_combined_counters (vlib_combined_counter_main_t * cm)
     }
 }
 
+void *vlib_stats_push_heap (void) __attribute__ ((weak));
+void *
+vlib_stats_push_heap (void)
+{
+  return 0;
+}
+
+void vlib_stats_pop_heap (void *, void *, int) __attribute__ ((weak));
+void
+vlib_stats_pop_heap (void *cm, void *oldheap, int is_combined)
+{
+}
+
 void
 vlib_validate_simple_counter (vlib_simple_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap = 0;
   int i;
 
+  /* Only named collections are exported via the stat segment */
+  if (cm->stat_segment_name)
+    oldheap = vlib_stats_push_heap ();
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  if (cm->stat_segment_name)
+    vlib_stats_pop_heap (cm, oldheap, 0 /* is_combined */ );
 }
 
 void
 vlib_validate_combined_counter (vlib_combined_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap = 0;
   int i;
 
+  /* Only named collections are exported via the stat segment */
+  if (cm->stat_segment_name)
+    oldheap = vlib_stats_push_heap ();
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  if (cm->stat_segment_name)
+    vlib_stats_pop_heap (cm, oldheap, 1 /* is_combined */ );
 }
 
 u32
@@ -63,6 +63,7 @@ typedef struct
                                            serialized incrementally. */
 
   char *name;			/**< The counter collection's name. */
+  char *stat_segment_name;	/**< Name in stat segment directory */
 } vlib_simple_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
@@ -183,6 +184,7 @@ typedef struct
   vlib_counter_t *value_at_last_serialize; /**< Counter values as of last serialize. */
   u32 last_incremental_serialize_index;	/**< Last counter index serialized incrementally. */
   char *name; /**< The counter collection's name. */
+  char *stat_segment_name; /**< Name in stat segment directory */
 } vlib_combined_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
@@ -314,6 +316,23 @@ void vlib_validate_combined_counter (vlib_combined_counter_main_t * cm,
 */
 #define vlib_counter_len(cm) vec_len((cm)->maxi)
 
+/** Switch to the stat segment heap before (re)allocating counters.
+    Used for collections with a stat_segment_name. Weak no-op in vlib;
+    the application provides the real version when it maps a stat
+    segment.
+    @returns - the previous heap, to be handed to vlib_stats_pop_heap
+*/
+void *vlib_stats_push_heap (void);
+
+/** Restore the previous heap and (re)publish the counter vector
+    in the stat segment directory
+    @param cm - (vlib_simple_counter_main_t *) or
+    (vlib_combined_counter_main_t *) the counter collection
+    @param oldheap - value returned by vlib_stats_push_heap
+    @param is_combined - non-zero for a combined counter collection
+*/
+void vlib_stats_pop_heap (void *cm, void *oldheap, int is_combined);
+
 serialize_function_t serialize_vlib_simple_counter_main,
   unserialize_vlib_simple_counter_main;
 serialize_function_t serialize_vlib_combined_counter_main,
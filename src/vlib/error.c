@@ -140,6 +140,18 @@ VLIB_REGISTER_NODE (misc_drop_buffers_node,static) = {
 };
 /* *INDENT-ON* */
 
+void vlib_stats_pop_heap2 (u64 *, u32, void *) __attribute__ ((weak));
+void
+vlib_stats_pop_heap2 (u64 * error_vector, u32 thread_index, void *oldheap)
+{
+}
+
+void vlib_stats_register_error_index (u8 *, u64) __attribute__ ((weak));
+void
+vlib_stats_register_error_index (u8 * name, u64 index)
+{
+}
+
 /* Reserves given number of error codes for given node. */
 void
 vlib_register_errors (vlib_main_t * vm,
@@ -148,6 +160,7 @@ vlib_register_errors (vlib_main_t * vm,
   vlib_error_main_t *em = &vm->error_main;
   vlib_node_t *n = vlib_get_node (vm, node_index);
   uword l;
+  void *oldheap;
 
   ASSERT (vlib_get_thread_index () == 0);
 
@@ -170,7 +183,10 @@ vlib_register_errors (vlib_main_t * vm,
 	       error_strings, n_errors * sizeof (error_strings[0]));
 
   /* Allocate a counter/elog type for each error. */
+  oldheap = vlib_stats_push_heap ();
   vec_validate (em->counters, l - 1);
+  vlib_stats_pop_heap2 (em->counters, vm->thread_index, oldheap);
+
   vec_validate (vm->error_elog_event_types, l - 1);
 
   /* Zero counters for re-registrations of errors. */
@@ -194,6 +210,20 @@ vlib_register_errors (vlib_main_t * vm,
 	vm->error_elog_event_types[n->error_heap_index + i] = t;
       }
   }
+
+  /* Publish the counter names in the stat segment directory */
+  {
+    u8 *error_name;
+    uword i;
+
+    for (i = 0; i < n_errors; i++)
+      {
+	error_name = format (0, "/err/%v/%s%c", n->name, error_strings[i], 0);
+	vlib_stats_register_error_index (error_name,
+					 n->error_heap_index + i);
+	vec_free (error_name);
+      }
+  }
 }
 
 static clib_error_t *
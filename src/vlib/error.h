@@ -90,6 +90,11 @@ void vlib_register_errors (struct vlib_main_t *vm,
 			   u32 node_index,
 			   u32 n_errors, char *error_strings[]);
 
+/* Stat segment hooks for error counters, weak no-ops in vlib. */
+void vlib_stats_pop_heap2 (u64 * error_vector, u32 thread_index,
+			   void *oldheap);
+void vlib_stats_register_error_index (u8 * name, u64 index);
+
 #endif /* included_vlib_error_h */
 
 /*
@@ -41,6 +41,7 @@
 #include <vppinfra/format.h>
 #include <vlib/vlib.h>
 #include <vlib/threads.h>
+#include <vlib/perf.h>
 #include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 #include <vlib/unix/unix.h>
@@ -985,7 +986,13 @@ dispatch_node (vlib_main_t * vm,
 	  n = node->function (vm, node, frame);
 	}
       else
-	n = node->function (vm, node, frame);
+	{
+	  if (PREDICT_FALSE (vm->perf_enabled))
+	    vlib_perf_dispatch_begin (vm);
+	  n = node->function (vm, node, frame);
+	  if (PREDICT_FALSE (vm->perf_enabled))
+	    vlib_perf_dispatch_end (vm, node->node_index, n);
+	}
 
       t = clib_cpu_time_now ();
 
@@ -1425,6 +1432,12 @@ dispatch_suspended_process (vlib_main_t * vm,
   return t;
 }
 
+void vlib_map_stat_segment_init (void) __attribute__ ((weak));
+void
+vlib_map_stat_segment_init (void)
+{
+}
+
 void vl_api_send_pending_rpc_requests (vlib_main_t *) __attribute__ ((weak));
 void
 vl_api_send_pending_rpc_requests (vlib_main_t * vm)
@@ -1432,6 +1445,44 @@ vl_api_send_pending_rpc_requests (vlib_main_t * vm)
 }
 
 
+vlib_adaptive_poll_config_t vlib_adaptive_poll_config = {
+  .idle_main_loops = 1024,
+  .min_sleep = 10e-6,
+  .max_sleep = 1e-3,
+  .polling_threshold_vector_length = 10,
+  .interrupt_threshold_vector_length = 5,
+};
+
+/* Pick the sleep for the next main loop from how long we've been idle */
+static_always_inline void
+vlib_adaptive_poll_update (vlib_main_t * vm, u32 n_vectors)
+{
+  vlib_adaptive_poll_config_t *apc = &vlib_adaptive_poll_config;
+  vlib_node_main_t *nm = &vm->node_main;
+
+  if (n_vectors || _vec_len (nm->pending_interrupt_node_runtime_indices)
+      || *vlib_worker_threads->wait_at_barrier)
+    {
+      vm->n_idle_wakeups += vm->idle_sleep != 0;
+      vm->idle_main_loops = 0;
+      vm->idle_sleep = 0;
+      return;
+    }
+
+  if (vm->idle_main_loops < apc->idle_main_loops)
+    {
+      vm->idle_main_loops++;
+      return;
+    }
+
+  /* By now adaptive rx mode nodes have dropped back to interrupt mode,
+     what is left polling has no interrupt to arm. */
+  if (vm->idle_sleep == 0)
+    vm->idle_sleep = apc->min_sleep;
+  else
+    vm->idle_sleep = clib_min (2 * vm->idle_sleep, apc->max_sleep);
+}
+
 static_always_inline void
 vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 {
@@ -1440,6 +1491,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   uword i;
   u64 cpu_time_now;
   vlib_frame_queue_main_t *fqm;
+  vlib_handoff_queue_main_t *hqm;
   u32 *last_node_runtime_indices = 0;
 
   /* Initialize pending node vector. */
@@ -1466,9 +1518,11 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 
   /* Pre-allocate expired nodes. */
   if (!nm->polling_threshold_vector_length)
-    nm->polling_threshold_vector_length = 10;
+    nm->polling_threshold_vector_length =
+      vlib_adaptive_poll_config.polling_threshold_vector_length;
   if (!nm->interrupt_threshold_vector_length)
-    nm->interrupt_threshold_vector_length = 5;
+    nm->interrupt_threshold_vector_length =
+      vlib_adaptive_poll_config.interrupt_threshold_vector_length;
 
   /* Start all processes. */
   if (is_main)
@@ -1487,11 +1541,16 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (PREDICT_FALSE (_vec_len (vm->pending_rpc_requests) > 0))
 	vl_api_send_pending_rpc_requests (vm);
 
+      vlib_perf_check (vm);
+
       if (!is_main)
 	{
+	  vlib_rcu_quiescent (vm);
 	  vlib_worker_thread_barrier_check ();
 	  vec_foreach (fqm, tm->frame_queue_mains)
 	    vlib_frame_queue_dequeue (vm, fqm);
+	  vec_foreach (hqm, tm->handoff_queue_mains)
+	    vlib_handoff_queue_dequeue (vm, hqm);
 	}
 
       /* Process pre-input nodes. */
@@ -1621,6 +1680,17 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (is_main && _vec_len (nm->data_from_advancing_timing_wheel) > 0)
 	goto processes_timing_wheel_data;
 
+      /* Nothing in flight on this thread, reclaim what workers are done
+         with. */
+      if (is_main)
+	vlib_rcu_poll (vm);
+      else if (PREDICT_FALSE (vlib_adaptive_poll_config.enable))
+	vlib_adaptive_poll_update (vm, vm->main_loop_vectors_processed);
+
+      /* Buffers freed this loop which belong to another numa node */
+      if (PREDICT_FALSE (vm->buffer_remote_pending))
+	vlib_buffer_flush_remote (vm);
+
       vlib_increment_main_loop_counter (vm);
 
       /* Record time stamp in case there are no enabled nodes and above
@@ -1673,6 +1743,192 @@ vlib_main_configure (vlib_main_t * vm, unformat_input_t * input)
 
 VLIB_EARLY_CONFIG_FUNCTION (vlib_main_configure, "vlib");
 
+static clib_error_t *
+adaptive_poll_parse (unformat_input_t * input,
+		     vlib_adaptive_poll_config_t * apc)
+{
+  vlib_adaptive_poll_config_t c = *apc;
+  f64 min_us = c.min_sleep * 1e6, max_us = c.max_sleep * 1e6;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "enable"))
+	c.enable = 1;
+      else if (unformat (input, "disable"))
+	c.enable = 0;
+      else if (unformat (input, "idle-loops %u", &c.idle_main_loops))
+	;
+      else if (unformat (input, "min-sleep %f", &min_us))
+	;
+      else if (unformat (input, "max-sleep %f", &max_us))
+	;
+      else if (unformat (input, "polling-threshold %u",
+			 &c.polling_threshold_vector_length))
+	;
+      else if (unformat (input, "interrupt-threshold %u",
+			 &c.interrupt_threshold_vector_length))
+	;
+      else
+	return unformat_parse_error (input);
+    }
+
+  if (min_us < 1 || max_us < min_us || max_us >= 1e6)
+    return clib_error_return (0, "need 1 <= min-sleep <= max-sleep < 1e6 us");
+  if (c.interrupt_threshold_vector_length >=
+      c.polling_threshold_vector_length)
+    return clib_error_return (0, "interrupt-threshold must be below "
+			      "polling-threshold");
+
+  c.min_sleep = min_us * 1e-6;
+  c.max_sleep = max_us * 1e-6;
+  *apc = c;
+  return 0;
+}
+
+static clib_error_t *
+adaptive_poll_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  return adaptive_poll_parse (input, &vlib_adaptive_poll_config);
+}
+
+VLIB_CONFIG_FUNCTION (adaptive_poll_config, "adaptive-poll");
+
+static clib_error_t *
+set_adaptive_poll_fn (vlib_main_t * vm, unformat_input_t * input,
+		      vlib_cli_command_t * cmd)
+{
+  vlib_adaptive_poll_config_t *apc = &vlib_adaptive_poll_config;
+  clib_error_t *error;
+  int i;
+
+  if ((error = adaptive_poll_parse (input, apc)))
+    return error;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      vlib_node_main_t *nm = &vlib_mains[i]->node_main;
+      nm->polling_threshold_vector_length =
+	apc->polling_threshold_vector_length;
+      nm->interrupt_threshold_vector_length =
+	apc->interrupt_threshold_vector_length;
+      if (!apc->enable)
+	vlib_mains[i]->idle_sleep = 0;
+    }
+  return 0;
+}
+
+/*?
+ * Tune adaptive polling. An enabled worker which has had nothing to do
+ * for '<em>idle-loops</em>' main loop iterations starts sleeping between
+ * iterations, 'min-sleep' microseconds at first and twice as long every
+ * idle iteration after that, up to 'max-sleep'. Interrupt mode
+ * interfaces wake the thread up immediately, polling ones are seen at
+ * most 'max-sleep' late, so 'max-sleep' trades wakeup latency for CPU.
+ * Adaptive rx mode interfaces switch to polling once they receive
+ * 'polling-threshold' packets per dispatch, and back to interrupt mode
+ * at or below 'interrupt-threshold'.
+ *
+ * Also available as the 'adaptive-poll' startup config section.
+ *
+ * @cliexpar
+ * @cliexcmd{set adaptive-poll enable min-sleep 10 max-sleep 500}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_adaptive_poll_cli, static) = {
+  .path = "set adaptive-poll",
+  .short_help = "set adaptive-poll [enable|disable] [idle-loops <n>] "
+    "[min-sleep <us>] [max-sleep <us>] [polling-threshold <n>] "
+    "[interrupt-threshold <n>]",
+  .function = set_adaptive_poll_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_adaptive_poll_fn (vlib_main_t * vm, unformat_input_t * input,
+		       vlib_cli_command_t * cmd)
+{
+  vlib_adaptive_poll_config_t *apc = &vlib_adaptive_poll_config;
+  f64 elapsed;
+  int i;
+
+  vlib_cli_output (vm, "adaptive poll %s, idle-loops %u, sleep %.0f-%.0fus, "
+		   "polling-threshold %u, interrupt-threshold %u",
+		   apc->enable ? "enabled" : "disabled",
+		   apc->idle_main_loops, apc->min_sleep * 1e6,
+		   apc->max_sleep * 1e6,
+		   apc->polling_threshold_vector_length,
+		   apc->interrupt_threshold_vector_length);
+
+  vlib_cli_output (vm, "%-20s%10s%12s%12s%10s%12s%12s", "Thread", "Backoff",
+		   "Sleeps", "Wakeups", "Asleep %", "Late avg us",
+		   "Late max us");
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      vlib_main_t *wm = vlib_mains[i];
+
+      elapsed = vlib_time_now (vm) - wm->idle_stats_start;
+      vlib_cli_output (vm, "%-20s%8.0fus%12llu%12llu%10.1f%12.1f%12.1f",
+		       vlib_worker_threads[i].name, wm->idle_sleep * 1e6,
+		       wm->n_idle_sleeps, wm->n_idle_wakeups,
+		       elapsed > 0 ? wm->idle_sleep_time * 100 / elapsed : 0,
+		       wm->n_idle_sleeps ?
+		       wm->idle_oversleep_time * 1e6 / wm->n_idle_sleeps : 0,
+		       wm->max_idle_oversleep * 1e6);
+    }
+  return 0;
+}
+
+/*?
+ * Show adaptive polling settings and, per worker, the current backoff,
+ * how often it slept and was woken up by work, the share of time spent
+ * asleep and how late on average and at worst it woke up compared to the
+ * sleep it asked for. Asleep % is roughly the CPU saved, late is what it
+ * cost in latency on top of the backoff itself.
+ *
+ * @cliexpar
+ * @cliexstart{show adaptive-poll}
+ * adaptive poll enabled, idle-loops 1024, sleep 10-1000us, polling-threshold 10, interrupt-threshold 5
+ * Thread                 Backoff      Sleeps     Wakeups  Asleep % Late avg us Late max us
+ * vpp_wk_0                1000us       84213          12      93.4        57.2       210.9
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_adaptive_poll_cli, static) = {
+  .path = "show adaptive-poll",
+  .short_help = "show adaptive-poll",
+  .function = show_adaptive_poll_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_adaptive_poll_fn (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  int i;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      vlib_main_t *wm = vlib_mains[i];
+      wm->n_idle_sleeps = wm->n_idle_wakeups = 0;
+      wm->idle_sleep_time = wm->idle_oversleep_time = 0;
+      wm->max_idle_oversleep = 0;
+      /* measured against the main thread clock, see show */
+      wm->idle_stats_start = vlib_time_now (vm);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_adaptive_poll_cli, static) = {
+  .path = "clear adaptive-poll",
+  .short_help = "clear adaptive-poll",
+  .function = clear_adaptive_poll_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
 static void
 dummy_queue_signal_callback (vlib_main_t * vm)
 {
@@ -1717,6 +1973,9 @@ vlib_main (vlib_main_t * volatile vm, unformat_input_t * input)
       goto done;
     }
 
+  /* Map the stat segment, counters and error vectors live there */
+  vlib_map_stat_segment_init ();
+
   /* Register static nodes so that init functions may use them. */
   vlib_register_all_static_nodes (vm);
 
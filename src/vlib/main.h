@@ -110,6 +110,9 @@ typedef struct vlib_main_t
   /* List of free-lists needing Blue Light Special announcements */
   vlib_buffer_free_list_t **buffer_announce_list;
 
+  /* Free lists hold buffers owned by another numa node's pool */
+  u8 buffer_remote_pending;
+
   /* Allocate/free buffer memory for DMA transfers, descriptor rings, etc.
      buffer memory is guaranteed to be cache-aligned. */
 
@@ -175,6 +178,9 @@ typedef struct vlib_main_t
   /* to compare with node runtime */
   u32 thread_index;
 
+  /* numa node this thread runs on, picks the local buffer pool */
+  u8 numa_node;
+
   /* List of init functions to call, setup by constructors */
   _vlib_init_function_list_elt_t *init_function_registrations;
   _vlib_init_function_list_elt_t *worker_init_function_registrations;
@@ -193,6 +199,24 @@ typedef struct vlib_main_t
   /* debugging */
   volatile int parked_at_barrier;
 
+  /* rcu epoch this thread saw at its last quiescent point */
+  volatile u64 rcu_epoch;
+
+  /* adaptive idle backoff, workers only. idle_sleep is what the next
+     idle main loop sleeps for, 0 while there is work. */
+  u32 idle_main_loops;
+  f64 idle_sleep;
+  u64 n_idle_sleeps;
+  u64 n_idle_wakeups;
+  f64 idle_sleep_time;
+  f64 idle_oversleep_time;
+  f64 max_idle_oversleep;
+  f64 idle_stats_start;
+
+  /* node profiler settings generation applied, counters open, see perf.h */
+  u32 perf_generation;
+  u8 perf_enabled;
+
   /* Attempt to do a post-mortem elog dump */
   int elog_post_mortem_dump;
 
@@ -219,6 +243,45 @@ typedef struct vlib_main_t
 /* Global main structure. */
 extern vlib_main_t vlib_global_main;
 
+/*
+ * Adaptive polling. A worker which finds no work for idle_main_loops
+ * iterations sleeps between iterations, doubling the sleep from
+ * min_sleep up to max_sleep for as long as it stays idle. Sleeps are
+ * done in epoll, so interrupt mode nodes still wake the thread up;
+ * polling nodes see their traffic up to max_sleep late. The first
+ * vector resets the backoff.
+ */
+typedef struct
+{
+  u8 enable;
+  u32 idle_main_loops;
+  f64 min_sleep;
+  f64 max_sleep;
+
+  /* adaptive rx mode nodes switch to polling at this input vector size
+     and back to interrupt mode at or below the interrupt threshold */
+  u32 polling_threshold_vector_length;
+  u32 interrupt_threshold_vector_length;
+} vlib_adaptive_poll_config_t;
+
+extern vlib_adaptive_poll_config_t vlib_adaptive_poll_config;
+
+/* Account for an idle sleep, slept may exceed what was asked for */
+always_inline void
+vlib_adaptive_poll_slept (vlib_main_t * vm, f64 requested, f64 slept)
+{
+  f64 over = slept - requested;
+
+  vm->n_idle_sleeps++;
+  vm->idle_sleep_time += slept;
+  if (over > 0)
+    {
+      vm->idle_oversleep_time += over;
+      if (over > vm->max_idle_oversleep)
+	vm->max_idle_oversleep = over;
+    }
+}
+
 void vlib_worker_loop (vlib_main_t * vm);
 
 always_inline f64
@@ -368,6 +431,9 @@ u32 vlib_app_num_thread_stacks_needed (void) __attribute__ ((weak));
 
 extern void vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n);
 
+/* Create the stat segment, if the application provides one */
+void vlib_map_stat_segment_init (void);
+
 #endif /* included_vlib_main_h */
 
 /*
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vlib_perf_h
+#define included_vlib_perf_h
+
+#include <unistd.h>
+#include <linux/perf_event.h>
+
+/*
+ * Node profiler.
+ *
+ * Each thread opens one group of hardware counters on itself with
+ * perf_event_open () and maps the counter pages, so dispatch_node ()
+ * reads them with rdpmc without entering the kernel. The counters are
+ * read before and after every sampled dispatch and the difference is
+ * charged to the node. With a sample interval of N only every Nth
+ * dispatch on a thread pays for the reads, per call and per packet
+ * figures stay exact since calls and vectors are counted for the
+ * sampled dispatches only.
+ *
+ * Where the kernel does not allow rdpmc (perf_event_paranoid, or
+ * /sys/bus/event_source/devices/cpu/rdpmc set to 0) the counters are
+ * read with read (), which works but costs a syscall per read.
+ */
+
+/* name, type, config */
+#define foreach_vlib_perf_counter					\
+_(INSTRUCTIONS, instructions, PERF_TYPE_HARDWARE,			\
+  PERF_COUNT_HW_INSTRUCTIONS)						\
+_(CYCLES, cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES)		\
+_(L1D_MISSES, l1d_misses, PERF_TYPE_HW_CACHE,				\
+  PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)		\
+  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))				\
+_(LLC_MISSES, llc_misses, PERF_TYPE_HARDWARE,				\
+  PERF_COUNT_HW_CACHE_MISSES)						\
+_(BRANCH_MISSES, branch_misses, PERF_TYPE_HARDWARE,			\
+  PERF_COUNT_HW_BRANCH_MISSES)
+
+typedef enum
+{
+#define _(E,n,t,c) VLIB_PERF_COUNTER_##E,
+  foreach_vlib_perf_counter
+#undef _
+    VLIB_PERF_N_COUNTERS,
+} vlib_perf_counter_t;
+
+typedef struct
+{
+  u64 calls;
+  u64 vectors;
+  u64 counts[VLIB_PERF_N_COUNTERS];
+} vlib_perf_node_stats_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  u8 use_rdpmc;
+  u32 countdown;
+  u8 sampling;
+
+  int fds[VLIB_PERF_N_COUNTERS];
+  struct perf_event_mmap_page *pages[VLIB_PERF_N_COUNTERS];
+  u64 start[VLIB_PERF_N_COUNTERS];
+
+  /* indexed by node index, replaced wholesale when it has to grow */
+  vlib_perf_node_stats_t *nodes;
+
+  /* why the last enable failed */
+  u8 *error;
+} vlib_perf_thread_t;
+
+typedef struct
+{
+  /* settings, applied by each thread at the top of its main loop */
+  volatile u32 generation;
+  u8 enable;
+  u32 sample_interval;
+
+  vlib_perf_thread_t *threads;
+  void *heap;
+} vlib_perf_main_t;
+
+extern vlib_perf_main_t vlib_perf_main;
+
+/* Open or close this thread's counters after a settings change */
+void vlib_perf_thread_update (vlib_main_t * vm);
+
+void vlib_perf_node_validate (vlib_perf_thread_t * pt, u32 node_index);
+
+always_inline void
+vlib_perf_check (vlib_main_t * vm)
+{
+  if (PREDICT_FALSE (vm->perf_generation != vlib_perf_main.generation))
+    vlib_perf_thread_update (vm);
+}
+
+always_inline u64
+vlib_perf_rdpmc (u32 counter)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  u32 lo, hi;
+  asm volatile ("rdpmc":"=a" (lo), "=d" (hi):"c" (counter));
+  return ((u64) hi << 32) | lo;
+#else
+  return 0;
+#endif
+}
+
+/* Current value of a self-monitored counter, see the perf_event_open(2)
+   man page for the protocol */
+always_inline u64
+vlib_perf_read_counter (vlib_perf_thread_t * pt, int i)
+{
+  struct perf_event_mmap_page *pc = pt->pages[i];
+  u32 seq, index;
+  u64 count;
+  i64 pmc;
+
+  if (PREDICT_FALSE (!pt->use_rdpmc))
+    {
+      if (read (pt->fds[i], &count, sizeof (count)) != sizeof (count))
+	return 0;
+      return count;
+    }
+
+  do
+    {
+      seq = pc->lock;
+      asm volatile ("":::"memory");
+      index = pc->index;
+      count = pc->offset;
+      if (pc->cap_user_rdpmc && index)
+	{
+	  pmc = vlib_perf_rdpmc (index - 1);
+	  /* sign extend the counter width */
+	  pmc <<= 64 - pc->pmc_width;
+	  pmc >>= 64 - pc->pmc_width;
+	  count += pmc;
+	}
+      asm volatile ("":::"memory");
+    }
+  while (pc->lock != seq);
+
+  return count;
+}
+
+always_inline void
+vlib_perf_dispatch_begin (vlib_main_t * vm)
+{
+  vlib_perf_thread_t *pt = vlib_perf_main.threads + vm->thread_index;
+  int i;
+
+  if (--pt->countdown)
+    {
+      pt->sampling = 0;
+      return;
+    }
+  pt->countdown = vlib_perf_main.sample_interval;
+  pt->sampling = 1;
+
+  for (i = 0; i < VLIB_PERF_N_COUNTERS; i++)
+    pt->start[i] = vlib_perf_read_counter (pt, i);
+}
+
+always_inline void
+vlib_perf_dispatch_end (vlib_main_t * vm, u32 node_index, uword n_vectors)
+{
+  vlib_perf_thread_t *pt = vlib_perf_main.threads + vm->thread_index;
+  vlib_perf_node_stats_t *ns;
+  u64 now[VLIB_PERF_N_COUNTERS];
+  int i;
+
+  if (!pt->sampling)
+    return;
+
+  for (i = 0; i < VLIB_PERF_N_COUNTERS; i++)
+    now[i] = vlib_perf_read_counter (pt, i);
+
+  if (PREDICT_FALSE (node_index >= vec_len (pt->nodes)))
+    vlib_perf_node_validate (pt, node_index);
+
+  ns = pt->nodes + node_index;
+  ns->calls++;
+  ns->vectors += n_vectors;
+  for (i = 0; i < VLIB_PERF_N_COUNTERS; i++)
+    ns->counts[i] += now[i] - pt->start[i];
+}
+
+#endif /* included_vlib_perf_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
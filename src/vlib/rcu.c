@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/rcu.h>
+
+vlib_rcu_main_t vlib_rcu_main;
+
+/* oldest epoch any worker may still be working in */
+static u64
+vlib_rcu_min_epoch (void)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u64 epoch, min_epoch = rm->epoch;
+  int i;
+
+  /* workers parked at the barrier hold no references */
+  if (vlib_worker_threads && vlib_worker_threads[0].recursion_level > 0)
+    return min_epoch;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      epoch = __atomic_load_n (&vlib_mains[i]->rcu_epoch, __ATOMIC_ACQUIRE);
+      if (epoch < min_epoch)
+	min_epoch = epoch;
+    }
+
+  return min_epoch;
+}
+
+void
+vlib_rcu_call (vlib_rcu_callback_t * callback, void *arg)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_pending_t *p;
+  void *oldheap;
+
+  clib_spinlock_lock_if_init (&rm->lock);
+  oldheap = clib_mem_set_heap (rm->heap);
+  vec_add2 (rm->pending, p, 1);
+  clib_mem_set_heap (oldheap);
+
+  /* full barrier, anything published before is visible to a thread
+     which has seen the new epoch */
+  p->epoch = __sync_add_and_fetch (&rm->epoch, 1);
+  p->callback = callback;
+  p->arg = arg;
+  rm->n_calls++;
+  clib_spinlock_unlock_if_init (&rm->lock);
+}
+
+static void
+vlib_rcu_free_cb (void *p)
+{
+  clib_mem_free (p);
+}
+
+void
+vlib_rcu_free (void *p)
+{
+  if (p)
+    vlib_rcu_call (vlib_rcu_free_cb, p);
+}
+
+static void
+vlib_rcu_vec_free_cb (void *v)
+{
+  vec_free (v);
+}
+
+void
+vlib_rcu_vec_free (void *v)
+{
+  if (v)
+    vlib_rcu_call (vlib_rcu_vec_free_cb, v);
+}
+
+void
+vlib_rcu_poll_internal (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_pending_t *p, *runnable;
+  u64 min_epoch;
+  u32 n = 0;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  min_epoch = vlib_rcu_min_epoch ();
+
+  clib_spinlock_lock_if_init (&rm->lock);
+  vec_foreach (p, rm->pending)
+  {
+    if (p->epoch > min_epoch)
+      break;
+    n++;
+  }
+  if (n == 0)
+    {
+      clib_spinlock_unlock_if_init (&rm->lock);
+      return;
+    }
+  /* callbacks may defer more work, run them from a private vector */
+  runnable = rm->runnable;
+  rm->runnable = 0;
+  vec_add (runnable, rm->pending, n);
+  vec_delete (rm->pending, n, 0);
+  clib_spinlock_unlock_if_init (&rm->lock);
+
+  vec_foreach (p, runnable) p->callback (p->arg);
+
+  rm->n_callbacks += n;
+  vec_reset_length (runnable);
+  if (rm->runnable == 0)
+    rm->runnable = runnable;
+  else
+    vec_free (runnable);
+}
+
+void
+vlib_rcu_synchronize (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  f64 t_start, now, deadline;
+  u64 target;
+  int i;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (vec_len (vlib_mains) < 2)
+    return;
+
+  /* workers parked at the barrier are as quiescent as it gets */
+  if (vlib_worker_threads[0].recursion_level > 0)
+    return;
+
+  target = __sync_add_and_fetch (&rm->epoch, 1);
+  t_start = now = vlib_time_now (vm);
+  deadline = now + BARRIER_SYNC_TIMEOUT;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    while (__atomic_load_n (&vlib_mains[i]->rcu_epoch, __ATOMIC_ACQUIRE) <
+	   target)
+      {
+	if ((now = vlib_time_now (vm)) > deadline)
+	  {
+	    fformat (stderr, "%s: worker thread deadlock\n", __FUNCTION__);
+	    os_panic ();
+	  }
+      }
+
+  now = vlib_time_now (vm);
+  rm->n_synchronize++;
+  rm->synchronize_time += now - t_start;
+  if (now - t_start > rm->max_synchronize_time)
+    rm->max_synchronize_time = now - t_start;
+}
+
+void
+vlib_rcu_flush (vlib_main_t * vm)
+{
+  vlib_rcu_synchronize (vm);
+  vlib_rcu_poll (vm);
+}
+
+static clib_error_t *
+show_rcu_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  int i;
+
+  vlib_cli_output (vm, "epoch %llu, %u callbacks pending", rm->epoch,
+		   vec_len (rm->pending));
+  vlib_cli_output (vm, "deferred %llu, completed %llu", rm->n_calls,
+		   rm->n_callbacks);
+  vlib_cli_output (vm, "synchronize %llu, avg %.2f us, max %.2f us",
+		   rm->n_synchronize,
+		   rm->n_synchronize ?
+		   rm->synchronize_time * 1e6 / rm->n_synchronize : 0,
+		   rm->max_synchronize_time * 1e6);
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    vlib_cli_output (vm, "  thread %d: epoch %llu (%llu behind)", i,
+		     vlib_mains[i]->rcu_epoch,
+		     rm->epoch - vlib_mains[i]->rcu_epoch);
+
+  return 0;
+}
+
+/*?
+ * Show the state of deferred reclamation: the current epoch, how many
+ * deferred frees are waiting for their grace period and how far each
+ * worker is behind.
+ *
+ * @cliexpar
+ * @cliexstart{show rcu}
+ * epoch 1234, 0 callbacks pending
+ * deferred 1234, completed 1234
+ * synchronize 2, avg 3.10 us, max 4.02 us
+ *   thread 1: epoch 1234 (0 behind)
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_rcu_command, static) = {
+  .path = "show rcu",
+  .short_help = "show rcu",
+  .function = show_rcu_command_fn,
+};
+/* *INDENT-ON* */
+
+typedef struct
+{
+  u32 n_run;
+  u32 next;
+  u32 n_out_of_order;
+} vlib_rcu_test_main_t;
+
+static vlib_rcu_test_main_t vlib_rcu_test_main;
+
+static void
+vlib_rcu_test_cb (void *arg)
+{
+  vlib_rcu_test_main_t *tm = &vlib_rcu_test_main;
+
+  if (pointer_to_uword (arg) != tm->next)
+    tm->n_out_of_order++;
+  tm->next = pointer_to_uword (arg) + 1;
+  tm->n_run++;
+}
+
+static clib_error_t *
+test_rcu_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  vlib_rcu_test_main_t *tm = &vlib_rcu_test_main;
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u64 n_callbacks, n_synchronize;
+  u32 i, n_calls = 100;
+  int failed = 0;
+  u8 *v = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "calls %d", &n_calls))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  /* start from a clean slate, nothing queued by anyone else */
+  vlib_rcu_flush (vm);
+
+  memset (tm, 0, sizeof (*tm));
+  n_callbacks = rm->n_callbacks;
+  n_synchronize = rm->n_synchronize;
+
+  for (i = 0; i < n_calls; i++)
+    vlib_rcu_call (vlib_rcu_test_cb, uword_to_pointer (i, void *));
+  vlib_rcu_free (clib_mem_alloc (64));
+  vec_validate (v, 63);
+  vlib_rcu_vec_free (v);
+
+  if (tm->n_run)
+    {
+      vlib_cli_output (vm, "FAILED: %u callbacks ran before a grace period",
+		       tm->n_run);
+      failed = 1;
+    }
+  if (vec_len (rm->pending) != n_calls + 2)
+    {
+      vlib_cli_output (vm, "FAILED: %u callbacks pending, expected %u",
+		       vec_len (rm->pending), n_calls + 2);
+      failed = 1;
+    }
+
+  vlib_rcu_synchronize (vm);
+  if (vec_len (vlib_mains) > 1 && vlib_worker_threads[0].recursion_level == 0
+      && rm->n_synchronize != n_synchronize + 1)
+    {
+      vlib_cli_output (vm, "FAILED: synchronize did not wait for workers");
+      failed = 1;
+    }
+  vlib_rcu_poll (vm);
+
+  if (tm->n_run != n_calls || rm->n_callbacks != n_callbacks + n_calls + 2)
+    {
+      vlib_cli_output (vm, "FAILED: %u of %u callbacks ran after a "
+		       "grace period", tm->n_run, n_calls);
+      failed = 1;
+    }
+  if (tm->n_out_of_order)
+    {
+      vlib_cli_output (vm, "FAILED: %u callbacks ran out of order",
+		       tm->n_out_of_order);
+      failed = 1;
+    }
+  if (vec_len (rm->pending))
+    {
+      vlib_cli_output (vm, "FAILED: %u callbacks still pending",
+		       vec_len (rm->pending));
+      failed = 1;
+    }
+
+  vlib_cli_output (vm, "rcu tests: %s", failed ? "failed" : "passed");
+  return 0;
+}
+
+/*?
+ * Queue deferred callbacks and frees, check that none of them runs before
+ * a grace period and that all of them run, in order, after one.
+ *
+ * @cliexpar
+ * @cliexstart{test rcu calls 100}
+ * rcu tests: passed
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_rcu_command, static) = {
+  .path = "test rcu",
+  .short_help = "test rcu [calls <n>]",
+  .function = test_rcu_command_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+vlib_rcu_init (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+
+  clib_spinlock_init (&rm->lock);
+  rm->heap = clib_mem_get_heap ();
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vlib_rcu_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
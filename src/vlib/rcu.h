@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vlib_rcu_h
+#define included_vlib_rcu_h
+
+#include <vppinfra/lock.h>
+
+/*
+ * Epoch based deferred reclamation.
+ *
+ * No thread holds on to control plane data across iterations of its main
+ * loop, so the end of a loop iteration is a quiescent point. A writer
+ * publishes new data with a single store and hands whatever the old
+ * data was to vlib_rcu_call (). The callback runs on the main thread
+ * once every worker has been through a quiescent point since, i.e. when
+ * no worker can still be looking at the old data.
+ *
+ * This is what a barrier sync around the update buys, minus stopping the
+ * workers. Like the barrier, it says nothing about buffers sitting in
+ * handoff frame queues.
+ */
+
+typedef void (vlib_rcu_callback_t) (void *arg);
+
+typedef struct
+{
+  u64 epoch;
+  vlib_rcu_callback_t *callback;
+  void *arg;
+} vlib_rcu_pending_t;
+
+typedef struct
+{
+  /* bumped by every writer, threads copy it at quiescent points */
+  volatile u64 epoch;
+
+  /* deferred callbacks, in epoch order */
+  vlib_rcu_pending_t *pending;
+  vlib_rcu_pending_t *runnable;
+  clib_spinlock_t lock;
+  /* workers may defer too, keep the vectors on the main heap */
+  void *heap;
+
+  /* stats */
+  u64 n_calls;
+  u64 n_callbacks;
+  u64 n_synchronize;
+  f64 synchronize_time;
+  f64 max_synchronize_time;
+} vlib_rcu_main_t;
+
+extern vlib_rcu_main_t vlib_rcu_main;
+
+/** \brief Mark a quiescent point for the calling thread
+    Called by the main loop, nothing else should need it.
+*/
+always_inline void
+vlib_rcu_quiescent (vlib_main_t * vm)
+{
+  u64 epoch = __atomic_load_n (&vlib_rcu_main.epoch, __ATOMIC_ACQUIRE);
+  __atomic_store_n (&vm->rcu_epoch, epoch, __ATOMIC_RELEASE);
+}
+
+/** \brief Run a callback once no thread can see data unpublished so far
+    @param callback - function to run on the main thread
+    @param arg - its argument, typically the old data
+*/
+void vlib_rcu_call (vlib_rcu_callback_t * callback, void *arg);
+
+/** \brief clib_mem_free () once no thread can see the memory */
+void vlib_rcu_free (void *p);
+
+/** \brief vec_free () once no thread can see the vector */
+void vlib_rcu_vec_free (void *v);
+
+/** \brief Wait until every worker has been through a quiescent point
+    Does not stop the workers. Main thread only.
+*/
+void vlib_rcu_synchronize (vlib_main_t * vm);
+
+/** \brief Wait for a grace period and run every pending callback
+    For teardown paths which free what the callbacks refer to.
+*/
+void vlib_rcu_flush (vlib_main_t * vm);
+
+void vlib_rcu_poll_internal (vlib_main_t * vm);
+
+/** \brief Run callbacks whose grace period has expired, main loop only */
+always_inline void
+vlib_rcu_poll (vlib_main_t * vm)
+{
+  if (PREDICT_FALSE (vec_len (vlib_rcu_main.pending) > 0))
+    vlib_rcu_poll_internal (vm);
+}
+
+#endif /* included_vlib_rcu_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -288,7 +288,7 @@ sort_registrations_by_no_clone (void *a0, void *a1)
 	  - ((i32) ((*tr1)->no_data_structure_clone)));
 }
 
-static uword *
+uword *
 clib_sysfs_list_to_bitmap (char *filename)
 {
   FILE *fp;
@@ -318,6 +318,31 @@ clib_sysfs_list_to_bitmap (char *filename)
 
 /* Called early in the init sequence */
 
+/* numa node of a cpu, 0 when sysfs doesn't tell */
+static u8
+vlib_cpu_numa_node (u32 cpu)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  uword *cpus, node;
+  u8 *path = 0;
+  u8 rv = 0;
+
+  /* *INDENT-OFF* */
+  clib_bitmap_foreach (node, tm->cpu_socket_bitmap, ({
+    vec_reset_length (path);
+    path = format (path, "/sys/devices/system/node/node%u/cpulist%c",
+                   node, 0);
+    cpus = clib_sysfs_list_to_bitmap ((char *) path);
+    if (clib_bitmap_get (cpus, cpu))
+      rv = node;
+    clib_bitmap_free (cpus);
+  }));
+  /* *INDENT-ON* */
+
+  vec_free (path);
+  return rv;
+}
+
 clib_error_t *
 vlib_thread_init (vlib_main_t * vm)
 {
@@ -379,6 +404,7 @@ vlib_thread_init (vlib_main_t * vm)
       CPU_SET (tm->main_lcore, &cpuset);
       pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t), &cpuset);
     }
+  vm->numa_node = vlib_cpu_numa_node (tm->main_lcore);
 
   /* as many threads as stacks... */
   vec_validate_aligned (vlib_worker_threads, vec_len (vlib_thread_stacks) - 1,
@@ -691,6 +717,10 @@ vlib_launch_thread_int (void *fp, vlib_worker_thread_t * w, unsigned lcore_id)
   void *(*fp_arg) (void *) = fp;
 
   w->lcore_id = lcore_id;
+  /* workers pick their buffer pool by numa node */
+  if (w - vlib_worker_threads < vec_len (vlib_mains))
+    vlib_mains[w - vlib_worker_threads]->numa_node =
+      vlib_cpu_numa_node (lcore_id);
   if (tm->cb.vlib_launch_thread_cb && !w->registration->use_pthreads)
     return tm->cb.vlib_launch_thread_cb (fp, (void *) w, lcore_id);
   else
@@ -916,8 +946,11 @@ start_workers (vlib_main_t * vm)
 	      clib_mem_set_heap (oldheap);
 	      vec_add1_aligned (vlib_mains, vm_clone, CLIB_CACHE_LINE_BYTES);
 
+	      oldheap = vlib_stats_push_heap ();
 	      vm_clone->error_main.counters = vec_dup_aligned
 		(vlib_mains[0]->error_main.counters, CLIB_CACHE_LINE_BYTES);
+	      vlib_stats_pop_heap2 (vm_clone->error_main.counters,
+				    vm_clone->thread_index, oldheap);
 	      vm_clone->error_main.counters_last_clear = vec_dup_aligned
 		(vlib_mains[0]->error_main.counters_last_clear,
 		 CLIB_CACHE_LINE_BYTES);
@@ -937,6 +970,10 @@ start_workers (vlib_main_t * vm)
                             fl_clone[0] = fl_orig[0];
                             fl_clone->buffers = 0;
                             fl_clone->n_alloc = 0;
+                            fl_clone->remote_buffers = 0;
+                            fl_clone->n_alloc_ops = fl_clone->n_free_ops = 0;
+                            fl_clone->last_alloc_ops = 0;
+                            fl_clone->last_free_ops = 0;
                           }));
 /* *INDENT-ON* */
 
@@ -1091,7 +1128,11 @@ vlib_worker_thread_node_refork (void)
   clib_memcpy (&vm_clone->error_main, &vm->error_main,
 	       sizeof (vm->error_main));
   j = vec_len (vm->error_main.counters) - 1;
+
+  void *oldheap = vlib_stats_push_heap ();
   vec_validate_aligned (old_counters, j, CLIB_CACHE_LINE_BYTES);
+  vlib_stats_pop_heap2 (old_counters, vm_clone->thread_index, oldheap);
+
   vec_validate_aligned (old_counters_all_clear, j, CLIB_CACHE_LINE_BYTES);
   vm_clone->error_main.counters = old_counters;
   vm_clone->error_main.counters_last_clear = old_counters_all_clear;
@@ -1435,8 +1476,43 @@ vlib_worker_thread_fork_fixup (vlib_fork_fixup_t which)
 #define BARRIER_MINIMUM_OPEN_FACTOR 3
 #endif
 
+/* caller which closed the barrier, stats are charged to it on release */
+static const char *barrier_outer_caller;
+
+static void
+barrier_stats_update (const char *caller, f64 t_closed)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_barrier_caller_stats_t *bs;
+  uword *p;
+  u64 us;
+  u32 bucket;
+
+  p = hash_get (tm->barrier_stats_by_caller, pointer_to_uword (caller));
+  if (p)
+    bs = vec_elt_at_index (tm->barrier_stats, p[0]);
+  else
+    {
+      vec_add2 (tm->barrier_stats, bs, 1);
+      bs->caller = caller;
+      hash_set (tm->barrier_stats_by_caller, pointer_to_uword (caller),
+		bs - tm->barrier_stats);
+    }
+
+  bs->count++;
+  bs->total_closed += t_closed;
+  if (t_closed > bs->max_closed)
+    bs->max_closed = t_closed;
+
+  us = t_closed * 1e6;
+  bucket = us ? min_log2 (us) + 1 : 0;
+  if (bucket >= VLIB_BARRIER_HIST_N_BUCKETS)
+    bucket = VLIB_BARRIER_HIST_N_BUCKETS - 1;
+  bs->hist[bucket]++;
+}
+
 void
-vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
+vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *caller)
 {
   f64 deadline;
   f64 now;
@@ -1450,6 +1526,7 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
 
   ASSERT (vlib_get_thread_index () == 0);
 
+  vlib_worker_threads[0].barrier_caller = caller;
   count = vec_len (vlib_mains) - 1;
 
   /* Record entry relative to last close */
@@ -1464,6 +1541,7 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
     }
 
   vlib_worker_threads[0].barrier_sync_count++;
+  barrier_outer_caller = caller;
 
   /* Enforce minimum barrier open time to minimize packet loss */
   ASSERT (vm->barrier_no_close_before <= (now + BARRIER_MINIMUM_OPEN_LIMIT));
@@ -1566,6 +1644,8 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
   t_closed_total = now - vm->barrier_epoch;
 
+  barrier_stats_update (barrier_outer_caller, t_closed_total);
+
   minimum_open = t_closed_total * BARRIER_MINIMUM_OPEN_FACTOR;
 
   if (minimum_open > BARRIER_MINIMUM_OPEN_LIMIT)
@@ -1775,6 +1855,209 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
   return (fqm - tm->frame_queue_mains);
 }
 
+#define HANDOFF_QUEUE_N_SLOTS 4096
+
+/*
+ * Create a set of handoff queues delivering to node_index, one per
+ * receiving thread. Like frame queues, call with the workers stopped.
+ */
+u32
+vlib_handoff_queue_main_init (u32 node_index, u32 n_slots,
+			      vlib_handoff_queue_policy_t policy)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  vlib_handoff_queue_t *hq;
+  int i;
+
+  if (n_slots == 0)
+    n_slots = HANDOFF_QUEUE_N_SLOTS;
+  n_slots = max_pow2 (clib_max (n_slots, VLIB_FRAME_SIZE));
+
+  vec_add2 (tm->handoff_queue_mains, hqm, 1);
+
+  hqm->node_index = node_index;
+  hqm->policy = policy;
+  hqm->wait_timeout = 100e-6;
+
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      hq = clib_mem_alloc_aligned (sizeof (*hq), CLIB_CACHE_LINE_BYTES);
+      memset (hq, 0, sizeof (*hq));
+      hq->size = n_slots;
+      hq->vector_threshold = VLIB_FRAME_SIZE;
+      vec_validate_aligned (hq->ring, n_slots - 1, CLIB_CACHE_LINE_BYTES);
+      vec_validate_aligned (hq->senders, tm->n_vlib_mains - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_add1 (hqm->queues, hq);
+    }
+
+  vec_validate (hqm->pending, tm->n_vlib_mains - 1);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    vec_validate (hqm->pending[i], tm->n_vlib_mains - 1);
+
+  return (hqm - tm->handoff_queue_mains);
+}
+
+/*
+ * Hand buffers to another thread. Returns how many were enqueued, the
+ * rest did not fit and have been freed.
+ */
+u32
+vlib_handoff_queue_enqueue (vlib_main_t * vm, u32 handoff_queue_index,
+			    u32 thread_index, u32 * buffers, u32 n_buffers)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  vlib_handoff_queue_t *hq;
+  vlib_handoff_queue_sender_t *sender;
+  u32 head, n_free, n, slot, n_first, n_left = n_buffers;
+  u64 deadline = 0;
+
+  hqm = vec_elt_at_index (tm->handoff_queue_mains, handoff_queue_index);
+  hq = hqm->queues[thread_index];
+  sender = vec_elt_at_index (hq->senders, vm->thread_index);
+  sender->enqueues++;
+
+  while (n_left)
+    {
+      head = __atomic_load_n (&hq->prod_head, __ATOMIC_RELAXED);
+      n_free = hq->size -
+	(head - __atomic_load_n (&hq->cons_tail, __ATOMIC_ACQUIRE));
+
+      if (PREDICT_FALSE (n_free == 0))
+	{
+	  u64 now = clib_cpu_time_now ();
+
+	  if (hqm->policy != VLIB_HANDOFF_QUEUE_POLICY_WAIT)
+	    break;
+	  if (deadline == 0)
+	    {
+	      sender->wait_events++;
+	      deadline = now + hqm->wait_timeout *
+		vm->clib_time.clocks_per_second;
+	    }
+	  else if (now > deadline)
+	    break;
+	  if (vm->thread_index)
+	    vlib_worker_thread_barrier_check ();
+	  CLIB_PAUSE ();
+	  continue;
+	}
+
+      n = clib_min (n_left, n_free);
+      if (!__atomic_compare_exchange_n (&hq->prod_head, &head, head + n,
+					/* weak */ 1, __ATOMIC_ACQUIRE,
+					__ATOMIC_RELAXED))
+	continue;
+
+      slot = head & (hq->size - 1);
+      n_first = clib_min (n, hq->size - slot);
+      clib_memcpy (hq->ring + slot, buffers, n_first * sizeof (u32));
+      if (n_first < n)
+	clib_memcpy (hq->ring, buffers + n_first, (n - n_first) * sizeof (u32));
+
+      /* publish in claim order */
+      while (__atomic_load_n (&hq->prod_tail, __ATOMIC_RELAXED) != head)
+	CLIB_PAUSE ();
+      __atomic_store_n (&hq->prod_tail, head + n, __ATOMIC_RELEASE);
+
+      buffers += n;
+      n_left -= n;
+    }
+
+  sender->enqueue_vectors += n_buffers - n_left;
+
+  if (PREDICT_FALSE (n_left))
+    {
+      sender->congestion_drops += n_left;
+      vlib_buffer_free (vm, buffers, n_left);
+    }
+
+  return n_buffers - n_left;
+}
+
+/*
+ * Hand each buffer to the thread given for it, one enqueue per receiving
+ * thread. Returns the number of buffers dropped for congestion.
+ */
+u32
+vlib_handoff_queue_enqueue_to_threads (vlib_main_t * vm,
+				       u32 handoff_queue_index,
+				       u32 * buffers, u16 * thread_indices,
+				       u32 n_buffers)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  u32 **pending, i, n_enq = 0;
+
+  hqm = vec_elt_at_index (tm->handoff_queue_mains, handoff_queue_index);
+  pending = hqm->pending[vm->thread_index];
+
+  for (i = 0; i < n_buffers; i++)
+    vec_add1 (pending[thread_indices[i]], buffers[i]);
+
+  for (i = 0; i < vec_len (pending); i++)
+    if (vec_len (pending[i]))
+      {
+	n_enq += vlib_handoff_queue_enqueue (vm, handoff_queue_index, i,
+					     pending[i], vec_len (pending[i]));
+	_vec_len (pending[i]) = 0;
+      }
+
+  return n_buffers - n_enq;
+}
+
+/*
+ * Move whatever the handoff queue holds, up to vector_threshold buffers,
+ * into frames for the queue's node.
+ */
+int
+vlib_handoff_queue_dequeue (vlib_main_t * vm, vlib_handoff_queue_main_t * hqm)
+{
+  vlib_handoff_queue_t *hq = hqm->queues[vm->thread_index];
+  u32 tail, n_avail, n_left, n, slot, n_first, bucket;
+  vlib_frame_t *f;
+  u32 *to;
+
+  tail = hq->cons_tail;
+  n_avail = __atomic_load_n (&hq->prod_tail, __ATOMIC_ACQUIRE) - tail;
+  if (n_avail == 0)
+    return 0;
+
+  bucket = ((u64) n_avail * VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS) / hq->size;
+  if (bucket >= VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS)
+    bucket = VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS - 1;
+  hq->occupancy_histogram[bucket]++;
+
+  n_left = clib_min (n_avail, hq->vector_threshold);
+  hq->dequeue_vectors += n_left;
+  hq->dequeues++;
+
+  while (n_left)
+    {
+      n = clib_min (n_left, VLIB_FRAME_SIZE);
+      f = vlib_get_frame_to_node (vm, hqm->node_index);
+      to = vlib_frame_vector_args (f);
+
+      slot = tail & (hq->size - 1);
+      n_first = clib_min (n, hq->size - slot);
+      clib_memcpy (to, hq->ring + slot, n_first * sizeof (u32));
+      if (n_first < n)
+	clib_memcpy (to + n_first, hq->ring, (n - n_first) * sizeof (u32));
+
+      f->n_vectors = n;
+      vlib_put_frame_to_node (vm, hqm->node_index, f);
+      tail += n;
+      n_left -= n;
+    }
+
+  /* give the slots back to the senders */
+  __atomic_store_n (&hq->cons_tail, tail, __ATOMIC_RELEASE);
+
+  return 1;
+}
+
 int
 vlib_thread_cb_register (struct vlib_main_t *vm, vlib_thread_callbacks_t * cb)
 {
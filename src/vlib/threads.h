@@ -118,8 +118,8 @@ typedef struct
   vlib_thread_registration_t *registration;
   u8 *name;
   u64 barrier_sync_count;
-#ifdef BARRIER_TRACING
   const char *barrier_caller;
+#ifdef BARRIER_TRACING
   const char *barrier_context;
 #endif
   volatile u32 *node_reforks_required;
@@ -171,6 +171,70 @@ typedef struct
   frame_queue_nelt_counter_t *frame_queue_histogram;
 } vlib_frame_queue_main_t;
 
+/*
+ * Handoff queues
+ *
+ * Unlike frame queues, which move whole frame sized elements, a handoff
+ * queue is a ring of buffer indices. Senders enqueue batches of any size
+ * without locks, the receiving worker dequeues whatever is there into
+ * frames for the queue's node. When the ring is full the queue's policy
+ * decides whether senders drop, or wait for a bounded time and then drop.
+ */
+
+typedef enum
+{
+  VLIB_HANDOFF_QUEUE_POLICY_DROP,
+  VLIB_HANDOFF_QUEUE_POLICY_WAIT,
+} vlib_handoff_queue_policy_t;
+
+#define VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS 16
+
+/* one per sending thread, so senders never share a cache line */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 enqueues;
+  u64 enqueue_vectors;
+  u64 congestion_drops;
+  u64 wait_events;
+} vlib_handoff_queue_sender_t;
+
+typedef struct
+{
+  /* enqueue side, shared by all senders */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 prod_head;
+  volatile u32 prod_tail;
+
+  /* dequeue side, receiving thread only */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 cons_tail;
+  u64 dequeues;
+  u64 dequeue_vectors;
+  /* ring occupancy seen by non-empty dequeues, in 1/16ths of the ring */
+  u64 occupancy_histogram[VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS];
+
+  /* read-only, constant, shared */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  u32 *ring;
+  u32 size;
+  u32 vector_threshold;
+  vlib_handoff_queue_sender_t *senders;
+}
+vlib_handoff_queue_t;
+
+typedef struct
+{
+  u32 node_index;
+  vlib_handoff_queue_policy_t policy;
+  /* how long a sender waits for room under the wait policy */
+  f64 wait_timeout;
+  /* queue per receiving thread */
+  vlib_handoff_queue_t **queues;
+  /* per sending thread, buffers sorted by receiving thread */
+  u32 ***pending;
+} vlib_handoff_queue_main_t;
+
 typedef struct
 {
   uword node_index;
@@ -188,8 +252,25 @@ int vlib_frame_queue_enqueue (vlib_main_t * vm, u32 node_runtime_index,
 int
 vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm);
 
+u32 vlib_handoff_queue_main_init (u32 node_index, u32 n_slots,
+				  vlib_handoff_queue_policy_t policy);
+
+u32 vlib_handoff_queue_enqueue (vlib_main_t * vm, u32 handoff_queue_index,
+				u32 thread_index, u32 * buffers,
+				u32 n_buffers);
+
+u32 vlib_handoff_queue_enqueue_to_threads (vlib_main_t * vm,
+					   u32 handoff_queue_index,
+					   u32 * buffers, u16 * thread_indices,
+					   u32 n_buffers);
+
+int vlib_handoff_queue_dequeue (vlib_main_t * vm,
+				vlib_handoff_queue_main_t * hqm);
+
 void vlib_worker_thread_node_runtime_update (void);
 
+uword *clib_sysfs_list_to_bitmap (char *filename);
+
 void vlib_create_worker_threads (vlib_main_t * vm, int n,
 				 void (*thread_function) (void *));
 
@@ -206,14 +287,23 @@ u32 vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts);
 #define BARRIER_SYNC_TIMEOUT (1.0)
 #endif
 
-#ifdef BARRIER_TRACING
-#define vlib_worker_thread_barrier_sync(X) {vlib_worker_threads[0].barrier_caller=__FUNCTION__;vlib_worker_thread_barrier_sync_int(X);}
-#else
-#define vlib_worker_thread_barrier_sync(X) vlib_worker_thread_barrier_sync_int(X)
-#endif
+#define vlib_worker_thread_barrier_sync(X) \
+  vlib_worker_thread_barrier_sync_int (X, __FUNCTION__)
 
+/* closed time histogram, bucket i counts syncs shorter than 2^i us */
+#define VLIB_BARRIER_HIST_N_BUCKETS 16
 
-void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm);
+typedef struct
+{
+  const char *caller;
+  u64 count;
+  f64 total_closed;
+  f64 max_closed;
+  u64 hist[VLIB_BARRIER_HIST_N_BUCKETS];
+} vlib_barrier_caller_stats_t;
+
+void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm,
+					  const char *caller);
 void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 
@@ -333,6 +423,7 @@ typedef struct
 
   /* Worker handoff queues */
   vlib_frame_queue_main_t *frame_queue_mains;
+  vlib_handoff_queue_main_t *handoff_queue_mains;
 
   /* worker thread initialization barrier */
   volatile u32 worker_thread_release;
@@ -346,6 +437,10 @@ typedef struct
   /* callbacks */
   vlib_thread_callbacks_t cb;
   int extern_thread_mgmt;
+
+  /* per caller barrier sync stats, hashed by caller name pointer */
+  vlib_barrier_caller_stats_t *barrier_stats;
+  uword *barrier_stats_by_caller;
 } vlib_thread_main_t;
 
 extern vlib_thread_main_t vlib_thread_main;
@@ -575,6 +575,311 @@ VLIB_CLI_COMMAND (cmd_test_frame_queue_threshold,static) = {
 /* *INDENT-ON* */
 
 
+static u8 *
+format_handoff_queue_policy (u8 * s, va_list * args)
+{
+  vlib_handoff_queue_policy_t policy = va_arg (*args, int);
+
+  switch (policy)
+    {
+    case VLIB_HANDOFF_QUEUE_POLICY_DROP:
+      return format (s, "drop");
+    case VLIB_HANDOFF_QUEUE_POLICY_WAIT:
+      return format (s, "wait");
+    }
+  return format (s, "unknown");
+}
+
+static clib_error_t *
+show_handoff_queue_fn (vlib_main_t * vm, unformat_input_t * input,
+		       vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  vlib_handoff_queue_t *hq;
+  vlib_handoff_queue_sender_t *sender;
+  u8 *line = 0;
+  u32 thread_index;
+  int i;
+
+  if (vec_len (tm->handoff_queue_mains) == 0)
+    {
+      vlib_cli_output (vm, "No handoff queues exist");
+      return 0;
+    }
+
+  vec_foreach (hqm, tm->handoff_queue_mains)
+  {
+    vlib_cli_output (vm, "%d: node %U policy %U wait-timeout %.0fus",
+		     hqm - tm->handoff_queue_mains, format_vlib_node_name, vm,
+		     hqm->node_index, format_handoff_queue_policy,
+		     hqm->policy, hqm->wait_timeout * 1e6);
+
+    for (thread_index = 1; thread_index < vec_len (hqm->queues);
+	 thread_index++)
+      {
+	hq = hqm->queues[thread_index];
+	vlib_cli_output (vm, "  to thread %d: size %u occupancy %u "
+			 "dequeues %lld vectors %lld threshold %u",
+			 thread_index, hq->size,
+			 hq->prod_tail - hq->cons_tail, hq->dequeues,
+			 hq->dequeue_vectors, hq->vector_threshold);
+
+	vec_reset_length (line);
+	for (i = 0; i < VLIB_HANDOFF_QUEUE_HIST_N_BUCKETS; i++)
+	  line = format (line, " %lld", hq->occupancy_histogram[i]);
+	vlib_cli_output (vm, "    occupancy /16ths:%v", line);
+
+	vec_foreach (sender, hq->senders)
+	{
+	  if (sender->enqueues == 0)
+	    continue;
+	  vlib_cli_output (vm, "    from thread %d: enqueues %lld "
+			   "vectors %lld congestion-drops %lld waits %lld",
+			   sender - hq->senders, sender->enqueues,
+			   sender->enqueue_vectors, sender->congestion_drops,
+			   sender->wait_events);
+	}
+      }
+  }
+
+  vec_free (line);
+  return 0;
+}
+
+/*?
+ * Display the worker handoff queues: per receiving thread occupancy and
+ * its histogram, and per sending thread enqueue, congestion drop and
+ * wait counts.
+ *
+ * The occupancy histogram counts how full each queue was, in sixteenths
+ * of its size, every time its worker found it non-empty. Weight in the
+ * top buckets means the receiving worker is the bottleneck.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_handoff_queue_command, static) = {
+  .path = "show handoff queue",
+  .short_help = "show handoff queue",
+  .function = show_handoff_queue_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_handoff_queue_fn (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  vlib_handoff_queue_t *hq;
+  vlib_handoff_queue_sender_t *sender;
+  u32 thread_index;
+
+  vec_foreach (hqm, tm->handoff_queue_mains)
+  {
+    for (thread_index = 0; thread_index < vec_len (hqm->queues);
+	 thread_index++)
+      {
+	hq = hqm->queues[thread_index];
+	hq->dequeues = hq->dequeue_vectors = 0;
+	memset (hq->occupancy_histogram, 0,
+		sizeof (hq->occupancy_histogram));
+	vec_foreach (sender, hq->senders)
+	{
+	  sender->enqueues = sender->enqueue_vectors = 0;
+	  sender->congestion_drops = sender->wait_events = 0;
+	}
+      }
+  }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_handoff_queue_command, static) = {
+  .path = "clear handoff queue",
+  .short_help = "clear handoff queue",
+  .function = clear_handoff_queue_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_handoff_queue_fn (vlib_main_t * vm, unformat_input_t * input,
+		      vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_handoff_queue_main_t *hqm;
+  clib_error_t *error = NULL;
+  u32 index = ~0, threshold = 0, timeout_us = ~0, i;
+  int policy = -1;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "index %u", &index))
+	;
+      else if (unformat (line_input, "policy drop"))
+	policy = VLIB_HANDOFF_QUEUE_POLICY_DROP;
+      else if (unformat (line_input, "policy wait"))
+	policy = VLIB_HANDOFF_QUEUE_POLICY_WAIT;
+      else if (unformat (line_input, "wait-timeout %u", &timeout_us))
+	;
+      else if (unformat (line_input, "threshold %u", &threshold))
+	;
+      else
+	{
+	  error = clib_error_return (0, "parse error: '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (index >= vec_len (tm->handoff_queue_mains))
+    {
+      error = clib_error_return (0, "expecting valid handoff queue index");
+      goto done;
+    }
+
+  hqm = vec_elt_at_index (tm->handoff_queue_mains, index);
+
+  if (policy != -1)
+    hqm->policy = policy;
+  if (timeout_us != ~0)
+    hqm->wait_timeout = timeout_us * 1e-6;
+  if (threshold)
+    for (i = 0; i < vec_len (hqm->queues); i++)
+      hqm->queues[i]->vector_threshold = threshold;
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+/*?
+ * Tune a worker handoff queue. With policy drop, the default, a sender
+ * finding the queue full drops what does not fit. With policy wait it
+ * spins for up to wait-timeout microseconds first, which trades sender
+ * cycles for fewer drops under short bursts. Threshold caps the buffers
+ * a worker takes off the queue per main loop iteration.
+ *
+ * @cliexpar
+ * @cliexcmd{set handoff queue index 0 policy wait wait-timeout 50}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_handoff_queue_command, static) = {
+  .path = "set handoff queue",
+  .short_help = "set handoff queue index <n> [policy drop|wait] "
+    "[wait-timeout <usec>] [threshold <n>]",
+  .function = set_handoff_queue_fn,
+};
+/* *INDENT-ON* */
+
+static int
+barrier_stats_cmp (void *a1, void *a2)
+{
+  vlib_barrier_caller_stats_t *s1 = a1, *s2 = a2;
+
+  if (s1->total_closed < s2->total_closed)
+    return 1;
+  if (s1->total_closed > s2->total_closed)
+    return -1;
+  return 0;
+}
+
+static clib_error_t *
+show_barrier_stats_fn (vlib_main_t * vm, unformat_input_t * input,
+		       vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_caller_stats_t *stats, *bs;
+  u8 *line = 0;
+  int i;
+
+  if (vec_len (tm->barrier_stats) == 0)
+    {
+      vlib_cli_output (vm, "no barrier syncs recorded");
+      return 0;
+    }
+
+  /* biggest offenders first */
+  stats = vec_dup (tm->barrier_stats);
+  vec_sort_with_function (stats, barrier_stats_cmp);
+
+  vlib_cli_output (vm, "%-40s%10s%12s%10s%10s", "Caller", "Count",
+		   "Total ms", "Avg us", "Max us");
+  vec_foreach (bs, stats)
+  {
+    vlib_cli_output (vm, "%-40s%10llu%12.3f%10.1f%10.1f", bs->caller,
+		     bs->count, bs->total_closed * 1e3,
+		     bs->total_closed * 1e6 / bs->count,
+		     bs->max_closed * 1e6);
+
+    /* closed time histogram, non-empty buckets only */
+    vec_reset_length (line);
+    for (i = 0; i < VLIB_BARRIER_HIST_N_BUCKETS; i++)
+      if (bs->hist[i])
+	{
+	  if (i == VLIB_BARRIER_HIST_N_BUCKETS - 1)
+	    line = format (line, " >=%uus:%llu", 1 << (i - 1), bs->hist[i]);
+	  else
+	    line = format (line, " <%uus:%llu", 1 << i, bs->hist[i]);
+	}
+    vlib_cli_output (vm, "  %v", line);
+  }
+
+  vec_free (line);
+  vec_free (stats);
+  return 0;
+}
+
+/*?
+ * Show how often and for how long each caller of
+ * vlib_worker_thread_barrier_sync() stopped the workers, sorted by total
+ * time the barrier was held. Each entry is followed by a histogram of the
+ * closed time, bucket <Nus counts syncs shorter than N microseconds.
+ * Only the outermost sync is counted, nested syncs are charged to it.
+ *
+ * @cliexpar
+ * @cliexstart{show barrier stats}
+ * Caller                                       Count    Total ms    Avg us    Max us
+ * adj_nbr_update_rewrite_internal                  4       0.412     103.0     160.2
+ *   <128us:3 <256us:1
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_show_barrier_stats, static) = {
+  .path = "show barrier stats",
+  .short_help = "show barrier stats",
+  .function = show_barrier_stats_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_barrier_stats_fn (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  vec_free (tm->barrier_stats);
+  hash_free (tm->barrier_stats_by_caller);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_clear_barrier_stats, static) = {
+  .path = "clear barrier stats",
+  .short_help = "clear barrier stats",
+  .function = clear_barrier_stats_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -130,6 +130,16 @@ linux_epoll_file_update (clib_file_t * f, clib_file_update_type_t update_type)
     }
 }
 
+static void
+linux_epoll_idle_sleep (f64 t)
+{
+  struct timespec ts;
+
+  ts.tv_sec = 0;
+  ts.tv_nsec = t * 1e9;
+  nanosleep (&ts, 0);
+}
+
 static_always_inline uword
 linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  vlib_frame_t * frame, u32 thread_index)
@@ -138,7 +148,7 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   clib_file_main_t *fm = &file_main;
   linux_epoll_main_t *em = vec_elt_at_index (linux_epoll_mains, thread_index);
   struct epoll_event *e;
-  int n_fds_ready;
+  int n_fds_ready = 0;
   int is_main = (thread_index == 0);
 
   {
@@ -147,6 +157,7 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     f64 timeout;
     int timeout_ms = 0, max_timeout_ms = 10;
     f64 vector_rate = vlib_last_vectors_per_main_loop (vm);
+    f64 idle_sleep = 0, t_sleep = 0;
 
     /* If we're not working very hard, decide how long to sleep */
     if (is_main && vector_rate < 2 && vm->api_queue_nonempty == 0
@@ -183,6 +194,16 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	timeout_ms = max_timeout_ms;
 	node->input_main_loops_per_call = 0;
       }
+    else if (is_main == 0 && PREDICT_FALSE (vm->idle_sleep > 0)
+	     && vlib_adaptive_poll_config.enable)
+      {
+	/* Adaptive backoff. epoll only does milliseconds, shorter sleeps
+	   check the fds and nanosleep instead. */
+	idle_sleep = vm->idle_sleep;
+	timeout_ms = idle_sleep * 1e3;
+	node->input_main_loops_per_call = 0;
+	t_sleep = vlib_time_now (vm);
+      }
     else			/* busy */
       {
 	/* Don't come back for a respectable number of dispatch cycles */
@@ -205,13 +226,21 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 				      em->epoll_events,
 				      vec_len (em->epoll_events), timeout_ms);
 	  }
+	if (idle_sleep > 0 && timeout_ms == 0 && n_fds_ready == 0)
+	  linux_epoll_idle_sleep (idle_sleep);
       }
     else
       {
-	if (timeout_ms)
+	if (idle_sleep > 0)
+	  linux_epoll_idle_sleep (idle_sleep);
+	else if (timeout_ms)
 	  usleep (timeout_ms * 1000);
-	return 0;
       }
+
+    if (idle_sleep > 0)
+      vlib_adaptive_poll_slept (vm, idle_sleep, vlib_time_now (vm) - t_sleep);
+    if (!is_main && em->epoll_fd == -1)
+      return 0;
   }
 
   if (n_fds_ready < 0)
@@ -389,6 +389,11 @@ vl_msg_api_barrier_release (void)
 {
 }
 
+void
+vl_msg_api_barrier_trace_context (const char *context)
+{
+}
+
 always_inline void
 msg_handler_internal (api_main_t * am,
 		      void *the_msg, int trace_it, int do_it, int free_it)
@@ -22,7 +22,10 @@
 #include <vnet/fib/fib_node_list.h>
 
 /* Adjacency packet/byte counters indexed by adjacency index. */
-vlib_combined_counter_main_t adjacency_counters;
+vlib_combined_counter_main_t adjacency_counters = {
+    .name = "adjacency",
+    .stat_segment_name = "/net/adjacency",
+};
 
 /*
  * the single adj pool
@@ -148,28 +151,47 @@ format_ip_adjacency (u8 * s, va_list * args)
     return s;
 }
 
+/*
+ * adj_free
+ *
+ * RCU callback. No worker can still be using the adj, so its midchain
+ * DPO can be released and the pool slot reused.
+ */
+static void
+adj_free (void *arg)
+{
+    ip_adjacency_t *adj = adj_get(pointer_to_uword(arg));
+
+    if (IP_LOOKUP_NEXT_MIDCHAIN == adj->lookup_next_index)
+    {
+        dpo_reset(&adj->sub_type.midchain.next_dpo);
+    }
+
+    fib_node_deinit(&adj->ia_node);
+    ASSERT(0 == vec_len(adj->ia_delegates));
+    vec_free(adj->ia_delegates);
+    pool_put(adj_pool, adj);
+}
+
 /*
  * adj_last_lock_gone
  *
  * last lock/reference to the adj has gone, we no longer need it.
+ * Removing it from the DBs stops new users finding it. Those already
+ * holding the index are packets in flight on the workers, so rather than
+ * a barrier sync the adj is freed once they have all moved on.
  */
 static void
 adj_last_lock_gone (ip_adjacency_t *adj)
 {
-    vlib_main_t * vm = vlib_get_main();
-
     ASSERT(0 == fib_node_list_get_size(adj->ia_node.fn_children));
     ADJ_DBG(adj, "last-lock-gone");
 
     adj_delegate_adj_deleted(adj);
 
-    vlib_worker_thread_barrier_sync (vm);
-
     switch (adj->lookup_next_index)
     {
     case IP_LOOKUP_NEXT_MIDCHAIN:
-        dpo_reset(&adj->sub_type.midchain.next_dpo);
-        /* FALL THROUGH */
     case IP_LOOKUP_NEXT_ARP:
     case IP_LOOKUP_NEXT_REWRITE:
 	/*
@@ -201,12 +223,7 @@ adj_last_lock_gone (ip_adjacency_t *adj)
 	break;
     }
 
-    vlib_worker_thread_barrier_release(vm);
-
-    fib_node_deinit(&adj->ia_node);
-    ASSERT(0 == vec_len(adj->ia_delegates));
-    vec_free(adj->ia_delegates);
-    pool_put(adj_pool, adj);
+    vlib_rcu_call(adj_free, uword_to_pointer(adj_get_index(adj), void *));
 }
 
 u32
@@ -64,7 +64,8 @@
   _(16, L4_HDR_OFFSET_VALID, 0)				\
   _(17, FLOW_REPORT, "flow-report")			\
   _(18, IS_DVR, "dvr")                                  \
-  _(19, QOS_DATA_VALID, 0)
+  _(19, QOS_DATA_VALID, 0)				\
+  _(20, GSO, "gso")
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -388,6 +389,15 @@ typedef struct
     u32 src_epg;
   } gbp;
 
+  /**
+   * Generic segmentation offload, valid when VNET_BUFFER_F_GSO is set:
+   * the payload is cut into gso_size byte segments, each carrying a
+   * copy of the headers up to and including the gso_l4_hdr_sz bytes
+   * long TCP header at l4_hdr_offset.
+   */
+  u16 gso_size;
+  u16 gso_l4_hdr_sz;
+
   union
   {
     struct
@@ -402,7 +412,7 @@ typedef struct
       u64 pad[1];
       u64 pg_replay_timestamp;
     };
-    u32 unused[10];
+    u32 unused[8];
   };
 } vnet_buffer_opaque2_t;
 
@@ -137,7 +137,8 @@ static void vl_api_classify_add_del_session_t_handler
 {
   vnet_classify_main_t *cm = &vnet_classify_main;
   vl_api_classify_add_del_session_reply_t *rmp;
-  int rv;
+  vlib_main_t *vm = vlib_get_main ();
+  int rv, need_barrier;
   u32 table_index, hit_next_index, opaque_index, metadata;
   i32 advance;
   u8 action;
@@ -149,10 +150,19 @@ static void vl_api_classify_add_del_session_t_handler
   action = mp->action;
   metadata = ntohl (mp->metadata);
 
+  /* mp-safe, only FIB table actions stop the workers */
+  need_barrier = vnet_classify_session_needs_barrier
+    (cm, table_index, mp->match, action, mp->is_add);
+  if (need_barrier)
+    vlib_worker_thread_barrier_sync (vm);
+
   rv = vnet_classify_add_del_session
     (cm, table_index, mp->match, hit_next_index, opaque_index,
      advance, action, metadata, mp->is_add);
 
+  if (need_barrier)
+    vlib_worker_thread_barrier_release (vm);
+
   REPLY_MACRO (VL_API_CLASSIFY_ADD_DEL_SESSION_REPLY);
 }
 
@@ -645,6 +655,12 @@ classify_api_hookup (vlib_main_t * vm)
   foreach_vpe_api_msg;
 #undef _
 
+  /*
+   * Bucket updates are published with a single store and replaced pages
+   * are freed after a grace period, see vnet_classify_add_del ()
+   */
+  am->is_mp_safe[VL_API_CLASSIFY_ADD_DEL_SESSION] = 1;
+
   /*
    * Set up the (msg_name, crc, message-id) table
    */
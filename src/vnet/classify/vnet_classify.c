@@ -163,6 +163,9 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
   if (pool_is_free_index (cm->tables, table_index))
     return;
 
+  /* Deferred page frees refer to the table heap */
+  vlib_rcu_flush (vlib_get_main ());
+
   t = pool_elt_at_index (cm->tables, table_index);
   if (del_chain && t->next_table_index != ~0)
     /* Recursively delete the entire chain */
@@ -170,11 +173,41 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
 
   vec_free (t->mask);
   vec_free (t->buckets);
+  vec_free (t->chain);
   mheap_free (t->mheap);
 
   pool_put (cm->tables, t);
 }
 
+/*
+ * Flatten the next_table_index chain of each table, for
+ * vnet_classify_find_entry_chain. Call with the workers stopped, after
+ * any change to the tables or their next_table_index.
+ */
+static void
+vnet_classify_update_chains (vnet_classify_main_t * cm)
+{
+  vnet_classify_table_t *t;
+  u32 next_table_index;
+
+  /* *INDENT-OFF* */
+  pool_foreach (t, cm->tables,
+  ({
+    vec_reset_length (t->chain);
+    next_table_index = t->next_table_index;
+    /* Stop at a deleted table, or a loop */
+    while (next_table_index != ~0
+	   && !pool_is_free_index (cm->tables, next_table_index)
+	   && vec_len (t->chain) < pool_elts (cm->tables))
+      {
+	vec_add1 (t->chain, next_table_index);
+	next_table_index =
+	  pool_elt_at_index (cm->tables, next_table_index)->next_table_index;
+      }
+  }));
+  /* *INDENT-ON* */
+}
+
 static vnet_classify_entry_t *
 vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
 {
@@ -219,6 +252,62 @@ vnet_classify_entry_free (vnet_classify_table_t * t,
   t->freelists[log2_pages] = v;
 }
 
+typedef struct
+{
+  u32 table_index;
+  /* ~0 for a working copy, which goes back to the table heap */
+  u32 log2_pages;
+  vnet_classify_entry_t *v;
+} vnet_classify_deferred_free_t;
+
+static void
+vnet_classify_entry_free_rcu (void *arg)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_deferred_free_t *df = arg;
+  vnet_classify_table_t *t;
+  void *oldheap;
+
+  t = pool_elt_at_index (cm->tables, df->table_index);
+
+  if (df->log2_pages != ~0)
+    {
+      while (__sync_lock_test_and_set (t->writer_lock, 1))
+	;
+      vnet_classify_entry_free (t, df->v, df->log2_pages);
+      CLIB_MEMORY_BARRIER ();
+      t->writer_lock[0] = 0;
+    }
+
+  oldheap = clib_mem_set_heap (t->mheap);
+  if (df->log2_pages == ~0)
+    clib_mem_free (df->v);
+  clib_mem_free (df);
+  clib_mem_set_heap (oldheap);
+}
+
+/*
+ * Return pages a bucket no longer points at to the freelist once no
+ * worker can still be walking them, rather than right away.
+ */
+static void
+vnet_classify_entry_free_deferred (vnet_classify_table_t * t,
+				   vnet_classify_entry_t * v, u32 log2_pages)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_deferred_free_t *df;
+  void *oldheap;
+
+  oldheap = clib_mem_set_heap (t->mheap);
+  df = clib_mem_alloc (sizeof (*df));
+  clib_mem_set_heap (oldheap);
+
+  df->table_index = t - cm->tables;
+  df->log2_pages = log2_pages;
+  df->v = v;
+  vlib_rcu_call (vnet_classify_entry_free_rcu, df);
+}
+
 static inline void make_working_copy
   (vnet_classify_table_t * t, vnet_classify_bucket_t * b)
 {
@@ -254,8 +343,9 @@ static inline void make_working_copy
 
   if (required_length > working_copy_length)
     {
+      /* a worker may still be walking it, from the last update */
       if (working_copy)
-	clib_mem_free (working_copy);
+	vnet_classify_entry_free_deferred (t, working_copy, ~0);
       working_copy =
 	clib_mem_alloc_aligned (required_length, CLIB_CACHE_LINE_BYTES);
       t->working_copies[thread_index] = working_copy;
@@ -627,7 +717,7 @@ expand_ok:
   b->as_u64 = tmp_b.as_u64;
   t->active_elements++;
   v = vnet_classify_get_entry (t, t->saved_bucket.offset);
-  vnet_classify_entry_free (t, v, old_log2_pages);
+  vnet_classify_entry_free_deferred (t, v, old_log2_pages);
 
 unlock:
   CLIB_MEMORY_BARRIER ();
@@ -779,10 +869,12 @@ vnet_classify_add_del_table (vnet_classify_main_t * cm,
 
 	  t->next_table_index = next_table_index;
 	}
+      vnet_classify_update_chains (cm);
       return 0;
     }
 
   vnet_classify_delete_table_index (cm, *table_index, del_chain);
+  vnet_classify_update_chains (cm);
   return 0;
 }
 
@@ -1628,7 +1720,10 @@ format_vnet_classify_table (u8 * s, va_list * args)
 	      t->current_data_flag, t->current_data_offset);
   s = format (s, "\n  mask %U", format_hex_bytes, t->mask,
 	      t->match_n_vectors * sizeof (u32x4));
-  s = format (s, "\n  linear-search buckets %d\n", t->linear_buckets);
+  s = format (s, "\n  linear-search buckets %d", t->linear_buckets);
+  if (vec_len (t->chain))
+    s = format (s, "\n  chain %U", format_vec32, t->chain, "%d");
+  s = format (s, "\n");
 
   if (verbose == 0)
     return s;
@@ -2196,6 +2291,37 @@ vnet_classify_add_del_session (vnet_classify_main_t * cm,
   return 0;
 }
 
+/*
+ * Sessions are published to the workers without stopping them, but
+ * the FIB index actions find, create and release FIB tables, which the
+ * workers index without locks. Tell the caller whether this add or
+ * delete needs the barrier.
+ */
+int
+vnet_classify_session_needs_barrier (vnet_classify_main_t * cm,
+				     u32 table_index, u8 * match, u8 action,
+				     int is_add)
+{
+  vnet_classify_table_t *t;
+  vnet_classify_entry_t *e;
+
+  if (action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
+      action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
+    return 1;
+
+  if (is_add || pool_is_free_index (cm->tables, table_index))
+    return 0;
+
+  /* deleting releases whatever the existing session holds */
+  t = pool_elt_at_index (cm->tables, table_index);
+  e = vnet_classify_find_entry (t, match,
+				vnet_classify_hash_packet (t, match),
+				0 /* now */ );
+
+  return (e && (e->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
+		e->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX));
+}
+
 static clib_error_t *
 classify_session_command_fn (vlib_main_t * vm,
 			     unformat_input_t * input,
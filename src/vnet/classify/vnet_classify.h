@@ -152,6 +152,7 @@ typedef struct
 
 typedef struct
 {
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   /* Mask to apply after skipping N vectors */
   u32x4 *mask;
   /* Buckets and entries */
@@ -175,6 +176,9 @@ typedef struct
   /* Miss next index, return if next_table_index = 0 */
   u32 miss_next_index;
 
+  /* Tables following this one in the next_table_index chain, in order */
+  u32 *chain;
+
   /* Per-bucket working copies, one per thread */
   vnet_classify_entry_t **working_copies;
   int *working_copy_lengths;
@@ -216,11 +220,122 @@ u8 *format_classify_table (u8 * s, va_list * args);
 
 u64 vnet_classify_hash_packet (vnet_classify_table_t * t, u8 * h);
 
+#ifdef CLIB_HAVE_VEC256
+/*
+ * Wide versions of the hash and match loops. Match vectors are masked
+ * two (AVX2) or four (AVX-512) at a time, using unaligned loads, so unlike
+ * the u32x4 code the packet data needs no particular alignment. Called
+ * with a constant n_vectors, so each match size compiles to straight
+ * line code.
+ */
+static_always_inline u32x4
+vnet_classify_masked_xor_wide (vnet_classify_table_t * t, u8 * h,
+			       u32 n_vectors)
+{
+  u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+  u8 *mask = (u8 *) t->mask;
+  u32 tail = (n_vectors & ~1) * sizeof (u32x4);
+  u32x4 x = { 0 };
+  u32x8 x8 = { 0 };
+
+  if (n_vectors & 1)
+    x = u32x4_load_unaligned (data + tail) &
+      u32x4_load_unaligned (mask + tail);
+#ifdef CLIB_HAVE_VEC512
+  if (n_vectors >= 4)
+    {
+      u32x16 x16 = u32x16_load_unaligned (data) &
+	u32x16_load_unaligned (mask);
+      x8 = u32x16_extract_lo (x16) ^ u32x16_extract_hi (x16);
+    }
+  else
+#endif
+    {
+      if (n_vectors >= 2)
+	x8 = u32x8_load_unaligned (data) & u32x8_load_unaligned (mask);
+      if (n_vectors >= 4)
+	x8 ^= u32x8_load_unaligned (data + 32) &
+	  u32x8_load_unaligned (mask + 32);
+    }
+  if (n_vectors >= 2)
+    x ^= u32x8_extract_lo (x8) ^ u32x8_extract_hi (x8);
+
+  return x;
+}
+
+static_always_inline vnet_classify_entry_t *
+vnet_classify_find_entry_wide (vnet_classify_table_t * t,
+			       vnet_classify_entry_t * v, u8 * h,
+			       u32 limit, f64 now, u32 n_vectors)
+{
+  u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+  u8 *mask = (u8 *) t->mask;
+  u32 tail = (n_vectors & ~1) * sizeof (u32x4);
+  u32x4 d = { 0 };
+  u32x8 d01 = { 0 }, d23 = { 0 };
+#ifdef CLIB_HAVE_VEC512
+  u32x16 d0123 = { 0 };
+#endif
+  u8 *key;
+  int match;
+  u32 i;
+
+  /* Mask the packet once, not once per entry */
+  if (n_vectors & 1)
+    d = u32x4_load_unaligned (data + tail) &
+      u32x4_load_unaligned (mask + tail);
+#ifdef CLIB_HAVE_VEC512
+  if (n_vectors >= 4)
+    d0123 = u32x16_load_unaligned (data) & u32x16_load_unaligned (mask);
+  else
+#endif
+    {
+      if (n_vectors >= 2)
+	d01 = u32x8_load_unaligned (data) & u32x8_load_unaligned (mask);
+      if (n_vectors >= 4)
+	d23 = u32x8_load_unaligned (data + 32) &
+	  u32x8_load_unaligned (mask + 32);
+    }
+
+  for (i = 0; i < limit; i++)
+    {
+      key = (u8 *) v->key;
+      match = 1;
+
+      if (n_vectors & 1)
+	match = u32x4_is_all_zero (d ^ u32x4_load_unaligned (key + tail));
+#ifdef CLIB_HAVE_VEC512
+      if (n_vectors >= 4)
+	match &= u32x16_is_all_zero (d0123 ^ u32x16_load_unaligned (key));
+      else
+#endif
+      if (n_vectors >= 2)
+	{
+	  u32x8 r = d01 ^ u32x8_load_unaligned (key);
+	  if (n_vectors >= 4)
+	    r |= d23 ^ u32x8_load_unaligned (key + 32);
+	  match &= u32x8_is_all_zero (r);
+	}
+
+      if (match)
+	{
+	  if (PREDICT_TRUE (now))
+	    {
+	      v->hits++;
+	      v->last_heard = now;
+	    }
+	  return (v);
+	}
+
+      v = (vnet_classify_entry_t *) (key + n_vectors * sizeof (u32x4));
+    }
+  return 0;
+}
+#endif /* CLIB_HAVE_VEC256 */
+
 static inline u64
 vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 {
-  u32x4 *mask;
-
   union
   {
     u32x4 as_u32x4;
@@ -228,7 +343,20 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
   } xor_sum __attribute__ ((aligned (sizeof (u32x4))));
 
   ASSERT (t);
-  mask = t->mask;
+#ifdef CLIB_HAVE_VEC256
+  switch (t->match_n_vectors)
+    {
+#define _(size)								\
+    case size:								\
+      xor_sum.as_u32x4 = vnet_classify_masked_xor_wide (t, h, size);	\
+      break;
+      foreach_size_in_u32x4;
+#undef _
+    default:
+      abort ();
+    }
+#else /* CLIB_HAVE_VEC256 */
+  u32x4 *mask = t->mask;
 #ifdef CLIB_HAVE_VEC128
   if (U32X4_ALIGNED (h))
     {				//SSE can't handle unaligned data
@@ -286,6 +414,7 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 	  abort ();
 	}
     }
+#endif /* CLIB_HAVE_VEC256 */
 
   return clib_xxhash (xor_sum.as_u64[0] ^ xor_sum.as_u64[1]);
 }
@@ -371,21 +500,22 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 				 u8 * h, u64 hash, f64 now)
 {
   vnet_classify_entry_t *v;
+#ifndef CLIB_HAVE_VEC256
   u32x4 *mask, *key;
   union
   {
     u32x4 as_u32x4;
     u64 as_u64[2];
   } result __attribute__ ((aligned (sizeof (u32x4))));
+  int i;
+#endif
   vnet_classify_bucket_t *b;
   u32 value_index;
   u32 bucket_index;
   u32 limit;
-  int i;
 
   bucket_index = hash & (t->nbuckets - 1);
   b = &t->buckets[bucket_index];
-  mask = t->mask;
 
   if (b->offset == 0)
     return 0;
@@ -403,6 +533,19 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 
   v = vnet_classify_entry_at_index (t, v, value_index);
 
+#ifdef CLIB_HAVE_VEC256
+  switch (t->match_n_vectors)
+    {
+#define _(size)								\
+    case size:								\
+      return vnet_classify_find_entry_wide (t, v, h, limit, now, size);
+      foreach_size_in_u32x4;
+#undef _
+    default:
+      abort ();
+    }
+#else /* CLIB_HAVE_VEC256 */
+  mask = t->mask;
 #ifdef CLIB_HAVE_VEC128
   if (U32X4_ALIGNED (h))
     {
@@ -506,6 +649,81 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 	}
     }
   return 0;
+#endif /* CLIB_HAVE_VEC256 */
+}
+
+/* Tables of a chain hashed and prefetched together */
+#define VNET_CLASSIFY_CHAIN_BATCH 8
+
+/**
+ * @brief Look up a packet in the tables chained after a table
+ *
+ * Walks the flattened chain of the table (t->chain) rather than following
+ * next_table_index one dependent lookup at a time. The packet is hashed
+ * against up to VNET_CLASSIFY_CHAIN_BATCH masks and all their buckets and
+ * entries are prefetched before the first probe, so the cache misses of
+ * the tables overlap and a chain costs about as much as a single table.
+ * Tables are probed in chain order, the first hit wins, as with the walk.
+ *
+ * @param cm        classifier main
+ * @param tp        [in] table that missed, [out] table that hit, or the
+ *                  last table of the chain when all miss
+ * @param h         packet data
+ * @param h_current packet current data, matched by tables with
+ *                  CLASSIFY_FLAG_USE_CURR_DATA; 0 to match all tables at h
+ * @param now       time, to update entry hits, 0 not to
+ *
+ * @returns matching entry, 0 on a miss
+ */
+static inline vnet_classify_entry_t *
+vnet_classify_find_entry_chain (vnet_classify_main_t * cm,
+				vnet_classify_table_t ** tp, u8 * h,
+				u8 * h_current, f64 now)
+{
+  vnet_classify_table_t *tables[VNET_CLASSIFY_CHAIN_BATCH];
+  u8 *data[VNET_CLASSIFY_CHAIN_BATCH];
+  u64 hashes[VNET_CLASSIFY_CHAIN_BATCH];
+  vnet_classify_table_t *t;
+  vnet_classify_entry_t *e;
+  u32 *chain = (*tp)->chain;
+  u32 n_left = vec_len (chain);
+  u32 i, n;
+
+  while (n_left > 0)
+    {
+      n = clib_min (n_left, VNET_CLASSIFY_CHAIN_BATCH);
+
+      for (i = 0; i < n; i++)
+	{
+	  t = tables[i] = pool_elt_at_index (cm->tables, chain[i]);
+	  if (h_current
+	      && t->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
+	    data[i] = h_current + t->current_data_offset;
+	  else
+	    data[i] = h;
+	  hashes[i] = vnet_classify_hash_packet_inline (t, data[i]);
+	  vnet_classify_prefetch_bucket (t, hashes[i]);
+	}
+      for (i = 0; i < n; i++)
+	vnet_classify_prefetch_entry (tables[i], hashes[i]);
+
+      for (i = 0; i < n; i++)
+	{
+	  e = vnet_classify_find_entry_inline (tables[i], data[i],
+					       hashes[i], now);
+	  if (e)
+	    {
+	      *tp = tables[i];
+	      return e;
+	    }
+	}
+
+      *tp = tables[n - 1];
+      chain += n;
+      n_left -= n;
+    }
+
+  return 0;
 }
 
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t * cm,
@@ -521,6 +739,9 @@ int vnet_classify_add_del_session (vnet_classify_main_t * cm,
 				   u32 opaque_index,
 				   i32 advance,
 				   u8 action, u32 metadata, int is_add);
+int vnet_classify_session_needs_barrier (vnet_classify_main_t * cm,
+					 u32 table_index, u8 * match,
+					 u8 action, int is_add);
 
 int vnet_classify_add_del_table (vnet_classify_main_t * cm,
 				 u8 * mask,
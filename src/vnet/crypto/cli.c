@@ -0,0 +1,199 @@
+/*
+ * cli.c : crypto engine CLI
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+
+static clib_error_t *
+show_crypto_engines_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *p;
+
+  if (vec_len (cm->engines) == 0)
+    {
+      vlib_cli_output (vm, "No crypto engines registered");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "%-20s%-8s%s", "Name", "Prio", "Description");
+  /* *INDENT-OFF* */
+  vec_foreach (p, cm->engines)
+    vlib_cli_output (vm, "%-20s%-8u%s", p->name, p->priority, p->desc);
+  /* *INDENT-ON* */
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_crypto_engines_command, static) =
+{
+  .path = "show crypto engines",
+  .short_help = "show crypto engines",
+  .function = show_crypto_engines_command_fn,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_vnet_crypto_handlers (u8 * s, va_list * args)
+{
+  vnet_crypto_op_id_t opt = va_arg (*args, vnet_crypto_op_id_t);
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *otd = cm->opt_data + opt;
+  vnet_crypto_engine_t *e;
+  u32 ei;
+
+  s = format (s, "%-20U", format_vnet_crypto_op, opt);
+
+  /* *INDENT-OFF* */
+  vec_foreach (e, cm->engines)
+    {
+      if (e->ops_handlers[opt] == 0)
+	continue;
+      ei = e - cm->engines;
+      s = format (s, "%s%s ", e->name,
+		  ei == otd->active_engine_index ? "*" : "");
+    }
+  /* *INDENT-ON* */
+  return s;
+}
+
+static clib_error_t *
+show_crypto_handlers_command_fn (vlib_main_t * vm,
+				 unformat_input_t * input,
+				 vlib_cli_command_t * cmd)
+{
+  vnet_crypto_op_id_t opt;
+
+  vlib_cli_output (vm, "%-20s%s", "Op", "Engines (* active)");
+  for (opt = 1; opt < VNET_CRYPTO_N_OP_IDS; opt++)
+    vlib_cli_output (vm, "%U", format_vnet_crypto_handlers, opt);
+
+  return 0;
+}
+
+/*?
+ * Lists, for every crypto operation, the engines that implement it.
+ * The active one is marked with '*'.
+ *
+ * @cliexpar
+ * @cliexstart{show crypto handlers}
+ * Op                  Engines (* active)
+ * des-cbc-enc         openssl*
+ * aes-128-cbc-enc     openssl native*
+ * ...
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_crypto_handlers_command, static) =
+{
+  .path = "show crypto handlers",
+  .short_help = "show crypto handlers",
+  .function = show_crypto_handlers_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_crypto_handler_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_crypto_op_id_t *opts = 0, opt, *optp;
+  clib_error_t *error = 0;
+  char *engine = 0;
+  int all = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "expected op and engine");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "all"))
+	all = 1;
+      else if (unformat (line_input, "%U", unformat_vnet_crypto_op, &opt))
+	vec_add1 (opts, opt);
+      else if (!engine && unformat (line_input, "%s", &engine))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (!engine)
+    {
+      error = clib_error_return (0, "engine required");
+      goto done;
+    }
+
+  vec_add1 (engine, 0);
+
+  if (all)
+    {
+      /* switch whatever the engine implements */
+      for (opt = 1; opt < VNET_CRYPTO_N_OP_IDS; opt++)
+	vnet_crypto_set_handler (opt, engine);
+      goto done;
+    }
+
+  /* *INDENT-OFF* */
+  vec_foreach (optp, opts)
+    {
+      if (vnet_crypto_set_handler (optp[0], engine))
+	{
+	  error = clib_error_return (0, "engine '%s' can't handle %U",
+				     engine, format_vnet_crypto_op, optp[0]);
+	  goto done;
+	}
+    }
+  /* *INDENT-ON* */
+
+done:
+  vec_free (engine);
+  vec_free (opts);
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Selects the engine that handles the given crypto operations,
+ * overriding the priority based default.
+ *
+ * @cliexpar
+ * @cliexcmd{set crypto handler aes-128-gcm-enc aes-128-gcm-dec openssl}
+ * @cliexcmd{set crypto handler all native}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_crypto_handler_command, static) =
+{
+  .path = "set crypto handler",
+  .short_help = "set crypto handler <op>... | all <engine>",
+  .function = set_crypto_handler_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,363 @@
+/*
+ * crypto.c : crypto engine abstraction
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/api_errno.h>
+#include <vnet/crypto/crypto.h>
+
+vnet_crypto_main_t crypto_main;
+
+static_always_inline u32
+vnet_crypto_process_ops_call_handler (vlib_main_t * vm,
+				      vnet_crypto_main_t * cm,
+				      vnet_crypto_op_id_t opt,
+				      vnet_crypto_op_t * ops[], u32 n_ops)
+{
+  u32 i;
+
+  if (n_ops == 0)
+    return 0;
+
+  if (PREDICT_FALSE (cm->ops_handlers[opt] == 0))
+    {
+      for (i = 0; i < n_ops; i++)
+	ops[i]->status = VNET_CRYPTO_OP_STATUS_FAIL_NO_HANDLER;
+      return 0;
+    }
+
+  return (cm->ops_handlers[opt]) (vm, ops, n_ops);
+}
+
+u32
+vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[], u32 n_ops)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_t *op_queue[VLIB_FRAME_SIZE];
+  u64 pending[VLIB_FRAME_SIZE / 64];
+  u32 n_op_queue, n_chunk, n_pending, rv = 0;
+  vnet_crypto_op_id_t opt;
+  u32 i, j;
+
+  /*
+   * Hand each engine all operations of one type at once, even when
+   * the caller interleaved several types (e.g. SAs with different
+   * algorithms in one frame). Work in chunks of a frame so the
+   * bookkeeping stays on the stack.
+   */
+  while (n_ops)
+    {
+      n_chunk = clib_min (n_ops, VLIB_FRAME_SIZE);
+      memset (pending, 0, sizeof (pending));
+      for (i = 0; i < n_chunk; i++)
+	pending[i / 64] |= 1ULL << (i % 64);
+      n_pending = n_chunk;
+      i = 0;
+
+      while (n_pending)
+	{
+	  while ((pending[i / 64] & (1ULL << (i % 64))) == 0)
+	    i++;
+
+	  opt = ops[i].op;
+	  n_op_queue = 0;
+	  for (j = i; j < n_chunk; j++)
+	    {
+	      if (ops[j].op != opt
+		  || (pending[j / 64] & (1ULL << (j % 64))) == 0)
+		continue;
+	      pending[j / 64] &= ~(1ULL << (j % 64));
+	      op_queue[n_op_queue++] = &ops[j];
+	    }
+	  n_pending -= n_op_queue;
+	  rv += vnet_crypto_process_ops_call_handler (vm, cm, opt, op_queue,
+						      n_op_queue);
+	}
+
+      ops += n_chunk;
+      n_ops -= n_chunk;
+    }
+
+  return rv;
+}
+
+u32
+vnet_crypto_register_engine (vlib_main_t * vm, char *name, int prio,
+			     char *desc)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *p;
+
+  vec_add2 (cm->engines, p, 1);
+  p->name = name;
+  p->desc = desc;
+  p->priority = prio;
+
+  hash_set_mem (cm->engine_index_by_name, p->name, p - cm->engines);
+
+  return p - cm->engines;
+}
+
+void
+vnet_crypto_register_ops_handler (vlib_main_t * vm, u32 engine_index,
+				  vnet_crypto_op_id_t opt,
+				  vnet_crypto_ops_handler_t * fn)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ae, *e = vec_elt_at_index (cm->engines, engine_index);
+  vnet_crypto_op_data_t *otd = cm->opt_data + opt;
+
+  e->ops_handlers[opt] = fn;
+
+  if (otd->active_engine_index == ~0)
+    {
+      otd->active_engine_index = engine_index;
+      cm->ops_handlers[opt] = fn;
+      return;
+    }
+
+  ae = vec_elt_at_index (cm->engines, otd->active_engine_index);
+  if (ae->priority < e->priority)
+    {
+      otd->active_engine_index = engine_index;
+      cm->ops_handlers[opt] = fn;
+    }
+}
+
+void
+vnet_crypto_register_key_handler (vlib_main_t * vm, u32 engine_index,
+				  vnet_crypto_key_handler_t * key_handler)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *e = vec_elt_at_index (cm->engines, engine_index);
+  vnet_crypto_key_t *key;
+
+  e->key_handler = key_handler;
+
+  /* catch up with keys added before the engine showed up */
+  /* *INDENT-OFF* */
+  pool_foreach (key, cm->keys,
+  ({
+    key_handler (vm, VNET_CRYPTO_KEY_OP_ADD, key - cm->keys);
+  }));
+  /* *INDENT-ON* */
+}
+
+int
+vnet_crypto_set_handler (vnet_crypto_op_id_t opt, char *engine_name)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *e;
+  uword *p;
+
+  if (opt == VNET_CRYPTO_OP_NONE || opt >= VNET_CRYPTO_N_OP_IDS)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  p = hash_get_mem (cm->engine_index_by_name, engine_name);
+  if (!p)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  e = vec_elt_at_index (cm->engines, p[0]);
+  if (e->ops_handlers[opt] == 0)
+    return VNET_API_ERROR_UNIMPLEMENTED;
+
+  cm->opt_data[opt].active_engine_index = p[0];
+  cm->ops_handlers[opt] = e->ops_handlers[opt];
+
+  return 0;
+}
+
+u32
+vnet_crypto_key_add (vlib_main_t * vm, vnet_crypto_alg_t alg, u8 * data,
+		     u16 length)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *engine;
+  vnet_crypto_key_t *key;
+  u32 index;
+
+  pool_get (cm->keys, key);
+  memset (key, 0, sizeof (*key));
+  index = key - cm->keys;
+  key->alg = alg;
+  vec_validate_aligned (key->data, length - 1, CLIB_CACHE_LINE_BYTES);
+  clib_memcpy (key->data, data, length);
+
+  /* *INDENT-OFF* */
+  vec_foreach (engine, cm->engines)
+    if (engine->key_handler)
+      engine->key_handler (vm, VNET_CRYPTO_KEY_OP_ADD, index);
+  /* *INDENT-ON* */
+
+  return index;
+}
+
+void
+vnet_crypto_key_del (vlib_main_t * vm, u32 key_index)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *engine;
+  vnet_crypto_key_t *key = pool_elt_at_index (cm->keys, key_index);
+
+  /* *INDENT-OFF* */
+  vec_foreach (engine, cm->engines)
+    if (engine->key_handler)
+      engine->key_handler (vm, VNET_CRYPTO_KEY_OP_DEL, key_index);
+  /* *INDENT-ON* */
+
+  memset (key->data, 0, vec_len (key->data));
+  vec_free (key->data);
+  pool_put (cm->keys, key);
+}
+
+u8 *
+format_vnet_crypto_alg (u8 * s, va_list * args)
+{
+  vnet_crypto_alg_t alg = va_arg (*args, vnet_crypto_alg_t);
+  vnet_crypto_main_t *cm = &crypto_main;
+
+  if (alg >= VNET_CRYPTO_N_ALGS || cm->algs[alg].name == 0)
+    return format (s, "unknown");
+
+  return format (s, "%s", cm->algs[alg].name);
+}
+
+u8 *
+format_vnet_crypto_op (u8 * s, va_list * args)
+{
+  vnet_crypto_op_id_t opt = va_arg (*args, vnet_crypto_op_id_t);
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *otd;
+  char *suffix[] = {
+    [VNET_CRYPTO_OP_TYPE_ENCRYPT] = "enc",
+    [VNET_CRYPTO_OP_TYPE_DECRYPT] = "dec",
+    [VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT] = "enc",
+    [VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT] = "dec",
+    [VNET_CRYPTO_OP_TYPE_HMAC] = "hmac",
+  };
+
+  if (opt == VNET_CRYPTO_OP_NONE || opt >= VNET_CRYPTO_N_OP_IDS)
+    return format (s, "unknown");
+
+  otd = cm->opt_data + opt;
+  if (otd->type == VNET_CRYPTO_OP_TYPE_HMAC)
+    return format (s, "%s-%U", suffix[otd->type], format_vnet_crypto_alg,
+		   otd->alg);
+  return format (s, "%U-%s", format_vnet_crypto_alg, otd->alg,
+		 suffix[otd->type]);
+}
+
+u8 *
+format_vnet_crypto_op_status (u8 * s, va_list * args)
+{
+  vnet_crypto_op_status_t st = va_arg (*args, int);
+  char *strings[] = {
+#define _(n, str) [VNET_CRYPTO_OP_STATUS_##n] = str,
+    foreach_crypto_op_status
+#undef _
+  };
+
+  if (st >= VNET_CRYPTO_OP_N_STATUS)
+    return format (s, "unknown");
+
+  return format (s, "%s", strings[st]);
+}
+
+uword
+unformat_vnet_crypto_op (unformat_input_t * input, va_list * args)
+{
+  vnet_crypto_op_id_t *opt = va_arg (*args, vnet_crypto_op_id_t *);
+  vnet_crypto_op_id_t i;
+  u8 *name = 0;
+  uword rv = 0;
+
+  if (!unformat (input, "%s", &name))
+    return 0;
+
+  for (i = 1; i < VNET_CRYPTO_N_OP_IDS; i++)
+    {
+      u8 *s = format (0, "%U%c", format_vnet_crypto_op, i, 0);
+      if (!strcmp ((char *) s, (char *) name))
+	{
+	  *opt = i;
+	  rv = 1;
+	}
+      vec_free (s);
+      if (rv)
+	break;
+    }
+
+  vec_free (name);
+  return rv;
+}
+
+static clib_error_t *
+vnet_crypto_init (vlib_main_t * vm)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *otd;
+  u32 i;
+
+  cm->engine_index_by_name = hash_create_string ( /* size */ 0,
+						 sizeof (uword));
+
+  for (i = 0; i < VNET_CRYPTO_N_OP_IDS; i++)
+    cm->opt_data[i].active_engine_index = ~0;
+
+#define _(n, s, l) \
+  cm->algs[VNET_CRYPTO_ALG_##n].name = s; \
+  cm->algs[VNET_CRYPTO_ALG_##n].key_length = l; \
+  otd = cm->opt_data + VNET_CRYPTO_OP_##n##_ENC; \
+  otd->alg = VNET_CRYPTO_ALG_##n; \
+  otd->type = VNET_CRYPTO_OP_TYPE_ENCRYPT; \
+  otd = cm->opt_data + VNET_CRYPTO_OP_##n##_DEC; \
+  otd->alg = VNET_CRYPTO_ALG_##n; \
+  otd->type = VNET_CRYPTO_OP_TYPE_DECRYPT;
+  foreach_crypto_cipher_alg;
+#undef _
+
+#define _(n, s, l) \
+  cm->algs[VNET_CRYPTO_ALG_##n].name = s; \
+  cm->algs[VNET_CRYPTO_ALG_##n].key_length = l; \
+  otd = cm->opt_data + VNET_CRYPTO_OP_##n##_ENC; \
+  otd->alg = VNET_CRYPTO_ALG_##n; \
+  otd->type = VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT; \
+  otd = cm->opt_data + VNET_CRYPTO_OP_##n##_DEC; \
+  otd->alg = VNET_CRYPTO_ALG_##n; \
+  otd->type = VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT;
+  foreach_crypto_aead_alg;
+#undef _
+
+#define _(n, s, l) \
+  cm->algs[VNET_CRYPTO_ALG_HMAC_##n].name = s; \
+  otd = cm->opt_data + VNET_CRYPTO_OP_##n##_HMAC; \
+  otd->alg = VNET_CRYPTO_ALG_HMAC_##n; \
+  otd->type = VNET_CRYPTO_OP_TYPE_HMAC;
+  foreach_crypto_hmac_alg;
+#undef _
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vnet_crypto_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
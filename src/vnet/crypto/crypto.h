@@ -0,0 +1,241 @@
+/*
+ * crypto.h : crypto engine abstraction
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vnet_crypto_crypto_h
+#define included_vnet_crypto_crypto_h
+
+#include <vlib/vlib.h>
+
+/*
+ * Crypto engines register a handler per operation. A handler gets a batch
+ * of operations of one type and completes all of them before returning,
+ * so callers fill a vector of vnet_crypto_op_t for a whole frame and hand
+ * it to vnet_crypto_process_ops () in one go. For every operation the
+ * registered engine with the highest priority wins, "set crypto handler"
+ * overrides that choice.
+ */
+
+/* alg, name, key length in bytes */
+#define foreach_crypto_cipher_alg \
+  _(DES_CBC, "des-cbc", 8) \
+  _(3DES_CBC, "3des-cbc", 24) \
+  _(AES_128_CBC, "aes-128-cbc", 16) \
+  _(AES_192_CBC, "aes-192-cbc", 24) \
+  _(AES_256_CBC, "aes-256-cbc", 32)
+
+#define foreach_crypto_aead_alg \
+  _(AES_128_GCM, "aes-128-gcm", 16) \
+  _(AES_192_GCM, "aes-192-gcm", 24) \
+  _(AES_256_GCM, "aes-256-gcm", 32)
+
+/* alg, name, digest length in bytes */
+#define foreach_crypto_hmac_alg \
+  _(SHA1, "sha-1", 20) \
+  _(SHA256, "sha-256", 32) \
+  _(SHA384, "sha-384", 48) \
+  _(SHA512, "sha-512", 64)
+
+typedef enum
+{
+  VNET_CRYPTO_ALG_NONE = 0,
+#define _(n, s, l) VNET_CRYPTO_ALG_##n,
+  foreach_crypto_cipher_alg
+  foreach_crypto_aead_alg
+#undef _
+#define _(n, s, l) VNET_CRYPTO_ALG_HMAC_##n,
+  foreach_crypto_hmac_alg
+#undef _
+  VNET_CRYPTO_N_ALGS,
+} vnet_crypto_alg_t;
+
+typedef enum
+{
+  VNET_CRYPTO_OP_NONE = 0,
+#define _(n, s, l) VNET_CRYPTO_OP_##n##_ENC, VNET_CRYPTO_OP_##n##_DEC,
+  foreach_crypto_cipher_alg
+  foreach_crypto_aead_alg
+#undef _
+#define _(n, s, l) VNET_CRYPTO_OP_##n##_HMAC,
+  foreach_crypto_hmac_alg
+#undef _
+  VNET_CRYPTO_N_OP_IDS,
+} vnet_crypto_op_id_t;
+
+typedef enum
+{
+  VNET_CRYPTO_OP_TYPE_ENCRYPT = 0,
+  VNET_CRYPTO_OP_TYPE_DECRYPT,
+  VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT,
+  VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT,
+  VNET_CRYPTO_OP_TYPE_HMAC,
+  VNET_CRYPTO_OP_N_TYPES,
+} vnet_crypto_op_type_t;
+
+#define foreach_crypto_op_status \
+  _(PENDING, "pending") \
+  _(COMPLETED, "completed") \
+  _(FAIL_NO_HANDLER, "no-handler") \
+  _(FAIL_BAD_HMAC, "bad-hmac") \
+  _(FAIL_ENGINE_ERR, "engine-error")
+
+typedef enum
+{
+#define _(n, s) VNET_CRYPTO_OP_STATUS_##n,
+  foreach_crypto_op_status
+#undef _
+    VNET_CRYPTO_OP_N_STATUS,
+} vnet_crypto_op_status_t;
+
+typedef struct
+{
+  /* vnet_crypto_op_id_t */
+  u16 op;
+  /* vnet_crypto_op_status_t */
+  u8 status;
+  u8 flags;
+#define VNET_CRYPTO_OP_FLAG_HMAC_CHECK (1 << 0)
+  u32 key_index;
+  u32 len;
+  u16 aad_len;
+  /* bytes of digest / tag to write or compare */
+  u8 digest_len;
+  u8 tag_len;
+  /* cipher: IV; AEAD: 12 byte nonce */
+  u8 *iv;
+  u8 *src;
+  u8 *dst;
+  u8 *aad;
+  union
+  {
+    u8 *digest;
+    u8 *tag;
+  };
+  uword user_data;
+} vnet_crypto_op_t;
+
+STATIC_ASSERT_SIZEOF (vnet_crypto_op_t, CLIB_CACHE_LINE_BYTES);
+
+typedef struct
+{
+  vnet_crypto_alg_t alg;
+  /* key material, a vector */
+  u8 *data;
+} vnet_crypto_key_t;
+
+typedef enum
+{
+  VNET_CRYPTO_KEY_OP_ADD,
+  VNET_CRYPTO_KEY_OP_DEL,
+} vnet_crypto_key_op_t;
+
+typedef u32 (vnet_crypto_ops_handler_t) (vlib_main_t * vm,
+					 vnet_crypto_op_t * ops[], u32 n_ops);
+
+typedef void (vnet_crypto_key_handler_t) (vlib_main_t * vm,
+					  vnet_crypto_key_op_t kop,
+					  u32 key_index);
+
+typedef struct
+{
+  char *name;
+  char *desc;
+  int priority;
+  vnet_crypto_key_handler_t *key_handler;
+  vnet_crypto_ops_handler_t *ops_handlers[VNET_CRYPTO_N_OP_IDS];
+} vnet_crypto_engine_t;
+
+typedef struct
+{
+  char *name;
+  u16 key_length;
+} vnet_crypto_alg_data_t;
+
+typedef struct
+{
+  vnet_crypto_alg_t alg;
+  vnet_crypto_op_type_t type;
+  /* engine the handler below was taken from, ~0 if none */
+  u32 active_engine_index;
+} vnet_crypto_op_data_t;
+
+typedef struct
+{
+  vnet_crypto_alg_data_t algs[VNET_CRYPTO_N_ALGS];
+  vnet_crypto_op_data_t opt_data[VNET_CRYPTO_N_OP_IDS];
+  /* active handler per operation */
+  vnet_crypto_ops_handler_t *ops_handlers[VNET_CRYPTO_N_OP_IDS];
+  vnet_crypto_engine_t *engines;
+  /* pool of keys */
+  vnet_crypto_key_t *keys;
+  uword *engine_index_by_name;
+} vnet_crypto_main_t;
+
+extern vnet_crypto_main_t crypto_main;
+
+/* engine registration */
+u32 vnet_crypto_register_engine (vlib_main_t * vm, char *name, int prio,
+				 char *desc);
+void vnet_crypto_register_ops_handler (vlib_main_t * vm, u32 engine_index,
+				       vnet_crypto_op_id_t opt,
+				       vnet_crypto_ops_handler_t * oph);
+void vnet_crypto_register_key_handler (vlib_main_t * vm, u32 engine_index,
+				       vnet_crypto_key_handler_t * keyh);
+int vnet_crypto_set_handler (vnet_crypto_op_id_t opt, char *engine_name);
+
+/* keys, added and removed by the control plane with workers stopped */
+u32 vnet_crypto_key_add (vlib_main_t * vm, vnet_crypto_alg_t alg,
+			 u8 * data, u16 length);
+void vnet_crypto_key_del (vlib_main_t * vm, u32 key_index);
+
+/* returns the number of operations completed successfully */
+u32 vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[],
+			     u32 n_ops);
+
+format_function_t format_vnet_crypto_alg;
+format_function_t format_vnet_crypto_op;
+format_function_t format_vnet_crypto_op_status;
+unformat_function_t unformat_vnet_crypto_op;
+
+static_always_inline vnet_crypto_key_t *
+vnet_crypto_get_key (u32 key_index)
+{
+  return pool_elt_at_index (crypto_main.keys, key_index);
+}
+
+static_always_inline void
+vnet_crypto_op_init (vnet_crypto_op_t * op, vnet_crypto_op_id_t type)
+{
+  memset (op, 0, sizeof (*op));
+  op->op = type;
+  op->status = VNET_CRYPTO_OP_STATUS_PENDING;
+}
+
+static_always_inline vnet_crypto_op_type_t
+vnet_crypto_get_op_type (vnet_crypto_op_id_t opt)
+{
+  return crypto_main.opt_data[opt].type;
+}
+
+#endif /* included_vnet_crypto_crypto_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,419 @@
+/*
+ * crypto_test.c : crypto engine known answer tests and benchmark
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+
+typedef struct
+{
+  char *name;
+  vnet_crypto_alg_t alg;
+  char *key, *iv, *aad, *plaintext, *ciphertext, *tag;
+} crypto_test_vector_t;
+
+/* hex strings, from RFC 3602, the GCM spec (McGrew & Viega) and RFC 4231 */
+static crypto_test_vector_t crypto_test_vectors[] = {
+  {
+   .name = "rfc3602 case 1",
+   .alg = VNET_CRYPTO_ALG_AES_128_CBC,
+   .key = "06a9214036b8a15b512e03d534120006",
+   .iv = "3dafba429d9eb430b422da802c9fac41",
+   .plaintext = "53696e676c6520626c6f636b206d7367",
+   .ciphertext = "e353779c1079aeb82708942dbe77181a",
+   },
+  {
+   .name = "rfc3602 case 2",
+   .alg = VNET_CRYPTO_ALG_AES_128_CBC,
+   .key = "c286696d887c9aa0611bbb3e2025a45a",
+   .iv = "562e17996d093d28ddb3ba695a2e6f58",
+   .plaintext = "000102030405060708090a0b0c0d0e0f"
+   "101112131415161718191a1b1c1d1e1f",
+   .ciphertext = "d296cd94c2cccf8a3a863028b5e1dc0a"
+   "7586602d253cfff91b8266bea6d61ab1",
+   },
+  {
+   .name = "gcm spec test case 4",
+   .alg = VNET_CRYPTO_ALG_AES_128_GCM,
+   .key = "feffe9928665731c6d6a8f9467308308",
+   .iv = "cafebabefacedbaddecaf888",
+   .aad = "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+   .plaintext = "d9313225f88406e5a55909c5aff5269a"
+   "86a7a9531534f7da2e4c303d8a318a72"
+   "1c3c0c95956809532fcf0e2449a6b525"
+   "b16aedf5aa0de657ba637b39",
+   .ciphertext = "42831ec2217774244b7221b784d0d49c"
+   "e3aa212f2c02a4e035c17e2329aca12e"
+   "21d514b25466931c7d8f6a5aac84aa05"
+   "1ba30b396a0aac973d58e091",
+   .tag = "5bc94fbc3221a5db94fae95ae7121a47",
+   },
+  {
+   .name = "gcm spec test case 2",
+   .alg = VNET_CRYPTO_ALG_AES_128_GCM,
+   .key = "00000000000000000000000000000000",
+   .iv = "000000000000000000000000",
+   .plaintext = "00000000000000000000000000000000",
+   .ciphertext = "0388dace60b6a392f328c2b971b2fe78",
+   .tag = "ab6e47d42cec13bdf53a67b21257bddf",
+   },
+  {
+   .name = "rfc4231 case 2",
+   .alg = VNET_CRYPTO_ALG_HMAC_SHA256,
+   .key = "4a656665",
+   .plaintext = "7768617420646f2079612077616e7420"
+   "666f72206e6f7468696e673f",
+   .tag = "5bdcc146bf60754e6a042426089575c7"
+   "5a003f089d2739839dec58b964ec3843",
+   },
+  {
+   .name = "rfc2202 case 2",
+   .alg = VNET_CRYPTO_ALG_HMAC_SHA1,
+   .key = "4a656665",
+   .plaintext = "7768617420646f2079612077616e7420"
+   "666f72206e6f7468696e673f",
+   .tag = "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+   },
+};
+
+typedef struct
+{
+  u32 n_buffers;
+  u32 buffer_size;
+  u32 rounds;
+  u8 perf;
+  u8 verbose;
+} crypto_test_args_t;
+
+static u8 *
+crypto_test_hex (char *s)
+{
+  u8 *v = 0;
+
+  if (s && strlen (s))
+    {
+      unformat_input_t in;
+      unformat_init_string (&in, s, strlen (s));
+      unformat (&in, "%U", unformat_hex_string, &v);
+      unformat_free (&in);
+    }
+  return v;
+}
+
+static vnet_crypto_op_id_t
+crypto_test_op (vnet_crypto_alg_t alg, vnet_crypto_op_type_t type)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_id_t opt;
+
+  for (opt = 1; opt < VNET_CRYPTO_N_OP_IDS; opt++)
+    if (cm->opt_data[opt].alg == alg && cm->opt_data[opt].type == type)
+      return opt;
+  return VNET_CRYPTO_OP_NONE;
+}
+
+/* runs one operation on one specific engine, bypassing handler selection */
+static int
+crypto_test_run_one (vlib_main_t * vm, vnet_crypto_engine_t * e,
+		     vnet_crypto_op_t * op)
+{
+  vnet_crypto_op_t *ops[1] = { op };
+
+  if (e->ops_handlers[op->op] == 0)
+    return -1;
+  e->ops_handlers[op->op] (vm, ops, 1);
+  return op->status == VNET_CRYPTO_OP_STATUS_COMPLETED ? 0 : 1;
+}
+
+static int
+crypto_test_vector (vlib_main_t * vm, crypto_test_vector_t * tv,
+		    vnet_crypto_engine_t * e, u8 ** err)
+{
+  u8 *key = crypto_test_hex (tv->key), *iv = crypto_test_hex (tv->iv);
+  u8 *aad = crypto_test_hex (tv->aad), *pt = crypto_test_hex (tv->plaintext);
+  u8 *ct = crypto_test_hex (tv->ciphertext), *tag = crypto_test_hex (tv->tag);
+  u8 *out = 0, out_tag[64];
+  vnet_crypto_op_type_t enc_type, dec_type;
+  vnet_crypto_op_t op;
+  u32 key_index;
+  int rv = 0, skipped = 1;
+
+  vec_validate (out, vec_len (pt) + 16);
+  key_index = vnet_crypto_key_add (vm, tv->alg, key, vec_len (key));
+
+  if (tag && !ct)
+    {
+      vnet_crypto_op_init (&op, crypto_test_op (tv->alg,
+						VNET_CRYPTO_OP_TYPE_HMAC));
+      op.key_index = key_index;
+      op.src = pt;
+      op.len = vec_len (pt);
+      op.digest = out_tag;
+      op.digest_len = vec_len (tag);
+      if ((rv = crypto_test_run_one (vm, e, &op)) < 0)
+	goto done;
+      skipped = 0;
+      if (rv || memcmp (out_tag, tag, vec_len (tag)))
+	{
+	  *err = format (*err, "digest mismatch");
+	  rv = 1;
+	  goto done;
+	}
+      op.flags = VNET_CRYPTO_OP_FLAG_HMAC_CHECK;
+      op.digest = tag;
+      if (crypto_test_run_one (vm, e, &op))
+	{
+	  *err = format (*err, "digest check failed");
+	  rv = 1;
+	}
+      goto done;
+    }
+
+  enc_type = tag ? VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT :
+    VNET_CRYPTO_OP_TYPE_ENCRYPT;
+  dec_type = tag ? VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT :
+    VNET_CRYPTO_OP_TYPE_DECRYPT;
+
+  vnet_crypto_op_init (&op, crypto_test_op (tv->alg, enc_type));
+  op.key_index = key_index;
+  op.iv = iv;
+  op.src = pt;
+  op.dst = out;
+  op.len = vec_len (pt);
+  op.aad = aad;
+  op.aad_len = vec_len (aad);
+  op.tag = out_tag;
+  op.tag_len = vec_len (tag);
+  if ((rv = crypto_test_run_one (vm, e, &op)) < 0)
+    goto done;
+  skipped = 0;
+  if (rv || memcmp (out, ct, vec_len (ct))
+      || (tag && memcmp (out_tag, tag, vec_len (tag))))
+    {
+      *err = format (*err, "encrypt mismatch");
+      rv = 1;
+      goto done;
+    }
+
+  op.op = crypto_test_op (tv->alg, dec_type);
+  op.src = ct;
+  op.tag = tag;
+  if (crypto_test_run_one (vm, e, &op) || memcmp (out, pt, vec_len (pt)))
+    {
+      *err = format (*err, "decrypt mismatch");
+      rv = 1;
+      goto done;
+    }
+
+  if (tag)
+    {
+      /* a corrupted tag must be refused */
+      tag[0] ^= 1;
+      if (crypto_test_run_one (vm, e, &op) !=
+	  1 || op.status != VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC)
+	{
+	  *err = format (*err, "bad tag accepted");
+	  rv = 1;
+	}
+    }
+
+done:
+  vnet_crypto_key_del (vm, key_index);
+  vec_free (key);
+  vec_free (iv);
+  vec_free (aad);
+  vec_free (pt);
+  vec_free (ct);
+  vec_free (tag);
+  vec_free (out);
+  return skipped ? -1 : rv;
+}
+
+static void
+crypto_test_perf (vlib_main_t * vm, crypto_test_args_t * a,
+		  vnet_crypto_engine_t * e, vnet_crypto_op_id_t opt)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *otd = cm->opt_data + opt;
+  vnet_crypto_op_t *ops = 0, **opp = 0;
+  u8 *key = 0, *data = 0, *digests = 0, iv[16] = { }, aad[12] = { };
+  u32 i, r, key_index, seed = 0xdeadbeef;
+  u16 key_len = cm->algs[otd->alg].key_length;
+  u64 t0, t1;
+
+  if (e->ops_handlers[opt] == 0)
+    return;
+
+  if (key_len == 0)
+    key_len = 20;
+  vec_validate (key, key_len - 1);
+  for (i = 0; i < key_len; i++)
+    key[i] = random_u32 (&seed);
+  key_index = vnet_crypto_key_add (vm, otd->alg, key, key_len);
+
+  vec_validate_aligned (data, a->n_buffers * a->buffer_size - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_validate (digests, a->n_buffers * 64);
+  vec_validate_aligned (ops, a->n_buffers - 1, CLIB_CACHE_LINE_BYTES);
+  vec_validate (opp, a->n_buffers - 1);
+
+  for (i = 0; i < a->n_buffers; i++)
+    {
+      vnet_crypto_op_init (ops + i, opt);
+      ops[i].key_index = key_index;
+      ops[i].iv = iv;
+      ops[i].src = ops[i].dst = data + i * a->buffer_size;
+      ops[i].len = a->buffer_size;
+      ops[i].aad = aad;
+      ops[i].aad_len = sizeof (aad);
+      ops[i].digest = digests + i * 64;
+      ops[i].tag_len = 16;
+      opp[i] = ops + i;
+    }
+
+  /* decrypting garbage fails the tag check after doing all the work */
+  t0 = clib_cpu_time_now ();
+  for (r = 0; r < a->rounds; r++)
+    e->ops_handlers[opt] (vm, opp, a->n_buffers);
+  t1 = clib_cpu_time_now ();
+
+  vlib_cli_output (vm, "%-20U%-10s%10.2f", format_vnet_crypto_op, opt,
+		   e->name, (f64) (t1 - t0) /
+		   ((f64) a->rounds * a->n_buffers * a->buffer_size));
+
+  vnet_crypto_key_del (vm, key_index);
+  vec_free (key);
+  vec_free (data);
+  vec_free (digests);
+  vec_free (ops);
+  vec_free (opp);
+}
+
+static clib_error_t *
+test_crypto_command_fn (vlib_main_t * vm,
+			unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  crypto_test_args_t _a = {
+    .n_buffers = 256,
+    .buffer_size = 1024,
+    .rounds = 100,
+  }, *a = &_a;
+  crypto_test_vector_t *tv;
+  vnet_crypto_engine_t *e;
+  vnet_crypto_op_id_t opt;
+  u32 n_fail = 0;
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = 0;
+  u8 *err = 0;
+  int rv;
+
+  if (unformat_user (input, unformat_line_input, line_input))
+    {
+      while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (line_input, "perf"))
+	    a->perf = 1;
+	  else if (unformat (line_input, "verbose"))
+	    a->verbose = 1;
+	  else if (unformat (line_input, "buffers %u", &a->n_buffers))
+	    ;
+	  else if (unformat (line_input, "size %u", &a->buffer_size))
+	    ;
+	  else if (unformat (line_input, "rounds %u", &a->rounds))
+	    ;
+	  else
+	    {
+	      error = clib_error_return (0, "unknown input '%U'",
+					 format_unformat_error, line_input);
+	      break;
+	    }
+	}
+      unformat_free (line_input);
+      if (error)
+	return error;
+    }
+
+  if (a->n_buffers == 0 || a->n_buffers > VLIB_FRAME_SIZE)
+    return clib_error_return (0, "buffers must be 1 - %u", VLIB_FRAME_SIZE);
+  if (a->buffer_size == 0 || a->buffer_size % 16)
+    return clib_error_return (0, "size must be a multiple of 16");
+
+  for (tv = crypto_test_vectors;
+       tv < crypto_test_vectors + ARRAY_LEN (crypto_test_vectors); tv++)
+    /* *INDENT-OFF* */
+    vec_foreach (e, cm->engines)
+      {
+	vec_reset_length (err);
+	rv = crypto_test_vector (vm, tv, e, &err);
+	if (rv < 0)
+	  continue;
+	if (rv)
+	  n_fail++;
+	if (rv || a->verbose)
+	  vlib_cli_output (vm, "%-24s%-10s%s %v", tv->name, e->name,
+			   rv ? "FAILED" : "OK", err);
+      }
+    /* *INDENT-ON* */
+
+  vlib_cli_output (vm, "known answer tests: %s",
+		   n_fail ? "FAILED" : "passed");
+
+  if (a->perf)
+    {
+      vlib_cli_output (vm, "%-20s%-10s%10s", "Op", "Engine", "Clk/byte");
+      for (opt = 1; opt < VNET_CRYPTO_N_OP_IDS; opt++)
+	/* *INDENT-OFF* */
+	vec_foreach (e, cm->engines)
+	  crypto_test_perf (vm, a, e, opt);
+	/* *INDENT-ON* */
+    }
+
+  vec_free (err);
+  return 0;
+}
+
+/*?
+ * Checks every registered crypto engine against known answer vectors and
+ * optionally measures the cost per byte of each operation each engine
+ * implements, on frames of @c buffers operations of @c size bytes.
+ *
+ * @cliexpar
+ * @cliexstart{test crypto perf buffers 256 size 1024}
+ * known answer tests: passed
+ * Op                  Engine      Clk/byte
+ * aes-128-cbc-enc     openssl         2.40
+ * aes-128-cbc-enc     native          1.35
+ * ...
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_crypto_command, static) =
+{
+  .path = "test crypto",
+  .short_help = "test crypto [perf] [verbose] [buffers <n>] [size <bytes>]"
+    " [rounds <n>]",
+  .function = test_crypto_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,175 @@
+/*
+ * aes.h : AES-NI key schedule and block helpers
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vnet_crypto_native_aes_h
+#define included_vnet_crypto_native_aes_h
+
+#include <x86intrin.h>
+
+typedef enum
+{
+  AES_KEY_128 = 0,
+  AES_KEY_192 = 1,
+  AES_KEY_256 = 2,
+} aes_key_size_t;
+
+#define AES_KEY_ROUNDS(x)	(10 + x * 2)
+#define AES_KEY_BYTES(x)	(16 + x * 8)
+
+static_always_inline u32
+aes_sub_word (u32 w)
+{
+  /* aeskeygenassist applies the S-box to dword 1 and returns it in dword 0 */
+  return _mm_cvtsi128_si32 (_mm_aeskeygenassist_si128
+			    (_mm_set_epi32 (0, 0, w, 0), 0));
+}
+
+/* FIPS-197 section 5.2; not on the data path so plain C is fine */
+static_always_inline void
+aes_key_expand (__m128i * k, const u8 * key, aes_key_size_t ks)
+{
+  u32 w[4 * (AES_KEY_ROUNDS (AES_KEY_256) + 1)];
+  int nk = AES_KEY_BYTES (ks) / 4;
+  int n = 4 * (AES_KEY_ROUNDS (ks) + 1);
+  u8 rcon = 1;
+  u32 t;
+  int i;
+
+  clib_memcpy (w, key, AES_KEY_BYTES (ks));
+
+  for (i = nk; i < n; i++)
+    {
+      t = w[i - 1];
+      if (i % nk == 0)
+	{
+	  t = aes_sub_word ((t >> 8) | (t << 24)) ^ rcon;
+	  rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0);
+	}
+      else if (nk > 6 && i % nk == 4)
+	t = aes_sub_word (t);
+      w[i] = w[i - nk] ^ t;
+    }
+
+  for (i = 0; i <= AES_KEY_ROUNDS (ks); i++)
+    k[i] = _mm_loadu_si128 ((__m128i *) (w + 4 * i));
+
+  memset (w, 0, sizeof (w));
+}
+
+/* equivalent inverse cipher key schedule, FIPS-197 section 5.3.5 */
+static_always_inline void
+aes_key_enc_to_dec (__m128i * dk, __m128i * ek, aes_key_size_t ks)
+{
+  int rounds = AES_KEY_ROUNDS (ks);
+  int i;
+
+  dk[0] = ek[rounds];
+  for (i = 1; i < rounds; i++)
+    dk[i] = _mm_aesimc_si128 (ek[rounds - i]);
+  dk[rounds] = ek[0];
+}
+
+static_always_inline __m128i
+aes_encrypt_block (__m128i r, __m128i * k, int rounds)
+{
+  int i;
+
+  r ^= k[0];
+  for (i = 1; i < rounds; i++)
+    r = _mm_aesenc_si128 (r, k[i]);
+  return _mm_aesenclast_si128 (r, k[rounds]);
+}
+
+static_always_inline __m128i
+aes_byte_swap (__m128i x)
+{
+  return _mm_shuffle_epi8 (x, _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+					    10, 11, 12, 13, 14, 15));
+}
+
+/*
+ * GHASH multiply in the bit reflected representation from the Intel
+ * "Carry-Less Multiplication and Its Usage for Computing the GCM Mode"
+ * white paper: operands are byte swapped blocks, the product is kept
+ * unreduced as (lo, hi) so several products can be summed before a single
+ * reduction.
+ */
+static_always_inline void
+ghash_mul_unreduced (__m128i a, __m128i b, __m128i * lo, __m128i * hi)
+{
+  __m128i t0, t1, m;
+
+  t0 = _mm_clmulepi64_si128 (a, b, 0x00);
+  t1 = _mm_clmulepi64_si128 (a, b, 0x11);
+  m = _mm_clmulepi64_si128 (a, b, 0x10) ^ _mm_clmulepi64_si128 (a, b, 0x01);
+
+  *lo ^= t0 ^ _mm_slli_si128 (m, 8);
+  *hi ^= t1 ^ _mm_srli_si128 (m, 8);
+}
+
+static_always_inline __m128i
+ghash_reduce (__m128i lo, __m128i hi)
+{
+  __m128i t0, t1, t2;
+
+  /* shift the 256 bit product left by one */
+  t0 = _mm_srli_epi32 (lo, 31);
+  t1 = _mm_srli_epi32 (hi, 31);
+  lo = _mm_slli_epi32 (lo, 1);
+  hi = _mm_slli_epi32 (hi, 1);
+  t2 = _mm_srli_si128 (t0, 12);
+  t1 = _mm_slli_si128 (t1, 4);
+  t0 = _mm_slli_si128 (t0, 4);
+  lo = _mm_or_si128 (lo, t0);
+  hi = _mm_or_si128 (hi, t1);
+  hi = _mm_or_si128 (hi, t2);
+
+  /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+  t0 = _mm_slli_epi32 (lo, 31);
+  t1 = _mm_slli_epi32 (lo, 30);
+  t2 = _mm_slli_epi32 (lo, 25);
+  t0 ^= t1 ^ t2;
+  t1 = _mm_srli_si128 (t0, 4);
+  t0 = _mm_slli_si128 (t0, 12);
+  lo ^= t0;
+
+  t0 = _mm_srli_epi32 (lo, 1);
+  t2 = _mm_srli_epi32 (lo, 2);
+  t0 ^= t2 ^ _mm_srli_epi32 (lo, 7) ^ t1;
+  lo ^= t0;
+
+  return hi ^ lo;
+}
+
+static_always_inline __m128i
+ghash_mul (__m128i a, __m128i b)
+{
+  __m128i lo = _mm_setzero_si128 (), hi = _mm_setzero_si128 ();
+
+  ghash_mul_unreduced (a, b, &lo, &hi);
+  return ghash_reduce (lo, hi);
+}
+
+#endif /* included_vnet_crypto_native_aes_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
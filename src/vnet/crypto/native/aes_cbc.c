@@ -0,0 +1,263 @@
+/*
+ * aes_cbc.c : native AES-CBC
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+#include <vnet/crypto/native/crypto_native.h>
+
+#define AES_CBC_N_LANES 4
+
+/*
+ * CBC encryption is serial within a packet, so AES round latency is hidden
+ * by encrypting one block of each of AES_CBC_N_LANES packets per round
+ * instead. A lane that runs out of data picks up the next operation.
+ */
+static_always_inline u32
+aes_ops_enc_aes_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     u32 n_ops, aes_key_size_t ks)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  int rounds = AES_KEY_ROUNDS (ks);
+  u8 dummy[16] __attribute__ ((aligned (16)));
+  vnet_crypto_op_t *lane_op[AES_CBC_N_LANES] = { };
+  __m128i r[AES_CBC_N_LANES] = { };
+  __m128i *k[AES_CBC_N_LANES];
+  u8 *src[AES_CBC_N_LANES], *dst[AES_CBC_N_LANES];
+  u32 len[AES_CBC_N_LANES] = { }, inc[AES_CBC_N_LANES] = { };
+  aes_cbc_key_data_t *kd;
+  u32 next_op = 0, n_active, n_bytes, i, j, b;
+
+  kd = cm->key_data[ops[0]->key_index];
+  for (i = 0; i < AES_CBC_N_LANES; i++)
+    {
+      k[i] = kd->encrypt_key;
+      src[i] = dst[i] = dummy;
+    }
+
+more:
+  n_active = 0;
+  n_bytes = ~0;
+  for (i = 0; i < AES_CBC_N_LANES; i++)
+    {
+      if (len[i] == 0)
+	{
+	  if (lane_op[i])
+	    {
+	      lane_op[i]->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+	      lane_op[i] = 0;
+	    }
+
+	  while (next_op < n_ops && ops[next_op]->len == 0)
+	    ops[next_op++]->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+
+	  if (next_op < n_ops)
+	    {
+	      vnet_crypto_op_t *op = ops[next_op++];
+	      kd = cm->key_data[op->key_index];
+	      lane_op[i] = op;
+	      k[i] = kd->encrypt_key;
+	      r[i] = _mm_loadu_si128 ((__m128i *) op->iv);
+	      src[i] = op->src;
+	      dst[i] = op->dst;
+	      len[i] = op->len;
+	      inc[i] = 16;
+	    }
+	  else
+	    {
+	      /* idle lane, spins on a dummy block */
+	      src[i] = dst[i] = dummy;
+	      inc[i] = 0;
+	    }
+	}
+
+      if (len[i])
+	{
+	  n_active++;
+	  n_bytes = clib_min (n_bytes, len[i]);
+	}
+    }
+
+  if (n_active == 0)
+    return n_ops;
+
+  for (b = 0; b < n_bytes; b += 16)
+    {
+      for (i = 0; i < AES_CBC_N_LANES; i++)
+	r[i] ^= _mm_loadu_si128 ((__m128i *) src[i]) ^ k[i][0];
+
+      for (j = 1; j < rounds; j++)
+	for (i = 0; i < AES_CBC_N_LANES; i++)
+	  r[i] = _mm_aesenc_si128 (r[i], k[i][j]);
+
+      for (i = 0; i < AES_CBC_N_LANES; i++)
+	{
+	  r[i] = _mm_aesenclast_si128 (r[i], k[i][rounds]);
+	  _mm_storeu_si128 ((__m128i *) dst[i], r[i]);
+	  src[i] += inc[i];
+	  dst[i] += inc[i];
+	}
+    }
+
+  for (i = 0; i < AES_CBC_N_LANES; i++)
+    if (len[i])
+      len[i] -= n_bytes;
+
+  goto more;
+}
+
+/* decryption has no chain dependency, 4 blocks of one packet at a time */
+static_always_inline void
+aes_cbc_dec (__m128i * k, u8 * src, u8 * dst, u8 * iv, int n_bytes,
+	     int rounds)
+{
+  __m128i r0, r1, r2, r3, c0, c1, c2, c3, f;
+  int i;
+
+  f = _mm_loadu_si128 ((__m128i *) iv);
+
+  while (n_bytes >= 64)
+    {
+      c0 = _mm_loadu_si128 ((__m128i *) src);
+      c1 = _mm_loadu_si128 ((__m128i *) (src + 16));
+      c2 = _mm_loadu_si128 ((__m128i *) (src + 32));
+      c3 = _mm_loadu_si128 ((__m128i *) (src + 48));
+
+      r0 = c0 ^ k[0];
+      r1 = c1 ^ k[0];
+      r2 = c2 ^ k[0];
+      r3 = c3 ^ k[0];
+
+      for (i = 1; i < rounds; i++)
+	{
+	  r0 = _mm_aesdec_si128 (r0, k[i]);
+	  r1 = _mm_aesdec_si128 (r1, k[i]);
+	  r2 = _mm_aesdec_si128 (r2, k[i]);
+	  r3 = _mm_aesdec_si128 (r3, k[i]);
+	}
+
+      r0 = _mm_aesdeclast_si128 (r0, k[rounds]);
+      r1 = _mm_aesdeclast_si128 (r1, k[rounds]);
+      r2 = _mm_aesdeclast_si128 (r2, k[rounds]);
+      r3 = _mm_aesdeclast_si128 (r3, k[rounds]);
+
+      _mm_storeu_si128 ((__m128i *) dst, r0 ^ f);
+      _mm_storeu_si128 ((__m128i *) (dst + 16), r1 ^ c0);
+      _mm_storeu_si128 ((__m128i *) (dst + 32), r2 ^ c1);
+      _mm_storeu_si128 ((__m128i *) (dst + 48), r3 ^ c2);
+
+      f = c3;
+      n_bytes -= 64;
+      src += 64;
+      dst += 64;
+    }
+
+  while (n_bytes > 0)
+    {
+      c0 = _mm_loadu_si128 ((__m128i *) src);
+      r0 = c0 ^ k[0];
+      for (i = 1; i < rounds; i++)
+	r0 = _mm_aesdec_si128 (r0, k[i]);
+      r0 = _mm_aesdeclast_si128 (r0, k[rounds]);
+      _mm_storeu_si128 ((__m128i *) dst, r0 ^ f);
+      f = c0;
+      n_bytes -= 16;
+      src += 16;
+      dst += 16;
+    }
+}
+
+static_always_inline u32
+aes_ops_dec_aes_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     u32 n_ops, aes_key_size_t ks)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  int rounds = AES_KEY_ROUNDS (ks);
+  vnet_crypto_op_t *op;
+  aes_cbc_key_data_t *kd;
+  u32 i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ops[i];
+      kd = cm->key_data[op->key_index];
+
+      if (i + 1 < n_ops)
+	CLIB_PREFETCH (ops[i + 1]->src, CLIB_CACHE_LINE_BYTES, LOAD);
+
+      ASSERT (op->len % 16 == 0);
+      aes_cbc_dec (kd->decrypt_key, op->src, op->dst, op->iv, op->len,
+		   rounds);
+      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+    }
+
+  return n_ops;
+}
+
+static void *
+aes_cbc_key_exp (vnet_crypto_key_t * key, aes_key_size_t ks)
+{
+  aes_cbc_key_data_t *kd;
+
+  kd = clib_mem_alloc_aligned (sizeof (*kd), CLIB_CACHE_LINE_BYTES);
+  memset (kd, 0, sizeof (*kd));
+  aes_key_expand (kd->encrypt_key, key->data, ks);
+  aes_key_enc_to_dec (kd->decrypt_key, kd->encrypt_key, ks);
+
+  return kd;
+}
+
+#define foreach_aes_cbc_handler_type _(128) _(192) _(256)
+
+#define _(x) \
+static u32 aes_ops_dec_aes_cbc_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
+{ return aes_ops_dec_aes_cbc (vm, ops, n_ops, AES_KEY_##x); } \
+static u32 aes_ops_enc_aes_cbc_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
+{ return aes_ops_enc_aes_cbc (vm, ops, n_ops, AES_KEY_##x); } \
+static void * aes_cbc_key_exp_##x (vnet_crypto_key_t *key) \
+{ return aes_cbc_key_exp (key, AES_KEY_##x); }
+
+foreach_aes_cbc_handler_type;
+#undef _
+
+clib_error_t *
+crypto_native_aes_cbc_init (vlib_main_t * vm)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+
+#define _(x) \
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
+				    VNET_CRYPTO_OP_AES_##x##_CBC_ENC, \
+				    aes_ops_enc_aes_cbc_##x); \
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
+				    VNET_CRYPTO_OP_AES_##x##_CBC_DEC, \
+				    aes_ops_dec_aes_cbc_##x); \
+  cm->key_fn[VNET_CRYPTO_ALG_AES_##x##_CBC] = aes_cbc_key_exp_##x;
+  foreach_aes_cbc_handler_type;
+#undef _
+
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
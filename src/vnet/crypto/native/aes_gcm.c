@@ -0,0 +1,297 @@
+/*
+ * aes_gcm.c : native AES-GCM
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+#include <vnet/crypto/native/crypto_native.h>
+
+/* loads up to 16 bytes without reading past the end of the data */
+static_always_inline __m128i
+aes_gcm_load_partial (u8 * p, int n_bytes)
+{
+  u8 tmp[16] = { };
+
+  clib_memcpy (tmp, p, n_bytes);
+  return _mm_loadu_si128 ((__m128i *) tmp);
+}
+
+static_always_inline void
+aes_gcm_store_partial (u8 * p, __m128i r, int n_bytes)
+{
+  u8 tmp[16];
+
+  _mm_storeu_si128 ((__m128i *) tmp, r);
+  clib_memcpy (p, tmp, n_bytes);
+}
+
+/* ghash of n_bytes of data, the last block zero padded */
+static_always_inline __m128i
+aes_gcm_ghash (__m128i T, aes_gcm_key_data_t * kd, u8 * data, int n_bytes)
+{
+  __m128i lo, hi;
+
+  while (n_bytes >= 64)
+    {
+      lo = hi = _mm_setzero_si128 ();
+      ghash_mul_unreduced (T ^ aes_byte_swap (_mm_loadu_si128
+					      ((__m128i *) data)),
+			   kd->Hi[0], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (_mm_loadu_si128
+					  ((__m128i *) (data + 16))),
+			   kd->Hi[1], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (_mm_loadu_si128
+					  ((__m128i *) (data + 32))),
+			   kd->Hi[2], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (_mm_loadu_si128
+					  ((__m128i *) (data + 48))),
+			   kd->Hi[3], &lo, &hi);
+      T = ghash_reduce (lo, hi);
+      n_bytes -= 64;
+      data += 64;
+    }
+
+  while (n_bytes >= 16)
+    {
+      T = ghash_mul (T ^ aes_byte_swap (_mm_loadu_si128 ((__m128i *) data)),
+		     kd->Hi[3]);
+      n_bytes -= 16;
+      data += 16;
+    }
+
+  if (n_bytes)
+    T = ghash_mul (T ^ aes_byte_swap (aes_gcm_load_partial (data, n_bytes)),
+		   kd->Hi[3]);
+
+  return T;
+}
+
+static_always_inline __m128i
+aes_gcm_ctr_block (__m128i Y, u32 ctr)
+{
+  return _mm_insert_epi32 (Y, clib_host_to_net_u32 (ctr), 3);
+}
+
+/*
+ * CTR mode over the payload, 4 blocks per iteration so the AES rounds of
+ * independent blocks overlap. The ciphertext is hashed in the same pass:
+ * on encrypt after it is produced, on decrypt as it is read.
+ */
+static_always_inline __m128i
+aes_gcm_crypt (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, u8 * src,
+	       u8 * dst, u32 n_bytes, int rounds, int is_encrypt)
+{
+  __m128i *k = kd->encrypt_key;
+  __m128i r0, r1, r2, r3, d0, d1, d2, d3, lo, hi;
+  u32 ctr = 2;
+  int i;
+
+  while (n_bytes >= 64)
+    {
+      r0 = aes_gcm_ctr_block (Y, ctr) ^ k[0];
+      r1 = aes_gcm_ctr_block (Y, ctr + 1) ^ k[0];
+      r2 = aes_gcm_ctr_block (Y, ctr + 2) ^ k[0];
+      r3 = aes_gcm_ctr_block (Y, ctr + 3) ^ k[0];
+      ctr += 4;
+
+      for (i = 1; i < rounds; i++)
+	{
+	  r0 = _mm_aesenc_si128 (r0, k[i]);
+	  r1 = _mm_aesenc_si128 (r1, k[i]);
+	  r2 = _mm_aesenc_si128 (r2, k[i]);
+	  r3 = _mm_aesenc_si128 (r3, k[i]);
+	}
+
+      d0 = _mm_loadu_si128 ((__m128i *) src);
+      d1 = _mm_loadu_si128 ((__m128i *) (src + 16));
+      d2 = _mm_loadu_si128 ((__m128i *) (src + 32));
+      d3 = _mm_loadu_si128 ((__m128i *) (src + 48));
+
+      r0 = _mm_aesenclast_si128 (r0, k[rounds]) ^ d0;
+      r1 = _mm_aesenclast_si128 (r1, k[rounds]) ^ d1;
+      r2 = _mm_aesenclast_si128 (r2, k[rounds]) ^ d2;
+      r3 = _mm_aesenclast_si128 (r3, k[rounds]) ^ d3;
+
+      _mm_storeu_si128 ((__m128i *) dst, r0);
+      _mm_storeu_si128 ((__m128i *) (dst + 16), r1);
+      _mm_storeu_si128 ((__m128i *) (dst + 32), r2);
+      _mm_storeu_si128 ((__m128i *) (dst + 48), r3);
+
+      if (is_encrypt)
+	{
+	  d0 = r0;
+	  d1 = r1;
+	  d2 = r2;
+	  d3 = r3;
+	}
+
+      lo = hi = _mm_setzero_si128 ();
+      ghash_mul_unreduced (T ^ aes_byte_swap (d0), kd->Hi[0], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (d1), kd->Hi[1], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (d2), kd->Hi[2], &lo, &hi);
+      ghash_mul_unreduced (aes_byte_swap (d3), kd->Hi[3], &lo, &hi);
+      T = ghash_reduce (lo, hi);
+
+      n_bytes -= 64;
+      src += 64;
+      dst += 64;
+    }
+
+  while (n_bytes)
+    {
+      int n = clib_min (n_bytes, 16);
+
+      r0 = aes_encrypt_block (aes_gcm_ctr_block (Y, ctr++), k, rounds);
+      d0 = aes_gcm_load_partial (src, n);
+      r0 ^= d0;
+      aes_gcm_store_partial (dst, r0, n);
+
+      if (is_encrypt)
+	d0 = aes_gcm_load_partial (dst, n);
+
+      T = ghash_mul (T ^ aes_byte_swap (d0), kd->Hi[3]);
+
+      n_bytes -= n;
+      src += n;
+      dst += n;
+    }
+
+  return T;
+}
+
+static_always_inline int
+aes_gcm (vnet_crypto_op_t * op, aes_gcm_key_data_t * kd, int rounds,
+	 int is_encrypt)
+{
+  u8 tag[16];
+  __m128i T, Y, L;
+  int tag_len = op->tag_len ? op->tag_len : 16;
+
+  /* Y0 = IV || 0^31 || 1 */
+  Y = aes_gcm_load_partial (op->iv, 12);
+  Y = aes_gcm_ctr_block (Y, 1);
+
+  T = aes_gcm_ghash (_mm_setzero_si128 (), kd, op->aad, op->aad_len);
+  T = aes_gcm_crypt (T, kd, Y, op->src, op->dst, op->len, rounds,
+		     is_encrypt);
+
+  /* bit lengths of AAD and ciphertext, already in byte swapped form */
+  L = _mm_set_epi64x ((u64) op->aad_len << 3, (u64) op->len << 3);
+  T = ghash_mul (T ^ L, kd->Hi[3]);
+
+  T = aes_byte_swap (T) ^ aes_encrypt_block (Y, kd->encrypt_key, rounds);
+  _mm_storeu_si128 ((__m128i *) tag, T);
+
+  if (is_encrypt)
+    {
+      clib_memcpy (op->tag, tag, tag_len);
+      return 1;
+    }
+
+  return memcmp (op->tag, tag, tag_len) == 0;
+}
+
+static_always_inline u32
+aes_ops_aes_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+		 aes_key_size_t ks, int is_encrypt)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  int rounds = AES_KEY_ROUNDS (ks);
+  vnet_crypto_op_t *op;
+  u32 i, n_fail = 0;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ops[i];
+
+      if (i + 1 < n_ops)
+	CLIB_PREFETCH (ops[i + 1]->src, CLIB_CACHE_LINE_BYTES, LOAD);
+
+      if (aes_gcm (op, cm->key_data[op->key_index], rounds, is_encrypt))
+	op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+      else
+	{
+	  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+	  n_fail++;
+	}
+    }
+
+  return n_ops - n_fail;
+}
+
+static void *
+aes_gcm_key_exp (vnet_crypto_key_t * key, aes_key_size_t ks)
+{
+  aes_gcm_key_data_t *kd;
+  __m128i H;
+
+  kd = clib_mem_alloc_aligned (sizeof (*kd), CLIB_CACHE_LINE_BYTES);
+  memset (kd, 0, sizeof (*kd));
+  aes_key_expand (kd->encrypt_key, key->data, ks);
+
+  /* H = E(K, 0^128) */
+  H = aes_encrypt_block (_mm_setzero_si128 (), kd->encrypt_key,
+			 AES_KEY_ROUNDS (ks));
+  H = aes_byte_swap (H);
+  kd->Hi[3] = H;
+  kd->Hi[2] = ghash_mul (kd->Hi[3], H);
+  kd->Hi[1] = ghash_mul (kd->Hi[2], H);
+  kd->Hi[0] = ghash_mul (kd->Hi[1], H);
+
+  return kd;
+}
+
+#define foreach_aes_gcm_handler_type _(128) _(192) _(256)
+
+#define _(x) \
+static u32 aes_ops_dec_aes_gcm_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
+{ return aes_ops_aes_gcm (vm, ops, n_ops, AES_KEY_##x, 0); } \
+static u32 aes_ops_enc_aes_gcm_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
+{ return aes_ops_aes_gcm (vm, ops, n_ops, AES_KEY_##x, 1); } \
+static void * aes_gcm_key_exp_##x (vnet_crypto_key_t *key) \
+{ return aes_gcm_key_exp (key, AES_KEY_##x); }
+
+foreach_aes_gcm_handler_type;
+#undef _
+
+clib_error_t *
+crypto_native_aes_gcm_init (vlib_main_t * vm)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+
+#define _(x) \
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
+				    VNET_CRYPTO_OP_AES_##x##_GCM_ENC, \
+				    aes_ops_enc_aes_gcm_##x); \
+  vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
+				    VNET_CRYPTO_OP_AES_##x##_GCM_DEC, \
+				    aes_ops_dec_aes_gcm_##x); \
+  cm->key_fn[VNET_CRYPTO_ALG_AES_##x##_GCM] = aes_gcm_key_exp_##x;
+  foreach_aes_gcm_handler_type;
+#undef _
+
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,60 @@
+/*
+ * crypto_native.h : native (AES-NI) crypto engine
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vnet_crypto_native_crypto_native_h
+#define included_vnet_crypto_native_crypto_native_h
+
+#include <vnet/crypto/crypto.h>
+#include <vnet/crypto/native/aes.h>
+
+typedef struct
+{
+  __m128i encrypt_key[AES_KEY_ROUNDS (AES_KEY_256) + 1];
+  __m128i decrypt_key[AES_KEY_ROUNDS (AES_KEY_256) + 1];
+} aes_cbc_key_data_t;
+
+typedef struct
+{
+  __m128i encrypt_key[AES_KEY_ROUNDS (AES_KEY_256) + 1];
+  /* byte swapped H^4, H^3, H^2, H for 4 block aggregated GHASH */
+  __m128i Hi[4];
+} aes_gcm_key_data_t;
+
+typedef void *(crypto_native_key_fn_t) (vnet_crypto_key_t * key);
+
+typedef struct
+{
+  u32 crypto_engine_index;
+  crypto_native_key_fn_t *key_fn[VNET_CRYPTO_N_ALGS];
+  /* expanded keys, indexed by crypto key index */
+  void **key_data;
+} crypto_native_main_t;
+
+extern crypto_native_main_t crypto_native_main;
+
+clib_error_t *crypto_native_aes_cbc_init (vlib_main_t * vm);
+clib_error_t *crypto_native_aes_gcm_init (vlib_main_t * vm);
+
+#endif /* included_vnet_crypto_native_crypto_native_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,85 @@
+/*
+ * main.c : native (AES-NI) crypto engine
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+#include <vnet/crypto/native/crypto_native.h>
+
+crypto_native_main_t crypto_native_main;
+
+static void
+crypto_native_key_handler (vlib_main_t * vm, vnet_crypto_key_op_t kop,
+			   u32 key_index)
+{
+  vnet_crypto_key_t *key = vnet_crypto_get_key (key_index);
+  crypto_native_main_t *cm = &crypto_native_main;
+
+  if (cm->key_fn[key->alg] == 0)
+    return;
+
+  if (kop == VNET_CRYPTO_KEY_OP_DEL)
+    {
+      if (key_index >= vec_len (cm->key_data) || !cm->key_data[key_index])
+	return;
+      memset (cm->key_data[key_index], 0,
+	      clib_mem_size (cm->key_data[key_index]));
+      clib_mem_free (cm->key_data[key_index]);
+      cm->key_data[key_index] = 0;
+      return;
+    }
+
+  vec_validate_aligned (cm->key_data, key_index, CLIB_CACHE_LINE_BYTES);
+  cm->key_data[key_index] = cm->key_fn[key->alg] (key);
+}
+
+static clib_error_t *
+crypto_native_init (vlib_main_t * vm)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  clib_error_t *error;
+
+  if ((error = vlib_call_init_function (vm, vnet_crypto_init)))
+    return error;
+
+  /* GCM needs PCLMULQDQ as well, every AES-NI capable cpu has it */
+  if (!clib_cpu_supports_x86_aes () || !clib_cpu_supports_pclmulqdq ())
+    return 0;
+
+  cm->crypto_engine_index =
+    vnet_crypto_register_engine (vm, "native", 100,
+				 "Native AES-NI multi-buffer engine");
+
+  if ((error = crypto_native_aes_cbc_init (vm)))
+    return error;
+
+  if ((error = crypto_native_aes_gcm_init (vm)))
+    return error;
+
+  vnet_crypto_register_key_handler (vm, cm->crypto_engine_index,
+				    crypto_native_key_handler);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (crypto_native_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -44,18 +44,26 @@ af_packet_main_t af_packet_main;
 #define AF_PACKET_TX_BLOCK_SIZE	 	(AF_PACKET_TX_FRAME_SIZE * \
 					 AF_PACKET_TX_FRAMES_PER_BLOCK)
 
-#define AF_PACKET_RX_FRAMES_PER_BLOCK	1024
+/* TPACKET_V3 packs frames back to back, so a block holds far more than
+   AF_PACKET_RX_FRAMES_PER_BLOCK small packets. The frame size only caps
+   the largest packet. */
+#define AF_PACKET_RX_FRAMES_PER_BLOCK	32
 #define AF_PACKET_RX_FRAME_SIZE	 	(2048 * 5)
-#define AF_PACKET_RX_BLOCK_NR		1
+#define AF_PACKET_RX_BLOCK_NR		32
 #define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
 #define AF_PACKET_RX_BLOCK_SIZE		(AF_PACKET_RX_FRAME_SIZE * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
+/* kernel hands over a partially filled block after this many ms */
+#define AF_PACKET_RX_BLOCK_TIMEOUT_MS	1
+
+#define AF_PACKET_MAX_RX_QUEUES		64
 
 /*defined in net/if.h but clashes with dpdk headers */
 unsigned int if_nametoindex (const char *ifname);
 
 typedef struct tpacket_req tpacket_req_t;
+typedef struct tpacket_req3 tpacket_req3_t;
 
 static u32
 af_packet_eth_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hi,
@@ -92,14 +100,15 @@ af_packet_fd_read_ready (clib_file_t * uf)
 {
   af_packet_main_t *apm = &af_packet_main;
   vnet_main_t *vnm = vnet_get_main ();
-  u32 idx = uf->private_data;
+  u32 idx = uf->private_data >> 16;
+  u16 qid = uf->private_data & 0xFFFF;
   af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, idx);
 
   apm->pending_input_bitmap =
     clib_bitmap_set (apm->pending_input_bitmap, idx, 1);
 
   /* Schedule the rx node */
-  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, 0);
+  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, qid);
 
   return 0;
 }
@@ -124,64 +133,124 @@ is_bridge (const u8 * host_if_name)
 }
 
 static int
-create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
-		       tpacket_req_t * tx_req, int *fd, u8 ** ring)
+create_packet_sock (int host_if_index, int protocol, int ver, int *fd)
 {
   af_packet_main_t *apm = &af_packet_main;
-  int ret, err;
   struct sockaddr_ll sll;
-  int ver = TPACKET_V2;
-  socklen_t req_sz = sizeof (struct tpacket_req);
-  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr +
-    tx_req->tp_block_size * tx_req->tp_block_nr;
+  int err;
 
-  if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
+  if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (protocol))) < 0)
     {
       vlib_log_debug (apm->log_class, "Failed to create socket");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
-      goto error;
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
     }
 
   /* bind before rx ring is cfged so we don't receive packets from other interfaces */
   memset (&sll, 0, sizeof (sll));
   sll.sll_family = PF_PACKET;
-  sll.sll_protocol = htons (ETH_P_ALL);
+  sll.sll_protocol = htons (protocol);
   sll.sll_ifindex = host_if_index;
   if ((err = bind (*fd, (struct sockaddr *) &sll, sizeof (sll))) < 0)
     {
       vlib_log_debug (apm->log_class,
-		      "Failed to bind rx packet socket (error %d)", err);
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
-      goto error;
+		      "Failed to bind packet socket (error %d)", err);
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
     }
 
   if ((err =
        setsockopt (*fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof (ver))) < 0)
     {
       vlib_log_debug (apm->log_class,
-		      "Failed to set rx packet interface version");
+		      "Failed to set packet interface version");
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
+    }
+
+  return 0;
+}
+
+static int
+create_packet_v3_rx_sock (int host_if_index, tpacket_req3_t * rx_req,
+			  u16 fanout_id, int *fd, u8 ** ring)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  int ret, err;
+  socklen_t req_sz = sizeof (struct tpacket_req3);
+  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr;
+
+  if ((ret = create_packet_sock (host_if_index, ETH_P_ALL, TPACKET_V3, fd)))
+    goto error;
+
+  if ((err =
+       setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz)) < 0)
+    {
+      vlib_log_debug (apm->log_class, "Failed to set packet rx ring options");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
-  int opt = 1;
-  if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
+  *ring =
+    mmap (NULL, ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, *fd,
+	  0);
+  if (*ring == MAP_FAILED)
     {
-      vlib_log_debug (apm->log_class,
-		      "Failed to set packet tx ring error handling option");
+      vlib_log_debug (apm->log_class, "mmap failure");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
+  /* spread flows over the queues, fragments stay with their flow */
+  if (fanout_id)
+    {
+      int opt = fanout_id | ((PACKET_FANOUT_HASH |
+			      PACKET_FANOUT_FLAG_DEFRAG) << 16);
+      if ((err = setsockopt (*fd, SOL_PACKET, PACKET_FANOUT, &opt,
+			     sizeof (opt))) < 0)
+	{
+	  vlib_log_debug (apm->log_class, "Failed to join fanout group %u",
+			  fanout_id);
+	  munmap (*ring, ring_sz);
+	  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  goto error;
+	}
+    }
+
+  return 0;
+error:
+  if (*fd >= 0)
+    close (*fd);
+  *fd = -1;
+  return ret;
+}
+
+static int
+create_packet_v2_tx_sock (int host_if_index, tpacket_req_t * tx_req,
+			  int *fd, u8 ** ring)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  int ret, err;
+  socklen_t req_sz = sizeof (struct tpacket_req);
+  u32 ring_sz = tx_req->tp_block_size * tx_req->tp_block_nr;
+
+  /* protocol 0, the tx socket never receives anything */
+  if ((ret = create_packet_sock (host_if_index, 0, TPACKET_V2, fd)))
+    goto error;
+
+  int opt = 1;
   if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz)) < 0)
+       setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
     {
-      vlib_log_debug (apm->log_class, "Failed to set packet rx ring options");
+      vlib_log_debug (apm->log_class,
+		      "Failed to set packet tx ring error handling option");
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
+  /* hand frames straight to the driver, we do our own queueing */
+  if ((err = setsockopt (*fd, SOL_PACKET, PACKET_QDISC_BYPASS, &opt,
+			 sizeof (opt))) < 0)
+    vlib_log_debug (apm->log_class,
+		    "Failed to set qdisc bypass, using kernel qdisc");
+
   if ((err =
        setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz)) < 0)
     {
@@ -208,17 +277,45 @@ error:
   return ret;
 }
 
+static void
+af_packet_free_rx_queues (af_packet_if_t * apif)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  af_packet_queue_t *q;
+  u32 ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr;
+
+  vec_foreach (q, apif->rx_queues)
+  {
+    if (q->clib_file_index != ~0)
+      {
+	clib_file_del (&file_main, file_main.file_pool + q->clib_file_index);
+	q->clib_file_index = ~0;
+      }
+    else if (q->fd >= 0)
+      close (q->fd);
+    q->fd = -1;
+
+    if (q->rx_ring && munmap (q->rx_ring, ring_sz))
+      vlib_log_warn (apm->log_class,
+		     "Host interface %s could not free rx ring %u",
+		     apif->host_if_name, q->queue_id);
+    q->rx_ring = NULL;
+  }
+  vec_free (apif->rx_queues);
+}
+
 int
 af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
-		     u32 * sw_if_index)
+		     u32 num_rx_queues, u32 * sw_if_index)
 {
   af_packet_main_t *apm = &af_packet_main;
   int ret, fd = -1, fd2 = -1;
-  struct tpacket_req *rx_req = 0;
+  struct tpacket_req3 *rx_req = 0;
   struct tpacket_req *tx_req = 0;
   struct ifreq ifr;
-  u8 *ring = 0;
+  u8 *tx_ring = 0;
   af_packet_if_t *apif = 0;
+  af_packet_queue_t *q;
   u8 hw_addr[6];
   clib_error_t *error;
   vnet_sw_interface_t *sw;
@@ -227,8 +324,9 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_main_t *vnm = vnet_get_main ();
   uword *p;
   uword if_index;
-  u8 *host_if_name_dup = vec_dup (host_if_name);
+  u8 *host_if_name_dup = 0;
   int host_if_index = -1;
+  u32 i;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p)
@@ -238,11 +336,19 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       return VNET_API_ERROR_IF_ALREADY_EXISTS;
     }
 
+  if (num_rx_queues == 0)
+    num_rx_queues = 1;
+  if (num_rx_queues > AF_PACKET_MAX_RX_QUEUES)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  host_if_name_dup = vec_dup (host_if_name);
+
   vec_validate (rx_req, 0);
   rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
   rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
   rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
   rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+  rx_req->tp_retire_blk_tov = AF_PACKET_RX_BLOCK_TIMEOUT_MS;
 
   vec_validate (tx_req, 0);
   tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
@@ -266,8 +372,8 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   if ((ret = ioctl (fd2, SIOCGIFINDEX, &ifr)) < 0)
     {
       vlib_log_debug (apm->log_class, "af_packet_create error: %d", ret);
-      close (fd2);
-      return VNET_API_ERROR_INVALID_INTERFACE;
+      ret = VNET_API_ERROR_INVALID_INTERFACE;
+      goto error;
     }
 
   host_if_index = ifr.ifr_ifindex;
@@ -289,46 +395,76 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (fd2 > -1)
     close (fd2);
+  fd2 = -1;
 
-  ret = create_packet_v2_sock (host_if_index, rx_req, tx_req, &fd, &ring);
+  ret = create_packet_v2_tx_sock (host_if_index, tx_req, &fd, &tx_ring);
 
   if (ret != 0)
     goto error;
 
-  ret = is_bridge (host_if_name);
-
-  if (ret == 0)			/* is a bridge, ignore state */
-    host_if_index = -1;
-
   /* So far everything looks good, let's create interface */
   pool_get (apm->interfaces, apif);
   if_index = apif - apm->interfaces;
 
-  apif->host_if_index = host_if_index;
   apif->fd = fd;
-  apif->rx_ring = ring;
-  apif->tx_ring = ring + rx_req->tp_block_size * rx_req->tp_block_nr;
+  apif->tx_ring = tx_ring;
   apif->rx_req = rx_req;
   apif->tx_req = tx_req;
   apif->host_if_name = host_if_name_dup;
   apif->per_interface_next_index = ~0;
   apif->next_tx_frame = 0;
-  apif->next_rx_frame = 0;
+  apif->rx_queues = 0;
 
-  if (tm->n_vlib_mains > 1)
-    clib_spinlock_init (&apif->lockp);
+  /* one rx socket per queue, the kernel hashes flows across them */
+  apif->fanout_id = 0;
+  if (num_rx_queues > 1)
+    {
+      apif->fanout_id = (getpid () ^ (if_index << 10)) & 0xFFFF;
+      if (apif->fanout_id == 0)
+	apif->fanout_id = 1;
+    }
+
+  vec_validate_aligned (apif->rx_queues, num_rx_queues - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (q, apif->rx_queues)
+  {
+    q->fd = -1;
+    q->clib_file_index = ~0;
+    q->queue_id = q - apif->rx_queues;
+  }
 
+  vec_foreach (q, apif->rx_queues)
   {
     clib_file_t template = { 0 };
+
+    ret = create_packet_v3_rx_sock (host_if_index, rx_req, apif->fanout_id,
+				    &q->fd, &q->rx_ring);
+    if (ret != 0)
+      {
+	q->rx_ring = 0;
+	goto error_free_if;
+      }
+
     template.read_function = af_packet_fd_read_ready;
-    template.file_descriptor = fd;
-    template.private_data = if_index;
+    template.file_descriptor = q->fd;
+    template.private_data = (if_index << 16) | q->queue_id;
     template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
-    template.description = format (0, "%U", format_af_packet_device_name,
-				   if_index);
-    apif->clib_file_index = clib_file_add (&file_main, &template);
+    template.description = format (0, "%U queue %u",
+				   format_af_packet_device_name, if_index,
+				   q->queue_id);
+    q->clib_file_index = clib_file_add (&file_main, &template);
   }
 
+  ret = is_bridge (host_if_name);
+
+  if (ret == 0)			/* is a bridge, ignore state */
+    host_if_index = -1;
+
+  apif->host_if_index = host_if_index;
+
+  if (tm->n_vlib_mains > 1)
+    clib_spinlock_init (&apif->lockp);
+
   /*use configured or generate random MAC address */
   if (hw_addr_set)
     clib_memcpy (hw_addr, hw_addr_set, 6);
@@ -350,13 +486,11 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (error)
     {
-      memset (apif, 0, sizeof (*apif));
-      pool_put (apm->interfaces, apif);
       vlib_log_err (apm->log_class, "Unable to register interface: %U",
 		    format_clib_error, error);
       clib_error_free (error);
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
-      goto error;
+      goto error_free_if;
     }
 
   sw = vnet_get_hw_sw_interface (vnm, apif->hw_if_index);
@@ -365,15 +499,17 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_hw_interface_set_input_node (vnm, apif->hw_if_index,
 				    af_packet_input_node.index);
 
-  vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, 0,	/* queue */
-				      ~0 /* any cpu */ );
+  for (i = 0; i < num_rx_queues; i++)
+    vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, i,
+					~0 /* any cpu */ );
 
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
 
-  vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, 0,
-				 VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
+  for (i = 0; i < num_rx_queues; i++)
+    vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, i,
+				   VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
 
   mhash_set_mem (&apm->if_index_by_host_if_name, host_if_name_dup, &if_index,
 		 0);
@@ -382,6 +518,12 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   return 0;
 
+error_free_if:
+  af_packet_free_rx_queues (apif);
+  munmap (tx_ring, tx_req->tp_block_size * tx_req->tp_block_nr);
+  close (fd);
+  memset (apif, 0, sizeof (*apif));
+  pool_put (apm->interfaces, apif);
 error:
   if (fd2 > -1)
     close (fd2);
@@ -397,6 +539,7 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   vnet_main_t *vnm = vnet_get_main ();
   af_packet_main_t *apm = &af_packet_main;
   af_packet_if_t *apif;
+  af_packet_queue_t *q;
   uword *p;
   uword if_index;
   u32 ring_sz;
@@ -413,24 +556,19 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
 
   /* bring down the interface */
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index, 0);
-  vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, 0);
+  vec_foreach (q, apif->rx_queues)
+    vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index,
+					  q->queue_id);
 
   /* clean up */
-  if (apif->clib_file_index != ~0)
-    {
-      clib_file_del (&file_main, file_main.file_pool + apif->clib_file_index);
-      apif->clib_file_index = ~0;
-    }
-  else
-    close (apif->fd);
+  af_packet_free_rx_queues (apif);
 
-  ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
-    apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
-  if (munmap (apif->rx_ring, ring_sz))
+  ring_sz = apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
+  if (munmap (apif->tx_ring, ring_sz))
     vlib_log_warn (apm->log_class,
-		   "Host interface %s could not free rx/tx ring",
+		   "Host interface %s could not free tx ring",
 		   host_if_name);
-  apif->rx_ring = NULL;
+  close (apif->fd);
   apif->tx_ring = NULL;
   apif->fd = -1;
 
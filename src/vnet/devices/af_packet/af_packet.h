@@ -27,22 +27,38 @@ typedef struct
   u8 host_if_name[64];
 } af_packet_if_detail_t;
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* TPACKET_V3 rx socket, member of the interface fanout group */
+  int fd;
+  u8 *rx_ring;
+  u32 clib_file_index;
+  u16 queue_id;
+
+  u32 next_rx_block;
+  /* position inside a block which was only partially consumed */
+  u32 next_rx_pkt;
+  u32 next_rx_offset;
+} af_packet_queue_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_spinlock_t lockp;
   u8 *host_if_name;
   int host_if_index;
+  /* TPACKET_V2 tx socket, bypasses the kernel qdisc layer */
   int fd;
-  struct tpacket_req *rx_req;
+  struct tpacket_req3 *rx_req;
   struct tpacket_req *tx_req;
-  u8 *rx_ring;
   u8 *tx_ring;
   u32 hw_if_index;
   u32 sw_if_index;
-  u32 clib_file_index;
 
-  u32 next_rx_frame;
+  af_packet_queue_t *rx_queues;
+  u16 fanout_id;
+
   u32 next_tx_frame;
 
   u32 per_interface_next_index;
@@ -72,7 +88,8 @@ extern vnet_device_class_t af_packet_device_class;
 extern vlib_node_registration_t af_packet_input_node;
 
 int af_packet_create_if (vlib_main_t * vm, u8 * host_if_name,
-			 u8 * hw_addr_set, u32 * sw_if_index);
+			 u8 * hw_addr_set, u32 num_rx_queues,
+			 u32 * sw_if_index);
 int af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name);
 int af_packet_set_l4_cksum_offload (vlib_main_t * vm, u32 sw_if_index,
 				    u8 set);
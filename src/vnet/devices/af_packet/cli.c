@@ -48,6 +48,7 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   u8 hwaddr[6];
   u8 *hw_addr_ptr = 0;
   u32 sw_if_index;
+  u32 num_rx_queues = 1;
   int r;
   clib_error_t *error = NULL;
 
@@ -63,6 +64,8 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	if (unformat
 	    (line_input, "hw-addr %U", unformat_ethernet_address, hwaddr))
 	hw_addr_ptr = hwaddr;
+      else if (unformat (line_input, "num-rx-queues %u", &num_rx_queues))
+	;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -77,7 +80,8 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       goto done;
     }
 
-  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, &sw_if_index);
+  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, num_rx_queues,
+			   &sw_if_index);
 
   if (r == VNET_API_ERROR_SYSCALL_ERROR_1)
     {
@@ -91,6 +95,12 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       goto done;
     }
 
+  if (r == VNET_API_ERROR_INVALID_VALUE)
+    {
+      error = clib_error_return (0, "Invalid number of rx queues");
+      goto done;
+    }
+
   if (r == VNET_API_ERROR_SUBIF_ALREADY_EXISTS)
     {
       error = clib_error_return (0, "Interface elready exists");
@@ -119,6 +129,10 @@ done:
  *
  * - <b>hw-addr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
+ * - <b>num-rx-queues <n></b> - Optional number of receive queues. Each
+ * queue is a separate TPACKET_V3 socket, the kernel spreads flows over
+ * them with PACKET_FANOUT and the queues are placed on worker threads
+ * like any other device queue.
  *
  * @cliexpar
  * Example of how to create a host interface tied to one side of an
@@ -132,7 +146,8 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (af_packet_create_command, static) = {
   .path = "create host-interface",
-  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>]",
+  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>] "
+    "[num-rx-queues <n>]",
   .function = af_packet_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -65,7 +65,19 @@ format_af_packet_device_name (u8 * s, va_list * args)
 static u8 *
 format_af_packet_device (u8 * s, va_list * args)
 {
+  u32 dev_instance = va_arg (*args, u32);
+  CLIB_UNUSED (int verbose) = va_arg (*args, int);
+  af_packet_main_t *apm = &af_packet_main;
+  af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, dev_instance);
+  u32 indent = format_get_indent (s);
+
   s = format (s, "Linux PACKET socket interface");
+  s = format (s, "\n%Urx: TPACKET_V3, %u queues", format_white_space,
+	      indent + 2, vec_len (apif->rx_queues));
+  if (apif->fanout_id)
+    s = format (s, ", fanout group %u", apif->fanout_id);
+  s = format (s, "\n%Utx: TPACKET_V2", format_white_space,
+	      indent + 2);
   return s;
 }
 
@@ -50,8 +50,8 @@ typedef struct
 {
   u32 next_index;
   u32 hw_if_index;
-  int block;
-  struct tpacket2_hdr tph;
+  u16 queue_id;
+  struct tpacket3_hdr tph;
 } af_packet_input_trace_t;
 
 static u8 *
@@ -62,13 +62,13 @@ format_af_packet_input_trace (u8 * s, va_list * args)
   af_packet_input_trace_t *t = va_arg (*args, af_packet_input_trace_t *);
   u32 indent = format_get_indent (s);
 
-  s = format (s, "af_packet: hw_if_index %d next-index %d",
-	      t->hw_if_index, t->next_index);
+  s = format (s, "af_packet: hw_if_index %d queue %u next-index %d",
+	      t->hw_if_index, t->queue_id, t->next_index);
 
   s =
     format (s,
-	    "\n%Utpacket2_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
-	    "\n%Usec 0x%x nsec 0x%x vlan %U"
+	    "\n%Utpacket3_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
+	    "\n%Usec 0x%x nsec 0x%x rxhash 0x%x vlan %U"
 #ifdef TP_STATUS_VLAN_TPID_VALID
 	    " vlan_tpid %u"
 #endif
@@ -82,9 +82,10 @@ format_af_packet_input_trace (u8 * s, va_list * args)
 	    t->tph.tp_net,
 	    format_white_space, indent + 4,
 	    t->tph.tp_sec,
-	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.tp_vlan_tci
+	    t->tph.tp_nsec, t->tph.hv1.tp_rxhash,
+	    format_ethernet_vlan_tci, t->tph.hv1.tp_vlan_tci
 #ifdef TP_STATUS_VLAN_TPID_VALID
-	    , t->tph.tp_vlan_tpid
+	    , t->tph.hv1.tp_vlan_tpid
 #endif
     );
   return s;
@@ -175,21 +176,23 @@ mark_tcp_udp_cksum_calc (vlib_buffer_t * b)
 
 always_inline uword
 af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
-			   vlib_frame_t * frame, af_packet_if_t * apif)
+			   vlib_frame_t * frame, af_packet_if_t * apif,
+			   vnet_device_and_queue_t * dq)
 {
   af_packet_main_t *apm = &af_packet_main;
-  struct tpacket2_hdr *tph;
+  af_packet_queue_t *q = vec_elt_at_index (apif->rx_queues, dq->queue_id);
+  struct tpacket_block_desc *bd;
+  struct tpacket3_hdr *tph;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-  u32 block = 0;
-  u32 rx_frame;
+  u32 block = q->next_rx_block;
+  u32 pkt = q->next_rx_pkt;
+  u32 pkt_offset = q->next_rx_offset;
   u32 n_free_bufs;
   u32 n_rx_packets = 0;
   u32 n_rx_bytes = 0;
   u32 *to_next = 0;
   u32 block_size = apif->rx_req->tp_block_size;
-  u32 frame_size = apif->rx_req->tp_frame_size;
-  u32 frame_num = apif->rx_req->tp_frame_nr;
-  u8 *block_start = apif->rx_ring + block * block_size;
+  u32 block_num = apif->rx_req->tp_block_nr;
   uword n_trace = vlib_get_trace_count (vm, node);
   u32 thread_index = vlib_get_thread_index ();
   u32 n_buffer_bytes = vlib_buffer_free_list_buffer_size (vm,
@@ -210,18 +213,45 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       _vec_len (apm->rx_buffers[thread_index]) = n_free_bufs;
     }
 
-  rx_frame = apif->next_rx_frame;
-  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
-  while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs))
+  /*
+   * TPACKET_V3 hands over whole blocks. Every packet of a block is
+   * consumed before the block is returned, a block left half done
+   * because we ran out of buffers or frame space is resumed next time.
+   */
+  bd = (struct tpacket_block_desc *) (q->rx_ring + block * block_size);
+  while ((bd->hdr.bh1.block_status & TP_STATUS_USER) &&
+	 (n_free_bufs > min_bufs))
     {
       vlib_buffer_t *b0 = 0, *first_b0 = 0;
+      u32 num_pkts = bd->hdr.bh1.num_pkts;
       u32 next0 = next_index;
 
+      if (pkt == 0)
+	pkt_offset = bd->hdr.bh1.offset_to_first_pkt;
+
       u32 n_left_to_next;
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs) &&
-	     n_left_to_next)
+      while (pkt < num_pkts && (n_free_bufs > min_bufs) && n_left_to_next)
 	{
+	  tph = (struct tpacket3_hdr *) ((u8 *) bd + pkt_offset);
+
+	  /* next frame header and data share the next couple of lines */
+	  if (PREDICT_TRUE (pkt + 1 < num_pkts))
+	    {
+	      u8 *next = (u8 *) tph + tph->tp_next_offset;
+	      CLIB_PREFETCH (next, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
+	    }
+
+	  pkt++;
+	  pkt_offset += tph->tp_next_offset;
+
+	  /* the tx socket is a separate socket, don't loop our own
+	     frames back in */
+	  struct sockaddr_ll *sll = (struct sockaddr_ll *)
+	    ((u8 *) tph + TPACKET_ALIGN (sizeof (struct tpacket3_hdr)));
+	  if (PREDICT_FALSE (sll->sll_pkttype == PACKET_OUTGOING))
+	    continue;
+
 	  u32 data_len = tph->tp_snaplen;
 	  u32 offset = 0;
 	  u32 bi0 = 0, first_bi0 = 0, prev_bi0;
@@ -255,7 +285,7 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      ethernet_vlan_header_t *vlan =
 			(ethernet_vlan_header_t *) (eth + 1);
 		      vlan->priority_cfi_and_id =
-			clib_host_to_net_u16 (tph->tp_vlan_tci);
+			clib_host_to_net_u16 (tph->hv1.tp_vlan_tci);
 		      vlan->type = eth->type;
 		      eth->type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
 		      vlan_len = sizeof (ethernet_vlan_header_t);
@@ -319,23 +349,38 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = apif->hw_if_index;
-	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket2_hdr));
+	      tr->queue_id = q->queue_id;
+	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket3_hdr));
 	    }
 
 	  /* enque and take next packet */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
 					   n_left_to_next, first_bi0, next0);
-
-	  /* next packet */
-	  tph->tp_status = TP_STATUS_KERNEL;
-	  rx_frame = (rx_frame + 1) % frame_num;
-	  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
 	}
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+      /* whole block consumed, give it back to the kernel */
+      if (pkt == num_pkts)
+	{
+	  CLIB_MEMORY_BARRIER ();
+	  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	  block = (block + 1) % block_num;
+	  bd = (struct tpacket_block_desc *) (q->rx_ring + block * block_size);
+	  pkt = 0;
+	}
     }
 
-  apif->next_rx_frame = rx_frame;
+  q->next_rx_block = block;
+  q->next_rx_pkt = pkt;
+  q->next_rx_offset = pkt_offset;
+
+  /* the kernel only signals retired blocks, so if we stopped short
+     nobody would wake us up for the rest */
+  if (PREDICT_FALSE (dq->mode != VNET_HW_INTERFACE_RX_MODE_POLLING &&
+		     (bd->hdr.bh1.block_status & TP_STATUS_USER)))
+    vnet_device_input_set_interrupt_pending (vnet_get_main (),
+					     apif->hw_if_index, q->queue_id);
 
   vlib_increment_combined_counter
     (vnet_get_main ()->interface_main.combined_sw_if_counters
@@ -360,7 +405,7 @@ af_packet_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
     af_packet_if_t *apif;
     apif = vec_elt_at_index (apm->interfaces, dq->dev_instance);
     if (apif->is_admin_up)
-      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif);
+      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif, dq);
   }
 
   return n_rx_packets;
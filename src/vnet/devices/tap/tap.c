@@ -171,7 +171,10 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   _IOCTL (vif->tap_fd, TUNSETIFF, (void *) &ifr);
   vif->ifindex = if_nametoindex (ifr.ifr_ifrn.ifrn_name);
 
+  /* with gso, the kernel hands us partial checksums and TSO packets */
   unsigned int offload = 0;
+  if (args->enable_gso)
+    offload = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
   hdrsz = sizeof (struct virtio_net_hdr_v1);
   _IOCTL (vif->tap_fd, TUNSETOFFLOAD, offload);
   _IOCTL (vif->tap_fd, TUNSETVNETHDRSZ, &hdrsz);
@@ -378,6 +381,12 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   args->sw_if_index = vif->sw_if_index;
   hw = vnet_get_hw_interface (vnm, vif->hw_if_index);
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  if (args->enable_gso)
+    {
+      vif->flags |= VIRTIO_IF_FLAG_GSO;
+      hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO |
+	VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
+    }
   vnet_hw_interface_set_input_node (vnm, vif->hw_if_index,
 				    virtio_input_node.index);
   vnet_hw_interface_assign_rx_thread (vnm, vif->hw_if_index, 0, ~0);
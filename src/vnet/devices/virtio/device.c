@@ -26,6 +26,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
+#include <vnet/gso/gso.h>
 #include <vnet/devices/virtio/virtio.h>
 
 #define foreach_virtio_tx_func_error	       \
@@ -134,6 +135,29 @@ add_buffer_to_slot (vlib_main_t * vm, virtio_vring_t * vring, u32 bi,
 
   memset (hdr, 0, hdr_sz);
 
+  /* Leave checksums and segmentation to the kernel */
+  if (PREDICT_FALSE (b->flags & (VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+				 VNET_BUFFER_F_OFFLOAD_UDP_CKSUM |
+				 VNET_BUFFER_F_GSO)))
+    {
+      u16 csum_start = vnet_buffer (b)->l4_hdr_offset - b->current_data;
+      u16 csum_offset = vnet_gso_prepare_partial_checksum (b);
+
+      if (csum_offset)
+	{
+	  hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	  hdr->csum_start = csum_start;
+	  hdr->csum_offset = csum_offset;
+	}
+      if (b->flags & VNET_BUFFER_F_GSO)
+	{
+	  hdr->gso_type = (b->flags & VNET_BUFFER_F_IS_IP4) ?
+	    VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+	  hdr->gso_size = vnet_buffer2 (b)->gso_size;
+	  hdr->hdr_len = csum_start + vnet_buffer2 (b)->gso_l4_hdr_sz;
+	}
+    }
+
   if (PREDICT_TRUE ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0))
     {
       d->addr = pointer_to_uword (vlib_buffer_get_current (b)) - hdr_sz;
@@ -32,6 +32,7 @@
 #include <vnet/feature/feature.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
+#include <vnet/gso/gso.h>
 #include <vnet/devices/virtio/virtio.h>
 
 
@@ -198,6 +199,14 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		}
 	    }
 
+	  if (PREDICT_FALSE ((vif->flags & VIRTIO_IF_FLAG_GSO) &&
+			     ((hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) ||
+			      hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE)))
+	    vnet_gso_rx_offload (b0, vlib_buffer_get_current (b0),
+				 hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM,
+				 hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE ?
+				 hdr->gso_size : 0);
+
 	  if (PREDICT_FALSE (vif->per_interface_next_index != ~0))
 	    next0 = vif->per_interface_next_index;
 	  else
@@ -39,6 +39,7 @@
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
 
+#include <vnet/gso/gso.h>
 #include <vnet/devices/virtio/vhost-user.h>
 
 /**
@@ -86,6 +87,12 @@
  * The value 64 was obtained by testing (48 and 128 were not as good).
  */
 #define VHOST_USER_RX_COPY_THRESHOLD 64
+/*
+ * On the receive side, descriptors are read this many packets ahead of
+ * the one being parsed, so that the descriptor table entries written by
+ * the guest on another core are in cache when they are needed.
+ */
+#define VHOST_USER_RX_DESC_PREFETCH 4
 /*
  * On the transmit side, we keep processing the buffers from vlib in the while
  * loop and prepare the copy order to be executed later. However, the static
@@ -841,6 +848,8 @@ vhost_user_socket_read (clib_file_t * uf)
 	(1ULL << FEAT_VIRTIO_NET_F_MQ) |
 	(1ULL << FEAT_VHOST_USER_F_PROTOCOL_FEATURES) |
 	(1ULL << FEAT_VIRTIO_F_VERSION_1);
+      if (vui->enable_gso)
+	msg.u64 |= VHOST_USER_GSO_FEATURES;
       msg.u64 &= vui->feature_mask;
       msg.size = sizeof (msg.u64);
       DBG_SOCK ("if %d msg VHOST_USER_GET_FEATURES - reply 0x%016llx",
@@ -863,6 +872,24 @@ vhost_user_socket_read (clib_file_t * uf)
       vui->is_any_layout =
 	(vui->features & (1 << FEAT_VIRTIO_F_ANY_LAYOUT)) ? 1 : 0;
 
+      /* Guest completes our partial checksums, and takes whole TSO
+       * buffers when it can do so for both address families */
+      {
+	vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm,
+							 vui->hw_if_index);
+	u64 tso = (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4) |
+	  (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6);
+
+	hw->flags &= ~(VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD |
+		       VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO);
+	if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM))
+	  {
+	    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
+	    if ((vui->features & tso) == tso)
+	      hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO;
+	  }
+      }
+
       ASSERT (vui->virtio_net_hdr_sz < VLIB_BUFFER_PRE_DATA_SIZE);
       vnet_hw_interface_set_flags (vnm, vui->hw_if_index, 0);
       vui->is_up = 0;
@@ -1437,48 +1464,28 @@ vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq)
   vq->int_deadline = vlib_time_now (vm) + vum->coalesce_time;
 }
 
-static_always_inline u32
-vhost_user_input_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
-		       u16 copy_len, u32 * map_hint)
+/*
+ * Sources were mapped, and their first cache line prefetched, when the
+ * copy orders were prepared. Copies only touch memory here.
+ */
+static_always_inline void
+vhost_user_input_copy (vhost_copy_t * cpy, u16 copy_len)
 {
-  void *src0, *src1, *src2, *src3;
-  if (PREDICT_TRUE (copy_len >= 4))
+  while (PREDICT_TRUE (copy_len >= 4))
     {
-      if (PREDICT_FALSE (!(src2 = map_guest_mem (vui, cpy[0].src, map_hint))))
-	return 1;
-      if (PREDICT_FALSE (!(src3 = map_guest_mem (vui, cpy[1].src, map_hint))))
-	return 1;
-
-      while (PREDICT_TRUE (copy_len >= 4))
-	{
-	  src0 = src2;
-	  src1 = src3;
-
-	  if (PREDICT_FALSE
-	      (!(src2 = map_guest_mem (vui, cpy[2].src, map_hint))))
-	    return 1;
-	  if (PREDICT_FALSE
-	      (!(src3 = map_guest_mem (vui, cpy[3].src, map_hint))))
-	    return 1;
-
-	  CLIB_PREFETCH (src2, 64, LOAD);
-	  CLIB_PREFETCH (src3, 64, LOAD);
-
-	  clib_memcpy ((void *) cpy[0].dst, src0, cpy[0].len);
-	  clib_memcpy ((void *) cpy[1].dst, src1, cpy[1].len);
-	  copy_len -= 2;
-	  cpy += 2;
-	}
+      clib_memcpy ((void *) cpy[0].dst, (void *) cpy[0].src, cpy[0].len);
+      clib_memcpy ((void *) cpy[1].dst, (void *) cpy[1].src, cpy[1].len);
+      clib_memcpy ((void *) cpy[2].dst, (void *) cpy[2].src, cpy[2].len);
+      clib_memcpy ((void *) cpy[3].dst, (void *) cpy[3].src, cpy[3].len);
+      copy_len -= 4;
+      cpy += 4;
     }
   while (copy_len)
     {
-      if (PREDICT_FALSE (!(src0 = map_guest_mem (vui, cpy->src, map_hint))))
-	return 1;
-      clib_memcpy ((void *) cpy->dst, src0, cpy->len);
+      clib_memcpy ((void *) cpy->dst, (void *) cpy->src, cpy->len);
       copy_len -= 1;
       cpy += 1;
     }
-  return 0;
 }
 
 /**
@@ -1681,6 +1688,7 @@ vhost_user_if_input (vlib_main_t * vm,
 	  u16 desc_current;
 	  u32 desc_data_offset;
 	  vring_desc_t *desc_table = txvq->desc;
+	  u32 error0 = VHOST_USER_INPUT_FUNC_ERROR_NO_ERROR;
 
 	  if (PREDICT_FALSE (vum->cpus[thread_index].rx_buffers_len <= 1))
 	    {
@@ -1694,6 +1702,16 @@ vhost_user_if_input (vlib_main_t * vm,
 
 	  desc_current =
 	    txvq->avail->ring[txvq->last_avail_idx & txvq->qsz_mask];
+
+	  if (PREDICT_TRUE (n_left > VHOST_USER_RX_DESC_PREFETCH))
+	    {
+	      u16 desc_ahead = txvq->avail->ring[(txvq->last_avail_idx +
+						  VHOST_USER_RX_DESC_PREFETCH)
+						 & txvq->qsz_mask];
+	      CLIB_PREFETCH (&txvq->desc[desc_ahead & txvq->qsz_mask],
+			     sizeof (vring_desc_t), LOAD);
+	    }
+
 	  vum->cpus[thread_index].rx_buffers_len--;
 	  bi_current = (vum->cpus[thread_index].rx_buffers)
 	    [vum->cpus[thread_index].rx_buffers_len];
@@ -1742,12 +1760,31 @@ vhost_user_if_input (vlib_main_t * vm,
 	      desc_current = 0;
 	      if (PREDICT_FALSE (desc_table == 0))
 		{
-		  vlib_error_count (vm, node->node_index,
-				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+		  error0 = VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL;
 		  goto out;
 		}
 	    }
 
+	  if (PREDICT_FALSE (vui->enable_gso))
+	    {
+	      virtio_net_hdr_t *hdr;
+
+	      hdr = map_guest_mem (vui, desc_table[desc_current].addr,
+				   &map_hint);
+	      if (PREDICT_TRUE (hdr != 0) &&
+		  ((hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) ||
+		   hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE))
+		{
+		  vhost_rx_offload_t *ro;
+
+		  vec_add2 (vum->cpus[thread_index].rx_offloads, ro, 1);
+		  ro->buffer_index = to_next[-1];
+		  ro->flags = hdr->flags;
+		  ro->gso_type = hdr->gso_type;
+		  ro->gso_size = hdr->gso_size;
+		}
+	    }
+
 	  if (PREDICT_TRUE (vui->is_any_layout) ||
 	      (!(desc_table[desc_current].flags & VIRTQ_DESC_F_NEXT)))
 	    {
@@ -1799,6 +1836,10 @@ vhost_user_if_input (vlib_main_t * vm,
 						       &vum->cpus
 						       [thread_index],
 						       b_head);
+		      if (vec_len (vum->cpus[thread_index].rx_offloads) &&
+			  vec_end (vum->cpus[thread_index].rx_offloads)[-1].
+			  buffer_index == to_next[0])
+			_vec_len (vum->cpus[thread_index].rx_offloads) -= 1;
 		      n_left = 0;
 		      goto stop;
 		    }
@@ -1814,7 +1855,20 @@ vhost_user_if_input (vlib_main_t * vm,
 		  b_current = vlib_get_buffer (vm, bi_current);
 		}
 
-	      /* Prepare a copy order executed later for the data */
+	      /*
+	       * Prepare a copy order executed later for the data. The guest
+	       * data is mapped and prefetched now, so it has arrived by the
+	       * time the batch of copies runs.
+	       */
+	      void *src = map_guest_mem (vui, desc_table[desc_current].addr +
+					 desc_data_offset, &map_hint);
+	      if (PREDICT_FALSE (src == 0))
+		{
+		  error0 = VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL;
+		  goto out;
+		}
+	      CLIB_PREFETCH (src, CLIB_CACHE_LINE_BYTES, LOAD);
+
 	      vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
 	      copy_len++;
 	      u32 desc_data_l =
@@ -1823,7 +1877,7 @@ vhost_user_if_input (vlib_main_t * vm,
 	      cpy->len = (cpy->len > desc_data_l) ? desc_data_l : cpy->len;
 	      cpy->dst = (uword) (vlib_buffer_get_current (b_current) +
 				  b_current->current_length);
-	      cpy->src = desc_table[desc_current].addr + desc_data_offset;
+	      cpy->src = pointer_to_uword (src);
 
 	      desc_data_offset += cpy->len;
 
@@ -1853,9 +1907,22 @@ vhost_user_if_input (vlib_main_t * vm,
 	  {
 	    u32 next0 = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
 
-	    /* redirect if feature path enabled */
-	    vnet_feature_start_device_input_x1 (vui->sw_if_index, &next0,
-						b_head);
+	    if (PREDICT_FALSE (error0))
+	      {
+		/* partially copied, don't let anyone parse it */
+		b_head->error = node->errors[error0];
+		next0 = VNET_DEVICE_INPUT_NEXT_DROP;
+		if (vec_len (vum->cpus[thread_index].rx_offloads) &&
+		    vec_end (vum->cpus[thread_index].rx_offloads)[-1].
+		    buffer_index == to_next[-1])
+		  _vec_len (vum->cpus[thread_index].rx_offloads) -= 1;
+	      }
+	    else
+	      {
+		/* redirect if feature path enabled */
+		vnet_feature_start_device_input_x1 (vui->sw_if_index,
+						    &next0, b_head);
+	      }
 
 	    u32 bi = to_next[-1];	//Cannot use to_next[-1] in the macro
 	    vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -1872,13 +1939,7 @@ vhost_user_if_input (vlib_main_t * vm,
 	   */
 	  if (PREDICT_FALSE (copy_len >= VHOST_USER_RX_COPY_THRESHOLD))
 	    {
-	      if (PREDICT_FALSE
-		  (vhost_user_input_copy (vui, vum->cpus[thread_index].copy,
-					  copy_len, &map_hint)))
-		{
-		  vlib_error_count (vm, node->node_index,
-				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
-		}
+	      vhost_user_input_copy (vum->cpus[thread_index].copy, copy_len);
 	      copy_len = 0;
 
 	      /* give buffers back to driver */
@@ -1892,12 +1953,26 @@ vhost_user_if_input (vlib_main_t * vm,
     }
 
   /* Do the memory copies */
-  if (PREDICT_FALSE
-      (vhost_user_input_copy (vui, vum->cpus[thread_index].copy,
-			      copy_len, &map_hint)))
+  vhost_user_input_copy (vum->cpus[thread_index].copy, copy_len);
+
+  /* Packet data is in place, parse headers of offloaded packets */
+  if (PREDICT_FALSE (vec_len (vum->cpus[thread_index].rx_offloads)))
     {
-      vlib_error_count (vm, node->node_index,
-			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+      vhost_rx_offload_t *ro;
+
+      vec_foreach (ro, vum->cpus[thread_index].rx_offloads)
+      {
+	vlib_buffer_t *b = vlib_get_buffer (vm, ro->buffer_index);
+	u16 gso_size = 0;
+
+	if (ro->gso_type == VIRTIO_NET_HDR_GSO_TCPV4 ||
+	    ro->gso_type == VIRTIO_NET_HDR_GSO_TCPV6)
+	  gso_size = ro->gso_size;
+	vnet_gso_rx_offload (b, vlib_buffer_get_current (b),
+			     ro->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM,
+			     gso_size);
+      }
+      _vec_len (vum->cpus[thread_index].rx_offloads) = 0;
     }
 
   /* give buffers back to driver */
@@ -2008,6 +2083,32 @@ vhost_user_tx_trace (vhost_trace_t * t,
   t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
 }
 
+/**
+ * Fill the virtio header of a packet whose L4 checksum and segmentation
+ * are left to the guest.
+ */
+static_always_inline void
+vhost_user_tx_offload (virtio_net_hdr_t * hdr, vlib_buffer_t * b)
+{
+  u16 csum_start = vnet_buffer (b)->l4_hdr_offset - b->current_data;
+  u16 csum_offset = vnet_gso_prepare_partial_checksum (b);
+
+  if (csum_offset)
+    {
+      hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      hdr->csum_start = csum_start;
+      hdr->csum_offset = csum_offset;
+    }
+
+  if (b->flags & VNET_BUFFER_F_GSO)
+    {
+      hdr->gso_type = (b->flags & VNET_BUFFER_F_IS_IP4) ?
+	VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+      hdr->gso_size = vnet_buffer2 (b)->gso_size;
+      hdr->hdr_len = csum_start + vnet_buffer2 (b)->gso_l4_hdr_sz;
+    }
+}
+
 static_always_inline u32
 vhost_user_tx_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
 		    u16 copy_len, u32 * map_hint)
@@ -2073,7 +2174,6 @@ vhost_user_tx (vlib_main_t * vm,
   u32 map_hint = 0;
   u8 retry = 8;
   u16 copy_len;
-  u16 tx_headers_len;
 
   if (PREDICT_FALSE (!vui->admin_up))
     {
@@ -2096,16 +2196,16 @@ vhost_user_tx (vlib_main_t * vm,
 
 retry:
   error = VHOST_USER_TX_FUNC_ERROR_NONE;
-  tx_headers_len = 0;
   copy_len = 0;
   while (n_left > 0)
     {
       vlib_buffer_t *b0, *current_b0;
       u16 desc_head, desc_index, desc_len;
       vring_desc_t *desc_table;
-      uword buffer_map_addr;
+      virtio_net_hdr_mrg_rxbuf_t *hdr;
+      uword buffer_map_addr, hdr_addr;
       u32 buffer_len;
-      u16 bytes_left;
+      u16 bytes_left, num_buffers = 1;
 
       if (PREDICT_TRUE (n_left > 1))
 	vlib_prefetch_buffer_with_index (vm, buffers[1], LOAD);
@@ -2131,6 +2231,15 @@ retry:
       desc_head = desc_index =
 	rxvq->avail->ring[rxvq->last_avail_idx & rxvq->qsz_mask];
 
+      if (PREDICT_TRUE (n_left > 1) &&
+	  (u16) (rxvq->last_avail_idx + 1) != rxvq->avail->idx)
+	{
+	  u16 desc_next = rxvq->avail->ring[(rxvq->last_avail_idx + 1) &
+					    rxvq->qsz_mask];
+	  CLIB_PREFETCH (&rxvq->desc[desc_next & rxvq->qsz_mask],
+			 sizeof (vring_desc_t), LOAD);
+	}
+
       /* Go deeper in case of indirect descriptor
        * I don't know of any driver providing indirect for RX. */
       if (PREDICT_FALSE (rxvq->desc[desc_head].flags & VIRTQ_DESC_F_INDIRECT))
@@ -2157,20 +2266,31 @@ retry:
       buffer_len = desc_table[desc_index].len;
 
       {
-	// Get a header from the header array
-	virtio_net_hdr_mrg_rxbuf_t *hdr =
-	  &vum->cpus[thread_index].tx_headers[tx_headers_len];
-	tx_headers_len++;
-	hdr->hdr.flags = 0;
-	hdr->hdr.gso_type = 0;
-	hdr->num_buffers = 1;	//This is local, no need to check
-
-	// Prepare a copy order executed later for the header
-	vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
-	copy_len++;
-	cpy->len = vui->virtio_net_hdr_sz;
-	cpy->dst = buffer_map_addr;
-	cpy->src = (uword) hdr;
+	/*
+	 * The header is small and built here, so write it directly to the
+	 * guest buffer instead of staging it for the copy batch. The guest
+	 * does not look at it before the used index is updated.
+	 */
+	virtio_net_hdr_mrg_rxbuf_t h;
+
+	if (PREDICT_FALSE
+	    (!(hdr = map_guest_mem (vui, buffer_map_addr, &map_hint))))
+	  {
+	    error = VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL;
+	    goto done;
+	  }
+	hdr_addr = buffer_map_addr;
+
+	memset (&h, 0, sizeof (h));
+	h.num_buffers = 1;
+
+	// Leave checksums and segmentation to the guest
+	if (PREDICT_FALSE (b0->flags & (VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+					VNET_BUFFER_F_OFFLOAD_UDP_CKSUM |
+					VNET_BUFFER_F_GSO)))
+	  vhost_user_tx_offload (&h.hdr, b0);
+
+	clib_memcpy (hdr, &h, vui->virtio_net_hdr_sz);
       }
 
       buffer_map_addr += vui->virtio_net_hdr_sz;
@@ -2190,9 +2310,6 @@ retry:
 		}
 	      else if (vui->virtio_net_hdr_sz == 12)	//MRG is available
 		{
-		  virtio_net_hdr_mrg_rxbuf_t *hdr =
-		    &vum->cpus[thread_index].tx_headers[tx_headers_len - 1];
-
 		  //Move from available to used buffer
 		  rxvq->used->ring[rxvq->last_used_idx & rxvq->qsz_mask].id =
 		    desc_head;
@@ -2204,15 +2321,16 @@ retry:
 
 		  rxvq->last_avail_idx++;
 		  rxvq->last_used_idx++;
-		  hdr->num_buffers++;
+		  // Guest memory, keep the count local for the rollback
+		  hdr->num_buffers = ++num_buffers;
 		  desc_len = 0;
 
 		  if (PREDICT_FALSE
 		      (rxvq->last_avail_idx == rxvq->avail->idx))
 		    {
 		      //Dequeue queued descriptors for this packet
-		      rxvq->last_used_idx -= hdr->num_buffers - 1;
-		      rxvq->last_avail_idx -= hdr->num_buffers - 1;
+		      rxvq->last_used_idx -= num_buffers - 1;
+		      rxvq->last_avail_idx -= num_buffers - 1;
 		      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOBUF;
 		      goto done;
 		    }
@@ -2291,13 +2409,16 @@ retry:
       rxvq->used->ring[rxvq->last_used_idx & rxvq->qsz_mask].len = desc_len;
       vhost_user_log_dirty_ring (vui, rxvq,
 				 ring[rxvq->last_used_idx & rxvq->qsz_mask]);
+      vhost_user_log_dirty_pages_2 (vui, hdr_addr, vui->virtio_net_hdr_sz, 1);
       rxvq->last_avail_idx++;
       rxvq->last_used_idx++;
 
       if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
 	{
-	  vum->cpus[thread_index].current_trace->hdr =
-	    vum->cpus[thread_index].tx_headers[tx_headers_len - 1];
+	  virtio_net_hdr_mrg_rxbuf_t *th =
+	    &vum->cpus[thread_index].current_trace->hdr;
+	  memset (th, 0, sizeof (*th));
+	  clib_memcpy (th, hdr, vui->virtio_net_hdr_sz);
 	}
 
       n_left--;			//At the end for error counting when 'goto done' is invoked
@@ -2879,7 +3000,7 @@ vhost_user_vui_init (vnet_main_t * vnm,
 		     vhost_user_intf_t * vui,
 		     int server_sock_fd,
 		     const char *sock_filename,
-		     u64 feature_mask, u32 * sw_if_index)
+		     u64 feature_mask, u32 * sw_if_index, u8 enable_gso)
 {
   vnet_sw_interface_t *sw;
   int q;
@@ -2907,6 +3028,7 @@ vhost_user_vui_init (vnet_main_t * vnm,
   vui->sock_errno = 0;
   vui->is_up = 0;
   vui->feature_mask = feature_mask;
+  vui->enable_gso = enable_gso;
   vui->clib_file_index = ~0;
   vui->log_base_addr = 0;
   vui->if_index = vui - vum->vhost_user_interfaces;
@@ -2940,7 +3062,8 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      u8 is_server,
 		      u32 * sw_if_index,
 		      u64 feature_mask,
-		      u8 renumber, u32 custom_dev_instance, u8 * hwaddr)
+		      u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
+		      u8 enable_gso)
 {
   vhost_user_intf_t *vui = NULL;
   u32 sw_if_idx = ~0;
@@ -2978,7 +3101,7 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 
   vhost_user_create_ethernet (vnm, vm, vui, hwaddr);
   vhost_user_vui_init (vnm, vui, server_sock_fd, sock_filename,
-		       feature_mask, &sw_if_idx);
+		       feature_mask, &sw_if_idx, enable_gso);
 
   if (renumber)
     vnet_interface_name_renumber (sw_if_idx, custom_dev_instance);
@@ -2997,7 +3120,8 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      const char *sock_filename,
 		      u8 is_server,
 		      u32 sw_if_index,
-		      u64 feature_mask, u8 renumber, u32 custom_dev_instance)
+		      u64 feature_mask, u8 renumber, u32 custom_dev_instance,
+		      u8 enable_gso)
 {
   vhost_user_main_t *vum = &vhost_user_main;
   vhost_user_intf_t *vui = NULL;
@@ -3032,7 +3156,7 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 
   vhost_user_term_if (vui);
   vhost_user_vui_init (vnm, vui, server_sock_fd,
-		       sock_filename, feature_mask, &sw_if_idx);
+		       sock_filename, feature_mask, &sw_if_idx, enable_gso);
 
   if (renumber)
     vnet_interface_name_renumber (sw_if_idx, custom_dev_instance);
@@ -3054,6 +3178,7 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   u8 is_server = 0;
   u64 feature_mask = (u64) ~ (0ULL);
   u8 renumber = 0;
+  u8 enable_gso = 0;
   u32 custom_dev_instance = ~0;
   u8 hwaddr[6];
   u8 *hw = NULL;
@@ -3079,6 +3204,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
 	{
 	  renumber = 1;
 	}
+      else if (unformat (line_input, "gso"))
+	enable_gso = 1;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -3092,7 +3219,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   int rv;
   if ((rv = vhost_user_create_if (vnm, vm, (char *) sock_filename,
 				  is_server, &sw_if_index, feature_mask,
-				  renumber, custom_dev_instance, hw)))
+				  renumber, custom_dev_instance, hw,
+				  enable_gso)))
     {
       error = clib_error_return (0, "vhost_user_create_if returned %d", rv);
       goto done;
@@ -3465,6 +3593,13 @@ done:
  *   - 0x040000000 (30) - VHOST_USER_F_PROTOCOL_FEATURES
  *   - 0x100000000 (32) - VIRTIO_F_VERSION_1
  *
+ * - <b>gso</b> - Optional flag to also offer checksum offload and TSO
+ * (VIRTIO_NET_F_CSUM, VIRTIO_NET_F_GUEST_CSUM and the HOST/GUEST TSO4/TSO6
+ * features) to the guest. Large TCP packets from the guest are then carried
+ * through the graph unsegmented and cut on the output interface. They are
+ * not segmented before encapsulation: routed into a tunnel they are
+ * checked against its MTU like any other packet.
+ *
  * - <b>hwaddr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
  *
@@ -3489,7 +3624,8 @@ done:
 VLIB_CLI_COMMAND (vhost_user_connect_command, static) = {
     .path = "create vhost-user",
     .short_help = "create vhost-user socket <socket-filename> [server] "
-    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] ",
+    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] "
+    "[gso]",
     .function = vhost_user_connect_command_fn,
 };
 /* *INDENT-ON* */
@@ -45,7 +45,28 @@
 #define VRING_USED_F_NO_NOTIFY  1
 #define VRING_AVAIL_F_NO_INTERRUPT 1
 
+/* virtio_net_hdr_t flags and gso_type */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
+#define VIRTIO_NET_HDR_GSO_NONE		0
+#define VIRTIO_NET_HDR_GSO_TCPV4	1
+#define VIRTIO_NET_HDR_GSO_TCPV6	4
+
+/* Features offered with "gso": partial checksums and TSO both ways */
+#define VHOST_USER_GSO_FEATURES				\
+  ((1ULL << FEAT_VIRTIO_NET_F_CSUM) |			\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM) |		\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4) |		\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6) |		\
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO4) |		\
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO6))
+
 #define foreach_virtio_net_feature      \
+ _ (VIRTIO_NET_F_CSUM, 0)               \
+ _ (VIRTIO_NET_F_GUEST_CSUM, 1)         \
+ _ (VIRTIO_NET_F_GUEST_TSO4, 7)         \
+ _ (VIRTIO_NET_F_GUEST_TSO6, 8)         \
+ _ (VIRTIO_NET_F_HOST_TSO4, 11)         \
+ _ (VIRTIO_NET_F_HOST_TSO6, 12)         \
  _ (VIRTIO_NET_F_MRG_RXBUF, 15)         \
  _ (VIRTIO_NET_F_CTRL_VQ, 17)           \
  _ (VIRTIO_NET_F_GUEST_ANNOUNCE, 21)    \
@@ -67,11 +88,12 @@ typedef enum
 int vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 * sw_if_index, u64 feature_mask,
-			  u8 renumber, u32 custom_dev_instance, u8 * hwaddr);
+			  u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
+			  u8 enable_gso);
 int vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 sw_if_index, u64 feature_mask,
-			  u8 renumber, u32 custom_dev_instance);
+			  u8 renumber, u32 custom_dev_instance, u8 enable_gso);
 int vhost_user_delete_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  u32 sw_if_index);
 
@@ -249,6 +271,9 @@ typedef struct
   int virtio_net_hdr_sz;
   int is_any_layout;
 
+  /* Offer checksum and segmentation offload to the guest */
+  u8 enable_gso;
+
   void *log_base_addr;
   u64 log_size;
 
@@ -280,14 +305,24 @@ typedef struct
 #define VHOST_USER_RX_BUFFERS_N (2 * VLIB_FRAME_SIZE + 2)
 #define VHOST_USER_COPY_ARRAY_N (4 * VLIB_FRAME_SIZE)
 
+typedef struct
+{
+  u32 buffer_index;
+  u16 gso_size;
+  u8 flags;
+  u8 gso_type;
+} vhost_rx_offload_t;
+
 typedef struct
 {
   u32 rx_buffers_len;
   u32 rx_buffers[VHOST_USER_RX_BUFFERS_N];
 
-  virtio_net_hdr_mrg_rxbuf_t tx_headers[VLIB_FRAME_SIZE];
   vhost_copy_t copy[VHOST_USER_COPY_ARRAY_N];
 
+  /* Packets whose offload metadata is filled once their data is copied */
+  vhost_rx_offload_t *rx_offloads;
+
   /* This is here so it doesn't end-up
    * using stack or registers. */
   vhost_trace_t *current_trace;
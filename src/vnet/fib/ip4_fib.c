@@ -194,6 +194,9 @@ ip4_fib_table_destroy (u32 fib_index)
 	hash_unset (ip4_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
 
+    ASSERT(0 == vec_len(v4_fib->fwding_bulk_routes));
+    vec_free(v4_fib->fwding_bulk_routes);
+    hash_free(v4_fib->fwding_bulk_by_prefix);
     ip4_mtrie_free(&v4_fib->mtrie);
 
     pool_put(ip4_main.v4_fibs, v4_fib);
@@ -377,13 +380,68 @@ ip4_fib_table_entry_remove (ip4_fib_t *fib,
     fib->fib_entry_by_dst_address[len] = hash;
 }
 
+static void
+ip4_fib_table_fwding_bulk_flush (ip4_fib_t *fib)
+{
+    if (0 == vec_len(fib->fwding_bulk_routes))
+        return;
+
+    ip4_fib_mtrie_route_add_bulk(&fib->mtrie, fib->fwding_bulk_routes);
+    vec_reset_length(fib->fwding_bulk_routes);
+    hash_free(fib->fwding_bulk_by_prefix);
+}
+
+void
+ip4_fib_table_fwding_bulk_start (u32 fib_index)
+{
+    ip4_fib_get(fib_index)->fwding_bulk++;
+}
+
+void
+ip4_fib_table_fwding_bulk_end (u32 fib_index)
+{
+    ip4_fib_t *fib = ip4_fib_get(fib_index);
+
+    ASSERT(fib->fwding_bulk);
+    if (0 == --fib->fwding_bulk)
+        ip4_fib_table_fwding_bulk_flush(fib);
+}
+
 void
 ip4_fib_table_fwding_dpo_update (ip4_fib_t *fib,
 				 const ip4_address_t *addr,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
-    ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+    ip4_fib_mtrie_route_t *route;
+    uword *p;
+    u64 key;
+
+    if (PREDICT_TRUE(!fib->fwding_bulk))
+    {
+        ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+        return;
+    }
+
+    /*
+     * an update to a prefix that is already held back replaces it
+     */
+    key = ((u64) len << 32) | (addr->data_u32 & ip4_main.fib_masks[len]);
+    p = hash_get(fib->fwding_bulk_by_prefix, key);
+
+    if (NULL == p)
+    {
+        hash_set(fib->fwding_bulk_by_prefix, key,
+                 vec_len(fib->fwding_bulk_routes));
+        vec_add2(fib->fwding_bulk_routes, route, 1);
+        route->dst_address = *addr;
+        route->dst_address_length = len;
+    }
+    else
+    {
+        route = vec_elt_at_index(fib->fwding_bulk_routes, p[0]);
+    }
+    route->adj_index = dpo->dpoi_index;
 }
 
 void
@@ -406,6 +464,11 @@ ip4_fib_table_fwding_dpo_remove (ip4_fib_t *fib,
     fib_entry_get_prefix(cover_index, &cover_prefix);
     cover_dpo = fib_entry_contribute_ip_forwarding(cover_index);
 
+    /*
+     * the route being removed may still be held back
+     */
+    ip4_fib_table_fwding_bulk_flush(fib);
+
     ip4_fib_mtrie_route_del(&fib->mtrie,
                             addr, len, dpo->dpoi_index,
                             cover_prefix.fp_len,
@@ -57,6 +57,13 @@ typedef struct ip4_fib_t_
   u32 fwd_classify_table_index;
   u32 rev_classify_table_index;
 
+  /* Non-zero while forwarding updates are held back for a bulk load */
+  u32 fwding_bulk;
+
+  /* Held back forwarding updates, and their index by prefix */
+  ip4_fib_mtrie_route_t *fwding_bulk_routes;
+  uword *fwding_bulk_by_prefix;
+
   /* Required for pool_get_aligned */
   CLIB_CACHE_LINE_ALIGN_MARK(cacheline0);
 } ip4_fib_t;
@@ -91,6 +98,16 @@ extern void ip4_fib_table_fwding_dpo_remove(ip4_fib_t *fib,
 extern u32 ip4_fib_table_lookup_lb (ip4_fib_t *fib,
 				    const ip4_address_t * dst);
 
+/**
+ * @brief Hold back the forwarding updates of a table, so that a large
+ * number of routes can be added to its mtrie in bulk.
+ * Until the matching ip4_fib_table_fwding_bulk_end, the data-plane does
+ * not see added routes. Removals push the held back routes first.
+ * Calls nest.
+ */
+extern void ip4_fib_table_fwding_bulk_start(u32 fib_index);
+extern void ip4_fib_table_fwding_bulk_end(u32 fib_index);
+
 /**
  * @brief Walk all entries in a FIB table
  * N.B: This is NOT safe to deletes. If you need to delete walk the whole
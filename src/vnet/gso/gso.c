@@ -0,0 +1,159 @@
+/*
+ * gso.c : software segmentation of GSO buffers
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/gso/gso.h>
+
+/* buffer state that describes the original chain, not its segments */
+#define GSO_SEGMENT_CLEAR_FLAGS			\
+  (VLIB_BUFFER_NEXT_PRESENT |			\
+   VLIB_BUFFER_TOTAL_LENGTH_VALID |		\
+   VLIB_BUFFER_IS_TRACED |			\
+   VLIB_BUFFER_NON_DEFAULT_FREELIST |		\
+   VLIB_BUFFER_IS_RECYCLED |			\
+   VLIB_BUFFER_RECYCLE |			\
+   VNET_BUFFER_F_GSO)
+
+u32
+vnet_gso_segment_buffer (vlib_main_t * vm, vlib_buffer_t * b, u32 ** segs)
+{
+  u16 gso_size = vnet_buffer2 (b)->gso_size;
+  i32 hdr_sz = vnet_buffer (b)->l4_hdr_offset - b->current_data +
+    vnet_buffer2 (b)->gso_l4_hdr_sz;
+  u16 l3_start = vnet_buffer (b)->l3_hdr_offset - b->current_data;
+  u32 buffer_size, n_data, n_segs, n_alloc, seg_flags, seq, src_left, i;
+  u32 *bi;
+  int is_ip4 = (b->flags & VNET_BUFFER_F_IS_IP4) != 0;
+  vlib_buffer_t *sb = b;
+  tcp_header_t *th;
+  ip4_header_t *ip4;
+  u16 ip4_id = 0;
+  u8 tcp_flags, *src;
+
+  buffer_size = vlib_buffer_free_list_buffer_size
+    (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+
+  if (PREDICT_FALSE (!(b->flags & (VNET_BUFFER_F_IS_IP4 |
+				   VNET_BUFFER_F_IS_IP6))
+		     || gso_size == 0 || hdr_sz <= 0
+		     || hdr_sz > b->current_length
+		     || b->current_data + hdr_sz + gso_size > buffer_size))
+    return 0;
+
+  n_data = vlib_buffer_length_in_chain (vm, b) - hdr_sz;
+  if (PREDICT_FALSE (n_data == 0))
+    return 0;
+  n_segs = (n_data + gso_size - 1) / gso_size;
+
+  vec_add2 (*segs, bi, n_segs);
+  n_alloc = vlib_buffer_alloc (vm, bi, n_segs);
+  if (PREDICT_FALSE (n_alloc != n_segs))
+    {
+      if (n_alloc)
+	vlib_buffer_free (vm, bi, n_alloc);
+      _vec_len (*segs) -= n_segs;
+      return 0;
+    }
+
+  th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+  ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
+  seq = clib_net_to_host_u32 (th->seq_number);
+  tcp_flags = th->flags;
+  if (is_ip4)
+    ip4_id = clib_net_to_host_u16 (ip4->fragment_id);
+
+  seg_flags = (b->flags & ~GSO_SEGMENT_CLEAR_FLAGS) |
+    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+    (is_ip4 ? VNET_BUFFER_F_OFFLOAD_IP_CKSUM : 0);
+
+  src = vlib_buffer_get_current (b) + hdr_sz;
+  src_left = b->current_length - hdr_sz;
+
+  for (i = 0; i < n_segs; i++)
+    {
+      vlib_buffer_t *nb = vlib_get_buffer (vm, bi[i]);
+      u32 len = clib_min (gso_size, n_data), left = len;
+      u16 ip_len;
+      u8 *dst;
+
+      nb->current_data = b->current_data;
+      nb->current_length = hdr_sz + len;
+      nb->total_length_not_including_first_buffer = 0;
+      nb->flags = seg_flags;
+      nb->error = b->error;
+      clib_memcpy (nb->opaque, b->opaque, sizeof (b->opaque));
+      clib_memcpy (nb->opaque2, b->opaque2, sizeof (b->opaque2));
+
+      dst = vlib_buffer_get_current (nb);
+      clib_memcpy (dst, vlib_buffer_get_current (b), hdr_sz);
+      dst += hdr_sz;
+
+      while (left)
+	{
+	  u32 n;
+
+	  if (src_left == 0)
+	    {
+	      sb = vlib_get_buffer (vm, sb->next_buffer);
+	      src = vlib_buffer_get_current (sb);
+	      src_left = sb->current_length;
+	      continue;
+	    }
+	  n = clib_min (left, src_left);
+	  clib_memcpy (dst, src, n);
+	  dst += n;
+	  src += n;
+	  src_left -= n;
+	  left -= n;
+	}
+
+      ip_len = nb->current_length - l3_start;
+      if (is_ip4)
+	{
+	  ip4_header_t *nip4 = (ip4_header_t *) (vlib_buffer_get_current (nb)
+						 + l3_start);
+	  nip4->length = clib_host_to_net_u16 (ip_len);
+	  nip4->fragment_id = clib_host_to_net_u16 (ip4_id + i);
+	}
+      else
+	{
+	  ip6_header_t *nip6 = (ip6_header_t *) (vlib_buffer_get_current (nb)
+						 + l3_start);
+	  nip6->payload_length =
+	    clib_host_to_net_u16 (ip_len - sizeof (ip6_header_t));
+	}
+
+      th = (tcp_header_t *) (nb->data + vnet_buffer (nb)->l4_hdr_offset);
+      th->seq_number = clib_host_to_net_u32 (seq + i * gso_size);
+      th->flags = tcp_flags;
+      if (i < n_segs - 1)
+	th->flags &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+      if (i > 0)
+	th->flags &= ~TCP_FLAG_CWR;
+
+      n_data -= len;
+    }
+
+  return n_segs;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,195 @@
+/*
+ * gso.h : generic segmentation offload
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_vnet_gso_gso_h
+#define included_vnet_gso_gso_h
+
+#include <vnet/vnet.h>
+#include <vnet/ethernet/packet.h>
+#include <vnet/ip/ip4_packet.h>
+#include <vnet/ip/ip6_packet.h>
+#include <vnet/tcp/tcp_packet.h>
+#include <vnet/udp/udp_packet.h>
+
+/*
+ * A GSO buffer is a TCP packet, possibly chained, whose payload is larger
+ * than the segment size the peer accepts. It travels through the graph
+ * as a single packet and is cut into gso_size segments either by a
+ * device that has VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO, or in software by
+ * interface-output right before the device tx node.
+ *
+ * GSO buffers always carry VNET_BUFFER_F_OFFLOAD_TCP_CKSUM (and
+ * VNET_BUFFER_F_OFFLOAD_IP_CKSUM for IPv4) together with valid l3 and l4
+ * header offsets. Whatever the TCP checksum field holds at that point is
+ * ignored and recomputed for every segment.
+ */
+
+/**
+ * Cut a GSO buffer into segments.
+ *
+ * Every segment is a single, newly allocated buffer holding a copy of the
+ * headers followed by up to gso_size bytes of payload. IP lengths, IPv4
+ * ids and TCP sequence numbers and flags are fixed up, checksums are left
+ * to the offload flags set on each segment. The segment indices are
+ * appended to @a segs, the original buffer is left untouched.
+ *
+ * @return number of segments, 0 if the buffer can't be segmented or no
+ *         buffers could be allocated.
+ */
+u32 vnet_gso_segment_buffer (vlib_main_t * vm, vlib_buffer_t * b,
+			     u32 ** segs);
+
+/**
+ * Fill offload metadata for a packet received from a paravirtual device.
+ *
+ * @a data points to the ethernet header, it does not have to be in the
+ * buffer yet. With @a needs_csum the sender left the L4 checksum partial,
+ * the buffer then gets the matching offload flag so the checksum is
+ * completed on the way out, and is trusted on local delivery. A non-zero
+ * @a gso_size marks a TCP packet as a GSO buffer.
+ */
+static_always_inline void
+vnet_gso_rx_offload (vlib_buffer_t * b, u8 * data, int needs_csum,
+		     u16 gso_size)
+{
+  ethernet_header_t *eh = (ethernet_header_t *) data;
+  u16 ethertype = clib_net_to_host_u16 (eh->type);
+  u16 l2_sz = sizeof (ethernet_header_t), l3_sz;
+  u32 flags;
+  u8 l4_proto;
+  int n_tags = 0;
+
+  while ((ethertype == ETHERNET_TYPE_VLAN ||
+	  ethertype == ETHERNET_TYPE_DOT1AD) && n_tags++ < 2)
+    {
+      ethernet_vlan_header_t *vh = (ethernet_vlan_header_t *) (data + l2_sz);
+      ethertype = clib_net_to_host_u16 (vh->type);
+      l2_sz += sizeof (ethernet_vlan_header_t);
+    }
+
+  if (ethertype == ETHERNET_TYPE_IP4)
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (data + l2_sz);
+      l3_sz = ip4_header_bytes (ip4);
+      l4_proto = ip4->protocol;
+      flags = VNET_BUFFER_F_IS_IP4;
+    }
+  else if (ethertype == ETHERNET_TYPE_IP6)
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) (data + l2_sz);
+      l3_sz = sizeof (ip6_header_t);
+      l4_proto = ip6->protocol;
+      flags = VNET_BUFFER_F_IS_IP6;
+    }
+  else
+    return;
+
+  vnet_buffer (b)->l2_hdr_offset = b->current_data;
+  vnet_buffer (b)->l3_hdr_offset = b->current_data + l2_sz;
+  vnet_buffer (b)->l4_hdr_offset = b->current_data + l2_sz + l3_sz;
+  flags |= VNET_BUFFER_F_L2_HDR_OFFSET_VALID |
+    VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+
+  if (needs_csum)
+    {
+      if (l4_proto == IP_PROTOCOL_TCP)
+	flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+      else if (l4_proto == IP_PROTOCOL_UDP)
+	flags |= VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+      flags |= VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+	VNET_BUFFER_F_L4_CHECKSUM_CORRECT;
+    }
+
+  if (gso_size && l4_proto == IP_PROTOCOL_TCP)
+    {
+      tcp_header_t *th = (tcp_header_t *) (data + l2_sz + l3_sz);
+      flags |= VNET_BUFFER_F_GSO | VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+      vnet_buffer2 (b)->gso_size = gso_size;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_header_bytes (th);
+    }
+
+  b->flags |= flags;
+}
+
+/**
+ * Prepare a buffer for a device that completes partial checksums, the
+ * way virtio does with VIRTIO_NET_HDR_F_NEEDS_CSUM.
+ *
+ * The IPv4 header checksum, which such devices don't offload, is computed
+ * here, and the L4 checksum field is seeded with the pseudo-header sum.
+ *
+ * @return offset of the checksum field within the L4 header, 0 if the
+ *         buffer doesn't request L4 checksum offload.
+ */
+static_always_inline u16
+vnet_gso_prepare_partial_checksum (vlib_buffer_t * b)
+{
+  ip4_header_t *ip4 = (ip4_header_t *) (b->data +
+					vnet_buffer (b)->l3_hdr_offset);
+  ip6_header_t *ip6 = (ip6_header_t *) ip4;
+  u8 *l4 = b->data + vnet_buffer (b)->l4_hdr_offset;
+  u16 csum_offset;
+  ip_csum_t sum;
+  u32 l4_len;
+
+  if ((b->flags & VNET_BUFFER_F_IS_IP4) &&
+      (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM))
+    ip4->checksum = ip4_header_checksum (ip4);
+
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+  else if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
+    csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+  else
+    return 0;
+
+  if (b->flags & VNET_BUFFER_F_IS_IP4)
+    {
+      l4_len = clib_net_to_host_u16 (ip4->length) - ip4_header_bytes (ip4);
+      sum = clib_host_to_net_u32 (l4_len + (ip4->protocol << 16));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip4->src_address, u32));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip4->dst_address, u32));
+    }
+  else
+    {
+      l4_len = clib_net_to_host_u16 (ip6->payload_length);
+      sum = clib_host_to_net_u32 (l4_len + (ip6->protocol << 16));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip6->src_address.as_u64[0], u64));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip6->src_address.as_u64[1], u64));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip6->dst_address.as_u64[0], u64));
+      sum = ip_csum_with_carry
+	(sum, clib_mem_unaligned (&ip6->dst_address.as_u64[1], u64));
+    }
+
+  *(u16 *) (l4 + csum_offset) = ip_csum_fold (sum);
+  return csum_offset;
+}
+
+#endif /* included_vnet_gso_gso_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,328 @@
+/*
+ * gso_test.c : software segmentation self test
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/gso/gso.h>
+#include <vnet/ip/ip.h>
+
+/* bytes of payload put in each buffer of the test chain, deliberately
+ * not a multiple of any segment size */
+#define GSO_TEST_BYTES_PER_BUFFER 1000
+#define GSO_TEST_SEQ 0xfffff000
+
+typedef struct
+{
+  u32 payload_size;
+  u16 gso_size;
+  u8 is_ip6;
+  u8 verbose;
+} gso_test_args_t;
+
+static_always_inline u8
+gso_test_payload_byte (u32 offset)
+{
+  return (offset * 7) ^ (offset >> 8);
+}
+
+/* Build a chained ethernet/ip/tcp GSO buffer */
+static int
+gso_test_build (vlib_main_t * vm, gso_test_args_t * a, u32 * bi_ret)
+{
+  u16 l3_sz = a->is_ip6 ? sizeof (ip6_header_t) : sizeof (ip4_header_t);
+  u16 hdr_sz = sizeof (ethernet_header_t) + l3_sz + sizeof (tcp_header_t);
+  u32 n_buffers, i, offset = 0;
+  u32 *bis = 0;
+  vlib_buffer_t *b, *prev = 0, *first;
+  ethernet_header_t *eh;
+  tcp_header_t *th;
+  u8 *p;
+
+  n_buffers = 1 + (a->payload_size + GSO_TEST_BYTES_PER_BUFFER - 1) /
+    GSO_TEST_BYTES_PER_BUFFER;
+  vec_validate (bis, n_buffers - 1);
+  if (vlib_buffer_alloc (vm, bis, n_buffers) != n_buffers)
+    {
+      vec_free (bis);
+      return -1;
+    }
+
+  /* headers in the first buffer, payload in the rest */
+  first = vlib_get_buffer (vm, bis[0]);
+  first->current_data = 0;
+  first->current_length = hdr_sz;
+  first->total_length_not_including_first_buffer = a->payload_size;
+  first->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+  eh = vlib_buffer_get_current (first);
+  memset (eh, 0, hdr_sz);
+  eh->type = clib_host_to_net_u16 (a->is_ip6 ? ETHERNET_TYPE_IP6 :
+				   ETHERNET_TYPE_IP4);
+  if (a->is_ip6)
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) (eh + 1);
+      ip6->ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (0x6 << 28);
+      ip6->payload_length = clib_host_to_net_u16 (sizeof (tcp_header_t) +
+						  a->payload_size);
+      ip6->protocol = IP_PROTOCOL_TCP;
+      ip6->hop_limit = 64;
+      ip6->src_address.as_u64[0] = clib_host_to_net_u64 (0x20010db8ULL << 32);
+      ip6->src_address.as_u64[1] = clib_host_to_net_u64 (1);
+      ip6->dst_address.as_u64[0] = clib_host_to_net_u64 (0x20010db8ULL << 32);
+      ip6->dst_address.as_u64[1] = clib_host_to_net_u64 (2);
+      first->flags |= VNET_BUFFER_F_IS_IP6;
+    }
+  else
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (eh + 1);
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->length = clib_host_to_net_u16 (sizeof (ip4_header_t) +
+					  sizeof (tcp_header_t) +
+					  a->payload_size);
+      ip4->fragment_id = clib_host_to_net_u16 (0xfff0);
+      ip4->ttl = 64;
+      ip4->protocol = IP_PROTOCOL_TCP;
+      ip4->src_address.as_u32 = clib_host_to_net_u32 (0x0a000001);
+      ip4->dst_address.as_u32 = clib_host_to_net_u32 (0x0a000002);
+      first->flags |= VNET_BUFFER_F_IS_IP4 | VNET_BUFFER_F_OFFLOAD_IP_CKSUM;
+    }
+
+  th = (tcp_header_t *) ((u8 *) eh + sizeof (ethernet_header_t) + l3_sz);
+  th->src_port = clib_host_to_net_u16 (1234);
+  th->dst_port = clib_host_to_net_u16 (80);
+  th->seq_number = clib_host_to_net_u32 (GSO_TEST_SEQ);
+  th->data_offset_and_reserved = (sizeof (tcp_header_t) / 4) << 4;
+  th->flags = TCP_FLAG_ACK | TCP_FLAG_PSH | TCP_FLAG_FIN | TCP_FLAG_CWR;
+  th->window = clib_host_to_net_u16 (0xffff);
+
+  vnet_buffer (first)->l2_hdr_offset = 0;
+  vnet_buffer (first)->l3_hdr_offset = sizeof (ethernet_header_t);
+  vnet_buffer (first)->l4_hdr_offset = sizeof (ethernet_header_t) + l3_sz;
+  vnet_buffer2 (first)->gso_size = a->gso_size;
+  vnet_buffer2 (first)->gso_l4_hdr_sz = sizeof (tcp_header_t);
+  first->flags |= VNET_BUFFER_F_L2_HDR_OFFSET_VALID |
+    VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_L4_HDR_OFFSET_VALID |
+    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM | VNET_BUFFER_F_GSO;
+
+  prev = first;
+  for (i = 1; i < n_buffers; i++)
+    {
+      u32 len = clib_min (GSO_TEST_BYTES_PER_BUFFER,
+			  a->payload_size - offset), j;
+
+      b = vlib_get_buffer (vm, bis[i]);
+      b->current_data = 0;
+      b->current_length = len;
+      b->flags = 0;
+      p = vlib_buffer_get_current (b);
+      for (j = 0; j < len; j++)
+	p[j] = gso_test_payload_byte (offset + j);
+      offset += len;
+
+      prev->next_buffer = bis[i];
+      prev->flags |= VLIB_BUFFER_NEXT_PRESENT;
+      prev = b;
+    }
+
+  *bi_ret = bis[0];
+  vec_free (bis);
+  return 0;
+}
+
+/* Check one segment, returns a description of the first problem */
+static u8 *
+gso_test_check_segment (vlib_main_t * vm, gso_test_args_t * a,
+			vlib_buffer_t * b, u32 seg, u32 n_segs)
+{
+  u16 l3_sz = a->is_ip6 ? sizeof (ip6_header_t) : sizeof (ip4_header_t);
+  u16 hdr_sz = sizeof (ethernet_header_t) + l3_sz + sizeof (tcp_header_t);
+  u32 len = clib_min (a->gso_size, a->payload_size - seg * a->gso_size);
+  u8 *data = vlib_buffer_get_current (b);
+  ip4_header_t *ip4 = (ip4_header_t *) (data + sizeof (ethernet_header_t));
+  ip6_header_t *ip6 = (ip6_header_t *) ip4;
+  tcp_header_t *th = (tcp_header_t *) ((u8 *) ip4 + l3_sz);
+  u8 expect_flags = TCP_FLAG_ACK;
+  u16 full, partial, csum_offset;
+  int bogus;
+  u32 i;
+
+  if (b->flags & (VLIB_BUFFER_NEXT_PRESENT | VNET_BUFFER_F_GSO))
+    return format (0, "flags %U", format_vnet_buffer, b);
+  if (!(b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM))
+    return format (0, "no tcp checksum offload");
+  if (b->current_length != hdr_sz + len)
+    return format (0, "length %u, expected %u", b->current_length,
+		   hdr_sz + len);
+
+  if (a->is_ip6)
+    {
+      if (clib_net_to_host_u16 (ip6->payload_length) !=
+	  sizeof (tcp_header_t) + len)
+	return format (0, "ip6 payload length %u",
+		       clib_net_to_host_u16 (ip6->payload_length));
+    }
+  else
+    {
+      if (clib_net_to_host_u16 (ip4->length) != l3_sz + sizeof (*th) + len)
+	return format (0, "ip4 length %u", clib_net_to_host_u16 (ip4->length));
+      if (clib_net_to_host_u16 (ip4->fragment_id) != (u16) (0xfff0 + seg))
+	return format (0, "ip4 id 0x%x",
+		       clib_net_to_host_u16 (ip4->fragment_id));
+    }
+
+  if (clib_net_to_host_u32 (th->seq_number) !=
+      GSO_TEST_SEQ + seg * a->gso_size)
+    return format (0, "seq 0x%x", clib_net_to_host_u32 (th->seq_number));
+
+  if (seg == 0)
+    expect_flags |= TCP_FLAG_CWR;
+  if (seg == n_segs - 1)
+    expect_flags |= TCP_FLAG_PSH | TCP_FLAG_FIN;
+  if (th->flags != expect_flags)
+    return format (0, "tcp flags 0x%x, expected 0x%x", th->flags,
+		   expect_flags);
+
+  for (i = 0; i < len; i++)
+    if (data[hdr_sz + i] != gso_test_payload_byte (seg * a->gso_size + i))
+      return format (0, "payload byte %u", i);
+
+  /* a partial checksum completed over the tcp segment must match the
+   * checksum computed in software */
+  th->checksum = 0;
+  if (a->is_ip6)
+    full = ip6_tcp_udp_icmp_compute_checksum (vm, b, ip6, &bogus);
+  else
+    full = ip4_tcp_udp_compute_checksum (vm, b, ip4);
+
+  csum_offset = vnet_gso_prepare_partial_checksum (b);
+  if (csum_offset != STRUCT_OFFSET_OF (tcp_header_t, checksum))
+    return format (0, "checksum offset %u", csum_offset);
+  if (!a->is_ip6 && !ip4_header_checksum_is_valid (ip4))
+    return format (0, "ip4 header checksum");
+  partial = ~ip_csum_fold (ip_incremental_checksum (0, th,
+						    sizeof (*th) + len));
+  if (partial != full)
+    return format (0, "partial checksum 0x%x, expected 0x%x", partial, full);
+
+  return 0;
+}
+
+static int
+gso_test_run (vlib_main_t * vm, gso_test_args_t * a)
+{
+  u32 bi, n_segs, expect, i;
+  u32 *segs = 0;
+  u8 *err = 0;
+
+  if (gso_test_build (vm, a, &bi))
+    {
+      vlib_cli_output (vm, "buffer allocation failed");
+      return -1;
+    }
+
+  n_segs = vnet_gso_segment_buffer (vm, vlib_get_buffer (vm, bi), &segs);
+  expect = (a->payload_size + a->gso_size - 1) / a->gso_size;
+  if (n_segs != expect || vec_len (segs) != n_segs)
+    err = format (0, "%u segments, expected %u", n_segs, expect);
+
+  for (i = 0; i < vec_len (segs) && !err; i++)
+    {
+      err = gso_test_check_segment (vm, a, vlib_get_buffer (vm, segs[i]),
+				    i, n_segs);
+      if (err)
+	err = format (err, " in segment %u", i);
+    }
+
+  vlib_cli_output (vm, "%-6s payload %-6u gso-size %-5u segments %-4u %s %v",
+		   a->is_ip6 ? "ip6" : "ip4", a->payload_size, a->gso_size,
+		   n_segs, err ? "FAILED" : "OK", err);
+
+  vlib_buffer_free (vm, &bi, 1);
+  if (vec_len (segs))
+    vlib_buffer_free (vm, segs, vec_len (segs));
+  vec_free (segs);
+  vec_free (err);
+  return err != 0;
+}
+
+static clib_error_t *
+test_gso_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  gso_test_args_t a = {.payload_size = 10000,.gso_size = 1448 };
+  u32 payload_sizes[] = { 1, 1448, 1449, 2896 };
+  int n_fail = 0, i;
+
+  if (unformat_user (input, unformat_line_input, line_input))
+    {
+      while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (line_input, "size %u", &a.payload_size))
+	    ;
+	  else if (unformat (line_input, "gso-size %u", &a.gso_size))
+	    ;
+	  else
+	    {
+	      clib_error_t *error;
+	      error = clib_error_return (0, "unknown input `%U'",
+					 format_unformat_error, line_input);
+	      unformat_free (line_input);
+	      return error;
+	    }
+	}
+      unformat_free (line_input);
+    }
+
+  if (a.payload_size == 0 || a.gso_size == 0 || a.payload_size > 65000)
+    return clib_error_return (0, "invalid size");
+
+  for (a.is_ip6 = 0; a.is_ip6 < 2; a.is_ip6++)
+    {
+      gso_test_args_t edge = a;
+
+      n_fail += gso_test_run (vm, &a);
+
+      /* segment boundary edge cases */
+      for (i = 0; i < ARRAY_LEN (payload_sizes); i++)
+	{
+	  edge.payload_size = payload_sizes[i];
+	  edge.gso_size = 1448;
+	  n_fail += gso_test_run (vm, &edge);
+	}
+    }
+
+  vlib_cli_output (vm, "gso segmentation tests: %s",
+		   n_fail ? "FAILED" : "passed");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_gso_command, static) =
+{
+  .path = "test gso",
+  .short_help = "test gso [size <payload-bytes>] [gso-size <bytes>]",
+  .function = test_gso_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -34,8 +34,8 @@ typedef struct
 
   per_inteface_handoff_data_t *if_data;
 
-  /* Worker handoff index */
-  u32 frame_queue_index;
+  /* Worker handoff queue index */
+  u32 handoff_queue_index;
 
   /* convenience variables */
   vlib_main_t *vlib_main;
@@ -70,30 +70,32 @@ format_worker_handoff_trace (u8 * s, va_list * args)
 
 vlib_node_registration_t handoff_node;
 
+#define foreach_worker_handoff_error \
+_(CONGESTION_DROP, "congestion drop")
+
+typedef enum
+{
+#define _(sym,str) WORKER_HANDOFF_ERROR_##sym,
+  foreach_worker_handoff_error
+#undef _
+    WORKER_HANDOFF_N_ERROR,
+} worker_handoff_error_t;
+
+static char *worker_handoff_error_strings[] = {
+#define _(sym,string) string,
+  foreach_worker_handoff_error
+#undef _
+};
+
 static uword
 worker_handoff_node_fn (vlib_main_t * vm,
 			vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
   handoff_main_t *hm = &handoff_main;
-  vlib_thread_main_t *tm = vlib_get_thread_main ();
   u32 n_left_from, *from;
-  static __thread vlib_frame_queue_elt_t **handoff_queue_elt_by_worker_index;
-  static __thread vlib_frame_queue_t **congested_handoff_queue_by_worker_index
-    = 0;
-  vlib_frame_queue_elt_t *hf = 0;
-  int i;
-  u32 n_left_to_next_worker = 0, *to_next_worker = 0;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti = thread_indices;
   u32 next_worker_index = 0;
-  u32 current_worker_index = ~0;
-
-  if (PREDICT_FALSE (handoff_queue_elt_by_worker_index == 0))
-    {
-      vec_validate (handoff_queue_elt_by_worker_index, tm->n_vlib_mains - 1);
-
-      vec_validate_init_empty (congested_handoff_queue_by_worker_index,
-			       hm->first_worker_index + hm->num_workers - 1,
-			       (vlib_frame_queue_t *) (~0));
-    }
+  u32 n_drop;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -147,35 +149,10 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	index0 = hash % vec_len (ihd0->workers);
 
       next_worker_index += ihd0->workers[index0];
+      ti[0] = next_worker_index;
+      ti++;
 
-      if (next_worker_index != current_worker_index)
-	{
-	  if (hf)
-	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
-
-	  hf = vlib_get_worker_handoff_queue_elt (hm->frame_queue_index,
-						  next_worker_index,
-						  handoff_queue_elt_by_worker_index);
-
-	  n_left_to_next_worker = VLIB_FRAME_SIZE - hf->n_vectors;
-	  to_next_worker = &hf->buffer_index[hf->n_vectors];
-	  current_worker_index = next_worker_index;
-	}
-
-      /* enqueue to correct worker thread */
-      to_next_worker[0] = bi0;
-      to_next_worker++;
-      n_left_to_next_worker--;
-
-      if (n_left_to_next_worker == 0)
-	{
-	  hf->n_vectors = VLIB_FRAME_SIZE;
-	  vlib_put_frame_queue_elt (hf);
-	  current_worker_index = ~0;
-	  handoff_queue_elt_by_worker_index[next_worker_index] = 0;
-	  hf = 0;
-	}
-
+      /* trace now, the buffer belongs to the other worker once handed off */
       if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
 			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
 	{
@@ -185,35 +162,18 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	  t->next_worker_index = next_worker_index - hm->first_worker_index;
 	  t->buffer_index = bi0;
 	}
-
     }
 
-  if (hf)
-    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
+  /* one lock-free enqueue per worker, whatever the batch size */
+  n_drop = vlib_handoff_queue_enqueue_to_threads (vm, hm->handoff_queue_index,
+						  vlib_frame_vector_args
+						  (frame), thread_indices,
+						  frame->n_vectors);
+  if (n_drop)
+    vlib_node_increment_counter (vm, node->node_index,
+				 WORKER_HANDOFF_ERROR_CONGESTION_DROP,
+				 n_drop);
 
-  /* Ship frames to the worker nodes */
-  for (i = 0; i < vec_len (handoff_queue_elt_by_worker_index); i++)
-    {
-      if (handoff_queue_elt_by_worker_index[i])
-	{
-	  hf = handoff_queue_elt_by_worker_index[i];
-	  /*
-	   * It works better to let the handoff node
-	   * rate-adapt, always ship the handoff queue element.
-	   */
-	  if (1 || hf->n_vectors == hf->last_n_vectors)
-	    {
-	      vlib_put_frame_queue_elt (hf);
-	      handoff_queue_elt_by_worker_index[i] = 0;
-	    }
-	  else
-	    hf->last_n_vectors = hf->n_vectors;
-	}
-      congested_handoff_queue_by_worker_index[i] =
-	(vlib_frame_queue_t *) (~0);
-    }
-  hf = 0;
-  current_worker_index = ~0;
   return frame->n_vectors;
 }
 
@@ -224,6 +184,8 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
   .vector_size = sizeof (u32),
   .format_trace = format_worker_handoff_trace,
   .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (worker_handoff_error_strings),
+  .error_strings = worker_handoff_error_strings,
 
   .n_next_nodes = 1,
   .next_nodes = {
@@ -254,9 +216,10 @@ interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
   if (clib_bitmap_last_set (bitmap) >= hm->num_workers)
     return VNET_API_ERROR_INVALID_WORKER;
 
-  if (hm->frame_queue_index == ~0)
-    hm->frame_queue_index =
-      vlib_frame_queue_main_init (handoff_dispatch_node.index, 0);
+  if (hm->handoff_queue_index == ~0)
+    hm->handoff_queue_index =
+      vlib_handoff_queue_main_init (handoff_dispatch_node.index, 0,
+				    VLIB_HANDOFF_QUEUE_POLICY_DROP);
 
   vec_validate (hm->if_data, sw_if_index);
   d = vec_elt_at_index (hm->if_data, sw_if_index);
@@ -578,7 +541,7 @@ handoff_init (vlib_main_t * vm)
   hm->vlib_main = vm;
   hm->vnet_main = &vnet_main;
 
-  hm->frame_queue_index = ~0;
+  hm->handoff_queue_index = ~0;
 
   return 0;
 }
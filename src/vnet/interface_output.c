@@ -43,6 +43,7 @@
 #include <vnet/ip/ip6.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/feature/feature.h>
+#include <vnet/gso/gso.h>
 
 typedef struct
 {
@@ -175,6 +176,12 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
   th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
   uh = (udp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
 
+  /* the field may hold a partial (pseudo-header) sum, start from zero */
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    th->checksum = 0;
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
+    uh->checksum = 0;
+
   if (is_ip4)
     {
       ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
@@ -204,7 +211,8 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 				   vlib_node_runtime_t * node,
 				   vlib_frame_t * frame, vnet_main_t * vnm,
 				   vnet_hw_interface_t * hi,
-				   int do_tx_offloads)
+				   int do_tx_offloads,
+				   int do_segmentation)
 {
   vnet_interface_output_runtime_t *rt = (void *) node->runtime_data;
   vnet_sw_interface_t *si;
@@ -213,6 +221,8 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
   u32 n_bytes_b0, n_bytes_b1, n_bytes_b2, n_bytes_b3;
   u32 thread_index = vm->thread_index;
   vnet_interface_main_t *im = &vnm->interface_main;
+  vnet_interface_per_thread_data_t *ptd =
+    vec_elt_at_index (im->per_thread_data, thread_index);
   u32 next_index = VNET_INTERFACE_OUTPUT_NEXT_TX;
   u32 current_config_index = ~0;
   u8 arc = im->output_feature_arc_index;
@@ -289,6 +299,17 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	  vlib_prefetch_buffer_with_index (vm, from[6], LOAD);
 	  vlib_prefetch_buffer_with_index (vm, from[7], LOAD);
 
+	  /* GSO buffers are segmented in the single loop */
+	  if (do_segmentation)
+	    {
+	      or_flags = vlib_get_buffer (vm, from[0])->flags |
+		vlib_get_buffer (vm, from[1])->flags |
+		vlib_get_buffer (vm, from[2])->flags |
+		vlib_get_buffer (vm, from[3])->flags;
+	      if (PREDICT_FALSE (or_flags & VNET_BUFFER_F_GSO))
+		break;
+	    }
+
 	  bi0 = from[0];
 	  bi1 = from[1];
 	  bi2 = from[2];
@@ -397,10 +418,7 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	  u32 tx_swif0;
 
 	  bi0 = from[0];
-	  to_tx[0] = bi0;
 	  from += 1;
-	  to_tx += 1;
-	  n_left_to_tx -= 1;
 
 	  b0 = vlib_get_buffer (vm, bi0);
 
@@ -408,6 +426,63 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	     driver tx function. */
 	  ASSERT (b0->current_length > 0);
 
+	  if (do_segmentation && PREDICT_FALSE (b0->flags & VNET_BUFFER_F_GSO))
+	    {
+	      u32 n_segs, *seg;
+
+	      tx_swif0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
+	      vec_reset_length (ptd->split_buffers);
+	      n_segs = vnet_gso_segment_buffer (vm, b0, &ptd->split_buffers);
+	      vlib_buffer_free (vm, &bi0, 1);
+	      if (PREDICT_FALSE (n_segs == 0))
+		{
+		  vlib_error_count
+		    (vm, node->node_index,
+		     VNET_INTERFACE_OUTPUT_ERROR_NO_BUFFERS_FOR_GSO, 1);
+		  continue;
+		}
+
+	      n_bytes_b0 = 0;
+	      /* *INDENT-OFF* */
+	      vec_foreach (seg, ptd->split_buffers)
+		{
+		  vlib_buffer_t *sb0 = vlib_get_buffer (vm, seg[0]);
+
+		  if (PREDICT_FALSE (n_left_to_tx == 0))
+		    {
+		      vlib_put_next_frame (vm, node, next_index, n_left_to_tx);
+		      vlib_get_new_next_frame (vm, node, next_index, to_tx,
+					       n_left_to_tx);
+		    }
+		  to_tx[0] = seg[0];
+		  to_tx += 1;
+		  n_left_to_tx -= 1;
+
+		  n_bytes_b0 += sb0->current_length;
+		  if (PREDICT_FALSE (current_config_index != ~0))
+		    {
+		      vnet_buffer (sb0)->feature_arc_index = arc;
+		      sb0->current_config_index = current_config_index;
+		    }
+		  if (do_tx_offloads)
+		    calc_checksums (vm, sb0);
+		}
+	      /* *INDENT-ON* */
+
+	      n_bytes += n_bytes_b0;
+	      n_packets += n_segs;
+	      if (PREDICT_FALSE (tx_swif0 != rt->sw_if_index))
+		vlib_increment_combined_counter (im->combined_sw_if_counters +
+						 VNET_INTERFACE_COUNTER_TX,
+						 thread_index, tx_swif0,
+						 n_segs, n_bytes_b0);
+	      continue;
+	    }
+
+	  to_tx[0] = bi0;
+	  to_tx += 1;
+	  n_left_to_tx -= 1;
+
 	  n_bytes_b0 = vlib_buffer_length_in_chain (vm, b0);
 	  tx_swif0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
 	  n_bytes += n_bytes_b0;
@@ -452,12 +527,18 @@ vnet_interface_output_node (vlib_main_t * vm, vlib_node_runtime_t * node,
   vnet_interface_output_runtime_t *rt = (void *) node->runtime_data;
   hi = vnet_get_sup_hw_interface (vnm, rt->sw_if_index);
 
-  if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD)
+  if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)
+    return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
+					      /* do_tx_offloads */ 0,
+					      /* do_segmentation */ 0);
+  else if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD)
     return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
-					      /* do_tx_offloads */ 0);
+					      /* do_tx_offloads */ 0,
+					      /* do_segmentation */ 1);
   else
     return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
-					      /* do_tx_offloads */ 1);
+					      /* do_tx_offloads */ 1,
+					      /* do_segmentation */ 1);
 }
 
 VLIB_NODE_FUNCTION_MULTIARCH_CLONE (vnet_interface_output_node);
@@ -2025,10 +2025,24 @@ typedef enum
 #define IP4_MCAST_ADDR_MASK 0xffff7f00
 #endif
 
+/*
+ * interface-output segments GSO buffers to the MTU, so they are exempt
+ * from the check, but only on a plain rewrite: a midchain or an output
+ * feature (ipsec-output) may encapsulate them first, and the outer packet
+ * can't be segmented. Those are checked like any other packet.
+ */
 always_inline void
 ip4_mtu_check (vlib_buffer_t * b, u16 packet_len,
-	       u16 adj_packet_bytes, bool df, u32 * next, u32 * error)
+	       u16 adj_packet_bytes, bool df, bool can_segment,
+	       u32 * next, u32 * error)
 {
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO))
+    {
+      if (can_segment)
+	return;
+      b->flags &= ~VNET_BUFFER_F_GSO;
+    }
+
   if (packet_len > adj_packet_bytes)
     {
       *error = IP4_ERROR_MTU_EXCEEDED;
@@ -2212,11 +2226,15 @@ ip4_rewrite_inline (vlib_main_t * vm,
 			 adj0[0].rewrite_header.max_l3_packet_bytes,
 			 ip0->flags_and_fragment_offset &
 			 clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
+			 !is_midchain && !(adj0[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next0, &error0);
 	  ip4_mtu_check (p1, clib_net_to_host_u16 (ip1->length),
 			 adj1[0].rewrite_header.max_l3_packet_bytes,
 			 ip1->flags_and_fragment_offset &
 			 clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
+			 !is_midchain && !(adj1[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next1, &error1);
 
 	  if (is_mcast)
@@ -2405,6 +2423,8 @@ ip4_rewrite_inline (vlib_main_t * vm,
 			 adj0[0].rewrite_header.max_l3_packet_bytes,
 			 ip0->flags_and_fragment_offset &
 			 clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT),
+			 !is_midchain && !(adj0[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next0, &error0);
 
 	  if (is_mcast)
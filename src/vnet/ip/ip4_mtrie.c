@@ -162,8 +162,8 @@ ply_8_init (ip4_fib_mtrie_8_ply_t * p,
 }
 
 static void
-ply_16_init (ip4_fib_mtrie_16_ply_t * p,
-	     ip4_fib_mtrie_leaf_t init, uword prefix_len)
+ply_root_init (ip4_fib_mtrie_root_ply_t * p,
+	       ip4_fib_mtrie_leaf_t init, uword prefix_len)
 {
   memset (p->dst_address_bits_of_leaves, prefix_len,
 	  sizeof (p->dst_address_bits_of_leaves));
@@ -198,23 +198,64 @@ get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 void
 ip4_mtrie_free (ip4_fib_mtrie_t * m)
 {
-  /* the root ply is embedded so the is nothing to do,
+  /* the 16 bit root ply is embedded so the is nothing to do,
    * the assumption being that the IP4 FIB table has emptied the trie
    * before deletion.
    */
 #if CLIB_DEBUG > 0
+  ip4_fib_mtrie_root_ply_t *root = ip4_fib_mtrie_root_ply (m);
   int i;
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  for (i = 0; i < ARRAY_LEN (root->leaves); i++)
     {
-      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]));
+      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (root->leaves[i]));
     }
 #endif
+#if IP4_MTRIE_ROOT_PLY_BITS == 24
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  clib_mem_free (m->root_ply);
+  clib_mem_set_heap (old_heap);
+  m->root_ply = 0;
+#endif
 }
 
 void
 ip4_mtrie_init (ip4_fib_mtrie_t * m)
 {
-  ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+#if IP4_MTRIE_ROOT_PLY_BITS == 24
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  m->root_ply = clib_mem_alloc_aligned (sizeof (ip4_fib_mtrie_root_ply_t),
+					CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (old_heap);
+#endif
+  ply_root_init (ip4_fib_mtrie_root_ply (m), IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+}
+
+/*
+ * The 16 bit root ply is indexed by the first 2 address bytes in network
+ * order, so convert to host order to do arithmetic on slots.
+ */
+always_inline u32
+root_slot_to_host (u32 slot)
+{
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
+  return clib_net_to_host_u16 (slot);
+#else
+  return slot;
+#endif
+}
+
+always_inline u32
+root_slot_from_host (u32 slot)
+{
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
+  return clib_host_to_net_u16 (slot);
+#else
+  return slot;
+#endif
 }
 
 typedef struct
@@ -370,8 +411,7 @@ set_leaf (ip4_fib_mtrie_t * m,
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
 
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -399,18 +439,18 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	       const ip4_fib_mtrie_set_unset_leaf_args_t * a)
 {
   ip4_fib_mtrie_leaf_t old_leaf, new_leaf;
-  ip4_fib_mtrie_16_ply_t *old_ply;
+  ip4_fib_mtrie_root_ply_t *old_ply;
   i32 n_dst_bits_next_plies;
-  u16 dst_byte;
+  u32 dst_byte;
 
-  old_ply = &m->root_ply;
+  old_ply = ip4_fib_mtrie_root_ply (m);
 
   ASSERT (a->dst_address_length <= 32);
 
   /* how many bits of the destination address are in the next PLY */
-  n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
+  n_dst_bits_next_plies = a->dst_address_length - IP4_MTRIE_ROOT_PLY_BITS;
 
-  dst_byte = a->dst_address.as_u16[0];
+  dst_byte = ip4_fib_mtrie_root_slot (&a->dst_address);
 
   /* Number of bits next plies <= 0 => insert leaves this ply. */
   if (n_dst_bits_next_plies <= 0)
@@ -420,8 +460,8 @@ set_root_leaf (ip4_fib_mtrie_t * m,
       u32 i, n_dst_bits_this_ply;
 
       /* The number of bits, and hence slots/buckets, we will fill */
-      n_dst_bits_this_ply = 16 - a->dst_address_length;
-      ASSERT ((clib_host_to_net_u16 (a->dst_address.as_u16[0]) &
+      n_dst_bits_this_ply = IP4_MTRIE_ROOT_PLY_BITS - a->dst_address_length;
+      ASSERT ((root_slot_to_host (dst_byte) &
 	       pow2_mask (n_dst_bits_this_ply)) == 0);
 
       /* Starting at the value of the byte at this section of the v4 address
@@ -429,11 +469,9 @@ set_root_leaf (ip4_fib_mtrie_t * m,
       for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
 	{
 	  ip4_fib_mtrie_8_ply_t *new_ply;
-	  u16 slot;
+	  u32 slot;
 
-	  slot = clib_net_to_host_u16 (dst_byte);
-	  slot += i;
-	  slot = clib_host_to_net_u16 (slot);
+	  slot = root_slot_from_host (root_slot_to_host (dst_byte) + i);
 
 	  old_leaf = old_ply->leaves[slot];
 	  old_leaf_is_terminal = ip4_fib_mtrie_leaf_is_terminal (old_leaf);
@@ -469,7 +507,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	      /* The current leaf is less specific and not termial (i.e. a ply),
 	       * recurse on down the trie */
 	      new_ply = get_next_ply_for_leaf (m, old_leaf);
-	      set_leaf (m, a, new_ply - ip4_ply_pool, 2);
+	      set_leaf (m, a, new_ply - ip4_ply_pool, IP4_MTRIE_ROOT_PLY_BYTES);
 	    }
 	  /*
 	   * else
@@ -485,7 +523,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
       ip4_fib_mtrie_8_ply_t *new_ply;
       u8 ply_base_len;
 
-      ply_base_len = 16;
+      ply_base_len = IP4_MTRIE_ROOT_PLY_BITS;
 
       old_leaf = old_ply->leaves[dst_byte];
 
@@ -493,8 +531,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	{
 	  /* There is a leaf occupying the slot. Replace it with a new ply */
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -506,7 +543,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
       else
 	new_ply = get_next_ply_for_leaf (m, old_leaf);
 
-      set_leaf (m, a, new_ply - ip4_ply_pool, 2);
+      set_leaf (m, a, new_ply - ip4_ply_pool, IP4_MTRIE_ROOT_PLY_BYTES);
     }
 }
 
@@ -551,9 +588,7 @@ unset_leaf (ip4_fib_mtrie_t * m,
 
 	  old_ply->leaves[i] =
 	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
-	  old_ply->dst_address_bits_of_leaves[i] =
-	    clib_max (old_ply->dst_address_bits_base,
-		      a->cover_address_length);
+	  old_ply->dst_address_bits_of_leaves[i] = a->cover_address_length;
 
 	  old_ply->n_non_empty_leafs +=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, i);
@@ -590,18 +625,19 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
   ip4_fib_mtrie_leaf_t old_leaf, del_leaf;
   i32 n_dst_bits_next_plies;
   i32 i, n_dst_bits_this_ply, old_leaf_is_terminal;
-  u16 dst_byte;
-  ip4_fib_mtrie_16_ply_t *old_ply;
+  u32 dst_byte;
+  ip4_fib_mtrie_root_ply_t *old_ply;
 
   ASSERT (a->dst_address_length <= 32);
 
-  old_ply = &m->root_ply;
-  n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
+  old_ply = ip4_fib_mtrie_root_ply (m);
+  n_dst_bits_next_plies = a->dst_address_length - IP4_MTRIE_ROOT_PLY_BITS;
 
-  dst_byte = a->dst_address.as_u16[0];
+  dst_byte = ip4_fib_mtrie_root_slot (&a->dst_address);
 
   n_dst_bits_this_ply = (n_dst_bits_next_plies <= 0 ?
-			 (16 - a->dst_address_length) : 0);
+			 (IP4_MTRIE_ROOT_PLY_BITS -
+			  a->dst_address_length) : 0);
 
   del_leaf = ip4_fib_mtrie_leaf_set_adj_index (a->adj_index);
 
@@ -609,18 +645,17 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
    * fill the buckets/slots of the ply */
   for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
     {
-      u16 slot;
+      u32 slot;
 
-      slot = clib_net_to_host_u16 (dst_byte);
-      slot += i;
-      slot = clib_host_to_net_u16 (slot);
+      slot = root_slot_from_host (root_slot_to_host (dst_byte) + i);
 
       old_leaf = old_ply->leaves[slot];
       old_leaf_is_terminal = ip4_fib_mtrie_leaf_is_terminal (old_leaf);
 
       if (old_leaf == del_leaf
 	  || (!old_leaf_is_terminal
-	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf), 2)))
+	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf),
+			     IP4_MTRIE_ROOT_PLY_BYTES)))
 	{
 	  old_ply->leaves[slot] =
 	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
@@ -646,6 +681,179 @@ ip4_fib_mtrie_route_add (ip4_fib_mtrie_t * m,
   set_root_leaf (m, &a);
 }
 
+/*
+ * Copy a ply and everything below it
+ */
+static ip4_fib_mtrie_leaf_t
+ply_clone (ip4_fib_mtrie_t * m, u32 old_ply_index)
+{
+  ip4_fib_mtrie_8_ply_t *old_ply, *new_ply;
+  ip4_fib_mtrie_leaf_t l;
+  u32 new_ply_index, i;
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  pool_get_aligned (ip4_ply_pool, new_ply, CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (old_heap);
+
+  new_ply_index = new_ply - ip4_ply_pool;
+  old_ply = pool_elt_at_index (ip4_ply_pool, old_ply_index);
+  clib_memcpy (new_ply, old_ply, sizeof (*new_ply));
+
+  for (i = 0; i < ARRAY_LEN (new_ply->leaves); i++)
+    {
+      l = pool_elt_at_index (ip4_ply_pool, new_ply_index)->leaves[i];
+      if (ip4_fib_mtrie_leaf_is_next_ply (l))
+	{
+	  l = ply_clone (m, ip4_fib_mtrie_leaf_get_next_ply_index (l));
+	  /* Refetch since ply_clone may move pool. */
+	  new_ply = pool_elt_at_index (ip4_ply_pool, new_ply_index);
+	  new_ply->leaves[i] = l;
+	}
+    }
+
+  return ip4_fib_mtrie_leaf_set_next_ply_index (new_ply_index);
+}
+
+/*
+ * Free a ply and everything below it
+ */
+static void
+ply_free (ip4_fib_mtrie_t * m, ip4_fib_mtrie_8_ply_t * ply)
+{
+  ip4_fib_mtrie_leaf_t l;
+  void *old_heap;
+  u32 i;
+
+  for (i = 0; i < ARRAY_LEN (ply->leaves); i++)
+    {
+      l = ply->leaves[i];
+      if (ip4_fib_mtrie_leaf_is_next_ply (l))
+	ply_free (m, get_next_ply_for_leaf (m, l));
+    }
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  pool_put (ip4_ply_pool, ply);
+  clib_mem_set_heap (old_heap);
+}
+
+/*
+ * Order routes so that those that end in the root ply come first, and the
+ * rest are grouped by root slot. Less specific routes go first, so later
+ * ones only ever overwrite slots and never have to be pushed down into
+ * plies.
+ */
+static int
+ip4_fib_mtrie_route_cmp (void *a1, void *a2)
+{
+  ip4_fib_mtrie_route_t *r1 = a1, *r2 = a2;
+  u8 long1, long2;
+  u32 v1, v2;
+
+  long1 = r1->dst_address_length > IP4_MTRIE_ROOT_PLY_BITS;
+  long2 = r2->dst_address_length > IP4_MTRIE_ROOT_PLY_BITS;
+  if (long1 != long2)
+    return long1 - long2;
+
+  if (long1)
+    {
+      v1 = root_slot_to_host (ip4_fib_mtrie_root_slot (&r1->dst_address));
+      v2 = root_slot_to_host (ip4_fib_mtrie_root_slot (&r2->dst_address));
+      if (v1 != v2)
+	return (v1 > v2) - (v1 < v2);
+    }
+
+  if (r1->dst_address_length != r2->dst_address_length)
+    return ((i32) r1->dst_address_length - (i32) r2->dst_address_length);
+
+  v1 = clib_net_to_host_u32 (r1->dst_address.as_u32);
+  v2 = clib_net_to_host_u32 (r2->dst_address.as_u32);
+  return (v1 > v2) - (v1 < v2);
+}
+
+/*
+ * Add routes that all hang off the same root slot. They are added to a
+ * new sub-trie that the data-plane cannot see, which then replaces the
+ * slot's leaf in one write.
+ */
+static void
+set_root_slot_bulk (ip4_fib_mtrie_t * m,
+		    ip4_fib_mtrie_route_t * routes, u32 n_routes)
+{
+  ip4_fib_mtrie_set_unset_leaf_args_t a;
+  ip4_fib_mtrie_leaf_t old_leaf, new_leaf;
+  ip4_fib_mtrie_root_ply_t *root;
+  u32 slot, new_ply_index, i;
+
+  root = ip4_fib_mtrie_root_ply (m);
+  slot = ip4_fib_mtrie_root_slot (&routes[0].dst_address);
+  old_leaf = root->leaves[slot];
+
+  if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+    new_leaf = ply_create (m, old_leaf,
+			   root->dst_address_bits_of_leaves[slot],
+			   IP4_MTRIE_ROOT_PLY_BITS);
+  else
+    new_leaf = ply_clone (m, ip4_fib_mtrie_leaf_get_next_ply_index
+			  (old_leaf));
+
+  new_ply_index = ip4_fib_mtrie_leaf_get_next_ply_index (new_leaf);
+  for (i = 0; i < n_routes; i++)
+    {
+      a.dst_address = routes[i].dst_address;
+      a.dst_address_length = routes[i].dst_address_length;
+      a.adj_index = routes[i].adj_index;
+      set_leaf (m, &a, new_ply_index, IP4_MTRIE_ROOT_PLY_BYTES);
+    }
+
+  __sync_val_compare_and_swap (&root->leaves[slot], old_leaf, new_leaf);
+  ASSERT (root->leaves[slot] == new_leaf);
+  root->dst_address_bits_of_leaves[slot] = IP4_MTRIE_ROOT_PLY_BITS;
+
+  if (!ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+    ply_free (m, get_next_ply_for_leaf (m, old_leaf));
+}
+
+void
+ip4_fib_mtrie_route_add_bulk (ip4_fib_mtrie_t * m,
+			      ip4_fib_mtrie_route_t * routes)
+{
+  ip4_fib_mtrie_set_unset_leaf_args_t a;
+  ip4_main_t *im = &ip4_main;
+  ip4_fib_mtrie_route_t *r;
+  u32 i, j, slot, n_routes;
+
+  /* Honor dst_address_length. Fib masks are in network byte order */
+  vec_foreach (r, routes)
+    r->dst_address.as_u32 &= im->fib_masks[r->dst_address_length];
+
+  vec_sort_with_function (routes, ip4_fib_mtrie_route_cmp);
+  n_routes = vec_len (routes);
+
+  /* Routes that end in the root ply, least specific first */
+  for (i = 0; i < n_routes; i++)
+    {
+      r = &routes[i];
+      if (r->dst_address_length > IP4_MTRIE_ROOT_PLY_BITS)
+	break;
+      a.dst_address = r->dst_address;
+      a.dst_address_length = r->dst_address_length;
+      a.adj_index = r->adj_index;
+      set_root_leaf (m, &a);
+    }
+
+  /* The rest, one sub-trie per root slot */
+  while (i < n_routes)
+    {
+      slot = ip4_fib_mtrie_root_slot (&routes[i].dst_address);
+      for (j = i + 1; j < n_routes; j++)
+	if (ip4_fib_mtrie_root_slot (&routes[j].dst_address) != slot)
+	  break;
+      set_root_slot_bulk (m, routes + i, j - i);
+      i = j;
+    }
+}
+
 void
 ip4_fib_mtrie_route_del (ip4_fib_mtrie_t * m,
 			 const ip4_address_t * dst_address,
@@ -689,12 +897,13 @@ mtrie_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_8_ply_t * p)
 uword
 ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
 {
+  ip4_fib_mtrie_root_ply_t *root = ip4_fib_mtrie_root_ply (m);
   uword bytes, i;
 
-  bytes = sizeof (*m);
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  bytes = sizeof (*root);
+  for (i = 0; i < ARRAY_LEN (root->leaves); i++)
     {
-      ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
+      ip4_fib_mtrie_leaf_t l = root->leaves[i];
       if (ip4_fib_mtrie_leaf_is_next_ply (l))
 	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
     }
@@ -768,30 +977,32 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
 {
   ip4_fib_mtrie_t *m = va_arg (*va, ip4_fib_mtrie_t *);
   int verbose = va_arg (*va, int);
-  ip4_fib_mtrie_16_ply_t *p;
+  ip4_fib_mtrie_root_ply_t *p;
   u32 base_address = 0;
   int i;
 
-  s = format (s, "%d plies, memory usage %U\n",
+  s = format (s, "%d plies, memory usage %U, %d-8%s stride\n",
 	      pool_elts (ip4_ply_pool),
-	      format_memory_size, ip4_fib_mtrie_memory_usage (m));
+	      format_memory_size, ip4_fib_mtrie_memory_usage (m),
+	      IP4_MTRIE_ROOT_PLY_BITS,
+	      IP4_MTRIE_ROOT_PLY_BITS == 16 ? "-8" : "");
   s = format (s, "root-ply");
-  p = &m->root_ply;
+  p = ip4_fib_mtrie_root_ply (m);
 
   if (verbose)
     {
       s = format (s, "root-ply");
-      p = &m->root_ply;
 
       for (i = 0; i < ARRAY_LEN (p->leaves); i++)
 	{
-	  u16 slot;
+	  u32 slot;
 
-	  slot = clib_host_to_net_u16 (i);
+	  slot = root_slot_from_host (i);
 
 	  if (p->dst_address_bits_of_leaves[slot] > 0)
 	    {
-	      s = FORMAT_PLY (s, p, slot, base_address, 16, 2);
+	      s = FORMAT_PLY (s, p, slot, base_address,
+			      IP4_MTRIE_ROOT_PLY_BITS, 2);
 	    }
 	}
     }
@@ -799,8 +1010,14 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   return s;
 }
 
-/** Default heap size for the IPv4 mtries */
+/** Default heap size for the IPv4 mtries. The 24 bit roots live there
+ * too, so leave room for a few tables */
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
 #define IP4_FIB_DEFAULT_MTRIE_HEAP_SIZE (32<<20)
+#else
+#define IP4_FIB_DEFAULT_MTRIE_HEAP_SIZE \
+  ((32<<20) + 4 * sizeof (ip4_fib_mtrie_root_ply_t))
+#endif
 
 static clib_error_t *
 ip4_mtrie_module_init (vlib_main_t * vm)
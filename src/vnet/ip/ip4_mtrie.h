@@ -45,7 +45,7 @@
 #include <vnet/ip/lookup.h>
 #include <vnet/ip/ip4_packet.h>	/* for ip4_address_t */
 
-/* ip4 fib leafs: 4 ply 8-8-8-8 mtrie.
+/* ip4 fib leafs: 16-8-8 or 24-8 mtrie.
    1 + 2*adj_index for terminal leaves.
    0 + 2*next_ply_index for non-terminals, i.e. PLYs
    1 => empty (adjacency index of zero is special miss adjacency). */
@@ -54,31 +54,48 @@ typedef u32 ip4_fib_mtrie_leaf_t;
 #define IP4_FIB_MTRIE_LEAF_EMPTY (1 + 2*0)
 
 /**
- * @brief the 16 way stride that is the top PLY of the mtrie
+ * @brief Stride of the root PLY, chosen at compile time.
+ * 16 gives the default 16-8-8 mtrie. 24 gives a 24-8 mtrie, where the
+ * root is a direct table that resolves all but the longer than /24
+ * prefixes with one memory access. It costs 80MB per table, so it is
+ * only worth it with few tables and large route counts.
+ */
+#ifndef IP4_MTRIE_ROOT_PLY_BITS
+#define IP4_MTRIE_ROOT_PLY_BITS 16
+#endif
+
+#if IP4_MTRIE_ROOT_PLY_BITS != 16 && IP4_MTRIE_ROOT_PLY_BITS != 24
+#error "IP4_MTRIE_ROOT_PLY_BITS must be 16 or 24"
+#endif
+
+#define IP4_MTRIE_ROOT_PLY_BYTES (IP4_MTRIE_ROOT_PLY_BITS / 8)
+#define PLY_ROOT_SIZE (1 << IP4_MTRIE_ROOT_PLY_BITS)
+
+/**
+ * @brief the 16 or 24 way stride that is the top PLY of the mtrie
  * We do not maintain the count of 'real' leaves in this PLY, since
  * it is never removed. The FIB will destroy the mtrie and the ply once
  * the FIB is destroyed.
  */
-#define PLY_16_SIZE (1<<16)
-typedef struct ip4_fib_mtrie_16_ply_t_
+typedef struct ip4_fib_mtrie_root_ply_t_
 {
   /**
    * The leaves/slots/buckets to be filed with leafs
    */
   union
   {
-    ip4_fib_mtrie_leaf_t leaves[PLY_16_SIZE];
+    ip4_fib_mtrie_leaf_t leaves[PLY_ROOT_SIZE];
 
 #ifdef CLIB_HAVE_VEC128
-    u32x4 leaves_as_u32x4[PLY_16_SIZE / 4];
+    u32x4 leaves_as_u32x4[PLY_ROOT_SIZE / 4];
 #endif
   };
 
   /**
    * Prefix length for terminal leaves.
    */
-  u8 dst_address_bits_of_leaves[PLY_16_SIZE];
-} ip4_fib_mtrie_16_ply_t;
+  u8 dst_address_bits_of_leaves[PLY_ROOT_SIZE];
+} ip4_fib_mtrie_root_ply_t;
 
 /**
  * @brief One ply of the 4 ply mtrie fib.
@@ -128,14 +145,32 @@ STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
  */
 typedef struct
 {
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
   /**
    * Embed the PLY with the mtrie struct. This means that the Data-plane
    * 'get me the mtrie' returns the first ply, and not an indirect 'pointer'
    * to it. therefore no cachline misses in the data-path.
    */
-  ip4_fib_mtrie_16_ply_t root_ply;
+  ip4_fib_mtrie_root_ply_t root_ply;
+#else
+  /**
+   * The 24 bit root is too big to embed in the FIB's pool. Its first
+   * access misses the cache anyway.
+   */
+  ip4_fib_mtrie_root_ply_t *root_ply;
+#endif
 } ip4_fib_mtrie_t;
 
+/**
+ * @brief A route for bulk insertion
+ */
+typedef struct ip4_fib_mtrie_route_t_
+{
+  ip4_address_t dst_address;
+  u32 dst_address_length;
+  u32 adj_index;
+} ip4_fib_mtrie_route_t;
+
 /**
  * @brief Initialise an mtrie
  */
@@ -152,6 +187,13 @@ void ip4_mtrie_free (ip4_fib_mtrie_t * m);
 void ip4_fib_mtrie_route_add (ip4_fib_mtrie_t * m,
 			      const ip4_address_t * dst_address,
 			      u32 dst_address_length, u32 adj_index);
+/**
+ * @brief Add many routes/entries to the mtrie
+ * Sorts the routes and builds new sub-tries off to the side, so each is
+ * swapped in with one write. The routes vector is reordered.
+ */
+void ip4_fib_mtrie_route_add_bulk (ip4_fib_mtrie_t * m,
+				   ip4_fib_mtrie_route_t * routes);
 /**
  * @brief remove a route/rntry to the mtrie
  */
@@ -176,6 +218,30 @@ format_function_t format_ip4_fib_mtrie;
  */
 extern ip4_fib_mtrie_8_ply_t *ip4_ply_pool;
 
+always_inline ip4_fib_mtrie_root_ply_t *
+ip4_fib_mtrie_root_ply (const ip4_fib_mtrie_t * m)
+{
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
+  return ((ip4_fib_mtrie_root_ply_t *) & m->root_ply);
+#else
+  return (m->root_ply);
+#endif
+}
+
+/**
+ * Slot of the root PLY for an address. The 16 bit root is indexed in
+ * network order, the 24 bit one in host order.
+ */
+always_inline u32
+ip4_fib_mtrie_root_slot (const ip4_address_t * dst_address)
+{
+#if IP4_MTRIE_ROOT_PLY_BITS == 16
+  return (dst_address->as_u16[0]);
+#else
+  return (clib_net_to_host_u32 (dst_address->as_u32) >> 8);
+#endif
+}
+
 /**
  * Is the leaf terminal (i.e. an LB index) or non-terminak (i.e. a PLY index)
  */
@@ -205,8 +271,14 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 			   u32 dst_address_byte_index)
 {
   ip4_fib_mtrie_8_ply_t *ply;
+  uword current_is_terminal;
+
+  /* Byte already consumed by the root PLY. Callers pass a constant, so
+   * this goes away at compile time */
+  if (dst_address_byte_index < IP4_MTRIE_ROOT_PLY_BYTES)
+    return current_leaf;
 
-  uword current_is_terminal = ip4_fib_mtrie_leaf_is_terminal (current_leaf);
+  current_is_terminal = ip4_fib_mtrie_leaf_is_terminal (current_leaf);
 
   if (!current_is_terminal)
     {
@@ -218,7 +290,8 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 }
 
 /**
- * @brief Lookup step number 1.  Processes 2 bytes of 4 byte ip4 address.
+ * @brief Lookup step number 1.  Processes the 2 or 3 bytes of the 4 byte
+ * ip4 address that index the root PLY.
  */
 always_inline ip4_fib_mtrie_leaf_t
 ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
@@ -226,7 +299,8 @@ ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_leaf_t next_leaf;
 
-  next_leaf = m->root_ply.leaves[dst_address->as_u16[0]];
+  next_leaf = ip4_fib_mtrie_root_ply (m)->leaves
+    [ip4_fib_mtrie_root_slot (dst_address)];
 
   return next_leaf;
 }
@@ -0,0 +1,374 @@
+/*
+ * ip4_mtrie_test.c : ip4 mtrie load and lookup benchmark
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Loads a synthetic table into a private mtrie, one route at a time and
+ * in bulk, and reports load time, memory and lookup rate for the stride
+ * layout vpp was built with. Lookups are checked against a reference
+ * longest prefix match, and removing all routes must free all plies.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip4_mtrie.h>
+
+/*
+ * Prefix length mix, roughly that of the public ip4 table: mostly /24s,
+ * a tail of /16 to /23s and a few more or less specific ones.
+ */
+static const u8 ip4_mtrie_test_len_weights[33] = {
+  [8] = 1,[12] = 1,[14] = 1,[15] = 1,
+  [16] = 4,[17] = 2,[18] = 3,[19] = 4,
+  [20] = 6,[21] = 6,[22] = 11,[23] = 9,
+  [24] = 58,[26] = 1,[28] = 1,[32] = 1,
+};
+
+typedef struct
+{
+  ip4_fib_mtrie_route_t *routes;
+  /* Reference tables, masked address to adj index, one per length */
+  uword *by_len[33];
+  ip4_address_t *addrs;
+  u32 n_routes;
+  u32 n_lookups;
+  u32 n_checks;
+  u32 seed;
+  u8 single;
+  u8 bulk;
+} ip4_mtrie_test_main_t;
+
+static u32
+ip4_mtrie_test_random_len (u32 * seed)
+{
+  u32 i, r, total = 0;
+
+  for (i = 0; i < ARRAY_LEN (ip4_mtrie_test_len_weights); i++)
+    total += ip4_mtrie_test_len_weights[i];
+
+  r = random_u32 (seed) % total;
+  for (i = 0; i < ARRAY_LEN (ip4_mtrie_test_len_weights); i++)
+    {
+      if (r < ip4_mtrie_test_len_weights[i])
+	return i;
+      r -= ip4_mtrie_test_len_weights[i];
+    }
+  return 24;
+}
+
+static void
+ip4_mtrie_test_gen (ip4_mtrie_test_main_t * tm)
+{
+  ip4_main_t *im = &ip4_main;
+  ip4_fib_mtrie_route_t *r;
+  u32 seed = tm->seed, len, a, i;
+
+  while (vec_len (tm->routes) < tm->n_routes)
+    {
+      len = ip4_mtrie_test_random_len (&seed);
+      /* unicast space, 1.0.0.0 - 223.255.255.255 */
+      a = (1 + random_u32 (&seed) % 223) << 24 | (random_u32 (&seed) >> 8);
+      a = clib_host_to_net_u32 (a) & im->fib_masks[len];
+      if (hash_get (tm->by_len[len], a))
+	continue;
+
+      vec_add2 (tm->routes, r, 1);
+      r->dst_address.as_u32 = a;
+      r->dst_address_length = len;
+      r->adj_index = vec_len (tm->routes);
+      hash_set (tm->by_len[len], a, r->adj_index);
+    }
+
+  /* lookups hit the routes' prefixes most of the time */
+  vec_validate (tm->addrs, (1 << 16) - 1);
+  for (i = 0; i < vec_len (tm->addrs); i++)
+    {
+      r = &tm->routes[random_u32 (&seed) % vec_len (tm->routes)];
+      a = clib_net_to_host_u32 (r->dst_address.as_u32);
+      if (r->dst_address_length < 32)
+	a |= random_u32 (&seed) & pow2_mask (32 - r->dst_address_length);
+      if (i % 8 == 0)
+	a = random_u32 (&seed);
+      tm->addrs[i].as_u32 = clib_host_to_net_u32 (a);
+    }
+}
+
+/* Longest prefix match in the reference tables, 0 if none */
+static u32
+ip4_mtrie_test_ref_lookup (ip4_mtrie_test_main_t * tm,
+			   const ip4_address_t * addr, u32 max_len,
+			   u32 * match_len)
+{
+  ip4_main_t *im = &ip4_main;
+  uword *p;
+  i32 len;
+
+  for (len = max_len; len >= 0; len--)
+    {
+      p = hash_get (tm->by_len[len], addr->as_u32 & im->fib_masks[len]);
+      if (p)
+	{
+	  *match_len = len;
+	  return p[0];
+	}
+    }
+  *match_len = 0;
+  return 0;
+}
+
+always_inline u32
+ip4_mtrie_test_lookup (ip4_fib_mtrie_t * m, const ip4_address_t * addr)
+{
+  ip4_fib_mtrie_leaf_t leaf;
+
+  leaf = ip4_fib_mtrie_lookup_step_one (m, addr);
+  leaf = ip4_fib_mtrie_lookup_step (m, leaf, addr, 2);
+  leaf = ip4_fib_mtrie_lookup_step (m, leaf, addr, 3);
+  return ip4_fib_mtrie_leaf_get_adj_index (leaf);
+}
+
+static clib_error_t *
+ip4_mtrie_test_check (ip4_mtrie_test_main_t * tm, ip4_fib_mtrie_t * m)
+{
+  u32 i, got, expected, len;
+  ip4_address_t *a;
+
+  for (i = 0; i < tm->n_checks; i++)
+    {
+      a = &tm->addrs[i % vec_len (tm->addrs)];
+      got = ip4_mtrie_test_lookup (m, a);
+      expected = ip4_mtrie_test_ref_lookup (tm, a, 32, &len);
+      if (got != expected)
+	return clib_error_return (0, "%U: mtrie adj %u expected %u",
+				  format_ip4_address, a, got, expected);
+    }
+  return 0;
+}
+
+static f64
+ip4_mtrie_test_lookup_rate (vlib_main_t * vm, ip4_mtrie_test_main_t * tm,
+			    ip4_fib_mtrie_t * m)
+{
+  u32 i, mask = vec_len (tm->addrs) - 1, sum = 0;
+  ip4_address_t *addrs = tm->addrs;
+  f64 t0, t1;
+
+  t0 = vlib_time_now (vm);
+  for (i = 0; i < tm->n_lookups; i += 4)
+    {
+      ip4_fib_mtrie_leaf_t l0, l1, l2, l3;
+      ip4_address_t *a0, *a1, *a2, *a3;
+
+      a0 = &addrs[i & mask];
+      a1 = &addrs[(i + 1) & mask];
+      a2 = &addrs[(i + 2) & mask];
+      a3 = &addrs[(i + 3) & mask];
+
+      /* as ip4_lookup_inline does */
+      l0 = ip4_fib_mtrie_lookup_step_one (m, a0);
+      l1 = ip4_fib_mtrie_lookup_step_one (m, a1);
+      l2 = ip4_fib_mtrie_lookup_step_one (m, a2);
+      l3 = ip4_fib_mtrie_lookup_step_one (m, a3);
+      l0 = ip4_fib_mtrie_lookup_step (m, l0, a0, 2);
+      l1 = ip4_fib_mtrie_lookup_step (m, l1, a1, 2);
+      l2 = ip4_fib_mtrie_lookup_step (m, l2, a2, 2);
+      l3 = ip4_fib_mtrie_lookup_step (m, l3, a3, 2);
+      l0 = ip4_fib_mtrie_lookup_step (m, l0, a0, 3);
+      l1 = ip4_fib_mtrie_lookup_step (m, l1, a1, 3);
+      l2 = ip4_fib_mtrie_lookup_step (m, l2, a2, 3);
+      l3 = ip4_fib_mtrie_lookup_step (m, l3, a3, 3);
+      sum += l0 + l1 + l2 + l3;
+    }
+  t1 = vlib_time_now (vm);
+
+  /* keep the compiler from dropping the lookups */
+  if (sum == 1)
+    clib_warning ("unlikely sum");
+
+  return tm->n_lookups / (t1 - t0) / 1e6;
+}
+
+static int
+ip4_mtrie_test_route_cmp_len_desc (void *a1, void *a2)
+{
+  ip4_fib_mtrie_route_t *r1 = a1, *r2 = a2;
+
+  return ((i32) r2->dst_address_length - (i32) r1->dst_address_length);
+}
+
+/*
+ * Remove all routes, most specific first, so the cover of each is the
+ * longest match among the routes still in the reference tables.
+ */
+static void
+ip4_mtrie_test_unload (ip4_mtrie_test_main_t * tm, ip4_fib_mtrie_t * m)
+{
+  ip4_fib_mtrie_route_t *r, *routes;
+  u32 cover_adj, cover_len;
+
+  routes = vec_dup (tm->routes);
+  vec_sort_with_function (routes, ip4_mtrie_test_route_cmp_len_desc);
+
+  vec_foreach (r, routes)
+  {
+    hash_unset (tm->by_len[r->dst_address_length], r->dst_address.as_u32);
+    cover_adj = ip4_mtrie_test_ref_lookup (tm, &r->dst_address,
+					   r->dst_address_length, &cover_len);
+    ip4_fib_mtrie_route_del (m, &r->dst_address, r->dst_address_length,
+			     r->adj_index, cover_len, cover_adj);
+  }
+
+  /* restore the reference tables for the next run */
+  vec_foreach (r, routes)
+    hash_set (tm->by_len[r->dst_address_length], r->dst_address.as_u32,
+	      r->adj_index);
+  vec_free (routes);
+}
+
+static clib_error_t *
+ip4_mtrie_test_run (vlib_main_t * vm, ip4_mtrie_test_main_t * tm,
+		    u8 is_bulk)
+{
+  ip4_fib_mtrie_route_t *r, *routes = 0;
+  clib_error_t *error = 0;
+  ip4_fib_mtrie_t *m;
+  u32 n_plies;
+  uword memory;
+  f64 t0, t1, mpps;
+
+  m = clib_mem_alloc_aligned (sizeof (*m), CLIB_CACHE_LINE_BYTES);
+  ip4_mtrie_init (m);
+  n_plies = pool_elts (ip4_ply_pool);
+
+  if (is_bulk)
+    {
+      /* add_bulk reorders its input, don't count the copy */
+      routes = vec_dup (tm->routes);
+      t0 = vlib_time_now (vm);
+      ip4_fib_mtrie_route_add_bulk (m, routes);
+      t1 = vlib_time_now (vm);
+    }
+  else
+    {
+      t0 = vlib_time_now (vm);
+      vec_foreach (r, tm->routes)
+	ip4_fib_mtrie_route_add (m, &r->dst_address, r->dst_address_length,
+				 r->adj_index);
+      t1 = vlib_time_now (vm);
+    }
+
+  memory = ip4_fib_mtrie_memory_usage (m);
+  if ((error = ip4_mtrie_test_check (tm, m)))
+    goto done;
+  mpps = ip4_mtrie_test_lookup_rate (vm, tm, m);
+
+  vlib_cli_output (vm, "%-6s %u routes in %.3f s (%.2e routes/s), "
+		   "%u plies, memory %U, lookup %.2f Mpps",
+		   is_bulk ? "bulk" : "single", vec_len (tm->routes),
+		   t1 - t0, vec_len (tm->routes) / (t1 - t0),
+		   pool_elts (ip4_ply_pool) - n_plies, format_memory_size,
+		   memory, mpps);
+
+  ip4_mtrie_test_unload (tm, m);
+  if (pool_elts (ip4_ply_pool) != n_plies)
+    error = clib_error_return (0, "%u plies leaked",
+			       pool_elts (ip4_ply_pool) - n_plies);
+
+done:
+  if (!error)
+    ip4_mtrie_free (m);
+  clib_mem_free (m);
+  vec_free (routes);
+  return error;
+}
+
+static clib_error_t *
+test_ip4_mtrie_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd_arg)
+{
+  ip4_mtrie_test_main_t _tm, *tm = &_tm;
+  clib_error_t *error = 0;
+  u32 i;
+
+  memset (tm, 0, sizeof (*tm));
+  tm->n_routes = 100000;
+  tm->n_lookups = 10 << 20;
+  tm->n_checks = 1 << 16;
+  tm->seed = 0xdeadbeef;
+  tm->single = tm->bulk = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "routes %u", &tm->n_routes))
+	;
+      else if (unformat (input, "lookups %u", &tm->n_lookups))
+	;
+      else if (unformat (input, "seed %u", &tm->seed))
+	;
+      else if (unformat (input, "single"))
+	tm->bulk = 0;
+      else if (unformat (input, "bulk"))
+	tm->single = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!tm->n_routes)
+    return clib_error_return (0, "need at least one route");
+
+  vlib_cli_output (vm, "%d-8%s stride, generating %u routes",
+		   IP4_MTRIE_ROOT_PLY_BITS,
+		   IP4_MTRIE_ROOT_PLY_BITS == 16 ? "-8" : "", tm->n_routes);
+  ip4_mtrie_test_gen (tm);
+
+  if (tm->single && (error = ip4_mtrie_test_run (vm, tm, 0 /* bulk */ )))
+    goto done;
+  if (tm->bulk)
+    error = ip4_mtrie_test_run (vm, tm, 1 /* bulk */ );
+
+done:
+  for (i = 0; i < ARRAY_LEN (tm->by_len); i++)
+    hash_free (tm->by_len[i]);
+  vec_free (tm->routes);
+  vec_free (tm->addrs);
+  return error;
+}
+
+/*?
+ * Benchmark the ip4 mtrie with a synthetic table. Reports load time, one
+ * route at a time and in bulk, memory used and lookup rate, for the
+ * stride layout selected at compile time with IP4_MTRIE_ROOT_PLY_BITS.
+ *
+ * @cliexpar
+ * @cliexcmd{test ip4 mtrie routes 900000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ip4_mtrie_command, static) =
+{
+  .path = "test ip4 mtrie",
+  .short_help = "test ip4 mtrie [routes <n>] [lookups <n>] [seed <n>] "
+    "[single|bulk]",
+  .function = test_ip4_mtrie_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
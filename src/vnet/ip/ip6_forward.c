@@ -1550,10 +1550,20 @@ typedef enum
  */
 #define IP6_MCAST_ADDR_MASK 0xffffffff
 
+/* GSO buffers are exempt only where they can still be segmented,
+   see ip4_mtu_check */
 always_inline void
 ip6_mtu_check (vlib_buffer_t * b, u16 packet_bytes,
-	       u16 adj_packet_bytes, u32 * next, u32 * error)
+	       u16 adj_packet_bytes, bool can_segment, u32 * next,
+	       u32 * error)
 {
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO))
+    {
+      if (can_segment)
+	return;
+      b->flags &= ~VNET_BUFFER_F_GSO;
+    }
+
   if (adj_packet_bytes >= 1280 && packet_bytes > adj_packet_bytes)
     {
       *error = IP6_ERROR_MTU_EXCEEDED;
@@ -1711,10 +1721,14 @@ ip6_rewrite_inline (vlib_main_t * vm,
 	  ip6_mtu_check (p0, clib_net_to_host_u16 (ip0->payload_length) +
 			 sizeof (ip6_header_t),
 			 adj0[0].rewrite_header.max_l3_packet_bytes,
+			 !is_midchain && !(adj0[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next0, &error0);
 	  ip6_mtu_check (p1, clib_net_to_host_u16 (ip1->payload_length) +
 			 sizeof (ip6_header_t),
 			 adj1[0].rewrite_header.max_l3_packet_bytes,
+			 !is_midchain && !(adj1[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next1, &error1);
 
 	  /* Don't adjust the buffer for hop count issue; icmp-error node
@@ -1852,6 +1866,8 @@ ip6_rewrite_inline (vlib_main_t * vm,
 	  ip6_mtu_check (p0, clib_net_to_host_u16 (ip0->payload_length) +
 			 sizeof (ip6_header_t),
 			 adj0[0].rewrite_header.max_l3_packet_bytes,
+			 !is_midchain && !(adj0[0].rewrite_header.flags &
+					   VNET_REWRITE_HAS_FEATURES),
 			 &next0, &error0);
 
 	  /* Don't adjust the buffer for hop count issue; icmp-error node
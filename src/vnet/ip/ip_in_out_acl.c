@@ -369,68 +369,48 @@ ip_in_out_acl_inline (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
+		  e0 = vnet_classify_find_entry_chain
+		    (vcm, &t0, b0->data, vlib_buffer_get_current (b0), now);
+		  if (e0)
 		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
+		      vnet_buffer (b0)->l2_classify.opaque_index
+			= e0->opaque_index;
+		      vlib_buffer_advance (b0, e0->advance);
+		      next0 = (e0->next_index < n_next_nodes) ?
+			e0->next_index : next0;
+		      hits++;
+		      chain_hits++;
+
+		      if (is_ip4)
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  (is_output ? IP4_ERROR_OUTACL_SESSION_DENY :
+			   IP4_ERROR_INACL_SESSION_DENY) : IP4_ERROR_NONE;
 		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-
-			  misses++;
-
-			  if (is_ip4)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      (is_output ? IP4_ERROR_OUTACL_TABLE_MISS :
-			       IP4_ERROR_INACL_TABLE_MISS) : IP4_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      (is_output ? IP6_ERROR_OUTACL_TABLE_MISS :
-			       IP6_ERROR_INACL_TABLE_MISS) : IP6_ERROR_NONE;
-			  b0->error = error_node->errors[error0];
-			  break;
-			}
-
-		      if (t0->current_data_flag ==
-			  CLASSIFY_FLAG_USE_CURR_DATA)
-			h0 =
-			  (void *) vlib_buffer_get_current (b0) +
-			  t0->current_data_offset;
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  (is_output ? IP6_ERROR_OUTACL_SESSION_DENY :
+			   IP6_ERROR_INACL_SESSION_DENY) : IP6_ERROR_NONE;
+		      b0->error = error_node->errors[error0];
+
+		      if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX
+			  || e0->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
+			vnet_buffer (b0)->sw_if_index[VLIB_TX] = e0->metadata;
+		    }
+		  else
+		    {
+		      next0 = (t0->miss_next_index < n_next_nodes) ?
+			t0->miss_next_index : next0;
+
+		      misses++;
+
+		      if (is_ip4)
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  (is_output ? IP4_ERROR_OUTACL_TABLE_MISS :
+			   IP4_ERROR_INACL_TABLE_MISS) : IP4_ERROR_NONE;
 		      else
-			h0 = b0->data;
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 = vnet_classify_find_entry
-			(t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-
-			  if (is_ip4)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      (is_output ? IP4_ERROR_OUTACL_SESSION_DENY :
-			       IP4_ERROR_INACL_SESSION_DENY) : IP4_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      (is_output ? IP6_ERROR_OUTACL_SESSION_DENY :
-			       IP6_ERROR_INACL_SESSION_DENY) : IP6_ERROR_NONE;
-			  b0->error = error_node->errors[error0];
-
-			  if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e0->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b0)->sw_if_index[VLIB_TX] =
-			      e0->metadata;
-			  break;
-			}
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  (is_output ? IP6_ERROR_OUTACL_TABLE_MISS :
+			   IP6_ERROR_INACL_TABLE_MISS) : IP6_ERROR_NONE;
+		      b0->error = error_node->errors[error0];
 		    }
 		}
 	    }
@@ -330,6 +330,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   fib_route_path_t *rpaths = NULL, rpath;
   fib_prefix_t *prefixs = NULL, pfx;
   clib_error_t *error = NULL;
+  u8 ip4_bulk = 0;
   f64 count;
   int i;
 
@@ -448,6 +449,13 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  incr = 1 << ((FIB_PROTOCOL_IP4 == prefixs[0].fp_proto ? 32 : 128) -
 		       prefixs[i].fp_len);
 
+	  /* Load many ip4 routes into the mtrie in one go */
+	  if (FIB_PROTOCOL_IP4 == prefixs[0].fp_proto && !is_del && n > 1)
+	    {
+	      ip4_fib_table_fwding_bulk_start (fib_index);
+	      ip4_bulk = 1;
+	    }
+
 	  for (k = 0; k < n; k++)
 	    {
 	      for (j = 0; j < vec_len (rpaths); j++)
@@ -503,6 +511,11 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 		}
 	    }
+	  if (ip4_bulk)
+	    {
+	      ip4_fib_table_fwding_bulk_end (fib_index);
+	      ip4_bulk = 0;
+	    }
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -516,6 +529,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 
 done:
+  if (ip4_bulk)
+    ip4_fib_table_fwding_bulk_end (fib_index);
   vec_free (dpos);
   vec_free (prefixs);
   vec_free (rpaths);
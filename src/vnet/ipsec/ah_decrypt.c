@@ -179,9 +179,7 @@ ah_decrypt_node_fn (vlib_main_t * vm,
 		  ih4->checksum = 0;
 		  ih4->flags_and_fragment_offset = 0;
 		}		//TODO else part for IPv6
-	      hmac_calc (sa0->integ_alg, sa0->integ_key, sa0->integ_key_len,
-			 (u8 *) ih4, i_b0->current_length, sig, sa0->use_esn,
-			 sa0->seq_hi);
+	      hmac_calc (vm, sa0, (u8 *) ih4, i_b0->current_length, sig);
 
 	      if (PREDICT_FALSE (memcmp (digest, sig, icv_size)))
 		{
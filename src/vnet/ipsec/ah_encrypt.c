@@ -269,10 +269,8 @@ ah_encrypt_node_fn (vlib_main_t * vm,
 	    memset (digest, 0, icv_size);
 	  }
 
-	  hmac_calc (sa0->integ_alg, sa0->integ_key,
-		     sa0->integ_key_len,
-		     (u8 *) vlib_buffer_get_current (i_b0),
-		     i_b0->current_length, sig, sa0->use_esn, sa0->seq_hi);
+	  hmac_calc (vm, sa0, (u8 *) vlib_buffer_get_current (i_b0),
+		     i_b0->current_length, sig);
 
 	  memcpy (digest, (char *) &sig[0], 12);
 
@@ -18,9 +18,9 @@
 #include <vnet/ip/ip.h>
 #include <vnet/ipsec/ipsec.h>
 
-#include <openssl/hmac.h>
+#include <vnet/crypto/crypto.h>
+
 #include <openssl/rand.h>
-#include <openssl/evp.h>
 
 typedef struct
 {
@@ -59,40 +59,46 @@ typedef CLIB_PACKED (struct {
 
 typedef struct
 {
-  const EVP_CIPHER *type;
+  vnet_crypto_op_id_t enc_op_id;
+  vnet_crypto_op_id_t dec_op_id;
+  vnet_crypto_alg_t alg;
   u8 iv_size;
   u8 block_size;
+  /* AEAD only, the cipher computes the ICV */
+  u8 icv_size;
 } ipsec_proto_main_crypto_alg_t;
 
 typedef struct
 {
-  const EVP_MD *md;
+  vnet_crypto_op_id_t op_id;
+  vnet_crypto_alg_t alg;
   u8 trunc_size;
 } ipsec_proto_main_integ_alg_t;
 
+/* RFC 4106 nonce and AAD, ops point here so it must outlive the batch */
+typedef struct
+{
+  /* *INDENT-OFF* */
+  CLIB_PACKED (struct {
+    u32 salt;
+    u64 iv;
+  }) nonce;
+  /* *INDENT-ON* */
+  u32 aad[3];
+  /* ICV received in the packet, replaced there by ESN seq_hi */
+  u8 icv[32];
+} esp_op_data_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *encrypt_ctx;
-#else
-  EVP_CIPHER_CTX encrypt_ctx;
-#endif
-    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *decrypt_ctx;
-#else
-  EVP_CIPHER_CTX decrypt_ctx;
-#endif
-    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  HMAC_CTX *hmac_ctx;
-#else
-  HMAC_CTX hmac_ctx;
-#endif
-  ipsec_crypto_alg_t last_encrypt_alg;
-  ipsec_crypto_alg_t last_decrypt_alg;
-  ipsec_integ_alg_t last_integ_alg;
+  /* operations collected over one frame, run once per node call */
+  vnet_crypto_op_t *crypto_ops;
+  vnet_crypto_op_t *integ_ops;
+  /* one per packet of the frame */
+  esp_op_data_t *op_data;
+  /* random CBC IVs for the frame */
+  u8 *ivs;
 } ipsec_proto_main_per_thread_data_t;
 
 typedef struct
@@ -258,111 +264,97 @@ ipsec_proto_init ()
 {
   ipsec_proto_main_t *em = &ipsec_proto_main;
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  ipsec_proto_main_crypto_alg_t *a;
+  ipsec_proto_main_integ_alg_t *i;
 
   memset (em, 0, sizeof (em[0]));
 
   vec_validate (em->ipsec_proto_main_crypto_algs, IPSEC_CRYPTO_N_ALG - 1);
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_128].type =
-    EVP_aes_128_cbc ();
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_192].type =
-    EVP_aes_192_cbc ();
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_256].type =
-    EVP_aes_256_cbc ();
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_128].iv_size = 16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_192].iv_size = 16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_256].iv_size = 16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_128].block_size =
-    16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_192].block_size =
-    16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_256].block_size =
-    16;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_DES_CBC].type =
-    EVP_des_cbc ();
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_3DES_CBC].type =
-    EVP_des_ede3_cbc ();
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_DES_CBC].block_size = 8;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_3DES_CBC].block_size = 8;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_DES_CBC].iv_size = 8;
-  em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_3DES_CBC].iv_size = 8;
-
-  vec_validate (em->ipsec_proto_main_integ_algs, IPSEC_INTEG_N_ALG - 1);
-  ipsec_proto_main_integ_alg_t *i;
-
-  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_SHA1_96];
-  i->md = EVP_sha1 ();
-  i->trunc_size = 12;
 
-  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_SHA_256_96];
-  i->md = EVP_sha256 ();
-  i->trunc_size = 12;
+#define _(ipsec, vnet, iv, block, icv) \
+  a = &em->ipsec_proto_main_crypto_algs[IPSEC_CRYPTO_ALG_##ipsec]; \
+  a->enc_op_id = VNET_CRYPTO_OP_##vnet##_ENC; \
+  a->dec_op_id = VNET_CRYPTO_OP_##vnet##_DEC; \
+  a->alg = VNET_CRYPTO_ALG_##vnet; \
+  a->iv_size = iv; \
+  a->block_size = block; \
+  a->icv_size = icv;
+
+  _(AES_CBC_128, AES_128_CBC, 16, 16, 0);
+  _(AES_CBC_192, AES_192_CBC, 16, 16, 0);
+  _(AES_CBC_256, AES_256_CBC, 16, 16, 0);
+  _(AES_GCM_128, AES_128_GCM, 8, 4, 16);
+  _(AES_GCM_192, AES_192_GCM, 8, 4, 16);
+  _(AES_GCM_256, AES_256_GCM, 8, 4, 16);
+  _(DES_CBC, DES_CBC, 8, 8, 0);
+  _(3DES_CBC, 3DES_CBC, 8, 8, 0);
+#undef _
 
-  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_SHA_256_128];
-  i->md = EVP_sha256 ();
-  i->trunc_size = 16;
+  vec_validate (em->ipsec_proto_main_integ_algs, IPSEC_INTEG_N_ALG - 1);
 
-  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_SHA_384_192];
-  i->md = EVP_sha384 ();
-  i->trunc_size = 24;
+#define _(ipsec, vnet, trunc) \
+  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_##ipsec]; \
+  i->op_id = VNET_CRYPTO_OP_##vnet##_HMAC; \
+  i->alg = VNET_CRYPTO_ALG_HMAC_##vnet; \
+  i->trunc_size = trunc;
 
-  i = &em->ipsec_proto_main_integ_algs[IPSEC_INTEG_ALG_SHA_512_256];
-  i->md = EVP_sha512 ();
-  i->trunc_size = 32;
+  _(SHA1_96, SHA1, 12);
+  _(SHA_256_96, SHA256, 12);
+  _(SHA_256_128, SHA256, 16);
+  _(SHA_384_192, SHA384, 24);
+  _(SHA_512_256, SHA512, 32);
+#undef _
 
   vec_validate_aligned (em->per_thread_data, tm->n_vlib_mains - 1,
 			CLIB_CACHE_LINE_BYTES);
-  int thread_id;
+}
 
-  for (thread_id = 0; thread_id < tm->n_vlib_mains; thread_id++)
-    {
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-      em->per_thread_data[thread_id].encrypt_ctx = EVP_CIPHER_CTX_new ();
-      em->per_thread_data[thread_id].decrypt_ctx = EVP_CIPHER_CTX_new ();
-      em->per_thread_data[thread_id].hmac_ctx = HMAC_CTX_new ();
-#else
-      EVP_CIPHER_CTX_init (&(em->per_thread_data[thread_id].encrypt_ctx));
-      EVP_CIPHER_CTX_init (&(em->per_thread_data[thread_id].decrypt_ctx));
-      HMAC_CTX_init (&(em->per_thread_data[thread_id].hmac_ctx));
-#endif
-    }
+always_inline int
+ipsec_proto_is_aead (ipsec_crypto_alg_t alg)
+{
+  return ipsec_proto_main.ipsec_proto_main_crypto_algs[alg].icv_size != 0;
 }
 
+/*
+ * Single HMAC for the AH nodes. With ESN the high sequence bits are
+ * hashed after the data, they are written into the buffer tailroom for
+ * the duration of the call.
+ */
 always_inline unsigned int
-hmac_calc (ipsec_integ_alg_t alg,
-	   u8 * key,
-	   int key_len,
-	   u8 * data, int data_len, u8 * signature, u8 use_esn, u32 seq_hi)
+hmac_calc (vlib_main_t * vm, ipsec_sa_t * sa, u8 * data, int data_len,
+	   u8 * signature)
 {
   ipsec_proto_main_t *em = &ipsec_proto_main;
-  u32 thread_index = vlib_get_thread_index ();
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  HMAC_CTX *ctx = em->per_thread_data[thread_index].hmac_ctx;
-#else
-  HMAC_CTX *ctx = &(em->per_thread_data[thread_index].hmac_ctx);
-#endif
-  const EVP_MD *md = NULL;
-  unsigned int len;
-
-  ASSERT (alg < IPSEC_INTEG_N_ALG);
-
-  if (PREDICT_FALSE (em->ipsec_proto_main_integ_algs[alg].md == 0))
+  ipsec_proto_main_integ_alg_t *a;
+  vnet_crypto_op_t op;
+  u32 saved = 0;
+
+  ASSERT (sa->integ_alg < IPSEC_INTEG_N_ALG);
+  a = &em->ipsec_proto_main_integ_algs[sa->integ_alg];
+
+  if (PREDICT_FALSE (a->op_id == VNET_CRYPTO_OP_NONE))
     return 0;
 
-  if (PREDICT_FALSE (alg != em->per_thread_data[thread_index].last_integ_alg))
+  vnet_crypto_op_init (&op, a->op_id);
+  op.key_index = sa->integ_key_index;
+  op.src = data;
+  op.len = data_len;
+  op.digest = signature;
+  op.digest_len = a->trunc_size;
+
+  if (PREDICT_TRUE (sa->use_esn))
     {
-      md = em->ipsec_proto_main_integ_algs[alg].md;
-      em->per_thread_data[thread_index].last_integ_alg = alg;
+      clib_memcpy (&saved, data + data_len, sizeof (saved));
+      clib_memcpy (data + data_len, &sa->seq_hi, sizeof (sa->seq_hi));
+      op.len += sizeof (sa->seq_hi);
     }
 
-  HMAC_Init_ex (ctx, key, key_len, md, NULL);
+  vnet_crypto_process_ops (vm, &op, 1);
 
-  HMAC_Update (ctx, data, data_len);
-
-  if (PREDICT_TRUE (use_esn))
-    HMAC_Update (ctx, (u8 *) & seq_hi, sizeof (seq_hi));
-  HMAC_Final (ctx, signature, &len);
+  if (PREDICT_TRUE (sa->use_esn))
+    clib_memcpy (data + data_len, &saved, sizeof (saved));
 
-  return em->ipsec_proto_main_integ_algs[alg].trunc_size;
+  return a->trunc_size;
 }
 
 #endif /* __ESP_H__ */
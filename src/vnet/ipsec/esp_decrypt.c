@@ -80,38 +80,32 @@ format_esp_decrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
-always_inline void
-esp_decrypt_cbc (ipsec_crypto_alg_t alg,
-		 u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
+typedef struct
 {
-  ipsec_proto_main_t *em = &ipsec_proto_main;
-  u32 thread_index = vlib_get_thread_index ();
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].decrypt_ctx;
-#else
-  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].decrypt_ctx);
-#endif
-  const EVP_CIPHER *cipher = NULL;
-  int out_len;
-
-  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
-
-  if (PREDICT_FALSE (em->ipsec_proto_main_crypto_algs[alg].type == 0))
-    return;
-
-  if (PREDICT_FALSE
-      (alg != em->per_thread_data[thread_index].last_decrypt_alg))
-    {
-      cipher = em->ipsec_proto_main_crypto_algs[alg].type;
-      em->per_thread_data[thread_index].last_decrypt_alg = alg;
-    }
-
-  EVP_DecryptInit_ex (ctx, cipher, NULL, key, iv);
-
-  EVP_DecryptUpdate (ctx, out, &out_len, in, in_len);
-  EVP_DecryptFinal_ex (ctx, out + out_len, &out_len);
-}
+  u32 seq;
+  u32 seq_hi;
+  /* output buffer, ~0 until one is taken */
+  u32 o_bi;
+  /* decrypted payload length */
+  u32 len;
+  /* outer header, transport mode only */
+  void *ih;
+  /* ESP_DECRYPT_N_ERROR when fine */
+  u8 error;
+  u8 ip_hdr_size;
+  u8 tunnel_mode;
+  u8 transport_ip6;
+  u8 decrypted;
+} esp_decrypt_packet_t;
 
+/*
+ * Packets are handled in three passes so every integrity check and every
+ * cipher of the frame run as one batch each: anti-replay pre-check and
+ * HMAC ops, then cipher ops for the packets that passed, then headers and
+ * enqueue. The replay window moves only in the last pass, after the
+ * packet was authenticated; it is checked again there to catch duplicates
+ * within the frame.
+ */
 static uword
 esp_decrypt_node_fn (vlib_main_t * vm,
 		     vlib_node_runtime_t * node, vlib_frame_t * from_frame)
@@ -123,6 +117,11 @@ esp_decrypt_node_fn (vlib_main_t * vm,
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
   u32 thread_index = vlib_get_thread_index ();
+  ipsec_proto_main_per_thread_data_t *ptd =
+    vec_elt_at_index (em->per_thread_data, thread_index);
+  esp_decrypt_packet_t packets[VLIB_FRAME_SIZE], *p0;
+  vnet_crypto_op_t *op0;
+  u32 i, n_ops;
 
   ipsec_alloc_empty_buffers (vm, im);
 
@@ -135,256 +134,355 @@ esp_decrypt_node_fn (vlib_main_t * vm,
       goto free_buffers_and_exit;
     }
 
+  vec_reset_length (ptd->crypto_ops);
+  vec_reset_length (ptd->integ_ops);
+  vec_validate (ptd->op_data, n_left_from - 1);
+
+  /* anti-replay pre-check and integrity ops */
+  for (i = 0; i < n_left_from; i++)
+    {
+      vlib_buffer_t *i_b0 = vlib_get_buffer (vm, from[i]);
+      esp_header_t *esp0 = vlib_buffer_get_current (i_b0);
+      ipsec_sa_t *sa0 = pool_elt_at_index (im->sad,
+					   vnet_buffer (i_b0)->ipsec.sad_index);
+
+      if (i + 1 < n_left_from)
+	vlib_prefetch_buffer_with_index (vm, from[i + 1], LOAD);
+
+      p0 = packets + i;
+      p0->seq = clib_host_to_net_u32 (esp0->seq);
+      p0->o_bi = ~0;
+      p0->error = ESP_DECRYPT_N_ERROR;
+      p0->decrypted = 0;
+
+      if (sa0->use_anti_replay)
+	{
+	  int rv = 0;
+
+	  if (PREDICT_TRUE (sa0->use_esn))
+	    rv = esp_replay_check_esn (sa0, p0->seq);
+	  else
+	    rv = esp_replay_check (sa0, p0->seq);
+
+	  if (PREDICT_FALSE (rv))
+	    {
+	      clib_warning ("anti-replay SPI %u seq %u", sa0->spi, p0->seq);
+	      p0->error = ESP_DECRYPT_ERROR_REPLAY;
+	      continue;
+	    }
+	}
+
+      p0->seq_hi = sa0->seq_hi;
+      sa0->total_data_size += i_b0->current_length;
+
+      if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
+	{
+	  ipsec_proto_main_integ_alg_t *ia0 =
+	    &em->ipsec_proto_main_integ_algs[sa0->integ_alg];
+	  u8 *icv = vlib_buffer_get_current (i_b0) + i_b0->current_length -
+	    ia0->trunc_size;
+
+	  i_b0->current_length -= ia0->trunc_size;
+
+	  vec_add2_aligned (ptd->integ_ops, op0, 1, CLIB_CACHE_LINE_BYTES);
+	  vnet_crypto_op_init (op0, ia0->op_id);
+	  op0->key_index = sa0->integ_key_index;
+	  op0->flags = VNET_CRYPTO_OP_FLAG_HMAC_CHECK;
+	  op0->src = (u8 *) esp0;
+	  op0->len = i_b0->current_length;
+	  op0->digest = icv;
+	  op0->digest_len = ia0->trunc_size;
+	  op0->user_data = i;
+
+	  /* ESN high bits are hashed from where the ICV was */
+	  if (sa0->use_esn)
+	    {
+	      esp_op_data_t *d0 = vec_elt_at_index (ptd->op_data, i);
+	      clib_memcpy (d0->icv, icv, ia0->trunc_size);
+	      clib_memcpy (icv, &p0->seq_hi, sizeof (p0->seq_hi));
+	      op0->digest = d0->icv;
+	      op0->len += sizeof (p0->seq_hi);
+	    }
+	}
+    }
+
+  n_ops = vec_len (ptd->integ_ops);
+  if (n_ops != vnet_crypto_process_ops (vm, ptd->integ_ops, n_ops))
+    {
+      /* *INDENT-OFF* */
+      vec_foreach (op0, ptd->integ_ops)
+	if (op0->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	  packets[op0->user_data].error = ESP_DECRYPT_ERROR_INTEG_ERROR;
+      /* *INDENT-ON* */
+    }
+
+  /* output buffers and cipher ops for authenticated packets */
+  for (i = 0; i < n_left_from; i++)
+    {
+      vlib_buffer_t *i_b0, *o_b0;
+      ipsec_proto_main_crypto_alg_t *ca0;
+      esp_header_t *esp0;
+      ipsec_sa_t *sa0;
+      ip4_header_t *ih4;
+
+      p0 = packets + i;
+      if (p0->error != ESP_DECRYPT_N_ERROR)
+	continue;
+
+      i_b0 = vlib_get_buffer (vm, from[i]);
+      esp0 = vlib_buffer_get_current (i_b0);
+      sa0 = pool_elt_at_index (im->sad, vnet_buffer (i_b0)->ipsec.sad_index);
+      ca0 = &em->ipsec_proto_main_crypto_algs[sa0->crypto_alg];
+
+      /* grab free buffer */
+      uword last_empty_buffer = vec_len (empty_buffers) - 1;
+      p0->o_bi = empty_buffers[last_empty_buffer];
+      o_b0 = vlib_get_buffer (vm, p0->o_bi);
+      vlib_prefetch_buffer_with_index (vm,
+				       empty_buffers[last_empty_buffer - 1],
+				       STORE);
+      _vec_len (empty_buffers) = last_empty_buffer;
+
+      /* add old buffer to the recycle list */
+      vec_add1 (recycle, from[i]);
+
+      if (PREDICT_FALSE (ca0->alg == VNET_CRYPTO_ALG_NONE))
+	continue;
+
+      o_b0->current_data = sizeof (ethernet_header_t);
+      p0->tunnel_mode = 1;
+      p0->transport_ip6 = 0;
+      p0->ip_hdr_size = 0;
+
+      /* transport mode */
+      if (PREDICT_FALSE (!sa0->is_tunnel && !sa0->is_tunnel_ip6))
+	{
+	  p0->tunnel_mode = 0;
+
+	  if (i_b0->flags & VNET_BUFFER_F_IS_IP4)
+	    ih4 = (ip4_header_t *) ((u8 *) esp0 - sizeof (ip4_header_t));
+	  else
+	    ih4 = (ip4_header_t *) ((u8 *) esp0 - sizeof (ip6_header_t));
+	  p0->ih = ih4;
+
+	  if (PREDICT_TRUE
+	      ((ih4->ip_version_and_header_length & 0xF0) != 0x40))
+	    {
+	      if (PREDICT_TRUE
+		  ((ih4->ip_version_and_header_length & 0xF0) == 0x60))
+		{
+		  p0->transport_ip6 = 1;
+		  p0->ip_hdr_size = sizeof (ip6_header_t);
+		}
+	      else
+		{
+		  p0->error = ESP_DECRYPT_ERROR_NOT_IP;
+		  continue;
+		}
+	    }
+	  else
+	    p0->ip_hdr_size = sizeof (ip4_header_t);
+	}
+
+      vec_add2_aligned (ptd->crypto_ops, op0, 1, CLIB_CACHE_LINE_BYTES);
+      vnet_crypto_op_init (op0, ca0->dec_op_id);
+      op0->key_index = sa0->crypto_key_index;
+      op0->src = esp0->data + ca0->iv_size;
+      op0->dst = (u8 *) vlib_buffer_get_current (o_b0) + p0->ip_hdr_size;
+      op0->user_data = i;
+
+      if (ca0->icv_size)
+	{
+	  esp_op_data_t *d0 = vec_elt_at_index (ptd->op_data, i);
+
+	  i_b0->current_length -= ca0->icv_size;
+	  op0->len = i_b0->current_length - sizeof (esp_header_t) -
+	    ca0->iv_size;
+	  d0->nonce.salt = sa0->salt;
+	  clib_memcpy (&d0->nonce.iv, esp0->data, sizeof (d0->nonce.iv));
+	  d0->aad[0] = esp0->spi;
+	  if (sa0->use_esn)
+	    {
+	      d0->aad[1] = clib_host_to_net_u32 (p0->seq_hi);
+	      d0->aad[2] = esp0->seq;
+	      op0->aad_len = 12;
+	    }
+	  else
+	    {
+	      d0->aad[1] = esp0->seq;
+	      op0->aad_len = 8;
+	    }
+	  op0->iv = (u8 *) & d0->nonce;
+	  op0->aad = (u8 *) d0->aad;
+	  op0->tag = op0->src + op0->len;
+	  op0->tag_len = ca0->icv_size;
+	}
+      else
+	{
+	  int blocks = (i_b0->current_length - sizeof (esp_header_t) -
+			ca0->iv_size) / ca0->block_size;
+	  op0->len = blocks * ca0->block_size;
+	  op0->iv = esp0->data;
+	}
+
+      p0->len = op0->len;
+      p0->decrypted = 1;
+    }
+
+  n_ops = vec_len (ptd->crypto_ops);
+  if (n_ops != vnet_crypto_process_ops (vm, ptd->crypto_ops, n_ops))
+    {
+      /* *INDENT-OFF* */
+      vec_foreach (op0, ptd->crypto_ops)
+	if (op0->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	  packets[op0->user_data].error =
+	    op0->status == VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC ?
+	    ESP_DECRYPT_ERROR_INTEG_ERROR : ESP_DECRYPT_ERROR_DECRYPTION_FAILED;
+      /* *INDENT-ON* */
+    }
+
   next_index = node->cached_next_index;
+  i = 0;
 
-  while (n_left_from > 0)
+  while (i < n_left_from)
     {
       u32 n_left_to_next;
 
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
 
-      while (n_left_from > 0 && n_left_to_next > 0)
+      while (i < n_left_from && n_left_to_next > 0)
 	{
-	  u32 i_bi0, o_bi0 = (u32) ~ 0, next0;
+	  u32 i_bi0, o_bi0, next0;
 	  vlib_buffer_t *i_b0;
 	  vlib_buffer_t *o_b0 = 0;
-	  esp_header_t *esp0;
 	  ipsec_sa_t *sa0;
-	  u32 sa_index0 = ~0;
-	  u32 seq;
+	  esp_footer_t *f0;
 	  ip4_header_t *ih4 = 0, *oh4 = 0;
 	  ip6_header_t *ih6 = 0, *oh6 = 0;
-	  u8 tunnel_mode = 1;
-	  u8 transport_ip6 = 0;
 
-
-	  i_bi0 = from[0];
-	  from += 1;
-	  n_left_from -= 1;
+	  p0 = packets + i;
+	  i_bi0 = from[i];
+	  i += 1;
 	  n_left_to_next -= 1;
 
 	  next0 = ESP_DECRYPT_NEXT_DROP;
 
 	  i_b0 = vlib_get_buffer (vm, i_bi0);
-	  esp0 = vlib_buffer_get_current (i_b0);
-
-	  sa_index0 = vnet_buffer (i_b0)->ipsec.sad_index;
-	  sa0 = pool_elt_at_index (im->sad, sa_index0);
+	  sa0 = pool_elt_at_index (im->sad,
+				   vnet_buffer (i_b0)->ipsec.sad_index);
 
-	  seq = clib_host_to_net_u32 (esp0->seq);
+	  o_bi0 = i_bi0;
+	  if (p0->o_bi != ~0)
+	    {
+	      o_bi0 = p0->o_bi;
+	      o_b0 = vlib_get_buffer (vm, o_bi0);
+	    }
+	  to_next[0] = o_bi0;
+	  to_next += 1;
 
-	  /* anti-replay check */
-	  if (sa0->use_anti_replay)
+	  if (PREDICT_TRUE (p0->error == ESP_DECRYPT_N_ERROR &&
+			    sa0->use_anti_replay))
 	    {
-	      int rv = 0;
+	      int rv;
 
+	      /* an earlier packet of this frame may have had this seq */
 	      if (PREDICT_TRUE (sa0->use_esn))
-		rv = esp_replay_check_esn (sa0, seq);
+		rv = esp_replay_check_esn (sa0, p0->seq);
 	      else
-		rv = esp_replay_check (sa0, seq);
+		rv = esp_replay_check (sa0, p0->seq);
 
 	      if (PREDICT_FALSE (rv))
-		{
-		  clib_warning ("anti-replay SPI %u seq %u", sa0->spi, seq);
-		  vlib_node_increment_counter (vm, esp_decrypt_node.index,
-					       ESP_DECRYPT_ERROR_REPLAY, 1);
-		  o_bi0 = i_bi0;
-		  to_next[0] = o_bi0;
-		  to_next += 1;
-		  goto trace;
-		}
+		p0->error = ESP_DECRYPT_ERROR_REPLAY;
+	      else if (PREDICT_TRUE (sa0->use_esn))
+		esp_replay_advance_esn (sa0, p0->seq);
+	      else
+		esp_replay_advance (sa0, p0->seq);
+	    }
+
+	  if (PREDICT_FALSE (p0->error != ESP_DECRYPT_N_ERROR))
+	    {
+	      vlib_node_increment_counter (vm, esp_decrypt_node.index,
+					   p0->error, 1);
+	      o_b0 = 0;
+	      goto trace;
 	    }
 
-	  sa0->total_data_size += i_b0->current_length;
+	  if (PREDICT_FALSE (!p0->decrypted))
+	    goto trace;
+
+	  o_b0->current_length = p0->len - 2 + p0->ip_hdr_size;
+	  o_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+	  f0 =
+	    (esp_footer_t *) ((u8 *) vlib_buffer_get_current (o_b0) +
+			      o_b0->current_length);
+	  o_b0->current_length -= f0->pad_length;
 
-	  if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
+	  /* tunnel mode */
+	  if (PREDICT_TRUE (p0->tunnel_mode))
 	    {
-	      u8 sig[64];
-	      int icv_size =
-		em->ipsec_proto_main_integ_algs[sa0->integ_alg].trunc_size;
-	      memset (sig, 0, sizeof (sig));
-	      u8 *icv =
-		vlib_buffer_get_current (i_b0) + i_b0->current_length -
-		icv_size;
-	      i_b0->current_length -= icv_size;
-
-	      hmac_calc (sa0->integ_alg, sa0->integ_key, sa0->integ_key_len,
-			 (u8 *) esp0, i_b0->current_length, sig, sa0->use_esn,
-			 sa0->seq_hi);
-
-	      if (PREDICT_FALSE (memcmp (icv, sig, icv_size)))
+	      if (PREDICT_TRUE (f0->next_header == IP_PROTOCOL_IP_IN_IP))
+		next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
+	      else if (f0->next_header == IP_PROTOCOL_IPV6)
+		next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
+	      else
 		{
+		  clib_warning ("next header: 0x%x", f0->next_header);
 		  vlib_node_increment_counter (vm, esp_decrypt_node.index,
-					       ESP_DECRYPT_ERROR_INTEG_ERROR,
+					       ESP_DECRYPT_ERROR_DECRYPTION_FAILED,
 					       1);
-		  o_bi0 = i_bi0;
-		  to_next[0] = o_bi0;
-		  to_next += 1;
+		  o_b0 = 0;
 		  goto trace;
 		}
 	    }
-
-	  if (PREDICT_TRUE (sa0->use_anti_replay))
+	  /* transport mode */
+	  else
 	    {
-	      if (PREDICT_TRUE (sa0->use_esn))
-		esp_replay_advance_esn (sa0, seq);
-	      else
-		esp_replay_advance (sa0, seq);
-	    }
-
-	  /* grab free buffer */
-	  uword last_empty_buffer = vec_len (empty_buffers) - 1;
-	  o_bi0 = empty_buffers[last_empty_buffer];
-	  to_next[0] = o_bi0;
-	  to_next += 1;
-	  o_b0 = vlib_get_buffer (vm, o_bi0);
-	  vlib_prefetch_buffer_with_index (vm,
-					   empty_buffers[last_empty_buffer -
-							 1], STORE);
-	  _vec_len (empty_buffers) = last_empty_buffer;
-
-	  /* add old buffer to the recycle list */
-	  vec_add1 (recycle, i_bi0);
-
-	  if ((sa0->crypto_alg >= IPSEC_CRYPTO_ALG_AES_CBC_128 &&
-	       sa0->crypto_alg <= IPSEC_CRYPTO_ALG_AES_CBC_256) ||
-	      (sa0->crypto_alg >= IPSEC_CRYPTO_ALG_DES_CBC &&
-	       sa0->crypto_alg <= IPSEC_CRYPTO_ALG_3DES_CBC))
-	    {
-	      const int BLOCK_SIZE =
-		em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].block_size;;
-	      const int IV_SIZE =
-		em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].iv_size;
-	      esp_footer_t *f0;
-	      u8 ip_hdr_size = 0;
-
-	      int blocks =
-		(i_b0->current_length - sizeof (esp_header_t) -
-		 IV_SIZE) / BLOCK_SIZE;
-
-	      o_b0->current_data = sizeof (ethernet_header_t);
-
-	      /* transport mode */
-	      if (PREDICT_FALSE (!sa0->is_tunnel && !sa0->is_tunnel_ip6))
+	      if (PREDICT_FALSE (p0->transport_ip6))
 		{
-		  tunnel_mode = 0;
-
-		  if (i_b0->flags & VNET_BUFFER_F_IS_IP4)
-		    ih4 =
-		      (ip4_header_t *) ((u8 *) esp0 - sizeof (ip4_header_t));
-		  else
-		    ih4 =
-		      (ip4_header_t *) ((u8 *) esp0 - sizeof (ip6_header_t));
-
-		  if (PREDICT_TRUE
-		      ((ih4->ip_version_and_header_length & 0xF0) != 0x40))
-		    {
-		      if (PREDICT_TRUE
-			  ((ih4->ip_version_and_header_length & 0xF0) ==
-			   0x60))
-			{
-			  transport_ip6 = 1;
-			  ip_hdr_size = sizeof (ip6_header_t);
-			  ih6 = (ip6_header_t *) ih4;
-			  oh6 = vlib_buffer_get_current (o_b0);
-			}
-		      else
-			{
-			  vlib_node_increment_counter (vm,
-						       esp_decrypt_node.index,
-						       ESP_DECRYPT_ERROR_NOT_IP,
-						       1);
-			  o_b0 = 0;
-			  goto trace;
-			}
-		    }
-		  else
-		    {
-		      oh4 = vlib_buffer_get_current (o_b0);
-		      ip_hdr_size = sizeof (ip4_header_t);
-		    }
+		  ih6 = p0->ih;
+		  oh6 = vlib_buffer_get_current (o_b0);
+		  next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
+		  oh6->ip_version_traffic_class_and_flow_label =
+		    ih6->ip_version_traffic_class_and_flow_label;
+		  oh6->protocol = f0->next_header;
+		  oh6->hop_limit = ih6->hop_limit;
+		  oh6->src_address.as_u64[0] = ih6->src_address.as_u64[0];
+		  oh6->src_address.as_u64[1] = ih6->src_address.as_u64[1];
+		  oh6->dst_address.as_u64[0] = ih6->dst_address.as_u64[0];
+		  oh6->dst_address.as_u64[1] = ih6->dst_address.as_u64[1];
+		  oh6->payload_length =
+		    clib_host_to_net_u16 (vlib_buffer_length_in_chain
+					  (vm, o_b0) - sizeof (ip6_header_t));
 		}
-
-	      esp_decrypt_cbc (sa0->crypto_alg,
-			       esp0->data + IV_SIZE,
-			       (u8 *) vlib_buffer_get_current (o_b0) +
-			       ip_hdr_size, BLOCK_SIZE * blocks,
-			       sa0->crypto_key, esp0->data);
-
-	      o_b0->current_length = (blocks * BLOCK_SIZE) - 2 + ip_hdr_size;
-	      o_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
-	      f0 =
-		(esp_footer_t *) ((u8 *) vlib_buffer_get_current (o_b0) +
-				  o_b0->current_length);
-	      o_b0->current_length -= f0->pad_length;
-
-	      /* tunnel mode */
-	      if (PREDICT_TRUE (tunnel_mode))
-		{
-		  if (PREDICT_TRUE (f0->next_header == IP_PROTOCOL_IP_IN_IP))
-		    {
-		      next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
-		      oh4 = vlib_buffer_get_current (o_b0);
-		    }
-		  else if (f0->next_header == IP_PROTOCOL_IPV6)
-		    next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
-		  else
-		    {
-		      clib_warning ("next header: 0x%x", f0->next_header);
-		      vlib_node_increment_counter (vm, esp_decrypt_node.index,
-						   ESP_DECRYPT_ERROR_DECRYPTION_FAILED,
-						   1);
-		      o_b0 = 0;
-		      goto trace;
-		    }
-		}
-	      /* transport mode */
 	      else
 		{
-		  if (PREDICT_FALSE (transport_ip6))
-		    {
-		      next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
-		      oh6->ip_version_traffic_class_and_flow_label =
-			ih6->ip_version_traffic_class_and_flow_label;
-		      oh6->protocol = f0->next_header;
-		      oh6->hop_limit = ih6->hop_limit;
-		      oh6->src_address.as_u64[0] = ih6->src_address.as_u64[0];
-		      oh6->src_address.as_u64[1] = ih6->src_address.as_u64[1];
-		      oh6->dst_address.as_u64[0] = ih6->dst_address.as_u64[0];
-		      oh6->dst_address.as_u64[1] = ih6->dst_address.as_u64[1];
-		      oh6->payload_length =
-			clib_host_to_net_u16 (vlib_buffer_length_in_chain
-					      (vm,
-					       o_b0) - sizeof (ip6_header_t));
-		    }
-		  else
-		    {
-		      next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
-		      oh4->ip_version_and_header_length = 0x45;
-		      oh4->tos = ih4->tos;
-		      oh4->fragment_id = 0;
-		      oh4->flags_and_fragment_offset = 0;
-		      oh4->ttl = ih4->ttl;
-		      oh4->protocol = f0->next_header;
-		      oh4->src_address.as_u32 = ih4->src_address.as_u32;
-		      oh4->dst_address.as_u32 = ih4->dst_address.as_u32;
-		      oh4->length =
-			clib_host_to_net_u16 (vlib_buffer_length_in_chain
-					      (vm, o_b0));
-		      oh4->checksum = ip4_header_checksum (oh4);
-		    }
+		  ih4 = p0->ih;
+		  oh4 = vlib_buffer_get_current (o_b0);
+		  next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
+		  oh4->ip_version_and_header_length = 0x45;
+		  oh4->tos = ih4->tos;
+		  oh4->fragment_id = 0;
+		  oh4->flags_and_fragment_offset = 0;
+		  oh4->ttl = ih4->ttl;
+		  oh4->protocol = f0->next_header;
+		  oh4->src_address.as_u32 = ih4->src_address.as_u32;
+		  oh4->dst_address.as_u32 = ih4->dst_address.as_u32;
+		  oh4->length =
+		    clib_host_to_net_u16 (vlib_buffer_length_in_chain
+					  (vm, o_b0));
+		  oh4->checksum = ip4_header_checksum (oh4);
 		}
+	    }
 
-	      /* for IPSec-GRE tunnel next node is ipsec-gre-input */
-	      if (PREDICT_FALSE
-		  ((vnet_buffer (i_b0)->ipsec.flags) &
-		   IPSEC_FLAG_IPSEC_GRE_TUNNEL))
-		next0 = ESP_DECRYPT_NEXT_IPSEC_GRE_INPUT;
+	  /* for IPSec-GRE tunnel next node is ipsec-gre-input */
+	  if (PREDICT_FALSE
+	      ((vnet_buffer (i_b0)->ipsec.flags) &
+	       IPSEC_FLAG_IPSEC_GRE_TUNNEL))
+	    next0 = ESP_DECRYPT_NEXT_IPSEC_GRE_INPUT;
 
-	      vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
-	      vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
-		vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
-	    }
+	  vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	  vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
+	    vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
 
 	trace:
 	  if (PREDICT_FALSE (i_b0->flags & VLIB_BUFFER_IS_TRACED))
@@ -42,7 +42,7 @@ typedef enum
 #define foreach_esp_encrypt_error                   \
  _(RX_PKTS, "ESP pkts received")                    \
  _(NO_BUFFER, "No buffer (packet dropped)")         \
- _(DECRYPTION_FAILED, "ESP encryption failed")      \
+ _(ENCRYPTION_FAILED, "ESP encryption failed")      \
  _(SEQ_CYCLED, "sequence number cycled")
 
 
@@ -87,53 +87,49 @@ format_esp_encrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
-always_inline void
-esp_encrypt_cbc (ipsec_crypto_alg_t alg,
-		 u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
+/* a packet whose cipher or ICV failed must not leave half built */
+static_always_inline void
+esp_encrypt_drop (vlib_main_t * vm, vlib_node_runtime_t * node, u32 * bis,
+		  u16 * nexts, u32 i)
 {
-  ipsec_proto_main_t *em = &ipsec_proto_main;
-  u32 thread_index = vlib_get_thread_index ();
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].encrypt_ctx;
-#else
-  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].encrypt_ctx);
-#endif
-  const EVP_CIPHER *cipher = NULL;
-  int out_len;
-
-  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
-
-  if (PREDICT_FALSE
-      (em->ipsec_proto_main_crypto_algs[alg].type == IPSEC_CRYPTO_ALG_NONE))
-    return;
-
-  if (PREDICT_FALSE
-      (alg != em->per_thread_data[thread_index].last_encrypt_alg))
-    {
-      cipher = em->ipsec_proto_main_crypto_algs[alg].type;
-      em->per_thread_data[thread_index].last_encrypt_alg = alg;
-    }
-
-  EVP_EncryptInit_ex (ctx, cipher, NULL, key, iv);
+  vlib_buffer_t *b = vlib_get_buffer (vm, bis[i]);
 
-  EVP_EncryptUpdate (ctx, out, &out_len, in, in_len);
-  EVP_EncryptFinal_ex (ctx, out + out_len, &out_len);
+  b->error = node->errors[ESP_ENCRYPT_ERROR_ENCRYPTION_FAILED];
+  nexts[i] = ESP_ENCRYPT_NEXT_DROP;
 }
 
 static uword
 esp_encrypt_node_fn (vlib_main_t * vm,
 		     vlib_node_runtime_t * node, vlib_frame_t * from_frame)
 {
-  u32 n_left_from, *from, *to_next = 0, next_index;
+  u32 n_left_from, *from;
+  u32 bis[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  vnet_crypto_op_t *op;
+  u32 i = 0, n_ops;
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
   ipsec_main_t *im = &ipsec_main;
   ipsec_proto_main_t *em = &ipsec_proto_main;
   u32 *recycle = 0;
   u32 thread_index = vlib_get_thread_index ();
+  ipsec_proto_main_per_thread_data_t *ptd =
+    vec_elt_at_index (em->per_thread_data, thread_index);
 
   ipsec_alloc_empty_buffers (vm, im);
 
+  /*
+   * Ciphers and HMACs are collected over the frame and run in two
+   * batches once all packets are built, IVs come from a single call.
+   * Packets are enqueued only after that, so a failed op can still
+   * send its packet to the drop node.
+   */
+  vec_reset_length (ptd->crypto_ops);
+  vec_reset_length (ptd->integ_ops);
+  vec_validate (ptd->op_data, n_left_from - 1);
+  vec_validate (ptd->ivs, n_left_from * 16 - 1);
+  RAND_bytes (ptd->ivs, n_left_from * 16);
+
   u32 *empty_buffers = im->empty_buffers[thread_index];
 
   if (PREDICT_FALSE (vec_len (empty_buffers) < n_left_from))
@@ -144,286 +140,342 @@ esp_encrypt_node_fn (vlib_main_t * vm,
       goto free_buffers_and_exit;
     }
 
-  next_index = node->cached_next_index;
-
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      u32 i_bi0, o_bi0, next0;
+      vlib_buffer_t *i_b0, *o_b0 = 0;
+      u32 sa_index0;
+      ipsec_sa_t *sa0;
+      ip4_and_esp_header_t *oh0 = 0;
+      ip6_and_esp_header_t *ih6_0, *oh6_0 = 0;
+      ip4_and_udp_and_esp_header_t *iuh0, *ouh0 = 0;
+      uword last_empty_buffer;
+      esp_header_t *o_esp0;
+      esp_footer_t *f0;
+      u8 is_ipv6;
+      u8 ip_udp_hdr_size;
+      u8 next_hdr_type;
+      u32 ip_proto = 0;
+      u8 transport_mode = 0;
+
+      i_bi0 = from[0];
+      from += 1;
+      n_left_from -= 1;
+
+      next0 = ESP_ENCRYPT_NEXT_DROP;
+
+      i_b0 = vlib_get_buffer (vm, i_bi0);
+      sa_index0 = vnet_buffer (i_b0)->ipsec.sad_index;
+      sa0 = pool_elt_at_index (im->sad, sa_index0);
+
+      if (PREDICT_FALSE (esp_seq_advance (sa0)))
 	{
-	  u32 i_bi0, o_bi0, next0;
-	  vlib_buffer_t *i_b0, *o_b0 = 0;
-	  u32 sa_index0;
-	  ipsec_sa_t *sa0;
-	  ip4_and_esp_header_t *oh0 = 0;
-	  ip6_and_esp_header_t *ih6_0, *oh6_0 = 0;
-	  ip4_and_udp_and_esp_header_t *iuh0, *ouh0 = 0;
-	  uword last_empty_buffer;
-	  esp_header_t *o_esp0;
-	  esp_footer_t *f0;
-	  u8 is_ipv6;
-	  u8 ip_udp_hdr_size;
-	  u8 next_hdr_type;
-	  u32 ip_proto = 0;
-	  u8 transport_mode = 0;
-
-	  i_bi0 = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  next0 = ESP_ENCRYPT_NEXT_DROP;
-
-	  i_b0 = vlib_get_buffer (vm, i_bi0);
-	  sa_index0 = vnet_buffer (i_b0)->ipsec.sad_index;
-	  sa0 = pool_elt_at_index (im->sad, sa_index0);
-
-	  if (PREDICT_FALSE (esp_seq_advance (sa0)))
-	    {
-	      clib_warning ("sequence number counter has cycled SPI %u",
-			    sa0->spi);
-	      vlib_node_increment_counter (vm, esp_encrypt_node.index,
-					   ESP_ENCRYPT_ERROR_SEQ_CYCLED, 1);
-	      //TODO: rekey SA
-	      o_bi0 = i_bi0;
-	      to_next[0] = o_bi0;
-	      to_next += 1;
-	      goto trace;
-	    }
+	  clib_warning ("sequence number counter has cycled SPI %u",
+			sa0->spi);
+	  vlib_node_increment_counter (vm, esp_encrypt_node.index,
+				       ESP_ENCRYPT_ERROR_SEQ_CYCLED, 1);
+	  //TODO: rekey SA
+	  o_bi0 = i_bi0;
+	  goto trace;
+	}
 
-	  sa0->total_data_size += i_b0->current_length;
-
-	  /* grab free buffer */
-	  last_empty_buffer = vec_len (empty_buffers) - 1;
-	  o_bi0 = empty_buffers[last_empty_buffer];
-	  o_b0 = vlib_get_buffer (vm, o_bi0);
-	  o_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
-	  o_b0->current_data = sizeof (ethernet_header_t);
-	  iuh0 = vlib_buffer_get_current (i_b0);
-	  vlib_prefetch_buffer_with_index (vm,
-					   empty_buffers[last_empty_buffer -
-							 1], STORE);
-	  _vec_len (empty_buffers) = last_empty_buffer;
-	  to_next[0] = o_bi0;
-	  to_next += 1;
-
-	  /* add old buffer to the recycle list */
-	  vec_add1 (recycle, i_bi0);
-
-	  /* is ipv6 */
-	  if (PREDICT_FALSE
-	      ((iuh0->ip4.ip_version_and_header_length & 0xF0) == 0x60))
+      sa0->total_data_size += i_b0->current_length;
+
+      /* grab free buffer */
+      last_empty_buffer = vec_len (empty_buffers) - 1;
+      o_bi0 = empty_buffers[last_empty_buffer];
+      o_b0 = vlib_get_buffer (vm, o_bi0);
+      o_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+      o_b0->current_data = sizeof (ethernet_header_t);
+      iuh0 = vlib_buffer_get_current (i_b0);
+      vlib_prefetch_buffer_with_index (vm,
+				       empty_buffers[last_empty_buffer -
+						     1], STORE);
+      _vec_len (empty_buffers) = last_empty_buffer;
+
+      /* add old buffer to the recycle list */
+      vec_add1 (recycle, i_bi0);
+
+      /* is ipv6 */
+      if (PREDICT_FALSE
+	  ((iuh0->ip4.ip_version_and_header_length & 0xF0) == 0x60))
+	{
+	  is_ipv6 = 1;
+	  ih6_0 = vlib_buffer_get_current (i_b0);
+	  next_hdr_type = IP_PROTOCOL_IPV6;
+	  oh6_0 = vlib_buffer_get_current (o_b0);
+
+	  oh6_0->ip6.ip_version_traffic_class_and_flow_label =
+	    ih6_0->ip6.ip_version_traffic_class_and_flow_label;
+	  oh6_0->ip6.protocol = IP_PROTOCOL_IPSEC_ESP;
+	  ip_udp_hdr_size = sizeof (ip6_header_t);
+	  o_esp0 = vlib_buffer_get_current (o_b0) + ip_udp_hdr_size;
+	  oh6_0->ip6.hop_limit = 254;
+	  oh6_0->ip6.src_address.as_u64[0] =
+	    ih6_0->ip6.src_address.as_u64[0];
+	  oh6_0->ip6.src_address.as_u64[1] =
+	    ih6_0->ip6.src_address.as_u64[1];
+	  oh6_0->ip6.dst_address.as_u64[0] =
+	    ih6_0->ip6.dst_address.as_u64[0];
+	  oh6_0->ip6.dst_address.as_u64[1] =
+	    ih6_0->ip6.dst_address.as_u64[1];
+	  o_esp0->spi = clib_net_to_host_u32 (sa0->spi);
+	  o_esp0->seq = clib_net_to_host_u32 (sa0->seq);
+	  ip_proto = ih6_0->ip6.protocol;
+
+	  next0 = ESP_ENCRYPT_NEXT_IP6_LOOKUP;
+	}
+      else
+	{
+	  is_ipv6 = 0;
+	  next_hdr_type = IP_PROTOCOL_IP_IN_IP;
+	  oh0 = vlib_buffer_get_current (o_b0);
+	  ouh0 = vlib_buffer_get_current (o_b0);
+
+	  oh0->ip4.ip_version_and_header_length = 0x45;
+	  oh0->ip4.tos = iuh0->ip4.tos;
+	  oh0->ip4.fragment_id = 0;
+	  oh0->ip4.flags_and_fragment_offset = 0;
+	  oh0->ip4.ttl = 254;
+	  if (sa0->udp_encap)
 	    {
-	      is_ipv6 = 1;
-	      ih6_0 = vlib_buffer_get_current (i_b0);
-	      next_hdr_type = IP_PROTOCOL_IPV6;
-	      oh6_0 = vlib_buffer_get_current (o_b0);
-
-	      oh6_0->ip6.ip_version_traffic_class_and_flow_label =
-		ih6_0->ip6.ip_version_traffic_class_and_flow_label;
-	      oh6_0->ip6.protocol = IP_PROTOCOL_IPSEC_ESP;
-	      ip_udp_hdr_size = sizeof (ip6_header_t);
-	      o_esp0 = vlib_buffer_get_current (o_b0) + ip_udp_hdr_size;
-	      oh6_0->ip6.hop_limit = 254;
-	      oh6_0->ip6.src_address.as_u64[0] =
-		ih6_0->ip6.src_address.as_u64[0];
-	      oh6_0->ip6.src_address.as_u64[1] =
-		ih6_0->ip6.src_address.as_u64[1];
-	      oh6_0->ip6.dst_address.as_u64[0] =
-		ih6_0->ip6.dst_address.as_u64[0];
-	      oh6_0->ip6.dst_address.as_u64[1] =
-		ih6_0->ip6.dst_address.as_u64[1];
-	      o_esp0->spi = clib_net_to_host_u32 (sa0->spi);
-	      o_esp0->seq = clib_net_to_host_u32 (sa0->seq);
-	      ip_proto = ih6_0->ip6.protocol;
-
-	      next0 = ESP_ENCRYPT_NEXT_IP6_LOOKUP;
+	      ouh0->udp.src_port =
+		clib_host_to_net_u16 (UDP_DST_PORT_ipsec);
+	      ouh0->udp.dst_port =
+		clib_host_to_net_u16 (UDP_DST_PORT_ipsec);
+	      ouh0->udp.checksum = 0;
+	      ouh0->ip4.protocol = IP_PROTOCOL_UDP;
+	      ip_udp_hdr_size =
+		sizeof (udp_header_t) + sizeof (ip4_header_t);
 	    }
 	  else
 	    {
-	      is_ipv6 = 0;
-	      next_hdr_type = IP_PROTOCOL_IP_IN_IP;
-	      oh0 = vlib_buffer_get_current (o_b0);
-	      ouh0 = vlib_buffer_get_current (o_b0);
-
-	      oh0->ip4.ip_version_and_header_length = 0x45;
-	      oh0->ip4.tos = iuh0->ip4.tos;
-	      oh0->ip4.fragment_id = 0;
-	      oh0->ip4.flags_and_fragment_offset = 0;
-	      oh0->ip4.ttl = 254;
-	      if (sa0->udp_encap)
-		{
-		  ouh0->udp.src_port =
-		    clib_host_to_net_u16 (UDP_DST_PORT_ipsec);
-		  ouh0->udp.dst_port =
-		    clib_host_to_net_u16 (UDP_DST_PORT_ipsec);
-		  ouh0->udp.checksum = 0;
-		  ouh0->ip4.protocol = IP_PROTOCOL_UDP;
-		  ip_udp_hdr_size =
-		    sizeof (udp_header_t) + sizeof (ip4_header_t);
-		}
-	      else
-		{
-		  oh0->ip4.protocol = IP_PROTOCOL_IPSEC_ESP;
-		  ip_udp_hdr_size = sizeof (ip4_header_t);
-		}
-	      o_esp0 = vlib_buffer_get_current (o_b0) + ip_udp_hdr_size;
-	      oh0->ip4.src_address.as_u32 = iuh0->ip4.src_address.as_u32;
-	      oh0->ip4.dst_address.as_u32 = iuh0->ip4.dst_address.as_u32;
-	      o_esp0->spi = clib_net_to_host_u32 (sa0->spi);
-	      o_esp0->seq = clib_net_to_host_u32 (sa0->seq);
-	      ip_proto = iuh0->ip4.protocol;
-
-	      next0 = ESP_ENCRYPT_NEXT_IP4_LOOKUP;
+	      oh0->ip4.protocol = IP_PROTOCOL_IPSEC_ESP;
+	      ip_udp_hdr_size = sizeof (ip4_header_t);
 	    }
+	  o_esp0 = vlib_buffer_get_current (o_b0) + ip_udp_hdr_size;
+	  oh0->ip4.src_address.as_u32 = iuh0->ip4.src_address.as_u32;
+	  oh0->ip4.dst_address.as_u32 = iuh0->ip4.dst_address.as_u32;
+	  o_esp0->spi = clib_net_to_host_u32 (sa0->spi);
+	  o_esp0->seq = clib_net_to_host_u32 (sa0->seq);
+	  ip_proto = iuh0->ip4.protocol;
+
+	  next0 = ESP_ENCRYPT_NEXT_IP4_LOOKUP;
+	}
 
-	  if (PREDICT_TRUE
-	      (!is_ipv6 && sa0->is_tunnel && !sa0->is_tunnel_ip6))
-	    {
-	      oh0->ip4.src_address.as_u32 = sa0->tunnel_src_addr.ip4.as_u32;
-	      oh0->ip4.dst_address.as_u32 = sa0->tunnel_dst_addr.ip4.as_u32;
+      if (PREDICT_TRUE
+	  (!is_ipv6 && sa0->is_tunnel && !sa0->is_tunnel_ip6))
+	{
+	  oh0->ip4.src_address.as_u32 = sa0->tunnel_src_addr.ip4.as_u32;
+	  oh0->ip4.dst_address.as_u32 = sa0->tunnel_dst_addr.ip4.as_u32;
 
-	      vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
-	    }
-	  else if (is_ipv6 && sa0->is_tunnel && sa0->is_tunnel_ip6)
-	    {
-	      oh6_0->ip6.src_address.as_u64[0] =
-		sa0->tunnel_src_addr.ip6.as_u64[0];
-	      oh6_0->ip6.src_address.as_u64[1] =
-		sa0->tunnel_src_addr.ip6.as_u64[1];
-	      oh6_0->ip6.dst_address.as_u64[0] =
-		sa0->tunnel_dst_addr.ip6.as_u64[0];
-	      oh6_0->ip6.dst_address.as_u64[1] =
-		sa0->tunnel_dst_addr.ip6.as_u64[1];
-
-	      vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
-	    }
-	  else
+	  vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	}
+      else if (is_ipv6 && sa0->is_tunnel && sa0->is_tunnel_ip6)
+	{
+	  oh6_0->ip6.src_address.as_u64[0] =
+	    sa0->tunnel_src_addr.ip6.as_u64[0];
+	  oh6_0->ip6.src_address.as_u64[1] =
+	    sa0->tunnel_src_addr.ip6.as_u64[1];
+	  oh6_0->ip6.dst_address.as_u64[0] =
+	    sa0->tunnel_dst_addr.ip6.as_u64[0];
+	  oh6_0->ip6.dst_address.as_u64[1] =
+	    sa0->tunnel_dst_addr.ip6.as_u64[1];
+
+	  vnet_buffer (o_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	}
+      else
+	{
+	  next_hdr_type = ip_proto;
+	  if (vnet_buffer (i_b0)->sw_if_index[VLIB_TX] != ~0)
 	    {
-	      next_hdr_type = ip_proto;
-	      if (vnet_buffer (i_b0)->sw_if_index[VLIB_TX] != ~0)
-		{
-		  transport_mode = 1;
-		  ethernet_header_t *ieh0, *oeh0;
-		  ieh0 =
-		    (ethernet_header_t *) ((u8 *)
-					   vlib_buffer_get_current (i_b0) -
-					   sizeof (ethernet_header_t));
-		  oeh0 = (ethernet_header_t *) o_b0->data;
-		  clib_memcpy (oeh0, ieh0, sizeof (ethernet_header_t));
-		  next0 = ESP_ENCRYPT_NEXT_INTERFACE_OUTPUT;
-		  vnet_buffer (o_b0)->sw_if_index[VLIB_TX] =
-		    vnet_buffer (i_b0)->sw_if_index[VLIB_TX];
-		}
-	      vlib_buffer_advance (i_b0, ip_udp_hdr_size);
+	      transport_mode = 1;
+	      ethernet_header_t *ieh0, *oeh0;
+	      ieh0 =
+		(ethernet_header_t *) ((u8 *)
+				       vlib_buffer_get_current (i_b0) -
+				       sizeof (ethernet_header_t));
+	      oeh0 = (ethernet_header_t *) o_b0->data;
+	      clib_memcpy (oeh0, ieh0, sizeof (ethernet_header_t));
+	      next0 = ESP_ENCRYPT_NEXT_INTERFACE_OUTPUT;
+	      vnet_buffer (o_b0)->sw_if_index[VLIB_TX] =
+		vnet_buffer (i_b0)->sw_if_index[VLIB_TX];
 	    }
+	  vlib_buffer_advance (i_b0, ip_udp_hdr_size);
+	}
 
-	  ASSERT (sa0->crypto_alg < IPSEC_CRYPTO_N_ALG);
+      ASSERT (sa0->crypto_alg < IPSEC_CRYPTO_N_ALG);
 
-	  if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
+      if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
+	{
+	  ipsec_proto_main_crypto_alg_t *ca0 =
+	    &em->ipsec_proto_main_crypto_algs[sa0->crypto_alg];
+	  const int BLOCK_SIZE = ca0->block_size;
+	  const int IV_SIZE = ca0->iv_size;
+	  int blocks = 1 + (i_b0->current_length + 1) / BLOCK_SIZE;
+	  vnet_crypto_op_t *op0;
+	  esp_op_data_t *d0;
+	  u8 *iv0;
+
+	  /* pad packet in input buffer */
+	  u8 pad_bytes = BLOCK_SIZE * blocks - 2 - i_b0->current_length;
+	  u8 j;
+	  u8 *padding =
+	    vlib_buffer_get_current (i_b0) + i_b0->current_length;
+	  i_b0->current_length = BLOCK_SIZE * blocks;
+	  for (j = 0; j < pad_bytes; ++j)
 	    {
-
-	      const int BLOCK_SIZE =
-		em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].block_size;
-	      const int IV_SIZE =
-		em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].iv_size;
-	      int blocks = 1 + (i_b0->current_length + 1) / BLOCK_SIZE;
-
-	      /* pad packet in input buffer */
-	      u8 pad_bytes = BLOCK_SIZE * blocks - 2 - i_b0->current_length;
-	      u8 i;
-	      u8 *padding =
-		vlib_buffer_get_current (i_b0) + i_b0->current_length;
-	      i_b0->current_length = BLOCK_SIZE * blocks;
-	      for (i = 0; i < pad_bytes; ++i)
-		{
-		  padding[i] = i + 1;
-		}
-	      f0 = vlib_buffer_get_current (i_b0) + i_b0->current_length - 2;
-	      f0->pad_length = pad_bytes;
-	      f0->next_header = next_hdr_type;
-
-	      o_b0->current_length = ip_udp_hdr_size + sizeof (esp_header_t) +
-		BLOCK_SIZE * blocks + IV_SIZE;
-
-	      vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
-		vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
-
-	      u8 iv[em->
-		    ipsec_proto_main_crypto_algs[sa0->crypto_alg].iv_size];
-	      RAND_bytes (iv, sizeof (iv));
-
-	      clib_memcpy ((u8 *) vlib_buffer_get_current (o_b0) +
-			   ip_udp_hdr_size + sizeof (esp_header_t), iv,
-			   em->ipsec_proto_main_crypto_algs[sa0->
-							    crypto_alg].iv_size);
-
-	      esp_encrypt_cbc (sa0->crypto_alg,
-			       (u8 *) vlib_buffer_get_current (i_b0),
-			       (u8 *) vlib_buffer_get_current (o_b0) +
-			       ip_udp_hdr_size + sizeof (esp_header_t) +
-			       IV_SIZE, BLOCK_SIZE * blocks,
-			       sa0->crypto_key, iv);
+	      padding[j] = j + 1;
 	    }
+	  f0 = vlib_buffer_get_current (i_b0) + i_b0->current_length - 2;
+	  f0->pad_length = pad_bytes;
+	  f0->next_header = next_hdr_type;
+
+	  o_b0->current_length = ip_udp_hdr_size + sizeof (esp_header_t) +
+	    BLOCK_SIZE * blocks + IV_SIZE;
 
-	  o_b0->current_length += hmac_calc (sa0->integ_alg, sa0->integ_key,
-					     sa0->integ_key_len,
-					     (u8 *) o_esp0,
-					     o_b0->current_length -
-					     ip_udp_hdr_size,
-					     vlib_buffer_get_current (o_b0) +
-					     o_b0->current_length,
-					     sa0->use_esn, sa0->seq_hi);
+	  vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
+	    vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
 
+	  iv0 = (u8 *) o_esp0 + sizeof (esp_header_t);
+	  d0 = vec_elt_at_index (ptd->op_data, vec_len (ptd->crypto_ops));
 
-	  if (PREDICT_FALSE (is_ipv6))
+	  vec_add2_aligned (ptd->crypto_ops, op0, 1, CLIB_CACHE_LINE_BYTES);
+	  vnet_crypto_op_init (op0, ca0->enc_op_id);
+	  op0->user_data = i;
+	  op0->key_index = sa0->crypto_key_index;
+	  op0->src = vlib_buffer_get_current (i_b0);
+	  op0->dst = iv0 + IV_SIZE;
+	  op0->len = BLOCK_SIZE * blocks;
+
+	  if (ca0->icv_size)
 	    {
-	      oh6_0->ip6.payload_length =
-		clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, o_b0) -
-				      sizeof (ip6_header_t));
+	      /* RFC 4106: the IV is the 64 bit sequence number */
+	      u32 seq_hi = clib_host_to_net_u32 (sa0->seq_hi);
+	      d0->nonce.salt = sa0->salt;
+	      clib_memcpy (iv0, &seq_hi, sizeof (seq_hi));
+	      clib_memcpy (iv0 + sizeof (seq_hi), &o_esp0->seq,
+			   sizeof (o_esp0->seq));
+	      clib_memcpy (&d0->nonce.iv, iv0, IV_SIZE);
+	      d0->aad[0] = o_esp0->spi;
+	      if (sa0->use_esn)
+		{
+		  d0->aad[1] = seq_hi;
+		  d0->aad[2] = o_esp0->seq;
+		  op0->aad_len = 12;
+		}
+	      else
+		{
+		  d0->aad[1] = o_esp0->seq;
+		  op0->aad_len = 8;
+		}
+	      op0->iv = (u8 *) & d0->nonce;
+	      op0->aad = (u8 *) d0->aad;
+	      op0->tag = op0->dst + op0->len;
+	      op0->tag_len = ca0->icv_size;
+	      o_b0->current_length += ca0->icv_size;
 	    }
 	  else
 	    {
-	      oh0->ip4.length =
-		clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, o_b0));
-	      oh0->ip4.checksum = ip4_header_checksum (&oh0->ip4);
-	      if (sa0->udp_encap)
-		{
-		  ouh0->udp.length =
-		    clib_host_to_net_u16 (oh0->ip4.length -
-					  ip4_header_bytes (&oh0->ip4));
-		}
+	      clib_memcpy (iv0, ptd->ivs + 16 * (vec_len (ptd->crypto_ops)
+						 - 1), IV_SIZE);
+	      op0->iv = iv0;
 	    }
+	}
 
-	  if (transport_mode)
-	    vlib_buffer_reset (o_b0);
+      if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
+	{
+	  ipsec_proto_main_integ_alg_t *ia0 =
+	    &em->ipsec_proto_main_integ_algs[sa0->integ_alg];
+	  u8 *digest0 = vlib_buffer_get_current (o_b0) +
+	    o_b0->current_length;
+	  vnet_crypto_op_t *op0;
+
+	  vec_add2_aligned (ptd->integ_ops, op0, 1, CLIB_CACHE_LINE_BYTES);
+	  vnet_crypto_op_init (op0, ia0->op_id);
+	  op0->user_data = i;
+	  op0->key_index = sa0->integ_key_index;
+	  op0->src = (u8 *) o_esp0;
+	  op0->len = o_b0->current_length - ip_udp_hdr_size;
+	  op0->digest = digest0;
+	  op0->digest_len = ia0->trunc_size;
+
+	  /* ESN high bits are hashed from where the ICV goes */
+	  if (sa0->use_esn)
+	    {
+	      clib_memcpy (digest0, &sa0->seq_hi, sizeof (sa0->seq_hi));
+	      op0->len += sizeof (sa0->seq_hi);
+	    }
+	  o_b0->current_length += ia0->trunc_size;
+	}
 
-	trace:
-	  if (PREDICT_FALSE (i_b0->flags & VLIB_BUFFER_IS_TRACED))
+      if (PREDICT_FALSE (is_ipv6))
+	{
+	  oh6_0->ip6.payload_length =
+	    clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, o_b0) -
+				  sizeof (ip6_header_t));
+	}
+      else
+	{
+	  oh0->ip4.length =
+	    clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, o_b0));
+	  oh0->ip4.checksum = ip4_header_checksum (&oh0->ip4);
+	  if (sa0->udp_encap)
 	    {
-	      if (o_b0)
-		{
-		  o_b0->flags |= VLIB_BUFFER_IS_TRACED;
-		  o_b0->trace_index = i_b0->trace_index;
-		  esp_encrypt_trace_t *tr =
-		    vlib_add_trace (vm, node, o_b0, sizeof (*tr));
-		  tr->spi = sa0->spi;
-		  tr->seq = sa0->seq - 1;
-		  tr->udp_encap = sa0->udp_encap;
-		  tr->crypto_alg = sa0->crypto_alg;
-		  tr->integ_alg = sa0->integ_alg;
-		}
+	      ouh0->udp.length =
+		clib_host_to_net_u16 (oh0->ip4.length -
+				      ip4_header_bytes (&oh0->ip4));
 	    }
+	}
+
+      if (transport_mode)
+	vlib_buffer_reset (o_b0);
 
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next, o_bi0,
-					   next0);
+    trace:
+      if (PREDICT_FALSE (i_b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  if (o_b0)
+	    {
+	      o_b0->flags |= VLIB_BUFFER_IS_TRACED;
+	      o_b0->trace_index = i_b0->trace_index;
+	      esp_encrypt_trace_t *tr =
+		vlib_add_trace (vm, node, o_b0, sizeof (*tr));
+	      tr->spi = sa0->spi;
+	      tr->seq = sa0->seq - 1;
+	      tr->udp_encap = sa0->udp_encap;
+	      tr->crypto_alg = sa0->crypto_alg;
+	      tr->integ_alg = sa0->integ_alg;
+	    }
 	}
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+      bis[i] = o_bi0;
+      nexts[i] = next0;
+      i++;
     }
+
+  /* the ICV covers the ciphertext, so ciphers go first */
+  n_ops = vec_len (ptd->crypto_ops);
+  if (n_ops != vnet_crypto_process_ops (vm, ptd->crypto_ops, n_ops))
+    {
+      /* *INDENT-OFF* */
+      vec_foreach (op, ptd->crypto_ops)
+	if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	  esp_encrypt_drop (vm, node, bis, nexts, op->user_data);
+      /* *INDENT-ON* */
+    }
+
+  n_ops = vec_len (ptd->integ_ops);
+  if (n_ops != vnet_crypto_process_ops (vm, ptd->integ_ops, n_ops))
+    {
+      /* *INDENT-OFF* */
+      vec_foreach (op, ptd->integ_ops)
+	if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	  esp_encrypt_drop (vm, node, bis, nexts, op->user_data);
+      /* *INDENT-ON* */
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, bis, nexts, from_frame->n_vectors);
+
   vlib_node_increment_counter (vm, esp_encrypt_node.index,
 			       ESP_ENCRYPT_ERROR_RX_PKTS,
 			       from_frame->n_vectors);
@@ -22,6 +22,7 @@
 #include <vnet/udp/udp.h>
 
 #include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/ipsec_spd_lookup.h>
 #include <vnet/ipsec/ikev2.h>
 #include <vnet/ipsec/esp.h>
 #include <vnet/ipsec/ah.h>
@@ -114,11 +115,14 @@ ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add)
       }));
       /* *INDENT-ON* */
       hash_unset (im->spd_index_by_spd_id, spd_id);
+      ipsec_spd_lookup_free (spd);
       pool_free (spd->policies);
       vec_free (spd->ipv4_outbound_policies);
       vec_free (spd->ipv6_outbound_policies);
       vec_free (spd->ipv4_inbound_protect_policy_indices);
       vec_free (spd->ipv4_inbound_policy_discard_and_bypass_indices);
+      vec_free (spd->ipv6_inbound_protect_policy_indices);
+      vec_free (spd->ipv6_inbound_policy_discard_and_bypass_indices);
       pool_put (im->spds, spd);
     }
   else				/* create new SPD */
@@ -140,13 +144,19 @@ ipsec_spd_entry_sort (void *a1, void *a2)
   u32 *id2 = a2;
   ipsec_spd_t *spd;
   ipsec_policy_t *p1, *p2;
+  u64 o1, o2;
 
   /* *INDENT-OFF* */
   pool_foreach (spd, im->spds, ({
     p1 = pool_elt_at_index(spd->policies, *id1);
     p2 = pool_elt_at_index(spd->policies, *id2);
     if (p1 && p2)
-      return p2->priority - p1->priority;
+      {
+        /* same order as the classified lookup, ties included */
+        o1 = ipsec_spd_policy_order (p1, *id1);
+        o2 = ipsec_spd_policy_order (p2, *id2);
+        return (o1 > o2) - (o1 < o2);
+      }
   }));
   /* *INDENT-ON* */
 
@@ -256,6 +266,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
 	    }
 	}
 
+      ipsec_spd_lookup_add_policy (spd, policy_index);
     }
   else
     {
@@ -305,7 +316,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
              {
                vec_foreach_index(j, spd->ipv6_outbound_policies) {
                  if (vec_elt(spd->ipv6_outbound_policies, j) == i) {
-                   vec_del1 (spd->ipv6_outbound_policies, j);
+                   vec_delete (spd->ipv6_outbound_policies, 1, j);
                    break;
                  }
                }
@@ -316,7 +327,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
                  {
                    vec_foreach_index(j, spd->ipv6_inbound_protect_policy_indices) {
                      if (vec_elt(spd->ipv6_inbound_protect_policy_indices, j) == i) {
-                       vec_del1 (spd->ipv6_inbound_protect_policy_indices, j);
+                       vec_delete (spd->ipv6_inbound_protect_policy_indices, 1, j);
                        break;
                      }
                    }
@@ -325,7 +336,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
                  {
                    vec_foreach_index(j, spd->ipv6_inbound_policy_discard_and_bypass_indices) {
                      if (vec_elt(spd->ipv6_inbound_policy_discard_and_bypass_indices, j) == i) {
-                       vec_del1 (spd->ipv6_inbound_policy_discard_and_bypass_indices, j);
+                       vec_delete (spd->ipv6_inbound_policy_discard_and_bypass_indices, 1, j);
                        break;
                      }
                    }
@@ -346,7 +357,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
               {
                 vec_foreach_index(j, spd->ipv4_outbound_policies) {
                   if (vec_elt(spd->ipv4_outbound_policies, j) == i) {
-                    vec_del1 (spd->ipv4_outbound_policies, j);
+                    vec_delete (spd->ipv4_outbound_policies, 1, j);
                     break;
                   }
                 }
@@ -357,7 +368,7 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
                   {
                     vec_foreach_index(j, spd->ipv4_inbound_protect_policy_indices) {
                       if (vec_elt(spd->ipv4_inbound_protect_policy_indices, j) == i) {
-                        vec_del1 (spd->ipv4_inbound_protect_policy_indices, j);
+                        vec_delete (spd->ipv4_inbound_protect_policy_indices, 1, j);
                         break;
                       }
                     }
@@ -366,13 +377,14 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
                   {
                     vec_foreach_index(j, spd->ipv4_inbound_policy_discard_and_bypass_indices) {
                       if (vec_elt(spd->ipv4_inbound_policy_discard_and_bypass_indices, j) == i) {
-                        vec_del1 (spd->ipv4_inbound_policy_discard_and_bypass_indices, j);
+                        vec_delete (spd->ipv4_inbound_policy_discard_and_bypass_indices, 1, j);
                         break;
                       }
                     }
                   }
               }
           }
+          ipsec_spd_lookup_del_policy (spd, i);
           pool_put (spd->policies, vp);
           break;
       }));
@@ -412,6 +424,51 @@ ipsec_is_sa_used (u32 sa_index)
   return 0;
 }
 
+/*
+ * (Re)creates the vnet crypto keys of an SA from its key material. For
+ * AEAD algorithms the last 4 bytes of the keying material are the salt
+ * (RFC 4106), the cipher key is what precedes it.
+ */
+void
+ipsec_sa_set_crypto_keys (vlib_main_t * vm, ipsec_sa_t * sa)
+{
+  ipsec_proto_main_t *em = &ipsec_proto_main;
+  ipsec_proto_main_crypto_alg_t *ca;
+  ipsec_proto_main_integ_alg_t *ia;
+  u8 key_len = sa->crypto_key_len;
+
+  sa->crypto_key_index = ~0;
+  sa->integ_key_index = ~0;
+
+  ca = vec_elt_at_index (em->ipsec_proto_main_crypto_algs, sa->crypto_alg);
+  if (ca->alg != VNET_CRYPTO_ALG_NONE)
+    {
+      if (ca->icv_size && key_len > 4)
+	{
+	  key_len -= 4;
+	  clib_memcpy (&sa->salt, sa->crypto_key + key_len, 4);
+	}
+      sa->crypto_key_index = vnet_crypto_key_add (vm, ca->alg,
+						  sa->crypto_key, key_len);
+    }
+
+  ia = vec_elt_at_index (em->ipsec_proto_main_integ_algs, sa->integ_alg);
+  if (ia->alg != VNET_CRYPTO_ALG_NONE)
+    sa->integ_key_index = vnet_crypto_key_add (vm, ia->alg, sa->integ_key,
+					       sa->integ_key_len);
+}
+
+void
+ipsec_sa_free_crypto_keys (vlib_main_t * vm, ipsec_sa_t * sa)
+{
+  if (sa->crypto_key_index != ~0)
+    vnet_crypto_key_del (vm, sa->crypto_key_index);
+  if (sa->integ_key_index != ~0)
+    vnet_crypto_key_del (vm, sa->integ_key_index);
+  sa->crypto_key_index = ~0;
+  sa->integ_key_index = ~0;
+}
+
 int
 ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add,
 		  u8 udp_encap)
@@ -446,6 +503,7 @@ ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add,
 	  if (err)
 	    return VNET_API_ERROR_SYSCALL_ERROR_1;
 	}
+      ipsec_sa_free_crypto_keys (vm, sa);
       pool_put (im->sad, sa);
     }
   else				/* create new SA */
@@ -454,6 +512,7 @@ ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add,
       clib_memcpy (sa, new_sa, sizeof (*sa));
       sa_index = sa - im->sad;
       sa->udp_encap = udp_encap ? 1 : 0;
+      ipsec_sa_set_crypto_keys (vm, sa);
       hash_set (im->sa_index_by_sa_id, sa->id, sa_index);
       if (im->cb.add_del_sa_sess_cb)
 	{
@@ -499,6 +558,9 @@ ipsec_set_sa_key (vlib_main_t * vm, ipsec_sa_t * sa_update)
 
   if (0 < sa_update->crypto_key_len || 0 < sa_update->integ_key_len)
     {
+      ipsec_sa_free_crypto_keys (vm, sa);
+      ipsec_sa_set_crypto_keys (vm, sa);
+
       if (im->cb.add_del_sa_sess_cb)
 	{
 	  err = im->cb.add_del_sa_sess_cb (sa_index, 0);
@@ -530,11 +592,41 @@ ipsec_rand_seed (void)
 static clib_error_t *
 ipsec_check_support (ipsec_sa_t * sa)
 {
-  if (sa->crypto_alg == IPSEC_CRYPTO_ALG_AES_GCM_128)
-    return clib_error_return (0, "unsupported aes-gcm-128 crypto-alg");
+  ipsec_proto_main_t *em = &ipsec_proto_main;
+  ipsec_proto_main_crypto_alg_t *ca;
+
+  if (sa->crypto_alg >= IPSEC_CRYPTO_N_ALG
+      || sa->integ_alg >= IPSEC_INTEG_N_ALG)
+    return clib_error_return (0, "unsupported algorithm");
+
+  ca = &em->ipsec_proto_main_crypto_algs[sa->crypto_alg];
+
+  if (sa->crypto_alg != IPSEC_CRYPTO_ALG_NONE
+      && ca->alg == VNET_CRYPTO_ALG_NONE)
+    return clib_error_return (0, "unsupported %U crypto-alg",
+			      format_ipsec_crypto_alg, sa->crypto_alg);
+
+  if (ca->icv_size)
+    {
+      /* AEAD, integrity comes with the cipher */
+      if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
+	return clib_error_return (0, "%U requires none integ-alg",
+				  format_ipsec_crypto_alg, sa->crypto_alg);
+      if (sa->crypto_key_len !=
+	  crypto_main.algs[ca->alg].key_length + sizeof (sa->salt))
+	return clib_error_return (0, "%U key must include a 4 byte salt",
+				  format_ipsec_crypto_alg, sa->crypto_alg);
+      return 0;
+    }
+
   if (sa->integ_alg == IPSEC_INTEG_ALG_NONE)
     return clib_error_return (0, "unsupported none integ-alg");
 
+  if (em->ipsec_proto_main_integ_algs[sa->integ_alg].alg ==
+      VNET_CRYPTO_ALG_NONE)
+    return clib_error_return (0, "unsupported %U integ-alg",
+			      format_ipsec_integ_alg, sa->integ_alg);
+
   return 0;
 }
 
@@ -545,6 +637,7 @@ ipsec_init (vlib_main_t * vm)
   ipsec_main_t *im = &ipsec_main;
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   vlib_node_t *node;
+  u32 i;
 
   ipsec_rand_seed ();
 
@@ -560,6 +653,15 @@ ipsec_init (vlib_main_t * vm)
   vec_validate_aligned (im->empty_buffers, tm->n_vlib_mains - 1,
 			CLIB_CACHE_LINE_BYTES);
 
+  vec_validate (im->ip4_outbound_flow_cache_by_thread,
+		tm->n_vlib_mains - 1);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    vec_validate_aligned (im->ip4_outbound_flow_cache_by_thread[i],
+			  IPSEC_SPD_FLOW_CACHE_SIZE - 1,
+			  CLIB_CACHE_LINE_BYTES);
+  /* zeroed cache entries are never valid */
+  im->spd_epoch = 1;
+
   node = vlib_get_node_by_name (vm, (u8 *) "error-drop");
   ASSERT (node);
   im->error_drop_node_index = node->index;
@@ -17,6 +17,7 @@
 
 #include <vnet/ip/ip.h>
 #include <vnet/feature/feature.h>
+#include <vppinfra/bihash_16_8.h>
 
 #define IPSEC_FLAG_IPSEC_GRE_TUNNEL (1 << 0)
 
@@ -133,6 +134,10 @@ typedef struct
 
   u32 salt;
 
+  /* vnet crypto keys, ~0 when unset */
+  u32 crypto_key_index;
+  u32 integ_key_index;
+
   /* runtime */
   u32 seq;
   u32 seq_hi;
@@ -217,6 +222,27 @@ typedef struct
   vlib_counter_t counter;
 } ipsec_policy_t;
 
+/* Range policy selector, host byte order, see ipsec_spd_lookup.h */
+typedef struct
+{
+  u32 laddr_start, laddr_stop;
+  u32 raddr_start, raddr_stop;
+  u16 lport_start, lport_stop;
+  u16 rport_start, rport_stop;
+  u8 protocol;
+  /* walk order, policy index in the low bits, see ipsec_spd_policy_order */
+  u64 order;
+} ipsec_spd_range_rule_t;
+
+typedef struct
+{
+  /* fully specified 5-tuples -> order, created on first use */
+  clib_bihash_16_8_t exact;
+  u32 n_exact;
+  /* everything else, in priority order */
+  ipsec_spd_range_rule_t *range_rules;
+} ipsec_spd_ip4_lookup_t;
+
 typedef struct
 {
   u32 id;
@@ -229,8 +255,23 @@ typedef struct
   u32 *ipv4_inbound_policy_discard_and_bypass_indices;
   u32 *ipv6_inbound_protect_policy_indices;
   u32 *ipv6_inbound_policy_discard_and_bypass_indices;
+
+  /* classified lookup, updated along with the vectors above */
+  ipsec_spd_ip4_lookup_t ip4_outbound_lookup;
+  uword *ipv4_inbound_protect_by_spi;
+  u32 **ipv4_inbound_protect_spi_buckets;
 } ipsec_spd_t;
 
+#define IPSEC_SPD_FLOW_CACHE_SIZE (1 << 12)
+
+typedef struct
+{
+  u64 key[2];
+  u32 spd_index;
+  u32 epoch;
+  u32 policy_index;
+} ipsec_spd_flow_cache_entry_t;
+
 typedef struct
 {
   u32 spd_index;
@@ -299,6 +340,10 @@ typedef struct
 
   /* callbacks */
   ipsec_main_callbacks_t cb;
+
+  /* per-thread ip4 outbound SPD flow caches, see ipsec_spd_lookup.h */
+  ipsec_spd_flow_cache_entry_t **ip4_outbound_flow_cache_by_thread;
+  u32 spd_epoch;
 } ipsec_main_t;
 
 extern ipsec_main_t ipsec_main;
@@ -322,6 +367,8 @@ int ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy,
 int ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add,
 		      u8 udp_encap);
 int ipsec_set_sa_key (vlib_main_t * vm, ipsec_sa_t * sa_update);
+void ipsec_sa_set_crypto_keys (vlib_main_t * vm, ipsec_sa_t * sa);
+void ipsec_sa_free_crypto_keys (vlib_main_t * vm, ipsec_sa_t * sa);
 
 u32 ipsec_get_sa_index_by_sa_id (u32 sa_id);
 u8 ipsec_is_sa_used (u32 sa_index);
@@ -155,6 +155,7 @@ ipsec_add_del_tunnel_if_internal (vnet_main_t * vnm,
 				  ipsec_add_del_tunnel_args_t * args,
 				  u32 * sw_if_index)
 {
+  vlib_main_t *vm = vlib_get_main ();
   ipsec_tunnel_if_t *t;
   ipsec_main_t *im = &ipsec_main;
   vnet_hw_interface_t *hi = NULL;
@@ -213,6 +214,7 @@ ipsec_add_del_tunnel_if_internal (vnet_main_t * vnm,
 	  clib_memcpy (sa->crypto_key, args->remote_crypto_key,
 		       args->remote_crypto_key_len);
 	}
+      ipsec_sa_set_crypto_keys (vm, sa);
 
       pool_get (im->sad, sa);
       memset (sa, 0, sizeof (*sa));
@@ -237,6 +239,7 @@ ipsec_add_del_tunnel_if_internal (vnet_main_t * vnm,
 	  clib_memcpy (sa->crypto_key, args->local_crypto_key,
 		       args->local_crypto_key_len);
 	}
+      ipsec_sa_set_crypto_keys (vm, sa);
 
       hash_set (im->ipsec_if_pool_index_by_key, key,
 		t - im->tunnel_interfaces);
@@ -277,9 +280,11 @@ ipsec_add_del_tunnel_if_internal (vnet_main_t * vnm,
       /* delete input and output SA */
 
       sa = pool_elt_at_index (im->sad, t->input_sa_index);
+      ipsec_sa_free_crypto_keys (vm, sa);
       pool_put (im->sad, sa);
 
       sa = pool_elt_at_index (im->sad, t->output_sa_index);
+      ipsec_sa_free_crypto_keys (vm, sa);
       pool_put (im->sad, sa);
 
       hash_unset (im->ipsec_if_pool_index_by_key, key);
@@ -402,6 +407,9 @@ ipsec_set_interface_key (vnet_main_t * vnm, u32 hw_if_index,
   else
     return VNET_API_ERROR_INVALID_VALUE;
 
+  ipsec_sa_free_crypto_keys (vlib_get_main (), sa);
+  ipsec_sa_set_crypto_keys (vlib_get_main (), sa);
+
   return 0;
 }
 
@@ -479,6 +487,7 @@ ipsec_set_interface_sa (vnet_main_t * vnm, u32 hw_if_index, u32 sa_id,
 	return VNET_API_ERROR_SYSCALL_ERROR_1;
     }
 
+  ipsec_sa_free_crypto_keys (vlib_get_main (), old_sa);
   pool_put (im->sad, old_sa);
 
   return 0;
@@ -71,7 +71,7 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 n_left_from, last_sw_if_index = ~0;
   u32 thread_index = vlib_get_thread_index ();
   u64 n_bytes = 0, n_packets = 0;
-  u8 icv_len;
+  u8 icv_len, iv_len;
   ipsec_tunnel_if_t *last_t = NULL;
   ipsec_sa_t *sa0;
   vlib_combined_counter_main_t *rx_counter;
@@ -152,13 +152,18 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      sa0 = pool_elt_at_index (im->sad, t->input_sa_index);
 		      icv_len =
 			em->ipsec_proto_main_integ_algs[sa0->
-							integ_alg].trunc_size;
+							integ_alg].trunc_size +
+			em->ipsec_proto_main_crypto_algs[sa0->
+							 crypto_alg].icv_size;
+		      iv_len =
+			em->ipsec_proto_main_crypto_algs[sa0->
+							 crypto_alg].iv_size;
 
 		      /* length = packet length - ESP/tunnel overhead */
 		      n_bytes -= n_packets * (sizeof (ip4_header_t) +
 					      sizeof (esp_header_t) +
 					      sizeof (esp_footer_t) +
-					      16 /* aes-cbc IV */  + icv_len);
+					      iv_len + icv_len);
 
 		      if (last_t)
 			{
@@ -200,11 +205,12 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (last_t)
     {
       sa0 = pool_elt_at_index (im->sad, last_t->input_sa_index);
-      icv_len = em->ipsec_proto_main_integ_algs[sa0->integ_alg].trunc_size;
+      icv_len = em->ipsec_proto_main_integ_algs[sa0->integ_alg].trunc_size +
+	em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].icv_size;
+      iv_len = em->ipsec_proto_main_crypto_algs[sa0->crypto_alg].iv_size;
 
       n_bytes -= n_packets * (sizeof (ip4_header_t) + sizeof (esp_header_t) +
-			      sizeof (esp_footer_t) + 16 /* aes-cbc IV */  +
-			      icv_len);
+			      sizeof (esp_footer_t) + iv_len + icv_len);
       vlib_increment_combined_counter (rx_counter,
 				       thread_index,
 				       last_sw_if_index, n_packets, n_bytes);
@@ -21,6 +21,7 @@
 #include <vnet/feature/feature.h>
 
 #include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/ipsec_spd_lookup.h>
 #include <vnet/ipsec/esp.h>
 #include <vnet/ipsec/ah.h>
 
@@ -80,16 +81,16 @@ ipsec_input_protect_policy_match (ipsec_spd_t * spd, u32 sa, u32 da, u32 spi)
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
   ipsec_sa_t *s;
-  u32 *i;
+  u32 *i, *candidates;
+
+  /* only policies whose SA carries this SPI can match */
+  candidates = ipsec_spd_ip4_inbound_protect_candidates (spd, spi);
 
-  vec_foreach (i, spd->ipv4_inbound_protect_policy_indices)
+  vec_foreach (i, candidates)
   {
     p = pool_elt_at_index (spd->policies, *i);
     s = pool_elt_at_index (im->sad, p->sa_index);
 
-    if (spi != s->spi)
-      continue;
-
     if (s->is_tunnel)
       {
 	if (da != clib_net_to_host_u32 (s->tunnel_dst_addr.ip4.as_u32))
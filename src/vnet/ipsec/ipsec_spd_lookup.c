@@ -0,0 +1,316 @@
+/*
+ * ipsec_spd_lookup.c : classified IPSec SPD lookup
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/ipsec_spd_lookup.h>
+
+static int
+ipsec_spd_ip4_policy_is_exact (ipsec_policy_t * p)
+{
+  if (!p->protocol)
+    return 0;
+
+  if (p->laddr.start.ip4.as_u32 != p->laddr.stop.ip4.as_u32)
+    return 0;
+
+  if (p->raddr.start.ip4.as_u32 != p->raddr.stop.ip4.as_u32)
+    return 0;
+
+  if (!ipsec_spd_proto_has_ports (p->protocol))
+    return 1;
+
+  return (p->lport.start == p->lport.stop
+	  && p->rport.start == p->rport.stop);
+}
+
+/* Sized for large SPDs; the arena is only reserved, not touched */
+#define IPSEC_SPD_EXACT_N_BUCKETS (1 << 12)
+#define IPSEC_SPD_EXACT_MEMORY (64 << 20)
+
+static void
+ipsec_spd_ip4_policy_key (ipsec_policy_t * p, clib_bihash_kv_16_8_t * kv)
+{
+  int has_ports = ipsec_spd_proto_has_ports (p->protocol);
+
+  ipsec_spd_ip4_make_key (kv, p->protocol,
+			  clib_net_to_host_u32 (p->laddr.start.ip4.as_u32),
+			  clib_net_to_host_u32 (p->raddr.start.ip4.as_u32),
+			  has_ports ? p->lport.start : 0,
+			  has_ports ? p->rport.start : 0);
+}
+
+static void
+ipsec_spd_ip4_outbound_lookup_free (ipsec_spd_ip4_lookup_t * lk)
+{
+  if (lk->exact.nbuckets)
+    clib_bihash_free_16_8 (&lk->exact);
+  memset (&lk->exact, 0, sizeof (lk->exact));
+  lk->n_exact = 0;
+  vec_free (lk->range_rules);
+}
+
+static void
+ipsec_spd_ip4_outbound_add (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_spd_ip4_lookup_t *lk = &spd->ip4_outbound_lookup;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+  u64 order = ipsec_spd_policy_order (p, policy_index);
+  clib_bihash_kv_16_8_t kv, value;
+  ipsec_spd_range_rule_t *r;
+  u32 i;
+
+  if (ipsec_spd_ip4_policy_is_exact (p))
+    {
+      if (!lk->exact.nbuckets)
+	clib_bihash_init_16_8 (&lk->exact, "ipsec spd exact",
+			       IPSEC_SPD_EXACT_N_BUCKETS,
+			       IPSEC_SPD_EXACT_MEMORY);
+
+      ipsec_spd_ip4_policy_key (p, &kv);
+      if (!clib_bihash_search_16_8 (&lk->exact, &kv, &value))
+	{
+	  /* a duplicate selector can never win, the first one shadows it */
+	  if (value.value < order)
+	    return;
+	}
+      else
+	lk->n_exact++;
+
+      kv.value = order;
+      clib_bihash_add_del_16_8 (&lk->exact, &kv, 1 /* is_add */ );
+      return;
+    }
+
+  /* usually added in walk order, so search from the end */
+  i = vec_len (lk->range_rules);
+  while (i > 0 && lk->range_rules[i - 1].order > order)
+    i--;
+
+  vec_insert (lk->range_rules, 1, i);
+  r = vec_elt_at_index (lk->range_rules, i);
+  r->laddr_start = clib_net_to_host_u32 (p->laddr.start.ip4.as_u32);
+  r->laddr_stop = clib_net_to_host_u32 (p->laddr.stop.ip4.as_u32);
+  r->raddr_start = clib_net_to_host_u32 (p->raddr.start.ip4.as_u32);
+  r->raddr_stop = clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32);
+  r->lport_start = p->lport.start;
+  r->lport_stop = p->lport.stop;
+  r->rport_start = p->rport.start;
+  r->rport_stop = p->rport.stop;
+  r->protocol = p->protocol;
+  r->order = order;
+}
+
+/* Called while the policy is still in the pool */
+static void
+ipsec_spd_ip4_outbound_del (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_spd_ip4_lookup_t *lk = &spd->ip4_outbound_lookup;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+  clib_bihash_kv_16_8_t kv, value, other;
+  ipsec_policy_t *q;
+  u32 i, *qi;
+
+  if (ipsec_spd_ip4_policy_is_exact (p))
+    {
+      ipsec_spd_ip4_policy_key (p, &kv);
+      if (!lk->n_exact || clib_bihash_search_16_8 (&lk->exact, &kv, &value)
+	  || (u32) value.value != policy_index)
+	return;
+
+      /* a shadowed duplicate takes over, the first in walk order wins */
+      vec_foreach (qi, spd->ipv4_outbound_policies)
+      {
+	if (*qi == policy_index)
+	  continue;
+	q = pool_elt_at_index (spd->policies, *qi);
+	if (!ipsec_spd_ip4_policy_is_exact (q))
+	  continue;
+	ipsec_spd_ip4_policy_key (q, &other);
+	if (other.key[0] != kv.key[0] || other.key[1] != kv.key[1])
+	  continue;
+	kv.value = ipsec_spd_policy_order (q, *qi);
+	clib_bihash_add_del_16_8 (&lk->exact, &kv, 1 /* is_add */ );
+	return;
+      }
+
+      clib_bihash_add_del_16_8 (&lk->exact, &kv, 0 /* is_add */ );
+      lk->n_exact--;
+      return;
+    }
+
+  vec_foreach_index (i, lk->range_rules)
+    if ((u32) lk->range_rules[i].order == policy_index)
+    {
+      vec_delete (lk->range_rules, 1, i);
+      break;
+    }
+}
+
+static void
+ipsec_spd_ip4_inbound_protect_free (ipsec_spd_t * spd)
+{
+  u32 i;
+
+  vec_foreach_index (i, spd->ipv4_inbound_protect_spi_buckets)
+    vec_free (spd->ipv4_inbound_protect_spi_buckets[i]);
+  vec_free (spd->ipv4_inbound_protect_spi_buckets);
+  hash_free (spd->ipv4_inbound_protect_by_spi);
+}
+
+static void
+ipsec_spd_ip4_inbound_protect_add (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+  ipsec_sa_t *sa = pool_elt_at_index (im->sad, p->sa_index);
+  u64 order = ipsec_spd_policy_order (p, policy_index);
+  u32 bi, i, *b;
+  uword *bucket;
+
+  if (!spd->ipv4_inbound_protect_by_spi)
+    spd->ipv4_inbound_protect_by_spi = hash_create (0, sizeof (uword));
+
+  bucket = hash_get (spd->ipv4_inbound_protect_by_spi, sa->spi);
+  if (bucket)
+    bi = bucket[0];
+  else
+    {
+      bi = vec_len (spd->ipv4_inbound_protect_spi_buckets);
+      vec_validate (spd->ipv4_inbound_protect_spi_buckets, bi);
+      hash_set (spd->ipv4_inbound_protect_by_spi, sa->spi, bi);
+    }
+
+  /* keep each bucket in walk order */
+  b = spd->ipv4_inbound_protect_spi_buckets[bi];
+  i = vec_len (b);
+  while (i > 0 && ipsec_spd_policy_order (pool_elt_at_index (spd->policies,
+							     b[i - 1]),
+					  b[i - 1]) > order)
+    i--;
+  vec_insert (b, 1, i);
+  b[i] = policy_index;
+  spd->ipv4_inbound_protect_spi_buckets[bi] = b;
+}
+
+static void
+ipsec_spd_ip4_inbound_protect_del (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+  ipsec_sa_t *sa = pool_elt_at_index (im->sad, p->sa_index);
+  uword *bucket;
+  u32 i, *b;
+
+  bucket = hash_get (spd->ipv4_inbound_protect_by_spi, sa->spi);
+  if (!bucket)
+    return;
+
+  b = spd->ipv4_inbound_protect_spi_buckets[bucket[0]];
+  vec_foreach_index (i, b)
+    if (b[i] == policy_index)
+    {
+      vec_delete (b, 1, i);
+      break;
+    }
+}
+
+/*
+ * Called, with the worker barrier held, once a policy has been added
+ * to the SPD's policy vectors.
+ */
+void
+ipsec_spd_lookup_add_policy (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+
+  if (p->is_ipv6)
+    return;
+
+  if (p->is_outbound)
+    ipsec_spd_ip4_outbound_add (spd, policy_index);
+  else if (p->policy == IPSEC_POLICY_ACTION_PROTECT)
+    ipsec_spd_ip4_inbound_protect_add (spd, policy_index);
+  else
+    return;
+
+  /* every cached flow decision is now suspect */
+  im->spd_epoch++;
+}
+
+/*
+ * Called, with the worker barrier held, once a policy has been removed
+ * from the SPD's policy vectors but before it is returned to the pool.
+ */
+void
+ipsec_spd_lookup_del_policy (ipsec_spd_t * spd, u32 policy_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *p = pool_elt_at_index (spd->policies, policy_index);
+
+  if (p->is_ipv6)
+    return;
+
+  if (p->is_outbound)
+    ipsec_spd_ip4_outbound_del (spd, policy_index);
+  else if (p->policy == IPSEC_POLICY_ACTION_PROTECT)
+    ipsec_spd_ip4_inbound_protect_del (spd, policy_index);
+  else
+    return;
+
+  im->spd_epoch++;
+}
+
+/*
+ * Recreate the lookup from the policy vectors, for when they have been
+ * filled in wholesale rather than through ipsec_add_del_policy ().
+ */
+void
+ipsec_spd_lookup_rebuild (ipsec_spd_t * spd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  u32 *i;
+
+  ipsec_spd_ip4_outbound_lookup_free (&spd->ip4_outbound_lookup);
+  ipsec_spd_ip4_inbound_protect_free (spd);
+
+  vec_foreach (i, spd->ipv4_outbound_policies)
+    ipsec_spd_ip4_outbound_add (spd, *i);
+  vec_foreach (i, spd->ipv4_inbound_protect_policy_indices)
+    ipsec_spd_ip4_inbound_protect_add (spd, *i);
+
+  im->spd_epoch++;
+}
+
+void
+ipsec_spd_lookup_free (ipsec_spd_t * spd)
+{
+  ipsec_main_t *im = &ipsec_main;
+
+  ipsec_spd_ip4_outbound_lookup_free (&spd->ip4_outbound_lookup);
+  ipsec_spd_ip4_inbound_protect_free (spd);
+  im->spd_epoch++;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
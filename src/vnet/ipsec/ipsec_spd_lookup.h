@@ -0,0 +1,253 @@
+/*
+ * ipsec_spd_lookup.h : classified IPSec SPD lookup
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IPSEC_SPD_LOOKUP_H__
+#define __IPSEC_SPD_LOOKUP_H__
+
+#include <vppinfra/xxhash.h>
+#include <vnet/ipsec/ipsec.h>
+
+/*
+ * The SPD policy vectors are sorted by priority, so the first policy a
+ * linear walk hits is the answer. The classified lookup returns exactly
+ * that policy:
+ *
+ *  - fully specified policies go in a 5-tuple bihash, which hands back
+ *    the order (see ipsec_spd_policy_order) of the best exact match;
+ *  - everything else is a range rule, walked in order, but only as
+ *    far as the exact match: nothing after it can win;
+ *  - the outcome, including "no match", is remembered in a small per
+ *    thread flow cache, invalidated wholesale by bumping the SPD epoch.
+ *
+ * Inbound protect policies can only match packets carrying their SA's
+ * SPI, so they are simply bucketed by SPI.
+ *
+ * Adding or deleting a policy touches only its own entry; nothing is
+ * keyed by position, so the rest of the SPD is left alone.
+ */
+
+/*
+ * Where a policy sits in the linear walk: higher priority first, ties
+ * broken by policy index. The policy index is the low 32 bits.
+ */
+always_inline u64
+ipsec_spd_policy_order (ipsec_policy_t * p, u32 policy_index)
+{
+  return ((u64) ((u32) p->priority ^ 0x7fffffff) << 32) | policy_index;
+}
+
+always_inline int
+ipsec_spd_proto_has_ports (u8 pr)
+{
+  return (pr == IP_PROTOCOL_TCP || pr == IP_PROTOCOL_UDP
+	  || pr == IP_PROTOCOL_SCTP);
+}
+
+always_inline void
+ipsec_spd_ip4_make_key (clib_bihash_kv_16_8_t * kv, u8 pr, u32 la, u32 ra,
+			u16 lp, u16 rp)
+{
+  kv->key[0] = ((u64) la << 32) | ra;
+  kv->key[1] = ((u64) pr << 32) | ((u32) lp << 16) | rp;
+}
+
+always_inline int
+ipsec_spd_ip4_range_rule_match (ipsec_spd_range_rule_t * r, u8 pr, u32 la,
+				u32 ra, u16 lp, u16 rp)
+{
+  if (PREDICT_FALSE (r->protocol && (r->protocol != pr)))
+    return 0;
+
+  if (ra < r->raddr_start || ra > r->raddr_stop)
+    return 0;
+
+  if (la < r->laddr_start || la > r->laddr_stop)
+    return 0;
+
+  if (PREDICT_FALSE (!ipsec_spd_proto_has_ports (pr)))
+    return 1;
+
+  if (lp < r->lport_start || lp > r->lport_stop)
+    return 0;
+
+  if (rp < r->rport_start || rp > r->rport_stop)
+    return 0;
+
+  return 1;
+}
+
+/*
+ * Returns the index into spd->policies of the highest priority match,
+ * or ~0. Addresses and ports in host byte order; ports are ignored
+ * unless pr is TCP, UDP or SCTP.
+ */
+always_inline u32
+ipsec_spd_ip4_outbound_classify (ipsec_spd_t * spd, u8 pr, u32 la, u32 ra,
+				 u16 lp, u16 rp)
+{
+  ipsec_spd_ip4_lookup_t *lk = &spd->ip4_outbound_lookup;
+  clib_bihash_kv_16_8_t kv;
+  ipsec_spd_range_rule_t *r;
+  u64 order = ~0ULL;
+
+  if (!ipsec_spd_proto_has_ports (pr))
+    lp = rp = 0;
+
+  if (lk->n_exact)
+    {
+      ipsec_spd_ip4_make_key (&kv, pr, la, ra, lp, rp);
+      if (!clib_bihash_search_16_8 (&lk->exact, &kv, &kv))
+	order = kv.value;
+    }
+
+  vec_foreach (r, lk->range_rules)
+  {
+    if (r->order > order)
+      break;
+    if (ipsec_spd_ip4_range_rule_match (r, pr, la, ra, lp, rp))
+      {
+	order = r->order;
+	break;
+      }
+  }
+
+  if (order == ~0ULL)
+    return ~0;
+
+  return (u32) order;
+}
+
+always_inline ipsec_policy_t *
+ipsec_spd_ip4_outbound_lookup (ipsec_main_t * im, u32 thread_index,
+			       ipsec_spd_t * spd, u8 pr, u32 la, u32 ra,
+			       u16 lp, u16 rp)
+{
+  ipsec_spd_flow_cache_entry_t *e;
+  u32 spd_index, policy_index;
+  u64 k0, k1;
+
+  if (!spd)
+    return 0;
+
+  if (!ipsec_spd_proto_has_ports (pr))
+    lp = rp = 0;
+
+  spd_index = spd - im->spds;
+  k0 = ((u64) la << 32) | ra;
+  k1 = ((u64) pr << 32) | ((u32) lp << 16) | rp;
+
+  e = vec_elt_at_index (im->ip4_outbound_flow_cache_by_thread[thread_index],
+			clib_xxhash (k0 ^ k1 ^ ((u64) spd_index << 48)) &
+			(IPSEC_SPD_FLOW_CACHE_SIZE - 1));
+
+  if (PREDICT_TRUE (e->epoch == im->spd_epoch && e->spd_index == spd_index
+		    && e->key[0] == k0 && e->key[1] == k1))
+    policy_index = e->policy_index;
+  else
+    {
+      policy_index = ipsec_spd_ip4_outbound_classify (spd, pr, la, ra,
+						      lp, rp);
+      e->key[0] = k0;
+      e->key[1] = k1;
+      e->spd_index = spd_index;
+      e->policy_index = policy_index;
+      e->epoch = im->spd_epoch;
+    }
+
+  if (policy_index == ~0)
+    return 0;
+
+  return pool_elt_at_index (spd->policies, policy_index);
+}
+
+/* The original walk; the reference the classified lookup must agree with */
+always_inline ipsec_policy_t *
+ipsec_spd_ip4_outbound_lookup_linear (ipsec_spd_t * spd, u8 pr, u32 la,
+				      u32 ra, u16 lp, u16 rp)
+{
+  ipsec_policy_t *p;
+  u32 *i;
+
+  if (!spd)
+    return 0;
+
+  vec_foreach (i, spd->ipv4_outbound_policies)
+  {
+    p = pool_elt_at_index (spd->policies, *i);
+    if (PREDICT_FALSE (p->protocol && (p->protocol != pr)))
+      continue;
+
+    if (ra < clib_net_to_host_u32 (p->raddr.start.ip4.as_u32))
+      continue;
+
+    if (ra > clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32))
+      continue;
+
+    if (la < clib_net_to_host_u32 (p->laddr.start.ip4.as_u32))
+      continue;
+
+    if (la > clib_net_to_host_u32 (p->laddr.stop.ip4.as_u32))
+      continue;
+
+    if (PREDICT_FALSE (!ipsec_spd_proto_has_ports (pr)))
+      return p;
+
+    if (lp < p->lport.start)
+      continue;
+
+    if (lp > p->lport.stop)
+      continue;
+
+    if (rp < p->rport.start)
+      continue;
+
+    if (rp > p->rport.stop)
+      continue;
+
+    return p;
+  }
+  return 0;
+}
+
+/*
+ * Inbound protect policies for an SPI, in priority order, or 0.
+ */
+always_inline u32 *
+ipsec_spd_ip4_inbound_protect_candidates (ipsec_spd_t * spd, u32 spi)
+{
+  uword *p;
+
+  p = hash_get (spd->ipv4_inbound_protect_by_spi, spi);
+  if (!p)
+    return 0;
+
+  return vec_elt (spd->ipv4_inbound_protect_spi_buckets, p[0]);
+}
+
+void ipsec_spd_lookup_add_policy (ipsec_spd_t * spd, u32 policy_index);
+void ipsec_spd_lookup_del_policy (ipsec_spd_t * spd, u32 policy_index);
+void ipsec_spd_lookup_rebuild (ipsec_spd_t * spd);
+void ipsec_spd_lookup_free (ipsec_spd_t * spd);
+
+#endif /* __IPSEC_SPD_LOOKUP_H__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,334 @@
+/*
+ * ipsec_spd_test.c : SPD lookup consistency test and benchmark
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/ipsec_spd_lookup.h>
+
+/* Well clear of anything a sane control plane would allocate */
+#define IPSEC_SPD_TEST_SPD_ID 0xfffffff0
+
+typedef struct
+{
+  u32 la, ra;
+  u16 lp, rp;
+  u8 pr;
+} ipsec_spd_test_pkt_t;
+
+typedef struct
+{
+  u32 seed;
+  u32 n_packets;
+  u32 iterations;
+  u32 exact_percent;
+} ipsec_spd_test_args_t;
+
+static ipsec_spd_t *ipsec_spd_test_spd;
+
+/* Keeps the compiler from optimizing the timed lookups away */
+static volatile uword ipsec_spd_test_sink;
+
+static int
+ipsec_spd_test_sort (void *a1, void *a2)
+{
+  ipsec_policy_t *p1, *p2;
+  u64 o1, o2;
+
+  p1 = pool_elt_at_index (ipsec_spd_test_spd->policies, *(u32 *) a1);
+  p2 = pool_elt_at_index (ipsec_spd_test_spd->policies, *(u32 *) a2);
+  o1 = ipsec_spd_policy_order (p1, *(u32 *) a1);
+  o2 = ipsec_spd_policy_order (p2, *(u32 *) a2);
+
+  return (o1 > o2) - (o1 < o2);
+}
+
+static u8
+ipsec_spd_test_protocol (u32 * seed)
+{
+  static u8 protocols[] = { IP_PROTOCOL_TCP, IP_PROTOCOL_UDP,
+    IP_PROTOCOL_ICMP, 0
+  };
+  return protocols[random_u32 (seed) % ARRAY_LEN (protocols)];
+}
+
+static void
+ipsec_spd_test_populate (ipsec_spd_t * spd, u32 n_policies,
+			 ipsec_spd_test_args_t * a)
+{
+  ipsec_policy_t *p;
+  u32 i, la, ra, len;
+
+  for (i = 0; i < n_policies; i++)
+    {
+      pool_get (spd->policies, p);
+      memset (p, 0, sizeof (*p));
+
+      p->id = spd->id;
+      p->is_outbound = 1;
+      /* few distinct priorities, so ties are exercised too */
+      p->priority = random_u32 (&a->seed) % 64;
+      p->policy = (random_u32 (&a->seed) & 1) ?
+	IPSEC_POLICY_ACTION_BYPASS : IPSEC_POLICY_ACTION_DISCARD;
+
+      la = 0x0a000000 | (random_u32 (&a->seed) & 0xffff);
+      ra = 0xac100000 | (random_u32 (&a->seed) & 0xffff);
+
+      if ((random_u32 (&a->seed) % 100) < a->exact_percent)
+	{
+	  p->protocol = ipsec_spd_test_protocol (&a->seed) ? :
+	    IP_PROTOCOL_TCP;
+	  p->laddr.start.ip4.as_u32 = p->laddr.stop.ip4.as_u32 =
+	    clib_host_to_net_u32 (la);
+	  p->raddr.start.ip4.as_u32 = p->raddr.stop.ip4.as_u32 =
+	    clib_host_to_net_u32 (ra);
+	  p->lport.start = p->lport.stop = random_u32 (&a->seed) & 0xff;
+	  p->rport.start = p->rport.stop = random_u32 (&a->seed) & 0xff;
+	}
+      else
+	{
+	  p->protocol = ipsec_spd_test_protocol (&a->seed);
+	  len = 8 + random_u32 (&a->seed) % 8;
+	  la &= ~pow2_mask (len);
+	  p->laddr.start.ip4.as_u32 = clib_host_to_net_u32 (la);
+	  p->laddr.stop.ip4.as_u32 =
+	    clib_host_to_net_u32 (la | pow2_mask (len));
+	  len = 8 + random_u32 (&a->seed) % 8;
+	  ra &= ~pow2_mask (len);
+	  p->raddr.start.ip4.as_u32 = clib_host_to_net_u32 (ra);
+	  p->raddr.stop.ip4.as_u32 =
+	    clib_host_to_net_u32 (ra | pow2_mask (len));
+	  p->lport.start = random_u32 (&a->seed) & 0xff;
+	  p->lport.stop = p->lport.start + (random_u32 (&a->seed) & 0x3f);
+	  p->rport.start = 0;
+	  p->rport.stop = 0xffff;
+	}
+
+      vec_add1 (spd->ipv4_outbound_policies, p - spd->policies);
+    }
+
+  ipsec_spd_test_spd = spd;
+  vec_sort_with_function (spd->ipv4_outbound_policies, ipsec_spd_test_sort);
+}
+
+/*
+ * Half the packets are drawn from the policies' selectors, the rest
+ * are random and mostly miss.
+ */
+static ipsec_spd_test_pkt_t *
+ipsec_spd_test_packets (ipsec_spd_t * spd, ipsec_spd_test_args_t * a)
+{
+  ipsec_spd_test_pkt_t *pkts = 0, *pkt;
+  ipsec_policy_t *p;
+  u32 i, n, la, ra;
+
+  vec_validate (pkts, a->n_packets - 1);
+
+  for (i = 0; i < a->n_packets; i++)
+    {
+      pkt = vec_elt_at_index (pkts, i);
+      if (i & 1)
+	{
+	  pkt->la = 0x0a000000 | (random_u32 (&a->seed) & 0xffff);
+	  pkt->ra = 0xac100000 | (random_u32 (&a->seed) & 0xffff);
+	  pkt->lp = random_u32 (&a->seed) & 0xff;
+	  pkt->rp = random_u32 (&a->seed) & 0xff;
+	  pkt->pr = ipsec_spd_test_protocol (&a->seed) ? : IP_PROTOCOL_UDP;
+	  continue;
+	}
+
+      n = random_u32 (&a->seed) % vec_len (spd->ipv4_outbound_policies);
+      p = pool_elt_at_index (spd->policies,
+			     spd->ipv4_outbound_policies[n]);
+      la = clib_net_to_host_u32 (p->laddr.start.ip4.as_u32);
+      ra = clib_net_to_host_u32 (p->raddr.start.ip4.as_u32);
+      pkt->la = la + random_u32 (&a->seed) %
+	(clib_net_to_host_u32 (p->laddr.stop.ip4.as_u32) - la + 1);
+      pkt->ra = ra + random_u32 (&a->seed) %
+	(clib_net_to_host_u32 (p->raddr.stop.ip4.as_u32) - ra + 1);
+      pkt->lp = p->lport.start + random_u32 (&a->seed) %
+	(p->lport.stop - p->lport.start + 1);
+      pkt->rp = p->rport.start + random_u32 (&a->seed) %
+	(p->rport.stop - p->rport.start + 1);
+      pkt->pr = p->protocol ? : IP_PROTOCOL_TCP;
+    }
+
+  return pkts;
+}
+
+static int
+ipsec_spd_test_one (vlib_main_t * vm, u32 n_policies,
+		    ipsec_spd_test_args_t * a)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_test_pkt_t *pkts, *pkt;
+  ipsec_policy_t *p0, *p1, *p2;
+  f64 t0, t_linear, t_classify, t_cached;
+  u32 i, n_hits = 0, n_bad = 0;
+  ipsec_spd_t *spd;
+  uword *p, sink = 0;
+  int rv;
+
+  rv = ipsec_add_del_spd (vm, IPSEC_SPD_TEST_SPD_ID, 1 /* is_add */ );
+  if (rv)
+    return rv;
+
+  p = hash_get (im->spd_index_by_spd_id, IPSEC_SPD_TEST_SPD_ID);
+  spd = pool_elt_at_index (im->spds, p[0]);
+
+  ipsec_spd_test_populate (spd, n_policies, a);
+  ipsec_spd_lookup_rebuild (spd);
+  pkts = ipsec_spd_test_packets (spd, a);
+
+  /* The classified lookup must agree with the walk, cached or not */
+  vec_foreach (pkt, pkts)
+  {
+    p0 = ipsec_spd_ip4_outbound_lookup_linear (spd, pkt->pr, pkt->la,
+					       pkt->ra, pkt->lp, pkt->rp);
+    p1 = ipsec_spd_ip4_outbound_lookup (im, vm->thread_index, spd, pkt->pr,
+					pkt->la, pkt->ra, pkt->lp, pkt->rp);
+    p2 = ipsec_spd_ip4_outbound_lookup (im, vm->thread_index, spd, pkt->pr,
+					pkt->la, pkt->ra, pkt->lp, pkt->rp);
+    n_hits += (p0 != 0);
+    if (p0 != p1 || p0 != p2)
+      {
+	u32 la = clib_host_to_net_u32 (pkt->la);
+	u32 ra = clib_host_to_net_u32 (pkt->ra);
+
+	if (n_bad++ < 5)
+	  vlib_cli_output (vm, "mismatch: %U:%u -> %U:%u proto %u, "
+			   "linear %d classified %d cached %d",
+			   format_ip4_address, &la, pkt->lp,
+			   format_ip4_address, &ra, pkt->rp, pkt->pr,
+			   p0 ? p0 - spd->policies : -1,
+			   p1 ? p1 - spd->policies : -1,
+			   p2 ? p2 - spd->policies : -1);
+      }
+  }
+
+  t0 = vlib_time_now (vm);
+  for (i = 0; i < a->iterations; i++)
+    vec_foreach (pkt, pkts)
+      sink += pointer_to_uword
+      (ipsec_spd_ip4_outbound_lookup_linear (spd, pkt->pr, pkt->la,
+					     pkt->ra, pkt->lp, pkt->rp));
+  t_linear = vlib_time_now (vm) - t0;
+
+  t0 = vlib_time_now (vm);
+  for (i = 0; i < a->iterations; i++)
+    vec_foreach (pkt, pkts)
+      sink += ipsec_spd_ip4_outbound_classify (spd, pkt->pr, pkt->la,
+					       pkt->ra, pkt->lp, pkt->rp);
+  t_classify = vlib_time_now (vm) - t0;
+
+  t0 = vlib_time_now (vm);
+  for (i = 0; i < a->iterations; i++)
+    vec_foreach (pkt, pkts)
+      sink += pointer_to_uword
+      (ipsec_spd_ip4_outbound_lookup (im, vm->thread_index, spd, pkt->pr,
+				      pkt->la, pkt->ra, pkt->lp, pkt->rp));
+  t_cached = vlib_time_now (vm) - t0;
+  ipsec_spd_test_sink = sink;
+
+  vlib_cli_output (vm, "%8u %7u %6u %8u %12.1f %12.1f %12.1f%s",
+		   n_policies, vec_len (spd->ip4_outbound_lookup.range_rules),
+		   n_hits, vec_len (pkts),
+		   1e9 * t_linear / (a->iterations * vec_len (pkts)),
+		   1e9 * t_classify / (a->iterations * vec_len (pkts)),
+		   1e9 * t_cached / (a->iterations * vec_len (pkts)),
+		   n_bad ? " FAILED" : "");
+
+  vec_free (pkts);
+  ipsec_add_del_spd (vm, IPSEC_SPD_TEST_SPD_ID, 0 /* is_add */ );
+
+  return n_bad ? -1 : 0;
+}
+
+static clib_error_t *
+ipsec_spd_test_command_fn (vlib_main_t * vm,
+			   unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  ipsec_spd_test_args_t _a, *a = &_a;
+  u32 n, min = 10, max = 100000;
+  int rv = 0;
+
+  memset (a, 0, sizeof (*a));
+  a->seed = 0xdaba0000;
+  a->n_packets = 4096;
+  a->iterations = 1;
+  a->exact_percent = 90;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "min %u", &min))
+	;
+      else if (unformat (input, "max %u", &max))
+	;
+      else if (unformat (input, "packets %u", &a->n_packets))
+	;
+      else if (unformat (input, "iterations %u", &a->iterations))
+	;
+      else if (unformat (input, "exact %u", &a->exact_percent))
+	;
+      else if (unformat (input, "seed %u", &a->seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!min || min > max || !a->n_packets || !a->iterations)
+    return clib_error_return (0, "bad parameters");
+
+  vlib_cli_output (vm, "seed %u, %u%% exact policies, ns per lookup:",
+		   a->seed, a->exact_percent);
+  vlib_cli_output (vm, "%8s %7s %6s %8s %12s %12s %12s", "policies",
+		   "ranges", "hits", "packets", "linear", "classified",
+		   "cached");
+
+  for (n = min; n <= max && !rv; n *= 10)
+    rv = ipsec_spd_test_one (vm, n, a);
+
+  if (rv)
+    return clib_error_return (0, "SPD lookup test failed");
+  return 0;
+}
+
+/*?
+ * Check the classified SPD lookup against the linear policy walk, and
+ * time both, on outbound SPDs of increasing size (min, min * 10, ...,
+ * max policies).
+ *
+ * @cliexpar
+ * @cliexcmd{test ipsec spd-lookup min 10 max 100000 packets 4096}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ipsec_spd_test_command, static) =
+{
+  .path = "test ipsec spd-lookup",
+  .short_help = "test ipsec spd-lookup [min <n>] [max <n>] [packets <n>] "
+    "[iterations <n>] [exact <percent>] [seed <n>]",
+  .function = ipsec_spd_test_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
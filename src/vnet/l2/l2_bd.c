@@ -85,6 +85,16 @@ bd_add_bd_index (bd_main_t * bdm, u32 bd_id)
 
   vec_validate (l2input_main.bd_configs, rv);
   l2input_main.bd_configs[rv].bd_id = bd_id;
+  l2input_main.bd_configs[rv].learn_rate_limit = 0;
+
+  /* Counters of a reused index start from zero */
+#define _(sym,str)							\
+  vlib_validate_simple_counter						\
+    (&l2learn_main.bd_counters[L2LEARN_BD_COUNTER_##sym], rv);		\
+  vlib_zero_simple_counter						\
+    (&l2learn_main.bd_counters[L2LEARN_BD_COUNTER_##sym], rv);
+  foreach_l2learn_bd_counter
+#undef _
 
   return rv;
 }
@@ -299,6 +309,20 @@ bd_set_mac_age (vlib_main_t * vm, u32 bd_index, u8 age)
 			     L2_MAC_AGE_PROCESS_EVENT_STOP, 0);
 }
 
+/**
+    Set the learn rate limit for the bridge domain, in MACs per second
+    learned or moved on each thread. Zero means no limit.
+*/
+void
+bd_set_learn_rate (vlib_main_t * vm, u32 bd_index, u32 rate)
+{
+  l2_bridge_domain_t *bd_config;
+
+  vec_validate (l2input_main.bd_configs, bd_index);
+  bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+  bd_config->learn_rate_limit = rate;
+}
+
 /**
     Set the tag for the bridge domain.
 */
@@ -697,6 +721,69 @@ VLIB_CLI_COMMAND (bd_mac_age_cli, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+bd_learn_rate (vlib_main_t * vm,
+	       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  bd_main_t *bdm = &bd_main;
+  clib_error_t *error = 0;
+  u32 bd_index, bd_id;
+  u32 rate;
+  uword *p;
+
+  if (!unformat (input, "%d", &bd_id))
+    {
+      error = clib_error_return (0, "expecting bridge-domain id but got `%U'",
+				 format_unformat_error, input);
+      goto done;
+    }
+
+  if (bd_id == 0)
+    return clib_error_return (0,
+			      "No operations on the default bridge domain are supported");
+
+  p = hash_get (bdm->bd_index_by_bd_id, bd_id);
+
+  if (p == 0)
+    return clib_error_return (0, "No such bridge domain %d", bd_id);
+
+  bd_index = p[0];
+
+  if (!unformat (input, "%u", &rate))
+    {
+      error =
+	clib_error_return (0, "expecting MACs per second but got `%U'",
+			   format_unformat_error, input);
+      goto done;
+    }
+
+  bd_set_learn_rate (vm, bd_index, rate);
+
+done:
+  return error;
+}
+
+/*?
+ * Limit the rate at which MACs are learned or moved in a bridge-domain,
+ * e.g. to protect the MAC table from a MAC flood or a forwarding loop.
+ * The limit applies to each worker thread separately. Packets from MACs
+ * which are not learned are still forwarded. The limit is off by default.
+ *
+ * @cliexpar
+ * Example of how to limit learning to 1000 MACs per second per thread
+ * (where 200 is the bridge-domain-id):
+ * @cliexcmd{set bridge-domain learn-rate 200 1000}
+ * Example of how to remove the limit (where 200 is the bridge-domain-id):
+ * @cliexcmd{set bridge-domain learn-rate 200 0}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (bd_learn_rate_cli, static) = {
+  .path = "set bridge-domain learn-rate",
+  .short_help = "set bridge-domain learn-rate <bridge-domain-id> <macs-per-sec>",
+  .function = bd_learn_rate,
+};
+/* *INDENT-ON* */
+
 /*?
  * Modify whether or not an existing bridge-domain should terminate and respond
  * to ARP Requests. ARP Termination is disabled by default.
@@ -1085,6 +1172,22 @@ bd_show (vlib_main_t * vm, unformat_input_t * input, vlib_cli_command_t * cmd)
 	      vlib_cli_output (vm, "\n  BD-Tag: %s", bd_config->bd_tag);
 
 	    }
+
+	  if (detail)
+	    {
+	      if (bd_config->learn_rate_limit)
+		vlib_cli_output (vm, "\n  Learn rate limit: %u/s per thread",
+				 bd_config->learn_rate_limit);
+	      else
+		vlib_cli_output (vm, "\n  Learn rate limit: off");
+#define _(sym,str)							\
+	      vlib_cli_output (vm, "  MACs %s: %llu", str,		\
+			       vlib_get_simple_counter			\
+			       (&l2learn_main.bd_counters		\
+				[L2LEARN_BD_COUNTER_##sym], bd_index));
+	      foreach_l2learn_bd_counter
+#undef _
+	    }
 	}
     }
   vec_free (as);
@@ -91,6 +91,9 @@ typedef struct
   /* sequence number for bridge domain based flush of MACs */
   u8 seq_num;
 
+  /* max MACs learned or moved per second on each thread, 0 = no limit */
+  u32 learn_rate_limit;
+
   /* Bridge domain tag (C string NULL terminated) */
   u8 *bd_tag;
 
@@ -137,6 +140,7 @@ u32 bd_remove_member (l2_bridge_domain_t * bd_config, u32 sw_if_index);
 
 u32 bd_set_flags (vlib_main_t * vm, u32 bd_index, u32 flags, u32 enable);
 void bd_set_mac_age (vlib_main_t * vm, u32 bd_index, u8 age);
+void bd_set_learn_rate (vlib_main_t * vm, u32 bd_index, u32 rate);
 int bd_add_del (l2_bridge_domain_add_del_args_t * args);
 
 /**
@@ -959,19 +959,25 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
+/*
+ * Scan n_buckets buckets from first_bucket, sending MAC events and, unless
+ * event_only, aging out MACs. Learned entries left are added to
+ * learn_count.
+ */
 static_always_inline f64
-l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
+l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only,
+	    u32 first_bucket, u32 n_buckets, u32 * learn_count)
 {
   l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
 
   BVT (clib_bihash) * h = &fm->mac_table;
   int i, j, k;
+  u32 last_bucket = first_bucket + n_buckets;
   f64 last_start = start_time;
   f64 accum_t = 0;
   f64 delta_t = 0;
   u32 evt_idx = 0;
-  u32 learn_count = 0;
   u32 client = lm->client_pid;
   u32 cl_idx = lm->client_index;
   vl_api_l2_macs_event_t *mp = 0;
@@ -983,7 +989,9 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       reg = vl_api_client_index_to_registration (lm->client_index);
     }
 
-  for (i = 0; i < h->nbuckets; i++)
+  ASSERT (last_bucket <= h->nbuckets);
+
+  for (i = first_bucket; i < last_bucket; i++)
     {
       /* allow no more than 20us without a pause */
       delta_t = vlib_time_now (vm) - last_start;
@@ -994,7 +1002,7 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	  accum_t += delta_t;
 	}
 
-      if (i < (h->nbuckets - 3))
+      if (i < (last_bucket - 3))
 	{
 	  BVT (clib_bihash_bucket) * b = &h->buckets[i + 3];
 	  CLIB_PREFETCH (b, CLIB_CACHE_LINE_BYTES, LOAD);
@@ -1022,7 +1030,7 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      l2fib_entry_result_t result = {.raw = v->kvp[k].value };
 
 	      if (result.fields.age_not == 0)
-		learn_count++;
+		(*learn_count)++;
 
 	      if (client)
 		{
@@ -1102,15 +1110,15 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      BVT (clib_bihash_kv) kv;
 	      kv.key = key.raw;
 	      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
-	      learn_count--;
+	      (*learn_count)--;
+	      vlib_increment_simple_counter
+		(&lm->bd_counters[L2LEARN_BD_COUNTER_AGE], vm->thread_index,
+		 bd_index, 1);
 	    }
 	  v++;
 	}
     }
 
-  /* keep learn count consistent */
-  l2learn_main.global_learn_count = learn_count;
-
   if (mp)
     {
       /*  send any outstanding mac event message else free message buffer */
@@ -1135,6 +1143,57 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
   return delta_t + accum_t;
 }
 
+/* Scan the whole table, restarting the ager from the first bucket */
+static f64
+l2fib_scan_all (vlib_main_t * vm, f64 start_time, u8 event_only)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  u32 learn_count = 0;
+  f64 t;
+
+  t = l2fib_scan (vm, start_time, event_only, 0, fm->mac_table.nbuckets,
+		  &learn_count);
+
+  /* keep learn count consistent */
+  l2learn_main.global_learn_count = learn_count;
+
+  if (!event_only)
+    {
+      fm->age_scan_bucket = 0;
+      fm->age_scan_learn_count = 0;
+      fm->age_scan_time = 0;
+    }
+  return t;
+}
+
+/*
+ * Age the next slice of buckets and return the number scanned. The learn
+ * count and the scan time are updated when the ager wraps around.
+ */
+static u32
+l2fib_scan_slice (vlib_main_t * vm, f64 start_time)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  u32 nbuckets = fm->mac_table.nbuckets;
+  u32 n;
+
+  n = clib_min (L2FIB_AGE_SCAN_SLICE_BUCKETS, nbuckets - fm->age_scan_bucket);
+  fm->age_scan_time += l2fib_scan (vm, start_time, 0, fm->age_scan_bucket,
+				   n, &fm->age_scan_learn_count);
+  fm->age_scan_bucket += n;
+
+  if (fm->age_scan_bucket >= nbuckets)
+    {
+      /* keep learn count consistent */
+      l2learn_main.global_learn_count = fm->age_scan_learn_count;
+      fm->age_scan_duration = fm->age_scan_time;
+      fm->age_scan_bucket = 0;
+      fm->age_scan_learn_count = 0;
+      fm->age_scan_time = 0;
+    }
+  return n;
+}
+
 static uword
 l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 			       vlib_frame_t * f)
@@ -1144,6 +1203,7 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
   l2learn_main_t *lm = &l2learn_main;
   bool enabled = 0;
   f64 start_time, next_age_scan_time = CLIB_TIME_MAX;
+  u32 n_scanned;
 
   while (1)
     {
@@ -1162,13 +1222,17 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 
       start_time = vlib_time_now (vm);
       enum
-      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      { SCAN_MAC_AGE, SCAN_MAC_AGE_SLICE, SCAN_MAC_EVENT,
+	SCAN_DISABLE
+      } scan = SCAN_MAC_AGE;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
 	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  else
+	    scan = SCAN_MAC_AGE_SLICE;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1187,12 +1251,20 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	  ASSERT (0);
 	}
 
+      /*
+       * Start and one pass requests scan the whole table at once. Periodic
+       * aging scans a slice at a time, so the scanner does a bounded amount
+       * of work each time it runs.
+       */
       if (scan == SCAN_MAC_EVENT)
-	l2fib_main.evt_scan_duration = l2fib_scan (vm, start_time, 1);
+	l2fib_main.evt_scan_duration = l2fib_scan_all (vm, start_time, 1);
       else
 	{
+	  n_scanned = fm->mac_table.nbuckets;
 	  if (scan == SCAN_MAC_AGE)
-	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
+	    l2fib_main.age_scan_duration = l2fib_scan_all (vm, start_time, 0);
+	  if (scan == SCAN_MAC_AGE_SLICE)
+	    n_scanned = l2fib_scan_slice (vm, start_time);
 	  if (scan == SCAN_DISABLE)
 	    {
 	      l2fib_main.age_scan_duration = 0;
@@ -1200,7 +1272,8 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	    }
 	  /* schedule next scan */
 	  if (enabled)
-	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL;
+	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL *
+	      n_scanned / fm->mac_table.nbuckets;
 	  else
 	    next_age_scan_time = CLIB_TIME_MAX;
 	}
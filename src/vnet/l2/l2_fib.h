@@ -30,6 +30,12 @@
 /* Ager scan interval is 1 minute for aging */
 #define L2FIB_AGE_SCAN_INTERVAL		(60.0)
 
+/*
+ * Buckets visited per ager run. The interval is spread over the
+ * slices, so every bucket is still scanned once a minute.
+ */
+#define L2FIB_AGE_SCAN_SLICE_BUCKETS	(1024)
+
 /* MAC event scan delay is 100 msec unless specified by MAC event client */
 #define L2FIB_EVENT_SCAN_DELAY_DEFAULT	(0.1)
 
@@ -52,6 +58,11 @@ typedef struct
   f64 evt_scan_duration;
   f64 age_scan_duration;
 
+  /* next bucket for the ager, with learned entries and time so far */
+  u32 age_scan_bucket;
+  u32 age_scan_learn_count;
+  f64 age_scan_time;
+
   /* delay between event scans, default to 100 msec */
   f64 event_scan_delay;
 
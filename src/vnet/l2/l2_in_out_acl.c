@@ -353,61 +353,39 @@ l2_in_out_acl_node_fn (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
+		  h0 = (void *) vlib_buffer_get_current (b0);
+		  e0 = vnet_classify_find_entry_chain (vcm, &t0, (u8 *) h0,
+						       (u8 *) h0, now);
+		  if (e0)
 		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
+		      vlib_buffer_advance (b0, e0->advance);
+		      next0 = (e0->next_index < ACL_NEXT_INDEX_N_NEXT) ?
+			e0->next_index : next0;
+		      hits++;
+		      chain_hits++;
+
+		      if (is_output)
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  L2_OUTACL_ERROR_SESSION_DENY : L2_OUTACL_ERROR_NONE;
 		      else
-			{
-			  next0 =
-			    (t0->miss_next_index <
-			     ACL_NEXT_INDEX_N_NEXT) ? t0->miss_next_index :
-			    next0;
-
-			  misses++;
-
-			  if (is_output)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      L2_OUTACL_ERROR_TABLE_MISS :
-			      L2_OUTACL_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      L2_INACL_ERROR_TABLE_MISS : L2_INACL_ERROR_NONE;
-			  b0->error = node->errors[error0];
-			  break;
-			}
-
-		      if (t0->current_data_flag ==
-			  CLASSIFY_FLAG_USE_CURR_DATA)
-			h0 =
-			  (void *) vlib_buffer_get_current (b0) +
-			  t0->current_data_offset;
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  L2_INACL_ERROR_SESSION_DENY : L2_INACL_ERROR_NONE;
+		      b0->error = node->errors[error0];
+		    }
+		  else
+		    {
+		      next0 = (t0->miss_next_index < ACL_NEXT_INDEX_N_NEXT) ?
+			t0->miss_next_index : next0;
+
+		      misses++;
+
+		      if (is_output)
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  L2_OUTACL_ERROR_TABLE_MISS : L2_OUTACL_ERROR_NONE;
 		      else
-			h0 = (void *) vlib_buffer_get_current (b0);
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 = vnet_classify_find_entry
-			(t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < ACL_NEXT_INDEX_N_NEXT) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-
-			  if (is_output)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      L2_OUTACL_ERROR_SESSION_DENY :
-			      L2_OUTACL_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      L2_INACL_ERROR_SESSION_DENY :
-			      L2_INACL_ERROR_NONE;
-			  b0->error = node->errors[error0];
-			  break;
-			}
+			error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+			  L2_INACL_ERROR_TABLE_MISS : L2_INACL_ERROR_NONE;
+		      b0->error = node->errors[error0];
 		    }
 		}
 	    }
@@ -45,6 +45,11 @@ l2learn_main_t l2learn_main;
  * differ in certain cases (mac move tests), but this not expected to cause
  * problems in real-world networks. It is much simpler to separate learning
  * and forwarding into separate nodes.
+ *
+ * Mac table updates are queued per thread and written in batches of up to
+ * L2LEARN_BATCH_SIZE, so the bihash writer lock is taken once per batch
+ * rather than once per learned mac. The queue is always written before the
+ * frame is passed on, so forwarding still sees every mac learned from it.
  */
 
 
@@ -80,6 +85,7 @@ _(MISS,              "L2 learn misses")			\
 _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
+_(RATE_LIMIT,        "L2 not learned due to rate limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
 _(FILTER_DROP,       "L2 filter mac drops")
 
@@ -105,23 +111,94 @@ typedef enum
 } l2learn_next_t;
 
 
+/** Find a mac table update queued earlier in the frame. */
+static_always_inline BVT (clib_bihash_kv) *
+l2learn_pending_find (l2learn_per_thread_data_t * ptd,
+		      l2fib_entry_key_t * key0)
+{
+  BVT (clib_bihash_kv) * kv;
+
+  vec_foreach (kv, ptd->pending)
+  {
+    if (kv->key == key0->raw)
+      return kv;
+  }
+  return 0;
+}
+
+/** Write the queued mac table updates. */
+static_always_inline void
+l2learn_flush (l2learn_main_t * msm, l2learn_per_thread_data_t * ptd)
+{
+  if (vec_len (ptd->pending) == 0)
+    return;
+
+  BV (clib_bihash_add_del_batch) (msm->mac_table, ptd->pending,
+				  vec_len (ptd->pending), 1 /* is_add */ );
+  vec_reset_length (ptd->pending);
+}
+
+/**
+ * Account a learned or moved mac against the bridge domain learn rate.
+ * Returns 0 if the rate limit was reached.
+ */
+static_always_inline int
+l2learn_rate_check (l2learn_main_t * msm, l2learn_per_thread_data_t * ptd,
+		    u32 thread_index, u32 bd_index)
+{
+  l2_bridge_domain_t *bd_config;
+  l2learn_bd_rate_t *rate;
+
+  bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+  if (PREDICT_TRUE (bd_config->learn_rate_limit == 0))
+    return 1;
+
+  vec_validate (ptd->bd_rates, bd_index);
+  rate = vec_elt_at_index (ptd->bd_rates, bd_index);
+  if (rate->second != ptd->now)
+    {
+      rate->second = ptd->now;
+      rate->count = 0;
+    }
+  if (rate->count >= bd_config->learn_rate_limit)
+    {
+      vlib_increment_simple_counter
+	(&msm->bd_counters[L2LEARN_BD_COUNTER_RATE_LIMIT], thread_index,
+	 bd_index, 1);
+      return 0;
+    }
+  rate->count++;
+  return 1;
+}
+
 /** Perform learning on one packet based on the mac table lookup result. */
 
 static_always_inline void
 l2learn_process (vlib_node_runtime_t * node,
 		 l2learn_main_t * msm,
+		 l2learn_per_thread_data_t * ptd,
+		 u32 thread_index,
 		 u64 * counter_base,
 		 vlib_buffer_t * b0,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result,
 		 u32 * count,
 		 l2fib_entry_result_t * result0, u32 * next0, u8 timestamp)
 {
+  BVT (clib_bihash_kv) * pending0 = 0;
+  u32 bd_index0 = vnet_buffer (b0)->l2.bd_index;
+
   /* Set up the default next node (typically L2FWD) */
   *next0 = vnet_l2_feature_next (b0, msm->feat_next_node_index,
 				 L2INPUT_FEAT_LEARN);
 
+  /* A queued update is newer than the mac table lookup result */
+  if (PREDICT_FALSE (vec_len (ptd->pending) != 0)
+      && (pending0 = l2learn_pending_find (ptd, key0)))
+    result0->raw = pending0->value;
+
   /* Check mac table lookup result */
   if (PREDICT_TRUE (result0->fields.sw_if_index == sw_if_index0))
     {
@@ -167,8 +244,17 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
+      if (!l2learn_rate_check (msm, ptd, thread_index, bd_index0))
+	{
+	  counter_base[L2LEARN_ERROR_RATE_LIMIT] += 1;
+	  return;
+	}
+
       /* It is ok to learn */
       msm->global_learn_count++;
+      vlib_increment_simple_counter
+	(&msm->bd_counters[L2LEARN_BD_COUNTER_LEARN], thread_index,
+	 bd_index0, 1);
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       result0->fields.lrn_evt = (msm->client_pid != 0);
@@ -196,10 +282,13 @@ l2learn_process (vlib_node_runtime_t * node,
 	  return;
 	}
 
-      /*
-       * TODO: may want to rate limit mac moves
-       * TODO: check global/bridge domain/interface learn limits
-       */
+      /* A mac flapping between ports counts against the learn rate */
+      if (!l2learn_rate_check (msm, ptd, thread_index, bd_index0))
+	{
+	  counter_base[L2LEARN_ERROR_RATE_LIMIT] += 1;
+	  return;
+	}
+
       result0->fields.sw_if_index = sw_if_index0;
       if (result0->fields.age_not)	/* The mac was provisioned */
 	{
@@ -209,19 +298,35 @@ l2learn_process (vlib_node_runtime_t * node,
       result0->fields.lrn_evt = (msm->client_pid != 0);
       result0->fields.lrn_mov = (msm->client_pid != 0);
       counter_base[L2LEARN_ERROR_MAC_MOVE] += 1;
+      vlib_increment_simple_counter
+	(&msm->bd_counters[L2LEARN_BD_COUNTER_MOVE], thread_index,
+	 bd_index0, 1);
     }
 
   /* Update the entry */
   result0->fields.timestamp = timestamp;
   result0->fields.sn.as_u16 = vnet_buffer (b0)->l2.l2fib_sn;
 
-  BVT (clib_bihash_kv) kv;
-  kv.key = key0->raw;
-  kv.value = result0->raw;
-  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+  if (pending0)
+    pending0->value = result0->raw;
+  else
+    {
+      vec_add2 (ptd->pending, pending0, 1);
+      pending0->key = key0->raw;
+      pending0->value = result0->raw;
+    }
 
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  if (vec_len (ptd->pending) >= L2LEARN_BATCH_SIZE)
+    {
+      l2learn_flush (msm, ptd);
+      /* The cache may hold a result older than the ones just written */
+      cached_key->raw = ~0;
+    }
+  else
+    {
+      cached_key->raw = key0->raw;
+      cached_result->raw = result0->raw;
+    }
 }
 
 
@@ -237,8 +342,14 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_error_main_t *em = &vm->error_main;
   l2fib_entry_key_t cached_key;
   l2fib_entry_result_t cached_result;
-  u8 timestamp = (u8) (vlib_time_now (vm) / 60);
+  f64 now = vlib_time_now (vm);
+  u8 timestamp = (u8) (now / 60);
   u32 count = 0;
+  u32 thread_index = vm->thread_index;
+  l2learn_per_thread_data_t *ptd;
+
+  ptd = vec_elt_at_index (msm->per_thread_data, thread_index);
+  ptd->now = (u32) now;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;	/* number of packets to process */
@@ -372,21 +483,29 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  &bucket0, &bucket1, &bucket2, &bucket3,
 			  &result0, &result1, &result2, &result3);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
+	  l2learn_process (node, msm, ptd, thread_index,
+			   &em->counters[node_counter_base_index],
 			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+			   &cached_result, &count, &result0, &next0,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
+	  l2learn_process (node, msm, ptd, thread_index,
+			   &em->counters[node_counter_base_index],
 			   b1, sw_if_index1, &key1, &cached_key,
-			   &count, &result1, &next1, timestamp);
+			   &cached_result, &count, &result1, &next1,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
+	  l2learn_process (node, msm, ptd, thread_index,
+			   &em->counters[node_counter_base_index],
 			   b2, sw_if_index2, &key2, &cached_key,
-			   &count, &result2, &next2, timestamp);
+			   &cached_result, &count, &result2, &next2,
+			   timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
+	  l2learn_process (node, msm, ptd, thread_index,
+			   &em->counters[node_counter_base_index],
 			   b3, sw_if_index3, &key3, &cached_key,
-			   &count, &result3, &next3, timestamp);
+			   &cached_result, &count, &result3, &next3,
+			   timestamp);
 
 	  /* verify speculative enqueues, maybe switch current next frame */
 	  /* if next0==next1==next_index then nothing special needs to be done */
@@ -439,9 +558,11 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  h0->src_address, vnet_buffer (b0)->l2.bd_index,
 			  &key0, &bucket0, &result0);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
+	  l2learn_process (node, msm, ptd, thread_index,
+			   &em->counters[node_counter_base_index],
 			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+			   &cached_result, &count, &result0, &next0,
+			   timestamp);
 
 	  /* verify speculative enqueue, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -452,6 +573,9 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  /* l2-fwd runs next, it must see the macs learned from this frame */
+  l2learn_flush (msm, ptd);
+
   return frame->n_vectors;
 }
 
@@ -503,6 +627,10 @@ VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
   /* init the hash table ptr */
   mp->mac_table = get_mac_table ();
 
+  vec_validate_aligned (mp->per_thread_data,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
   /*
    * Set the default number of dynamically learned macs to the number
    * of buckets.
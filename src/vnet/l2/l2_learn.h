@@ -22,6 +22,48 @@
 #include <vnet/ethernet/ethernet.h>
 
 
+/* Per bridge domain learning counters */
+#define foreach_l2learn_bd_counter		\
+_(LEARN, "learned")				\
+_(MOVE, "moved")				\
+_(RATE_LIMIT, "rate limited")			\
+_(AGE, "aged")
+
+typedef enum
+{
+#define _(sym,str) L2LEARN_BD_COUNTER_##sym,
+  foreach_l2learn_bd_counter
+#undef _
+    L2LEARN_N_BD_COUNTER,
+} l2learn_bd_counter_t;
+
+/* Per bridge domain learn rate, per worker thread */
+typedef struct
+{
+  u32 second;
+  u32 count;
+} l2learn_bd_rate_t;
+
+/*
+ * Mac table updates are queued by l2-learn and written with one
+ * writer lock acquisition per batch, rather than one per packet.
+ */
+#define L2LEARN_BATCH_SIZE 64
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Mac table updates not yet written */
+  BVT (clib_bihash_kv) * pending;
+
+  /* Learn rate per bridge domain, indexed by bd_index */
+  l2learn_bd_rate_t *bd_rates;
+
+  /* Time of the current frame, in seconds */
+  u32 now;
+} l2learn_per_thread_data_t;
+
 typedef struct
 {
 
@@ -41,6 +83,12 @@ typedef struct
   /* Next nodes for each feature */
   u32 feat_next_node_index[32];
 
+  /* Per thread batching and rate limit state */
+  l2learn_per_thread_data_t *per_thread_data;
+
+  /* Per bridge domain counters, indexed by bd_index */
+  vlib_simple_counter_main_t bd_counters[L2LEARN_N_BD_COUNTER];
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
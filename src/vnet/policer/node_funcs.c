@@ -713,42 +713,29 @@ policer_classify_inline (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
+		  e0 = vnet_classify_find_entry_chain (vcm, &t0, (u8 *) h0,
+						       0, now);
+		  if (e0)
 		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
+		      act0 = vnet_policer_police (vm,
+						  b0,
+						  e0->next_index,
+						  time_in_policer_periods,
+						  e0->opaque_index);
+		      if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
 			{
-			  t0 = pool_elt_at_index (vcm->tables,
-						  t0->next_table_index);
-			}
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  act0 = vnet_policer_police (vm,
-						      b0,
-						      e0->next_index,
-						      time_in_policer_periods,
-						      e0->opaque_index);
-			  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
-			    {
-			      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-			      b0->error =
-				node->errors[POLICER_CLASSIFY_ERROR_DROP];
-			      drop++;
-			    }
-			  hits++;
-			  chain_hits++;
-			  break;
+			  next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
+			  b0->error = node->errors[POLICER_CLASSIFY_ERROR_DROP];
+			  drop++;
 			}
+		      hits++;
+		      chain_hits++;
+		    }
+		  else
+		    {
+		      next0 = (t0->miss_next_index < n_next_nodes) ?
+			t0->miss_next_index : next0;
+		      misses++;
 		    }
 		}
 	    }
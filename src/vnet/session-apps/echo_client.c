@@ -67,7 +67,7 @@ send_data_chunk (echo_client_main_t * ecm, eclient_session_t * s)
 	      session_fifo_event_t evt;
 	      evt.fifo = f;
 	      evt.event_type = FIFO_EVENT_APP_TX;
-	      svm_queue_add (s->data.vpp_evt_q, (u8 *) & evt, 0);
+	      svm_ring_enqueue (s->data.vpp_evt_q, &evt, 0);
 	    }
 	}
       else
@@ -103,7 +103,7 @@ send_data_chunk (echo_client_main_t * ecm, eclient_session_t * s)
 	      session_fifo_event_t evt;
 	      evt.fifo = f;
 	      evt.event_type = FIFO_EVENT_APP_TX;
-	      svm_queue_add (s->data.vpp_evt_q, (u8 *) & evt, 0);
+	      svm_ring_enqueue (s->data.vpp_evt_q, &evt, 0);
 	    }
 	}
       else
@@ -462,15 +462,15 @@ echo_clients_rx_callback (stream_session_t * s)
   if (svm_fifo_max_dequeue (s->server_rx_fifo))
     {
       session_fifo_event_t evt;
-      svm_queue_t *q;
+      svm_ring_t *q;
       if (svm_fifo_set_event (s->server_rx_fifo))
 	{
 	  evt.fifo = s->server_rx_fifo;
 	  evt.event_type = FIFO_EVENT_BUILTIN_RX;
 	  q = session_manager_get_vpp_event_queue (s->thread_index);
-	  if (PREDICT_FALSE (q->cursize == q->maxsize))
+	  if (PREDICT_FALSE (svm_ring_is_full (q)))
 	    clib_warning ("out of event queue space");
-	  else if (svm_queue_add (q, (u8 *) & evt, 0))
+	  else if (svm_ring_enqueue (q, &evt, 0))
 	    clib_warning ("failed to enqueue self-tap");
 	}
     }
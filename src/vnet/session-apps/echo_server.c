@@ -23,7 +23,7 @@ typedef struct
   /*
    * Server app parameters
    */
-  svm_queue_t **vpp_queue;
+  svm_ring_t **vpp_queue;
   svm_queue_t *vl_input_queue;	/**< Sever's event queue */
 
   u32 app_index;		/**< Server app index */
@@ -148,7 +148,7 @@ echo_server_rx_callback (stream_session_t * s)
   session_fifo_event_t evt;
   u32 thread_index = vlib_get_thread_index ();
   app_session_transport_t at;
-  svm_queue_t *q;
+  svm_ring_t *q;
 
   ASSERT (s->thread_index == thread_index);
 
@@ -195,9 +195,9 @@ echo_server_rx_callback (stream_session_t * s)
 	  evt.event_type = FIFO_EVENT_BUILTIN_RX;
 
 	  q = esm->vpp_queue[s->thread_index];
-	  if (PREDICT_FALSE (q->cursize == q->maxsize))
+	  if (PREDICT_FALSE (svm_ring_is_full (q)))
 	    clib_warning ("out of event queue space");
-	  else if (svm_queue_add (q, (u8 *) & evt, 0))
+	  else if (svm_ring_enqueue (q, &evt, 0))
 	    clib_warning ("failed to enqueue self-tap");
 
 	  vec_validate (esm->rx_retries[s->thread_index], s->session_index);
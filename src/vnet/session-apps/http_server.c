@@ -32,7 +32,7 @@ typedef struct
 typedef struct
 {
   u8 **rx_buf;
-  svm_queue_t **vpp_queue;
+  svm_ring_t **vpp_queue;
   u64 byte_index;
 
   uword *handler_by_get_request;
@@ -176,8 +176,8 @@ send_data (stream_session_t * s, u8 * data)
 	      evt.fifo = s->server_tx_fifo;
 	      evt.event_type = FIFO_EVENT_APP_TX;
 
-	      svm_queue_add (hsm->vpp_queue[s->thread_index],
-			     (u8 *) & evt, 0 /* do wait for mutex */ );
+	      svm_ring_enqueue (hsm->vpp_queue[s->thread_index], &evt,
+				0 /* wait for space */ );
 	    }
 	  delay = 10e-3;
 	}
@@ -377,9 +377,9 @@ http_server_rx_callback (stream_session_t * s)
       evt.rpc_args.fp = alloc_http_process_callback;
       evt.rpc_args.arg = args;
       evt.event_type = FIFO_EVENT_RPC;
-      svm_queue_add
+      svm_ring_enqueue
 	(session_manager_get_vpp_event_queue (0 /* main thread */ ),
-	 (u8 *) & evt, 0 /* do wait for mutex */ );
+	 &evt, 0 /* wait for space */ );
     }
   else
     alloc_http_process (args);
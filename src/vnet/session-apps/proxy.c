@@ -214,8 +214,8 @@ proxy_rx_callback (stream_session_t * s)
 	  u32 ao_thread_index = active_open_tx_fifo->master_thread_index;
 	  evt.fifo = active_open_tx_fifo;
 	  evt.event_type = FIFO_EVENT_APP_TX;
-	  if (svm_queue_add (pm->active_open_event_queue[ao_thread_index],
-			     (u8 *) & evt, 0 /* do wait for mutex */ ))
+	  if (svm_ring_enqueue (pm->active_open_event_queue[ao_thread_index],
+				&evt, 0 /* wait for space */ ))
 	    clib_warning ("failed to enqueue tx evt");
 	}
     }
@@ -324,9 +324,9 @@ active_open_connected_callback (u32 app_index, u32 opaque,
     {
       evt.fifo = s->server_tx_fifo;
       evt.event_type = FIFO_EVENT_APP_TX;
-      if (svm_queue_add
-	  (pm->active_open_event_queue[thread_index], (u8 *) & evt,
-	   0 /* do wait for mutex */ ))
+      if (svm_ring_enqueue
+	  (pm->active_open_event_queue[thread_index], &evt,
+	   0 /* wait for space */ ))
 	clib_warning ("failed to enqueue tx evt");
     }
 
@@ -368,8 +368,8 @@ active_open_rx_callback (stream_session_t * s)
       u32 p_thread_index = proxy_tx_fifo->master_thread_index;
       evt.fifo = proxy_tx_fifo;
       evt.event_type = FIFO_EVENT_APP_TX;
-      if (svm_queue_add (pm->server_event_queue[p_thread_index], (u8 *) & evt,
-			 0 /* do wait for mutex */ ))
+      if (svm_ring_enqueue (pm->server_event_queue[p_thread_index], &evt,
+			    0 /* wait for space */ ))
 	clib_warning ("failed to enqueue server rx evt");
     }
 
@@ -185,6 +185,9 @@ application_del (application_t * app)
   if (CLIB_DEBUG > 1)
     clib_warning ("[%d] Delete app (%d)", getpid (), app->index);
 
+  /* Close the event queue eventfd, if the app asked for one */
+  svm_ring_set_eventfd (app->event_queue, -1);
+
   if (application_is_proxy (app))
     application_remove_proxy (app);
 
@@ -318,6 +321,11 @@ application_init (application_t * app, u32 api_client_index, u8 * app_name,
   if (!application_verify_cfg (seg_type))
     return VNET_API_ERROR_APP_UNSUPPORTED_CFG;
 
+  /* The event queue eventfd is passed over the api socket */
+  if ((options[APP_OPTIONS_FLAGS] & APP_OPTIONS_FLAGS_EVT_Q_USE_EVENTFD)
+      && seg_type != SSVM_SEGMENT_MEMFD)
+    return VNET_API_ERROR_APP_UNSUPPORTED_CFG;
+
   /*
    * Setup segment manager
    */
@@ -359,6 +367,9 @@ application_init (application_t * app, u32 api_client_index, u8 * app_name,
   app->local_connects = hash_create (0, sizeof (u64));
   app->proxied_transports = options[APP_OPTIONS_PROXY_TRANSPORT];
   app->event_queue = segment_manager_event_queue (sm);
+  if ((app->flags & APP_OPTIONS_FLAGS_EVT_Q_USE_EVENTFD)
+      && svm_ring_alloc_consumer_eventfd (app->event_queue) < 0)
+    return VNET_API_ERROR_SYSCALL_ERROR_1;
   app->name = vec_dup (app_name);
 
   /* If no scope enabled, default to global */
@@ -943,20 +954,21 @@ application_local_session_connect (u32 table_index, application_t * client,
 				   application_t * server,
 				   local_session_t * ll, u32 opaque)
 {
-  u32 seg_size, evt_q_sz, evt_q_elts, margin = 16 << 10;
+  u32 seg_size, evt_q_sz, margin = 16 << 10;
   segment_manager_properties_t *props, *cprops;
   int rv, has_transport, seg_index;
   svm_fifo_segment_private_t *seg;
   segment_manager_t *sm;
   local_session_t *ls;
-  svm_queue_t *sq, *cq;
+  svm_ring_t *sq, *cq;
 
   ls = application_alloc_local_session (server);
 
   props = application_segment_manager_properties (server);
   cprops = application_segment_manager_properties (client);
-  evt_q_elts = props->evt_q_size + cprops->evt_q_size;
-  evt_q_sz = evt_q_elts * sizeof (session_fifo_event_t);
+  evt_q_sz = svm_ring_size (props->evt_q_size, sizeof (session_fifo_event_t));
+  evt_q_sz += svm_ring_size (cprops->evt_q_size,
+			     sizeof (session_fifo_event_t));
   seg_size = props->rx_fifo_size + props->tx_fifo_size + evt_q_sz + margin;
 
   has_transport = session_has_transport ((stream_session_t *) ll);
@@ -72,8 +72,8 @@ typedef struct _application
   /** Namespace the application belongs to */
   u32 ns_index;
 
-  /** Application listens for events on this svm queue */
-  svm_queue_t *event_queue;
+  /** Application listens for events on this svm ring */
+  svm_ring_t *event_queue;
 
   /*
    * Callbacks: shoulder-taps for the server/client
@@ -138,7 +138,8 @@ typedef enum
   _(IS_BUILTIN, "Application is builtin")			\
   _(IS_PROXY, "Application is proxying")				\
   _(USE_GLOBAL_SCOPE, "App can use global session scope")	\
-  _(USE_LOCAL_SCOPE, "App can use local session scope")
+  _(USE_LOCAL_SCOPE, "App can use local session scope")		\
+  _(EVT_Q_USE_EVENTFD, "App sleeps on an eventfd for its event queue")
 
 typedef enum _app_options
 {
@@ -190,13 +191,13 @@ typedef struct app_session_
   volatile u8 session_state;		/**< session state */
   u32 session_index;			/**< index in owning pool */
   app_session_transport_t transport;	/**< transport info */
-  svm_queue_t *vpp_evt_q;		/**< vpp event queue for session */
+  svm_ring_t *vpp_evt_q;		/**< vpp event queue for session */
   u8 is_dgram;				/**< set if it works in dgram mode */
 } app_session_t;
 
 always_inline int
 app_send_dgram_raw (svm_fifo_t * f, app_session_transport_t * at,
-		    svm_queue_t * vpp_evt_q, u8 * data, u32 len, u8 noblock)
+		    svm_ring_t * vpp_evt_q, u8 * data, u32 len, u8 noblock)
 {
   u32 max_enqueue, actual_write;
   session_dgram_hdr_t hdr;
@@ -225,7 +226,7 @@ app_send_dgram_raw (svm_fifo_t * f, app_session_transport_t * at,
 	{
 	  evt.fifo = f;
 	  evt.event_type = FIFO_EVENT_APP_TX;
-	  svm_queue_add (vpp_evt_q, (u8 *) & evt, noblock);
+	  svm_ring_enqueue (vpp_evt_q, &evt, noblock);
 	}
     }
   ASSERT (rv);
@@ -240,7 +241,7 @@ app_send_dgram (app_session_t * s, u8 * data, u32 len, u8 noblock)
 }
 
 always_inline int
-app_send_stream_raw (svm_fifo_t * f, svm_queue_t * vpp_evt_q, u8 * data,
+app_send_stream_raw (svm_fifo_t * f, svm_ring_t * vpp_evt_q, u8 * data,
 		     u32 len, u8 noblock)
 {
   session_fifo_event_t evt;
@@ -252,7 +253,7 @@ app_send_stream_raw (svm_fifo_t * f, svm_queue_t * vpp_evt_q, u8 * data,
 	{
 	  evt.fifo = f;
 	  evt.event_type = FIFO_EVENT_APP_TX;
-	  svm_queue_add (vpp_evt_q, (u8 *) & evt, noblock);
+	  svm_ring_enqueue (vpp_evt_q, &evt, noblock);
 	}
     }
   return rv;
@@ -602,20 +602,19 @@ segment_manager_dealloc_fifos (u32 segment_index, svm_fifo_t * rx_fifo,
  *
  * Must be called with lock held
  */
-svm_queue_t *
+svm_ring_t *
 segment_manager_alloc_queue (svm_fifo_segment_private_t * segment,
 			     u32 queue_size)
 {
   ssvm_shared_header_t *sh;
-  svm_queue_t *q;
+  svm_ring_t *q;
   void *oldheap;
 
   sh = segment->ssvm.sh;
 
   oldheap = ssvm_push_heap (sh);
-  q = svm_queue_init (queue_size, sizeof (session_fifo_event_t),
-		      0 /* consumer pid */ ,
-		      0 /* signal when queue non-empty */ );
+  q = svm_ring_alloc (queue_size, sizeof (session_fifo_event_t),
+		      0 /* multiple producers and consumers */ );
   ssvm_pop_heap (oldheap);
   return q;
 }
@@ -624,7 +623,7 @@ segment_manager_alloc_queue (svm_fifo_segment_private_t * segment,
  * Frees shm queue allocated in the first segment
  */
 void
-segment_manager_dealloc_queue (segment_manager_t * sm, svm_queue_t * q)
+segment_manager_dealloc_queue (segment_manager_t * sm, svm_ring_t * q)
 {
   svm_fifo_segment_private_t *segment;
   ssvm_shared_header_t *sh;
@@ -636,7 +635,7 @@ segment_manager_dealloc_queue (segment_manager_t * sm, svm_queue_t * q)
   sh = segment->ssvm.sh;
 
   oldheap = ssvm_push_heap (sh);
-  svm_queue_free (q);
+  svm_ring_free (q);
   ssvm_pop_heap (oldheap);
   segment_manager_segment_reader_unlock (sm);
 }
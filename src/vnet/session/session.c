@@ -32,7 +32,7 @@ session_send_evt_to_thread (u64 session_handle, fifo_event_type_t evt_type,
 			    u32 thread_index, void *fp, void *rpc_args)
 {
   session_fifo_event_t evt = { {0}, };
-  svm_queue_t *q;
+  svm_ring_t *q;
   u32 tries = 0, max_tries;
 
   evt.event_type = evt_type;
@@ -45,7 +45,7 @@ session_send_evt_to_thread (u64 session_handle, fifo_event_type_t evt_type,
     evt.session_handle = session_handle;
 
   q = session_manager_get_vpp_event_queue (thread_index);
-  while (svm_queue_add (q, (u8 *) & evt, 1))
+  while (svm_ring_try_enqueue (q, &evt))
     {
       max_tries = vlib_get_current_process (vlib_get_main ())? 1e6 : 3;
       if (tries++ == max_tries)
@@ -77,6 +77,32 @@ session_send_rpc_evt_to_thread (u32 thread_index, void *fp, void *rpc_args)
     }
 }
 
+/**
+ * Undo transport_connection_deschedule
+ *
+ * Must be called from the connection's thread. The tx event is handled in
+ * the session queue node's next dispatch.
+ */
+void
+transport_connection_reschedule (transport_connection_t * tc)
+{
+  session_manager_main_t *smm = &session_manager_main;
+  session_fifo_event_t *evt;
+  stream_session_t *s;
+
+  ASSERT (tc->thread_index == vlib_get_thread_index ());
+  tc->flags &= ~TRANSPORT_CONNECTION_F_DESCHED;
+
+  s = session_get_if_valid (tc->s_index, tc->thread_index);
+  if (!s || !s->server_tx_fifo)
+    return;
+
+  vec_add2 (smm->pending_event_vector[tc->thread_index], evt, 1);
+  memset (evt, 0, sizeof (*evt));
+  evt->fifo = s->server_tx_fifo;
+  evt->event_type = FIFO_EVENT_APP_TX;
+}
+
 stream_session_t *
 session_alloc (u32 thread_index)
 {
@@ -449,7 +475,7 @@ session_enqueue_notify (stream_session_t * s, u8 block)
 {
   application_t *app;
   session_fifo_event_t evt;
-  svm_queue_t *q;
+  svm_ring_t *q;
 
   if (PREDICT_FALSE (s->session_state >= SESSION_STATE_CLOSING))
     {
@@ -484,9 +510,8 @@ session_enqueue_notify (stream_session_t * s, u8 block)
       q = app->event_queue;
 
       /* Based on request block (or not) for lack of space */
-      if (block || PREDICT_TRUE (q->cursize < q->maxsize))
-	svm_queue_add (app->event_queue, (u8 *) & evt,
-		       0 /* do wait for mutex */ );
+      if (block || PREDICT_TRUE (!svm_ring_is_full (q)))
+	svm_ring_enqueue (q, &evt, 0 /* wait for space */ );
       else
 	{
 	  clib_warning ("fifo full");
@@ -1187,8 +1212,8 @@ session_vpp_event_queues_allocate (session_manager_main_t * smm)
 
   for (i = 0; i < vec_len (smm->vpp_event_queues); i++)
     {
-      smm->vpp_event_queues[i] = svm_queue_init (evt_q_length, evt_size,
-						 vpp_pid, 0);
+      smm->vpp_event_queues[i] = svm_ring_alloc (evt_q_length, evt_size,
+						 SVM_RING_F_SINGLE_CONSUMER);
     }
 
   if (smm->evt_qs_use_memfd_seg)
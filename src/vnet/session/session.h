@@ -21,6 +21,7 @@
 #include <vnet/session/session_debug.h>
 #include <vnet/session/segment_manager.h>
 #include <svm/queue.h>
+#include <svm/ring.h>
 
 #define HALF_OPEN_LOOKUP_INVALID_VALUE ((u64)~0)
 #define INVALID_INDEX ((u32)~0)
@@ -192,8 +193,8 @@ struct _session_manager_main
   /** per-worker session context */
   session_tx_context_t *ctx;
 
-  /** vpp fifo event queue */
-  svm_queue_t **vpp_event_queues;
+  /** vpp fifo event queues, one per worker */
+  svm_ring_t **vpp_event_queues;
 
   /** Event queues memfd segment initialized only if so configured */
   ssvm_private_t evt_qs_segment;
@@ -470,6 +471,8 @@ transport_tx_fifo_size (transport_connection_t * tc)
   return s->server_tx_fifo->nitems;
 }
 
+void transport_connection_reschedule (transport_connection_t * tc);
+
 always_inline u32
 session_get_index (stream_session_t * s)
 {
@@ -548,7 +551,7 @@ void session_register_transport (transport_proto_t transport_proto,
 
 clib_error_t *vnet_session_enable_disable (vlib_main_t * vm, u8 is_en);
 
-always_inline svm_queue_t *
+always_inline svm_ring_t *
 session_manager_get_vpp_event_queue (u32 thread_index)
 {
   return session_manager_main.vpp_event_queues[thread_index];
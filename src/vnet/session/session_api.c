@@ -60,15 +60,15 @@ _(APPLICATION_TLS_CERT_ADD, application_tls_cert_add)			\
 _(APPLICATION_TLS_KEY_ADD, application_tls_key_add)			\
 
 static int
-session_send_memfd_fd (vl_api_registration_t * reg, const ssvm_private_t * sp)
+session_send_fd (vl_api_registration_t * reg, int fd)
 {
   clib_error_t *error;
   if (vl_api_registration_file_index (reg) == VL_API_INVALID_FI)
     {
-      clib_warning ("can't send memfd fd");
+      clib_warning ("can't send fd");
       return -1;
     }
-  error = vl_api_send_fd_msg (reg, sp->fd);
+  error = vl_api_send_fd_msg (reg, fd);
   if (error)
     {
       clib_error_report (error);
@@ -107,7 +107,7 @@ send_add_segment_callback (u32 api_client_index, const ssvm_private_t * sp)
   vl_msg_api_send_shmem (reg->vl_input_queue, (u8 *) & mp);
 
   if (ssvm_type (sp) == SSVM_SEGMENT_MEMFD)
-    return session_send_memfd_fd (reg, sp);
+    return session_send_fd (reg, sp->fd);
 
   return 0;
 }
@@ -141,7 +141,7 @@ send_del_segment_callback (u32 api_client_index, const ssvm_private_t * fs)
   vl_msg_api_send_shmem (reg->vl_input_queue, (u8 *) & mp);
 
   if (ssvm_type (fs) == SSVM_SEGMENT_MEMFD)
-    return session_send_memfd_fd (reg, fs);
+    return session_send_fd (reg, fs->fd);
 
   return 0;
 }
@@ -155,7 +155,7 @@ send_session_accept_callback (stream_session_t * s)
   vl_api_registration_t *reg;
   transport_connection_t *tc;
   stream_session_t *listener;
-  svm_queue_t *vpp_queue;
+  svm_ring_t *vpp_queue;
 
   reg = vl_mem_api_client_index_to_registration (server->api_client_index);
   if (!reg)
@@ -300,7 +300,7 @@ send_session_connected_callback (u32 app_index, u32 api_context,
   vl_api_connect_session_reply_t *mp;
   transport_connection_t *tc;
   vl_api_registration_t *reg;
-  svm_queue_t *vpp_queue;
+  svm_ring_t *vpp_queue;
   application_t *app;
 
   app = application_get (app_index);
@@ -380,6 +380,7 @@ vl_api_application_attach_t_handler (vl_api_application_attach_t * mp)
   vl_api_application_attach_reply_t *rmp;
   ssvm_private_t *segp, *evt_q_segment;
   vnet_app_attach_args_t _a, *a = &_a;
+  svm_ring_t *app_evt_q;
   vl_api_registration_t *reg;
   clib_error_t *error = 0;
   int rv = 0;
@@ -446,10 +447,14 @@ done:
 
   /* Send fifo segment fd if needed */
   if (ssvm_type (a->segment) == SSVM_SEGMENT_MEMFD)
-    session_send_memfd_fd (reg, a->segment);
+    session_send_fd (reg, a->segment->fd);
   /* Send event queues segment */
   if ((evt_q_segment = session_manager_get_evt_q_segment ()))
-    session_send_memfd_fd (reg, evt_q_segment);
+    session_send_fd (reg, evt_q_segment->fd);
+  /* Send the eventfd the app's event queue consumer sleeps on */
+  app_evt_q = uword_to_pointer (a->app_event_queue_address, svm_ring_t *);
+  if (app_evt_q->flags & SVM_RING_F_CONSUMER_EVTFD)
+    session_send_fd (reg, svm_ring_eventfd (app_evt_q));
 }
 
 static void
@@ -485,7 +490,7 @@ vl_api_bind_uri_t_handler (vl_api_bind_uri_t * mp)
   vl_api_bind_uri_reply_t *rmp;
   stream_session_t *s;
   application_t *app = 0;
-  svm_queue_t *vpp_evt_q;
+  svm_ring_t *vpp_evt_q;
   int rv;
 
   if (session_manager_is_enabled () == 0)
@@ -759,7 +764,7 @@ vl_api_bind_sock_t_handler (vl_api_bind_sock_t * mp)
   stream_session_t *s;
   transport_connection_t *tc = 0;
   ip46_address_t *ip46;
-  svm_queue_t *vpp_evt_q;
+  svm_ring_t *vpp_evt_q;
 
   if (session_manager_is_enabled () == 0)
     {
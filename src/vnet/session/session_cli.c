@@ -269,6 +269,9 @@ show_session_command_fn (vlib_main_t * vm, unformat_input_t * input,
 
 	  vlib_cli_output (vm, "Thread %d: %d active sessions",
 			   i, pool_elts (pool));
+	  if (verbose > 1)
+	    vlib_cli_output (vm, " event queue: %U", format_svm_ring,
+			     smm->vpp_event_queues[i]);
 	  if (verbose)
 	    {
 	      if (once_per_pool && verbose == 1)
@@ -386,7 +386,9 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
   ctx->snd_space = ctx->transport_vft->send_space (ctx->tc);
   if (ctx->snd_space == 0 || ctx->snd_mss == 0)
     {
-      vec_add1 (smm->pending_event_vector[thread_index], *e);
+      /* Descheduled transports post a new event once they can send */
+      if (!transport_connection_is_descheduled (ctx->tc))
+	vec_add1 (smm->pending_event_vector[thread_index], *e);
       return 0;
     }
 
@@ -404,12 +406,18 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
   n_bufs_needed = ctx->n_segs_per_evt * ctx->n_bufs_per_seg;
 
   /*
-   * Make sure we have at least one full frame of buffers ready
+   * Make sure we have at least one full frame of buffers ready. With
+   * GSO sized segments a full frame can mean thousands of buffers, so
+   * only allocate what this event needs plus some slack.
    */
   if (n_bufs < n_bufs_needed)
     {
       session_output_try_get_buffers (vm, smm, thread_index, &n_bufs,
-				      ctx->n_bufs_per_seg * VLIB_FRAME_SIZE);
+				      clib_min (ctx->n_bufs_per_seg *
+						VLIB_FRAME_SIZE,
+						clib_max (n_bufs_needed,
+							  2 *
+							  VLIB_FRAME_SIZE)));
       if (PREDICT_FALSE (n_bufs < n_bufs_needed))
 	{
 	  vec_add1 (smm->pending_event_vector[thread_index], *e);
@@ -565,18 +573,16 @@ dump_thread_0_event_queue (void)
   u32 my_thread_index = vm->thread_index;
   session_fifo_event_t _e, *e = &_e;
   stream_session_t *s0;
-  int i, index;
-  i8 *headp;
+  svm_ring_t *q;
+  int i, n_elts;
 
-  svm_queue_t *q;
   q = smm->vpp_event_queues[my_thread_index];
+  n_elts = svm_ring_n_elts (q);
 
-  index = q->head;
-
-  for (i = 0; i < q->cursize; i++)
+  for (i = 0; i < n_elts; i++)
     {
-      headp = (i8 *) (&q->data[0] + q->elsize * index);
-      clib_memcpy (e, headp, q->elsize);
+      if (svm_ring_peek (q, i, e))
+	break;
 
       switch (e->event_type)
 	{
@@ -606,11 +612,6 @@ dump_thread_0_event_queue (void)
 		   i, e->event_type);
 	  break;
 	}
-
-      index++;
-
-      if (index == q->maxsize)
-	index = 0;
     }
 }
 
@@ -648,11 +649,10 @@ u8
 session_node_lookup_fifo_event (svm_fifo_t * f, session_fifo_event_t * e)
 {
   session_manager_main_t *smm = vnet_get_session_manager_main ();
-  svm_queue_t *q;
   session_fifo_event_t *pending_event_vector, *evt;
-  int i, index, found = 0;
-  i8 *headp;
+  int i, n_elts, found = 0;
   u8 thread_index;
+  svm_ring_t *q;
 
   ASSERT (e);
   thread_index = f->master_thread_index;
@@ -660,16 +660,14 @@ session_node_lookup_fifo_event (svm_fifo_t * f, session_fifo_event_t * e)
    * Search evt queue
    */
   q = smm->vpp_event_queues[thread_index];
-  index = q->head;
-  for (i = 0; i < q->cursize; i++)
+  n_elts = svm_ring_n_elts (q);
+  for (i = 0; i < n_elts; i++)
     {
-      headp = (i8 *) (&q->data[0] + q->elsize * index);
-      clib_memcpy (e, headp, q->elsize);
+      if (svm_ring_peek (q, i, e))
+	break;
       found = session_node_cmp_event (e, f);
       if (found)
 	return 1;
-      if (++index == q->maxsize)
-	index = 0;
     }
   /*
    * Search pending events vector
@@ -692,10 +690,10 @@ session_queue_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		       vlib_frame_t * frame)
 {
   session_manager_main_t *smm = vnet_get_session_manager_main ();
-  session_fifo_event_t *my_pending_event_vector, *e;
+  session_fifo_event_t *my_pending_event_vector;
   session_fifo_event_t *my_fifo_events;
   u32 n_to_dequeue, n_events;
-  svm_queue_t *q;
+  svm_ring_t *q;
   application_t *app;
   int n_tx_packets = 0;
   u32 thread_index = vm->thread_index;
@@ -719,8 +717,8 @@ session_queue_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 
   my_fifo_events = smm->free_event_vector[thread_index];
 
-  /* min number of events we can dequeue without blocking */
-  n_to_dequeue = q->cursize;
+  /* upper bound on the number of events we can dequeue */
+  n_to_dequeue = svm_ring_n_elts (q);
   my_pending_event_vector = smm->pending_event_vector[thread_index];
 
   if (!n_to_dequeue && !vec_len (my_pending_event_vector)
@@ -740,21 +738,15 @@ session_queue_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       goto skip_dequeue;
     }
 
-  /* See you in the next life, don't be late */
-  if (pthread_mutex_trylock (&q->mutex))
-    return 0;
-
-  for (i = 0; i < n_to_dequeue; i++)
+  if (n_to_dequeue)
     {
-      vec_add2 (my_fifo_events, e, 1);
-      svm_queue_sub_raw (q, (u8 *) e);
+      n_events = vec_len (my_fifo_events);
+      vec_validate (my_fifo_events, n_events + n_to_dequeue - 1);
+      n_events += svm_ring_dequeue_batch (q, my_fifo_events + n_events,
+					  n_to_dequeue);
+      _vec_len (my_fifo_events) = n_events;
     }
 
-  /* The other side of the connection is not polling */
-  if (q->cursize < (q->maxsize / 8))
-    (void) pthread_cond_broadcast (&q->condvar);
-  pthread_mutex_unlock (&q->mutex);
-
   vec_append (my_fifo_events, my_pending_event_vector);
   vec_append (my_fifo_events, smm->pending_disconnects[thread_index]);
 
@@ -50,6 +50,7 @@ typedef struct _transport_connection
   u32 s_index;			/**< Parent session index */
   u32 c_index;			/**< Connection index in transport pool */
   u32 thread_index;		/**< Worker-thread index */
+  u8 flags;			/**< Transport connection flags */
 
   /*fib_node_index_t rmt_fei;
      dpo_id_t rmt_dpo; */
@@ -79,8 +80,28 @@ typedef struct _transport_connection
 #define c_rmt_fei connection.rmt_fei
 #define c_rmt_dpo connection.rmt_dpo
 #define c_opaque_id connection.opaque_conn_id
+#define c_flags connection.flags
 } transport_connection_t;
 
+typedef enum transport_connection_flags_
+{
+  /** Transport can't send for now and will reschedule the session itself,
+   * so the session layer should not keep polling it for tx */
+  TRANSPORT_CONNECTION_F_DESCHED = 1 << 0,
+} transport_connection_flags_t;
+
+always_inline void
+transport_connection_deschedule (transport_connection_t * tc)
+{
+  tc->flags |= TRANSPORT_CONNECTION_F_DESCHED;
+}
+
+always_inline u8
+transport_connection_is_descheduled (transport_connection_t * tc)
+{
+  return ((tc->flags & TRANSPORT_CONNECTION_F_DESCHED) ? 1 : 0);
+}
+
 typedef enum _transport_proto
 {
   TRANSPORT_PROTO_TCP,
@@ -387,6 +387,7 @@ tcp_connection_timers_init (tcp_connection_t * tc)
     {
       tc->timers[i] = TCP_TIMER_HANDLE_INVALID;
     }
+  tc->pacer.timer_handle = TCP_TIMER_HANDLE_INVALID;
 
   tc->rto = TCP_RTO_INIT;
 }
@@ -402,6 +403,7 @@ tcp_connection_timers_reset (tcp_connection_t * tc)
     {
       tcp_timer_reset (tc, i);
     }
+  tcp_pacer_timer_reset (tc);
 }
 
 #if 0
@@ -720,6 +722,45 @@ format_tcp_congestion_status (u8 * s, va_list * args)
   return s;
 }
 
+u8 *
+format_tcp_cc_algo (u8 * s, va_list * args)
+{
+  tcp_cc_algorithm_type_e type = va_arg (*args, tcp_cc_algorithm_type_e);
+
+  if (!tcp_cc_algo_is_registered (type))
+    return format (s, "unknown");
+  return format (s, "%s", tcp_cc_algo_get (type)->name);
+}
+
+uword
+unformat_tcp_cc_algo (unformat_input_t * input, va_list * va)
+{
+  tcp_cc_algorithm_type_e *result = va_arg (*va,
+					    tcp_cc_algorithm_type_e *);
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_cc_algorithm_type_e type;
+  u8 *name = 0;
+  uword rv = 0;
+
+  if (!unformat (input, "%_%v%_", &name))
+    return 0;
+
+  for (type = 0; type < vec_len (tm->cc_algos); type++)
+    {
+      if (!tcp_cc_algo_is_registered (type))
+	continue;
+      if (vec_len (name) == strlen (tm->cc_algos[type].name)
+	  && !memcmp (name, tm->cc_algos[type].name, vec_len (name)))
+	{
+	  *result = type;
+	  rv = 1;
+	  break;
+	}
+    }
+  vec_free (name);
+  return rv;
+}
+
 u8 *
 format_tcp_vars (u8 * s, va_list * args)
 {
@@ -737,9 +778,12 @@ format_tcp_vars (u8 * s, va_list * args)
   s = format (s, " flight size %u out space %u cc space %u rcv_wnd_av %u\n",
 	      tcp_flight_size (tc), tcp_available_output_snd_space (tc),
 	      tcp_available_cc_snd_space (tc), tcp_rcv_wnd_available (tc));
-  s = format (s, " cong %U ", format_tcp_congestion_status, tc);
+  s = format (s, " cong %U cc %s ", format_tcp_congestion_status, tc,
+	      tc->cc_algo ? tc->cc_algo->name : "none");
   s = format (s, "cwnd %u ssthresh %u rtx_bytes %u bytes_acked %u\n",
 	      tc->cwnd, tc->ssthresh, tc->snd_rxt_bytes, tc->bytes_acked);
+  s = format (s, " pacing rate %lu bucket %u throttled %u\n",
+	      tc->pacer.rate, tc->pacer.bucket, tc->pacer.n_throttled);
   s = format (s, " prev_ssthresh %u snd_congestion %u dupack %u",
 	      tc->prev_ssthresh, tc->snd_congestion - tc->iss,
 	      tc->rcv_dupacks);
@@ -952,6 +996,14 @@ tcp_session_send_mss (transport_connection_t * trans_conn)
    * the current state of the connection. */
   tcp_update_snd_mss (tc);
 
+  /* With GSO, let the session layer build buffers of as many full
+   * segments as fit in an IP packet. Keep to single segments while
+   * recovering, retransmits are always cut at snd_mss. Software
+   * segmentation needs every segment to fit in one buffer. */
+  if (tcp_main.gso_enabled && !tcp_in_cong_recovery (tc)
+      && tc->snd_mss + MAX_HDRS_LEN <= tcp_main.bytes_per_buffer)
+    return ((TCP_MAX_GSO_SZ - MAX_HDRS_LEN) / tc->snd_mss) * tc->snd_mss;
+
   return tc->snd_mss;
 }
 
@@ -1031,12 +1083,113 @@ tcp_snd_space (tcp_connection_t * tc)
   return 0;
 }
 
+/**
+ * Pacing rate for connection, in bytes/s
+ *
+ * Algorithms that model the path provide their own rate. For all others,
+ * spread cwnd over srtt, with some headroom for window growth as in
+ * Linux: 2x while in slow start, 1.2x afterwards. Not pacing while srtt
+ * is unknown.
+ */
+static u64
+tcp_pacer_rate (tcp_connection_t * tc)
+{
+  u64 rate;
+
+  if (tc->cc_algo->pacing_rate)
+    return tc->cc_algo->pacing_rate (tc);
+
+  if (!tc->srtt)
+    return 0;
+
+  rate = (u64) tc->cwnd * THZ / tc->srtt;
+  return tcp_in_slowstart (tc) ? 2 * rate : rate * 6 / 5;
+}
+
+static void
+tcp_pacer_timer_set (tcp_connection_t * tc, u32 interval)
+{
+  ASSERT (tc->c_thread_index == vlib_get_thread_index ());
+  tc->pacer.timer_handle =
+    tw_timer_start_16t_2w_512sl (&tcp_main.pacer_wheels[tc->c_thread_index],
+				 tc->c_c_index, 0, interval);
+}
+
+void
+tcp_pacer_timer_reset (tcp_connection_t * tc)
+{
+  if (tc->pacer.timer_handle == TCP_TIMER_HANDLE_INVALID)
+    return;
+
+  ASSERT (tc->c_thread_index == vlib_get_thread_index ());
+  tw_timer_stop_16t_2w_512sl (&tcp_main.pacer_wheels[tc->c_thread_index],
+			      tc->pacer.timer_handle);
+  tc->pacer.timer_handle = TCP_TIMER_HANDLE_INVALID;
+}
+
+/**
+ * Limit send space to what the connection's pacer allows at time now
+ *
+ * Refills the token bucket at the current pacing rate. If not even one
+ * segment can be sent, a pacer timer is armed for when that will be
+ * possible and the connection is descheduled from the session layer
+ * until it expires. Only connections that are actually throttled have
+ * timers, so the cost does not depend on the number of connections.
+ *
+ * @param tc tcp connection
+ * @param snd_space send space allowed by the windows
+ * @param now current time, in seconds
+ * @return bytes that can be sent right away
+ */
+u32
+tcp_pacer_snd_space (tcp_connection_t * tc, u32 snd_space, f64 now)
+{
+  tcp_pacer_t *pacer = &tc->pacer;
+  f64 bucket, max_burst;
+  u32 wait;
+
+  pacer->rate = tcp_pacer_rate (tc);
+  if (!pacer->rate)
+    {
+      pacer->last_update = now;
+      return snd_space;
+    }
+
+  /* Allow bursts of what the timer can release in a few ticks */
+  max_burst = clib_max (pacer->rate * TCP_PACER_BURST_TICKS * TCP_PACER_TICK,
+			TCP_PACER_MIN_BURST * tc->snd_mss);
+  bucket = pacer->bucket + (now - pacer->last_update) * pacer->rate;
+  pacer->bucket = clib_min (bucket, max_burst);
+  pacer->last_update = now;
+
+  if (!snd_space || pacer->bucket >= snd_space)
+    return snd_space;
+  if (pacer->bucket >= tc->snd_mss)
+    return pacer->bucket - pacer->bucket % tc->snd_mss;
+
+  /* Throttled. Wait until at least a segment can be sent */
+  pacer->n_throttled += 1;
+  if (pacer->timer_handle == TCP_TIMER_HANDLE_INVALID)
+    {
+      wait = (tc->snd_mss - pacer->bucket) / (pacer->rate * TCP_PACER_TICK);
+      tcp_pacer_timer_set (tc, wait + 1);
+    }
+  transport_connection_deschedule (&tc->connection);
+  return 0;
+}
+
 u32
 tcp_session_send_space (transport_connection_t * trans_conn)
 {
   tcp_connection_t *tc = (tcp_connection_t *) trans_conn;
-  return clib_min (tcp_snd_space (tc),
-		   tc->snd_wnd - (tc->snd_nxt - tc->snd_una));
+  u32 snd_space;
+
+  snd_space = clib_min (tcp_snd_space (tc),
+			tc->snd_wnd - (tc->snd_nxt - tc->snd_una));
+  if (tcp_main.pacing_enabled && tc->state >= TCP_STATE_ESTABLISHED)
+    snd_space = tcp_pacer_snd_space (tc, snd_space,
+				     vlib_time_now (vlib_get_main ()));
+  return snd_space;
 }
 
 i32
@@ -1062,6 +1215,9 @@ tcp_update_time (f64 now, u8 thread_index)
   tcp_set_time_now (thread_index);
   tw_timer_expire_timers_16t_2w_512sl (&tcp_main.timer_wheels[thread_index],
 				       now);
+  if (tcp_main.pacing_enabled)
+    tw_timer_expire_timers_16t_2w_512sl (&tcp_main.pacer_wheels
+					 [thread_index], now);
   tcp_flush_frames_to_output (thread_index);
 }
 
@@ -1194,6 +1350,27 @@ tcp_expired_timers_dispatch (u32 * expired_timers)
     }
 }
 
+/**
+ * Reschedule sessions whose pacer released enough tokens to send
+ */
+static void
+tcp_pacer_expired_timers_dispatch (u32 * expired_timers)
+{
+  u32 thread_index = vlib_get_thread_index ();
+  tcp_connection_t *tc;
+  int i;
+
+  for (i = 0; i < vec_len (expired_timers); i++)
+    {
+      tc = tcp_connection_get (expired_timers[i] & 0x0FFFFFFF,
+			       thread_index);
+      if (PREDICT_FALSE (!tc))
+	continue;
+      tc->pacer.timer_handle = TCP_TIMER_HANDLE_INVALID;
+      transport_connection_reschedule (&tc->connection);
+    }
+}
+
 void
 tcp_initialize_timer_wheels (tcp_main_t * tm)
 {
@@ -1204,6 +1381,10 @@ tcp_initialize_timer_wheels (tcp_main_t * tm)
     tw_timer_wheel_init_16t_2w_512sl (tw, tcp_expired_timers_dispatch,
 				      100e-3 /* timer period 100ms */ , ~0);
     tw->last_run_time = vlib_time_now (this_vlib_main);
+    tw = &tm->pacer_wheels[ii];
+    tw_timer_wheel_init_16t_2w_512sl (tw, tcp_pacer_expired_timers_dispatch,
+				      TCP_PACER_TICK, ~0);
+    tw->last_run_time = vlib_time_now (this_vlib_main);
   }));
   /* *INDENT-ON* */
 }
@@ -1274,6 +1455,7 @@ tcp_main_enable (vlib_main_t * vm)
 
   /* Initialize timer wheels */
   vec_validate (tm->timer_wheels, num_threads - 1);
+  vec_validate (tm->pacer_wheels, num_threads - 1);
   tcp_initialize_timer_wheels (tm);
 
   /* Initialize clocks per tick for TCP timestamp. Used to compute
@@ -1372,6 +1554,13 @@ tcp_config_fn (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "buffer-fail-fraction %f",
 			 &tm->buffer_fail_fraction))
 	;
+      else if (unformat (input, "gso"))
+	tm->gso_enabled = 1;
+      else if (unformat (input, "pacing"))
+	tm->pacing_enabled = 1;
+      else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
+			 &tm->cc_algo))
+	;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -1828,6 +2017,99 @@ VLIB_CLI_COMMAND (tcp_replay_scoreboard_command, static) =
 };
 /* *INDENT-ON* */
 
+/**
+ * Set the congestion control algorithm used by new connections
+ *
+ * @param type algorithm to use
+ * @param fib_index fib whose connections should use the algorithm, or ~0
+ *		    to change the default for all fibs without an override
+ * @param is_ip4 whether fib_index is an ip4 or ip6 fib
+ * @return 0 if all OK, else an error indication from api_errno.h
+ */
+int
+tcp_cc_algo_set (tcp_cc_algorithm_type_e type, u32 fib_index, u8 is_ip4)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  u8 **by_fib;
+
+  if (!tcp_cc_algo_is_registered (type))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (fib_index == ~0)
+    {
+      tm->cc_algo = type;
+      return 0;
+    }
+
+  by_fib = &tm->cc_algo_by_fib_index[is_ip4 ? TCP_IP4 : TCP_IP6];
+  vec_validate (*by_fib, fib_index);
+  (*by_fib)[fib_index] = type + 1;
+  return 0;
+}
+
+static clib_error_t *
+tcp_cc_algo_set_fn (vlib_main_t * vm, unformat_input_t * input,
+		    vlib_cli_command_t * cmd_arg)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  tcp_cc_algorithm_type_e type = TCP_CC_LAST;
+  app_namespace_t *app_ns;
+  u8 *ns_id = 0;
+  clib_error_t *error = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "congestion control algorithm required");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "namespace %_%v%_", &ns_id))
+	;
+      else if (unformat (line_input, "%U", unformat_tcp_cc_algo, &type))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (type == TCP_CC_LAST)
+    {
+      error = clib_error_return (0, "congestion control algorithm required");
+      goto done;
+    }
+
+  if (!ns_id)
+    {
+      tcp_cc_algo_set (type, ~0, 1);
+      goto done;
+    }
+
+  app_ns = app_namespace_get_from_id (ns_id);
+  if (!app_ns)
+    {
+      error = clib_error_return (0, "namespace %v not found", ns_id);
+      goto done;
+    }
+  tcp_cc_algo_set (type, app_ns->ip4_fib_index, 1);
+  tcp_cc_algo_set (type, app_ns->ip6_fib_index, 0);
+
+done:
+  unformat_free (line_input);
+  vec_free (ns_id);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (tcp_cc_algo_set_command, static) =
+{
+  .path = "set tcp cc-algo",
+  .short_help = "set tcp cc-algo <newreno|cubic|bbr> [namespace <ns-id>]",
+  .function = tcp_cc_algo_set_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 show_tcp_punt_fn (vlib_main_t * vm, unformat_input_t * input,
 		  vlib_cli_command_t * cmd_arg)
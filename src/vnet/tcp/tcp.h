@@ -30,6 +30,7 @@
 #define TCP_PAWS_IDLE 24 * 24 * 60 * 60 * THZ /**< 24 days */
 #define TCP_FIB_RECHECK_PERIOD	1 * THZ	/**< Recheck every 1s */
 #define TCP_MAX_OPTION_SPACE 40
+#define TCP_MAX_GSO_SZ 65535		/**< Max IP packet built with GSO */
 
 #define TCP_DUPACK_THRESHOLD 	3
 #define TCP_MAX_RX_FIFO_SIZE 	4 << 20
@@ -104,6 +105,12 @@ extern timer_expiration_handler tcp_timer_retransmit_syn_handler;
 #define TCP_CLEANUP_TIME	10	/* 1s Time to wait before cleanup */
 #define TCP_TIMER_PERSIST_MIN	2	/* 0.2s */
 
+/* Tx pacer. Connection timers are too coarse, so pacing uses its own per
+ * worker wheels */
+#define TCP_PACER_TICK		100e-6	/**< Pacer wheel tick, 100us */
+#define TCP_PACER_MIN_BURST	2	/**< Min burst, in segments */
+#define TCP_PACER_BURST_TICKS	2	/**< Max burst, in pacer ticks */
+
 #define TCP_RTO_MAX 60 * THZ	/* Min max RTO (60s) as per RFC6298 */
 #define TCP_RTO_MIN 0.2 * THZ	/* Min RTO (200ms) - lower than standard */
 #define TCP_RTT_MAX 30 * THZ	/* 30s (probably too much) */
@@ -228,10 +235,16 @@ typedef struct _sack_scoreboard
 typedef enum _tcp_cc_algorithm_type
 {
   TCP_CC_NEWRENO,
+  TCP_CC_CUBIC,
+  TCP_CC_BBR,
+  TCP_CC_LAST,
 } tcp_cc_algorithm_type_e;
 
 typedef struct _tcp_cc_algorithm tcp_cc_algorithm_t;
 
+/** Per connection scratch space available to congestion control algos */
+#define TCP_CC_DATA_SZ 8
+
 typedef enum _tcp_cc_ack_t
 {
   TCP_CC_ACK,
@@ -239,6 +252,16 @@ typedef enum _tcp_cc_ack_t
   TCP_CC_PARTIALACK
 } tcp_cc_ack_t;
 
+/** Token bucket that paces new data handed over by the session layer */
+typedef struct _tcp_pacer
+{
+  u64 rate;		/**< Pacing rate in bytes/s, 0 if not pacing */
+  f64 last_update;	/**< Last time the bucket was refilled */
+  u32 bucket;		/**< Bytes that can be sent right away */
+  u32 timer_handle;	/**< Pacer wheel timer, if throttled */
+  u32 n_throttled;	/**< Times sending was delayed */
+} tcp_pacer_t;
+
 typedef struct _tcp_connection
 {
   transport_connection_t connection;  /**< Common transport data. First! */
@@ -293,6 +316,8 @@ typedef struct _tcp_connection
   u32 tsecr_last_ack;	/**< Timestamp echoed to us in last healthy ACK */
   u32 snd_congestion;	/**< snd_una_max when congestion is detected */
   tcp_cc_algorithm_t *cc_algo;	/**< Congestion control algorithm */
+  u64 cc_data[TCP_CC_DATA_SZ];	/**< Congestion control algo private data */
+  tcp_pacer_t pacer;		/**< Tx pacer */
 
   /* RTT and RTO */
   u32 rto;		/**< Retransmission timeout */
@@ -310,13 +335,18 @@ typedef struct _tcp_connection
 
 struct _tcp_cc_algorithm
 {
+  const char *name;
   void (*rcv_ack) (tcp_connection_t * tc);
   void (*rcv_cong_ack) (tcp_connection_t * tc, tcp_cc_ack_t ack);
   void (*congestion) (tcp_connection_t * tc);
   void (*recovered) (tcp_connection_t * tc);
   void (*init) (tcp_connection_t * tc);
+  /** Optional. Rate, in bytes/s, at which the algo wants to be paced */
+  u64 (*pacing_rate) (tcp_connection_t * tc);
 };
 
+#define tcp_cc_data(_tc) ((void *) (_tc)->cc_data)
+
 #define tcp_fastrecovery_on(tc) (tc)->flags |= TCP_CONN_FAST_RECOVERY
 #define tcp_fastrecovery_off(tc) (tc)->flags &= ~TCP_CONN_FAST_RECOVERY
 #define tcp_recovery_on(tc) (tc)->flags |= TCP_CONN_RECOVERY
@@ -383,6 +413,9 @@ typedef struct _tcp_main
   /* Per worker-thread timer wheel for connections timers */
   tw_timer_wheel_16t_2w_512sl_t *timer_wheels;
 
+  /* Per worker-thread timer wheel for tx pacing */
+  tw_timer_wheel_16t_2w_512sl_t *pacer_wheels;
+
   /* Pool of half-open connections on which we've sent a SYN */
   tcp_connection_t *half_open_connections;
   clib_spinlock_t half_open_lock;
@@ -390,6 +423,12 @@ typedef struct _tcp_main
   /* Congestion control algorithms registered */
   tcp_cc_algorithm_t *cc_algos;
 
+  /** Default congestion control algorithm */
+  tcp_cc_algorithm_type_e cc_algo;
+
+  /** Per fib index algorithm overrides, algo type + 1 or 0 if unset */
+  u8 *cc_algo_by_fib_index[TCP_N_AF];
+
   /* Flag that indicates if stack is on or off */
   u8 is_enabled;
 
@@ -409,6 +448,12 @@ typedef struct _tcp_main
   u8 punt_unknown4;
   u8 punt_unknown6;
 
+  /** Hand multi-segment GSO buffers to the output path */
+  u8 gso_enabled;
+
+  /** Pace new data sent by connections */
+  u8 pacing_enabled;
+
   /** fault-injection */
   f64 buffer_fail_fraction;
 } tcp_main_t;
@@ -721,6 +766,18 @@ tcp_timer_update (tcp_connection_t * tc, u8 timer_id, u32 interval)
 				 tc->c_c_index, timer_id, interval);
 }
 
+u32 tcp_pacer_snd_space (tcp_connection_t * tc, u32 snd_space, f64 now);
+void tcp_pacer_timer_reset (tcp_connection_t * tc);
+
+/**
+ * Account for bytes sent on a paced connection
+ */
+always_inline void
+tcp_pacer_consume (tcp_connection_t * tc, u32 bytes)
+{
+  tc->pacer.bucket -= clib_min (tc->pacer.bucket, bytes);
+}
+
 always_inline void
 tcp_retransmit_timer_set (tcp_connection_t * tc)
 {
@@ -902,6 +959,21 @@ tcp_cc_algo_get (tcp_cc_algorithm_type_e type)
   return &tm->cc_algos[type];
 }
 
+always_inline u8
+tcp_cc_algo_is_registered (tcp_cc_algorithm_type_e type)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  return (type < vec_len (tm->cc_algos) && tm->cc_algos[type].init != 0);
+}
+
+uword unformat_tcp_cc_algo (unformat_input_t * input, va_list * va);
+u8 *format_tcp_cc_algo (u8 * s, va_list * args);
+int tcp_cc_algo_set (tcp_cc_algorithm_type_e type, u32 fib_index,
+		     u8 is_ip4);
+
+/* Newreno functions reused by other algorithms */
+void newreno_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type);
+
 void tcp_cc_init (tcp_connection_t * tc);
 
 /**
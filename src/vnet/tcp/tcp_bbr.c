@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Model based, rate driven congestion control, after BBR
+ *
+ * The path is modeled by its bottleneck bandwidth, the max delivery rate
+ * seen over the last few rounds, and by its propagation delay, the min rtt
+ * seen over the last few seconds. The congestion window is a multiple of
+ * the resulting bandwidth-delay product and the rate at which the sender
+ * should be paced is exported through the pacing_rate callback.
+ *
+ * Delivery rate is sampled once per round trip, i.e., bytes acked between
+ * two consecutive acks of snd_una_max, so no per packet state is needed.
+ * Packet loss is only used to conserve packets during recovery.
+ */
+
+#include <vnet/tcp/tcp.h>
+
+#define BBR_UNIT		256	/**< Fixed point unit for gains */
+#define BBR_HIGH_GAIN		739	/**< 2/ln(2), in BBR_UNIT */
+#define BBR_DRAIN_GAIN		89	/**< 1/high gain, in BBR_UNIT */
+#define BBR_CWND_GAIN		512	/**< cwnd gain while probing bw */
+#define BBR_CYCLE_LEN		8	/**< Phases in a probe bw gain cycle */
+#define BBR_BW_ROUNDS		10	/**< Rounds in the max bw filter */
+#define BBR_MIN_RTT_WIN		(10 * THZ)	/**< min rtt filter length */
+#define BBR_PROBE_RTT_TIME	(0.2 * THZ)	/**< Time spent probing rtt */
+#define BBR_FULL_BW_THRESH	320	/**< 1.25, bw growth to stay in startup */
+#define BBR_FULL_BW_ROUNDS	3	/**< Rounds without growth to exit */
+#define BBR_MIN_CWND_SEGS	4
+
+typedef enum bbr_mode_
+{
+  BBR_MODE_STARTUP,
+  BBR_MODE_DRAIN,
+  BBR_MODE_PROBE_BW,
+  BBR_MODE_PROBE_RTT,
+} bbr_mode_e;
+
+static const u16 bbr_pacing_gain_cycle[BBR_CYCLE_LEN] = {
+  BBR_UNIT * 5 / 4, BBR_UNIT * 3 / 4, BBR_UNIT, BBR_UNIT,
+  BBR_UNIT, BBR_UNIT, BBR_UNIT, BBR_UNIT
+};
+
+typedef struct bbr_bw_sample_
+{
+  u32 round;		/**< Round the sample was taken in */
+  u32 bw;		/**< Delivery rate in bytes per tick */
+} bbr_bw_sample_t;
+
+typedef struct bbr_data_
+{
+  bbr_bw_sample_t bw[3];	/**< Best, 2nd and 3rd best bw in window */
+  u32 min_rtt;			/**< Min rtt in ticks, 0 if unknown */
+  u32 min_rtt_stamp;		/**< Time min_rtt was last refreshed */
+  u32 round_start_seq;		/**< Ack that ends the current round */
+  u32 round_start_time;		/**< Time current round started */
+  u32 round_delivered;		/**< Bytes acked in current round */
+  u32 round_count;		/**< Rounds since connection start */
+  u32 full_bw;			/**< Bw at last startup growth check */
+  u32 mode_stamp;		/**< Phase start, or probe rtt end, time */
+  u8 mode;			/**< Current mode, see bbr_mode_e */
+  u8 cycle_index;		/**< Current phase of the gain cycle */
+  u8 full_bw_count;		/**< Rounds without significant bw growth */
+  u8 full_pipe;			/**< Set once startup filled the pipe */
+  u8 round_pending;		/**< Round end seq set by next ack */
+} bbr_data_t;
+
+STATIC_ASSERT (sizeof (bbr_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "bbr data too large");
+
+static inline u32
+bbr_max_bw (bbr_data_t * bd)
+{
+  return bd->bw[0].bw;
+}
+
+/**
+ * Windowed max filter, after Kathleen Nichols' algorithm. Keeps the best
+ * three samples such that the max can be aged out without a full history.
+ */
+static void
+bbr_bw_filter_update (bbr_data_t * bd, u32 bw, u32 round)
+{
+  bbr_bw_sample_t val = {.round = round,.bw = bw };
+
+  if (bw >= bd->bw[0].bw || round - bd->bw[2].round > BBR_BW_ROUNDS)
+    {
+      bd->bw[0] = bd->bw[1] = bd->bw[2] = val;
+      return;
+    }
+
+  if (bw >= bd->bw[1].bw)
+    bd->bw[1] = bd->bw[2] = val;
+  else if (bw >= bd->bw[2].bw)
+    bd->bw[2] = val;
+
+  /* Age out the best samples */
+  if (round - bd->bw[0].round > BBR_BW_ROUNDS)
+    {
+      bd->bw[0] = bd->bw[1];
+      bd->bw[1] = bd->bw[2];
+      bd->bw[2] = val;
+      if (round - bd->bw[0].round > BBR_BW_ROUNDS)
+	{
+	  bd->bw[0] = bd->bw[1];
+	  bd->bw[1] = bd->bw[2];
+	}
+    }
+  else if (bd->bw[1].round == bd->bw[0].round
+	   && round - bd->bw[1].round > BBR_BW_ROUNDS / 4)
+    {
+      bd->bw[1] = bd->bw[2] = val;
+    }
+  else if (bd->bw[2].round == bd->bw[1].round
+	   && round - bd->bw[2].round > BBR_BW_ROUNDS / 2)
+    {
+      bd->bw[2] = val;
+    }
+}
+
+static inline u64
+bbr_bdp (bbr_data_t * bd)
+{
+  return (u64) bbr_max_bw (bd) * bd->min_rtt;
+}
+
+static u32
+bbr_target_cwnd (tcp_connection_t * tc, u32 gain)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 min_cwnd = BBR_MIN_CWND_SEGS * tc->snd_mss;
+  u64 cwnd;
+
+  if (!bbr_max_bw (bd) || !bd->min_rtt)
+    return tcp_initial_cwnd (tc);
+
+  /* Leave room for delayed and stretched acks */
+  cwnd = (bbr_bdp (bd) * gain) / BBR_UNIT + 3 * tc->snd_mss;
+  return clib_max (cwnd, min_cwnd);
+}
+
+static u32
+bbr_pacing_gain (bbr_data_t * bd)
+{
+  switch (bd->mode)
+    {
+    case BBR_MODE_STARTUP:
+      return BBR_HIGH_GAIN;
+    case BBR_MODE_DRAIN:
+      return BBR_DRAIN_GAIN;
+    case BBR_MODE_PROBE_BW:
+      return bbr_pacing_gain_cycle[bd->cycle_index];
+    default:
+      return BBR_UNIT;
+    }
+}
+
+static u32
+bbr_cwnd_gain (bbr_data_t * bd)
+{
+  switch (bd->mode)
+    {
+    case BBR_MODE_STARTUP:
+    case BBR_MODE_DRAIN:
+      return BBR_HIGH_GAIN;
+    case BBR_MODE_PROBE_BW:
+      return BBR_CWND_GAIN;
+    default:
+      return BBR_UNIT;
+    }
+}
+
+static void
+bbr_enter_probe_bw (bbr_data_t * bd, u32 now)
+{
+  bd->mode = BBR_MODE_PROBE_BW;
+  /* Start in a cruising phase, as opposed to probing or draining */
+  bd->cycle_index = 2;
+  bd->mode_stamp = now;
+}
+
+static void
+bbr_check_full_pipe (bbr_data_t * bd)
+{
+  if (bd->full_pipe)
+    return;
+
+  if ((u64) bbr_max_bw (bd) * BBR_UNIT
+      >= (u64) bd->full_bw * BBR_FULL_BW_THRESH)
+    {
+      bd->full_bw = bbr_max_bw (bd);
+      bd->full_bw_count = 0;
+      return;
+    }
+  if (++bd->full_bw_count >= BBR_FULL_BW_ROUNDS)
+    bd->full_pipe = 1;
+}
+
+/**
+ * Called at the end of every round with the round's duration as rtt
+ */
+static void
+bbr_update_model (tcp_connection_t * tc, u32 rtt, u32 now)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u8 min_rtt_expired;
+
+  bbr_bw_filter_update (bd, bd->round_delivered / rtt, bd->round_count);
+
+  min_rtt_expired = now - bd->min_rtt_stamp > BBR_MIN_RTT_WIN;
+  if (!bd->min_rtt || rtt <= bd->min_rtt || min_rtt_expired)
+    {
+      bd->min_rtt = rtt;
+      bd->min_rtt_stamp = now;
+    }
+
+  switch (bd->mode)
+    {
+    case BBR_MODE_STARTUP:
+      bbr_check_full_pipe (bd);
+      if (bd->full_pipe)
+	bd->mode = BBR_MODE_DRAIN;
+      break;
+    case BBR_MODE_DRAIN:
+      if (tcp_flight_size (tc) <= bbr_target_cwnd (tc, BBR_UNIT))
+	bbr_enter_probe_bw (bd, now);
+      break;
+    case BBR_MODE_PROBE_BW:
+      if (now - bd->mode_stamp > bd->min_rtt)
+	{
+	  bd->cycle_index = (bd->cycle_index + 1) % BBR_CYCLE_LEN;
+	  bd->mode_stamp = now;
+	}
+      break;
+    case BBR_MODE_PROBE_RTT:
+      if (timestamp_lt (bd->mode_stamp, now))
+	{
+	  bd->min_rtt_stamp = now;
+	  if (bd->full_pipe)
+	    bbr_enter_probe_bw (bd, now);
+	  else
+	    bd->mode = BBR_MODE_STARTUP;
+	}
+      break;
+    }
+
+  /* Drain the queue, if any, to measure the propagation delay again */
+  if (min_rtt_expired && bd->mode != BBR_MODE_PROBE_RTT)
+    {
+      bd->mode = BBR_MODE_PROBE_RTT;
+      bd->mode_stamp = now + BBR_PROBE_RTT_TIME;
+    }
+}
+
+static void
+bbr_rcv_ack (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 now = tcp_time_now (), target;
+
+  bd->round_delivered += tc->bytes_acked;
+
+  /* Round starts with data sent after the pipe drained, or after the
+   * connection was initialized, which was not known until now */
+  if (PREDICT_FALSE (bd->round_pending))
+    {
+      bd->round_start_seq = tc->snd_una_max;
+      bd->round_pending = 0;
+    }
+  else if (seq_geq (tc->snd_una, bd->round_start_seq))
+    {
+      bbr_update_model (tc, clib_max (now - bd->round_start_time, 1), now);
+      bd->round_count += 1;
+      bd->round_start_seq = tc->snd_una_max;
+      bd->round_start_time = now;
+      bd->round_delivered = 0;
+      bd->round_pending = tc->snd_una == tc->snd_una_max;
+    }
+
+  /* Grow towards the target, but only exceed it before the pipe is full */
+  target = bbr_target_cwnd (tc, bbr_cwnd_gain (bd));
+  if (bd->full_pipe)
+    tc->cwnd = clib_min (tc->cwnd + tc->bytes_acked, target);
+  else if (tc->cwnd < target)
+    tc->cwnd += tc->bytes_acked;
+  tc->cwnd = clib_max (tc->cwnd, BBR_MIN_CWND_SEGS * tc->snd_mss);
+
+  if (bd->mode == BBR_MODE_PROBE_RTT)
+    tc->cwnd = BBR_MIN_CWND_SEGS * tc->snd_mss;
+
+  tc->cwnd = clib_min (tc->cwnd, transport_tx_fifo_size (&tc->connection));
+}
+
+/**
+ * Loss is not a congestion signal for the model. Just conserve packets
+ * during recovery, i.e., send one new segment per segment delivered.
+ */
+static void
+bbr_congestion (tcp_connection_t * tc)
+{
+  tc->ssthresh = clib_max (tcp_flight_size (tc),
+			   BBR_MIN_CWND_SEGS * tc->snd_mss);
+}
+
+static void
+bbr_recovered (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  tc->cwnd = clib_max (tc->ssthresh,
+		       bbr_target_cwnd (tc, bbr_cwnd_gain (bd)));
+}
+
+static void
+bbr_conn_init (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 now = tcp_time_now ();
+
+  memset (bd, 0, sizeof (*bd));
+  bd->mode = BBR_MODE_STARTUP;
+  bd->min_rtt_stamp = now;
+  bd->round_start_time = now;
+  bd->round_pending = 1;
+
+  /* Window is driven by the model, never by ssthresh */
+  tc->ssthresh = ~0;
+  tc->cwnd = tcp_initial_cwnd (tc);
+}
+
+/**
+ * Pacing rate, in bytes/s. Before the first bw sample is available, pace
+ * the window over the smoothed rtt, if known.
+ */
+static u64
+bbr_pacing_rate (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u64 bw = bbr_max_bw (bd);
+
+  if (!bw)
+    {
+      if (!tc->srtt)
+	return 0;
+      bw = tc->cwnd / tc->srtt;
+    }
+  return (bw * THZ * bbr_pacing_gain (bd)) / BBR_UNIT;
+}
+
+const static tcp_cc_algorithm_t tcp_bbr = {
+  .name = "bbr",
+  .congestion = bbr_congestion,
+  .recovered = bbr_recovered,
+  .rcv_ack = bbr_rcv_ack,
+  .rcv_cong_ack = newreno_rcv_cong_ack,
+  .init = bbr_conn_init,
+  .pacing_rate = bbr_pacing_rate,
+};
+
+clib_error_t *
+bbr_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_BBR, &tcp_bbr);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (bbr_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief CUBIC congestion control as per RFC8312
+ *
+ * Windows are tracked in segments and time in seconds, as in the RFC.
+ * Time is derived from the tcp tick, so the window evolution only depends
+ * on the sequence of acks and on tcp_time_now ().
+ */
+
+#include <vnet/tcp/tcp.h>
+#include <math.h>
+
+#define cubic_c		0.4	/**< Scaling constant C */
+#define cubic_beta	0.7	/**< Multiplicative decrease factor */
+/** Additive increase factor of the TCP-friendly window estimate */
+#define cubic_alpha	(3 * (1 - cubic_beta) / (1 + cubic_beta))
+
+typedef struct cubic_data_
+{
+  f64 w_max;		/**< Window, in segments, before last reduction */
+  f64 K;		/**< Seconds needed to grow back to w_max */
+  u32 t_start;		/**< Start of congestion avoidance epoch, 0 if none */
+} cubic_data_t;
+
+STATIC_ASSERT (sizeof (cubic_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "cubic data too large");
+
+static inline f64
+cubic_time (u32 ticks)
+{
+  return (f64) ticks / THZ;
+}
+
+/**
+ * RFC8312 Eq. 1: W_cubic (t) = C * (t - K)^3 + W_max
+ */
+static inline f64
+W_cubic (cubic_data_t * cd, f64 t)
+{
+  f64 diff = t - cd->K;
+  return cubic_c * diff * diff * diff + cd->w_max;
+}
+
+/**
+ * RFC8312 Eq. 4: W_est (t) = W_max * beta + alpha * (t / RTT)
+ */
+static inline f64
+W_est (cubic_data_t * cd, f64 t, f64 rtt)
+{
+  return cd->w_max * cubic_beta + cubic_alpha * (t / rtt);
+}
+
+static void
+cubic_congestion (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  f64 w_max = (f64) tc->cwnd / tc->snd_mss;
+
+  /* Fast convergence. If the window did not grow back to the previous
+   * maximum, release some bandwidth for the newer flows. */
+  if (w_max < cd->w_max)
+    cd->w_max = w_max * (1 + cubic_beta) / 2;
+  else
+    cd->w_max = w_max;
+
+  cd->K = cbrt (cd->w_max * (1 - cubic_beta) / cubic_c);
+  cd->t_start = 0;
+  tc->ssthresh = clib_max (cubic_beta * tc->cwnd, 2 * tc->snd_mss);
+}
+
+static void
+cubic_recovered (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  tc->cwnd = tc->ssthresh;
+  cd->t_start = tcp_time_now ();
+}
+
+static void
+cubic_rcv_ack (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  u32 now = tcp_time_now ();
+  f64 t, rtt, w_cubic, w_est, w_cur, segs;
+  u64 cnt, inc;
+
+  if (tcp_in_slowstart (tc))
+    {
+      tc->cwnd += clib_min (tc->snd_mss, tc->bytes_acked);
+      cd->t_start = 0;
+      return;
+    }
+
+  /* First congestion avoidance ack after slow start, e.g., post RTO */
+  if (!cd->t_start)
+    {
+      cd->t_start = now;
+      if (cd->w_max < (f64) tc->cwnd / tc->snd_mss)
+	{
+	  cd->w_max = (f64) tc->cwnd / tc->snd_mss;
+	  cd->K = 0;
+	}
+    }
+
+  t = cubic_time (now - cd->t_start);
+  rtt = cubic_time (clib_max (tc->srtt, 1));
+  w_cur = (f64) tc->cwnd / tc->snd_mss;
+
+  /* Target is the window one rtt from now */
+  w_cubic = W_cubic (cd, t + rtt);
+  w_est = W_est (cd, t, rtt);
+
+  /* Number of segments to be acked for cwnd to grow by one segment. In
+   * the TCP-friendly region, follow the standard tcp estimate instead. */
+  segs = 100 * w_cur;
+  if (w_cubic > w_cur)
+    segs = clib_min (segs, w_cur / (w_cubic - w_cur));
+  if (w_est > w_cur)
+    segs = clib_min (segs, w_cur / (w_est - w_cur));
+  cnt = clib_max ((u64) segs, 1);
+
+  tc->cwnd_acc_bytes += tc->bytes_acked;
+  if (tc->cwnd_acc_bytes >= cnt * tc->snd_mss)
+    {
+      inc = tc->cwnd_acc_bytes / (cnt * tc->snd_mss);
+      tc->cwnd_acc_bytes -= inc * cnt * tc->snd_mss;
+      tc->cwnd += inc * tc->snd_mss;
+    }
+  tc->cwnd = clib_min (tc->cwnd, transport_tx_fifo_size (&tc->connection));
+}
+
+static void
+cubic_conn_init (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  tc->ssthresh = tc->snd_wnd;
+  tc->cwnd = tcp_initial_cwnd (tc);
+  cd->w_max = 0;
+  cd->K = 0;
+  cd->t_start = 0;
+}
+
+const static tcp_cc_algorithm_t tcp_cubic = {
+  .name = "cubic",
+  .congestion = cubic_congestion,
+  .recovered = cubic_recovered,
+  .rcv_ack = cubic_rcv_ack,
+  .rcv_cong_ack = newreno_rcv_cong_ack,
+  .init = cubic_conn_init
+};
+
+clib_error_t *
+cubic_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_CUBIC, &tcp_cubic);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (cubic_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
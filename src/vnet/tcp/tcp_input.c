@@ -1223,10 +1223,24 @@ partial_ack:
   tcp_fast_retransmit (tc);
 }
 
+/**
+ * Pick the connection's congestion control algorithm and initialize it.
+ *
+ * Algorithms configured for the connection's fib, e.g., by means of an
+ * app namespace, take precedence over the global default.
+ */
 void
 tcp_cc_init (tcp_connection_t * tc)
 {
-  tc->cc_algo = tcp_cc_algo_get (TCP_CC_NEWRENO);
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_cc_algorithm_type_e type = tm->cc_algo;
+  u8 *by_fib = tm->cc_algo_by_fib_index[tc->c_is_ip4 ? TCP_IP4 : TCP_IP6];
+
+  if (tc->c_fib_index < vec_len (by_fib) && by_fib[tc->c_fib_index])
+    type = by_fib[tc->c_fib_index] - 1;
+
+  memset (tc->cc_data, 0, sizeof (tc->cc_data));
+  tc->cc_algo = tcp_cc_algo_get (type);
   tc->cc_algo->init (tc);
 }
 
@@ -1138,6 +1138,14 @@ tcp_push_hdr_i (tcp_connection_t * tc, vlib_buffer_t * b,
   ASSERT (opts_write_len == tc->snd_opts_len);
   vnet_buffer (b)->tcp.connection_index = tc->c_c_index;
 
+  /* Buffer holds more than one segment, have it segmented on tx */
+  if (data_len > tc->snd_mss)
+    {
+      b->flags |= VNET_BUFFER_F_GSO;
+      vnet_buffer2 (b)->gso_size = tc->snd_mss;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_hdr_opts_len;
+    }
+
   /*
    * Update connection variables
    */
@@ -2029,9 +2037,13 @@ u32
 tcp_push_header (transport_connection_t * tconn, vlib_buffer_t * b)
 {
   tcp_connection_t *tc;
+  u32 snd_nxt;
 
   tc = (tcp_connection_t *) tconn;
+  snd_nxt = tc->snd_nxt;
   tcp_push_hdr_i (tc, b, TCP_STATE_ESTABLISHED, 0);
+  if (tc->pacer.rate)
+    tcp_pacer_consume (tc, tc->snd_nxt - snd_nxt);
   ASSERT (seq_leq (tc->snd_una_max, tc->snd_una + tc->snd_wnd));
 
   if (tc->rtt_ts == 0 && !tcp_in_cong_recovery (tc))
@@ -1426,6 +1426,109 @@ tcp_test_fifo5 (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+/*
+ * Zero-copy chunks, with and without wrapping
+ */
+static int
+tcp_test_fifo6 (vlib_main_t * vm, unformat_input_t * input)
+{
+  svm_fifo_t *f;
+  u32 fifo_size = 400, offset = 350, j = 0;
+  svm_fifo_chunk_t chunks[2];
+  u8 *test_data = 0, *data_buf = 0;
+  int i, rv, verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_error_t *e = clib_error_return
+	    (0, "unknown input `%U'", format_unformat_error, input);
+	  clib_error_report (e);
+	  return -1;
+	}
+    }
+
+  f = fifo_prepare (fifo_size);
+  svm_fifo_init_pointers (f, offset);
+
+  vec_validate (test_data, 399);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+
+  rv = svm_fifo_read_chunks (f, chunks, 100);
+  TCP_TEST ((rv == -2), "read from empty fifo returned %d", rv);
+
+  /*
+   * Write 200 bytes, wrapping after 50
+   */
+  rv = svm_fifo_write_chunks (f, chunks, 200);
+  TCP_TEST ((rv == 200), "write chunks returned %d", rv);
+  TCP_TEST ((chunks[0].data == f->data + offset), "first chunk at tail");
+  TCP_TEST ((chunks[0].len == 50), "first chunk len %u", chunks[0].len);
+  TCP_TEST ((chunks[1].data == f->data), "second chunk at fifo start");
+  TCP_TEST ((chunks[1].len == 150), "second chunk len %u", chunks[1].len);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 0), "fifo has %u bytes before "
+	    "commit", svm_fifo_max_dequeue (f));
+
+  clib_memcpy (chunks[0].data, test_data, chunks[0].len);
+  clib_memcpy (chunks[1].data, test_data + chunks[0].len, chunks[1].len);
+  svm_fifo_enqueue_nocopy (f, 200);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 200), "fifo has %u bytes",
+	    svm_fifo_max_dequeue (f));
+  TCP_TEST ((f->tail == 150), "fifo tail %u", f->tail);
+
+  if (verbose)
+    vlib_cli_output (vm, "fifo after chunk write: %U", format_svm_fifo, f,
+		     1);
+
+  /*
+   * Read it back by reference, in two steps
+   */
+  rv = svm_fifo_read_chunks (f, chunks, 20);
+  TCP_TEST ((rv == 20), "read chunks returned %d", rv);
+  TCP_TEST ((chunks[1].len == 0), "second chunk len %u", chunks[1].len);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 200), "fifo has %u bytes before "
+	    "drop", svm_fifo_max_dequeue (f));
+  svm_fifo_dequeue_drop (f, rv);
+
+  rv = svm_fifo_read_chunks (f, chunks, ~0);
+  TCP_TEST ((rv == 180), "read chunks returned %d", rv);
+  TCP_TEST ((chunks[0].len == 30), "first chunk len %u", chunks[0].len);
+  TCP_TEST ((chunks[1].len == 150), "second chunk len %u", chunks[1].len);
+
+  vec_validate (data_buf, 179);
+  clib_memcpy (data_buf, chunks[0].data, chunks[0].len);
+  clib_memcpy (data_buf + chunks[0].len, chunks[1].data, chunks[1].len);
+  if (compare_data (data_buf, test_data + 20, 0, 180, &j))
+    {
+      TCP_TEST (0, "[%d] read %u expected %u", j, data_buf[j],
+		test_data[j + 20]);
+    }
+
+  svm_fifo_dequeue_drop (f, rv);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 0), "fifo has %u bytes",
+	    svm_fifo_max_dequeue (f));
+  TCP_TEST ((f->head == f->tail), "head %u tail %u", f->head, f->tail);
+
+  /*
+   * Write chunks are limited by free space
+   */
+  svm_fifo_enqueue_nowait (f, 350, test_data);
+  rv = svm_fifo_write_chunks (f, chunks, ~0);
+  TCP_TEST ((rv == 50), "write chunks returned %d", rv);
+  svm_fifo_enqueue_nocopy (f, rv);
+  rv = svm_fifo_write_chunks (f, chunks, ~0);
+  TCP_TEST ((rv == SVM_FIFO_FULL), "write to full fifo returned %d", rv);
+
+  svm_fifo_free (f);
+  vec_free (test_data);
+  vec_free (data_buf);
+  return 0;
+}
+
 /* *INDENT-OFF* */
 svm_fifo_trace_elem_t fifo_trace[] = {};
 /* *INDENT-ON* */
@@ -1518,6 +1621,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
       res = tcp_test_fifo5 (vm, input);
       if (res)
 	return res;
+
+      res = tcp_test_fifo6 (vm, input);
+      if (res)
+	return res;
     }
   else
     {
@@ -1541,6 +1648,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
 	{
 	  res = tcp_test_fifo5 (vm, input);
 	}
+      else if (unformat (input, "fifo6"))
+	{
+	  res = tcp_test_fifo6 (vm, input);
+	}
       else if (unformat (input, "replay"))
 	{
 	  res = tcp_test_fifo_replay (vm, input);
@@ -1657,6 +1768,302 @@ tcp_test_lookup (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+/*
+ * Congestion control tests. A single flow is simulated over a path with
+ * fixed bottleneck bandwidth, base rtt and buffer. The sender transmits its
+ * whole window at the start of every round and acks come back, one per
+ * segment, as fast as the bottleneck allows. Rounds whose window does not
+ * fit in the pipe and the buffer lose one segment that is recovered with
+ * fast retransmit. Time only advances through tcp_main.time_now so results
+ * are deterministic.
+ */
+#define TCP_TEST_CC_MSS		1460
+#define TCP_TEST_CC_RTT		100	/* base rtt in ticks */
+#define TCP_TEST_CC_BW_SEGS	10	/* bottleneck rate in segments/tick */
+#define TCP_TEST_CC_ROUNDS	400
+
+typedef struct
+{
+  u32 *cwnd;			/**< cwnd at the start of every round */
+  u32 max_cwnd;			/**< max cwnd after the first loss */
+  u32 min_cwnd;			/**< min cwnd after the first loss */
+  u32 n_losses;			/**< rounds with loss */
+  u32 last_loss_round;		/**< round of the last loss */
+  u32 cwnd_pre_loss;		/**< cwnd when the first loss happened */
+  u32 cwnd_post_loss;		/**< cwnd once the first loss was detected */
+  u64 delivered;		/**< bytes delivered after the first loss */
+  u64 pacing_rate;		/**< final pacing rate, if algo paces */
+} tcp_test_cc_result_t;
+
+static void
+tcp_test_cc_run (tcp_cc_algorithm_type_e type, tcp_test_cc_result_t * res)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  u32 bdp = TCP_TEST_CC_RTT * TCP_TEST_CC_BW_SEGS * TCP_TEST_CC_MSS;
+  f64 bw = TCP_TEST_CC_BW_SEGS * TCP_TEST_CC_MSS, now, start;
+  u32 pipe = 3 * bdp, round, i, n_segs, time_now;
+  tcp_connection_t _tc, *tc = &_tc;
+  stream_session_t *s;
+
+  memset (res, 0, sizeof (*res));
+  res->min_cwnd = ~0;
+  time_now = tm->time_now[0];
+  now = 1000;
+  tm->time_now[0] = now;
+
+  s = session_alloc (0);
+  s->server_tx_fifo = svm_fifo_create (4 * pipe);
+
+  memset (tc, 0, sizeof (*tc));
+  tc->c_s_index = s->session_index;
+  tc->c_thread_index = 0;
+  tc->state = TCP_STATE_ESTABLISHED;
+  tc->snd_mss = TCP_TEST_CC_MSS;
+  tc->snd_wnd = 4 * pipe;
+  tc->srtt = TCP_TEST_CC_RTT;
+  tc->cc_algo = tcp_cc_algo_get (type);
+  tc->cc_algo->init (tc);
+
+  for (round = 0; round < TCP_TEST_CC_ROUNDS; round++)
+    {
+      vec_add1 (res->cwnd, tc->cwnd);
+      if (res->n_losses)
+	{
+	  res->max_cwnd = clib_max (res->max_cwnd, tc->cwnd);
+	  res->min_cwnd = clib_min (res->min_cwnd, tc->cwnd);
+	}
+
+      n_segs = clib_max (clib_min (tc->cwnd, tc->snd_wnd) / tc->snd_mss, 1);
+      tc->snd_una_max = tc->snd_nxt = tc->snd_una + n_segs * tc->snd_mss;
+      start = now;
+
+      if (n_segs * tc->snd_mss > pipe)
+	{
+	  if (!res->n_losses)
+	    res->cwnd_pre_loss = tc->cwnd;
+	  tc->prev_cwnd = tc->cwnd;
+	  tc->prev_ssthresh = tc->ssthresh;
+	  tcp_cc_init_congestion (tc);
+	  tc->cwnd = tc->ssthresh;
+	  if (!res->n_losses)
+	    res->cwnd_post_loss = tc->cwnd;
+	  res->n_losses += 1;
+	  res->last_loss_round = round;
+
+	  /* Recovery takes the whole round */
+	  now = start + pipe / bw;
+	  tm->time_now[0] = now;
+	  tc->bytes_acked = tc->snd_una_max - tc->snd_una;
+	  tc->snd_una = tc->snd_una_max;
+	  tcp_cc_fastrecovery_exit (tc);
+	  continue;
+	}
+
+      for (i = 0; i < n_segs; i++)
+	{
+	  now = start + clib_max (TCP_TEST_CC_RTT,
+				  (i + 1) * tc->snd_mss / bw);
+	  tm->time_now[0] = now;
+	  tc->snd_una += tc->snd_mss;
+	  tc->bytes_acked = tc->snd_mss;
+	  tc->cc_algo->rcv_ack (tc);
+	  if (res->n_losses)
+	    res->delivered += tc->snd_mss;
+	}
+    }
+
+  if (tc->cc_algo->pacing_rate)
+    res->pacing_rate = tc->cc_algo->pacing_rate (tc);
+
+  tm->time_now[0] = time_now;
+  svm_fifo_free (s->server_tx_fifo);
+  session_free (s);
+}
+
+static int
+tcp_test_cc (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_test_cc_result_t _newreno, *newreno = &_newreno, _cubic, *cubic =
+    &_cubic, _bbr, *bbr = &_bbr;
+  u32 mss = TCP_TEST_CC_MSS, bdp, pipe, i;
+  f64 rate, bw;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  vlib_cli_output (vm, "parse error: '%U'", format_unformat_error,
+			   input);
+	  return -1;
+	}
+    }
+
+  if (!session_manager_is_enabled ())
+    {
+      vlib_cli_output (vm, "session layer must be enabled");
+      return -1;
+    }
+
+  bdp = TCP_TEST_CC_RTT * TCP_TEST_CC_BW_SEGS * mss;
+  pipe = 3 * bdp;
+  bw = TCP_TEST_CC_BW_SEGS * mss * THZ;
+
+  tcp_test_cc_run (TCP_CC_NEWRENO, newreno);
+  tcp_test_cc_run (TCP_CC_CUBIC, cubic);
+  tcp_test_cc_run (TCP_CC_BBR, bbr);
+
+  if (verbose)
+    {
+      vlib_cli_output (vm, "%-8s%-12s%-12s%-12s", "round", "newreno",
+		       "cubic", "bbr");
+      for (i = 0; i < TCP_TEST_CC_ROUNDS; i += 10)
+	vlib_cli_output (vm, "%-8u%-12u%-12u%-12u", i,
+			 newreno->cwnd[i] / mss, cubic->cwnd[i] / mss,
+			 bbr->cwnd[i] / mss);
+    }
+
+  /*
+   * Slow start overshoots the pipe for both loss based algos
+   */
+  TCP_TEST ((newreno->n_losses && cubic->n_losses),
+	    "newreno losses %u cubic losses %u", newreno->n_losses,
+	    cubic->n_losses);
+
+  /*
+   * Multiplicative decrease. NewReno halves the window, CUBIC only
+   * reduces it by 1 - beta
+   */
+  TCP_TEST ((clib_abs ((int) newreno->cwnd_post_loss
+		       - (int) newreno->cwnd_pre_loss / 2) <= mss),
+	    "newreno cwnd after loss %u before %u", newreno->cwnd_post_loss,
+	    newreno->cwnd_pre_loss);
+  TCP_TEST ((clib_abs ((int) cubic->cwnd_post_loss
+		       - (int) (0.7 * cubic->cwnd_pre_loss)) <= mss),
+	    "cubic cwnd after loss %u before %u", cubic->cwnd_post_loss,
+	    cubic->cwnd_pre_loss);
+
+  /*
+   * CUBIC grows back to the pipe size much faster than NewReno and, after
+   * the first loss, keeps at least beta of the pipe in flight
+   */
+  TCP_TEST ((cubic->delivered > newreno->delivered),
+	    "cubic delivered %lu newreno %lu", cubic->delivered,
+	    newreno->delivered);
+  TCP_TEST ((cubic->max_cwnd > newreno->max_cwnd),
+	    "cubic max cwnd %u newreno %u", cubic->max_cwnd,
+	    newreno->max_cwnd);
+  TCP_TEST ((cubic->min_cwnd >= 0.7 * pipe - mss),
+	    "cubic min cwnd %u pipe %u", cubic->min_cwnd, pipe);
+
+  /*
+   * BBR sizes the window from its path model, so it never fills the buffer
+   * and its pacing rate matches the bottleneck, up to the probing gains
+   */
+  TCP_TEST ((bbr->n_losses == 0), "bbr losses %u", bbr->n_losses);
+  for (i = 0; i < TCP_TEST_CC_ROUNDS; i++)
+    bbr->max_cwnd = clib_max (bbr->max_cwnd, bbr->cwnd[i]);
+  TCP_TEST ((bbr->max_cwnd <= pipe), "bbr max cwnd %u pipe %u",
+	    bbr->max_cwnd, pipe);
+  rate = bbr->pacing_rate;
+  TCP_TEST ((rate >= 0.7 * bw && rate <= 1.3 * bw),
+	    "bbr pacing rate %.0f bottleneck %.0f", rate, bw);
+
+  vec_free (newreno->cwnd);
+  vec_free (cubic->cwnd);
+  vec_free (bbr->cwnd);
+  return 0;
+}
+
+static int
+tcp_test_pacer (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_connection_t _tc, *tc = &_tc;
+  u32 mss = 1460, snd_space, rate;
+  f64 now = 100.0;
+
+  if (!vec_len (tm->pacer_wheels))
+    {
+      vlib_cli_output (vm, "tcp must be enabled");
+      return -1;
+    }
+
+  memset (tc, 0, sizeof (*tc));
+  tcp_connection_timers_init (tc);
+  tc->c_c_index = 0x0FFFFFFF;
+  tc->c_thread_index = vlib_get_thread_index ();
+  tc->state = TCP_STATE_ESTABLISHED;
+  tc->snd_mss = mss;
+  tc->cwnd = 100 * mss;
+  tc->ssthresh = 10 * mss;
+  tc->srtt = 10;
+  tc->cc_algo = tcp_cc_algo_get (TCP_CC_NEWRENO);
+  tc->pacer.last_update = now;
+
+  /*
+   * Congestion avoidance rate is 1.2 cwnd per srtt
+   */
+  rate = (u64) tc->cwnd * THZ / tc->srtt * 6 / 5;
+
+  /*
+   * Empty bucket, sending is delayed and session descheduled
+   */
+  snd_space = tcp_pacer_snd_space (tc, 10 * mss, now);
+  TCP_TEST ((tc->pacer.rate == rate), "rate %lu expected %u",
+	    tc->pacer.rate, rate);
+  TCP_TEST ((snd_space == 0), "snd space %u", snd_space);
+  TCP_TEST ((tc->pacer.n_throttled == 1), "throttled %u",
+	    tc->pacer.n_throttled);
+  TCP_TEST ((tc->pacer.timer_handle != TCP_TIMER_HANDLE_INVALID),
+	    "pacer timer should be armed");
+  TCP_TEST ((transport_connection_is_descheduled (&tc->connection)),
+	    "connection should be descheduled");
+
+  /*
+   * One tick later there's enough for one segment
+   */
+  now += TCP_PACER_TICK;
+  snd_space = tcp_pacer_snd_space (tc, 10 * mss, now);
+  TCP_TEST ((snd_space == mss), "snd space %u expected %u", snd_space, mss);
+  tcp_pacer_consume (tc, snd_space);
+  TCP_TEST ((tc->pacer.bucket == (u32) (rate * TCP_PACER_TICK) - mss),
+	    "bucket %u", tc->pacer.bucket);
+
+  /*
+   * After a long pause, the burst is bounded
+   */
+  now += 1.0;
+  snd_space = tcp_pacer_snd_space (tc, 10 * mss, now);
+  TCP_TEST ((tc->pacer.bucket == (u32) (rate * TCP_PACER_BURST_TICKS *
+					TCP_PACER_TICK)),
+	    "bucket %u", tc->pacer.bucket);
+  TCP_TEST ((snd_space == 2 * mss), "snd space %u expected %u", snd_space,
+	    2 * mss);
+
+  /*
+   * Windows smaller than a segment go out as they are
+   */
+  snd_space = tcp_pacer_snd_space (tc, mss / 2, now);
+  TCP_TEST ((snd_space == mss / 2), "snd space %u expected %u", snd_space,
+	    mss / 2);
+
+  /*
+   * No pacing in slow start without an rtt estimate
+   */
+  tc->srtt = 0;
+  snd_space = tcp_pacer_snd_space (tc, 100 * mss, now);
+  TCP_TEST ((snd_space == 100 * mss && tc->pacer.rate == 0),
+	    "snd space %u rate %lu", snd_space, tc->pacer.rate);
+
+  tcp_connection_timers_reset (tc);
+  TCP_TEST ((tc->pacer.timer_handle == TCP_TIMER_HANDLE_INVALID),
+	    "pacer timer should be stopped");
+  return 0;
+}
+
 static int
 tcp_test_session (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -1742,6 +2149,14 @@ tcp_test (vlib_main_t * vm,
 	{
 	  res = tcp_test_lookup (vm, input);
 	}
+      else if (unformat (input, "cc"))
+	{
+	  res = tcp_test_cc (vm, input);
+	}
+      else if (unformat (input, "pacer"))
+	{
+	  res = tcp_test_pacer (vm, input);
+	}
       else if (unformat (input, "all"))
 	{
 	  if ((res = tcp_test_sack (vm, input)))
@@ -1750,6 +2165,10 @@ tcp_test (vlib_main_t * vm,
 	    goto done;
 	  if ((res = tcp_test_lookup (vm, input)))
 	    goto done;
+	  if ((res = tcp_test_cc (vm, input)))
+	    goto done;
+	  if ((res = tcp_test_pacer (vm, input)))
+	    goto done;
 	}
       else
 	break;
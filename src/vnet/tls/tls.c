@@ -42,7 +42,7 @@ int
 tls_add_vpp_q_evt (svm_fifo_t * f, u8 evt_type)
 {
   session_fifo_event_t evt;
-  svm_queue_t *q;
+  svm_ring_t *q;
 
   if (svm_fifo_set_event (f))
     {
@@ -50,9 +50,9 @@ tls_add_vpp_q_evt (svm_fifo_t * f, u8 evt_type)
       evt.event_type = evt_type;
 
       q = session_manager_get_vpp_event_queue (f->master_thread_index);
-      if (PREDICT_TRUE (q->cursize < q->maxsize))
+      if (PREDICT_TRUE (!svm_ring_is_full (q)))
 	{
-	  svm_queue_add (q, (u8 *) & evt, 0 /* do wait for mutex */ );
+	  svm_ring_enqueue (q, &evt, 0 /* wait for space */ );
 	}
       else
 	{
@@ -67,7 +67,7 @@ static inline int
 tls_add_app_q_evt (application_t * app, stream_session_t * app_session)
 {
   session_fifo_event_t evt;
-  svm_queue_t *q;
+  svm_ring_t *q;
 
   if (PREDICT_FALSE (app_session->session_state == SESSION_STATE_CLOSED))
     {
@@ -87,9 +87,9 @@ tls_add_app_q_evt (application_t * app, stream_session_t * app_session)
       evt.event_type = FIFO_EVENT_APP_RX;
       q = app->event_queue;
 
-      if (PREDICT_TRUE (q->cursize < q->maxsize))
+      if (PREDICT_TRUE (!svm_ring_is_full (q)))
 	{
-	  svm_queue_add (q, (u8 *) & evt, 0 /* do wait for mutex */ );
+	  svm_ring_enqueue (q, &evt, 0 /* wait for space */ );
 	}
       else
 	{
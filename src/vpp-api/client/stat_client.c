@@ -0,0 +1,471 @@
+/*
+ *------------------------------------------------------------------
+ * stat_client.c - Library for access to VPP statistics segment
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vppinfra/socket.h>
+#include <vppinfra/time.h>
+#include <svm/ssvm.h>
+#include "stat_client.h"
+
+/* Give up waiting for a directory update after this many seconds */
+#define STAT_SEGMENT_ACCESS_TIMEOUT 1.0
+
+typedef struct
+{
+  /* Local mapping of the segment */
+  u8 *base;
+  u64 memory_size;
+
+  /* Where vpp has the segment mapped */
+  uword ssvm_va;
+
+  stat_segment_shared_header_t *shared_header;
+} stat_client_main_t;
+
+stat_client_main_t stat_client_main;
+
+typedef struct
+{
+  u64 epoch;
+} stat_segment_access_t;
+
+/*
+ * Translate a vpp address into the local mapping,
+ * 0 if it points outside the segment
+ */
+static void *
+stat_segment_pointer (stat_client_main_t * sm, void *p, uword size)
+{
+  uword offset = pointer_to_uword (p) - sm->ssvm_va;
+
+  if (p == 0 || pointer_to_uword (p) < sm->ssvm_va
+      || offset + size > sm->memory_size)
+    return 0;
+
+  return sm->base + offset;
+}
+
+/*
+ * Translate a vpp vector and sanity check its length; a torn read
+ * must not make us copy half the address space.
+ */
+static void *
+stat_segment_vector (stat_client_main_t * sm, void *v, uword elt_size)
+{
+  vec_header_t *vh;
+
+  if (v == 0)
+    return 0;
+
+  vh = stat_segment_pointer (sm, _vec_find (v), sizeof (vec_header_t));
+  if (vh == 0)
+    return 0;
+
+  if (stat_segment_pointer (sm, v, vh->len * elt_size) == 0)
+    return 0;
+
+  return vh->vector_data;
+}
+
+static int
+stat_segment_access_start (stat_segment_access_t * sa,
+			   stat_client_main_t * sm)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  f64 timeout = unix_time_now () + STAT_SEGMENT_ACCESS_TIMEOUT;
+
+  while (shared_header->in_progress != 0)
+    if (unix_time_now () > timeout)
+      return -1;
+
+  sa->epoch = shared_header->epoch;
+  CLIB_MEMORY_BARRIER ();
+  return 0;
+}
+
+static int
+stat_segment_access_end (stat_segment_access_t * sa,
+			 stat_client_main_t * sm)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+
+  CLIB_MEMORY_BARRIER ();
+  if (shared_header->epoch != sa->epoch || shared_header->in_progress)
+    return 0;
+  return 1;
+}
+
+int
+stat_segment_connect (char *socket_name)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  ssvm_shared_header_t *sh;
+  clib_socket_t s = { 0 };
+  clib_error_t *err;
+  struct stat st = { 0 };
+  int mfd = -1;
+  u8 version;
+
+  /* Standalone readers don't have a heap yet */
+  if (clib_mem_get_heap () == 0)
+    clib_mem_init (0, 64 << 20);
+
+  memset (sm, 0, sizeof (*sm));
+  s.config = socket_name ? socket_name : STAT_SEGMENT_SOCKET_FILE;
+  s.flags = CLIB_SOCKET_F_IS_CLIENT | CLIB_SOCKET_F_SEQPACKET;
+  if ((err = clib_socket_init (&s)))
+    {
+      clib_error_report (err);
+      return -1;
+    }
+
+  err = clib_socket_recvmsg (&s, &version, sizeof (version), &mfd, 1);
+  clib_socket_close (&s);
+  if (err)
+    {
+      clib_error_report (err);
+      return -1;
+    }
+
+  if (mfd == -1 || version != STAT_SEGMENT_VERSION)
+    {
+      clib_warning ("bad stat segment fd %d version %d", mfd, version);
+      if (mfd != -1)
+	close (mfd);
+      return -1;
+    }
+
+  if (fstat (mfd, &st) == -1)
+    {
+      clib_unix_warning ("fstat");
+      close (mfd);
+      return -1;
+    }
+
+  sm->base = mmap (0, st.st_size, PROT_READ, MAP_SHARED, mfd, 0);
+  close (mfd);
+  if (sm->base == MAP_FAILED)
+    {
+      clib_unix_warning ("mmap");
+      sm->base = 0;
+      return -1;
+    }
+
+  sh = (ssvm_shared_header_t *) sm->base;
+  sm->memory_size = st.st_size;
+  sm->ssvm_va = sh->ssvm_va;
+  sm->shared_header =
+    stat_segment_pointer (sm, sh->opaque[STAT_SEGMENT_OPAQUE_HEADER],
+			  sizeof (stat_segment_shared_header_t));
+
+  if (sm->shared_header == 0
+      || sm->shared_header->version != STAT_SEGMENT_VERSION)
+    {
+      clib_warning ("stat segment not ready");
+      stat_segment_disconnect ();
+      return -1;
+    }
+
+  return 0;
+}
+
+void
+stat_segment_disconnect (void)
+{
+  stat_client_main_t *sm = &stat_client_main;
+
+  if (sm->base)
+    munmap (sm->base, sm->memory_size);
+  memset (sm, 0, sizeof (*sm));
+}
+
+f64
+stat_segment_heartbeat (void)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  f64 *scalars;
+
+  scalars = stat_segment_vector (sm, sm->shared_header->scalar_vector,
+				 sizeof (f64));
+  if (scalars == 0 || vec_len (scalars) <= STAT_SCALAR_HEARTBEAT)
+    return 0.0;
+  return scalars[STAT_SCALAR_HEARTBEAT];
+}
+
+u8 **
+stat_segment_string_vector (u8 ** string_vector, char *string)
+{
+  u8 *name = format (0, "%s%c", string, 0);
+  vec_add1 (string_vector, name);
+  return string_vector;
+}
+
+static stat_segment_directory_entry_t *
+stat_segment_directory (stat_client_main_t * sm)
+{
+  return stat_segment_vector (sm, sm->shared_header->directory_vector,
+			      sizeof (stat_segment_directory_entry_t));
+}
+
+/*
+ * Returns the directory indices of the entries matching any of the
+ * regular expressions in patterns, or all of them if patterns is 0
+ */
+u32 *
+stat_segment_ls (u8 ** patterns)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  stat_segment_directory_entry_t *directory;
+  stat_segment_access_t sa;
+  regex_t regex[vec_len (patterns)];
+  u32 *dir = 0;
+  int i, j, rv;
+
+  for (i = 0; i < vec_len (patterns); i++)
+    {
+      rv = regcomp (&regex[i], (char *) patterns[i],
+		    REG_EXTENDED | REG_NOSUB);
+      if (rv)
+	{
+	  clib_warning ("could not compile regex %s", patterns[i]);
+	  while (--i >= 0)
+	    regfree (&regex[i]);
+	  return 0;
+	}
+    }
+
+retry:
+  vec_reset_length (dir);
+  if (stat_segment_access_start (&sa, sm))
+    goto done;
+
+  directory = stat_segment_directory (sm);
+  for (j = 0; j < vec_len (directory); j++)
+    {
+      if (vec_len (patterns) == 0)
+	{
+	  vec_add1 (dir, j);
+	  continue;
+	}
+      for (i = 0; i < vec_len (patterns); i++)
+	{
+	  if (regexec (&regex[i], directory[j].name, 0, NULL, 0) == 0)
+	    {
+	      vec_add1 (dir, j);
+	      break;
+	    }
+	}
+    }
+
+  if (!stat_segment_access_end (&sa, sm))
+    goto retry;
+
+done:
+  for (i = 0; i < vec_len (patterns); i++)
+    regfree (&regex[i]);
+
+  return dir;
+}
+
+static void *
+copy_counter_vector (stat_client_main_t * sm, void *data, uword elt_size)
+{
+  void **per_thread, **result = 0;
+  void *v;
+  int i;
+
+  per_thread = stat_segment_vector (sm, data, sizeof (void *));
+  if (per_thread == 0)
+    return 0;
+
+  vec_validate (result, vec_len (per_thread) - 1);
+  for (i = 0; i < vec_len (per_thread); i++)
+    {
+      v = stat_segment_vector (sm, per_thread[i], elt_size);
+      if (v == 0 || vec_len (v) == 0)
+	continue;
+      result[i] = _vec_resize ((void *) 0, vec_len (v),
+			       vec_len (v) * elt_size, 0, 0);
+      clib_memcpy (result[i], v, vec_len (v) * elt_size);
+    }
+  return result;
+}
+
+static stat_segment_data_t
+copy_data (stat_client_main_t * sm, stat_segment_directory_entry_t * ep)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_data_t result = { 0 };
+  u64 **error_vector, *thread_errors;
+  u8 **names;
+  f64 *scalars;
+  u8 *name;
+  int i;
+
+  result.name = strndup (ep->name, STAT_SEGMENT_NAME_MAX);
+  result.type = ep->type;
+
+  switch (ep->type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      scalars = stat_segment_vector (sm, shared_header->scalar_vector,
+				     sizeof (f64));
+      if (scalars && ep->index < vec_len (scalars))
+	result.scalar_value = scalars[ep->index];
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      result.simple_counter_vec =
+	copy_counter_vector (sm, ep->data, sizeof (counter_t));
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      result.combined_counter_vec =
+	copy_counter_vector (sm, ep->data, sizeof (vlib_counter_t));
+      break;
+
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      error_vector = stat_segment_vector (sm, shared_header->error_vector,
+					  sizeof (u64 *));
+      for (i = 0; i < vec_len (error_vector); i++)
+	{
+	  thread_errors = stat_segment_vector (sm, error_vector[i],
+					       sizeof (u64));
+	  if (thread_errors && ep->index < vec_len (thread_errors))
+	    result.error_value += thread_errors[ep->index];
+	}
+      break;
+
+    case STAT_DIR_TYPE_NAME_VECTOR:
+      names = stat_segment_vector (sm, ep->data, sizeof (u8 *));
+      for (i = 0; i < vec_len (names); i++)
+	{
+	  name = stat_segment_vector (sm, names[i], sizeof (u8));
+	  vec_add1 (result.name_vector,
+		    name ? format (0, "%s%c", name, 0) : 0);
+	}
+      break;
+
+    default:
+      fprintf (stderr, "Unknown type: %d\n", ep->type);
+    }
+  return result;
+}
+
+void
+stat_segment_data_free (stat_segment_data_t * res)
+{
+  int i, j;
+
+  for (i = 0; i < vec_len (res); i++)
+    {
+      switch (res[i].type)
+	{
+	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+	  for (j = 0; j < vec_len (res[i].simple_counter_vec); j++)
+	    vec_free (res[i].simple_counter_vec[j]);
+	  vec_free (res[i].simple_counter_vec);
+	  break;
+	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+	  for (j = 0; j < vec_len (res[i].combined_counter_vec); j++)
+	    vec_free (res[i].combined_counter_vec[j]);
+	  vec_free (res[i].combined_counter_vec);
+	  break;
+	case STAT_DIR_TYPE_NAME_VECTOR:
+	  for (j = 0; j < vec_len (res[i].name_vector); j++)
+	    vec_free (res[i].name_vector[j]);
+	  vec_free (res[i].name_vector);
+	  break;
+	default:
+	  break;
+	}
+      free (res[i].name);
+    }
+  vec_free (res);
+}
+
+stat_segment_data_t *
+stat_segment_dump (u32 * stats)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  stat_segment_directory_entry_t *directory;
+  stat_segment_data_t *res = 0;
+  stat_segment_access_t sa;
+  int i;
+
+retry:
+  if (stat_segment_access_start (&sa, sm))
+    return 0;
+
+  directory = stat_segment_directory (sm);
+  for (i = 0; i < vec_len (stats); i++)
+    {
+      if (stats[i] >= vec_len (directory))
+	continue;
+      vec_add1 (res, copy_data (sm, &directory[stats[i]]));
+    }
+
+  if (!stat_segment_access_end (&sa, sm))
+    {
+      stat_segment_data_free (res);
+      res = 0;
+      goto retry;
+    }
+
+  return res;
+}
+
+char *
+stat_segment_index_to_name (u32 index)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  stat_segment_directory_entry_t *directory;
+  stat_segment_access_t sa;
+  char *name = 0;
+
+retry:
+  if (stat_segment_access_start (&sa, sm))
+    return 0;
+
+  directory = stat_segment_directory (sm);
+  if (index < vec_len (directory))
+    name = strndup (directory[index].name, STAT_SEGMENT_NAME_MAX);
+
+  if (!stat_segment_access_end (&sa, sm))
+    {
+      free (name);
+      name = 0;
+      goto retry;
+    }
+
+  return name;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
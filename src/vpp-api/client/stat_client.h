@@ -0,0 +1,65 @@
+/*
+ * stat_client.h - Library for access to VPP statistics segment
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_stat_client_h
+#define included_stat_client_h
+
+#include <vppinfra/vec.h>
+#include <vppinfra/serialize.h>
+#include <vlib/counter.h>
+#include <vpp/stats/stat_segment.h>
+
+/*
+ * Everything returned by the library is a private copy, taken while
+ * the directory epoch was stable. Directory entries are never removed,
+ * so the indices returned by stat_segment_ls stay valid for the life
+ * of the vpp process.
+ */
+typedef struct
+{
+  char *name;
+  stat_directory_type_t type;
+  union
+  {
+    f64 scalar_value;
+    u64 error_value;
+    counter_t **simple_counter_vec;	/* [thread][index] */
+    vlib_counter_t **combined_counter_vec;	/* [thread][index] */
+    u8 **name_vector;
+  };
+} stat_segment_data_t;
+
+int stat_segment_connect (char *socket_name);
+void stat_segment_disconnect (void);
+
+u32 *stat_segment_ls (u8 ** patterns);
+stat_segment_data_t *stat_segment_dump (u32 * stats);
+void stat_segment_data_free (stat_segment_data_t * res);
+char *stat_segment_index_to_name (u32 index);
+
+f64 stat_segment_heartbeat (void);
+u8 **stat_segment_string_vector (u8 ** string_vector, char *string);
+
+#endif /* included_stat_client_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
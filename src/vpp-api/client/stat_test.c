@@ -0,0 +1,163 @@
+/*
+ *------------------------------------------------------------------
+ * stat_test.c - stat segment client smoke test
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Run against a live vpp:
+ *   stat_test [socket-name <path>] [iterations <n>]
+ */
+
+#include <stdio.h>
+#include <vppinfra/format.h>
+#include <vppinfra/time.h>
+#include "stat_client.h"
+
+#define STAT_TEST_CHECK(_cond, _fmt, _args...)                  \
+  do {                                                          \
+    if (!(_cond))                                               \
+      {                                                         \
+        fformat (stderr, "FAIL %s:%d: " _fmt "\n",              \
+                 __FUNCTION__, __LINE__, ##_args);              \
+        return 1;                                               \
+      }                                                         \
+  } while (0)
+
+static int
+stat_test_directory (void)
+{
+  u8 **patterns = 0;
+  u32 *all, *sys;
+  int i;
+
+  all = stat_segment_ls (0);
+  STAT_TEST_CHECK (vec_len (all) > 0, "empty directory");
+
+  /* Indices are dense and stable */
+  for (i = 0; i < vec_len (all); i++)
+    STAT_TEST_CHECK (all[i] == i, "index %d is %d", i, all[i]);
+
+  patterns = stat_segment_string_vector (patterns, "^/sys/");
+  sys = stat_segment_ls (patterns);
+  STAT_TEST_CHECK (vec_len (sys) > 0, "no /sys/ entries");
+  STAT_TEST_CHECK (vec_len (sys) < vec_len (all), "filter didn't filter");
+
+  for (i = 0; i < vec_len (sys); i++)
+    {
+      char *name = stat_segment_index_to_name (sys[i]);
+      STAT_TEST_CHECK (name && !strncmp (name, "/sys/", 5),
+		       "bad match %s", name);
+      free (name);
+    }
+
+  vec_free (all);
+  vec_free (sys);
+  vec_free (patterns[0]);
+  vec_free (patterns);
+  return 0;
+}
+
+static int
+stat_test_dump (int iterations)
+{
+  stat_segment_data_t *res;
+  u8 **patterns = 0;
+  u32 *stats;
+  int i, j, n_threads = -1;
+
+  patterns = stat_segment_string_vector (patterns, "^/if/");
+  patterns = stat_segment_string_vector (patterns, "^/err/");
+  patterns = stat_segment_string_vector (patterns, "^/sys/");
+  stats = stat_segment_ls (patterns);
+  STAT_TEST_CHECK (vec_len (stats) > 0, "nothing to dump");
+
+  /* Repeated dumps must always hand back a consistent snapshot */
+  for (i = 0; i < iterations; i++)
+    {
+      res = stat_segment_dump (stats);
+      STAT_TEST_CHECK (vec_len (res) == vec_len (stats),
+		       "dumped %d of %d", vec_len (res), vec_len (stats));
+
+      for (j = 0; j < vec_len (res); j++)
+	{
+	  STAT_TEST_CHECK (res[j].type != STAT_DIR_TYPE_ILLEGAL,
+			   "illegal type for %s", res[j].name);
+	  if (res[j].type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+	    {
+	      if (n_threads == -1)
+		n_threads = vec_len (res[j].simple_counter_vec);
+	      STAT_TEST_CHECK (vec_len (res[j].simple_counter_vec) ==
+			       n_threads, "%s: %d threads, expected %d",
+			       res[j].name,
+			       vec_len (res[j].simple_counter_vec),
+			       n_threads);
+	    }
+	}
+      stat_segment_data_free (res);
+    }
+
+  vec_free (stats);
+  for (i = 0; i < vec_len (patterns); i++)
+    vec_free (patterns[i]);
+  vec_free (patterns);
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  unformat_input_t _argv, *a = &_argv;
+  u8 *socket_name = (u8 *) STAT_SEGMENT_SOCKET_FILE;
+  int iterations = 1000;
+
+  clib_mem_init (0, 64 << 20);
+  unformat_init_command_line (a, argv);
+
+  while (unformat_check_input (a) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (a, "socket-name %s", &socket_name))
+	vec_add1 (socket_name, 0);
+      else if (unformat (a, "iterations %d", &iterations))
+	;
+      else
+	{
+	  fformat (stderr, "unknown input `%U'\n", format_unformat_error, a);
+	  return 1;
+	}
+    }
+
+  if (stat_segment_connect ((char *) socket_name))
+    {
+      fformat (stderr, "connect to %s failed\n", socket_name);
+      return 1;
+    }
+
+  if (stat_test_directory () || stat_test_dump (iterations))
+    return 1;
+
+  stat_segment_disconnect ();
+  fformat (stdout, "PASS\n");
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
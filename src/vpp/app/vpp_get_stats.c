@@ -0,0 +1,181 @@
+/*
+ *------------------------------------------------------------------
+ * vpp_get_stats.c - dump the vpp stat segment
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <vppinfra/format.h>
+#include <vppinfra/time.h>
+#include <vpp-api/client/stat_client.h>
+
+static void
+print_data (stat_segment_data_t * res)
+{
+  int i, j, k;
+
+  for (i = 0; i < vec_len (res); i++)
+    {
+      switch (res[i].type)
+	{
+	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+	  for (k = 0; k < vec_len (res[i].simple_counter_vec); k++)
+	    for (j = 0; j < vec_len (res[i].simple_counter_vec[k]); j++)
+	      fformat (stdout, "[%d @ %d]: %llu packets %s\n",
+		       j, k, res[i].simple_counter_vec[k][j], res[i].name);
+	  break;
+
+	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+	  for (k = 0; k < vec_len (res[i].combined_counter_vec); k++)
+	    for (j = 0; j < vec_len (res[i].combined_counter_vec[k]); j++)
+	      fformat (stdout, "[%d @ %d]: %llu packets, %llu bytes %s\n",
+		       j, k, res[i].combined_counter_vec[k][j].packets,
+		       res[i].combined_counter_vec[k][j].bytes, res[i].name);
+	  break;
+
+	case STAT_DIR_TYPE_ERROR_INDEX:
+	  fformat (stdout, "%llu %s\n", res[i].error_value, res[i].name);
+	  break;
+
+	case STAT_DIR_TYPE_SCALAR_INDEX:
+	  fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
+	  break;
+
+	case STAT_DIR_TYPE_NAME_VECTOR:
+	  for (k = 0; k < vec_len (res[i].name_vector); k++)
+	    if (res[i].name_vector[k])
+	      fformat (stdout, "[%d]: %s %s\n", k, res[i].name_vector[k],
+		       res[i].name);
+	  break;
+
+	default:
+	  fformat (stderr, "Unknown value %d\n", res[i].type);
+	}
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  unformat_input_t _argv, *a = &_argv;
+  u8 *stat_segment_name, *pattern = 0, **patterns = 0;
+  stat_segment_data_t *res;
+  u32 *stats = 0;
+  f64 heartbeat, interval = 1.0;
+  char *name;
+  int i, rv;
+  enum
+  {
+    STAT_CLIENT_CMD_UNKNOWN,
+    STAT_CLIENT_CMD_LS,
+    STAT_CLIENT_CMD_POLL,
+    STAT_CLIENT_CMD_DUMP,
+  } cmd = STAT_CLIENT_CMD_UNKNOWN;
+
+  clib_mem_init (0, 128 << 20);
+
+  unformat_init_command_line (a, argv);
+
+  stat_segment_name = (u8 *) STAT_SEGMENT_SOCKET_FILE;
+
+  while (unformat_check_input (a) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (a, "socket-name %s", &stat_segment_name))
+	vec_add1 (stat_segment_name, 0);
+      else if (unformat (a, "interval %f", &interval))
+	;
+      else if (unformat (a, "ls"))
+	cmd = STAT_CLIENT_CMD_LS;
+      else if (unformat (a, "dump"))
+	cmd = STAT_CLIENT_CMD_DUMP;
+      else if (unformat (a, "poll"))
+	cmd = STAT_CLIENT_CMD_POLL;
+      else if (unformat (a, "%s", &pattern))
+	{
+	  vec_add1 (pattern, 0);
+	  vec_add1 (patterns, pattern);
+	}
+      else
+	{
+	  fformat (stderr,
+		   "%s: usage [socket-name <name>] [interval <sec>] "
+		   "[ls|dump|poll] <patterns> ...\n", argv[0]);
+	  exit (1);
+	}
+    }
+
+  rv = stat_segment_connect ((char *) stat_segment_name);
+  if (rv)
+    {
+      fformat (stderr, "Couldn't connect to vpp, does %s exist?\n",
+	       stat_segment_name);
+      exit (1);
+    }
+
+  stats = stat_segment_ls (patterns);
+
+  switch (cmd)
+    {
+    case STAT_CLIENT_CMD_LS:
+      /* List all counters */
+      for (i = 0; i < vec_len (stats); i++)
+	{
+	  name = stat_segment_index_to_name (stats[i]);
+	  fformat (stdout, "%s\n", name);
+	  free (name);
+	}
+      break;
+
+    case STAT_CLIENT_CMD_DUMP:
+      res = stat_segment_dump (stats);
+      print_data (res);
+      stat_segment_data_free (res);
+      break;
+
+    case STAT_CLIENT_CMD_POLL:
+      heartbeat = stat_segment_heartbeat ();
+      while (1)
+	{
+	  res = stat_segment_dump (stats);
+	  print_data (res);
+	  stat_segment_data_free (res);
+	  unix_sleep (interval);
+
+	  /* vpp restarted or went away, stop */
+	  if (stat_segment_heartbeat () < heartbeat)
+	    break;
+	  heartbeat = stat_segment_heartbeat ();
+	}
+      break;
+
+    default:
+      fformat (stderr,
+	       "%s: usage [socket-name <name>] [interval <sec>] "
+	       "[ls|dump|poll] <patterns> ...\n", argv[0]);
+    }
+
+  stat_segment_disconnect ();
+
+  exit (0);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,599 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vpp/stats/stats.h>
+
+/*
+ * Directory writers hold the lock and raise in_progress for as long
+ * as the stat heap is pushed, so a reader can never see a vector that
+ * is being reallocated without also seeing the epoch move.
+ */
+static void
+stat_segment_lock (stats_main_t * sm)
+{
+  clib_spinlock_lock (&sm->stat_segment_lock);
+  sm->shared_header->in_progress = 1;
+  CLIB_MEMORY_BARRIER ();
+}
+
+static void
+stat_segment_unlock (stats_main_t * sm)
+{
+  CLIB_MEMORY_BARRIER ();
+  sm->shared_header->epoch++;
+  CLIB_MEMORY_BARRIER ();
+  sm->shared_header->in_progress = 0;
+  clib_spinlock_unlock (&sm->stat_segment_lock);
+}
+
+static void
+stat_segment_pop_heap (stats_main_t * sm, void *oldheap)
+{
+  ssvm_pop_heap (oldheap);
+  stat_segment_unlock (sm);
+}
+
+/*
+ * Find or create a directory entry.
+ * Call with the stat heap pushed.
+ */
+static stat_segment_directory_entry_t *
+stat_segment_directory_entry (stats_main_t * sm, char *name,
+			      stat_directory_type_t type)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_directory_entry_t *ep;
+  uword *p;
+  u8 *key;
+
+  p = hash_get_mem (sm->directory_vector_by_name, name);
+  if (p)
+    return vec_elt_at_index (shared_header->directory_vector, p[0]);
+
+  vec_add2 (shared_header->directory_vector, ep, 1);
+  memset (ep, 0, sizeof (*ep));
+  ep->type = type;
+  strncpy (ep->name, name, STAT_SEGMENT_NAME_MAX - 1);
+
+  key = format (0, "%s%c", name, 0);
+  hash_set_mem (sm->directory_vector_by_name, key,
+		ep - shared_header->directory_vector);
+  return ep;
+}
+
+void *
+vlib_stats_push_heap (void)
+{
+  stats_main_t *sm = &stats_main;
+  ssvm_private_t *ssvmp = &sm->stat_segment;
+
+  if (PREDICT_FALSE (sm->shared_header == 0))
+    return 0;
+
+  stat_segment_lock (sm);
+  return ssvm_push_heap (ssvmp->sh);
+}
+
+void
+vlib_stats_pop_heap (void *cm_arg, void *oldheap, int is_combined)
+{
+  stats_main_t *sm = &stats_main;
+  stat_segment_directory_entry_t *ep;
+
+  if (oldheap == 0)
+    return;
+
+  if (is_combined)
+    {
+      vlib_combined_counter_main_t *cm = cm_arg;
+      ep = stat_segment_directory_entry
+	(sm, cm->stat_segment_name, STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED);
+      ep->data = cm->counters;
+    }
+  else
+    {
+      vlib_simple_counter_main_t *cm = cm_arg;
+      ep = stat_segment_directory_entry
+	(sm, cm->stat_segment_name, STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE);
+      ep->data = cm->counters;
+    }
+
+  stat_segment_pop_heap (sm, oldheap);
+}
+
+void
+vlib_stats_pop_heap2 (u64 * error_vector, u32 thread_index, void *oldheap)
+{
+  stats_main_t *sm = &stats_main;
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+
+  if (oldheap == 0)
+    return;
+
+  vec_validate (shared_header->error_vector, thread_index);
+  shared_header->error_vector[thread_index] = error_vector;
+
+  stat_segment_pop_heap (sm, oldheap);
+}
+
+void
+vlib_stats_register_error_index (u8 * name, u64 index)
+{
+  stats_main_t *sm = &stats_main;
+  stat_segment_directory_entry_t *ep;
+  void *oldheap;
+
+  oldheap = vlib_stats_push_heap ();
+  if (oldheap == 0)
+    return;
+
+  ep = stat_segment_directory_entry (sm, (char *) name,
+				     STAT_DIR_TYPE_ERROR_INDEX);
+  ep->index = index;
+
+  stat_segment_pop_heap (sm, oldheap);
+}
+
+static void
+stat_segment_update_node_names (stats_main_t * sm, vlib_node_t ** nodes)
+{
+  stat_segment_directory_entry_t *ep;
+  void *oldheap;
+  int i;
+
+  oldheap = vlib_stats_push_heap ();
+  if (oldheap == 0)
+    return;
+
+  for (i = 0; i < vec_len (sm->node_names); i++)
+    vec_free (sm->node_names[i]);
+  vec_free (sm->node_names);
+
+  vec_validate (sm->node_names, vec_len (nodes) - 1);
+  for (i = 0; i < vec_len (nodes); i++)
+    sm->node_names[i] = format (0, "%v%c", nodes[i]->name, 0);
+
+  ep = stat_segment_directory_entry (sm, "/sys/node/names",
+				     STAT_DIR_TYPE_NAME_VECTOR);
+  ep->data = sm->node_names;
+
+  stat_segment_pop_heap (sm, oldheap);
+}
+
+/*
+ * Called from vlib_main() right after the thread setup, before any
+ * counter or error vector is allocated.
+ */
+void
+vlib_map_stat_segment_init (void)
+{
+  stats_main_t *sm = &stats_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  ssvm_private_t *ssvmp = &sm->stat_segment;
+  stat_segment_shared_header_t *shared_header;
+  stat_segment_directory_entry_t *ep;
+  void *oldheap;
+  int rv;
+
+  ssvmp->ssvm_size = sm->memory_size ? sm->memory_size :
+    STAT_SEGMENT_DEFAULT_SIZE;
+  ssvmp->i_am_master = 1;
+  ssvmp->my_pid = getpid ();
+  ssvmp->name = format (0, "/stats%c", 0);
+  ssvmp->requested_va = 0;
+
+  rv = ssvm_master_init (ssvmp, SSVM_SEGMENT_MEMFD);
+  if (rv)
+    {
+      clib_warning ("stat segment create failed, rv %d", rv);
+      return;
+    }
+
+  clib_spinlock_init (&sm->stat_segment_lock);
+
+  oldheap = ssvm_push_heap (ssvmp->sh);
+
+  shared_header = clib_mem_alloc_aligned (sizeof (*shared_header),
+					  CLIB_CACHE_LINE_BYTES);
+  /* not memset (), gcc 12 can't see the allocation size through
+     clib_mem_alloc_aligned () and warns about the bounds */
+  *shared_header = (stat_segment_shared_header_t)
+  {
+  .version = STAT_SEGMENT_VERSION};
+  vec_validate (shared_header->error_vector, tm->n_vlib_mains - 1);
+  vec_validate_aligned (shared_header->scalar_vector, STAT_N_SCALARS - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  sm->shared_header = shared_header;
+  sm->directory_vector_by_name = hash_create_string (0, sizeof (uword));
+
+#define _(E,n)                                                          \
+  ep = stat_segment_directory_entry (sm, n, STAT_DIR_TYPE_SCALAR_INDEX); \
+  ep->index = STAT_SCALAR_##E;
+  foreach_stat_segment_scalar;
+#undef _
+
+  ssvmp->sh->opaque[STAT_SEGMENT_OPAQUE_HEADER] = shared_header;
+  ssvmp->sh->ready = 1;
+
+  ssvm_pop_heap (oldheap);
+
+#define _(E,n)                                                          \
+  sm->node_counters[STAT_NODE_COUNTER_##E].name = #n;                   \
+  sm->node_counters[STAT_NODE_COUNTER_##E].stat_segment_name =          \
+    "/sys/node/" #n;
+  foreach_stat_segment_node_counter;
+#undef _
+}
+
+static void
+do_stat_segment_updates (stats_main_t * sm)
+{
+  vlib_main_t *vm = vlib_mains[0];
+  f64 *scalars = sm->shared_header->scalar_vector;
+  vlib_main_t *this_vlib_main;
+  vlib_node_runtime_t *r;
+  vlib_node_t **nodes, *n;
+  vlib_perf_node_stats_t *ns;
+  f64 vector_rate = 0.0, now;
+  u64 input_vectors = 0;
+  u64 calls, vectors, clocks;
+  u32 n_nodes, first_thread;
+  int i, j;
+
+  n_nodes = vec_len (vm->node_main.nodes);
+  if (n_nodes != vec_len (sm->node_names))
+    {
+      stat_segment_update_node_names (sm, vm->node_main.nodes);
+      for (j = 0; j < STAT_NODE_N_COUNTERS; j++)
+	vlib_validate_simple_counter (&sm->node_counters[j], n_nodes - 1);
+    }
+
+  /*
+   * Racy reads of the per-thread node runtimes, exactly what
+   * "show runtime" would see; no barrier, no work for the workers.
+   */
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vlib_main = vlib_mains[i];
+      nodes = this_vlib_main->node_main.nodes;
+
+      for (j = 0; j < clib_min (n_nodes, vec_len (nodes)); j++)
+	{
+	  n = nodes[j];
+	  r = vlib_node_get_runtime (this_vlib_main, n->index);
+
+	  calls = n->stats_total.calls + r->calls_since_last_overflow;
+	  vectors = n->stats_total.vectors + r->vectors_since_last_overflow;
+	  clocks = n->stats_total.clocks + r->clocks_since_last_overflow;
+
+	  sm->node_counters[STAT_NODE_COUNTER_CALLS].counters[i][j] = calls;
+	  sm->node_counters[STAT_NODE_COUNTER_VECTORS].counters[i][j] =
+	    vectors;
+	  sm->node_counters[STAT_NODE_COUNTER_CLOCKS].counters[i][j] = clocks;
+	  sm->node_counters[STAT_NODE_COUNTER_SUSPENDS].counters[i][j] =
+	    n->stats_total.suspends;
+
+	  if (n->type == VLIB_NODE_TYPE_INPUT)
+	    input_vectors += vectors;
+	}
+
+      /* node profiler, if it ever ran on this thread */
+      ns = i < vec_len (vlib_perf_main.threads) ?
+	__atomic_load_n (&vlib_perf_main.threads[i].nodes,
+			 __ATOMIC_ACQUIRE) : 0;
+      for (j = 0; j < clib_min (n_nodes, vec_len (ns)); j++)
+	{
+	  sm->node_counters[STAT_NODE_COUNTER_PERF_CALLS].counters[i][j] =
+	    ns[j].calls;
+	  sm->node_counters[STAT_NODE_COUNTER_PERF_VECTORS].counters[i][j] =
+	    ns[j].vectors;
+#define _(E,n,t,c)							\
+	  sm->node_counters[STAT_NODE_COUNTER_PERF_##E].counters[i][j] =	\
+	    ns[j].counts[VLIB_PERF_COUNTER_##E];
+	  foreach_vlib_perf_counter;
+#undef _
+	}
+    }
+
+  /* Average over the workers, the main thread is mostly idle */
+  first_thread = vec_len (vlib_mains) > 1 ? 1 : 0;
+  for (i = first_thread; i < vec_len (vlib_mains); i++)
+    vector_rate += vlib_last_vector_length_per_node (vlib_mains[i]);
+  vector_rate /= (f64) (vec_len (vlib_mains) - first_thread);
+
+  now = vlib_time_now (vm);
+  scalars[STAT_SCALAR_VECTOR_RATE] = vector_rate;
+  if (sm->last_input_time > 0.0 && now > sm->last_input_time)
+    scalars[STAT_SCALAR_INPUT_RATE] =
+      (f64) (input_vectors - sm->last_input_vectors) /
+      (now - sm->last_input_time);
+  sm->last_input_vectors = input_vectors;
+  sm->last_input_time = now;
+
+  scalars[STAT_SCALAR_LAST_STATS_CLEAR] =
+    vm->node_main.time_last_runtime_stats_clear;
+  scalars[STAT_SCALAR_LAST_UPDATE] = now;
+  scalars[STAT_SCALAR_HEARTBEAT] += 1.0;
+}
+
+static clib_error_t *
+stats_socket_accept_ready (clib_file_t * uf)
+{
+  stats_main_t *sm = &stats_main;
+  ssvm_private_t *ssvmp = &sm->stat_segment;
+  clib_socket_t client = { 0 };
+  clib_error_t *err;
+  u8 version = STAT_SEGMENT_VERSION;
+
+  err = clib_socket_accept (sm->socket, &client);
+  if (err)
+    {
+      clib_error_report (err);
+      return err;
+    }
+
+  /* Hand the segment fd over and hang up */
+  err = clib_socket_sendmsg (&client, &version, sizeof (version),
+			     &ssvmp->fd, 1);
+  if (err)
+    clib_error_report (err);
+  clib_socket_close (&client);
+
+  return 0;
+}
+
+static void
+stats_segment_socket_init (stats_main_t * sm)
+{
+  clib_file_t template = { 0 };
+  clib_error_t *error;
+  clib_socket_t *s;
+
+  if (sm->socket_name == 0)
+    sm->socket_name = format (0, "%s%c", STAT_SEGMENT_SOCKET_FILE, 0);
+
+  /* mkdir of file socket, only under /run  */
+  if (strncmp ((char *) sm->socket_name, "/run", 4) == 0)
+    {
+      u8 *tmp = format (0, "%s", sm->socket_name);
+      int i = vec_len (tmp);
+      while (i && tmp[--i] != '/')
+	;
+
+      tmp[i] = 0;
+
+      if (i)
+	vlib_unix_recursive_mkdir ((char *) tmp);
+      vec_free (tmp);
+    }
+
+  s = clib_mem_alloc (sizeof (*s));
+  memset (s, 0, sizeof (*s));
+  s->config = (char *) sm->socket_name;
+  s->flags = CLIB_SOCKET_F_IS_SERVER | CLIB_SOCKET_F_SEQPACKET |
+    CLIB_SOCKET_F_ALLOW_GROUP_WRITE;
+
+  if ((error = clib_socket_init (s)))
+    {
+      clib_error_report (error);
+      clib_mem_free (s);
+      return;
+    }
+
+  template.read_function = stats_socket_accept_ready;
+  template.file_descriptor = s->fd;
+  template.description = format (0, "stats segment listener %s", s->config);
+  clib_file_add (&file_main, &template);
+
+  sm->socket = s;
+}
+
+static uword
+stat_segment_collector_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+				vlib_frame_t * f)
+{
+  stats_main_t *sm = &stats_main;
+
+  if (sm->shared_header == 0)
+    return 0;
+
+  stats_segment_socket_init (sm);
+
+  if (sm->update_interval == 0.0)
+    sm->update_interval = STAT_SEGMENT_DEFAULT_UPDATE_INTERVAL;
+
+  while (1)
+    {
+      do_stat_segment_updates (sm);
+      vlib_process_suspend (vm, sm->update_interval);
+    }
+  return 0;			/* or not */
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (stat_segment_collector, static) =
+{
+  .function = stat_segment_collector_process,
+  .name = "statseg-collector-process",
+  .type = VLIB_NODE_TYPE_PROCESS,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_stat_dir_type (u8 * s, va_list * args)
+{
+  stat_directory_type_t type = va_arg (*args, stat_directory_type_t);
+  char *type_name;
+
+  switch (type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      type_name = "ScalarPtr";
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      type_name = "CMainPtr";
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      type_name = "CombinedPtr";
+      break;
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      type_name = "ErrIndex";
+      break;
+    case STAT_DIR_TYPE_NAME_VECTOR:
+      type_name = "NameVector";
+      break;
+    default:
+      type_name = "illegal!";
+      break;
+    }
+
+  return format (s, "%s", type_name);
+}
+
+static clib_error_t *
+show_stat_segment_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  stats_main_t *sm = &stats_main;
+  ssvm_private_t *ssvmp = &sm->stat_segment;
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_directory_entry_t *show_data, *ep;
+  int verbose = 0;
+  f64 value;
+  u64 error_value;
+  int i, j;
+
+  if (shared_header == 0)
+    return clib_error_return (0, "stat segment not mapped");
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  /* Lock even as reader, as this command doesn't handle epoch changes */
+  clib_spinlock_lock (&sm->stat_segment_lock);
+  show_data = vec_dup (shared_header->directory_vector);
+  clib_spinlock_unlock (&sm->stat_segment_lock);
+
+  vlib_cli_output (vm, "%-60s %10s %20s", "Name", "Type", "Value");
+
+  for (i = 0; i < vec_len (show_data); i++)
+    {
+      ep = vec_elt_at_index (show_data, i);
+
+      switch (ep->type)
+	{
+	case STAT_DIR_TYPE_SCALAR_INDEX:
+	  value = shared_header->scalar_vector[ep->index];
+	  vlib_cli_output (vm, "%-60s %10U %20.2f", ep->name,
+			   format_stat_dir_type, ep->type, value);
+	  break;
+
+	case STAT_DIR_TYPE_ERROR_INDEX:
+	  error_value = 0;
+	  for (j = 0; j < vec_len (shared_header->error_vector); j++)
+	    if (ep->index < vec_len (shared_header->error_vector[j]))
+	      error_value += shared_header->error_vector[j][ep->index];
+	  vlib_cli_output (vm, "%-60s %10U %20llu", ep->name,
+			   format_stat_dir_type, ep->type, error_value);
+	  break;
+
+	default:
+	  vlib_cli_output (vm, "%-60s %10U %20p", ep->name,
+			   format_stat_dir_type, ep->type, ep->data);
+	  break;
+	}
+    }
+
+  vec_free (show_data);
+
+  vlib_cli_output (vm, "epoch %lld, socket %s", shared_header->epoch,
+		   sm->socket_name);
+  if (verbose)
+    vlib_cli_output (vm, "%U", format_mheap, ssvmp->sh->heap,
+		     0 /* verbose */ );
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+/*?
+ * Show the stat segment directory: name, type and, for scalars and
+ * error counters, the current value.
+ *
+ * @cliexpar
+ * @cliexstart{show statistics segment}
+ * Name                                                               Type                Value
+ * /sys/vector_rate                                             ScalarPtr                 0.00
+ * ...
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (show_stat_segment_command, static) =
+{
+  .path = "show statistics segment",
+  .short_help = "show statistics segment [verbose]",
+  .function = show_stat_segment_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+statseg_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  stats_main_t *sm = &stats_main;
+  uword memory_size;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "socket-name %s", &sm->socket_name))
+	;
+      else if (unformat (input, "default"))
+	sm->socket_name = format (0, "%s%c", STAT_SEGMENT_SOCKET_FILE, 0);
+      else if (unformat (input, "size %U", unformat_memory_size,
+			 &memory_size))
+	sm->memory_size = memory_size;
+      else if (unformat (input, "update-interval %f", &sm->update_interval))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+/* statseg { ... } configuration. */
+/*?
+ *
+ * @cfgcmd{socket-name, &lt;path&gt;}
+ * Socket handing out the stat segment file descriptor,
+ * default /run/vpp/stats.sock.
+ *
+ * @cfgcmd{size, &lt;nn&gt;[KMG]}
+ * Stat segment size, default 32M. Named counter vectors, e.g. FIB
+ * counters, are allocated in the segment; large FIBs need more.
+ *
+ * @cfgcmd{update-interval, &lt;seconds&gt;}
+ * How often scalars and node counters are refreshed, default 10.
+ *
+?*/
+VLIB_EARLY_CONFIG_FUNCTION (statseg_config, "statseg");
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef included_stat_segment_h
+#define included_stat_segment_h
+
+/**
+ * @file
+ * @brief Shared memory statistics segment layout.
+ *
+ * The stat segment is a memfd ssvm segment owned by vpp. Named counter
+ * vectors, error counters and a handful of scalars are allocated directly
+ * in it, so workers update them in place and readers scrape them without
+ * any help from the data plane.
+ *
+ * The directory is a vector of fixed size entries. Whenever vpp changes
+ * the directory or reallocates a vector it points at, it raises
+ * in_progress, makes the change, bumps the epoch and drops in_progress.
+ * Readers take a snapshot of the epoch, copy what they need and retry
+ * if the epoch moved or an update was in progress. All pointers are vpp
+ * virtual addresses; readers rebase them against ssvm_va.
+ *
+ * This header is shared with the client library, so it must only
+ * depend on vppinfra.
+ */
+
+#include <vppinfra/types.h>
+
+/** Default socket handing out the segment file descriptor */
+#define STAT_SEGMENT_SOCKET_FILE "/run/vpp/stats.sock"
+
+/** Bump when the shared layout changes */
+#define STAT_SEGMENT_VERSION 1
+
+/** ssvm_shared_header_t opaque[] slot holding the stat shared header */
+#define STAT_SEGMENT_OPAQUE_HEADER 0
+
+#define STAT_SEGMENT_NAME_MAX 128
+
+typedef enum
+{
+  STAT_DIR_TYPE_ILLEGAL = 0,
+  STAT_DIR_TYPE_SCALAR_INDEX,
+  STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE,
+  STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED,
+  STAT_DIR_TYPE_ERROR_INDEX,
+  STAT_DIR_TYPE_NAME_VECTOR,
+} stat_directory_type_t;
+
+typedef struct
+{
+  stat_directory_type_t type;
+  union
+  {
+    /** scalar_vector or per-thread error vector index */
+    u64 index;
+    /** counter_t ** / vlib_counter_t ** / u8 ** vector, vpp address */
+    void *data;
+  };
+  char name[STAT_SEGMENT_NAME_MAX];
+} stat_segment_directory_entry_t;
+
+#define foreach_stat_segment_scalar			\
+_(VECTOR_RATE, "/sys/vector_rate")			\
+_(INPUT_RATE, "/sys/input_rate")			\
+_(LAST_UPDATE, "/sys/last_update")			\
+_(LAST_STATS_CLEAR, "/sys/last_stats_clear")		\
+_(HEARTBEAT, "/sys/heartbeat")
+
+typedef enum
+{
+#define _(E,n) STAT_SCALAR_##E,
+  foreach_stat_segment_scalar
+#undef _
+    STAT_N_SCALARS,
+} stat_segment_scalar_t;
+
+typedef struct
+{
+  u64 version;
+
+  /** Directory change marker, see file comment */
+  volatile u64 epoch;
+  volatile u64 in_progress;
+
+  /** Vector of directory entries */
+  stat_segment_directory_entry_t *directory_vector;
+
+  /** Per-thread error counter vectors, indexed by error heap index */
+  u64 **error_vector;
+
+  /** Scalars, indexed by stat_segment_scalar_t */
+  f64 *scalar_vector;
+} stat_segment_shared_header_t;
+
+#endif /* included_stat_segment_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -21,12 +21,17 @@
 #include <vnet/interface.h>
 #include <pthread.h>
 #include <vlib/threads.h>
+#include <vlib/perf.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/mfib/mfib_table.h>
 #include <vlib/unix/unix.h>
 #include <vlibmemory/api.h>
 #include <vlibapi/api_helper_macros.h>
 #include <svm/queue.h>
+#include <svm/ssvm.h>
+#include <vppinfra/lock.h>
+#include <vppinfra/socket.h>
+#include <vpp/stats/stat_segment.h>
 
 typedef struct
 {
@@ -96,6 +101,33 @@ typedef struct
 } vpe_client_stats_registration_t;
 
 
+/* Per-node runtime counters exported via the stat segment. The perf_
+   ones come from the node profiler, see vlib/perf.h, and only cover the
+   dispatches it sampled. */
+#define foreach_stat_segment_node_counter	\
+_(CALLS, calls)					\
+_(VECTORS, vectors)				\
+_(CLOCKS, clocks)				\
+_(SUSPENDS, suspends)				\
+_(PERF_CALLS, perf_calls)			\
+_(PERF_VECTORS, perf_vectors)			\
+_(PERF_INSTRUCTIONS, perf_instructions)		\
+_(PERF_CYCLES, perf_cycles)			\
+_(PERF_L1D_MISSES, perf_l1d_misses)		\
+_(PERF_LLC_MISSES, perf_llc_misses)		\
+_(PERF_BRANCH_MISSES, perf_branch_misses)
+
+typedef enum
+{
+#define _(E,n) STAT_NODE_COUNTER_##E,
+  foreach_stat_segment_node_counter
+#undef _
+    STAT_NODE_N_COUNTERS,
+} stat_segment_node_counter_t;
+
+#define STAT_SEGMENT_DEFAULT_SIZE (32 << 20)
+#define STAT_SEGMENT_DEFAULT_UPDATE_INTERVAL 10.0
+
 typedef struct
 {
   void *mheap;
@@ -157,6 +189,34 @@ typedef struct
   vpe_client_stats_registration_t **regs_tmp;
   vpe_client_registration_t **clients_tmp;
 
+  /*
+   * Shared memory stat segment, see stat_segment.h
+   */
+  ssvm_private_t stat_segment;
+  stat_segment_shared_header_t *shared_header;
+
+  /* Directory index by name, lives in the stat segment heap */
+  uword *directory_vector_by_name;
+
+  /* Serializes directory writers, held between push and pop heap */
+  clib_spinlock_t stat_segment_lock;
+
+  /* Configuration */
+  u64 memory_size;
+  u8 *socket_name;
+  f64 update_interval;
+
+  /* Hands the segment fd to readers */
+  clib_socket_t *socket;
+
+  /* Per-node counters and the node name vector */
+  vlib_simple_counter_main_t node_counters[STAT_NODE_N_COUNTERS];
+  u8 **node_names;
+
+  /* Input rate computation */
+  u64 last_input_vectors;
+  f64 last_input_time;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -336,18 +336,26 @@ os_exit (int code)
   exit (code);
 }
 
-#ifdef BARRIER_TRACING
+/* message name, barrier stats are kept per api message */
+static const char *api_barrier_context;
+
 void
 vl_msg_api_barrier_trace_context (const char *context)
 {
+#ifdef BARRIER_TRACING
   vlib_worker_threads[0].barrier_context = context;
-}
 #endif
+  api_barrier_context = context;
+}
 
 void
 vl_msg_api_barrier_sync (void)
 {
-  vlib_worker_thread_barrier_sync (vlib_get_main ());
+  const char *caller = api_barrier_context;
+
+  api_barrier_context = 0;
+  vlib_worker_thread_barrier_sync_int (vlib_get_main (),
+				       caller ? caller : __FUNCTION__);
 }
 
 void
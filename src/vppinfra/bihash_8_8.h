@@ -85,6 +85,44 @@ clib_bihash_key_compare_8_8 (u64 a, u64 b)
   return a == b;
 }
 
+/** Compare a key with all keys of a kvp page at once
+    @param kvp - the page's BIHASH_KVP_PER_PAGE (key,value) pairs
+    @param search_key - the (key,value) pair to look for, key only
+    @return bitmap of the kvps with a matching key
+*/
+static inline u32
+clib_bihash_key_match_page_8_8 (clib_bihash_kv_8_8_t * kvp,
+				clib_bihash_kv_8_8_t * search_key)
+{
+#if defined (CLIB_HAVE_VEC256)
+  u64x4 key = u64x4_splat (search_key->key);
+  u32 m0, m1;
+
+  /* keys are in lanes 0 and 2, values in 1 and 3 */
+  m0 = u8x32_msb_mask ((u8x32) (u64x4_load_unaligned (kvp) == key));
+  m1 = u8x32_msb_mask ((u8x32) (u64x4_load_unaligned (kvp + 2) == key));
+  return ((m0 & 1) | ((m0 >> 15) & 2) | ((m1 & 1) << 2) |
+	  ((m1 >> 13) & 8));
+#elif defined (CLIB_HAVE_VEC128) && defined (CLIB_HAVE_VEC128_MSB_MASK) \
+  && defined (CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE)
+  u64x2 key = u64x2_splat (search_key->key);
+  u32 m = 0, i;
+
+  for (i = 0; i < 4; i++)
+    m |= (u8x16_msb_mask ((u8x16) (u64x2_load_unaligned (kvp + i) == key))
+	  & 1) << i;
+  return m;
+#else
+  u32 m = 0, i;
+
+  for (i = 0; i < 4; i++)
+    m |= (kvp[i].key == search_key->key) << i;
+  return m;
+#endif
+}
+
+#define BIHASH_HAVE_KEY_MATCH_PAGE
+
 #undef __included_bihash_template_h__
 #include <vppinfra/bihash_template.h>
 
@@ -118,6 +118,20 @@ void clib_bihash_free (clib_bihash * h);
 */
 int clib_bihash_add_del (clib_bihash * h, clib_bihash_kv * add_v, int is_add);
 
+/** Add or delete several (key,value) pairs from a bi-hash table
+
+    @param h - the bi-hash table to search
+    @param add_v - the (key,value) pairs to add or delete
+    @param n_kvs - number of pairs
+    @param is_add - add=1, delete=0
+    @returns number of pairs which could not be added or deleted
+    @note Takes the writer lock once for the whole batch, instead of once
+    per pair as clib_bihash_add_del does. Pairs are added in order, so a
+    later pair replaces an earlier one with the same key
+*/
+u32 clib_bihash_add_del_batch (clib_bihash * h, clib_bihash_kv * add_v,
+			       u32 n_kvs, int is_add);
+
 
 /** Search a bi-hash table, use supplied hash code
 
@@ -165,6 +179,24 @@ void clib_bihash_prefetch_data (clib_bihash * h, u64 hash);
 int clib_bihash_search_inline_2
   (clib_bihash * h, clib_bihash_kv * search_key, clib_bihash_kv * valuep);
 
+/** Search a bi-hash table for several keys
+
+    Hashes keys, prefetches their buckets, then their (key,value) pages,
+    BIHASH_SEARCH_BATCH_LOOKAHEAD keys ahead of the compares, so that
+    cache misses of different keys overlap.
+
+    @param h - the bi-hash table to search
+    @param search_keys - (key,value) pairs containing the search keys
+    @param valuep - (key,value) pairs set to the search results, may be
+    search_keys
+    @param found - set to 1 for each key found, 0 otherwise
+    @param n_keys - number of keys to search for
+    @returns number of keys found
+*/
+u32 clib_bihash_search_batch
+  (clib_bihash * h, clib_bihash_kv * search_keys, clib_bihash_kv * valuep,
+   u8 * found, u32 n_keys);
+
 /** Visit active (key,value) pairs in a bi-hash table
 
     @param h - the bi-hash table to search
@@ -260,7 +260,8 @@ BV (split_and_rehash_linear)
   return new_values;
 }
 
-int BV (clib_bihash_add_del)
+/* Called with the writer lock held */
+static int BV (clib_bihash_add_del_locked)
   (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add)
 {
   u32 bucket_index;
@@ -283,9 +284,6 @@ int BV (clib_bihash_add_del)
 
   tmp_b.linear_search = 0;
 
-  while (__sync_lock_test_and_set (h->writer_lock, 1))
-    ;
-
   /* First elt in the bucket? */
   if (b->offset == 0)
     {
@@ -448,11 +446,50 @@ free_old_bucket:
 unlock:
   BV (clib_bihash_reset_cache) (b);
   BV (clib_bihash_unlock_bucket) (b);
+  return rv;
+}
+
+int BV (clib_bihash_add_del)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add)
+{
+  int rv;
+
+  while (__sync_lock_test_and_set (h->writer_lock, 1))
+    ;
+
+  rv = BV (clib_bihash_add_del_locked) (h, add_v, is_add);
+
   CLIB_MEMORY_BARRIER ();
   h->writer_lock[0] = 0;
   return rv;
 }
 
+/*
+ * Take the writer lock once for all the pairs, rather than once per pair.
+ * Writers on other threads wait for the whole batch, so keep batches to
+ * about a frame's worth.
+ */
+u32 BV (clib_bihash_add_del_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, u32 n_kvs,
+   int is_add)
+{
+  u32 i, n_errors = 0;
+
+  if (n_kvs == 0)
+    return 0;
+
+  while (__sync_lock_test_and_set (h->writer_lock, 1))
+    ;
+
+  for (i = 0; i < n_kvs; i++)
+    if (BV (clib_bihash_add_del_locked) (h, add_v + i, is_add) < 0)
+      n_errors++;
+
+  CLIB_MEMORY_BARRIER ();
+  h->writer_lock[0] = 0;
+  return n_errors;
+}
+
 int BV (clib_bihash_search)
   (BVT (clib_bihash) * h,
    BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
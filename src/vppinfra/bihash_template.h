@@ -259,6 +259,9 @@ void BV (clib_bihash_free) (BVT (clib_bihash) * h);
 
 int BV (clib_bihash_add_del) (BVT (clib_bihash) * h,
 			      BVT (clib_bihash_kv) * add_v, int is_add);
+u32 BV (clib_bihash_add_del_batch) (BVT (clib_bihash) * h,
+				    BVT (clib_bihash_kv) * add_v, u32 n_kvs,
+				    int is_add);
 int BV (clib_bihash_search) (BVT (clib_bihash) * h,
 			     BVT (clib_bihash_kv) * search_v,
 			     BVT (clib_bihash_kv) * return_v);
@@ -461,6 +464,159 @@ static inline int BV (clib_bihash_search_inline_2)
   return -1;
 }
 
+#ifndef BIHASH_HAVE_KEY_MATCH_PAGE
+/*
+ * Bitmap of the kvps in a page whose key matches search_key. Key types
+ * that can compare a whole page at once, e.g. with vector instructions,
+ * define BIHASH_HAVE_KEY_MATCH_PAGE and their own version of this.
+ */
+static inline u32 BV (clib_bihash_key_match_page)
+  (BVT (clib_bihash_kv) * kvp, BVT (clib_bihash_kv) * search_key)
+{
+  u32 i, mask = 0;
+
+  for (i = 0; i < BIHASH_KVP_PER_PAGE; i++)
+    if (BV (clib_bihash_key_compare) (kvp[i].key, search_key->key))
+      mask |= 1 << i;
+  return mask;
+}
+#endif
+
+/*
+ * Number of keys clib_bihash_search_batch hashes ahead of the bucket it
+ * reads, and reads ahead of the page it compares. Keys are independent,
+ * so this many bucket and this many page misses are in flight at once.
+ */
+#ifndef BIHASH_SEARCH_BATCH_LOOKAHEAD
+#define BIHASH_SEARCH_BATCH_LOOKAHEAD 8
+#endif
+#define BIHASH_SEARCH_BATCH_SLOTS (2 * BIHASH_SEARCH_BATCH_LOOKAHEAD)
+
+typedef struct
+{
+  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_value) * v;
+  u64 hash;
+} BVT (clib_bihash_batch_slot);
+
+/*
+ * Keys go through three stages, one lookahead apart: hash and prefetch
+ * the bucket, find and prefetch the kvp page, then compare. Buckets and
+ * pages of several keys are fetched from memory in parallel, instead of
+ * one after the other.
+ */
+static inline u32 BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * search_keys,
+   BVT (clib_bihash_kv) * valuep, u8 * found, u32 n_keys)
+{
+  BVT (clib_bihash_batch_slot) slots[BIHASH_SEARCH_BATCH_SLOTS], *s;
+  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_kv) * key;
+  u32 i, n_found = 0, mask, limit;
+  i32 k;
+
+  STATIC_ASSERT ((BIHASH_SEARCH_BATCH_SLOTS &
+		  (BIHASH_SEARCH_BATCH_SLOTS - 1)) == 0,
+		 "lookahead must be a power of 2");
+
+  for (i = 0; i < n_keys + BIHASH_SEARCH_BATCH_SLOTS; i++)
+    {
+      /*
+       * Stage 3: the page is in cache, compare. Runs first, so stage 1
+       * can reuse the slot of the key that just left the pipeline.
+       */
+      k = i - BIHASH_SEARCH_BATCH_SLOTS;
+      if (k >= 0)
+	{
+	  s = &slots[k & (BIHASH_SEARCH_BATCH_SLOTS - 1)];
+	  key = &search_keys[k];
+	  found[k] = 0;
+	  if (!(b = s->b))
+	    goto next;
+
+#if BIHASH_KVP_CACHE_SIZE > 0
+	  if (PREDICT_TRUE ((b->cache_lru & (1 << 15)) == 0))
+	    {
+	      BVT (clib_bihash_kv) * kvp = b->cache;
+	      for (limit = 0; limit < BIHASH_KVP_CACHE_SIZE; limit++)
+		if (BV (clib_bihash_key_compare) (kvp[limit].key, key->key))
+		  {
+		    valuep[k] = kvp[limit];
+		    found[k] = 1;
+		    n_found++;
+		    h->cache_hits++;
+		    goto next;
+		  }
+	    }
+#endif
+	  v = s->v;
+	  limit = 1;
+	  if (PREDICT_FALSE (b->linear_search))
+	    limit <<= b->log2_pages;
+
+	  while (limit--)
+	    {
+	      mask = BV (clib_bihash_key_match_page) (v->kvp, key);
+	      if (mask)
+		{
+		  BVT (clib_bihash_kv) * kvp;
+		  kvp = &v->kvp[count_trailing_zeros (mask)];
+		  valuep[k] = *kvp;
+		  found[k] = 1;
+		  n_found++;
+#if BIHASH_KVP_CACHE_SIZE > 0
+		  u8 cache_slot;
+		  if (BV (clib_bihash_lock_bucket) (b))
+		    {
+		      cache_slot = BV (clib_bihash_get_lru) (b);
+		      b->cache[cache_slot] = *kvp;
+		      BV (clib_bihash_update_lru) (b, cache_slot);
+		      BV (clib_bihash_unlock_bucket) (b);
+		      h->cache_misses++;
+		    }
+#endif
+		  break;
+		}
+	      v++;
+	    }
+	}
+
+    next:
+      /* Stage 2: the bucket is in cache, find and prefetch the page */
+      k = i - BIHASH_SEARCH_BATCH_LOOKAHEAD;
+      if (k >= 0 && k < n_keys)
+	{
+	  s = &slots[k & (BIHASH_SEARCH_BATCH_SLOTS - 1)];
+	  b = s->b;
+	  if (b->offset == 0)
+	    s->b = 0;
+	  else
+	    {
+	      v = BV (clib_bihash_get_value) (h, b->offset);
+	      if (PREDICT_TRUE (b->linear_search == 0))
+		v += (s->hash >> h->log2_nbuckets) &
+		  ((1 << b->log2_pages) - 1);
+	      s->v = v;
+	      CLIB_PREFETCH (v, sizeof (v[0]), READ);
+	    }
+	}
+
+      /* Stage 1: hash the key and prefetch its bucket */
+      if (i < n_keys)
+	{
+	  s = &slots[i & (BIHASH_SEARCH_BATCH_SLOTS - 1)];
+	  s->hash = BV (clib_bihash_hash) (&search_keys[i]);
+	  s->b = &h->buckets[s->hash & (h->nbuckets - 1)];
+	  CLIB_PREFETCH (s->b, sizeof (s->b[0]), READ);
+	}
+    }
+
+  return n_found;
+}
+
+#undef BIHASH_HAVE_KEY_MATCH_PAGE
+
 #endif /* __included_bihash_template_h__ */
 
 /** @endcond */
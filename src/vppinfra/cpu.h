@@ -63,6 +63,7 @@
 
 #define foreach_x86_64_flags \
 _ (sse3,     1, ecx, 0)   \
+_ (pclmulqdq, 1, ecx, 1)  \
 _ (ssse3,    1, ecx, 9)   \
 _ (sse41,    1, ecx, 19)  \
 _ (sse42,    1, ecx, 20)  \
@@ -158,7 +159,7 @@ static inline int clib_cpu_supports_ ## flag() { return 0; }
   static inline int
 clib_cpu_supports_aes ()
 {
-#if defined (__aarch64__)
+#if defined (__x86_64__)
   return clib_cpu_supports_x86_aes ();
 #elif defined (__aarch64__)
   return clib_cpu_supports_aarch64_aes ();
@@ -34,6 +34,8 @@ typedef struct
   int careful_delete_tests;
   int verbose;
   int non_random_keys;
+  u32 batch_size;
+  u32 *batch_nitems;
   uword *key_hash;
   u64 *keys;
   uword hash_memory_size;
@@ -282,6 +284,154 @@ test_bihash (test_main_t * tm)
   return 0;
 }
 
+/*
+ * Search a table of n_items random keys, in random order, one key at a
+ * time and in batches, and report searches per second. Small tables stay
+ * in cache, large ones make every bucket and page a DRAM access.
+ */
+static clib_error_t *
+test_bihash_batch_one (test_main_t * tm, u32 n_items)
+{
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) kv, *keys = 0, *values = 0;
+  u32 *order = 0, i, j, k, n, n_found, n_searches;
+  u8 *found = 0;
+  f64 before, single, batch;
+  u64 sum;
+
+  memset (h, 0, sizeof (*h));
+  BV (clib_bihash_init) (h, "batch", max_pow2 (clib_max (n_items / 2, 2)),
+			 tm->hash_memory_size);
+
+  for (i = 0; i < n_items; i++)
+    {
+      kv.key = random_u64 (&tm->seed);
+      kv.value = i;
+      vec_add1 (values, kv);
+      vec_add1 (order, i);
+      vec_add1 (tm->keys, kv.key);
+    }
+  for (i = 0; i < n_items; i += n)
+    {
+      n = clib_min (tm->batch_size, n_items - i);
+      if (BV (clib_bihash_add_del_batch) (h, &values[i], n, 1 /* is_add */ ))
+	return clib_error_return (0, "batch add failed");
+    }
+  vec_reset_length (values);
+
+  /* Keys to search for, shuffled, plus as many that are not in the table */
+  for (i = vec_len (order) - 1; i > 0; i--)
+    {
+      j = random_u64 (&tm->seed) % (i + 1);
+      k = order[i];
+      order[i] = order[j];
+      order[j] = k;
+    }
+  vec_validate (keys, 2 * n_items - 1);
+  for (i = 0; i < n_items; i++)
+    {
+      keys[2 * i].key = tm->keys[order[i]];
+      keys[2 * i + 1].key = random_u64 (&tm->seed) | 1;
+    }
+  vec_validate (values, vec_len (keys) - 1);
+  vec_validate (found, vec_len (keys) - 1);
+
+  /* At least 10M searches for stable numbers */
+  n_searches = clib_max (vec_len (keys), 10 << 20);
+  n_searches -= n_searches % vec_len (keys);
+
+  sum = 0;
+  before = clib_time_now (&tm->clib_time);
+  for (k = 0; k < n_searches; k += vec_len (keys))
+    for (i = 0; i < vec_len (keys); i++)
+      if (BV (clib_bihash_search_inline_2) (h, &keys[i], &values[i]) == 0)
+	sum += values[i].value + 1;
+  single = n_searches / (clib_time_now (&tm->clib_time) - before);
+
+  n_found = 0;
+  before = clib_time_now (&tm->clib_time);
+  for (k = 0; k < n_searches; k += vec_len (keys))
+    for (i = 0; i < vec_len (keys); i += n)
+      {
+	n = clib_min (tm->batch_size, vec_len (keys) - i);
+	n_found += BV (clib_bihash_search_batch) (h, &keys[i], &values[i],
+						  &found[i], n);
+      }
+  batch = n_searches / (clib_time_now (&tm->clib_time) - before);
+
+  /* Check the last round of batch results */
+  for (i = 0; i < vec_len (keys); i++)
+    {
+      BVT (clib_bihash_kv) v;
+      int rv = BV (clib_bihash_search) (h, &keys[i], &v);
+
+      if (found[i] != (rv == 0) || (rv == 0 && values[i].value != v.value))
+	return clib_error_return (0, "batch search for key %llu: found %d "
+				  "value %llu, expected %d value %llu",
+				  keys[i].key, found[i], values[i].value,
+				  rv == 0, v.value);
+    }
+  if (n_found != n_items * (n_searches / vec_len (keys)))
+    return clib_error_return (0, "batch search found %u keys, expected %u",
+			      n_found,
+			      n_items * (n_searches / vec_len (keys)));
+
+  fformat (stdout, "%9u items, %U: single %.2f M/s, batch of %u %.2f M/s "
+	   "(x%.2f)\n", n_items, format_memory_size,
+	   h->alloc_arena_next - h->alloc_arena,
+	   single / 1e6, tm->batch_size, batch / 1e6, batch / single);
+
+  if (sum == 1)
+    fformat (stdout, "unlikely sum\n");
+
+  /* Batch delete the keys in the table; deleting missing keys fails */
+  for (i = 0; i < vec_len (keys); i += n)
+    {
+      n = clib_min (tm->batch_size, vec_len (keys) - i);
+      n_found = BV (clib_bihash_add_del_batch) (h, &keys[i], n,
+						0 /* is_add */ );
+      /* Odd slots hold the missing keys */
+      if (n_found != (n + (i & 1)) / 2)
+	return clib_error_return (0, "batch delete of %u keys failed %u "
+				  "times, expected %u", n, n_found,
+				  (n + (i & 1)) / 2);
+    }
+  for (i = 0; i < vec_len (keys); i++)
+    if (BV (clib_bihash_search) (h, &keys[i], &kv) == 0)
+      return clib_error_return (0, "key %llu found after batch delete",
+				keys[i].key);
+
+  BV (clib_bihash_free) (h);
+  vec_reset_length (tm->keys);
+  vec_free (keys);
+  vec_free (values);
+  vec_free (found);
+  vec_free (order);
+  return 0;
+}
+
+static clib_error_t *
+test_bihash_batch (test_main_t * tm)
+{
+  clib_error_t *error;
+  u32 *n_items;
+
+  /* Defaults: cache resident, and well past any last level cache */
+  if (!tm->batch_nitems)
+    {
+      vec_add1 (tm->batch_nitems, 4 << 10);
+      vec_add1 (tm->batch_nitems, 4 << 20);
+    }
+
+  fformat (stdout, "Random searches, half of them for missing keys...\n");
+  vec_foreach (n_items, tm->batch_nitems)
+  {
+    if ((error = test_bihash_batch_one (tm, n_items[0])))
+      return error;
+  }
+  return 0;
+}
+
 clib_error_t *
 test_bihash_cache (test_main_t * tm)
 {
@@ -321,8 +471,10 @@ test_bihash_main (test_main_t * tm)
   unformat_input_t *i = tm->input;
   clib_error_t *error;
   int which = 0;
+  u32 n;
 
   tm->report_every_n = 1;
+  tm->batch_size = 256;
   tm->hash_memory_size = 4095ULL << 20;
 
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
@@ -353,6 +505,12 @@ test_bihash_main (test_main_t * tm)
 	which = 1;
       else if (unformat (i, "cache"))
 	which = 2;
+      else if (unformat (i, "batch-size %d", &tm->batch_size))
+	;
+      else if (unformat (i, "batch-nitems %d", &n))
+	vec_add1 (tm->batch_nitems, n);
+      else if (unformat (i, "batch"))
+	which = 3;
 
       else if (unformat (i, "verbose"))
 	tm->verbose = 1;
@@ -381,6 +539,10 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_cache (tm);
       break;
 
+    case 3:
+      error = test_bihash_batch (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
@@ -63,6 +63,24 @@ foreach_avx512_vec512i foreach_avx512_vec512u
 #undef _
 /* *INDENT-ON* */
 
+/* _extract_lo, _extract_hi */
+/* *INDENT-OFF* */
+#define _(t1,t2) \
+always_inline t1							\
+t2##_extract_lo (t2 v)							\
+{ return (t1) _mm512_extracti64x4_epi64 ((__m512i) v, 0); }		\
+\
+always_inline t1							\
+t2##_extract_hi (t2 v)							\
+{ return (t1) _mm512_extracti64x4_epi64 ((__m512i) v, 1); }		\
+
+_(u8x32, u8x64)
+_(u16x16, u16x32)
+_(u32x8, u32x16)
+_(u64x4, u64x8)
+#undef _
+/* *INDENT-ON* */
+
 static_always_inline u32
 u16x32_msb_mask (u16x32 v)
 {
@@ -1433,5 +1433,51 @@ class TestACLplugin(VppTestCase):
 
         self.logger.info("ACLP_TEST_FINISH_0315")
 
+    def test_0400_tuple_merge_udp_deny_port(self):
+        """ deny single UDPv4/v6 with the tuple merge lookup engine
+        """
+        self.logger.info("ACLP_TEST_START_0400")
+
+        self.vapi.cli("set acl-plugin lookup-engine tuple-merge")
+
+        port = random.randint(0, 65535)
+        # Add an ACL
+        rules = []
+        rules.append(self.create_rule(self.IPV4, self.DENY, port,
+                                      self.proto[self.IP][self.UDP]))
+        rules.append(self.create_rule(self.IPV6, self.DENY, port,
+                                      self.proto[self.IP][self.UDP]))
+        # Permit ip any any in the end
+        rules.append(self.create_rule(self.IPV4, self.PERMIT,
+                                      self.PORTS_ALL, 0))
+        rules.append(self.create_rule(self.IPV6, self.PERMIT,
+                                      self.PORTS_ALL, 0))
+
+        # Apply rules
+        self.apply_rules(rules, "deny ip4/ip6 udp "+str(port))
+        reply = self.vapi.cli("show acl-plugin tables applied")
+        self.assertIn("lookup engine: tuple-merge", reply)
+
+        # Traffic should not pass
+        self.run_verify_negat_test(self.IP, self.IPRANDOM,
+                                   self.proto[self.IP][self.UDP], port)
+
+        self.vapi.cli("set acl-plugin lookup-engine hash")
+
+        self.logger.info("ACLP_TEST_FINISH_0400")
+
+    def test_0401_lookup_bench(self):
+        """ compare the lookup engines on a synthetic ruleset
+        """
+        self.logger.info("ACLP_TEST_START_0401")
+
+        reply = self.vapi.cli("test acl-plugin lookup-bench "
+                              "rules 200 packets 2000")
+        self.logger.info(reply)
+        self.assertIn("tuple-merge", reply)
+        self.assertNotIn("differ from the linear lookup", reply)
+
+        self.logger.info("ACLP_TEST_FINISH_0401")
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -404,3 +404,21 @@ class ACLPluginConnTestCase(VppTestCase):
     def test_3006_tcp_transient_teardown_conn_test(self):
         """ IPv6: transient TCP session (3WHS,ACK,FINACK), ref. on egress """
         self.run_tcp_transient_teardown_conn_test(AF_INET6, 1)
+
+
+@unittest.skipUnless(running_extended_tests(), "part of extended tests")
+class ACLPluginConnTimerWheelTestCase(ACLPluginConnTestCase):
+    """ ACL plugin connection tests with timer wheel session aging """
+
+    @classmethod
+    def setUpConstants(cls):
+        super(ACLPluginConnTimerWheelTestCase, cls).setUpConstants()
+        cls.vpp_cmdline.extend(["acl-plugin", "{", "session", "timer",
+                                "wheel", "}"])
+
+    def test_0003_timer_wheel_conn_test(self):
+        """ IPv4: conn timed out by the timer wheel """
+        self.run_basic_conn_test(AF_INET, 0)
+        reply = self.vapi.ppcli("show acl-plugin sessions")
+        self.assertIn("Session aging: per-worker timer wheels", reply)
+        self.assertIn("expirations per second", reply)
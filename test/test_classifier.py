@@ -226,7 +226,8 @@ class TestClassifier(VppTestCase):
         return ('{:0>12}{:0>12}{:0>4}'.format(dst_mac, src_mac,
                                               ether_type)).rstrip('0')
 
-    def create_classify_table(self, key, mask, data_offset=0, is_add=1):
+    def create_classify_table(self, key, mask, data_offset=0, is_add=1,
+                              next_table_index=0xFFFFFFFF):
         """Create Classify Table
 
         :param str key: key for classify table (ex, ACL name).
@@ -234,11 +235,13 @@ class TestClassifier(VppTestCase):
         :param int match_n_vectors:
         :param int is_add: option to configure classify table.
             - create(1) or delete(0)
+        :param int next_table_index: table to search on a miss.
         """
         r = self.vapi.classify_add_del_table(
             is_add,
             binascii.unhexlify(mask),
             match_n_vectors=(len(mask) - 1) // 32 + 1,
+            next_table_index=next_table_index,
             miss_next_index=0,
             current_data_flag=1,
             current_data_offset=data_offset)
@@ -353,6 +356,44 @@ class TestClassifier(VppTestCase):
         self.pg2.assert_nothing_captured(remark="packets forwarded")
         self.pg3.assert_nothing_captured(remark="packets forwarded")
 
+    def test_acl_ip_chain(self):
+        """ Chained IP ACL test
+
+        Test scenario for IP ACL tables chained with next_table_index
+            - Create IPv4 stream for pg0 -> pg1 interface.
+            - Create ACL with source IP address.
+            - Create ACL with destination IP address, which misses and
+              chains to the source IP ACL.
+            - Send and verify received packets on pg1 interface.
+        """
+
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+
+        self.create_classify_table('ip', self.build_ip_mask(src_ip='ffffffff'))
+        self.create_classify_session(
+            self.pg0, self.acl_tbl_idx.get('ip'),
+            self.build_ip_match(src_ip=self.pg0.remote_ip4))
+        self.create_classify_table(
+            'ip_dst', self.build_ip_mask(dst_ip='ffffffff'),
+            next_table_index=self.acl_tbl_idx.get('ip'))
+        self.create_classify_session(
+            self.pg0, self.acl_tbl_idx.get('ip_dst'),
+            self.build_ip_match(dst_ip=self.pg2.remote_ip4))
+        self.input_acl_set_interface(self.pg0,
+                                     self.acl_tbl_idx.get('ip_dst'))
+
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        pkts = self.pg1.get_capture(len(pkts))
+        self.verify_capture(self.pg1, pkts)
+        self.input_acl_set_interface(self.pg0,
+                                     self.acl_tbl_idx.get('ip_dst'), 0)
+        self.pg0.assert_nothing_captured(remark="packets forwarded")
+        self.pg2.assert_nothing_captured(remark="packets forwarded")
+        self.pg3.assert_nothing_captured(remark="packets forwarded")
+
     def test_acl_mac(self):
         """ MAC ACL test
 
@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestCrypto(VppTestCase):
+    """ Crypto engines Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestCrypto, cls).setUpClass()
+
+    def test_known_answers(self):
+        """ every engine matches the known answer vectors """
+        reply = self.vapi.cli("test crypto verbose")
+        self.logger.info(reply)
+        self.assertIn("known answer tests: passed", reply)
+        self.assertNotIn("FAILED", reply)
+
+    def test_engines_agree(self):
+        """ engines agree after switching handlers """
+        engines = self.vapi.cli("show crypto engines")
+        self.logger.info(engines)
+        self.assertIn("openssl", engines)
+        for engine in ("openssl", "native"):
+            if engine not in engines:
+                continue
+            self.vapi.cli("set crypto handler all %s" % engine)
+            reply = self.vapi.cli("show crypto handlers")
+            self.logger.info(reply)
+            self.assertIn("%s*" % engine, reply)
+            reply = self.vapi.cli("test crypto")
+            self.assertNotIn("FAILED", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestGSO(VppTestCase):
+    """ Generic Segmentation Offload Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestGSO, cls).setUpClass()
+
+    def test_segmentation(self):
+        """ GSO buffers are cut into correct TCP segments """
+        reply = self.vapi.cli("test gso")
+        self.logger.info(reply)
+        self.assertIn("gso segmentation tests: passed", reply)
+        self.assertNotIn("FAILED", reply)
+
+    def test_segmentation_sizes(self):
+        """ GSO segmentation with a large payload and small segments """
+        for size, gso_size in ((65000, 1448), (4000, 536), (9000, 1000)):
+            reply = self.vapi.cli("test gso size %d gso-size %d" %
+                                  (size, gso_size))
+            self.logger.info(reply)
+            self.assertNotIn("FAILED", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
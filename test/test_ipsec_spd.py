@@ -0,0 +1,26 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestIpsecSpd(VppTestCase):
+    """ IPSec SPD lookup Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIpsecSpd, cls).setUpClass()
+
+    def test_spd_lookup(self):
+        """ SPD classified lookup agrees with the linear walk """
+        for exact in (0, 50, 90, 100):
+            reply = self.vapi.cli("test ipsec spd-lookup min 10 max 10000 "
+                                  "exact %d" % exact)
+            self.logger.info(reply)
+            self.assertNotIn("FAILED", reply)
+            self.assertNotIn("mismatch", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
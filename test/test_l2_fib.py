@@ -62,6 +62,7 @@
 
 import unittest
 import random
+import re
 
 from scapy.packet import Raw
 from scapy.layers.l2 import Ether
@@ -252,6 +253,16 @@ class TestL2fib(VppTestCase):
         """
         self.vapi.l2fib_flush_all()
 
+    def bd_learn_counters(self, bd_id):
+        """
+        Read the per bridge domain learning counters.
+
+        :param int bd_id: Bridge Domain id.
+        """
+        reply = self.vapi.cli("show bridge-domain %d detail" % bd_id)
+        return {k: int(v) for k, v in
+                re.findall(r"MACs (\w[\w ]*): (\d+)", reply)}
+
     def create_stream(self, src_if, packet_sizes, if_src_hosts, if_dst_hosts):
         """
         Create input packet stream for defined interface using hosts or
@@ -520,6 +531,25 @@ class TestL2fib(VppTestCase):
             self.assertLess(len(e), ev_macs * 10)
         self.assertEqual(len(learned_macs ^ macs), 0)
 
+    def test_l2_fib_learn_rate(self):
+        """ L2 FIB - learn rate limit
+        """
+        bd1 = 1
+        hosts = self.create_hosts(50, subnet=41)
+
+        before = self.bd_learn_counters(bd1)
+        self.vapi.cli("set bridge-domain learn-rate %d 5" % bd1)
+        self.learn_hosts(bd1, hosts)
+        self.vapi.cli("set bridge-domain learn-rate %d 0" % bd1)
+        after = self.bd_learn_counters(bd1)
+        self.vapi.l2fib_flush_bd(bd1)
+
+        # at most 5 per second, the burst may straddle a second boundary
+        learned = after["learned"] - before["learned"]
+        self.assertGreater(learned, 0)
+        self.assertLessEqual(learned, 10)
+        self.assertGreater(after["rate limited"], before["rate limited"])
+
 
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -935,6 +935,9 @@ class TestNAT44(MethodHolder):
         self.ipfix_src_port = 4739
         self.ipfix_domain_id = 1
 
+        self.vapi.cli("set nat44 timeout reset")
+        self.vapi.cli("nat session log disable")
+
         interfaces = self.vapi.nat44_interface_dump()
         for intf in interfaces:
             if intf.is_inside > 1:
@@ -2565,6 +2568,51 @@ class TestNAT44(MethodHolder):
                 data = ipfix.decode_data_set(p.getlayer(Set))
                 self.verify_ipfix_nat44_ses(data)
 
+    def test_session_log(self):
+        """ NAT44 binary session log """
+        log = "%s/nat-session-log" % self.tempdir
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.cli("nat session log %s size 1" % log)
+
+        pkts = self.create_stream_in(self.pg0, self.pg1)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        capture = self.pg1.get_capture(len(pkts))
+        self.verify_capture_out(capture)
+        self.logger.info(self.vapi.cli("show nat session log records 3"))
+        self.nat44_add_address(self.nat_addr, is_add=0)
+        self.vapi.cli("nat session log disable")
+
+        # clib_maplog header and first file of the main thread
+        with open("%s-0_header" % log, "rb") as f:
+            h = struct.unpack_from("<4BI4BII4xQQQ", f.read())
+        self.assertEqual(h[4], 0x4e415434)
+        record_size = h[9] * h[10]
+        n_entries = h[12]
+        with open("%s-0_0" % log, "rb") as f:
+            data = f.read(n_entries * record_size)
+        records = []
+        for i in range(0, len(data), 32):
+            r = struct.unpack_from("<QIIIHHBB6x", data, i)
+            if r[0]:
+                records.append(r)
+
+        self.assertEqual(len(records), 2 * len(pkts))
+        ports = {IP_PROTOS.tcp: self.tcp_port_in,
+                 IP_PROTOS.udp: self.udp_port_in,
+                 IP_PROTOS.icmp: self.icmp_id_in}
+        for (ts, src, nat_src, vrf, port, nat_port, event, proto) in records:
+            self.assertIn(event, [4, 5])  # NAT44_SESSION_CREATE/DELETE
+            self.assertEqual(struct.pack("I", src), self.pg0.remote_ip4n)
+            self.assertEqual(struct.pack("I", nat_src), self.nat_addr_n)
+            self.assertEqual(vrf, 0)
+            self.assertEqual(socket.ntohs(port), ports[proto])
+        self.assertEqual(len([r for r in records if r[6] == 4]), len(pkts))
+
     def test_ipfix_addr_exhausted(self):
         """ IPFIX logging NAT addresses exhausted """
         self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
@@ -4225,6 +4273,38 @@ class TestNAT44(MethodHolder):
                                                      0)
         self.assertEqual(len(sessions) - start_sessnum, 0)
 
+    @unittest.skipUnless(running_extended_tests(), "part of extended tests")
+    def test_session_timeout(self):
+        """ NAT44 session timeouts """
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.cli("set nat44 timeout udp 5 tcp-established 5 "
+                      "tcp-transitory 5 icmp 5")
+
+        pkts = self.create_stream_in(self.pg0, self.pg1)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.pg1.get_capture(len(pkts))
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4n,
+                                                     0)
+        self.assertEqual(len(sessions), 3)
+
+        sleep(15)
+
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4n,
+                                                     0)
+        self.assertEqual(len(sessions), 0)
+
+    def test_session_expire_scale(self):
+        """ NAT44 session expire unit test """
+        reply = self.vapi.cli("test nat44 session-expire sessions 100000")
+        self.logger.info(reply)
+        self.assertIn("expired 100000 sessions", reply)
+        self.assertNotIn("failed", reply)
+
     def tearDown(self):
         super(TestNAT44, self).tearDown()
         if not self.vpp_dead:
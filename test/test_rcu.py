@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+
+import unittest
+import binascii
+import multiprocessing
+
+from framework import VppTestCase, VppTestRunner
+from vpp_ip_route import VppIpRoute
+
+
+class TestRCU(VppTestCase):
+    """ Deferred Reclamation Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestRCU, cls).setUpClass()
+
+    def test_rcu(self):
+        """ Deferred callbacks run in order after a grace period """
+        reply = self.vapi.cli("test rcu calls 1000")
+        self.logger.info(reply)
+        self.assertIn("rcu tests: passed", reply)
+        self.assertNotIn("FAILED", reply)
+
+        reply = self.vapi.cli("show rcu")
+        self.logger.info(reply)
+        self.assertIn("0 callbacks pending", reply)
+
+    def test_barrier_stats_single_thread(self):
+        """ No barrier syncs are recorded without workers """
+        self.vapi.cli("clear barrier stats")
+        route = VppIpRoute(self, "10.10.10.0", 24, [], is_unreach=1)
+        route.add_vpp_config()
+        route.remove_vpp_config()
+
+        reply = self.vapi.cli("show barrier stats")
+        self.logger.info(reply)
+        self.assertIn("no barrier syncs recorded", reply)
+
+
+@unittest.skipUnless(multiprocessing.cpu_count() > 1,
+                     "needs a core for the worker thread")
+class TestRCUWorkers(VppTestCase):
+    """ Deferred Reclamation with Workers Test Case """
+
+    @classmethod
+    def setUpConstants(cls):
+        super(TestRCUWorkers, cls).setUpConstants()
+        cls.vpp_cmdline.extend(["cpu", "{", "workers", "1", "}"])
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestRCUWorkers, cls).setUpClass()
+
+    def test_rcu(self):
+        """ Deferred callbacks wait for the workers """
+        reply = self.vapi.cli("test rcu calls 1000")
+        self.logger.info(reply)
+        self.assertIn("rcu tests: passed", reply)
+        self.assertNotIn("FAILED", reply)
+
+        reply = self.vapi.cli("show rcu")
+        self.logger.info(reply)
+        self.assertIn("0 callbacks pending", reply)
+        self.assertIn("thread 1: epoch", reply)
+
+    def test_barrier_stats(self):
+        """ Barrier syncs are charged to the API message """
+        self.vapi.cli("clear barrier stats")
+        reply = self.vapi.cli("show barrier stats")
+        self.assertIn("no barrier syncs recorded", reply)
+
+        #
+        # classifier sessions are published without the barrier
+        #
+        mask = "ffffffff" + "00" * 12
+        match = "0a0a0a0a" + "00" * 12
+        r = self.vapi.classify_add_del_table(1, binascii.unhexlify(mask))
+        table_index = r.new_table_index
+        self.vapi.cli("clear barrier stats")
+        for is_add in (1, 0):
+            self.vapi.classify_add_del_session(is_add, table_index,
+                                               binascii.unhexlify(match))
+        reply = self.vapi.cli("show barrier stats")
+        self.logger.info(reply)
+        self.assertNotIn("classify_add_del_session", reply)
+
+        self.vapi.cli("clear barrier stats")
+        route = VppIpRoute(self, "10.10.10.0", 24, [], is_unreach=1)
+        route.add_vpp_config()
+        route.remove_vpp_config()
+        reply = self.vapi.cli("show barrier stats")
+        self.logger.info(reply)
+        self.assertIn("Caller", reply)
+        self.assertIn("ip_add_del_route", reply)
+
+        self.vapi.classify_add_del_table(0, binascii.unhexlify(mask),
+                                         table_index=table_index)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -87,5 +87,26 @@ class TestTCP(VppTestCase):
         ip_t01.remove_vpp_config()
         ip_t10.remove_vpp_config()
 
+    def test_tcp_cc_unittest(self):
+        """ TCP congestion control unit tests """
+        error = self.vapi.cli("test tcp cc")
+
+        if error:
+            self.logger.critical(error)
+        self.assertEqual(error.find("failed"), -1)
+
+    def test_tcp_cc_algo_select(self):
+        """ TCP congestion control algorithm selection """
+        for algo in ("cubic", "bbr", "newreno"):
+            error = self.vapi.cli("set tcp cc-algo %s" % algo)
+            self.assertEqual(error, "")
+            error = self.vapi.cli("set tcp cc-algo %s namespace 1" % algo)
+            self.assertEqual(error, "")
+
+        error = self.vapi.cli("set tcp cc-algo vegas")
+        self.assertNotEqual(error.find("unknown input"), -1)
+        error = self.vapi.cli("set tcp cc-algo cubic namespace 7")
+        self.assertNotEqual(error.find("not found"), -1)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)